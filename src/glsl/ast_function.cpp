@@ -442,11 +442,10 @@ no_matching_function_error(const char *name,
 			   exec_list *actual_parameters,
 			   _mesa_glsl_parse_state *state)
 {
-   gl_shader *sh = _mesa_glsl_get_builtin_function_shader();
+   ir_function *builtin = state->uses_builtin_functions
+      ? _mesa_glsl_find_builtin_function_by_name(name) : NULL;
 
-   if (state->symbols->get_function(name) == NULL
-      && (!state->uses_builtin_functions
-          || sh->symbols->get_function(name) == NULL)) {
+   if (state->symbols->get_function(name) == NULL && builtin == NULL) {
       _mesa_glsl_error(loc, state, "no function with name '%s'", name);
    } else {
       char *str = prototype_string(NULL, name, actual_parameters);
@@ -456,10 +455,7 @@ no_matching_function_error(const char *name,
       ralloc_free(str);
 
       print_function_prototypes(state, loc, state->symbols->get_function(name));
-
-      if (state->uses_builtin_functions) {
-         print_function_prototypes(state, loc, sh->symbols->get_function(name));
-      }
+      print_function_prototypes(state, loc, builtin);
    }
 }
 
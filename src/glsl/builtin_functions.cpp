@@ -55,11 +55,13 @@
 
 #include <stdarg.h>
 #include <stdio.h>
+#include <pthread.h>
 #include "main/core.h" /* for struct gl_shader */
 #include "standalone_scaffolding.h"
 #include "ir_builder.h"
 #include "glsl_parser_extras.h"
 #include "program/prog_instruction.h"
+#include "program/hash_table.h"
 #include <limits>
 
 using namespace ir_builder;
@@ -350,8 +352,10 @@ namespace {
  * builtin_builder: A singleton object representing the core of the built-in
  * function module.
  *
- * It generates IR for every built-in function signature, and organizes them
- * into functions.
+ * It generates IR for built-in function signatures, and organizes them into
+ * functions.  Functions are generated lazily: initialize() only records the
+ * name of every built-in, and the IR for a function's signatures is created
+ * the first time find() is asked for that name.
  */
 class builtin_builder {
 public:
@@ -362,19 +366,32 @@ public:
    void release();
    ir_function_signature *find(_mesa_glsl_parse_state *state,
                                const char *name, exec_list *actual_parameters);
+   ir_function *materialize(const char *name);
 
    /**
     * A shader to hold all the built-in signatures; created by this module.
     *
-    * This includes signatures for every built-in, regardless of version or
-    * enabled extensions.  The availability predicate associated with each
-    * signature allows matching_signature() to filter out the irrelevant ones.
+    * This includes signatures for every built-in that has been looked up so
+    * far, regardless of version or enabled extensions.  The availability
+    * predicate associated with each signature allows matching_signature() to
+    * filter out the irrelevant ones.
     */
    gl_shader *shader;
 
 private:
    void *mem_ctx;
 
+   /** Names of all the built-in functions, generated or not. */
+   struct hash_table *names;
+
+   /**
+    * The function create_intrinsics() and create_builtins() should generate,
+    * or NULL if they should just record every name.
+    */
+   const char *wanted;
+
+   bool want(const char *name);
+
    /** Global variables used by built-in functions. */
    ir_variable *gl_ModelViewProjectionMatrix;
    ir_variable *gl_Vertex;
@@ -597,6 +614,8 @@ private:
  */
 builtin_builder::builtin_builder()
    : shader(NULL),
+     names(NULL),
+     wanted(NULL),
      gl_ModelViewProjectionMatrix(NULL),
      gl_Vertex(NULL)
 {
@@ -606,6 +625,8 @@ builtin_builder::builtin_builder()
 builtin_builder::~builtin_builder()
 {
    ralloc_free(mem_ctx);
+   if (names != NULL)
+      hash_table_dtor(names);
 }
 
 ir_function_signature *
@@ -621,7 +642,7 @@ builtin_builder::find(_mesa_glsl_parse_state *state,
     */
    state->uses_builtin_functions = true;
 
-   ir_function *f = shader->symbols->get_function(name);
+   ir_function *f = materialize(name);
    if (f == NULL)
       return NULL;
 
@@ -640,7 +661,12 @@ builtin_builder::initialize()
       return;
 
    mem_ctx = ralloc_context(NULL);
+   names = hash_table_ctor(0, hash_table_string_hash,
+                           hash_table_string_compare);
    create_shader();
+
+   /* With nothing wanted, this just fills in the names table. */
+   wanted = NULL;
    create_intrinsics();
    create_builtins();
 }
@@ -651,6 +677,10 @@ builtin_builder::release()
    ralloc_free(mem_ctx);
    mem_ctx = NULL;
 
+   if (names != NULL)
+      hash_table_dtor(names);
+   names = NULL;
+
    ralloc_free(shader);
    shader = NULL;
 }
@@ -676,8 +706,55 @@ builtin_builder::create_shader()
    shader->symbols->add_variable(gl_Vertex);
 }
 
+/**
+ * Called before generating each built-in function; returns whether the
+ * function called \c name should actually be generated.
+ */
+bool
+builtin_builder::want(const char *name)
+{
+   if (wanted == NULL) {
+      hash_table_insert(names, (void *) name, name);
+      return false;
+   }
+
+   return strcmp(name, wanted) == 0;
+}
+
+/**
+ * Return the built-in function called \c name, generating it first if this
+ * is the first time it's been asked for.  Returns NULL if there isn't a
+ * built-in with that name.
+ */
+ir_function *
+builtin_builder::materialize(const char *name)
+{
+   ir_function *f = shader->symbols->get_function(name);
+   if (f != NULL || hash_table_find(names, name) == NULL)
+      return f;
+
+   /* Generating a function may need another one (for example, the atomic
+    * counter built-ins call intrinsics), so this can recurse.
+    */
+   const char *outer = wanted;
+   wanted = name;
+   create_intrinsics();
+   create_builtins();
+   wanted = outer;
+
+   return shader->symbols->get_function(name);
+}
+
 /** @} */
 
+/**
+ * Only the built-ins picked by want() are actually created.  The signatures
+ * are built before add_function() gets to see the name, so the check has to
+ * happen around the call rather than inside it.
+ */
+#define add_function(NAME, ...) \
+   do { if (want(NAME)) add_function(NAME, __VA_ARGS__); } while (0)
+
 /**
  * Create ir_function and ir_function_signature objects for each
  * intrinsic.
@@ -2174,6 +2251,8 @@ builtin_builder::create_builtins()
 #undef FIU2_MIXED
 }
 
+#undef add_function
+
 void
 builtin_builder::add_function(const char *name, ...)
 {
@@ -4046,7 +4125,7 @@ builtin_builder::_atomic_op(const char *intrinsic,
    MAKE_SIG(glsl_type::uint_type, avail, 1, counter);
 
    ir_variable *retval = body.make_temp(glsl_type::uint_type, "atomic_retval");
-   body.emit(call(shader->symbols->get_function(intrinsic), retval,
+   body.emit(call(materialize(intrinsic), retval,
                   sig->parameters));
    body.emit(ret(retval));
    return sig;
@@ -4100,6 +4179,7 @@ builtin_builder::_mid3(const glsl_type *type)
 
 /* The singleton instance of builtin_builder. */
 static builtin_builder builtins;
+static pthread_mutex_t builtins_lock = PTHREAD_MUTEX_INITIALIZER;
 
 /**
  * External API (exposing the built-in module to the rest of the compiler):
@@ -4108,26 +4188,60 @@ static builtin_builder builtins;
 void
 _mesa_glsl_initialize_builtin_functions()
 {
+   pthread_mutex_lock(&builtins_lock);
    builtins.initialize();
+   pthread_mutex_unlock(&builtins_lock);
 }
 
 void
 _mesa_glsl_release_builtin_functions()
 {
+   pthread_mutex_lock(&builtins_lock);
    builtins.release();
+   pthread_mutex_unlock(&builtins_lock);
 }
 
 ir_function_signature *
 _mesa_glsl_find_builtin_function(_mesa_glsl_parse_state *state,
                                  const char *name, exec_list *actual_parameters)
 {
-   return builtins.find(state, name, actual_parameters);
+   ir_function_signature * s;
+   pthread_mutex_lock(&builtins_lock);
+   s = builtins.find(state, name, actual_parameters);
+   pthread_mutex_unlock(&builtins_lock);
+   return s;
+}
+
+ir_function *
+_mesa_glsl_find_builtin_function_by_name(const char *name)
+{
+   ir_function *f;
+   pthread_mutex_lock(&builtins_lock);
+   f = builtins.materialize(name);
+   pthread_mutex_unlock(&builtins_lock);
+   return f;
 }
 
+/**
+ * The built-in shader grows as functions are generated, so anything walking
+ * its symbol table directly (i.e. the linker) has to hold this lock.
+ */
 gl_shader *
 _mesa_glsl_get_builtin_function_shader()
 {
    return builtins.shader;
 }
 
+void
+_mesa_glsl_lock_builtin_functions()
+{
+   pthread_mutex_lock(&builtins_lock);
+}
+
+void
+_mesa_glsl_unlock_builtin_functions()
+{
+   pthread_mutex_unlock(&builtins_lock);
+}
+
 /** @} */
@@ -1323,8 +1323,8 @@ ast_struct_specifier::ast_struct_specifier(const char *identifier,
 {
    if (identifier == NULL) {
       static unsigned anon_count = 1;
-      identifier = ralloc_asprintf(this, "#anon_struct_%04x", anon_count);
-      anon_count++;
+      identifier = ralloc_asprintf(this, "#anon_struct_%04x",
+                                   __sync_fetch_and_add(&anon_count, 1));
    }
    name = identifier;
    this->declarations.push_degenerate_list_at_head(&declarator_list->link);
@@ -1408,7 +1408,7 @@ _mesa_glsl_compile_shader(struct gl_context *ctx, struct gl_shader *shader,
 
       /* Print out the unoptimized IR. */
       if (dump_hir) {
-         _mesa_print_ir(shader->ir, state);
+         _mesa_print_ir(stdout, shader->ir, state);
       }
    }
 
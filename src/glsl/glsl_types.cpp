@@ -35,14 +35,17 @@ hash_table *glsl_type::array_types = NULL;
 hash_table *glsl_type::record_types = NULL;
 hash_table *glsl_type::interface_types = NULL;
 void *glsl_type::mem_ctx = NULL;
+pthread_mutex_t glsl_type::mutex = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
 
 void
 glsl_type::init_ralloc_type_ctx(void)
 {
+   pthread_mutex_lock(&glsl_type::mutex);
    if (glsl_type::mem_ctx == NULL) {
       glsl_type::mem_ctx = ralloc_autofree_context();
       assert(glsl_type::mem_ctx != NULL);
    }
+   pthread_mutex_unlock(&glsl_type::mutex);
 }
 
 glsl_type::glsl_type(GLenum gl_type,
@@ -55,9 +58,11 @@ glsl_type::glsl_type(GLenum gl_type,
    vector_elements(vector_elements), matrix_columns(matrix_columns),
    length(0)
 {
+   pthread_mutex_lock(&glsl_type::mutex);
    init_ralloc_type_ctx();
    assert(name != NULL);
    this->name = ralloc_strdup(this->mem_ctx, name);
+   pthread_mutex_unlock(&glsl_type::mutex);
    /* Neither dimension is zero or both dimensions are zero.
     */
    assert((vector_elements == 0) == (matrix_columns == 0));
@@ -74,9 +79,11 @@ glsl_type::glsl_type(GLenum gl_type,
    vector_elements(0), matrix_columns(0),
    length(0)
 {
+   pthread_mutex_lock(&glsl_type::mutex);
    init_ralloc_type_ctx();
    assert(name != NULL);
    this->name = ralloc_strdup(this->mem_ctx, name);
+   pthread_mutex_unlock(&glsl_type::mutex);
    memset(& fields, 0, sizeof(fields));
 }
 
@@ -91,6 +98,7 @@ glsl_type::glsl_type(const glsl_struct_field *fields, unsigned num_fields,
 {
    unsigned int i;
 
+   pthread_mutex_lock(&glsl_type::mutex);
    init_ralloc_type_ctx();
    assert(name != NULL);
    this->name = ralloc_strdup(this->mem_ctx, name);
@@ -106,6 +114,7 @@ glsl_type::glsl_type(const glsl_struct_field *fields, unsigned num_fields,
       this->fields.structure[i].sample = fields[i].sample;
       this->fields.structure[i].row_major = fields[i].row_major;
    }
+   pthread_mutex_unlock(&glsl_type::mutex);
 }
 
 glsl_type::glsl_type(const glsl_struct_field *fields, unsigned num_fields,
@@ -119,6 +128,7 @@ glsl_type::glsl_type(const glsl_struct_field *fields, unsigned num_fields,
 {
    unsigned int i;
 
+   pthread_mutex_lock(&glsl_type::mutex);
    init_ralloc_type_ctx();
    assert(name != NULL);
    this->name = ralloc_strdup(this->mem_ctx, name);
@@ -134,6 +144,7 @@ glsl_type::glsl_type(const glsl_struct_field *fields, unsigned num_fields,
       this->fields.structure[i].sample = fields[i].sample;
       this->fields.structure[i].row_major = fields[i].row_major;
    }
+   pthread_mutex_unlock(&glsl_type::mutex);
 }
 
 
@@ -265,6 +276,8 @@ const glsl_type *glsl_type::get_scalar_type() const
 void
 _mesa_glsl_release_types(void)
 {
+   pthread_mutex_lock(&glsl_type::mutex);
+
    if (glsl_type::array_types != NULL) {
       hash_table_dtor(glsl_type::array_types);
       glsl_type::array_types = NULL;
@@ -274,6 +287,8 @@ _mesa_glsl_release_types(void)
       hash_table_dtor(glsl_type::record_types);
       glsl_type::record_types = NULL;
    }
+
+   pthread_mutex_unlock(&glsl_type::mutex);
 }
 
 
@@ -296,7 +311,9 @@ glsl_type::glsl_type(const glsl_type *array, unsigned length) :
     * NUL.
     */
    const unsigned name_length = strlen(array->name) + 10 + 3;
+   pthread_mutex_lock(&glsl_type::mutex);
    char *const n = (char *) ralloc_size(this->mem_ctx, name_length);
+   pthread_mutex_unlock(&glsl_type::mutex);
 
    if (length == 0)
       snprintf(n, name_length, "%s[]", array->name);
@@ -432,6 +449,7 @@ glsl_type::get_instance(unsigned base_type, unsigned rows, unsigned columns)
 const glsl_type *
 glsl_type::get_array_instance(const glsl_type *base, unsigned array_size)
 {
+   pthread_mutex_lock(&glsl_type::mutex);
 
    if (array_types == NULL) {
       array_types = hash_table_ctor(64, hash_table_string_hash,
@@ -453,6 +471,8 @@ glsl_type::get_array_instance(const glsl_type *base, unsigned array_size)
       hash_table_insert(array_types, (void *) t, ralloc_strdup(mem_ctx, key));
    }
 
+   pthread_mutex_unlock(&glsl_type::mutex);
+
    assert(t->base_type == GLSL_TYPE_ARRAY);
    assert(t->length == array_size);
    assert(t->fields.array == base);
@@ -539,6 +559,8 @@ glsl_type::get_record_instance(const glsl_struct_field *fields,
 			       unsigned num_fields,
 			       const char *name)
 {
+   pthread_mutex_lock(&glsl_type::mutex);
+
    const glsl_type key(fields, num_fields, name);
 
    if (record_types == NULL) {
@@ -552,6 +574,8 @@ glsl_type::get_record_instance(const glsl_struct_field *fields,
       hash_table_insert(record_types, (void *) t, t);
    }
 
+   pthread_mutex_unlock(&glsl_type::mutex);
+
    assert(t->base_type == GLSL_TYPE_STRUCT);
    assert(t->length == num_fields);
    assert(strcmp(t->name, name) == 0);
@@ -566,6 +590,8 @@ glsl_type::get_interface_instance(const glsl_struct_field *fields,
 				  enum glsl_interface_packing packing,
 				  const char *block_name)
 {
+   pthread_mutex_lock(&glsl_type::mutex);
+
    const glsl_type key(fields, num_fields, packing, block_name);
 
    if (interface_types == NULL) {
@@ -579,6 +605,8 @@ glsl_type::get_interface_instance(const glsl_struct_field *fields,
       hash_table_insert(interface_types, (void *) t, t);
    }
 
+   pthread_mutex_unlock(&glsl_type::mutex);
+
    assert(t->base_type == GLSL_TYPE_INTERFACE);
    assert(t->length == num_fields);
    assert(strcmp(t->name, block_name) == 0);
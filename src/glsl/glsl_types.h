@@ -28,6 +28,7 @@
 
 #include <string.h>
 #include <assert.h>
+#include <pthread.h>
 #include "main/mtypes.h" /* for gl_texture_index, C++'s enum rules are broken */
 
 #ifdef __cplusplus
@@ -103,6 +104,8 @@ struct glsl_type {
     * easier to just ralloc_free 'mem_ctx' (or any of its ancestors). */
    static void* operator new(size_t size)
    {
+      pthread_mutex_lock(&glsl_type::mutex);
+
       if (glsl_type::mem_ctx == NULL) {
 	 glsl_type::mem_ctx = ralloc_context(NULL);
 	 assert(glsl_type::mem_ctx != NULL);
@@ -113,6 +116,8 @@ struct glsl_type {
       type = ralloc_size(glsl_type::mem_ctx, size);
       assert(type != NULL);
 
+      pthread_mutex_unlock(&glsl_type::mutex);
+
       return type;
    }
 
@@ -120,7 +125,9 @@ struct glsl_type {
     * ralloc_free in that case. */
    static void operator delete(void *type)
    {
+      pthread_mutex_lock(&glsl_type::mutex);
       ralloc_free(type);
+      pthread_mutex_unlock(&glsl_type::mutex);
    }
 
    /**
@@ -563,6 +570,13 @@ private:
 
    void init_ralloc_type_ctx(void);
 
+   /**
+    * Protects \c mem_ctx and the type hash tables, so that shaders can be
+    * compiled from several threads at once.  This is recursive because the
+    * constructors take it too.
+    */
+   static pthread_mutex_t mutex;
+
    /** Constructor for vector and matrix types */
    glsl_type(GLenum gl_type,
 	     glsl_base_type base_type, unsigned vector_elements,
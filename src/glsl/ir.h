@@ -109,6 +109,7 @@ public:
 
    /** ir_print_visitor helper for debugging. */
    void print(void) const;
+   void fprint(FILE *f) const;
 
    virtual void accept(ir_visitor *) = 0;
    virtual ir_visitor_status accept(ir_hierarchical_visitor *) = 0;
@@ -2467,9 +2468,18 @@ extern ir_function_signature *
 _mesa_glsl_find_builtin_function(_mesa_glsl_parse_state *state,
                                  const char *name, exec_list *actual_parameters);
 
+extern ir_function *
+_mesa_glsl_find_builtin_function_by_name(const char *name);
+
 extern gl_shader *
 _mesa_glsl_get_builtin_function_shader(void);
 
+extern void
+_mesa_glsl_lock_builtin_functions(void);
+
+extern void
+_mesa_glsl_unlock_builtin_functions(void);
+
 extern void
 _mesa_glsl_release_functions(void);
 
@@ -2502,7 +2512,7 @@ mode_string(const ir_variable *var);
 extern "C" {
 #endif /* __cplusplus */
 
-extern void _mesa_print_ir(struct exec_list *instructions,
+extern void _mesa_print_ir(FILE *f, struct exec_list *instructions,
                            struct _mesa_glsl_parse_state *state);
 
 #ifdef __cplusplus
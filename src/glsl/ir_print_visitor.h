@@ -38,7 +38,7 @@ extern "C" {
  */
 class ir_print_visitor : public ir_visitor {
 public:
-   ir_print_visitor();
+   ir_print_visitor(FILE *f);
    virtual ~ir_print_visitor();
 
    void indent(void);
@@ -103,6 +103,8 @@ private:
    void *mem_ctx;
 
    int indentation;
+
+   FILE *f;
 };
 
 #endif /* IR_PRINT_VISITOR_H */
@@ -294,7 +294,7 @@ compile_shader(struct gl_context *ctx, struct gl_shader *shader)
 
    /* Print out the resulting IR */
    if (!state->error && dump_lir) {
-      _mesa_print_ir(shader->ir, state);
+      _mesa_print_ir(stdout, shader->ir, state);
    }
 
    return;
@@ -37,6 +37,7 @@
 #include "ir_basic_block.h"
 #include "ir_optimization.h"
 #include "glsl_types.h"
+#include "main/hash_table.h"
 
 namespace {
 
@@ -56,16 +57,42 @@ public:
 };
 
 
-class kill_entry : public exec_node
+/**
+ * The available copies and kills for one block of instructions.
+ *
+ * Rather than starting with a copy of the enclosing block's ACP, the
+ * then/else blocks of an if look up copies they don't have themselves in
+ * \c parent, skipping any whose variables they've killed since.
+ */
+class acp_scope
 {
 public:
-   kill_entry(ir_variable *var)
+   acp_scope(acp_scope *parent)
+   {
+      this->parent = parent;
+      this->killed_all = false;
+      this->acp = _mesa_hash_table_create(NULL, _mesa_key_pointer_equal);
+      this->copies = _mesa_hash_table_create(NULL, _mesa_key_pointer_equal);
+      this->kills = _mesa_hash_table_create(NULL, _mesa_key_pointer_equal);
+   }
+   ~acp_scope()
    {
-      assert(var);
-      this->var = var;
+      _mesa_hash_table_destroy(this->acp, NULL);
+      _mesa_hash_table_destroy(this->copies, NULL);
+      _mesa_hash_table_destroy(this->kills, NULL);
    }
 
-   ir_variable *var;
+   /** Maps an ACP LHS variable to its acp_entry. */
+   hash_table *acp;
+   /** Maps an ACP RHS variable to an exec_list of the acp_entrys using it. */
+   hash_table *copies;
+   /** The variables whose values were killed in this block. */
+   hash_table *kills;
+
+   /** The enclosing block whose copies are still available, or NULL. */
+   acp_scope *parent;
+
+   bool killed_all;
 };
 
 class ir_copy_propagation_visitor : public ir_hierarchical_visitor {
@@ -74,8 +101,7 @@ public:
    {
       progress = false;
       mem_ctx = ralloc_context(0);
-      this->acp = new(mem_ctx) exec_list;
-      this->kills = new(mem_ctx) exec_list;
+      this->scope = NULL;
    }
    ~ir_copy_propagation_visitor()
    {
@@ -92,23 +118,50 @@ public:
 
    void add_copy(ir_assignment *ir);
    void kill(ir_variable *ir);
-   void handle_if_block(exec_list *instructions);
+   void kill_all();
+   ir_variable *find_copy(ir_variable *var);
+   void handle_block(exec_list *instructions, acp_scope *parent);
 
-   /** List of acp_entry: The available copies to propagate */
-   exec_list *acp;
-   /**
-    * List of kill_entry: The variables whose values were killed in this
-    * block.
-    */
-   exec_list *kills;
+   /** The available copies and kills of the block being visited. */
+   acp_scope *scope;
 
    bool progress;
 
-   bool killed_all;
-
    void *mem_ctx;
 };
 
+/* Helpers for the pointer-keyed tables in acp_scope. */
+static void *
+table_find(hash_table *ht, const void *key)
+{
+   hash_entry *entry =
+      _mesa_hash_table_search(ht, _mesa_hash_pointer(key), key);
+   return entry != NULL ? entry->data : NULL;
+}
+
+static void
+table_insert(hash_table *ht, const void *key, void *data)
+{
+   _mesa_hash_table_insert(ht, _mesa_hash_pointer(key), key, data);
+}
+
+static void
+table_remove(hash_table *ht, const void *key)
+{
+   hash_entry *entry =
+      _mesa_hash_table_search(ht, _mesa_hash_pointer(key), key);
+   if (entry != NULL)
+      _mesa_hash_table_remove(ht, entry);
+}
+
+static void
+table_clear(hash_table *ht)
+{
+   hash_entry *entry;
+   hash_table_foreach(ht, entry)
+      _mesa_hash_table_remove(ht, entry);
+}
+
 } /* unnamed namespace */
 
 ir_visitor_status
@@ -118,19 +171,12 @@ ir_copy_propagation_visitor::visit_enter(ir_function_signature *ir)
     * block.  Any instructions at global scope will be shuffled into
     * main() at link time, so they're irrelevant to us.
     */
-   exec_list *orig_acp = this->acp;
-   exec_list *orig_kills = this->kills;
-   bool orig_killed_all = this->killed_all;
-
-   this->acp = new(mem_ctx) exec_list;
-   this->kills = new(mem_ctx) exec_list;
-   this->killed_all = false;
+   acp_scope *orig_scope = this->scope;
+   acp_scope body_scope(NULL);
 
+   this->scope = &body_scope;
    visit_list_elements(this, &ir->body);
-
-   this->kills = orig_kills;
-   this->acp = orig_acp;
-   this->killed_all = orig_killed_all;
+   this->scope = orig_scope;
 
    return visit_continue_with_parent;
 }
@@ -152,6 +198,32 @@ ir_copy_propagation_visitor::visit_enter(ir_function *ir)
    return visit_continue;
 }
 
+/**
+ * Returns the variable \c var is currently a copy of, or NULL.
+ */
+ir_variable *
+ir_copy_propagation_visitor::find_copy(ir_variable *var)
+{
+   for (acp_scope *s = this->scope; s != NULL; s = s->parent) {
+      acp_entry *entry = (acp_entry *) table_find(s->acp, var);
+      if (entry != NULL) {
+	 /* A copy from an enclosing block is gone if one of the blocks
+	  * inside it has overwritten the source since.
+	  */
+	 for (acp_scope *t = this->scope; t != s; t = t->parent) {
+	    if (table_find(t->kills, entry->rhs) != NULL)
+	       return NULL;
+	 }
+	 return entry->rhs;
+      }
+
+      if (s->killed_all || table_find(s->kills, var) != NULL)
+	 return NULL;
+   }
+
+   return NULL;
+}
+
 /**
  * Replaces dereferences of ACP RHS variables with ACP LHS variables.
  *
@@ -165,16 +237,10 @@ ir_copy_propagation_visitor::visit(ir_dereference_variable *ir)
    if (this->in_assignee)
       return visit_continue;
 
-   ir_variable *var = ir->var;
-
-   foreach_list(n, this->acp) {
-      acp_entry *entry = (acp_entry *) n;
-
-      if (var == entry->lhs) {
-	 ir->var = entry->rhs;
-	 this->progress = true;
-	 break;
-      }
+   ir_variable *rhs = find_copy(ir->var);
+   if (rhs != NULL) {
+      ir->var = rhs;
+      this->progress = true;
    }
 
    return visit_continue;
@@ -198,44 +264,33 @@ ir_copy_propagation_visitor::visit_enter(ir_call *ir)
    /* Since we're unlinked, we don't (necessarily) know the side effects of
     * this call.  So kill all copies.
     */
-   acp->make_empty();
-   this->killed_all = true;
+   kill_all();
 
    return visit_continue_with_parent;
 }
 
+/**
+ * Visits a nested block of instructions, then moves its kills out into
+ * the current block.  \c parent is the block whose copies are available
+ * at the start, or NULL to start with none.
+ */
 void
-ir_copy_propagation_visitor::handle_if_block(exec_list *instructions)
+ir_copy_propagation_visitor::handle_block(exec_list *instructions,
+                                          acp_scope *parent)
 {
-   exec_list *orig_acp = this->acp;
-   exec_list *orig_kills = this->kills;
-   bool orig_killed_all = this->killed_all;
-
-   this->acp = new(mem_ctx) exec_list;
-   this->kills = new(mem_ctx) exec_list;
-   this->killed_all = false;
-
-   /* Populate the initial acp with a copy of the original */
-   foreach_list(n, orig_acp) {
-      acp_entry *a = (acp_entry *) n;
-      this->acp->push_tail(new(this->mem_ctx) acp_entry(a->lhs, a->rhs));
-   }
+   acp_scope *orig_scope = this->scope;
+   acp_scope block_scope(parent);
 
+   this->scope = &block_scope;
    visit_list_elements(this, instructions);
+   this->scope = orig_scope;
 
-   if (this->killed_all) {
-      orig_acp->make_empty();
-   }
-
-   exec_list *new_kills = this->kills;
-   this->kills = orig_kills;
-   this->acp = orig_acp;
-   this->killed_all = this->killed_all || orig_killed_all;
+   if (block_scope.killed_all)
+      kill_all();
 
-   foreach_list(n, new_kills) {
-      kill_entry *k = (kill_entry *) n;
-      kill(k->var);
-   }
+   hash_entry *entry;
+   hash_table_foreach(block_scope.kills, entry)
+      kill((ir_variable *) entry->data);
 }
 
 ir_visitor_status
@@ -243,43 +298,21 @@ ir_copy_propagation_visitor::visit_enter(ir_if *ir)
 {
    ir->condition->accept(this);
 
-   handle_if_block(&ir->then_instructions);
-   handle_if_block(&ir->else_instructions);
+   handle_block(&ir->then_instructions, this->scope);
+   handle_block(&ir->else_instructions, this->scope);
 
-   /* handle_if_block() already descended into the children. */
+   /* handle_block() already descended into the children. */
    return visit_continue_with_parent;
 }
 
 ir_visitor_status
 ir_copy_propagation_visitor::visit_enter(ir_loop *ir)
 {
-   exec_list *orig_acp = this->acp;
-   exec_list *orig_kills = this->kills;
-   bool orig_killed_all = this->killed_all;
-
    /* FINISHME: For now, the initial acp for loops is totally empty.
     * We could go through once, then go through again with the acp
     * cloned minus the killed entries after the first run through.
     */
-   this->acp = new(mem_ctx) exec_list;
-   this->kills = new(mem_ctx) exec_list;
-   this->killed_all = false;
-
-   visit_list_elements(this, &ir->body_instructions);
-
-   if (this->killed_all) {
-      orig_acp->make_empty();
-   }
-
-   exec_list *new_kills = this->kills;
-   this->kills = orig_kills;
-   this->acp = orig_acp;
-   this->killed_all = this->killed_all || orig_killed_all;
-
-   foreach_list(n, new_kills) {
-      kill_entry *k = (kill_entry *) n;
-      kill(k->var);
-   }
+   handle_block(&ir->body_instructions, NULL);
 
    /* already descended into the children. */
    return visit_continue_with_parent;
@@ -291,17 +324,35 @@ ir_copy_propagation_visitor::kill(ir_variable *var)
    assert(var != NULL);
 
    /* Remove any entries currently in the ACP for this kill. */
-   foreach_list_safe(n, acp) {
-      acp_entry *entry = (acp_entry *) n;
+   acp_entry *entry = (acp_entry *) table_find(scope->acp, var);
+   if (entry != NULL) {
+      entry->remove();
+      table_remove(scope->acp, var);
+   }
 
-      if (entry->lhs == var || entry->rhs == var) {
-	 entry->remove();
+   exec_list *copies = (exec_list *) table_find(scope->copies, var);
+   if (copies != NULL) {
+      foreach_list(n, copies) {
+	 table_remove(scope->acp, ((acp_entry *) n)->lhs);
       }
+      table_remove(scope->copies, var);
    }
 
-   /* Add the LHS variable to the list of killed variables in this block.
+   /* Add the LHS variable to the set of killed variables in this block.
     */
-   this->kills->push_tail(new(this->mem_ctx) kill_entry(var));
+   if (table_find(scope->kills, var) == NULL)
+      table_insert(scope->kills, var, var);
+}
+
+/**
+ * Empties the ACP, including anything available from enclosing blocks.
+ */
+void
+ir_copy_propagation_visitor::kill_all()
+{
+   table_clear(scope->acp);
+   table_clear(scope->copies);
+   scope->killed_all = true;
 }
 
 /**
@@ -330,7 +381,15 @@ ir_copy_propagation_visitor::add_copy(ir_assignment *ir)
 	 this->progress = true;
       } else {
 	 entry = new(this->mem_ctx) acp_entry(lhs_var, rhs_var);
-	 this->acp->push_tail(entry);
+	 table_insert(scope->acp, lhs_var, entry);
+
+	 exec_list *copies =
+	    (exec_list *) table_find(scope->copies, rhs_var);
+	 if (copies == NULL) {
+	    copies = new(this->mem_ctx) exec_list;
+	    table_insert(scope->copies, rhs_var, copies);
+	 }
+	 copies->push_tail(entry);
       }
    }
 }
@@ -342,7 +401,9 @@ bool
 do_copy_propagation(exec_list *instructions)
 {
    ir_copy_propagation_visitor v;
+   acp_scope top_scope(NULL);
 
+   v.scope = &top_scope;
    visit_list_elements(&v, instructions);
 
    return v.progress;
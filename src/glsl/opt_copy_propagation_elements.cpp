@@ -46,6 +46,7 @@
 #include "ir_basic_block.h"
 #include "ir_optimization.h"
 #include "glsl_types.h"
+#include "main/hash_table.h"
 
 static bool debug = false;
 
@@ -62,21 +63,27 @@ public:
       memcpy(this->swizzle, swizzle, sizeof(this->swizzle));
    }
 
-   acp_entry(acp_entry *a)
-   {
-      this->lhs = a->lhs;
-      this->rhs = a->rhs;
-      this->write_mask = a->write_mask;
-      memcpy(this->swizzle, a->swizzle, sizeof(this->swizzle));
-   }
-
    ir_variable *lhs;
    ir_variable *rhs;
+   /** Zero once the entry has been removed from the ACP. */
    unsigned int write_mask;
    int swizzle[4];
 };
 
 
+/** An entry in the list of ACP entries copying from a variable. */
+class acp_ref : public exec_node
+{
+public:
+   acp_ref(acp_entry *entry)
+   {
+      this->entry = entry;
+   }
+
+   acp_entry *entry;
+};
+
+
 class kill_entry : public exec_node
 {
 public:
@@ -90,16 +97,56 @@ public:
    unsigned int write_mask;
 };
 
+
+/**
+ * The available copies and kills for one block of instructions.
+ *
+ * Rather than starting with a copy of the enclosing block's ACP, the
+ * then/else blocks of an if look up copies they don't have themselves in
+ * \c parent, masking off any channels they've killed since.
+ */
+class acp_scope
+{
+public:
+   acp_scope(acp_scope *parent)
+   {
+      this->parent = parent;
+      this->killed_all = false;
+      this->acp = _mesa_hash_table_create(NULL, _mesa_key_pointer_equal);
+      this->copies = _mesa_hash_table_create(NULL, _mesa_key_pointer_equal);
+      this->kills = _mesa_hash_table_create(NULL, _mesa_key_pointer_equal);
+   }
+   ~acp_scope()
+   {
+      _mesa_hash_table_destroy(this->acp, NULL);
+      _mesa_hash_table_destroy(this->copies, NULL);
+      _mesa_hash_table_destroy(this->kills, NULL);
+   }
+
+   /**
+    * Maps an ACP LHS variable to an exec_list of its acp_entrys, in the
+    * order they were added.
+    */
+   hash_table *acp;
+   /** Maps an ACP RHS variable to an exec_list of acp_refs to entries. */
+   hash_table *copies;
+   /** Maps a variable killed in this block to its kill_entry. */
+   hash_table *kills;
+
+   /** The enclosing block whose copies are still available, or NULL. */
+   acp_scope *parent;
+
+   bool killed_all;
+};
+
 class ir_copy_propagation_elements_visitor : public ir_rvalue_visitor {
 public:
    ir_copy_propagation_elements_visitor()
    {
       this->progress = false;
-      this->killed_all = false;
       this->mem_ctx = ralloc_context(NULL);
       this->shader_mem_ctx = NULL;
-      this->acp = new(mem_ctx) exec_list;
-      this->kills = new(mem_ctx) exec_list;
+      this->scope = NULL;
    }
    ~ir_copy_propagation_elements_visitor()
    {
@@ -116,27 +163,53 @@ public:
    void handle_rvalue(ir_rvalue **rvalue);
 
    void add_copy(ir_assignment *ir);
-   void kill(kill_entry *k);
-   void handle_if_block(exec_list *instructions);
+   void kill(ir_variable *var, unsigned int write_mask);
+   void kill_all();
+   void handle_block(exec_list *instructions, acp_scope *parent);
 
-   /** List of acp_entry: The available copies to propagate */
-   exec_list *acp;
-   /**
-    * List of kill_entry: The variables whose values were killed in this
-    * block.
-    */
-   exec_list *kills;
+   /** The available copies and kills of the block being visited. */
+   acp_scope *scope;
 
    bool progress;
 
-   bool killed_all;
-
    /* Context for our local data structures. */
    void *mem_ctx;
    /* Context for allocating new shader nodes. */
    void *shader_mem_ctx;
 };
 
+/* Helpers for the pointer-keyed tables in acp_scope. */
+static void *
+table_find(hash_table *ht, const void *key)
+{
+   hash_entry *entry =
+      _mesa_hash_table_search(ht, _mesa_hash_pointer(key), key);
+   return entry != NULL ? entry->data : NULL;
+}
+
+static void
+table_insert(hash_table *ht, const void *key, void *data)
+{
+   _mesa_hash_table_insert(ht, _mesa_hash_pointer(key), key, data);
+}
+
+static void
+table_remove(hash_table *ht, const void *key)
+{
+   hash_entry *entry =
+      _mesa_hash_table_search(ht, _mesa_hash_pointer(key), key);
+   if (entry != NULL)
+      _mesa_hash_table_remove(ht, entry);
+}
+
+static void
+table_clear(hash_table *ht)
+{
+   hash_entry *entry;
+   hash_table_foreach(ht, entry)
+      _mesa_hash_table_remove(ht, entry);
+}
+
 } /* unnamed namespace */
 
 ir_visitor_status
@@ -146,19 +219,12 @@ ir_copy_propagation_elements_visitor::visit_enter(ir_function_signature *ir)
     * block.  Any instructions at global scope will be shuffled into
     * main() at link time, so they're irrelevant to us.
     */
-   exec_list *orig_acp = this->acp;
-   exec_list *orig_kills = this->kills;
-   bool orig_killed_all = this->killed_all;
-
-   this->acp = new(mem_ctx) exec_list;
-   this->kills = new(mem_ctx) exec_list;
-   this->killed_all = false;
+   acp_scope *orig_scope = this->scope;
+   acp_scope body_scope(NULL);
 
+   this->scope = &body_scope;
    visit_list_elements(this, &ir->body);
-
-   this->kills = orig_kills;
-   this->acp = orig_acp;
-   this->killed_all = orig_killed_all;
+   this->scope = orig_scope;
 
    return visit_continue_with_parent;
 }
@@ -170,14 +236,10 @@ ir_copy_propagation_elements_visitor::visit_leave(ir_assignment *ir)
    ir_variable *var = ir->lhs->variable_referenced();
 
    if (var->type->is_scalar() || var->type->is_vector()) {
-      kill_entry *k;
-
       if (lhs)
-	 k = new(mem_ctx) kill_entry(var, ir->write_mask);
+	 kill(var, ir->write_mask);
       else
-	 k = new(mem_ctx) kill_entry(var, ~0);
-
-      kill(k);
+	 kill(var, ~0);
    }
 
    add_copy(ir);
@@ -242,19 +304,44 @@ ir_copy_propagation_elements_visitor::handle_rvalue(ir_rvalue **ir)
    ir_variable *var = deref_var->var;
 
    /* Try to find ACP entries covering swizzle_chan[], hoping they're
-    * the same source variable.
+    * the same source variable.  Later entries override earlier ones, so
+    * walk them from the newest back, outwards through the enclosing
+    * blocks, and only fill in channels that aren't set yet.
     */
-   foreach_list(n, this->acp) {
-      acp_entry *entry = (acp_entry *) n;
-
-      if (var == entry->lhs) {
-	 for (int c = 0; c < chans; c++) {
-	    if (entry->write_mask & (1 << swizzle_chan[c])) {
-	       source[c] = entry->rhs;
-	       source_chan[c] = entry->swizzle[swizzle_chan[c]];
+   int missing = chans;
+   unsigned int killed = 0;
+   for (acp_scope *s = this->scope; s != NULL && missing; s = s->parent) {
+      exec_list *entries = (exec_list *) table_find(s->acp, var);
+      if (entries != NULL) {
+	 for (exec_node *n = entries->tail_pred; !n->is_head_sentinel();
+	      n = n->prev) {
+	    acp_entry *entry = (acp_entry *) n;
+	    unsigned int write_mask = entry->write_mask & ~killed;
+
+	    /* A copy from an enclosing block is gone if one of the blocks
+	     * inside it has overwritten the source since.
+	     */
+	    for (acp_scope *t = this->scope; t != s && write_mask; t = t->parent) {
+	       if (table_find(t->kills, entry->rhs) != NULL)
+		  write_mask = 0;
+	    }
+
+	    for (int c = 0; c < chans; c++) {
+	       if (!source[c] && (write_mask & (1 << swizzle_chan[c]))) {
+		  source[c] = entry->rhs;
+		  source_chan[c] = entry->swizzle[swizzle_chan[c]];
+		  missing--;
+	       }
 	    }
 	 }
       }
+
+      if (s->killed_all)
+	 break;
+
+      kill_entry *k = (kill_entry *) table_find(s->kills, var);
+      if (k != NULL)
+	 killed |= k->write_mask;
    }
 
    /* Make sure all channels are copying from the same source variable. */
@@ -306,46 +393,35 @@ ir_copy_propagation_elements_visitor::visit_enter(ir_call *ir)
    /* Since we're unlinked, we don't (necessarily) know the side effects of
     * this call.  So kill all copies.
     */
-   acp->make_empty();
-   this->killed_all = true;
+   kill_all();
 
    return visit_continue_with_parent;
 }
 
+/**
+ * Visits a nested block of instructions, then moves its kills into the
+ * current block, removing them from the current block's ACP in the
+ * process.  \c parent is the block whose copies are available at the
+ * start, or NULL to start with none.
+ */
 void
-ir_copy_propagation_elements_visitor::handle_if_block(exec_list *instructions)
+ir_copy_propagation_elements_visitor::handle_block(exec_list *instructions,
+                                                   acp_scope *parent)
 {
-   exec_list *orig_acp = this->acp;
-   exec_list *orig_kills = this->kills;
-   bool orig_killed_all = this->killed_all;
-
-   this->acp = new(mem_ctx) exec_list;
-   this->kills = new(mem_ctx) exec_list;
-   this->killed_all = false;
-
-   /* Populate the initial acp with a copy of the original */
-   foreach_list(n, orig_acp) {
-      acp_entry *a = (acp_entry *) n;
-      this->acp->push_tail(new(this->mem_ctx) acp_entry(a));
-   }
+   acp_scope *orig_scope = this->scope;
+   acp_scope block_scope(parent);
 
+   this->scope = &block_scope;
    visit_list_elements(this, instructions);
+   this->scope = orig_scope;
 
-   if (this->killed_all) {
-      orig_acp->make_empty();
-   }
+   if (block_scope.killed_all)
+      kill_all();
 
-   exec_list *new_kills = this->kills;
-   this->kills = orig_kills;
-   this->acp = orig_acp;
-   this->killed_all = this->killed_all || orig_killed_all;
-
-   /* Move the new kills into the parent block's list, removing them
-    * from the parent's ACP list in the process.
-    */
-   foreach_list_safe(node, new_kills) {
-      kill_entry *k = (kill_entry *)node;
-      kill(k);
+   hash_entry *entry;
+   hash_table_foreach(block_scope.kills, entry) {
+      kill_entry *k = (kill_entry *) entry->data;
+      kill(k->var, k->write_mask);
    }
 }
 
@@ -354,43 +430,21 @@ ir_copy_propagation_elements_visitor::visit_enter(ir_if *ir)
 {
    ir->condition->accept(this);
 
-   handle_if_block(&ir->then_instructions);
-   handle_if_block(&ir->else_instructions);
+   handle_block(&ir->then_instructions, this->scope);
+   handle_block(&ir->else_instructions, this->scope);
 
-   /* handle_if_block() already descended into the children. */
+   /* handle_block() already descended into the children. */
    return visit_continue_with_parent;
 }
 
 ir_visitor_status
 ir_copy_propagation_elements_visitor::visit_enter(ir_loop *ir)
 {
-   exec_list *orig_acp = this->acp;
-   exec_list *orig_kills = this->kills;
-   bool orig_killed_all = this->killed_all;
-
    /* FINISHME: For now, the initial acp for loops is totally empty.
     * We could go through once, then go through again with the acp
     * cloned minus the killed entries after the first run through.
     */
-   this->acp = new(mem_ctx) exec_list;
-   this->kills = new(mem_ctx) exec_list;
-   this->killed_all = false;
-
-   visit_list_elements(this, &ir->body_instructions);
-
-   if (this->killed_all) {
-      orig_acp->make_empty();
-   }
-
-   exec_list *new_kills = this->kills;
-   this->kills = orig_kills;
-   this->acp = orig_acp;
-   this->killed_all = this->killed_all || orig_killed_all;
-
-   foreach_list_safe(node, new_kills) {
-      kill_entry *k = (kill_entry *)node;
-      kill(k);
-   }
+   handle_block(&ir->body_instructions, NULL);
 
    /* already descended into the children. */
    return visit_continue_with_parent;
@@ -398,28 +452,51 @@ ir_copy_propagation_elements_visitor::visit_enter(ir_loop *ir)
 
 /* Remove any entries currently in the ACP for this kill. */
 void
-ir_copy_propagation_elements_visitor::kill(kill_entry *k)
+ir_copy_propagation_elements_visitor::kill(ir_variable *var,
+                                           unsigned int write_mask)
 {
-   foreach_list_safe(node, acp) {
-      acp_entry *entry = (acp_entry *)node;
+   exec_list *entries = (exec_list *) table_find(scope->acp, var);
+   if (entries != NULL) {
+      foreach_list_safe(node, entries) {
+	 acp_entry *entry = (acp_entry *)node;
 
-      if (entry->lhs == k->var) {
-	 entry->write_mask = entry->write_mask & ~k->write_mask;
-	 if (entry->write_mask == 0) {
+	 entry->write_mask = entry->write_mask & ~write_mask;
+	 if (entry->write_mask == 0)
 	    entry->remove();
-	    continue;
-	 }
       }
-      if (entry->rhs == k->var) {
-	 entry->remove();
+   }
+
+   exec_list *copies = (exec_list *) table_find(scope->copies, var);
+   if (copies != NULL) {
+      foreach_list(node, copies) {
+	 acp_entry *entry = ((acp_ref *)node)->entry;
+
+	 if (entry->write_mask != 0) {
+	    entry->write_mask = 0;
+	    entry->remove();
+	 }
       }
+      table_remove(scope->copies, var);
    }
 
-   /* If we were on a list, remove ourselves before inserting */
-   if (k->next)
-      k->remove();
+   kill_entry *k = (kill_entry *) table_find(scope->kills, var);
+   if (k != NULL) {
+      k->write_mask |= write_mask;
+   } else {
+      k = new(mem_ctx) kill_entry(var, write_mask);
+      table_insert(scope->kills, var, k);
+   }
+}
 
-   this->kills->push_tail(k);
+/**
+ * Empties the ACP, including anything available from enclosing blocks.
+ */
+void
+ir_copy_propagation_elements_visitor::kill_all()
+{
+   table_clear(scope->acp);
+   table_clear(scope->copies);
+   scope->killed_all = true;
 }
 
 /**
@@ -481,14 +558,29 @@ ir_copy_propagation_elements_visitor::add_copy(ir_assignment *ir)
 
    entry = new(this->mem_ctx) acp_entry(lhs->var, rhs->var, write_mask,
 					swizzle);
-   this->acp->push_tail(entry);
+
+   exec_list *entries = (exec_list *) table_find(scope->acp, lhs->var);
+   if (entries == NULL) {
+      entries = new(this->mem_ctx) exec_list;
+      table_insert(scope->acp, lhs->var, entries);
+   }
+   entries->push_tail(entry);
+
+   exec_list *copies = (exec_list *) table_find(scope->copies, rhs->var);
+   if (copies == NULL) {
+      copies = new(this->mem_ctx) exec_list;
+      table_insert(scope->copies, rhs->var, copies);
+   }
+   copies->push_tail(new(this->mem_ctx) acp_ref(entry));
 }
 
 bool
 do_copy_propagation_elements(exec_list *instructions)
 {
    ir_copy_propagation_elements_visitor v;
+   acp_scope top_scope(NULL);
 
+   v.scope = &top_scope;
    visit_list_elements(&v, instructions);
 
    return v.progress;
@@ -0,0 +1,178 @@
+/* Author(s):
+ *   Connor Abbott
+ *
+ * Copyright (c) 2014 Connor Abbott (connor@abbott.cx)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "arena.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define ALIGN 16
+#define NUM_CLASSES 64 /* so the largest size class is 1 KiB */
+#define MAX_SMALL (ALIGN * NUM_CLASSES)
+#define CHUNK_SIZE (64 * 1024)
+
+typedef struct chunk_s {
+	struct chunk_s* next;
+} chunk_t;
+
+/* allocations too big for a size class get their own block, with this in
+ * front of them so they can be found when deleting the arena
+ */
+typedef struct large_s {
+	struct large_s* prev, *next;
+} large_t;
+
+typedef struct free_s {
+	struct free_s* next;
+} free_t;
+
+struct arena_s {
+	chunk_t* chunks;
+	char* cur, *end; /* the unused part of the current chunk */
+	free_t* free_lists[NUM_CLASSES];
+	large_t large; /* sentinel */
+};
+
+#define HEADER_SIZE(type) ((sizeof(type) + ALIGN - 1) & ~(ALIGN - 1))
+
+static inline unsigned size_class(size_t size)
+{
+	return (size + ALIGN - 1) / ALIGN - 1;
+}
+
+arena_t* arena_create(void)
+{
+	arena_t* arena = calloc(1, sizeof(arena_t));
+	if (!arena)
+		return NULL;
+	
+	arena->large.prev = arena->large.next = &arena->large;
+	return arena;
+}
+
+void arena_delete(arena_t* arena)
+{
+	chunk_t* chunk = arena->chunks;
+	while (chunk)
+	{
+		chunk_t* next = chunk->next;
+		free(chunk);
+		chunk = next;
+	}
+	
+	large_t* large = arena->large.next;
+	while (large != &arena->large)
+	{
+		large_t* next = large->next;
+		free(large);
+		large = next;
+	}
+	
+	free(arena);
+}
+
+static void* alloc_large(arena_t* arena, size_t size)
+{
+	large_t* large = malloc(HEADER_SIZE(large_t) + size);
+	if (!large)
+		return NULL;
+	
+	large->prev = &arena->large;
+	large->next = arena->large.next;
+	arena->large.next->prev = large;
+	arena->large.next = large;
+	return (char*) large + HEADER_SIZE(large_t);
+}
+
+static bool new_chunk(arena_t* arena)
+{
+	chunk_t* chunk = malloc(CHUNK_SIZE);
+	if (!chunk)
+		return false;
+	
+	chunk->next = arena->chunks;
+	arena->chunks = chunk;
+	arena->cur = (char*) chunk + HEADER_SIZE(chunk_t);
+	arena->end = (char*) chunk + CHUNK_SIZE;
+	return true;
+}
+
+void* arena_alloc(arena_t* arena, size_t size)
+{
+	if (size == 0)
+		size = 1;
+	
+	if (size > MAX_SMALL)
+		return alloc_large(arena, size);
+	
+	unsigned class = size_class(size);
+	free_t* block = arena->free_lists[class];
+	if (block)
+	{
+		arena->free_lists[class] = block->next;
+		return block;
+	}
+	
+	size_t block_size = (class + 1) * ALIGN;
+	if ((size_t) (arena->end - arena->cur) < block_size)
+	{
+		/* the rest of the current chunk is wasted, but it's at most 1 KiB */
+		if (!new_chunk(arena))
+			return NULL;
+	}
+	
+	void* ret = arena->cur;
+	arena->cur += block_size;
+	return ret;
+}
+
+void* arena_calloc(arena_t* arena, size_t size)
+{
+	void* ret = arena_alloc(arena, size);
+	if (ret)
+		memset(ret, 0, size);
+	return ret;
+}
+
+void arena_free(arena_t* arena, void* ptr, size_t size)
+{
+	if (!ptr)
+		return;
+	
+	if (size == 0)
+		size = 1;
+	
+	if (size > MAX_SMALL)
+	{
+		large_t* large = (large_t*) ((char*) ptr - HEADER_SIZE(large_t));
+		large->prev->next = large->next;
+		large->next->prev = large->prev;
+		free(large);
+		return;
+	}
+	
+	unsigned class = size_class(size);
+	free_t* block = ptr;
+	block->next = arena->free_lists[class];
+	arena->free_lists[class] = block;
+}
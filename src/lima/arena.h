@@ -0,0 +1,57 @@
+/* Author(s):
+ *   Connor Abbott
+ *
+ * Copyright (c) 2014 Connor Abbott (connor@abbott.cx)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef __arena_h__
+#define __arena_h__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * A slab allocator for the many small objects (IR nodes, dependency edges,
+ * and the sets hanging off them) that make up a program. Small allocations
+ * are carved out of large chunks, freed blocks are kept on a free list per
+ * size and reused, and everything is given back to the system at once when
+ * the arena is deleted. Callers must pass the size of the allocation back in
+ * when freeing it. Arenas aren't thread-safe.
+ */
+
+typedef struct arena_s arena_t;
+
+arena_t* arena_create(void);
+void arena_delete(arena_t* arena);
+
+void* arena_alloc(arena_t* arena, size_t size);
+void* arena_calloc(arena_t* arena, size_t size);
+void arena_free(arena_t* arena, void* ptr, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
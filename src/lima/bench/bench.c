@@ -0,0 +1,799 @@
+/* Author(s):
+ *   Connor Abbott
+ *
+ * Copyright (c) 2014 Connor Abbott (connor@abbott.cx)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Compile benchmark. Every input is compiled a few times in a child process,
+ * so that a crash in the compiler only fails that input and the peak RSS of
+ * the child is the peak for that shader alone. The fastest time of each
+ * stage is kept, since everything slower than that is noise from the rest of
+ * the machine.
+ *
+ * There are two kinds of baseline. The checked in one only has what doesn't
+ * depend on the machine: whether each input compiles, and the size of the
+ * code and how hard the backend had to work to get it. Times and RSS can only
+ * be compared against a run on the same machine, so they go in a separate
+ * file that's made locally, and only compared if it was made on this host.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <stdbool.h>
+#include <time.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include "shader.h"
+
+#define USAGE \
+"usage: limabench [options] inputs...\n" \
+"\n" \
+"options:\n" \
+"\t--core (-c) -- choose which processor to compile for.\n" \
+"\t\tMali-200\n" \
+"\t\tMali-400\n" \
+"\t\tDefault: Mali-400\n" \
+"\t--iterations (-n) [number] -- compile each input this many times,\n" \
+"\t\tand report the fastest time of each stage. Default: 3\n" \
+"\t--baseline (-b) [file] -- compare whether each input compiles and\n" \
+"\t\tthe instruction count and code size against this file, and exit\n" \
+"\t\twith an error if any input regressed.\n" \
+"\t--times (-t) [file] -- compare the times and peak RSS against this\n" \
+"\t\tfile, if it was written on the same host.\n" \
+"\t--update (-u) -- write the results to the baseline and times files\n" \
+"\t\tinstead of comparing against them.\n" \
+"\t--threshold (-r) [percent] -- how much worse than the times file the\n" \
+"\t\ttotal time or peak RSS of an input may get before it counts as a\n" \
+"\t\tregression. Default: 20\n" \
+"\t--help (-h) -- print this message and quit.\n" \
+"\n" \
+"The type of each input is guessed from its .vert or .frag extension.\n"
+
+/* times below this are too short to compare reliably */
+#define MIN_TIME 0.002
+
+static void usage(void)
+{
+	fprintf(stderr, USAGE);
+}
+
+static char* read_file(const char* path)
+{
+	FILE* fp = fopen(path, "rb");
+	if (!fp) return NULL;
+
+	if (fseek(fp, 0, SEEK_END) != 0)
+	{
+		fclose(fp);
+		return NULL;
+	}
+	long fsize = ftell(fp);
+	if ((fsize <= 0)
+		|| (fseek(fp, 0, SEEK_SET) != 0))
+	{
+		fclose(fp);
+		return NULL;
+	}
+
+	char* data = (char*)malloc(fsize + 1);
+	if (!data)
+	{
+		fclose(fp);
+		return NULL;
+	}
+
+	if (fread(data, fsize, 1, fp) != 1)
+	{
+		fclose(fp);
+		free(data);
+		return NULL;
+	}
+	data[fsize] = '\0';
+
+	fclose(fp);
+	return data;
+}
+
+static const char* base_name(const char* path)
+{
+	const char* name = strrchr(path, '/');
+	return name ? name + 1 : path;
+}
+
+static lima_shader_stage_e guess_stage(const char* path)
+{
+	const char* ext = strrchr(path, '.');
+	if (ext && strcmp(ext, ".vert") == 0)
+		return lima_shader_stage_vertex;
+	if (ext && strcmp(ext, ".frag") == 0)
+		return lima_shader_stage_fragment;
+	return lima_shader_stage_unknown;
+}
+
+static double get_time(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+typedef struct
+{
+	char name[64];
+	bool success;
+	double parse_time, optimize_time, compile_time, total_time;
+	unsigned long peak_rss; /* in KiB */
+	unsigned num_instrs, code_size;
+	unsigned sched_restarts, spill_iterations;
+} result_t;
+
+/*
+ * The number of instructions in the output. Vertex shader instructions are
+ * all the same size, but fragment shader instructions aren't, so for those
+ * we count the instructions going into codegen.
+ */
+
+static unsigned get_num_instrs(lima_shader_t* shader)
+{
+	if (lima_shader_get_stage(shader) == lima_shader_stage_vertex)
+		return lima_shader_get_info(shader).vs.num_instructions;
+
+	const lima_shader_stats_t* stats = lima_shader_get_stats(shader);
+	unsigned i;
+	for (i = 0; i < stats->num_passes; i++)
+		if (strcmp(stats->passes[i].name, "lima_pp_lir_codegen") == 0)
+			return stats->passes[i].size_after;
+
+	return 0;
+}
+
+static bool compile_once(lima_compiler_t* compiler, lima_core_e core,
+						 lima_shader_stage_e stage, const char* source,
+						 result_t* result, bool first)
+{
+	lima_shader_t* shader = lima_shader_create(compiler, stage, core);
+	if (!shader)
+		return false;
+
+	bool success = false;
+
+	lima_shader_enable_stats(shader);
+
+	double start = get_time();
+	lima_shader_parse(shader, source);
+	if (lima_shader_error(shader))
+	{
+		if (first)
+			fprintf(stderr, "%s: %s", result->name,
+					lima_shader_info_log(shader));
+		goto cleanup;
+	}
+
+	double parsed = get_time();
+	lima_shader_optimize(shader);
+	double optimized = get_time();
+	lima_shader_compile(shader, false);
+	double compiled = get_time();
+
+	if (lima_shader_error(shader))
+	{
+		if (first)
+			fprintf(stderr, "%s: %s", result->name,
+					lima_shader_info_log(shader));
+		goto cleanup;
+	}
+
+	double parse_time = parsed - start;
+	double optimize_time = optimized - parsed;
+	double compile_time = compiled - optimized;
+	double total_time = compiled - start;
+
+	if (first || parse_time < result->parse_time)
+		result->parse_time = parse_time;
+	if (first || optimize_time < result->optimize_time)
+		result->optimize_time = optimize_time;
+	if (first || compile_time < result->compile_time)
+		result->compile_time = compile_time;
+	if (first || total_time < result->total_time)
+		result->total_time = total_time;
+
+	const lima_shader_stats_t* stats = lima_shader_get_stats(shader);
+	result->num_instrs = get_num_instrs(shader);
+	result->code_size = lima_shader_get_code_size(shader);
+	result->sched_restarts = stats->sched_restarts;
+	result->spill_iterations = stats->spill_iterations;
+
+	success = true;
+
+cleanup:
+	lima_shader_delete(shader);
+	return success;
+}
+
+/* runs in the child, and writes the result to fd */
+
+static void bench_child(lima_compiler_t* compiler, lima_core_e core,
+						const char* path, unsigned iterations,
+						result_t* result, int fd)
+{
+	char* source = read_file(path);
+	if (!source)
+	{
+		fprintf(stderr, "Error: could not read input file %s\n", path);
+		_exit(1);
+	}
+
+	lima_shader_stage_e stage = guess_stage(path);
+
+	unsigned i;
+	for (i = 0; i < iterations; i++)
+		if (!compile_once(compiler, core, stage, source, result, i == 0))
+			_exit(1);
+
+	result->success = true;
+	if (write(fd, result, sizeof(*result)) != sizeof(*result))
+		_exit(1);
+
+	free(source);
+	_exit(0);
+}
+
+static void bench_shader(lima_compiler_t* compiler, lima_core_e core,
+						 const char* path, unsigned iterations,
+						 result_t* result)
+{
+	memset(result, 0, sizeof(*result));
+	snprintf(result->name, sizeof(result->name), "%s", base_name(path));
+
+	int fds[2];
+	if (pipe(fds) != 0)
+	{
+		perror("pipe");
+		return;
+	}
+
+	fflush(stdout);
+	fflush(stderr);
+
+	pid_t pid = fork();
+	if (pid < 0)
+	{
+		perror("fork");
+		close(fds[0]);
+		close(fds[1]);
+		return;
+	}
+
+	if (pid == 0)
+	{
+		close(fds[0]);
+		bench_child(compiler, core, path, iterations, result, fds[1]);
+	}
+
+	close(fds[1]);
+
+	result_t child_result;
+	bool got_result =
+		read(fds[0], &child_result, sizeof(child_result)) ==
+		sizeof(child_result);
+	close(fds[0]);
+
+	int status;
+	struct rusage usage;
+	if (wait4(pid, &status, 0, &usage) != pid)
+	{
+		perror("wait4");
+		return;
+	}
+
+	if (WIFSIGNALED(status))
+		fprintf(stderr, "%s: compiler died with signal %d\n", result->name,
+				WTERMSIG(status));
+
+	if (!got_result || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+		return;
+
+	*result = child_result;
+	result->peak_rss = usage.ru_maxrss;
+}
+
+static void print_header(FILE* fp)
+{
+	fprintf(fp, "# %-28s %6s %9s %9s %9s %9s %8s %6s %6s %4s %4s\n",
+			"name", "status", "parse", "optimize", "compile", "total",
+			"rss_kb", "instrs", "bytes", "rst", "spl");
+}
+
+static void print_result(FILE* fp, const result_t* result)
+{
+	if (!result->success)
+	{
+		fprintf(fp, "  %-28s %6s\n", result->name, "fail");
+		return;
+	}
+
+	fprintf(fp, "  %-28s %6s %9.3f %9.3f %9.3f %9.3f %8lu %6u %6u %4u %4u\n",
+			result->name, "ok", result->parse_time * 1000.,
+			result->optimize_time * 1000., result->compile_time * 1000.,
+			result->total_time * 1000., result->peak_rss, result->num_instrs,
+			result->code_size, result->sched_restarts,
+			result->spill_iterations);
+}
+
+/*
+ * The baseline and times files are the columns of the printed table that
+ * they keep, with the times in milliseconds. Lines starting with # are
+ * ignored, except for the host line of the times file.
+ */
+
+static void print_counts(FILE* fp, const result_t* result)
+{
+	if (!result->success)
+	{
+		fprintf(fp, "  %-28s %6s\n", result->name, "fail");
+		return;
+	}
+
+	fprintf(fp, "  %-28s %6s %6u %6u %4u %4u\n", result->name, "ok",
+			result->num_instrs, result->code_size, result->sched_restarts,
+			result->spill_iterations);
+}
+
+static void print_times(FILE* fp, const result_t* result)
+{
+	if (!result->success)
+	{
+		fprintf(fp, "  %-28s %6s\n", result->name, "fail");
+		return;
+	}
+
+	fprintf(fp, "  %-28s %6s %9.3f %9.3f %9.3f %9.3f %8lu\n",
+			result->name, "ok", result->parse_time * 1000.,
+			result->optimize_time * 1000., result->compile_time * 1000.,
+			result->total_time * 1000., result->peak_rss);
+}
+
+static bool get_host(char* host, size_t size)
+{
+	if (gethostname(host, size) != 0)
+		return false;
+	host[size - 1] = '\0';
+	return true;
+}
+
+static bool write_baseline(const char* path, bool times,
+						   const result_t* results, unsigned num_results)
+{
+	FILE* fp = fopen(path, "w");
+	if (!fp)
+	{
+		fprintf(stderr, "Error: could not open %s for writing\n", path);
+		return false;
+	}
+
+	unsigned i;
+	if (times)
+	{
+		char host[HOST_NAME_MAX + 1];
+		if (get_host(host, sizeof(host)))
+			fprintf(fp, "# host %s\n", host);
+		fprintf(fp, "# %-28s %6s %9s %9s %9s %9s %8s\n", "name", "status",
+				"parse", "optimize", "compile", "total", "rss_kb");
+		for (i = 0; i < num_results; i++)
+			print_times(fp, &results[i]);
+	}
+	else
+	{
+		fprintf(fp, "# %-28s %6s %6s %6s %4s %4s\n", "name", "status",
+				"instrs", "bytes", "rst", "spl");
+		for (i = 0; i < num_results; i++)
+			print_counts(fp, &results[i]);
+	}
+
+	fclose(fp);
+	return true;
+}
+
+/* host is set to the host the file was written on, if it says */
+
+static result_t* read_baseline(const char* path, bool times,
+							   unsigned* num_results, char* host,
+							   size_t host_size)
+{
+	FILE* fp = fopen(path, "r");
+	if (!fp)
+	{
+		fprintf(stderr, "Error: could not read baseline %s\n", path);
+		return NULL;
+	}
+
+	unsigned capacity = 16;
+	result_t* results = malloc(capacity * sizeof(result_t));
+	*num_results = 0;
+	if (host)
+		host[0] = '\0';
+
+	char line[512];
+	while (fgets(line, sizeof(line), fp))
+	{
+		char* start = line + strspn(line, " \t");
+		if (host && strncmp(start, "# host ", 7) == 0)
+		{
+			snprintf(host, host_size, "%s", start + 7);
+			host[strcspn(host, "\n")] = '\0';
+			continue;
+		}
+		if (*start == '#' || *start == '\n' || *start == '\0')
+			continue;
+
+		if (*num_results == capacity)
+		{
+			capacity *= 2;
+			results = realloc(results, capacity * sizeof(result_t));
+		}
+
+		result_t* result = &results[*num_results];
+		memset(result, 0, sizeof(*result));
+
+		char status[8];
+		int fields, expected;
+		if (times)
+		{
+			fields = sscanf(start, "%63s %7s %lf %lf %lf %lf %lu",
+							result->name, status, &result->parse_time,
+							&result->optimize_time, &result->compile_time,
+							&result->total_time, &result->peak_rss);
+			expected = 7;
+		}
+		else
+		{
+			fields = sscanf(start, "%63s %7s %u %u %u %u",
+							result->name, status, &result->num_instrs,
+							&result->code_size, &result->sched_restarts,
+							&result->spill_iterations);
+			expected = 6;
+		}
+		if (fields < 2)
+			continue;
+
+		result->success = strcmp(status, "ok") == 0;
+		if (result->success && fields != expected)
+		{
+			fprintf(stderr, "Error: malformed baseline line: %s", line);
+			continue;
+		}
+
+		result->parse_time /= 1000.;
+		result->optimize_time /= 1000.;
+		result->compile_time /= 1000.;
+		result->total_time /= 1000.;
+		(*num_results)++;
+	}
+
+	fclose(fp);
+	return results;
+}
+
+static bool worse(double new_value, double old_value, double threshold)
+{
+	return new_value > old_value * (1. + threshold / 100.);
+}
+
+/*
+ * prints what got worse, and returns the number of regressions. The counts
+ * don't depend on the machine, so any increase is a regression, while times
+ * and RSS get the threshold.
+ */
+
+static unsigned compare_result(const result_t* new_result,
+							   const result_t* old_result, bool times,
+							   double threshold)
+{
+	if (!old_result->success)
+	{
+		if (new_result->success && !times)
+			printf("%s: now compiles\n", new_result->name);
+		return 0;
+	}
+
+	if (!new_result->success)
+	{
+		if (times)
+			return 0;
+		printf("REGRESSION %s: no longer compiles\n", new_result->name);
+		return 1;
+	}
+
+	unsigned regressions = 0;
+
+	if (times)
+	{
+		if (new_result->total_time > MIN_TIME &&
+			worse(new_result->total_time, old_result->total_time, threshold))
+		{
+			printf("REGRESSION %s: total time %.3f ms -> %.3f ms\n",
+				   new_result->name, old_result->total_time * 1000.,
+				   new_result->total_time * 1000.);
+			regressions++;
+		}
+
+		if (worse(new_result->peak_rss, old_result->peak_rss, threshold))
+		{
+			printf("REGRESSION %s: peak RSS %lu KiB -> %lu KiB\n",
+				   new_result->name, old_result->peak_rss,
+				   new_result->peak_rss);
+			regressions++;
+		}
+
+		return regressions;
+	}
+
+	if (new_result->num_instrs > old_result->num_instrs)
+	{
+		printf("REGRESSION %s: instructions %u -> %u\n",
+			   new_result->name, old_result->num_instrs,
+			   new_result->num_instrs);
+		regressions++;
+	}
+
+	if (new_result->code_size > old_result->code_size)
+	{
+		printf("REGRESSION %s: code size %u -> %u bytes\n",
+			   new_result->name, old_result->code_size,
+			   new_result->code_size);
+		regressions++;
+	}
+
+	if (new_result->num_instrs < old_result->num_instrs ||
+		new_result->code_size < old_result->code_size)
+		printf("%s: smaller than the baseline, consider updating it\n",
+			   new_result->name);
+
+	return regressions;
+}
+
+static unsigned compare_baseline(const result_t* results, unsigned num_results,
+								 const result_t* baseline, unsigned num_baseline,
+								 bool times, double threshold)
+{
+	unsigned regressions = 0;
+	unsigned i, j;
+	for (i = 0; i < num_results; i++)
+	{
+		for (j = 0; j < num_baseline; j++)
+			if (strcmp(results[i].name, baseline[j].name) == 0)
+				break;
+
+		if (j == num_baseline)
+		{
+			if (!times)
+				printf("%s: not in the baseline\n", results[i].name);
+			continue;
+		}
+
+		regressions += compare_result(&results[i], &baseline[j], times,
+									  threshold);
+	}
+
+	return regressions;
+}
+
+/* returns the number of regressions, or -1 if the file couldn't be read */
+
+static int check_baseline(const char* path, bool times,
+						  const result_t* results, unsigned num_results,
+						  double threshold)
+{
+	char host[HOST_NAME_MAX + 1], this_host[HOST_NAME_MAX + 1];
+	unsigned num_baseline;
+	result_t* baseline = read_baseline(path, times, &num_baseline,
+									   times ? host : NULL, sizeof(host));
+	if (!baseline)
+		return -1;
+
+	if (times && (!get_host(this_host, sizeof(this_host)) ||
+				  strcmp(host, this_host) != 0))
+	{
+		printf("%s was made on another host, not comparing times\n", path);
+		free(baseline);
+		return 0;
+	}
+
+	int regressions = compare_baseline(results, num_results, baseline,
+									   num_baseline, times, threshold);
+	free(baseline);
+	return regressions;
+}
+
+int main(int argc, char** argv)
+{
+	lima_core_e core = lima_core_mali_400;
+	unsigned iterations = 3;
+	const char* baseline_path = NULL;
+	const char* times_path = NULL;
+	bool update = false;
+	double threshold = 20.;
+
+	static struct option long_options[] = {
+		{"core",       required_argument, NULL, 'c'},
+		{"iterations", required_argument, NULL, 'n'},
+		{"baseline",   required_argument, NULL, 'b'},
+		{"times",      required_argument, NULL, 't'},
+		{"update",     no_argument,       NULL, 'u'},
+		{"threshold",  required_argument, NULL, 'r'},
+		{"help",       no_argument,       NULL, 'h'},
+		{NULL,         0,                 NULL, 0}
+	};
+
+	int c;
+	while ((c = getopt_long(argc, argv, "c:n:b:t:ur:h", long_options, NULL))
+		   != -1)
+	{
+		switch (c)
+		{
+			case 'c':
+				if (strcmp(optarg, "Mali-200") == 0)
+					core = lima_core_mali_200;
+				else if (strcmp(optarg, "Mali-400") == 0)
+					core = lima_core_mali_400;
+				else
+				{
+					fprintf(stderr, "Error: unknown core %s\n", optarg);
+					usage();
+					return 1;
+				}
+				break;
+
+			case 'n':
+				iterations = strtoul(optarg, NULL, 10);
+				if (iterations == 0)
+				{
+					fprintf(stderr, "Error: invalid iteration count %s\n",
+							optarg);
+					return 1;
+				}
+				break;
+
+			case 'b':
+				baseline_path = optarg;
+				break;
+
+			case 't':
+				times_path = optarg;
+				break;
+
+			case 'u':
+				update = true;
+				break;
+
+			case 'r':
+				threshold = strtod(optarg, NULL);
+				break;
+
+			case 'h':
+				usage();
+				return 0;
+
+			default:
+				usage();
+				return 1;
+		}
+	}
+
+	if (optind == argc)
+	{
+		fprintf(stderr, "Error: no inputs\n");
+		usage();
+		return 1;
+	}
+
+	if (update && !baseline_path && !times_path)
+	{
+		fprintf(stderr, "Error: --update needs a baseline or times file\n");
+		return 1;
+	}
+
+	unsigned num_results = argc - optind;
+	unsigned i;
+	for (i = 0; i < num_results; i++)
+		if (guess_stage(argv[optind + i]) == lima_shader_stage_unknown)
+		{
+			fprintf(stderr, "Error: cannot guess the type of %s\n",
+					argv[optind + i]);
+			return 1;
+		}
+
+	/*
+	 * Create the compiler up front, so that building the builtin library
+	 * isn't counted against the first shader.
+	 */
+
+	lima_compiler_t* compiler = lima_compiler_create();
+	if (!compiler)
+	{
+		fprintf(stderr, "Error: could not create the compiler\n");
+		return 1;
+	}
+
+	result_t* results = calloc(num_results, sizeof(result_t));
+
+	printf("times in ms, %u iterations\n", iterations);
+	print_header(stdout);
+	for (i = 0; i < num_results; i++)
+	{
+		bench_shader(compiler, core, argv[optind + i], iterations,
+					 &results[i]);
+		print_result(stdout, &results[i]);
+		fflush(stdout);
+	}
+
+	int ret = 0;
+
+	if (update)
+	{
+		if (baseline_path &&
+			!write_baseline(baseline_path, false, results, num_results))
+			ret = 1;
+		if (times_path &&
+			!write_baseline(times_path, true, results, num_results))
+			ret = 1;
+	}
+	else if (baseline_path || times_path)
+	{
+		int regressions = 0, count;
+		if (baseline_path)
+		{
+			count = check_baseline(baseline_path, false, results,
+								   num_results, threshold);
+			if (count < 0)
+				ret = 1;
+			else
+				regressions += count;
+		}
+		if (times_path)
+		{
+			count = check_baseline(times_path, true, results, num_results,
+								   threshold);
+			if (count < 0)
+				ret = 1;
+			else
+				regressions += count;
+		}
+
+		if (regressions)
+		{
+			printf("%d regressions\n", regressions);
+			ret = 1;
+		}
+		else if (!ret)
+			printf("no regressions\n");
+	}
+
+	free(results);
+	lima_compiler_delete(compiler);
+	return ret;
+}
@@ -0,0 +1,71 @@
+precision mediump float;
+varying vec4 v_data;
+uniform vec4 u_coeffs[16];
+void main() {
+  vec4 a = v_data;
+  vec4 t0 = a * u_coeffs[0] + vec4(0.0);
+  a = t0.yzwx * a.wxyz;
+  vec4 t1 = a * u_coeffs[1] + vec4(1.0);
+  a = t1.yzwx * a.wxyz;
+  vec4 t2 = a * u_coeffs[2] + vec4(2.0);
+  a = t2.yzwx * a.wxyz;
+  vec4 t3 = a * u_coeffs[3] + vec4(3.0);
+  a = t3.yzwx * a.wxyz;
+  vec4 t4 = a * u_coeffs[4] + vec4(4.0);
+  a = t4.yzwx * a.wxyz;
+  vec4 t5 = a * u_coeffs[5] + vec4(5.0);
+  a = t5.yzwx * a.wxyz;
+  vec4 t6 = a * u_coeffs[6] + vec4(6.0);
+  a = t6.yzwx * a.wxyz;
+  vec4 t7 = a * u_coeffs[7] + vec4(7.0);
+  a = t7.yzwx * a.wxyz;
+  vec4 t8 = a * u_coeffs[8] + vec4(8.0);
+  a = t8.yzwx * a.wxyz;
+  vec4 t9 = a * u_coeffs[9] + vec4(9.0);
+  a = t9.yzwx * a.wxyz;
+  vec4 t10 = a * u_coeffs[10] + vec4(10.0);
+  a = t10.yzwx * a.wxyz;
+  vec4 t11 = a * u_coeffs[11] + vec4(11.0);
+  a = t11.yzwx * a.wxyz;
+  vec4 t12 = a * u_coeffs[12] + vec4(12.0);
+  a = t12.yzwx * a.wxyz;
+  vec4 t13 = a * u_coeffs[13] + vec4(13.0);
+  a = t13.yzwx * a.wxyz;
+  vec4 t14 = a * u_coeffs[14] + vec4(14.0);
+  a = t14.yzwx * a.wxyz;
+  vec4 t15 = a * u_coeffs[15] + vec4(15.0);
+  a = t15.yzwx * a.wxyz;
+  vec4 t16 = a * u_coeffs[0] + vec4(16.0);
+  a = t16.yzwx * a.wxyz;
+  vec4 t17 = a * u_coeffs[1] + vec4(17.0);
+  a = t17.yzwx * a.wxyz;
+  vec4 t18 = a * u_coeffs[2] + vec4(18.0);
+  a = t18.yzwx * a.wxyz;
+  vec4 t19 = a * u_coeffs[3] + vec4(19.0);
+  a = t19.yzwx * a.wxyz;
+  vec4 t20 = a * u_coeffs[4] + vec4(20.0);
+  a = t20.yzwx * a.wxyz;
+  vec4 t21 = a * u_coeffs[5] + vec4(21.0);
+  a = t21.yzwx * a.wxyz;
+  vec4 t22 = a * u_coeffs[6] + vec4(22.0);
+  a = t22.yzwx * a.wxyz;
+  vec4 t23 = a * u_coeffs[7] + vec4(23.0);
+  a = t23.yzwx * a.wxyz;
+  vec4 t24 = a * u_coeffs[8] + vec4(24.0);
+  a = t24.yzwx * a.wxyz;
+  vec4 t25 = a * u_coeffs[9] + vec4(25.0);
+  a = t25.yzwx * a.wxyz;
+  vec4 t26 = a * u_coeffs[10] + vec4(26.0);
+  a = t26.yzwx * a.wxyz;
+  vec4 t27 = a * u_coeffs[11] + vec4(27.0);
+  a = t27.yzwx * a.wxyz;
+  vec4 t28 = a * u_coeffs[12] + vec4(28.0);
+  a = t28.yzwx * a.wxyz;
+  vec4 t29 = a * u_coeffs[13] + vec4(29.0);
+  a = t29.yzwx * a.wxyz;
+  vec4 t30 = a * u_coeffs[14] + vec4(30.0);
+  a = t30.yzwx * a.wxyz;
+  vec4 t31 = a * u_coeffs[15] + vec4(31.0);
+  a = t31.yzwx * a.wxyz;
+  gl_FragColor = a;
+}
@@ -0,0 +1,15 @@
+precision mediump float;
+varying vec2 v_uv;
+uniform float u_zoom;
+void main() {
+  vec2 c = v_uv * u_zoom - vec2(0.5, 0.0);
+  vec2 z = vec2(0.0);
+  float n = 0.0;
+  for (int i = 0; i < 32; i++) {
+    z = vec2(z.x * z.x - z.y * z.y, 2.0 * z.x * z.y) + c;
+    if (dot(z, z) > 4.0)
+      break;
+    n += 1.0;
+  }
+  gl_FragColor = vec4(vec3(n / 32.0), 1.0);
+}
@@ -0,0 +1,14 @@
+precision mediump float;
+uniform vec4 u_colors[8];
+uniform int u_count;
+varying vec2 v_uv;
+void main() {
+  vec4 acc = vec4(0.0);
+  for (int i = 0; i < 8; i++) {
+    if (i >= u_count)
+      break;
+    float w = 1.0 / float(i + 1);
+    acc += u_colors[i] * w * step(0.5, fract(v_uv.x * float(i)));
+  }
+  gl_FragColor = clamp(acc, 0.0, 1.0);
+}
@@ -0,0 +1,17 @@
+precision mediump float;
+uniform sampler2D u_shadow_map;
+uniform vec2 u_texel;
+varying vec4 v_shadow_coord;
+varying vec4 v_color;
+void main() {
+  vec3 coord = v_shadow_coord.xyz / v_shadow_coord.w;
+  float lit = 0.0;
+  for (int y = -1; y <= 1; y++) {
+    for (int x = -1; x <= 1; x++) {
+      vec2 offset = vec2(float(x), float(y)) * u_texel;
+      float depth = texture2D(u_shadow_map, coord.xy + offset).r;
+      lit += coord.z <= depth ? 1.0 : 0.0;
+    }
+  }
+  gl_FragColor = vec4(v_color.rgb * (0.25 + 0.75 * lit / 9.0), v_color.a);
+}
@@ -0,0 +1,26 @@
+precision mediump float;
+uniform vec3 u_eye;
+uniform float u_radius;
+uniform int u_steps;
+varying vec3 v_dir;
+void main() {
+  vec3 dir = normalize(v_dir);
+  vec3 p = u_eye;
+  float t = 0.0;
+  bool hit = false;
+  for (int i = 0; i < 64; i++) {
+    if (i >= u_steps)
+      break;
+    float d = length(p) - u_radius;
+    if (d < 0.001) {
+      hit = true;
+      break;
+    }
+    t += d;
+    p = u_eye + dir * t;
+  }
+  if (!hit)
+    discard;
+  vec3 n = normalize(p);
+  gl_FragColor = vec4(n * 0.5 + 0.5, 1.0);
+}
@@ -0,0 +1,19 @@
+attribute vec4 pos;
+attribute vec3 normal;
+attribute vec2 uv;
+uniform mat4 mvp;
+uniform mat4 mv;
+uniform mat3 nmat;
+uniform vec3 light;
+varying vec2 v_uv;
+varying vec3 v_n;
+varying vec3 v_l;
+varying float v_d;
+void main() {
+  vec4 p = mv * pos;
+  v_n = normalize(nmat * normal);
+  v_l = normalize(light - p.xyz);
+  v_d = length(light - p.xyz);
+  v_uv = uv * 2.0 + vec2(0.5);
+  gl_Position = mvp * pos;
+}
@@ -0,0 +1,26 @@
+attribute vec4 a_position;
+attribute vec3 a_normal;
+attribute vec2 a_texcoord;
+uniform mat4 u_mvp;
+uniform mat4 u_model;
+uniform mat3 u_normal_matrix;
+uniform vec3 u_light_pos[4];
+uniform vec3 u_light_color[4];
+uniform vec3 u_eye;
+varying vec3 v_color;
+varying vec2 v_texcoord;
+void main() {
+  vec3 n = normalize(u_normal_matrix * a_normal);
+  vec3 p = (u_model * a_position).xyz;
+  vec3 c = vec3(0.1);
+  for (int i = 0; i < 4; i++) {
+    vec3 l = normalize(u_light_pos[i] - p);
+    float d = max(dot(n, l), 0.0);
+    vec3 h = normalize(l + normalize(u_eye - p));
+    float s = pow(max(dot(n, h), 0.0), 16.0);
+    c += u_light_color[i] * (d + s);
+  }
+  v_color = c;
+  v_texcoord = a_texcoord;
+  gl_Position = u_mvp * a_position;
+}
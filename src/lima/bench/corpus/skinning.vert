@@ -0,0 +1,15 @@
+attribute vec4 a_position;
+attribute vec4 a_weights;
+attribute vec4 a_indices;
+uniform mat4 u_bones[8];
+uniform mat4 u_vp;
+varying float v_depth;
+void main() {
+  mat4 m = u_bones[int(a_indices.x)] * a_weights.x
+         + u_bones[int(a_indices.y)] * a_weights.y
+         + u_bones[int(a_indices.z)] * a_weights.z
+         + u_bones[int(a_indices.w)] * a_weights.w;
+  vec4 p = u_vp * (m * a_position);
+  v_depth = p.z / p.w;
+  gl_Position = p;
+}
@@ -0,0 +1,9 @@
+attribute vec4 a_position;
+attribute vec4 a_color;
+uniform vec4 u_scale;
+uniform vec4 u_bias;
+varying vec4 v_color;
+void main() {
+  v_color = a_color;
+  gl_Position = vec4(a_position.xy * u_scale.xy + u_bias.xy, a_position.zw);
+}
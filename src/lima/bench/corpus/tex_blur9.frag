@@ -0,0 +1,17 @@
+precision mediump float;
+uniform sampler2D u_tex;
+uniform vec2 u_step;
+varying vec2 v_uv;
+void main() {
+  vec4 sum = vec4(0.0);
+  sum += texture2D(u_tex, v_uv - 4.0 * u_step) * 0.05;
+  sum += texture2D(u_tex, v_uv - 3.0 * u_step) * 0.09;
+  sum += texture2D(u_tex, v_uv - 2.0 * u_step) * 0.12;
+  sum += texture2D(u_tex, v_uv - 1.0 * u_step) * 0.15;
+  sum += texture2D(u_tex, v_uv) * 0.18;
+  sum += texture2D(u_tex, v_uv + 1.0 * u_step) * 0.15;
+  sum += texture2D(u_tex, v_uv + 2.0 * u_step) * 0.12;
+  sum += texture2D(u_tex, v_uv + 3.0 * u_step) * 0.09;
+  sum += texture2D(u_tex, v_uv + 4.0 * u_step) * 0.05;
+  gl_FragColor = sum;
+}
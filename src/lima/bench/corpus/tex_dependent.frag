@@ -0,0 +1,12 @@
+precision mediump float;
+uniform sampler2D u_offsets;
+uniform sampler2D u_color;
+uniform sampler2D u_ramp;
+uniform float u_strength;
+varying vec2 v_texcoord;
+void main() {
+  vec2 offset = texture2D(u_offsets, v_texcoord).xy * 2.0 - 1.0;
+  vec4 c = texture2D(u_color, v_texcoord + offset * u_strength);
+  float lum = dot(c.rgb, vec3(0.299, 0.587, 0.114));
+  gl_FragColor = texture2D(u_ramp, vec2(lum, 0.5)) * c.a;
+}
@@ -0,0 +1,20 @@
+precision mediump float;
+uniform sampler2D u_base;
+uniform sampler2D u_detail;
+uniform sampler2D u_lightmap;
+uniform sampler2D u_mask;
+uniform samplerCube u_env;
+uniform vec2 u_detail_scale;
+uniform float u_reflectivity;
+varying vec2 v_texcoord;
+varying vec2 v_lightmap_coord;
+varying vec3 v_reflect;
+void main() {
+  vec4 base = texture2D(u_base, v_texcoord);
+  vec4 detail = texture2D(u_detail, v_texcoord * u_detail_scale);
+  vec4 light = texture2D(u_lightmap, v_lightmap_coord);
+  float mask = texture2D(u_mask, v_texcoord).r;
+  vec4 env = textureCube(u_env, v_reflect);
+  vec4 color = base * (detail * 2.0) * light;
+  gl_FragColor = mix(color, env, mask * u_reflectivity);
+}
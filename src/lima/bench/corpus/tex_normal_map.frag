@@ -0,0 +1,19 @@
+precision mediump float;
+uniform sampler2D u_diffuse;
+uniform sampler2D u_normal_map;
+uniform vec3 u_light_dir;
+uniform vec4 u_ambient;
+uniform float u_shininess;
+varying vec2 v_uv;
+varying vec3 v_view;
+void main() {
+  vec3 n = normalize(texture2D(u_normal_map, v_uv).xyz * 2.0 - 1.0);
+  vec3 l = normalize(u_light_dir);
+  float diff = max(dot(n, l), 0.0);
+  vec3 r = reflect(-l, n);
+  float spec = pow(max(dot(r, normalize(v_view)), 0.0), u_shininess);
+  vec4 base = texture2D(u_diffuse, v_uv);
+  if (base.a < 0.1)
+    discard;
+  gl_FragColor = base * (u_ambient + diff) + vec4(spec);
+}
@@ -0,0 +1,76 @@
+precision mediump float;
+uniform sampler2D u_albedo;
+uniform sampler2D u_normal_map;
+uniform sampler2D u_specular_map;
+uniform sampler2D u_emissive;
+uniform samplerCube u_env;
+uniform vec4 u_base_color;
+uniform vec3 u_light_dir[3];
+uniform vec3 u_light_color[3];
+uniform vec3 u_ambient;
+uniform vec3 u_fog_color;
+uniform vec2 u_fog_range;
+uniform float u_shininess;
+uniform float u_alpha_ref;
+uniform float u_time;
+uniform bool u_use_normal_map;
+uniform bool u_use_env;
+uniform bool u_use_fog;
+uniform bool u_alpha_test;
+varying vec2 v_texcoord;
+varying vec3 v_normal;
+varying vec3 v_tangent;
+varying vec3 v_view;
+varying float v_depth;
+
+vec3 perturb_normal(vec3 n, vec3 t, vec2 uv) {
+  vec3 b = cross(n, t);
+  vec3 m = texture2D(u_normal_map, uv).xyz * 2.0 - 1.0;
+  return normalize(m.x * t + m.y * b + m.z * n);
+}
+
+float fresnel(vec3 n, vec3 v) {
+  float f = 1.0 - max(dot(n, v), 0.0);
+  return f * f * f * f * f;
+}
+
+void main() {
+  vec4 albedo = texture2D(u_albedo, v_texcoord) * u_base_color;
+  if (u_alpha_test && albedo.a < u_alpha_ref)
+    discard;
+
+  vec3 n = normalize(v_normal);
+  if (u_use_normal_map)
+    n = perturb_normal(n, normalize(v_tangent), v_texcoord);
+  vec3 v = normalize(v_view);
+  vec4 spec_sample = texture2D(u_specular_map, v_texcoord);
+
+  vec3 diffuse = u_ambient;
+  vec3 specular = vec3(0.0);
+  for (int i = 0; i < 3; i++) {
+    vec3 l = normalize(u_light_dir[i]);
+    float ndotl = max(dot(n, l), 0.0);
+    vec3 h = normalize(l + v);
+    float s = pow(max(dot(n, h), 0.0), u_shininess * spec_sample.a);
+    diffuse += u_light_color[i] * ndotl;
+    specular += u_light_color[i] * s * spec_sample.rgb;
+  }
+
+  vec3 color = albedo.rgb * diffuse + specular;
+
+  if (u_use_env) {
+    vec3 r = reflect(-v, n);
+    color = mix(color, textureCube(u_env, r).rgb, fresnel(n, v));
+  }
+
+  float pulse = 0.5 + 0.5 * sin(u_time * 3.0);
+  color += texture2D(u_emissive, v_texcoord).rgb * pulse;
+
+  if (u_use_fog) {
+    float f = clamp((v_depth - u_fog_range.x) / (u_fog_range.y - u_fog_range.x),
+                    0.0, 1.0);
+    color = mix(color, u_fog_color, f);
+  }
+
+  gl_FragColor = vec4(color, albedo.a);
+}
@@ -0,0 +1,43 @@
+attribute vec4 a_position;
+attribute vec3 a_normal;
+attribute vec3 a_tangent;
+attribute vec2 a_texcoord;
+attribute vec4 a_weights;
+attribute vec4 a_indices;
+uniform mat4 u_bones[4];
+uniform mat4 u_model;
+uniform mat4 u_view_proj;
+uniform mat3 u_normal_matrix;
+uniform mat4 u_texture_matrix;
+uniform vec3 u_eye;
+uniform float u_time;
+uniform bool u_skinned;
+uniform bool u_wave;
+varying vec2 v_texcoord;
+varying vec3 v_normal;
+varying vec3 v_tangent;
+varying vec3 v_view;
+varying float v_depth;
+void main() {
+  vec4 p = a_position;
+  vec3 n = a_normal;
+  vec3 t = a_tangent;
+  if (u_skinned) {
+    mat4 m = u_bones[int(a_indices.x)] * a_weights.x
+           + u_bones[int(a_indices.y)] * a_weights.y
+           + u_bones[int(a_indices.z)] * a_weights.z
+           + u_bones[int(a_indices.w)] * a_weights.w;
+    p = m * p;
+    n = (m * vec4(n, 0.0)).xyz;
+    t = (m * vec4(t, 0.0)).xyz;
+  }
+  if (u_wave)
+    p.y += sin(p.x * 2.0 + u_time) * 0.1;
+  vec4 world = u_model * p;
+  v_normal = u_normal_matrix * n;
+  v_tangent = u_normal_matrix * t;
+  v_view = u_eye - world.xyz;
+  v_texcoord = (u_texture_matrix * vec4(a_texcoord, 0.0, 1.0)).xy;
+  gl_Position = u_view_proj * world;
+  v_depth = gl_Position.w;
+}
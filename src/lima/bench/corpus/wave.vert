@@ -0,0 +1,15 @@
+attribute vec4 a_position;
+uniform float u_time;
+uniform bool u_wave;
+varying vec4 v_color;
+void main() {
+  vec4 p = a_position;
+  if (u_wave) {
+    p.y += sin(p.x * 4.0 + u_time) * 0.1;
+    p.x += cos(p.y * 3.0 - u_time) * 0.05;
+  } else {
+    p.xyz *= abs(fract(u_time) - 0.5) + 0.5;
+  }
+  v_color = vec4(exp(-p.z), log(abs(p.y) + 1.0), sqrt(abs(p.x)), 1.0);
+  gl_Position = p;
+}
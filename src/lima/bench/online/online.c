@@ -0,0 +1,527 @@
+/* Author(s):
+ *   Connor Abbott
+ *
+ * Copyright (c) 2014 Connor Abbott (connor@abbott.cx)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Stress test and benchmark for the online compiler. The inputs are first
+ * compiled one at a time with the plain lima_shader_* calls, and then a
+ * number of threads hammer lima_online_compile() and
+ * lima_online_compile_async() with random picks from them, checking every
+ * result against the plain one byte for byte. This is repeated with the memo
+ * cache at its default size, small enough that it's always evicting, and
+ * turned off, so that shaders are compiled, shared while in flight, reused,
+ * and dropped all at the same time.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+#include <pthread.h>
+#include "shader.h"
+
+#define USAGE \
+"usage: limabench-online [options] inputs...\n" \
+"\n" \
+"options:\n" \
+"\t--threads (-j) [number] -- how many threads make requests at once,\n" \
+"\t\twhich is also the size of the queue's thread pool. Default: 8\n" \
+"\t--requests (-n) [number] -- how many requests each thread makes\n" \
+"\t\tin each round. Default: 200\n" \
+"\t--help (-h) -- print this message and quit.\n" \
+"\n" \
+"The type of each input is guessed from its .vert or .frag extension.\n"
+
+static void usage(void)
+{
+	fprintf(stderr, USAGE);
+}
+
+static char* read_file(const char* path)
+{
+	FILE* fp = fopen(path, "rb");
+	if (!fp) return NULL;
+	
+	if (fseek(fp, 0, SEEK_END) != 0)
+	{
+		fclose(fp);
+		return NULL;
+	}
+	long fsize = ftell(fp);
+	if ((fsize <= 0)
+		|| (fseek(fp, 0, SEEK_SET) != 0))
+	{
+		fclose(fp);
+		return NULL;
+	}
+	
+	char* data = (char*)malloc(fsize + 1);
+	if (!data)
+	{
+		fclose(fp);
+		return NULL;
+	}
+	
+	if (fread(data, fsize, 1, fp) != 1)
+	{
+		fclose(fp);
+		free(data);
+		return NULL;
+	}
+	data[fsize] = '\0';
+	
+	fclose(fp);
+	return data;
+}
+
+static lima_shader_stage_e guess_stage(const char* path)
+{
+	const char* ext = strrchr(path, '.');
+	if (ext && strcmp(ext, ".vert") == 0)
+		return lima_shader_stage_vertex;
+	if (ext && strcmp(ext, ".frag") == 0)
+		return lima_shader_stage_fragment;
+	return lima_shader_stage_unknown;
+}
+
+static double get_time(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* an input, and what the plain interface made of it */
+
+typedef struct
+{
+	const char* path;
+	lima_shader_stage_e stage;
+	char* source;
+	
+	bool error;
+	void* code;
+	unsigned code_size;
+	lima_shader_info_t info;
+} input_t;
+
+static bool compile_reference(lima_compiler_t* compiler, input_t* input)
+{
+	lima_shader_t* shader = lima_shader_create(compiler, input->stage,
+											   lima_core_mali_400);
+	if (!shader)
+		return false;
+	
+	lima_shader_parse(shader, input->source);
+	if (!lima_shader_error(shader))
+	{
+		lima_shader_optimize(shader);
+		lima_shader_compile(shader, false);
+	}
+	
+	input->error = lima_shader_error(shader);
+	if (!input->error)
+	{
+		input->code_size = lima_shader_get_code_size(shader);
+		input->code = malloc(input->code_size);
+		if (!input->code)
+		{
+			lima_shader_delete(shader);
+			return false;
+		}
+		memcpy(input->code, lima_shader_get_code(shader), input->code_size);
+		input->info = lima_shader_get_info(shader);
+	}
+	
+	lima_shader_delete(shader);
+	return true;
+}
+
+static bool check_result(const input_t* input, lima_online_shader_t* shader)
+{
+	if (!lima_online_shader_is_done(shader))
+	{
+		fprintf(stderr, "%s: not done after waiting\n", input->path);
+		return false;
+	}
+	
+	if (lima_online_shader_error(shader) != input->error)
+	{
+		fprintf(stderr, "%s: %s\n", input->path, input->error ?
+				"compiled, but shouldn't have" : "failed to compile");
+		return false;
+	}
+	
+	if (input->error)
+		return true;
+	
+	lima_shader_info_t info = lima_online_shader_get_info(shader);
+	if (lima_online_shader_get_code_size(shader) != input->code_size ||
+		memcmp(lima_online_shader_get_code(shader), input->code,
+			   input->code_size) != 0 ||
+		(input->stage == lima_shader_stage_vertex ?
+		 info.vs.num_instructions != input->info.vs.num_instructions :
+		 info.fs.stack_size != input->info.fs.stack_size))
+	{
+		fprintf(stderr, "%s: different result from the online compiler\n",
+				input->path);
+		return false;
+	}
+	
+	return true;
+}
+
+typedef struct
+{
+	lima_compiler_t* compiler;
+	lima_online_queue_t* queue;
+	const input_t* inputs;
+	unsigned num_inputs;
+	unsigned num_requests;
+	
+	pthread_mutex_t lock; /* protects the rest */
+	unsigned callbacks; /* how many completion callbacks have run */
+	unsigned failures;
+} round_t;
+
+typedef struct
+{
+	round_t* round;
+	uint32_t seed;
+	unsigned num_async; /* async requests made */
+	pthread_t thread;
+} worker_t;
+
+static uint32_t rand_next(uint32_t* state)
+{
+	uint32_t x = *state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	return *state = x;
+}
+
+static void add_failure(round_t* round)
+{
+	pthread_mutex_lock(&round->lock);
+	round->failures++;
+	pthread_mutex_unlock(&round->lock);
+}
+
+static void callback(lima_online_shader_t* shader, void* data)
+{
+	round_t* round = data;
+	
+	bool done = lima_online_shader_is_done(shader);
+	
+	pthread_mutex_lock(&round->lock);
+	round->callbacks++;
+	if (!done)
+		round->failures++;
+	pthread_mutex_unlock(&round->lock);
+}
+
+/* how many async requests a thread may have in flight at once */
+#define MAX_PENDING 8
+
+static void* worker_thread(void* data)
+{
+	worker_t* worker = data;
+	round_t* round = worker->round;
+	
+	lima_online_shader_t* pending[MAX_PENDING];
+	const input_t* pending_inputs[MAX_PENDING];
+	unsigned num_pending = 0, i;
+	
+	for (i = 0; i < round->num_requests; i++)
+	{
+		uint32_t r = rand_next(&worker->seed);
+		const input_t* input = &round->inputs[r % round->num_inputs];
+		
+		/* roughly half synchronous, half asynchronous */
+		if ((r >> 16) & 1)
+		{
+			lima_online_shader_t* shader =
+				lima_online_compile(round->compiler, input->stage,
+									lima_core_mali_400, input->source);
+			if (!shader)
+			{
+				fprintf(stderr, "%s: out of memory\n", input->path);
+				add_failure(round);
+				continue;
+			}
+			
+			if (!check_result(input, shader))
+				add_failure(round);
+			lima_online_shader_release(shader);
+			continue;
+		}
+		
+		if (num_pending == MAX_PENDING)
+		{
+			/* finish a random one, so they don't finish in order */
+			unsigned j = (r >> 17) % MAX_PENDING;
+			lima_online_shader_wait(pending[j]);
+			if (!check_result(pending_inputs[j], pending[j]))
+				add_failure(round);
+			lima_online_shader_release(pending[j]);
+			
+			num_pending--;
+			pending[j] = pending[num_pending];
+			pending_inputs[j] = pending_inputs[num_pending];
+		}
+		
+		lima_online_shader_t* shader =
+			lima_online_compile_async(round->queue, input->stage,
+									  lima_core_mali_400, input->source,
+									  callback, round);
+		if (!shader)
+		{
+			fprintf(stderr, "%s: out of memory\n", input->path);
+			add_failure(round);
+			continue;
+		}
+		
+		pending[num_pending] = shader;
+		pending_inputs[num_pending] = input;
+		num_pending++;
+		worker->num_async++;
+	}
+	
+	for (i = 0; i < num_pending; i++)
+	{
+		lima_online_shader_wait(pending[i]);
+		if (!check_result(pending_inputs[i], pending[i]))
+			add_failure(round);
+		lima_online_shader_release(pending[i]);
+	}
+	
+	return NULL;
+}
+
+/* returns the number of failures */
+
+static unsigned run_round(lima_compiler_t* compiler, const input_t* inputs,
+						  unsigned num_inputs, unsigned num_threads,
+						  unsigned num_requests, uint32_t seed,
+						  double* time)
+{
+	round_t round;
+	round.compiler = compiler;
+	round.inputs = inputs;
+	round.num_inputs = num_inputs;
+	round.num_requests = num_requests;
+	pthread_mutex_init(&round.lock, NULL);
+	round.callbacks = 0;
+	round.failures = 0;
+	
+	round.queue = lima_online_queue_create(compiler, num_threads);
+	worker_t* workers = calloc(num_threads, sizeof(worker_t));
+	if (!round.queue || !workers)
+	{
+		fprintf(stderr, "Error: could not start the threads\n");
+		if (round.queue)
+			lima_online_queue_delete(round.queue);
+		free(workers);
+		return 1;
+	}
+	
+	double start = get_time();
+	
+	unsigned i, num_started;
+	for (num_started = 0; num_started < num_threads; num_started++)
+	{
+		worker_t* worker = &workers[num_started];
+		worker->round = &round;
+		worker->seed = seed + 0x9e3779b9 * (num_started + 1);
+		worker->num_async = 0;
+		if (pthread_create(&worker->thread, NULL, worker_thread, worker) != 0)
+		{
+			fprintf(stderr, "Error: could not start the threads\n");
+			round.failures++;
+			break;
+		}
+	}
+	
+	for (i = 0; i < num_started; i++)
+		pthread_join(workers[i].thread, NULL);
+	
+	lima_online_queue_delete(round.queue);
+	
+	*time = get_time() - start;
+	
+	/* every thread that could have run a callback has been joined */
+	unsigned num_async = 0;
+	for (i = 0; i < num_started; i++)
+		num_async += workers[i].num_async;
+	if (round.callbacks != num_async)
+	{
+		fprintf(stderr, "Error: %u callbacks for %u async requests\n",
+				round.callbacks, num_async);
+		round.failures++;
+	}
+	
+	free(workers);
+	pthread_mutex_destroy(&round.lock);
+	return round.failures;
+}
+
+int main(int argc, char** argv)
+{
+	unsigned num_threads = 8, num_requests = 200;
+	
+	static struct option long_options[] = {
+		{"threads",  required_argument, NULL, 'j'},
+		{"requests", required_argument, NULL, 'n'},
+		{"help",     no_argument,       NULL, 'h'},
+		{NULL,       0,                 NULL, 0}
+	};
+	
+	int c;
+	while ((c = getopt_long(argc, argv, "j:n:h", long_options, NULL)) != -1)
+	{
+		switch (c)
+		{
+			case 'j':
+				num_threads = strtoul(optarg, NULL, 10);
+				if (num_threads == 0)
+				{
+					fprintf(stderr, "Error: invalid thread count %s\n",
+							optarg);
+					return 1;
+				}
+				break;
+			
+			case 'n':
+				num_requests = strtoul(optarg, NULL, 10);
+				if (num_requests == 0)
+				{
+					fprintf(stderr, "Error: invalid request count %s\n",
+							optarg);
+					return 1;
+				}
+				break;
+			
+			case 'h':
+				usage();
+				return 0;
+			
+			default:
+				usage();
+				return 1;
+		}
+	}
+	
+	if (optind == argc)
+	{
+		fprintf(stderr, "Error: no inputs\n");
+		usage();
+		return 1;
+	}
+	
+	unsigned num_inputs = argc - optind, i;
+	input_t* inputs = calloc(num_inputs, sizeof(input_t));
+	if (!inputs)
+		return 1;
+	
+	lima_compiler_t* compiler = lima_compiler_create();
+	if (!compiler)
+	{
+		fprintf(stderr, "Error: could not create the compiler\n");
+		free(inputs);
+		return 1;
+	}
+	
+	int ret = 0;
+	
+	for (i = 0; i < num_inputs; i++)
+	{
+		input_t* input = &inputs[i];
+		input->path = argv[optind + i];
+		input->stage = guess_stage(input->path);
+		if (input->stage == lima_shader_stage_unknown)
+		{
+			fprintf(stderr, "Error: cannot guess the type of %s\n",
+					input->path);
+			ret = 1;
+			goto cleanup;
+		}
+		
+		input->source = read_file(input->path);
+		if (!input->source)
+		{
+			fprintf(stderr, "Error: could not read input file %s\n",
+					input->path);
+			ret = 1;
+			goto cleanup;
+		}
+		
+		if (!compile_reference(compiler, input))
+		{
+			fprintf(stderr, "Error: out of memory\n");
+			ret = 1;
+			goto cleanup;
+		}
+	}
+	
+	/* the default, small enough to always be evicting, and off */
+	static const struct {
+		const char* name;
+		unsigned long size;
+	} cache_sizes[] = {
+		{"default", 16 << 20},
+		{"tiny",    4096},
+		{"off",     0},
+	};
+	
+	printf("%u threads, %u requests each\n", num_threads, num_requests);
+	for (i = 0; i < sizeof(cache_sizes) / sizeof(cache_sizes[0]); i++)
+	{
+		lima_online_set_cache_size(cache_sizes[i].size);
+		
+		double time;
+		unsigned failures = run_round(compiler, inputs, num_inputs,
+									  num_threads, num_requests, i + 1, &time);
+		printf("  cache %-8s %9.3f ms %9.1f requests/s %s\n",
+			   cache_sizes[i].name, time * 1000.,
+			   num_threads * num_requests / time, failures ? "FAIL" : "ok");
+		if (failures)
+			ret = 1;
+	}
+	
+	/* drop everything that's left, so it isn't reported as a leak */
+	lima_online_set_cache_size(0);
+	
+cleanup:
+	for (i = 0; i < num_inputs; i++)
+	{
+		free(inputs[i].source);
+		free(inputs[i].code);
+	}
+	free(inputs);
+	lima_compiler_delete(compiler);
+	return ret;
+}
@@ -0,0 +1,404 @@
+/* Author(s):
+ *   Connor Abbott
+ *
+ * Copyright (c) 2014 Connor Abbott (connor@abbott.cx)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Micro-benchmark for the fragment shader instruction encoder and decoder.
+ * The inputs are compiled once, and their code is repeated into one long
+ * instruction stream, so the mix of fields is what the compiler really
+ * produces. The stream is then decoded and re-encoded a few times, keeping
+ * the fastest run of each, and the re-encoded stream has to match the
+ * original word for word.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <stdbool.h>
+#include <time.h>
+#include "shader.h"
+#include "pp/lima_pp.h"
+
+#define USAGE \
+"usage: limabench-pp [options] inputs...\n" \
+"\n" \
+"options:\n" \
+"\t--instructions (-n) [number] -- the length of the instruction stream.\n" \
+"\t\tDefault: 1000000\n" \
+"\t--iterations (-i) [number] -- run each benchmark this many times,\n" \
+"\t\tand report the fastest. Default: 5\n" \
+"\t--help (-h) -- print this message and quit.\n" \
+"\n" \
+"The inputs are fragment shader sources.\n"
+
+static void usage(void)
+{
+	fprintf(stderr, USAGE);
+}
+
+static char* read_file(const char* path)
+{
+	FILE* fp = fopen(path, "rb");
+	if (!fp) return NULL;
+	
+	if (fseek(fp, 0, SEEK_END) != 0)
+	{
+		fclose(fp);
+		return NULL;
+	}
+	long fsize = ftell(fp);
+	if ((fsize <= 0)
+		|| (fseek(fp, 0, SEEK_SET) != 0))
+	{
+		fclose(fp);
+		return NULL;
+	}
+	
+	char* data = (char*)malloc(fsize + 1);
+	if (!data)
+	{
+		fclose(fp);
+		return NULL;
+	}
+	
+	if (fread(data, fsize, 1, fp) != 1)
+	{
+		fclose(fp);
+		free(data);
+		return NULL;
+	}
+	data[fsize] = '\0';
+	
+	fclose(fp);
+	return data;
+}
+
+static double get_time(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+typedef struct
+{
+	uint32_t* words;
+	unsigned num_words, capacity;
+	unsigned num_instrs;
+} stream_t;
+
+static bool stream_append(stream_t* stream, const uint32_t* words,
+						  unsigned num_words)
+{
+	if (stream->num_words + num_words > stream->capacity)
+	{
+		unsigned new_capacity = stream->capacity ? stream->capacity : 1024;
+		while (new_capacity < stream->num_words + num_words)
+			new_capacity *= 2;
+		uint32_t* new_words = realloc(stream->words,
+									  new_capacity * sizeof(uint32_t));
+		if (!new_words)
+			return false;
+		stream->words = new_words;
+		stream->capacity = new_capacity;
+	}
+	
+	memcpy(stream->words + stream->num_words, words,
+		   num_words * sizeof(uint32_t));
+	stream->num_words += num_words;
+	return true;
+}
+
+/* the number of instructions in code, or 0 if it's corrupt */
+
+static unsigned count_instrs(const uint32_t* code, unsigned num_words)
+{
+	unsigned i, count = 0;
+	for (i = 0; i < num_words; count++)
+	{
+		lima_pp_ctrl_t ctrl;
+		ctrl.mask = code[i];
+		if (ctrl.count == 0 || ctrl.count > num_words - i)
+			return 0;
+		i += ctrl.count;
+	}
+	
+	return count;
+}
+
+static bool compile(lima_compiler_t* compiler, const char* path,
+					stream_t* stream)
+{
+	char* source = read_file(path);
+	if (!source)
+	{
+		fprintf(stderr, "Error: could not read input file %s\n", path);
+		return false;
+	}
+	
+	lima_shader_t* shader = lima_shader_create(compiler,
+											   lima_shader_stage_fragment,
+											   lima_core_mali_400);
+	if (!shader)
+	{
+		free(source);
+		return false;
+	}
+	
+	bool success = false;
+	
+	lima_shader_parse(shader, source);
+	if (!lima_shader_error(shader))
+	{
+		lima_shader_optimize(shader);
+		lima_shader_compile(shader, false);
+	}
+	
+	if (lima_shader_error(shader))
+	{
+		fprintf(stderr, "%s: %s", path, lima_shader_info_log(shader));
+		goto cleanup;
+	}
+	
+	const uint32_t* code = lima_shader_get_code(shader);
+	unsigned num_words = lima_shader_get_code_size(shader) / 4;
+	unsigned num_instrs = count_instrs(code, num_words);
+	if (!num_instrs)
+	{
+		fprintf(stderr, "%s: corrupt code\n", path);
+		goto cleanup;
+	}
+	
+	success = stream_append(stream, code, num_words);
+	stream->num_instrs += num_instrs;
+
+cleanup:
+	lima_shader_delete(shader);
+	free(source);
+	return success;
+}
+
+/* Decodes a window of instructions at a time, so the decoded copies stay in
+ * the cache and the time is spent in the decoder rather than on stores. */
+#define WINDOW 256
+
+static double bench_decode(const stream_t* stream,
+						   lima_pp_instruction_t* window)
+{
+	double start = get_time();
+	
+	unsigned i, n = 0;
+	for (i = 0; i < stream->num_words; i += window[n].control.count)
+	{
+		n = (n + 1) % WINDOW;
+		lima_pp_instruction_decode(stream->words + i, &window[n]);
+	}
+	
+	return get_time() - start;
+}
+
+static double bench_encode(const lima_pp_instruction_t* instrs,
+						   unsigned num_instrs, unsigned num_unique,
+						   uint32_t* output)
+{
+	double start = get_time();
+	
+	unsigned i, offset = 0;
+	for (i = 0; i < num_instrs; i++)
+	{
+		/* encode writes the size back into the control word */
+		lima_pp_instruction_t inst = instrs[i % num_unique];
+		lima_pp_instruction_encode(&inst, output + offset);
+		offset += inst.control.count;
+	}
+	
+	return get_time() - start;
+}
+
+static double bench_calc_size(const lima_pp_instruction_t* instrs,
+							  unsigned num_instrs, unsigned num_unique,
+							  unsigned* total)
+{
+	double start = get_time();
+	
+	unsigned i, sum = 0;
+	for (i = 0; i < num_instrs; i++)
+	{
+		lima_pp_ctrl_t ctrl = instrs[i % num_unique].control;
+		lima_pp_instruction_calc_size(&ctrl);
+		sum += ctrl.count;
+	}
+	
+	*total = sum;
+	return get_time() - start;
+}
+
+static void print_result(const char* name, double time, unsigned num_instrs)
+{
+	printf("  %-10s %9.3f ms %8.2f ns/instr %8.2f Minstr/s\n", name,
+		   time * 1000., time * 1e9 / num_instrs, num_instrs / time / 1e6);
+}
+
+int main(int argc, char** argv)
+{
+	unsigned target_instrs = 1000000;
+	unsigned iterations = 5;
+	
+	static struct option long_options[] = {
+		{"instructions", required_argument, NULL, 'n'},
+		{"iterations",   required_argument, NULL, 'i'},
+		{"help",         no_argument,       NULL, 'h'},
+		{NULL,           0,                 NULL, 0}
+	};
+	
+	int c;
+	while ((c = getopt_long(argc, argv, "n:i:h", long_options, NULL)) != -1)
+	{
+		switch (c)
+		{
+			case 'n':
+				target_instrs = strtoul(optarg, NULL, 10);
+				if (target_instrs == 0)
+				{
+					fprintf(stderr, "Error: invalid instruction count %s\n",
+							optarg);
+					return 1;
+				}
+				break;
+			
+			case 'i':
+				iterations = strtoul(optarg, NULL, 10);
+				if (iterations == 0)
+				{
+					fprintf(stderr, "Error: invalid iteration count %s\n",
+							optarg);
+					return 1;
+				}
+				break;
+			
+			case 'h':
+				usage();
+				return 0;
+			
+			default:
+				usage();
+				return 1;
+		}
+	}
+	
+	if (optind == argc)
+	{
+		fprintf(stderr, "Error: no inputs\n");
+		usage();
+		return 1;
+	}
+	
+	lima_compiler_t* compiler = lima_compiler_create();
+	if (!compiler)
+	{
+		fprintf(stderr, "Error: could not create the compiler\n");
+		return 1;
+	}
+	
+	stream_t unique;
+	memset(&unique, 0, sizeof(unique));
+	
+	int i;
+	for (i = optind; i < argc; i++)
+		compile(compiler, argv[i], &unique);
+	
+	lima_compiler_delete(compiler);
+	
+	if (!unique.num_instrs)
+	{
+		fprintf(stderr, "Error: none of the inputs compiled\n");
+		return 1;
+	}
+	
+	/* repeat the code of all the inputs until the stream is long enough */
+	stream_t stream;
+	memset(&stream, 0, sizeof(stream));
+	while (stream.num_instrs < target_instrs)
+	{
+		if (!stream_append(&stream, unique.words, unique.num_words))
+			return 1;
+		stream.num_instrs += unique.num_instrs;
+	}
+	
+	lima_pp_instruction_t* decoded =
+		malloc(unique.num_instrs * sizeof(lima_pp_instruction_t));
+	lima_pp_instruction_t* window =
+		calloc(WINDOW, sizeof(lima_pp_instruction_t));
+	uint32_t* encoded = malloc(stream.num_words * sizeof(uint32_t));
+	if (!decoded || !window || !encoded)
+		return 1;
+	
+	unsigned j, offset = 0;
+	for (j = 0; j < unique.num_instrs; j++)
+	{
+		lima_pp_instruction_decode(unique.words + offset, &decoded[j]);
+		offset += decoded[j].control.count;
+	}
+	
+	printf("%u instructions, %u words, from %u unique instructions\n",
+		   stream.num_instrs, stream.num_words, unique.num_instrs);
+	
+	double decode_time = 0., encode_time = 0., calc_size_time = 0.;
+	unsigned total_size = 0;
+	for (j = 0; j < iterations; j++)
+	{
+		double time = bench_decode(&stream, window);
+		if (j == 0 || time < decode_time)
+			decode_time = time;
+		
+		time = bench_encode(decoded, stream.num_instrs, unique.num_instrs,
+							encoded);
+		if (j == 0 || time < encode_time)
+			encode_time = time;
+		
+		time = bench_calc_size(decoded, stream.num_instrs, unique.num_instrs,
+							   &total_size);
+		if (j == 0 || time < calc_size_time)
+			calc_size_time = time;
+	}
+	
+	print_result("decode", decode_time, stream.num_instrs);
+	print_result("encode", encode_time, stream.num_instrs);
+	print_result("calc_size", calc_size_time, stream.num_instrs);
+	
+	int ret = 0;
+	if (total_size != stream.num_words ||
+		memcmp(encoded, stream.words, stream.num_words * sizeof(uint32_t)) != 0)
+	{
+		fprintf(stderr, "Error: re-encoded stream doesn't match the input\n");
+		ret = 1;
+	}
+	
+	free(decoded);
+	free(window);
+	free(encoded);
+	free(stream.words);
+	free(unique.words);
+	return ret;
+}
@@ -105,19 +105,19 @@ void bitcopy(
 	if (dst_offset == 0) {
 		for(; size >= 32; size -=32)
 			*dst++ = _bitread32(src++, src_offset, 32);
-		_bitwrite32(dst, 0, size,
-			_bitread32(src, src_offset, size));
 	} else if (src_offset == 0) {
 		for(; size >= 32; size -=32)
 			_bitwrite32(dst++, dst_offset, 32, *src++);
-		_bitwrite32(dst, dst_offset, size, *src);
 	} else {
 		for(; size >= 32; size -=32)
 			_bitwrite32(
 				dst++, dst_offset, 32,
 				_bitread32(src++, src_offset, 32));
+	}
+
+	/* Don't touch the word after the end when there's nothing left. */
+	if (size != 0)
 		_bitwrite32(
 			dst, dst_offset, size,
 			_bitread32(src, src_offset, size));
-	}
 }
@@ -9,6 +9,7 @@
 #include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
+#include "arena.h"
 
 #ifndef MAX2
 #define MAX2(a, b) ((a) > (b) ? (a) : (b))
@@ -21,22 +22,57 @@
 typedef struct {
 	uint32_t* bits;
 	unsigned size;
+	arena_t* arena; //where bits comes from, or NULL for the heap
 } bitset_t;
 
-//Creates an empty set
-static inline bitset_t bitset_create(unsigned size)
+static inline uint32_t* bitset_bits_alloc(arena_t* arena, unsigned size)
+{
+	if (arena)
+		return (uint32_t*) arena_calloc(arena, size * sizeof(uint32_t));
+	return (uint32_t*) calloc(size, sizeof(uint32_t));
+}
+
+static inline void bitset_bits_free(arena_t* arena, uint32_t* bits,
+									unsigned size)
+{
+	if (arena)
+		arena_free(arena, bits, size * sizeof(uint32_t));
+	else
+		free(bits);
+}
+
+//Changes the number of words in a set, keeping the bits that are still in it
+static inline void bitset_resize(bitset_t* set, unsigned size)
+{
+	uint32_t* bits = bitset_bits_alloc(set->arena, size);
+	if (set->bits)
+	{
+		memcpy(bits, set->bits, MIN2(set->size, size) * sizeof(uint32_t));
+		bitset_bits_free(set->arena, set->bits, set->size);
+	}
+	set->bits = bits;
+	set->size = size;
+}
+
+//Creates an empty set, allocated from arena
+static inline bitset_t bitset_create_arena(unsigned size, arena_t* arena)
 {
 	bitset_t ret;
 	ret.size = (size + 31) / 32;
-	ret.bits = (uint32_t*) calloc(ret.size, sizeof(uint32_t));
+	ret.arena = arena;
+	ret.bits = bitset_bits_alloc(arena, ret.size);
 	return ret;
 }
 
+//Creates an empty set
+static inline bitset_t bitset_create(unsigned size)
+{
+	return bitset_create_arena(size, NULL);
+}
+
 static inline bitset_t bitset_create_full(unsigned size)
 {
-	bitset_t ret;
-	ret.size = (size + 31) / 32;
-	ret.bits = (uint32_t*) calloc(ret.size, sizeof(uint32_t));
+	bitset_t ret = bitset_create(size);
 	memset(ret.bits, 0xFF, (size / 32) * sizeof(uint32_t));
 	if (size % 32 != 0)
 		ret.bits[ret.size - 1] = (1 << (size % 32)) - 1;
@@ -46,10 +82,7 @@ static inline bitset_t bitset_create_full(unsigned size)
 static inline void bitset_copy(bitset_t* dest, bitset_t src)
 {
 	if (dest->size != src.size)
-	{
-		dest->bits = (uint32_t*) realloc(dest->bits, src.size);
-		dest->size = src.size;
-	}
+		bitset_resize(dest, src.size);
 	memcpy(dest->bits, src.bits, src.size * sizeof(uint32_t));
 }
 
@@ -64,7 +97,7 @@ static inline bitset_t bitset_new(bitset_t old)
 static inline void bitset_delete(bitset_t set)
 {
 	if (set.bits)
-		free(set.bits);
+		bitset_bits_free(set.arena, set.bits, set.size);
 }
 
 static inline bool bitset_get(bitset_t set, unsigned elem)
@@ -105,11 +138,7 @@ static inline void bitset_union(bitset_t* dest, bitset_t src)
 {
 	unsigned i;
 	if (src.size > dest->size)
-	{
-		dest->bits = (uint32_t*) realloc(dest->bits, src.size);
-		memset(&dest->bits[dest->size], 0, sizeof(uint32_t) * (src.size - dest->size));
-		dest->size = src.size;
-	}
+		bitset_resize(dest, src.size);
 	for (i = 0; i < dest->size; i++)
 		dest->bits[i] |= src.bits[i];
 }
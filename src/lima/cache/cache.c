@@ -0,0 +1,559 @@
+/* Author(s):
+ *   Connor Abbott
+ *
+ * Copyright (c) 2014 Connor Abbott (connor@abbott.cx)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#define _GNU_SOURCE /* for asprintf on linux */
+#include "cache/cache.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* The index is an open-addressed hash table of entry hashes, living in a
+ * shared mapping of the index file right after a small header. Hashes 0 and 1
+ * are reserved to mark empty and deleted slots.
+ */
+
+#define INDEX_MAGIC "LSCI"
+#define INDEX_VERSION 1
+#define NUM_SLOTS (1 << 20)
+#define MAX_ENTRIES (NUM_SLOTS / 2)
+
+#define EMPTY_KEY 0
+#define DELETED_KEY 1
+
+#define ENTRY_MAGIC "LSCE"
+
+typedef struct {
+	char magic[4];
+	uint32_t version;
+	uint32_t num_slots;
+	uint32_t num_entries, num_deleted;
+	uint32_t clock; /* bumped on every use, for LRU eviction */
+	uint64_t total_size; /* size of all the entry files in bytes */
+} index_header_t;
+
+typedef struct {
+	uint64_t key;
+	uint32_t size;
+	uint32_t last_use;
+} index_slot_t;
+
+typedef struct {
+	char magic[4];
+	uint32_t key_size;
+	uint32_t data_size;
+	uint32_t reserved;
+	uint64_t hash;
+} entry_header_t;
+
+struct lima_cache_s {
+	char* path;
+	unsigned long max_size;
+	int index_fd;
+	pthread_mutex_t lock; /* flock() doesn't exclude threads sharing index_fd */
+	index_header_t* header;
+	index_slot_t* slots;
+};
+
+static const size_t index_size =
+	sizeof(index_header_t) + NUM_SLOTS * sizeof(index_slot_t);
+
+/* 64-bit FNV-1a */
+static uint64_t hash_key(const void* key, unsigned size)
+{
+	const unsigned char* bytes = key;
+	uint64_t hash = 0xcbf29ce484222325ull;
+	
+	for (unsigned i = 0; i < size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= 0x100000001b3ull;
+	}
+	
+	if (hash <= DELETED_KEY)
+		hash += 2;
+	
+	return hash;
+}
+
+static bool write_all(int fd, const void* data, size_t size)
+{
+	const char* pos = data;
+	while (size)
+	{
+		ssize_t ret = write(fd, pos, size);
+		if (ret < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			return false;
+		}
+		
+		pos += ret;
+		size -= ret;
+	}
+	
+	return true;
+}
+
+static bool read_all(int fd, void* data, size_t size)
+{
+	char* pos = data;
+	while (size)
+	{
+		ssize_t ret = read(fd, pos, size);
+		if (ret < 0 && errno == EINTR)
+			continue;
+		if (ret <= 0)
+			return false;
+		
+		pos += ret;
+		size -= ret;
+	}
+	
+	return true;
+}
+
+/* entries are spread over 256 subdirectories named after the top byte of the
+ * hash, to keep the directories small.
+ */
+
+static char* entry_dir(lima_cache_t* cache, uint64_t hash)
+{
+	char* path;
+	if (asprintf(&path, "%s/%02x", cache->path, (unsigned) (hash >> 56)) == -1)
+		return NULL;
+	return path;
+}
+
+static char* entry_path(lima_cache_t* cache, uint64_t hash)
+{
+	char* path;
+	if (asprintf(&path, "%s/%02x/%014llx", cache->path,
+				 (unsigned) (hash >> 56),
+				 (unsigned long long) (hash & 0xffffffffffffffull)) == -1)
+		return NULL;
+	return path;
+}
+
+static bool index_valid(int fd)
+{
+	struct stat st;
+	if (fstat(fd, &st) != 0 || (size_t) st.st_size != index_size)
+		return false;
+	
+	index_header_t header;
+	if (pread(fd, &header, sizeof(header), 0) != sizeof(header))
+		return false;
+	
+	return memcmp(header.magic, INDEX_MAGIC, 4) == 0 &&
+		header.version == INDEX_VERSION &&
+		header.num_slots == NUM_SLOTS;
+}
+
+static bool index_init(int fd)
+{
+	index_header_t header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, INDEX_MAGIC, 4);
+	header.version = INDEX_VERSION;
+	header.num_slots = NUM_SLOTS;
+	
+	/* the slots are left as a hole in the file, so that an empty cache
+	 * doesn't take up much space.
+	 */
+	return ftruncate(fd, 0) == 0 &&
+		ftruncate(fd, index_size) == 0 &&
+		pwrite(fd, &header, sizeof(header), 0) == sizeof(header);
+}
+
+lima_cache_t* lima_cache_open(const char* path, unsigned long max_size)
+{
+	lima_cache_t* cache = malloc(sizeof(lima_cache_t));
+	if (!cache)
+		return NULL;
+	
+	cache->max_size = max_size;
+	cache->path = strdup(path);
+	if (!cache->path)
+		goto err_mem;
+	
+	if (mkdir(path, 0777) != 0 && errno != EEXIST)
+		goto err_path;
+	
+	char* index_path;
+	if (asprintf(&index_path, "%s/index", path) == -1)
+		goto err_path;
+	
+	cache->index_fd = open(index_path, O_RDWR | O_CREAT | O_CLOEXEC, 0666);
+	free(index_path);
+	if (cache->index_fd < 0)
+		goto err_path;
+	
+	if (flock(cache->index_fd, LOCK_EX) != 0)
+		goto err_fd;
+	
+	bool valid = index_valid(cache->index_fd) || index_init(cache->index_fd);
+	flock(cache->index_fd, LOCK_UN);
+	if (!valid)
+		goto err_fd;
+	
+	void* map = mmap(NULL, index_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+					 cache->index_fd, 0);
+	if (map == MAP_FAILED)
+		goto err_fd;
+	
+	cache->header = map;
+	cache->slots = (index_slot_t*) (cache->header + 1);
+	pthread_mutex_init(&cache->lock, NULL);
+	
+	return cache;
+	
+err_fd:
+	close(cache->index_fd);
+	
+err_path:
+	free(cache->path);
+	
+err_mem:
+	free(cache);
+	return NULL;
+}
+
+void lima_cache_close(lima_cache_t* cache)
+{
+	munmap(cache->header, index_size);
+	close(cache->index_fd);
+	pthread_mutex_destroy(&cache->lock);
+	free(cache->path);
+	free(cache);
+}
+
+/* Lookups don't take the lock, so they may race with another process
+ * changing the index. That's fine, since the worst that can happen is a
+ * spurious miss or a hit on an entry that was just evicted, in which case
+ * opening the entry file fails.
+ */
+
+static index_slot_t* find_slot(lima_cache_t* cache, uint64_t hash)
+{
+	for (unsigned i = 0; i < NUM_SLOTS; i++)
+	{
+		index_slot_t* slot = &cache->slots[(hash + i) & (NUM_SLOTS - 1)];
+		uint64_t key = *(volatile uint64_t*) &slot->key;
+		if (key == hash)
+			return slot;
+		if (key == EMPTY_KEY)
+			return NULL;
+	}
+	
+	return NULL;
+}
+
+static void touch_slot(lima_cache_t* cache, index_slot_t* slot)
+{
+	slot->last_use = __sync_add_and_fetch(&cache->header->clock, 1);
+}
+
+bool lima_cache_get(lima_cache_t* cache, const void* key, unsigned key_size,
+					void** data, unsigned* size)
+{
+	uint64_t hash = hash_key(key, key_size);
+	index_slot_t* slot = find_slot(cache, hash);
+	if (!slot)
+		return false;
+	
+	char* path = entry_path(cache, hash);
+	if (!path)
+		return false;
+	
+	int fd = open(path, O_RDONLY | O_CLOEXEC);
+	free(path);
+	if (fd < 0)
+		return false;
+	
+	bool hit = false;
+	void* stored_key = NULL;
+	entry_header_t header;
+	if (!read_all(fd, &header, sizeof(header)) ||
+		memcmp(header.magic, ENTRY_MAGIC, 4) != 0 ||
+		header.hash != hash || header.key_size != key_size)
+		goto cleanup;
+	
+	stored_key = malloc(key_size);
+	if (!stored_key || !read_all(fd, stored_key, key_size) ||
+		memcmp(stored_key, key, key_size) != 0)
+		goto cleanup;
+	
+	*data = malloc(header.data_size ? header.data_size : 1);
+	if (!*data)
+		goto cleanup;
+	
+	if (!read_all(fd, *data, header.data_size))
+	{
+		free(*data);
+		goto cleanup;
+	}
+	
+	*size = header.data_size;
+	hit = true;
+	
+	if (slot->key == hash)
+		touch_slot(cache, slot);
+	
+cleanup:
+	free(stored_key);
+	close(fd);
+	return hit;
+}
+
+static int compare_last_use(const void* a, const void* b)
+{
+	const index_slot_t* slot_a = *(index_slot_t* const*) a;
+	const index_slot_t* slot_b = *(index_slot_t* const*) b;
+	
+	if (slot_a->last_use < slot_b->last_use)
+		return -1;
+	if (slot_a->last_use > slot_b->last_use)
+		return 1;
+	return 0;
+}
+
+/* Evicts the least recently used entries until the cache is 10% under its
+ * limits, so that we don't have to sort the index again on every insertion
+ * once the cache is full. Must be called with the lock held.
+ */
+
+static void evict(lima_cache_t* cache, uint64_t keep)
+{
+	index_header_t* header = cache->header;
+	if (header->total_size <= cache->max_size &&
+		header->num_entries <= MAX_ENTRIES)
+		return;
+	
+	index_slot_t** live = malloc(header->num_entries * sizeof(index_slot_t*));
+	if (!live)
+		return;
+	
+	unsigned num_live = 0;
+	for (unsigned i = 0; i < NUM_SLOTS; i++)
+	{
+		if (cache->slots[i].key > DELETED_KEY && num_live < header->num_entries)
+			live[num_live++] = &cache->slots[i];
+	}
+	
+	qsort(live, num_live, sizeof(index_slot_t*), compare_last_use);
+	
+	uint64_t target_size = cache->max_size - cache->max_size / 10;
+	unsigned target_entries = MAX_ENTRIES - MAX_ENTRIES / 10;
+	
+	for (unsigned i = 0; i < num_live; i++)
+	{
+		if (header->total_size <= target_size &&
+			header->num_entries <= target_entries)
+			break;
+		
+		index_slot_t* slot = live[i];
+		if (slot->key == keep)
+			continue;
+		
+		char* path = entry_path(cache, slot->key);
+		if (path)
+		{
+			unlink(path);
+			free(path);
+		}
+		
+		slot->key = DELETED_KEY;
+		header->total_size -= slot->size;
+		header->num_entries--;
+		header->num_deleted++;
+	}
+	
+	free(live);
+}
+
+static void insert_slot(lima_cache_t* cache, uint64_t hash, uint32_t size)
+{
+	index_header_t* header = cache->header;
+	index_slot_t* free_slot = NULL;
+	
+	for (unsigned i = 0; i < NUM_SLOTS; i++)
+	{
+		index_slot_t* slot = &cache->slots[(hash + i) & (NUM_SLOTS - 1)];
+		if (slot->key == hash)
+		{
+			header->total_size -= slot->size;
+			header->total_size += size;
+			slot->size = size;
+			touch_slot(cache, slot);
+			return;
+		}
+		
+		if (slot->key == DELETED_KEY && !free_slot)
+			free_slot = slot;
+		
+		if (slot->key == EMPTY_KEY)
+		{
+			if (!free_slot)
+				free_slot = slot;
+			break;
+		}
+	}
+	
+	if (free_slot->key == DELETED_KEY)
+		header->num_deleted--;
+	header->num_entries++;
+	header->total_size += size;
+	
+	free_slot->size = size;
+	touch_slot(cache, free_slot);
+	__sync_synchronize();
+	free_slot->key = hash;
+}
+
+/* gets rid of deleted slots once they start making probe sequences long */
+
+static void rehash(lima_cache_t* cache)
+{
+	index_header_t* header = cache->header;
+	index_slot_t* live = malloc(header->num_entries * sizeof(index_slot_t));
+	if (!live)
+		return;
+	
+	unsigned num_live = 0;
+	for (unsigned i = 0; i < NUM_SLOTS; i++)
+	{
+		if (cache->slots[i].key > DELETED_KEY && num_live < header->num_entries)
+			live[num_live++] = cache->slots[i];
+	}
+	
+	memset(cache->slots, 0, NUM_SLOTS * sizeof(index_slot_t));
+	
+	for (unsigned i = 0; i < num_live; i++)
+	{
+		uint64_t hash = live[i].key;
+		for (unsigned j = 0; ; j++)
+		{
+			index_slot_t* slot = &cache->slots[(hash + j) & (NUM_SLOTS - 1)];
+			if (slot->key == EMPTY_KEY)
+			{
+				*slot = live[i];
+				break;
+			}
+		}
+	}
+	
+	header->num_entries = num_live;
+	header->num_deleted = 0;
+	free(live);
+}
+
+bool lima_cache_put(lima_cache_t* cache, const void* key, unsigned key_size,
+					const void* data, unsigned size)
+{
+	uint64_t hash = hash_key(key, key_size);
+	uint64_t entry_size = sizeof(entry_header_t) + key_size + size;
+	if (entry_size > cache->max_size)
+		return false;
+	
+	char* dir = entry_dir(cache, hash);
+	if (!dir)
+		return false;
+	
+	if (mkdir(dir, 0777) != 0 && errno != EEXIST)
+	{
+		free(dir);
+		return false;
+	}
+	
+	char* tmp_path;
+	int ret = asprintf(&tmp_path, "%s/tmp.XXXXXX", dir);
+	free(dir);
+	if (ret == -1)
+		return false;
+	
+	char* path = entry_path(cache, hash);
+	if (!path)
+	{
+		free(tmp_path);
+		return false;
+	}
+	
+	bool success = false;
+	
+	/* write the entry under a temporary name and rename it into place, so
+	 * that other processes either see the whole entry or none of it.
+	 */
+	int fd = mkstemp(tmp_path);
+	if (fd < 0)
+		goto cleanup;
+	
+	/* mkstemp() makes the file private, but the cache may be shared */
+	fchmod(fd, 0644);
+	
+	entry_header_t header;
+	memcpy(header.magic, ENTRY_MAGIC, 4);
+	header.key_size = key_size;
+	header.data_size = size;
+	header.reserved = 0;
+	header.hash = hash;
+	
+	bool written = write_all(fd, &header, sizeof(header)) &&
+		write_all(fd, key, key_size) &&
+		write_all(fd, data, size);
+	close(fd);
+	
+	if (!written || rename(tmp_path, path) != 0)
+	{
+		unlink(tmp_path);
+		goto cleanup;
+	}
+	
+	pthread_mutex_lock(&cache->lock);
+	if (flock(cache->index_fd, LOCK_EX) == 0)
+	{
+		insert_slot(cache, hash, entry_size);
+		evict(cache, hash);
+		if (cache->header->num_entries + cache->header->num_deleted >
+			NUM_SLOTS / 4 * 3)
+			rehash(cache);
+		
+		flock(cache->index_fd, LOCK_UN);
+		success = true;
+	}
+	pthread_mutex_unlock(&cache->lock);
+	
+cleanup:
+	free(path);
+	free(tmp_path);
+	return success;
+}
@@ -0,0 +1,67 @@
+/* Author(s):
+ *   Connor Abbott
+ *
+ * Copyright (c) 2014 Connor Abbott (connor@abbott.cx)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef __CACHE_H__
+#define __CACHE_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+
+/* A content-addressed cache of compiled shaders kept in a directory on disk.
+ *
+ * Entries are looked up by an arbitrary key blob, which is hashed to find the
+ * entry and then compared byte-for-byte against the key stored with it, so a
+ * hash collision can only cause a miss. Each entry lives in its own file,
+ * while a memory-mapped index in the same directory records the size and the
+ * last use of every entry, so that lookups don't need to touch the
+ * filesystem on a miss and the least recently used entries can be evicted
+ * once the cache grows past its size limit.
+ *
+ * Several processes may share the same directory: entries are written to a
+ * temporary file and renamed into place, and changes to the index are
+ * serialized with a lock on the index file.
+ */
+
+typedef struct lima_cache_s lima_cache_t;
+
+/* opens the cache in the given directory, creating it if needed */
+lima_cache_t* lima_cache_open(const char* path, unsigned long max_size);
+
+void lima_cache_close(lima_cache_t* cache);
+
+/* on a hit, returns a malloc'd copy of the entry's data */
+bool lima_cache_get(lima_cache_t* cache, const void* key, unsigned key_size,
+					void** data, unsigned* size);
+
+bool lima_cache_put(lima_cache_t* cache, const void* key, unsigned key_size,
+					const void* data, unsigned size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CACHE_H__ */
@@ -0,0 +1,95 @@
+/* Author(s):
+ *   Connor Abbott (connor@abbott.cx)
+ *
+ * Copyright (c) 2014 Connor Abbott (connor@abbott.cx)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "cycle_estimate.h"
+#include <stdlib.h>
+
+/*
+ * Every edge goes forward once the loops are cut, so the blocks are already
+ * in topological order, and one pass over them finds both paths.
+ * min[i] and max[i] are the fewest and most cycles it takes to get to
+ * block i, with UINT_MAX in min[i] if it can't be reached.
+ */
+
+bool cycle_estimate(const cycle_block_t* blocks, unsigned num_blocks,
+					lima_shader_report_t* report)
+{
+	report->min_cycles = report->max_cycles = 0;
+	report->has_loops = false;
+	
+	if (!num_blocks)
+		return true;
+	
+	unsigned* min = malloc(2 * num_blocks * sizeof(unsigned));
+	if (!min)
+		return false;
+	unsigned* max = min + num_blocks;
+	
+	unsigned i, j;
+	for (i = 0; i < num_blocks; i++)
+	{
+		min[i] = UINT_MAX;
+		max[i] = 0;
+	}
+	min[0] = 0;
+	
+	bool exited = false;
+	for (i = 0; i < num_blocks; i++)
+	{
+		const cycle_block_t* block = &blocks[i];
+		for (j = 0; j < block->num_edges; j++)
+		{
+			unsigned dest = block->edges[j].dest;
+			if (dest != CYCLE_EXIT && dest <= i)
+			{
+				report->has_loops = true;
+				dest = i + 1;
+			}
+			
+			if (min[i] == UINT_MAX)
+				continue;
+			
+			unsigned edge_min = min[i] + block->edges[j].cycles;
+			unsigned edge_max = max[i] + block->edges[j].cycles;
+			
+			if (dest == CYCLE_EXIT || dest >= num_blocks)
+			{
+				if (!exited || edge_min < report->min_cycles)
+					report->min_cycles = edge_min;
+				if (edge_max > report->max_cycles)
+					report->max_cycles = edge_max;
+				exited = true;
+				continue;
+			}
+			
+			if (edge_min < min[dest])
+				min[dest] = edge_min;
+			if (edge_max > max[dest])
+				max[dest] = edge_max;
+		}
+	}
+	
+	free(min);
+	return true;
+}
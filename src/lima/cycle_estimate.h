@@ -0,0 +1,68 @@
+/* Author(s):
+ *   Connor Abbott (connor@abbott.cx)
+ *
+ * Copyright (c) 2014 Connor Abbott (connor@abbott.cx)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef __cycle_estimate_h__
+#define __cycle_estimate_h__
+
+#include <stdbool.h>
+#include <limits.h>
+#include "shader.h"
+
+/*
+ * cycle_estimate.h
+ *
+ * The shortest and longest paths through the code, for the cycle counts in
+ * lima_shader_report_t. Both backends describe their blocks in code order,
+ * along with the ways out of each one and how many cycles it takes to get
+ * there. An edge going back to the same or an earlier block closes a loop,
+ * and is followed as if it fell through to the next block instead, which is
+ * where the code after the loop starts, so the paths go through each loop
+ * once.
+ */
+
+#define CYCLE_EXIT UINT_MAX
+
+typedef struct {
+	unsigned cycles; /* spent in the block before leaving this way */
+	unsigned dest; /* the block it goes to, CYCLE_EXIT, or past the end */
+} cycle_edge_t;
+
+typedef struct {
+	unsigned num_edges;
+	cycle_edge_t edges[3];
+} cycle_block_t;
+
+static inline void cycle_block_add_edge(cycle_block_t* block,
+										unsigned cycles, unsigned dest)
+{
+	block->edges[block->num_edges].cycles = cycles;
+	block->edges[block->num_edges].dest = dest;
+	block->num_edges++;
+}
+
+/* sets min_cycles, max_cycles, and has_loops in report */
+bool cycle_estimate(const cycle_block_t* blocks, unsigned num_blocks,
+					lima_shader_report_t* report);
+
+#endif
@@ -28,9 +28,8 @@
 
 
 #include "lima_gp.h"
-#include <stdio.h>
 
-#if 0
+
 
 typedef enum
 {
@@ -63,7 +62,7 @@ typedef struct
 	unsigned             off;
 } lima_gp_src_simple_map_e;
 
-static lima_gp_src_simple_map_e lima_gp_src_simple_map[] =
+static const lima_gp_src_simple_map_e lima_gp_src_simple_map[] =
 {
 	{ lima_gp_src_simple_attrib_x  , 0 },
 	{ lima_gp_src_simple_attrib_y  , 0 },
@@ -99,7 +98,7 @@ static lima_gp_src_simple_map_e lima_gp_src_simple_map[] =
 	{ lima_gp_src_simple_attrib_w  , 1 },
 };
 
-static lima_gp_src_simple_map_e lima_gp_src_simple_map_reg[] =
+static const lima_gp_src_simple_map_e lima_gp_src_simple_map_reg[] =
 {
 	{ lima_gp_src_simple_acc_0  , 0 },
 	{ lima_gp_src_simple_acc_1  , 0 },
@@ -111,7 +110,7 @@ static lima_gp_src_simple_map_e lima_gp_src_simple_map_reg[] =
 	{ lima_gp_src_simple_unused , 0 },
 };
 
-static bool lima_gp__mul_op_full[] =
+static const bool lima_gp__mul_op_full[] =
 {
 	0, 1, 1, 0,
 	1, 1, 1, 1,
@@ -121,136 +120,67 @@ static bool lima_gp__mul_op_full[] =
 
 
 
-static void lima_gp__varying_print(ogt_link_map_t* map, unsigned index, unsigned offset)
+static void print_tabs(string_buf_t* buf, unsigned tabs)
 {
-	unsigned o = (index << 2) + offset;
-	unsigned i, c;
-	essl_symbol_t* s
-		= ogt_link_map_reference(
-			map, essl_storage_qualifier_varying, o,
-			&i, &c);
-
-	if (!s)
-		printf("varying[%u].%c",
-			index, "xyzw"[offset]);
-	else
-	{
-		printf("%s", s->name);
-		if (s->count != 0)
-			printf("[%u]", i);
+	unsigned i;
+	for (i = 0; i < tabs; i++)
+		string_buf_printf(buf, "\t");
+}
 
-		const char* cname
-			= essl_symbol_component_name(s, c);
-		if (cname) printf(".%s", cname);
-	}
+static void lima_gp__varying_print(
+	string_buf_t* buf, unsigned index, unsigned offset)
+{
+	string_buf_printf(buf, "varying[%u].%c",
+		index, "xyzw"[offset]);
 }
 
 static void lima_gp__uniform_print(
-	ogt_link_map_t* map,
+	string_buf_t* buf,
 	unsigned index, unsigned component, lima_gp_load_off_t offset_reg)
 {
-	unsigned o = (index << 2) + component;
-	unsigned i, c;
-	essl_symbol_t* s
-		= ogt_link_map_reference(
-			map, essl_storage_qualifier_uniform, o,
-			&i, &c);
-
-	if (!s)
+	string_buf_printf(buf, "temp[");
+	if ((index != 0)
+		|| (offset_reg == lima_gp_load_off_none))
 	{
-		printf("temp[");
-		if ((index != 0)
-			|| (offset_reg == lima_gp_load_off_none))
-		{
-			printf("%u", index);
-			if (offset_reg != lima_gp_load_off_none)
-				printf(" + ");
-		}
-
+		string_buf_printf(buf, "%u", index);
 		if (offset_reg != lima_gp_load_off_none)
-				printf("$%s",
-					lima_gp_load_off_name[offset_reg]);
-		printf("].%c", "xyzw"[component]);
-	} else {
-		if ((s->storage_qualifier
-			== essl_storage_qualifier_const)
-			&& (offset_reg == lima_gp_load_off_none)
-			&& (s->name[0] == '?'))
-		{
-			unsigned v
-				= (essl_type_components(s->type)
-					* i) + c;
-			printf("%g", s->value[v].f);
-		} else {
-			printf("%s", s->name);
-			if ((s->count != 0)
-				|| (offset_reg != lima_gp_load_off_none))
-				printf("[");
-			if ((s->count != 0)
-				&& ((i != 0) || (offset_reg == lima_gp_load_off_none)))
-			{
-				printf("%u", i);
-				if (offset_reg != lima_gp_load_off_none)
-					printf(" + ");
-			}
-			if (offset_reg != lima_gp_load_off_none)
-				printf("$%s",
-					lima_gp_load_off_name[offset_reg]);
-
-			if ((s->count != 0)
-				|| (offset_reg != lima_gp_load_off_none))
-				printf("]");
-
-			const char* cname
-				= essl_symbol_component_name(s, c);
-			if (cname) printf(".%s", cname);
-		}
+			string_buf_printf(buf, " + ");
 	}
+	
+	if (offset_reg != lima_gp_load_off_none)
+			string_buf_printf(buf, "$%s",
+				lima_gp_load_off_name[offset_reg]);
+	string_buf_printf(buf, "].%c", "xyzw"[component]);
 }
 
-static void lima_gp__attribute_print(ogt_link_map_t* map, unsigned index, unsigned offset)
+static void lima_gp__attribute_print(
+	string_buf_t* buf, unsigned index, unsigned offset)
 {
-	unsigned o = (index << 2) + offset;
-	unsigned i, c;
-	essl_symbol_t* s
-		= ogt_link_map_reference(
-			map, essl_storage_qualifier_attribute, o,
-			&i, &c);
-
-	if (!s)
-	{
-		printf("attribute[%u].%c",
-			(o >> 2), "xyzw"[o & 3]);
-	}
-	else
-	{
-		printf("%s", s->name);
-		if (s->count != 0)
-			printf("[%u]", i);
-
-		const char* cname
-			= essl_symbol_component_name(s, c);
-		if (cname) printf(".%s", cname);
-	}
+	string_buf_printf(buf, "attribute[%u].%c",
+		index, "xyzw"[offset]);
 }
 
 
 
 static void lima_gp_src_simple_print(
-	lima_gp_src_simple_e src,
-	lima_gp_instruction_t* code, unsigned offset,
-	ogt_link_map_t* map)
+	string_buf_t* buf, lima_gp_src_simple_e src,
+	const lima_gp_instruction_t* code, unsigned size, unsigned offset)
 {
-	if (!code)
+	/* Sources refer back to earlier instructions, an offset that wraps
+	 * below zero lands past the end. */
+	if (offset >= size)
+	{
+		string_buf_printf(buf, "!undef");
 		return;
-
+	}
+	
 	switch (src)
 	{
 		case lima_gp_src_simple_unused:
-			printf("unused");
+			string_buf_printf(buf, "unused");
 			break;
 		case lima_gp_src_simple_ident:
-			printf("ident");
+			string_buf_printf(buf, "ident");
 			break;
 		case lima_gp_src_simple_attrib_x:
 		case lima_gp_src_simple_attrib_y:
@@ -259,11 +189,10 @@ static void lima_gp_src_simple_print(
 		{
 			if (code[offset].register0_attribute)
 			{
-				lima_gp__attribute_print(map,
-					code[offset].register0_addr,
+				lima_gp__attribute_print(buf, code[offset].register0_addr,
 					(src - lima_gp_src_simple_attrib_x));
 			} else {
-				printf("$%u.%c",
+				string_buf_printf(buf, "$%u.%c",
 					code[offset].register0_addr,
 				"xyzw"[src - lima_gp_src_simple_attrib_x]);
 			}
@@ -273,7 +202,7 @@ static void lima_gp_src_simple_print(
 		case lima_gp_src_simple_register_z:
 		case lima_gp_src_simple_register_w:
 		{
-			printf("$%u.%c",
+			string_buf_printf(buf, "$%u.%c",
 				code[offset].register1_addr,
 				"xyzw"[src - lima_gp_src_simple_register_x]);
 		} break;
@@ -282,8 +211,7 @@ static void lima_gp_src_simple_print(
 		case lima_gp_src_simple_uniform_z:
 		case lima_gp_src_simple_uniform_w:
 		{
-			lima_gp__uniform_print(map,
-				code[offset].load_addr,
+			lima_gp__uniform_print(buf, code[offset].load_addr,
 				(src - lima_gp_src_simple_uniform_x),
 				code[offset].load_offset);
 		} break;
@@ -292,7 +220,7 @@ static void lima_gp_src_simple_print(
 		{
 			lima_gp_src_simple_map_e m[2];
 			bool n[2];
-
+			
 			if (src == lima_gp_src_simple_acc_0)
 			{
 				m[0] = lima_gp_src_simple_map[code[offset].acc0_src0];
@@ -305,19 +233,19 @@ static void lima_gp_src_simple_print(
 				n[0] = code[offset].acc1_src0_neg;
 				n[1] = code[offset].acc1_src1_neg;
 			}
-
+			
 			if (m[0].src == lima_gp_src_simple_ident)
 			{
 				m[0].src = lima_gp_src_simple_complex;
 				m[0].off = 1;
 			}
-
-
+			
+			
 			if (m[1].src == lima_gp_src_simple_ident)
 			{
-				if (n[0]) printf("-");
+				if (n[0]) string_buf_printf(buf, "-");
 				lima_gp_src_simple_print(
-					m[0].src, code, (offset - m[0].off), map);
+					buf, m[0].src, code, size, (offset - m[0].off));
 			}
 			else if (((code[offset].acc_op == lima_gp_acc_op_min)
 					|| (code[offset].acc_op == lima_gp_acc_op_max))
@@ -326,40 +254,40 @@ static void lima_gp_src_simple_print(
 					&& (n[0] != n[1]))
 			{
 				if (code[offset].acc_op == lima_gp_acc_op_min)
-					printf("-");
-
-				printf("acc.abs(");
+					string_buf_printf(buf, "-");
+				
+				string_buf_printf(buf, "acc.abs(");
 				lima_gp_src_simple_print(
-					m[0].src, code, (offset - m[0].off), map);
-				printf(")");
+					buf, m[0].src, code, size, (offset - m[0].off));
+				string_buf_printf(buf, ")");
 			}
 			else
 			{
 				
-
+				
 				const char* sym
 					= lima_gp_acc_op_sym[code[offset].acc_op];
 				if (!sym)
-					printf("acc.%s",
+					string_buf_printf(buf, "acc.%s",
 						lima_gp_acc_op_name[code[offset].acc_op]);
-				printf("(");
-
-				if (n[0]) printf("-");
+				string_buf_printf(buf, "(");
+				
+				if (n[0]) string_buf_printf(buf, "-");
 				lima_gp_src_simple_print(
-					m[0].src, code, (offset - m[0].off), map);
-
+					buf, m[0].src, code, size, (offset - m[0].off));
+				
 				if (m[1].src != lima_gp_src_simple_unused)
 				{
 					if (sym)
-						printf(" %s ", sym);
+						string_buf_printf(buf, " %s ", sym);
 					else
-						printf(", ");
+						string_buf_printf(buf, ", ");
 	
-					if (n[1]) printf("-");
+					if (n[1]) string_buf_printf(buf, "-");
 					lima_gp_src_simple_print(
-						m[1].src, code, (offset - m[1].off), map);
+						buf, m[1].src, code, size, (offset - m[1].off));
 				}
-				printf(")");
+				string_buf_printf(buf, ")");
 			}
 		} break;
 		case lima_gp_src_simple_mul_0:
@@ -379,13 +307,13 @@ static void lima_gp_src_simple_print(
 				mx[0].src = lima_gp_src_simple_complex;
 				mx[0].off = 1;
 			}
-
+			
 			if (mx[2].src == lima_gp_src_simple_ident)
 			{
 				mx[2].src = lima_gp_src_simple_complex;
 				mx[2].off = 1;
 			}
-
+			
 			lima_gp_src_simple_map_e m[2];
 			bool mn;
 			if (src == lima_gp_src_simple_mul_0)
@@ -398,7 +326,7 @@ static void lima_gp_src_simple_print(
 				m[1] = mx[3];
 				mn   = mxn[1];
 			}
-
+			
 			lima_gp_mul_op_e op
 				= code[offset].mul_op;
 			switch (code[offset].mul_op)
@@ -410,105 +338,105 @@ static void lima_gp_src_simple_print(
 				default:
 					break;
 			}
-
+			
 			switch (op)
 			{
 				case lima_gp_mul_op_mul:
 				{
 					if (m[0].src == lima_gp_src_simple_ident)
 					{
-						if (mn) printf("-");
+						if (mn) string_buf_printf(buf, "-");
 						if(m[1].src == lima_gp_src_simple_ident)
-							printf("1.0");
+							string_buf_printf(buf, "1.0");
 						else
 							lima_gp_src_simple_print(
-								m[1].src, code, (offset - m[1].off), map);
+								buf, m[1].src, code, size, (offset - m[1].off));
 					}
 					else if(m[1].src == lima_gp_src_simple_ident)
 					{
-						if (mn) printf("-");
+						if (mn) string_buf_printf(buf, "-");
 						lima_gp_src_simple_print(
-							m[0].src, code, (offset - m[0].off), map);
+							buf, m[0].src, code, size, (offset - m[0].off));
 					}
 					else
 					{
-						if (mn) printf("-");
-						printf("(");
+						if (mn) string_buf_printf(buf, "-");
+						string_buf_printf(buf, "(");
 						lima_gp_src_simple_print(
-							m[0].src, code, (offset - m[0].off), map);
-						printf(" * ");
+							buf, m[0].src, code, size, (offset - m[0].off));
+						string_buf_printf(buf, " * ");
 						lima_gp_src_simple_print(
-							m[1].src, code, (offset - m[1].off), map);
-						printf(")");
+							buf, m[1].src, code, size, (offset - m[1].off));
+						string_buf_printf(buf, ")");
 					}
 				} break;
 				case lima_gp_mul_op_select:
 				{
-					printf("(");
-
+					string_buf_printf(buf, "(");
+					
 					lima_gp_src_simple_print(
-						mx[1].src, code, (offset - mx[1].off), map);
-					printf(" ? ");
-
+						buf, mx[1].src, code, size, (offset - mx[1].off));
+					string_buf_printf(buf, " ? ");
+					
 					if (mxn[0])
-						printf("-");
+						string_buf_printf(buf, "-");
 					lima_gp_src_simple_print(
-						mx[0].src, code, (offset - mx[0].off), map);
-					printf(" : ");
-
+						buf, mx[0].src, code, size, (offset - mx[0].off));
+					string_buf_printf(buf, " : ");
+					
 					if (mxn[1])
-						printf("-");
+						string_buf_printf(buf, "-");
 					lima_gp_src_simple_print(
-						mx[2].src, code, (offset - mx[2].off), map);
-
-					printf(")");
+						buf, mx[2].src, code, size, (offset - mx[2].off));
+					
+					string_buf_printf(buf, ")");
 				} break;
 				default:
 				{
 					bool full
 						= lima_gp__mul_op_full[op];
-
+					
 					if (!full && mn)
-						printf("-");
-
-					printf("mul");
+						string_buf_printf(buf, "-");
+					
+					string_buf_printf(buf, "mul");
 					if (!full)
-						printf("[%u]",
+						string_buf_printf(buf, "[%u]",
 							(src == lima_gp_src_simple_mul_0 ? 0 : 1));
-					printf(".%s(",
+					string_buf_printf(buf, ".%s(",
 						lima_gp_mul_op_name[op]);
-
+					
 					if (full)
 					{
 						if (mxn[0])
-							printf("-");
+							string_buf_printf(buf, "-");
 						lima_gp_src_simple_print(
-							mx[0].src, code, (offset - mx[0].off), map);
-
-						printf(", ");
-
+							buf, mx[0].src, code, size, (offset - mx[0].off));
+						
+						string_buf_printf(buf, ", ");
+						
 						lima_gp_src_simple_print(
-							mx[1].src, code, (offset - mx[1].off), map);
+							buf, mx[1].src, code, size, (offset - mx[1].off));
 	
-						printf(", ");
-
+						string_buf_printf(buf, ", ");
+						
 						if (mxn[1])
-							printf("-");
+							string_buf_printf(buf, "-");
 						lima_gp_src_simple_print(
-							mx[2].src, code, (offset - mx[2].off), map);
-
-						printf(", ");
-
+							buf, mx[2].src, code, size, (offset - mx[2].off));
+						
+						string_buf_printf(buf, ", ");
+						
 						lima_gp_src_simple_print(
-							mx[3].src, code, (offset - mx[3].off), map);
+							buf, mx[3].src, code, size, (offset - mx[3].off));
 					} else {
 						lima_gp_src_simple_print(
-							m[0].src, code, (offset - m[0].off), map);
-						printf(", ");
+							buf, m[0].src, code, size, (offset - m[0].off));
+						string_buf_printf(buf, ", ");
 						lima_gp_src_simple_print(
-							m[1].src, code, (offset - m[1].off), map);
+							buf, m[1].src, code, size, (offset - m[1].off));
 					}
-					printf(")");
+					string_buf_printf(buf, ")");
 				} break;
 			}
 		} break;
@@ -524,26 +452,26 @@ static void lima_gp_src_simple_print(
 			switch (code[offset].pass_op)
 			{
 				case lima_gp_pass_op_pass:
-					lima_gp_src_simple_print(m.src, code, (offset - m.off), map);
+					lima_gp_src_simple_print(buf, m.src, code, size, (offset - m.off));
 					break;
 				case lima_gp_pass_op_clamp:
-					printf("clamp(");
-					lima_gp_src_simple_print(m.src, code, (offset - m.off), map);
-					printf(", ");
+					string_buf_printf(buf, "clamp(");
+					lima_gp_src_simple_print(buf, m.src, code, size, (offset - m.off));
+					string_buf_printf(buf, ", ");
 					lima_gp_src_simple_print(
-						lima_gp_src_simple_uniform_x,
-						code, offset, map);
-					printf(", ");
+						buf, lima_gp_src_simple_uniform_x,
+						code, size, offset);
+					string_buf_printf(buf, ", ");
 					lima_gp_src_simple_print(
-						lima_gp_src_simple_uniform_y,
-						code, offset, map);
-					printf(")");
+						buf, lima_gp_src_simple_uniform_y,
+						code, size, offset);
+					string_buf_printf(buf, ")");
 					break;
 				default:
-					printf("pass.%s(",
+					string_buf_printf(buf, "pass.%s(",
 						lima_gp_pass_op_name[code[offset].pass_op]);
-					lima_gp_src_simple_print(m.src, code, (offset - m.off), map);
-					printf(")");
+					lima_gp_src_simple_print(buf, m.src, code, size, (offset - m.off));
+					string_buf_printf(buf, ")");
 					break;
 			}
 		} break;
@@ -559,50 +487,48 @@ static void lima_gp_src_simple_print(
 			switch (code[offset].complex_op)
 			{
 				case lima_gp_complex_op_nop:
-					fprintf(stderr, "Warning: Referencing unused complex field.\n");
-					printf("!complex");
+					string_buf_printf(buf, "!complex");
 					break;
 				case lima_gp_complex_op_pass:
-					lima_gp_src_simple_print(m.src, code, (offset - m.off), map);
+					lima_gp_src_simple_print(buf, m.src, code, size, (offset - m.off));
 					break;
 				default:
-					printf("complex.%s(",
+					string_buf_printf(buf, "complex.%s(",
 						lima_gp_complex_op_name[code[offset].complex_op]);
-					lima_gp_src_simple_print(m.src, code, (offset - m.off), map);
-					printf(")");
+					lima_gp_src_simple_print(buf, m.src, code, size, (offset - m.off));
+					string_buf_printf(buf, ")");
 					break;
 			}
 		} break;
 		default:
 		{
-			fprintf(stderr, "Warning: Referencing unknown field.\n");
-			printf("?");
+			string_buf_printf(buf, "?");
 		} break;
 	}
 }
 
 void lima_gp_instruction_print_decompile(
-	lima_gp_instruction_t* code, unsigned offset,
-	ogt_link_map_t* map, unsigned tabs)
+	string_buf_t* buf, const lima_gp_instruction_t* code, unsigned size,
+	unsigned offset, unsigned tabs)
 {
-	if (!code)
+	if (!code || (offset >= size))
 		return;
-
+	
 	if (code[offset].complex_op
 		>= lima_gp_complex_op_temp_load_addr_0)
 	{
-		ogt_asm_print_tabs(tabs);
-		printf("%03X: ", offset);
-
+		print_tabs(buf, tabs);
+		string_buf_printf(buf, "%03X: ", offset);
+		
 		unsigned i = code[offset].complex_op
 			- lima_gp_complex_op_temp_load_addr_0;
-		printf("$ld_addr_%u = ", i);
+		string_buf_printf(buf, "$ld_addr_%u = ", i);
 		lima_gp_src_simple_print(
-			lima_gp_src_simple_map[code[offset].complex_src].src,
-			code, (offset - lima_gp_src_simple_map[code[offset].complex_src].off), map);
-		printf(";\n");
+			buf, lima_gp_src_simple_map[code[offset].complex_src].src,
+			code, size, (offset - lima_gp_src_simple_map[code[offset].complex_src].off));
+		string_buf_printf(buf, ";\n");
 	}
-
+	
 	lima_gp_src_simple_map_e m[] =
 	{
 		lima_gp_src_simple_map_reg[code[offset].store0_src_x],
@@ -610,7 +536,7 @@ void lima_gp_instruction_print_decompile(
 		lima_gp_src_simple_map_reg[code[offset].store1_src_z],
 		lima_gp_src_simple_map_reg[code[offset].store1_src_w],
 	};
-
+	
 	unsigned varying[] =
 	{
 		code[offset].store0_varying,
@@ -618,7 +544,7 @@ void lima_gp_instruction_print_decompile(
 		code[offset].store1_varying,
 		code[offset].store1_varying,
 	};
-
+	
 	bool temporary[] =
 	{
 		code[offset].store0_temporary,
@@ -626,7 +552,7 @@ void lima_gp_instruction_print_decompile(
 		code[offset].store1_temporary,
 		code[offset].store1_temporary,
 	};
-
+	
 	unsigned address[] =
 	{
 		code[offset].store0_addr,
@@ -634,40 +560,39 @@ void lima_gp_instruction_print_decompile(
 		code[offset].store1_addr,
 		code[offset].store1_addr,
 	};
-
+	
 	if ((code[offset].store0_temporary
 		|| code[offset].store1_temporary)
 			&& ((code[offset].unknown_1 & 12) != 12))
 	{
-		fprintf(stderr,
-				"Warning: Unexpected value for unknown_1: %u.\n",
-				code[offset].unknown_1);
+		print_tabs(buf, tabs);
+		string_buf_printf(buf,
+			"/* Warning: Unexpected value for unknown_1: %u. */\n",
+			code[offset].unknown_1);
 	}
-
+	
 	unsigned i;
 	for (i = 0; i < 4; i++)
 	{
 		if (m[i].src == lima_gp_src_simple_unused)
 			continue;
-
-		ogt_asm_print_tabs(tabs);
-		printf("%03X: ", offset);
-
+		
+		print_tabs(buf, tabs);
+		string_buf_printf(buf, "%03X: ", offset);
+		
 		if (temporary[i])
 		{
 			/* TODO - Check if we're writing to a uniform? */
-			/*lima_gp__uniform_print(
-				map, varying[i], i, 7);*/
-
-			printf("temp[");
+			/*lima_gp__uniform_print(buf, varying[i], i, 7);*/
+			
+			string_buf_printf(buf, "temp[");
 			if (varying[i] != 0)
-				printf("%u + ", address[i]);
-
+				string_buf_printf(buf, "%u + ", address[i]);
+			
 			if (code[offset].complex_op
 				!= lima_gp_complex_op_temp_store_addr)
 			{
-				fprintf(stderr, "Warning: Temporary store address not set within instruction.\n");
-				printf("$st_addr");
+				string_buf_printf(buf, "$st_addr");
 			} else {
 				lima_gp_src_simple_map_e m
 					= lima_gp_src_simple_map[code[offset].complex_src];
@@ -676,49 +601,47 @@ void lima_gp_instruction_print_decompile(
 					m.src = lima_gp_src_simple_complex;
 					m.off = 1;
 				}
-
+				
 				lima_gp_src_simple_print(
-					m.src, code, (offset - m.off), map);
+					buf, m.src, code, size, (offset - m.off));
 			}
-			printf("].%c", "xyzw"[i]);
+			string_buf_printf(buf, "].%c", "xyzw"[i]);
 		}
 		else if (varying[i])
 		{
-			lima_gp__varying_print(
-				map, address[i], i);
+			lima_gp__varying_print(buf, address[i], i);
 		} else {
-			printf("$%u.%c",
+			string_buf_printf(buf, "$%u.%c",
 				address[i], "xyzw"[i]);
 		}
-		printf(" = ");
-
-		lima_gp_src_simple_print(m[i].src, code, (offset - m[i].off), map);
-		printf(";\n");
+		string_buf_printf(buf, " = ");
+		
+		lima_gp_src_simple_print(buf, m[i].src, code, size, (offset - m[i].off));
+		string_buf_printf(buf, ";\n");
 	}
-
+	
 	if (code[offset].branch)
 	{
-		ogt_asm_print_tabs(tabs);
-		printf("%03X: ", offset);
-
+		print_tabs(buf, tabs);
+		string_buf_printf(buf, "%03X: ", offset);
+		
 		unsigned branch_target
 			= code[offset].branch_target;
 		if (!code[offset].branch_target_lo)
 			branch_target += 0x100;
-
+		
 		if (code[offset].unknown_1 != 13)
 		{
-			fprintf(stderr,
-				"Warning: Unexpected value for unknown_1: %u.\n",
+			print_tabs(buf, tabs);
+			string_buf_printf(buf,
+				"/* Warning: Unexpected value for unknown_1: %u. */\n",
 				code[offset].unknown_1);
 		}
-
-		printf("if (");
+		
+		string_buf_printf(buf, "if (");
 		lima_gp_src_simple_print(
-				lima_gp_src_simple_pass,
-				code, offset, map);
-		printf(") goto 0x%03X;\n", branch_target);
+				buf, lima_gp_src_simple_pass,
+				code, size, offset);
+		string_buf_printf(buf, ") goto 0x%03X;\n", branch_target);
 	}
 }
-
-#endif
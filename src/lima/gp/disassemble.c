@@ -24,13 +24,12 @@
  */ 
 
 #include "lima_gp.h"
-#include <stdio.h>
 
-static void print_tabs(unsigned tabs)
+static void print_tabs(string_buf_t* buf, unsigned tabs)
 {
 	unsigned i;
 	for (i = 0; i < tabs; i++)
-		printf("\t");
+		string_buf_printf(buf, "\t");
 }
 
 const char* lima_gp_acc_op_name[] =
@@ -101,7 +100,7 @@ static const char* lima_gp__source_name(
 {
 	if (src > lima_gp_src_p1_attrib_w)
 		return NULL;
-
+	
 	switch (src)
 	{
 		case lima_gp_src_ident:
@@ -126,195 +125,191 @@ static const char* lima_gp__source_name(
 		default:
 			break;
 	}
-
+	
 	return lima_gp_src_name[src];
 }
 
 
 
 void lima_gp_instruction_print_explicit(
-	lima_gp_instruction_t* code, unsigned tabs)
+	string_buf_t* buf, lima_gp_instruction_t* code, unsigned tabs)
 {
-	print_tabs(tabs);
-	printf("{\n");
-
-
-	print_tabs(tabs + 1);
-	printf(".mul_op = %u\n", code->mul_op);
-
+	print_tabs(buf, tabs);
+	string_buf_printf(buf, "{\n");
+	
+	
+	print_tabs(buf, tabs + 1);
+	string_buf_printf(buf, ".mul_op = %u\n", code->mul_op);
+	
 	if ((code->mul0_src0 != lima_gp_src_unused)
 		|| (code->mul0_src1 != lima_gp_src_unused))
 	{
-		print_tabs(tabs + 1);
-		printf("mul0 ");
+		print_tabs(buf, tabs + 1);
+		string_buf_printf(buf, "mul0 ");
 		if (code->mul0_neg)
-			printf("-");
-		printf("%u, %u\n", code->mul0_src0, code->mul0_src1);
+			string_buf_printf(buf, "-");
+		string_buf_printf(buf, "%u, %u\n", code->mul0_src0, code->mul0_src1);
 	}
-
+	
 	if ((code->mul1_src0 != lima_gp_src_unused)
 		|| (code->mul1_src1 != lima_gp_src_unused))
 	{
-		print_tabs(tabs + 1);
-		printf("mul1 ");
+		print_tabs(buf, tabs + 1);
+		string_buf_printf(buf, "mul1 ");
 		if (code->mul1_neg)
-			printf("-");
-		printf("%u, %u\n", code->mul1_src0, code->mul1_src1);
+			string_buf_printf(buf, "-");
+		string_buf_printf(buf, "%u, %u\n", code->mul1_src0, code->mul1_src1);
 	}
-
-	print_tabs(tabs + 1);
-	printf(".acc_op = %u\n", code->acc_op);
-
+	
+	print_tabs(buf, tabs + 1);
+	string_buf_printf(buf, ".acc_op = %u\n", code->acc_op);
+	
 	if ((code->acc0_src0 != lima_gp_src_unused)
 		|| (code->acc0_src1 != lima_gp_src_unused))
 	{
-		print_tabs(tabs + 1);
-		printf("add0 ");
+		print_tabs(buf, tabs + 1);
+		string_buf_printf(buf, "add0 ");
 		if(code->acc0_src0_neg)
-			printf("-");
-		printf("%u, ", code->acc0_src0);
+			string_buf_printf(buf, "-");
+		string_buf_printf(buf, "%u, ", code->acc0_src0);
 		if(code->acc0_src1_neg)
-			printf("-");
-		printf("%u\n", code->acc0_src1);
+			string_buf_printf(buf, "-");
+		string_buf_printf(buf, "%u\n", code->acc0_src1);
 	}
-
+	
 	if ((code->acc1_src0 != lima_gp_src_unused)
 		|| (code->acc1_src1 != lima_gp_src_unused))
 	{
-		print_tabs(tabs + 1);
-		printf("add1 ");
+		print_tabs(buf, tabs + 1);
+		string_buf_printf(buf, "add1 ");
 		if(code->acc1_src0_neg)
-			printf("-");
-		printf("%u, ", code->acc1_src0);
+			string_buf_printf(buf, "-");
+		string_buf_printf(buf, "%u, ", code->acc1_src0);
 		if(code->acc1_src1_neg)
-			printf("-");
-		printf("%u\n", code->acc1_src1);
+			string_buf_printf(buf, "-");
+		string_buf_printf(buf, "%u\n", code->acc1_src1);
 	}
-
+	
 	if (code->complex_src != lima_gp_src_unused)
 	{
-		print_tabs(tabs + 1);
-		printf(".complex_op = %u\n", code->complex_op);
-
-		print_tabs(tabs + 1);
-		printf(".complex_src = %u\n", code->complex_src);
+		print_tabs(buf, tabs + 1);
+		string_buf_printf(buf, ".complex_op = %u\n", code->complex_op);
+		
+		print_tabs(buf, tabs + 1);
+		string_buf_printf(buf, ".complex_src = %u\n", code->complex_src);
 	}
-
+	
 	if (code->pass_src != lima_gp_src_unused)
 	{
-		print_tabs(tabs + 1);
-		printf(".pass_op = %u\n", code->pass_op);
-
-		print_tabs(tabs + 1);
-		printf(".pass_src = %u\n", code->pass_src);
+		print_tabs(buf, tabs + 1);
+		string_buf_printf(buf, ".pass_op = %u\n", code->pass_op);
+		
+		print_tabs(buf, tabs + 1);
+		string_buf_printf(buf, ".pass_src = %u\n", code->pass_src);
 	}
-
-	print_tabs(tabs + 1);
-	printf(".load_addr = %u\n", code->load_addr);
-
-	print_tabs(tabs + 1);
-	printf(".load_offset = %u\n", code->load_offset);
-
+	
+	print_tabs(buf, tabs + 1);
+	string_buf_printf(buf, ".load_addr = %u\n", code->load_addr);
+	
+	print_tabs(buf, tabs + 1);
+	string_buf_printf(buf, ".load_offset = %u\n", code->load_offset);
+	
 	if (code->register0_attribute)
 	{
-		print_tabs(tabs + 1);
-		printf(".register0_attribute = 1\n");
+		print_tabs(buf, tabs + 1);
+		string_buf_printf(buf, ".register0_attribute = 1\n");
 	}
-
-	print_tabs(tabs + 1);
-	printf(".register0_addr = %u\n", code->register0_addr);
-
-	print_tabs(tabs + 1);
-	printf(".register1_addr = %u\n", code->register1_addr);
-
+	
+	print_tabs(buf, tabs + 1);
+	string_buf_printf(buf, ".register0_addr = %u\n", code->register0_addr);
+	
+	print_tabs(buf, tabs + 1);
+	string_buf_printf(buf, ".register1_addr = %u\n", code->register1_addr);
+	
 	if ((code->store0_src_x != lima_gp_store_src_none)
 		|| (code->store0_src_y != lima_gp_store_src_none))
 	{
 		if (code->store0_varying)
 		{
-			print_tabs(tabs + 1);
-			printf(".store0_varying = 1\n");
+			print_tabs(buf, tabs + 1);
+			string_buf_printf(buf, ".store0_varying = 1\n");
 		}
 		if (code->store0_temporary)
 		{
-			print_tabs(tabs + 1);
-			printf(".store0_temporary = 1\n");
+			print_tabs(buf, tabs + 1);
+			string_buf_printf(buf, ".store0_temporary = 1\n");
 		}
-		print_tabs(tabs + 1);
-		printf(".store0_address = %u\n", code->store0_addr);
-
+		print_tabs(buf, tabs + 1);
+		string_buf_printf(buf, ".store0_address = %u\n", code->store0_addr);
+		
 		if (code->store0_src_x != lima_gp_store_src_none)
 		{
-			print_tabs(tabs + 1);
-			printf(".store0_src_x = %u\n", code->store0_src_x);
+			print_tabs(buf, tabs + 1);
+			string_buf_printf(buf, ".store0_src_x = %u\n", code->store0_src_x);
 		}
-
+		
 		if (code->store0_src_y != lima_gp_store_src_none)
 		{
-			print_tabs(tabs + 1);
-			printf(".store0_src_y = %u\n", code->store0_src_y);
+			print_tabs(buf, tabs + 1);
+			string_buf_printf(buf, ".store0_src_y = %u\n", code->store0_src_y);
 		}
 	}
-
+	
 	if ((code->store1_src_z != lima_gp_store_src_none)
 		|| (code->store1_src_w != lima_gp_store_src_none))
 	{
 		if (code->store1_varying)
 		{
-			print_tabs(tabs + 1);
-			printf(".store1_varying = 1\n");
+			print_tabs(buf, tabs + 1);
+			string_buf_printf(buf, ".store1_varying = 1\n");
 		}
 		if (code->store1_temporary)
 		{
-			print_tabs(tabs + 1);
-			printf(".store1_temporary = 1\n");
+			print_tabs(buf, tabs + 1);
+			string_buf_printf(buf, ".store1_temporary = 1\n");
 		}
-		print_tabs(tabs + 1);
-		printf(".store1_address = %u\n", code->store1_addr);
-
+		print_tabs(buf, tabs + 1);
+		string_buf_printf(buf, ".store1_address = %u\n", code->store1_addr);
+		
 		if (code->store1_src_z != lima_gp_store_src_none)
 		{
-			print_tabs(tabs + 1);
-			printf(".store1_src_z = %u\n", code->store1_src_z);
+			print_tabs(buf, tabs + 1);
+			string_buf_printf(buf, ".store1_src_z = %u\n", code->store1_src_z);
 		}
-
+		
 		if(code->store1_src_w != lima_gp_store_src_none)
 		{
-			print_tabs(tabs + 1);
-			printf(".store1_src_w = %u\n", code->store1_src_w);
+			print_tabs(buf, tabs + 1);
+			string_buf_printf(buf, ".store1_src_w = %u\n", code->store1_src_w);
 		}
 	}
-
+	
 	if (code->branch)
 	{
-		print_tabs(tabs + 1);
-		printf(".branch = 1\n");
-		print_tabs(tabs + 1);
-		printf(".branch_target_lo = %u\n", code->branch_target_lo);
-		print_tabs(tabs + 1);
-		printf(".branch_target = %u\n", code->branch_target);
+		print_tabs(buf, tabs + 1);
+		string_buf_printf(buf, ".branch = 1\n");
+		print_tabs(buf, tabs + 1);
+		string_buf_printf(buf, ".branch_target_lo = %u\n", code->branch_target_lo);
+		print_tabs(buf, tabs + 1);
+		string_buf_printf(buf, ".branch_target = %u\n", code->branch_target);
 	}
-
-	print_tabs(tabs + 1);
-	printf(".unknown_1 = %u\n", code->unknown_1);
 	
-	print_tabs(tabs);
-	printf("}");
+	print_tabs(buf, tabs + 1);
+	string_buf_printf(buf, ".unknown_1 = %u\n", code->unknown_1);
+	
+	print_tabs(buf, tabs);
+	string_buf_printf(buf, "}");
 }
 
-#if 0
-
 void lima_gp_instruction_print_verbose(
-	lima_gp_instruction_t* code, 
-	ogt_link_map_t* map,
-	unsigned tabs)
+	string_buf_t* buf, lima_gp_instruction_t* code, unsigned tabs)
 {
-	print_tabs(tabs);
-
+	print_tabs(buf, tabs);
+	
 	bool first    = true;
 	bool uniform  = false;
 	bool reg_used = false;
-
+	
 	{
 		unsigned i;
 		lima_gp_src_e s[] = 
@@ -351,7 +346,7 @@ void lima_gp_instruction_print_verbose(
 			}
 		}
 	}
-
+	
 	/* Scan for pass.clamp op. */
 	switch (code->pass_op)
 	{
@@ -360,53 +355,44 @@ void lima_gp_instruction_print_verbose(
 		default:
 			break;
 	}
-
+	
 	if (uniform)
 	{
 		first = false;
-
-		bool temporary = false;
-		if (map)
-		{
-			temporary = (((unsigned)code->load_addr << 2)
-				>= ogt_link_map_uniform_area(map));
-			/* TODO - Resolve vector name where possible. */
-		}
-
-		if (temporary)
-			printf("temporary");
-		else
-			printf("uniform");
-
-		printf(".load(%u", code->load_addr);
+		
+		/* Without a link map there's no telling where the uniforms end
+		 * and the temporaries begin, so every load is a uniform load. */
+		string_buf_printf(buf, "uniform");
+		
+		string_buf_printf(buf, ".load(%u", code->load_addr);
 		if (code->load_offset != lima_gp_load_off_none)
-			printf(", %s",
+			string_buf_printf(buf, ", %s",
 				lima_gp_load_off_name[code->load_offset]);
-		printf(")");
+		string_buf_printf(buf, ")");
 	}
-
+	
 	if (code->register0_attribute)
 	{
-		if (!first) printf(", ");
+		if (!first) string_buf_printf(buf, ", ");
 		else first = false;
-
-		printf("attribute.load(%u)", code->register0_addr);
+		
+		string_buf_printf(buf, "attribute.load(%u)", code->register0_addr);
 	}
 	else if (reg_used
 		|| (code->register0_addr != 0))
 	{
-		if (!first) printf(", ");
+		if (!first) string_buf_printf(buf, ", ");
 		else first = false;
-
-		printf("register[0].load(%u)", code->register0_addr);
+		
+		string_buf_printf(buf, "register[0].load(%u)", code->register0_addr);
 	}
-
+	
 	if (reg_used)
 	{
-		if (!first) printf(", ");
+		if (!first) string_buf_printf(buf, ", ");
 		else first = false;
-
-		printf("register[1].load(%u)", code->register1_addr);
+		
+		string_buf_printf(buf, "register[1].load(%u)", code->register1_addr);
 	}
 	
 	switch (code->mul_op)
@@ -417,39 +403,39 @@ void lima_gp_instruction_print_verbose(
 			if ((code->mul0_src0 != lima_gp_src_unused)
 				|| (code->mul0_src1 != lima_gp_src_unused))
 			{
-				if (!first) printf(", ");
+				if (!first) string_buf_printf(buf, ", ");
 				else first = false;
-
+				
 				const char* src0_name
 					= lima_gp__source_name(code, code->mul0_src0, false);
-
+				
 				if ((code->mul_op == lima_gp_mul_op_mul)
 					&& (code->mul0_src1 == lima_gp_src_ident))
 				{
-					printf("mul[0].pass(%s)", src0_name);
+					string_buf_printf(buf, "mul[0].pass(%s)", src0_name);
 				} else {
-					printf("mul[0].%s(%s, %s%s)",
+					string_buf_printf(buf, "mul[0].%s(%s, %s%s)",
 						lima_gp_mul_op_name[code->mul_op],
 						src0_name,
 						(code->mul0_neg ? "-" : ""),
 						lima_gp__source_name(code, code->mul0_src1, true));
 				}
 			}
-
+			
 			if ((code->mul1_src0 != lima_gp_src_unused)
 				|| (code->mul1_src1 != lima_gp_src_unused))
 			{
-				if (!first) printf(", ");
+				if (!first) string_buf_printf(buf, ", ");
 				else first = false;
-
+				
 				const char* src0_name
 					= lima_gp__source_name(code, code->mul1_src0, false);
-
+				
 				if (code->mul1_src1 == lima_gp_src_ident)
 				{
-					printf("mul[1].pass(%s)", src0_name);
+					string_buf_printf(buf, "mul[1].pass(%s)", src0_name);
 				} else {
-					printf("mul[1].mul(%s, %s%s)",
+					string_buf_printf(buf, "mul[1].mul(%s, %s%s)",
 						src0_name,
 						(code->mul1_neg ? "-" : ""),
 						lima_gp__source_name(code, code->mul1_src1, true));
@@ -458,10 +444,10 @@ void lima_gp_instruction_print_verbose(
 		} break;
 		case lima_gp_mul_op_select:
 		{
-			if (!first) printf(", ");
+			if (!first) string_buf_printf(buf, ", ");
 			else first = false;
-
-			printf("mul.%s(%s%s, %s, %s)",
+			
+			string_buf_printf(buf, "mul.%s(%s%s, %s, %s)",
 				lima_gp_mul_op_name[code->mul_op],
 				(code->mul0_neg ? "-" : ""),
 				lima_gp__source_name(code, code->mul0_src1, true),
@@ -470,10 +456,10 @@ void lima_gp_instruction_print_verbose(
 		} break;
 		default:
 		{
-			if (!first) printf(", ");
+			if (!first) string_buf_printf(buf, ", ");
 			else first = false;
-
-			printf("mul.%s(%s, %s%s, %s, %s%s)",
+			
+			string_buf_printf(buf, "mul.%s(%s, %s%s, %s, %s%s)",
 				lima_gp_mul_op_name[code->mul_op],
 				lima_gp__source_name(code, code->mul0_src0, false),
 				(code->mul0_neg ? "-" : ""),
@@ -483,24 +469,24 @@ void lima_gp_instruction_print_verbose(
 				lima_gp__source_name(code, code->mul1_src1, true));
 		} break;
 	}
-
+	
 	if ((code->acc0_src0 != lima_gp_src_unused)
 		|| (code->acc0_src1 != lima_gp_src_unused))
 	{
-		if (!first) printf(", ");
+		if (!first) string_buf_printf(buf, ", ");
 		else first = false;
-
+		
 		if ((code->acc_op == lima_gp_acc_op_add)
 			&& code->acc0_src1_neg
 			&& (code->acc0_src1 == lima_gp_src_ident))
 		{
-			printf("acc[0].pass(%s%s)",
+			string_buf_printf(buf, "acc[0].pass(%s%s)",
 				(code->acc0_src0_neg ? "-" : ""),
 				lima_gp__source_name(code, code->acc0_src0, false));
 		}
 		else
 		{
-			printf("acc[0].%s(%s%s, %s%s)",
+			string_buf_printf(buf, "acc[0].%s(%s%s, %s%s)",
 				lima_gp_acc_op_name[code->acc_op],
 				(code->acc0_src0_neg ? "-" : ""),
 				lima_gp__source_name(code, code->acc0_src0, false),
@@ -508,24 +494,24 @@ void lima_gp_instruction_print_verbose(
 				lima_gp__source_name(code, code->acc0_src1, true));
 		}
 	}
-
+	
 	if ((code->acc1_src0 != lima_gp_src_unused)
 		|| (code->acc1_src1 != lima_gp_src_unused))
 	{
-		if (!first) printf(", ");
+		if (!first) string_buf_printf(buf, ", ");
 		else first = false;
-
+		
 		if ((code->acc_op == lima_gp_acc_op_add)
 			&& code->acc1_src1_neg
 			&& (code->acc1_src1 == lima_gp_src_ident))
 		{
-			printf("acc[1].pass(%s%s)",
+			string_buf_printf(buf, "acc[1].pass(%s%s)",
 				(code->acc1_src0_neg ? "-" : ""),
 				lima_gp__source_name(code, code->acc1_src0, false));
 		}
 		else
 		{
-			printf("acc[1].%s(%s%s, %s%s)",
+			string_buf_printf(buf, "acc[1].%s(%s%s, %s%s)",
 				lima_gp_acc_op_name[code->acc_op],
 				(code->acc1_src0_neg ? "-" : ""),
 				lima_gp__source_name(code, code->acc1_src0, false),
@@ -533,163 +519,144 @@ void lima_gp_instruction_print_verbose(
 				lima_gp__source_name(code, code->acc1_src1, true));
 		}
 	}
-
-
+	
+	
 	if (code->complex_src != lima_gp_src_unused)
 	{
-		if (!first) printf(", ");
+		if (!first) string_buf_printf(buf, ", ");
 		else first = false;
-
-		printf("complex.%s(%s)",
+		
+		string_buf_printf(buf, "complex.%s(%s)",
 			lima_gp_complex_op_name[code->complex_op],
 			lima_gp__source_name(code, code->complex_src, false));
 	}
-
+	
 	if (code->pass_src != lima_gp_src_unused)
 	{
-		if (!first) printf(", ");
+		if (!first) string_buf_printf(buf, ", ");
 		else first = false;
-
-		printf("pass.%s(%s)",
+		
+		string_buf_printf(buf, "pass.%s(%s)",
 			lima_gp_pass_op_name[code->pass_op],
 			lima_gp__source_name(code, code->pass_src, false));
 	}
-
+	
 	if ((code->store0_src_x != lima_gp_store_src_none)
 		|| (code->store0_src_y != lima_gp_store_src_none))
 	{
-		if (!first) printf(", ");
+		if (!first) string_buf_printf(buf, ", ");
 		else first = false;
-
-		printf("store[0].");
-
+		
+		string_buf_printf(buf, "store[0].");
+		
 		if (code->store0_varying)
-			printf("varying");
+			string_buf_printf(buf, "varying");
 		else if (code->store0_temporary)
-			printf("temporary");
+			string_buf_printf(buf, "temporary");
 		else
-			printf("register");
-
-		printf("(%u, %s, %s)",
+			string_buf_printf(buf, "register");
+		
+		string_buf_printf(buf, "(%u, %s, %s)",
 			code->store0_addr,
 			lima_gp_store_src_name[code->store0_src_x],
 			lima_gp_store_src_name[code->store0_src_y]);
 	}
-
+	
 	if ((code->store1_src_z != lima_gp_store_src_none)
 		|| (code->store1_src_w != lima_gp_store_src_none))
 	{
-		if (!first) printf(", ");
+		if (!first) string_buf_printf(buf, ", ");
 		else first = false;
-
-		printf("store[1].");
-
+		
+		string_buf_printf(buf, "store[1].");
+		
 		if (code->store1_varying)
-			printf("varying");
+			string_buf_printf(buf, "varying");
 		else if (code->store1_temporary)
-			printf("temporary");
+			string_buf_printf(buf, "temporary");
 		else
-			printf("register");
+			string_buf_printf(buf, "register");
 			
-		printf("(%u, %s, %s)",
+		string_buf_printf(buf, "(%u, %s, %s)",
 			code->store1_addr,
 			lima_gp_store_src_name[code->store1_src_z],
 			lima_gp_store_src_name[code->store1_src_w]);
 	}
-
+	
 	if (code->branch)
 	{
-		if (!first) printf(", ");
+		if (!first) string_buf_printf(buf, ", ");
 		else first = false;
-
+		
 		unsigned branch_target
 			= code->branch_target;
 		if (!code->branch_target_lo)
 			branch_target += 0x100;
-		printf("branch(%u)", branch_target);
+		string_buf_printf(buf, "branch(%u)", branch_target);
 	}
-
+	
 	if (code->unknown_1)
 	{
-		if (!first) printf(", ");
+		if (!first) string_buf_printf(buf, ", ");
 		else first = false;
-
-		printf("unknown_1(%u)", code->unknown_1);
+		
+		string_buf_printf(buf, "unknown_1(%u)", code->unknown_1);
 	}
-
-	printf(";");
+	
+	string_buf_printf(buf, ";");
 }
 
 
 
 bool lima_gp_disassemble(
-	void* code, unsigned size,
-	ogt_link_map_t* map,
-	ogt_asm_type_e type,
-	ogt_asm_syntax_e syntax,
-	unsigned tabs)
+	string_buf_t* buf, const void* code, unsigned size,
+	lima_asm_syntax_e syntax, unsigned tabs)
 {
-	(void)type; /* Not used. */
-
-	if (size % sizeof(lima_gp_instruction_t))
-	{
-		fprintf(stderr, "Error: Invalid vertex assembly"
-			" (size must be multiple of 4 (32-bit) words)\n");
+	/* Vertex assembly is a whole number of 128-bit instructions. */
+	if (!code || (size % sizeof(lima_gp_instruction_t)))
 		return false;
-	}
-
-	/* Print symbol table. */
-	essl_program_t* program
-		= ogt_link_map_export_essl(map);
-	if (program)
-	{
-		essl_program_print(program, stdout, tabs);
-		printf("\n");
-	}
-
+	
 	lima_gp_instruction_t* icode
 		= (lima_gp_instruction_t*)code;
 	size /= sizeof(lima_gp_instruction_t);
-
+	
+	unsigned i;
 	switch (syntax)
 	{
-		case ogt_asm_syntax_explicit:
-		{
-			unsigned i;
+		case lima_asm_syntax_explicit:
 			for (i = 0; i < size; i++)
 			{
-				lima_gp_instruction_print_explicit(&icode[i], tabs);
-				printf("\n");
+				lima_gp_instruction_print_explicit(buf, &icode[i], tabs);
+				string_buf_printf(buf, "\n");
+				string_buf_flush(buf);
 			}
-		} break;
-		case ogt_asm_syntax_verbose:
-		{
-			unsigned i;
+			break;
+		case lima_asm_syntax_verbose:
 			for (i = 0; i < size; i++)
 			{
-				lima_gp_instruction_print_verbose(&icode[i], map, tabs);
-				printf("\n");
+				lima_gp_instruction_print_verbose(buf, &icode[i], tabs);
+				string_buf_printf(buf, "\n");
+				string_buf_flush(buf);
 			}
-		} break;
-		case ogt_asm_syntax_decompile:
-		{
-			print_tabs(tabs); printf("void main()\n");
-			print_tabs(tabs); printf("{\n");
-			tabs++;
-
-			unsigned i;
+			break;
+		case lima_asm_syntax_decompile:
+			print_tabs(buf, tabs); string_buf_printf(buf, "void main()\n");
+			print_tabs(buf, tabs); string_buf_printf(buf, "{\n");
+			string_buf_flush(buf);
+			
 			for (i = 0; i < size; i++)
+			{
 				lima_gp_instruction_print_decompile(
-					icode, i, map, tabs);
-
-			tabs--;
-			print_tabs(tabs); printf("}\n");
-		} break;
+					buf, icode, size, i, tabs + 1);
+				string_buf_flush(buf);
+			}
+			
+			print_tabs(buf, tabs); string_buf_printf(buf, "}\n");
+			string_buf_flush(buf);
+			break;
 		default:
 			return false;
 	}
 	
 	return true;
 }
-
-#endif
@@ -32,6 +32,8 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "string_buf.h"
+#include "shader.h"
 
 
 
@@ -207,11 +209,52 @@ extern const char* lima_gp_load_off_name[];
 
 
 extern void lima_gp_instruction_print_explicit(
-	lima_gp_instruction_t* code, unsigned tabs);
-/*extern void lima_gp_instruction_print_verbose(
-	lima_gp_instruction_t* code, ogt_link_map_t* map, unsigned tabs);
+	string_buf_t* buf, lima_gp_instruction_t* code, unsigned tabs);
+extern void lima_gp_instruction_print_verbose(
+	string_buf_t* buf, lima_gp_instruction_t* code, unsigned tabs);
 extern void lima_gp_instruction_print_decompile(
-	lima_gp_instruction_t* code, unsigned offset, ogt_link_map_t* map,
-	unsigned tabs);*/
+	string_buf_t* buf, const lima_gp_instruction_t* code, unsigned size,
+	unsigned offset, unsigned tabs);
+
+/* Prints size bytes of code to buf, flushing after every instruction.
+ * Returns false if the code is corrupt. */
+extern bool lima_gp_disassemble(
+	string_buf_t* buf, const void* code, unsigned size,
+	lima_asm_syntax_e syntax, unsigned tabs);
+
+
+
+/* Functional simulator, for checking what code computes and how many
+ * instructions it runs without the hardware. Attributes and varyings are
+ * LIMA_GP_SIM_NUM_ATTRIBS and LIMA_GP_SIM_NUM_VARYINGS vec4s per vertex, laid
+ * out by the symbol tables, and the uniforms are the uniform space as the
+ * compiler packed it: the uniform table, the temporaries, and then the
+ * constants it added. A simulator must only be used by one thread at a time.
+ */
+
+#define LIMA_GP_SIM_NUM_ATTRIBS  16
+#define LIMA_GP_SIM_NUM_VARYINGS 16
+#define LIMA_GP_SIM_NUM_UNIFORMS 512
+
+typedef struct lima_gp_sim_s lima_gp_sim_t;
+
+/* Takes a copy of size bytes of code, returns NULL if it's corrupt. */
+extern lima_gp_sim_t* lima_gp_sim_create(const void* code, unsigned size);
+extern void lima_gp_sim_delete(lima_gp_sim_t* sim);
+
+/* Sets the first num_uniforms vec4s of the uniform space, the rest are 0. */
+extern void lima_gp_sim_set_uniforms(lima_gp_sim_t* sim,
+	const float* uniforms, unsigned num_uniforms);
+
+/* Runs num_vertices vertices, adding up how many times each instruction
+ * runs. Returns false if a loop didn't terminate. */
+extern bool lima_gp_sim_run(lima_gp_sim_t* sim, const float* attributes,
+	float* varyings, unsigned num_vertices);
+
+/* The number of times each instruction ran, over every vertex run since the
+ * simulator was created or the counts were reset. */
+extern const unsigned long* lima_gp_sim_get_counts(lima_gp_sim_t* sim,
+	unsigned* num_instrs);
+extern void lima_gp_sim_reset_counts(lima_gp_sim_t* sim);
 
 #endif
@@ -0,0 +1,697 @@
+/* Author(s):
+ *   Connor Abbott
+ *
+ * Copyright (c) 2014 Connor Abbott (connor@abbott.cx)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Functional simulator for GP code.
+ *
+ * Vertices are run in batches of LANES, with the lane as the innermost index
+ * of all the state, so every operation is a short loop over the lanes that
+ * the compiler can turn into vector instructions. Lanes that go different ways
+ * at a branch are split up: each step runs the instruction at the lowest pc of
+ * any lane that hasn't finished, with only the lanes at that pc enabled, so
+ * they come back together where the paths join. Every lane computes every
+ * result, and the enabled mask is only applied when the results are written
+ * back.
+ *
+ * The complex and pass units are modelled by what they compute rather than
+ * how: exp2, log2, rcp and rsqrt give the exact result, and the complex1,
+ * complex2, preexp2 and postlog2 steps the compiler puts around them only pass
+ * it along.
+ */
+
+#include "lima_gp.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define LANES 8
+
+/* a batch runs this many steps at most before giving up, which is plenty for
+ * any loop that terminates */
+#define MAX_STEPS (1 << 20)
+
+typedef float lane_t[LANES];
+
+/* everything an instruction produces that the next two can read */
+typedef struct
+{
+	lane_t acc[2], mul[2], pass, complex;
+	lane_t attrib[4];
+} results_t;
+
+/* the loads of the instruction being run */
+typedef struct
+{
+	lane_t attrib[4];
+	const lane_t* reg;
+	lane_t load[4];
+} loads_t;
+
+struct lima_gp_sim_s
+{
+	lima_gp_instruction_t* code;
+	unsigned num_instrs;
+	unsigned long* counts;
+	
+	float uniforms[LIMA_GP_SIM_NUM_UNIFORMS][4];
+	
+	/* Programs that store temporaries get a copy of the uniforms for each
+	 * lane, since the temporaries live in the same space. */
+	bool stores_temps;
+	lane_t (*memory)[4];
+	
+	lane_t attrib[LIMA_GP_SIM_NUM_ATTRIBS][4];
+	lane_t reg[16][4];
+	lane_t varying[LIMA_GP_SIM_NUM_VARYINGS][4];
+	int ld_addr[3][LANES];
+	results_t p1, p2;
+	unsigned pc[LANES];
+	bool enabled[LANES];
+};
+
+static const lane_t zero = {0.f};
+static const lane_t one = {1.f, 1.f, 1.f, 1.f, 1.f, 1.f, 1.f, 1.f};
+
+lima_gp_sim_t* lima_gp_sim_create(const void* code, unsigned size)
+{
+	if (size == 0 || size % sizeof(lima_gp_instruction_t) != 0)
+		return NULL;
+	
+	lima_gp_sim_t* sim = calloc(1, sizeof(lima_gp_sim_t));
+	if (!sim)
+		return NULL;
+	
+	sim->num_instrs = size / sizeof(lima_gp_instruction_t);
+	sim->code = malloc(size);
+	sim->counts = calloc(sim->num_instrs, sizeof(unsigned long));
+	if (!sim->code || !sim->counts)
+	{
+		lima_gp_sim_delete(sim);
+		return NULL;
+	}
+	memcpy(sim->code, code, size);
+	
+	unsigned i;
+	for (i = 0; i < sim->num_instrs; i++)
+	{
+		if (sim->code[i].store0_temporary || sim->code[i].store1_temporary)
+			sim->stores_temps = true;
+	}
+	
+	if (sim->stores_temps)
+	{
+		sim->memory = malloc(LIMA_GP_SIM_NUM_UNIFORMS * sizeof(*sim->memory));
+		if (!sim->memory)
+		{
+			lima_gp_sim_delete(sim);
+			return NULL;
+		}
+	}
+	
+	return sim;
+}
+
+void lima_gp_sim_delete(lima_gp_sim_t* sim)
+{
+	free(sim->code);
+	free(sim->counts);
+	free(sim->memory);
+	free(sim);
+}
+
+void lima_gp_sim_set_uniforms(lima_gp_sim_t* sim, const float* uniforms,
+							  unsigned num_uniforms)
+{
+	if (num_uniforms > LIMA_GP_SIM_NUM_UNIFORMS)
+		num_uniforms = LIMA_GP_SIM_NUM_UNIFORMS;
+	
+	memset(sim->uniforms, 0, sizeof(sim->uniforms));
+	memcpy(sim->uniforms, uniforms, num_uniforms * 4 * sizeof(float));
+}
+
+const unsigned long* lima_gp_sim_get_counts(lima_gp_sim_t* sim,
+											unsigned* num_instrs)
+{
+	*num_instrs = sim->num_instrs;
+	return sim->counts;
+}
+
+void lima_gp_sim_reset_counts(lima_gp_sim_t* sim)
+{
+	memset(sim->counts, 0, sim->num_instrs * sizeof(unsigned long));
+}
+
+/* Loads */
+
+static int get_ld_addr(lima_gp_load_off_t offset)
+{
+	switch (offset)
+	{
+		case lima_gp_load_off_ld_addr_0:
+			return 0;
+		case lima_gp_load_off_ld_addr_1:
+			return 1;
+		case lima_gp_load_off_ld_addr_2:
+			return 2;
+		default:
+			return -1;
+	}
+}
+
+static void load_uniform(lima_gp_sim_t* sim,
+						 const lima_gp_instruction_t* instr, loads_t* loads)
+{
+	unsigned c, l;
+	int ld_addr = get_ld_addr(instr->load_offset);
+	
+	if (ld_addr < 0 && !sim->stores_temps)
+	{
+		/* the same for every lane */
+		for (c = 0; c < 4; c++)
+		{
+			float value = sim->uniforms[instr->load_addr][c];
+			for (l = 0; l < LANES; l++)
+				loads->load[c][l] = value;
+		}
+		return;
+	}
+	
+	for (l = 0; l < LANES; l++)
+	{
+		int addr = instr->load_addr;
+		if (ld_addr >= 0)
+			addr += sim->ld_addr[ld_addr][l];
+		
+		for (c = 0; c < 4; c++)
+		{
+			if (addr < 0 || addr >= LIMA_GP_SIM_NUM_UNIFORMS)
+				loads->load[c][l] = 0.f;
+			else if (sim->stores_temps)
+				loads->load[c][l] = sim->memory[addr][c][l];
+			else
+				loads->load[c][l] = sim->uniforms[addr][c];
+		}
+	}
+}
+
+static void load(lima_gp_sim_t* sim, const lima_gp_instruction_t* instr,
+				 loads_t* loads)
+{
+	if (instr->register0_attribute)
+		memcpy(loads->attrib, sim->attrib[instr->register0_addr],
+			   sizeof(loads->attrib));
+	else
+		memcpy(loads->attrib, sim->reg[instr->register0_addr],
+			   sizeof(loads->attrib));
+	
+	/* registers are only written after everything has been read */
+	loads->reg = (const lane_t*) sim->reg[instr->register1_addr];
+	
+	load_uniform(sim, instr, loads);
+}
+
+static const float* get_src(lima_gp_sim_t* sim, const loads_t* loads,
+							lima_gp_src_e src)
+{
+	switch (src)
+	{
+		case lima_gp_src_attrib_x:
+		case lima_gp_src_attrib_y:
+		case lima_gp_src_attrib_z:
+		case lima_gp_src_attrib_w:
+			return loads->attrib[src - lima_gp_src_attrib_x];
+		case lima_gp_src_register_x:
+		case lima_gp_src_register_y:
+		case lima_gp_src_register_z:
+		case lima_gp_src_register_w:
+			return loads->reg[src - lima_gp_src_register_x];
+		case lima_gp_src_load_x:
+		case lima_gp_src_load_y:
+		case lima_gp_src_load_z:
+		case lima_gp_src_load_w:
+			return loads->load[src - lima_gp_src_load_x];
+		case lima_gp_src_p1_acc_0:
+			return sim->p1.acc[0];
+		case lima_gp_src_p1_acc_1:
+			return sim->p1.acc[1];
+		case lima_gp_src_p1_mul_0:
+			return sim->p1.mul[0];
+		case lima_gp_src_p1_mul_1:
+			return sim->p1.mul[1];
+		case lima_gp_src_p1_pass:
+			return sim->p1.pass;
+		case lima_gp_src_p1_complex:
+			return sim->p1.complex;
+		case lima_gp_src_p2_pass:
+			return sim->p2.pass;
+		case lima_gp_src_p2_acc_0:
+			return sim->p2.acc[0];
+		case lima_gp_src_p2_acc_1:
+			return sim->p2.acc[1];
+		case lima_gp_src_p2_mul_0:
+			return sim->p2.mul[0];
+		case lima_gp_src_p2_mul_1:
+			return sim->p2.mul[1];
+		case lima_gp_src_p1_attrib_x:
+		case lima_gp_src_p1_attrib_y:
+		case lima_gp_src_p1_attrib_z:
+		case lima_gp_src_p1_attrib_w:
+			return sim->p1.attrib[src - lima_gp_src_p1_attrib_x];
+		default:
+			return zero;
+	}
+}
+
+/* Units */
+
+static void run_acc(lima_gp_sim_t* sim, const loads_t* loads,
+					lima_gp_acc_op_e op, lima_gp_src_e src0, bool neg0,
+					lima_gp_src_e src1, bool neg1, float* dest)
+{
+	const float* a = get_src(sim, loads, src0);
+	const float* b = src1 == lima_gp_src_ident ? zero :
+		get_src(sim, loads, src1);
+	float sign0 = neg0 ? -1.f : 1.f, sign1 = neg1 ? -1.f : 1.f;
+	
+	unsigned l;
+	switch (op)
+	{
+		case lima_gp_acc_op_add:
+			for (l = 0; l < LANES; l++)
+				dest[l] = sign0 * a[l] + sign1 * b[l];
+			break;
+		case lima_gp_acc_op_floor:
+			for (l = 0; l < LANES; l++)
+				dest[l] = floorf(sign0 * a[l]);
+			break;
+		case lima_gp_acc_op_sign:
+			for (l = 0; l < LANES; l++)
+				dest[l] = (float) ((sign0 * a[l] > 0.f) - (sign0 * a[l] < 0.f));
+			break;
+		case lima_gp_acc_op_ge:
+			for (l = 0; l < LANES; l++)
+				dest[l] = sign0 * a[l] >= sign1 * b[l] ? 1.f : 0.f;
+			break;
+		case lima_gp_acc_op_lt:
+			for (l = 0; l < LANES; l++)
+				dest[l] = sign0 * a[l] < sign1 * b[l] ? 1.f : 0.f;
+			break;
+		case lima_gp_acc_op_min:
+			for (l = 0; l < LANES; l++)
+				dest[l] = fminf(sign0 * a[l], sign1 * b[l]);
+			break;
+		case lima_gp_acc_op_max:
+			for (l = 0; l < LANES; l++)
+				dest[l] = fmaxf(sign0 * a[l], sign1 * b[l]);
+			break;
+		default:
+			memset(dest, 0, sizeof(lane_t));
+			break;
+	}
+}
+
+static void run_mul(lima_gp_sim_t* sim, const lima_gp_instruction_t* instr,
+					const loads_t* loads, results_t* cur)
+{
+	const float* mul0_src0 = get_src(sim, loads, instr->mul0_src0);
+	const float* mul0_src1 = instr->mul0_src1 == lima_gp_src_ident ? one :
+		get_src(sim, loads, instr->mul0_src1);
+	const float* mul1_src0 = get_src(sim, loads, instr->mul1_src0);
+	const float* mul1_src1 = instr->mul1_src1 == lima_gp_src_ident ? one :
+		get_src(sim, loads, instr->mul1_src1);
+	float sign0 = instr->mul0_neg ? -1.f : 1.f;
+	float sign1 = instr->mul1_neg ? -1.f : 1.f;
+	
+	unsigned l;
+	switch (instr->mul_op)
+	{
+		case lima_gp_mul_op_mul:
+			for (l = 0; l < LANES; l++)
+			{
+				cur->mul[0][l] = sign0 * (mul0_src0[l] * mul0_src1[l]);
+				cur->mul[1][l] = sign1 * (mul1_src0[l] * mul1_src1[l]);
+			}
+			break;
+		
+		case lima_gp_mul_op_select:
+			/* uses both multipliers, with the condition in mul0_src1 */
+			for (l = 0; l < LANES; l++)
+				cur->mul[0][l] = sign0 *
+					(mul0_src1[l] != 0.f ? mul0_src0[l] : mul1_src0[l]);
+			memset(cur->mul[1], 0, sizeof(lane_t));
+			break;
+		
+		case lima_gp_mul_op_complex1:
+			/* the last step of a complex op, with the complex unit's result
+			 * in mul0_src0 */
+			memcpy(cur->mul[0], mul0_src0, sizeof(lane_t));
+			memset(cur->mul[1], 0, sizeof(lane_t));
+			break;
+		
+		case lima_gp_mul_op_complex2:
+			/* the first step, only read by complex1, which leaves mul1 free
+			 * for a normal multiply */
+			for (l = 0; l < LANES; l++)
+			{
+				cur->mul[0][l] = mul0_src0[l];
+				cur->mul[1][l] = sign1 * (mul1_src0[l] * mul1_src1[l]);
+			}
+			break;
+		
+		default:
+			memset(cur->mul, 0, sizeof(cur->mul));
+			break;
+	}
+}
+
+static void run_complex(lima_gp_sim_t* sim, const lima_gp_instruction_t* instr,
+						const loads_t* loads, results_t* cur)
+{
+	const float* src = get_src(sim, loads, instr->complex_src);
+	
+	unsigned l;
+	switch (instr->complex_op)
+	{
+		case lima_gp_complex_op_exp2:
+			for (l = 0; l < LANES; l++)
+				cur->complex[l] = exp2f(src[l]);
+			break;
+		case lima_gp_complex_op_log2:
+			for (l = 0; l < LANES; l++)
+				cur->complex[l] = log2f(src[l]);
+			break;
+		case lima_gp_complex_op_rsqrt:
+			for (l = 0; l < LANES; l++)
+				cur->complex[l] = 1.f / sqrtf(src[l]);
+			break;
+		case lima_gp_complex_op_rcp:
+			for (l = 0; l < LANES; l++)
+				cur->complex[l] = 1.f / src[l];
+			break;
+		case lima_gp_complex_op_nop:
+			memset(cur->complex, 0, sizeof(lane_t));
+			break;
+		default:
+			/* pass, and the addresses for temporary loads and stores */
+			memcpy(cur->complex, src, sizeof(lane_t));
+			break;
+	}
+}
+
+static void run_pass(lima_gp_sim_t* sim, const lima_gp_instruction_t* instr,
+					 const loads_t* loads, results_t* cur)
+{
+	const float* src = get_src(sim, loads, instr->pass_src);
+	
+	unsigned l;
+	if (instr->pass_op == lima_gp_pass_op_clamp)
+	{
+		/* the bounds are in the x and y of this instruction's load */
+		for (l = 0; l < LANES; l++)
+			cur->pass[l] = fminf(fmaxf(src[l], loads->load[0][l]),
+								 loads->load[1][l]);
+	}
+	else
+		memcpy(cur->pass, src, sizeof(lane_t));
+}
+
+/* Writing back */
+
+static void write_lanes(const bool* enabled, float* dest, const float* src)
+{
+	unsigned l;
+	for (l = 0; l < LANES; l++)
+		dest[l] = enabled[l] ? src[l] : dest[l];
+}
+
+static const float* get_store_src(const results_t* cur,
+								  lima_gp_store_src_e src)
+{
+	switch (src)
+	{
+		case lima_gp_store_src_acc_0:
+			return cur->acc[0];
+		case lima_gp_store_src_acc_1:
+			return cur->acc[1];
+		case lima_gp_store_src_mul_0:
+			return cur->mul[0];
+		case lima_gp_store_src_mul_1:
+			return cur->mul[1];
+		case lima_gp_store_src_pass:
+			return cur->pass;
+		case lima_gp_store_src_complex:
+			return cur->complex;
+		default:
+			return NULL;
+	}
+}
+
+static void store_temp(lima_gp_sim_t* sim, const results_t* cur,
+					   unsigned component, const float* src)
+{
+	unsigned l;
+	for (l = 0; l < LANES; l++)
+	{
+		/* the address comes from the complex unit */
+		int addr = (int) cur->complex[l];
+		if (sim->enabled[l] && addr >= 0 && addr < LIMA_GP_SIM_NUM_UNIFORMS)
+			sim->memory[addr][component][l] = src[l];
+	}
+}
+
+static void store(lima_gp_sim_t* sim, const lima_gp_instruction_t* instr,
+				  const results_t* cur)
+{
+	lima_gp_store_src_e srcs[4] = {
+		instr->store0_src_x, instr->store0_src_y,
+		instr->store1_src_z, instr->store1_src_w
+	};
+	
+	unsigned i;
+	for (i = 0; i < 4; i++)
+	{
+		const float* src = get_store_src(cur, srcs[i]);
+		if (!src)
+			continue;
+		
+		bool varying = i < 2 ? instr->store0_varying : instr->store1_varying;
+		bool temporary =
+			i < 2 ? instr->store0_temporary : instr->store1_temporary;
+		unsigned addr = i < 2 ? instr->store0_addr : instr->store1_addr;
+		
+		if (varying)
+			write_lanes(sim->enabled, sim->varying[addr][i], src);
+		else if (temporary)
+			store_temp(sim, cur, i, src);
+		else
+			write_lanes(sim->enabled, sim->reg[addr][i], src);
+	}
+}
+
+static void set_ld_addr(lima_gp_sim_t* sim, const lima_gp_instruction_t* instr,
+						const results_t* cur)
+{
+	int ld_addr;
+	switch (instr->complex_op)
+	{
+		case lima_gp_complex_op_temp_load_addr_0:
+			ld_addr = 0;
+			break;
+		case lima_gp_complex_op_temp_load_addr_1:
+			ld_addr = 1;
+			break;
+		case lima_gp_complex_op_temp_load_addr_2:
+			ld_addr = 2;
+			break;
+		default:
+			return;
+	}
+	
+	unsigned l;
+	for (l = 0; l < LANES; l++)
+	{
+		if (sim->enabled[l])
+			sim->ld_addr[ld_addr][l] = (int) cur->complex[l];
+	}
+}
+
+static void write_results(lima_gp_sim_t* sim, const results_t* cur,
+						  bool all_enabled)
+{
+	if (all_enabled)
+	{
+		sim->p2 = sim->p1;
+		sim->p1 = *cur;
+		return;
+	}
+	
+	const float* src1 = (const float*) &sim->p1;
+	const float* src0 = (const float*) cur;
+	float* dest2 = (float*) &sim->p2;
+	float* dest1 = (float*) &sim->p1;
+	
+	unsigned i;
+	for (i = 0; i < sizeof(results_t) / sizeof(lane_t); i++)
+	{
+		write_lanes(sim->enabled, dest2 + i * LANES, src1 + i * LANES);
+		write_lanes(sim->enabled, dest1 + i * LANES, src0 + i * LANES);
+	}
+}
+
+static unsigned get_branch_target(const lima_gp_instruction_t* instr)
+{
+	return (!instr->branch_target_lo << 8) | instr->branch_target;
+}
+
+static void run_instr(lima_gp_sim_t* sim, unsigned pc, bool all_enabled)
+{
+	const lima_gp_instruction_t* instr = &sim->code[pc];
+	
+	loads_t loads;
+	load(sim, instr, &loads);
+	
+	results_t cur;
+	run_acc(sim, &loads, instr->acc_op, instr->acc0_src0, instr->acc0_src0_neg,
+			instr->acc0_src1, instr->acc0_src1_neg, cur.acc[0]);
+	run_acc(sim, &loads, instr->acc_op, instr->acc1_src0, instr->acc1_src0_neg,
+			instr->acc1_src1, instr->acc1_src1_neg, cur.acc[1]);
+	run_mul(sim, instr, &loads, &cur);
+	run_complex(sim, instr, &loads, &cur);
+	run_pass(sim, instr, &loads, &cur);
+	memcpy(cur.attrib, loads.attrib, sizeof(cur.attrib));
+	
+	store(sim, instr, &cur);
+	set_ld_addr(sim, instr, &cur);
+	write_results(sim, &cur, all_enabled);
+	
+	unsigned l;
+	if (instr->branch)
+	{
+		/* the condition goes through the pass unit */
+		unsigned target = get_branch_target(instr);
+		for (l = 0; l < LANES; l++)
+		{
+			if (sim->enabled[l])
+				sim->pc[l] = cur.pass[l] != 0.f ? target : pc + 1;
+		}
+	}
+	else
+	{
+		for (l = 0; l < LANES; l++)
+		{
+			if (sim->enabled[l])
+				sim->pc[l] = pc + 1;
+		}
+	}
+}
+
+static void start_batch(lima_gp_sim_t* sim, const float* attributes,
+						unsigned num_lanes)
+{
+	/* lanes past the end of the vertices start out finished */
+	unsigned i, c, l;
+	for (l = 0; l < LANES; l++)
+		sim->pc[l] = l < num_lanes ? 0 : sim->num_instrs;
+	
+	memset(sim->attrib, 0, sizeof(sim->attrib));
+	for (l = 0; l < num_lanes; l++)
+	{
+		const float* attrib = attributes + l * LIMA_GP_SIM_NUM_ATTRIBS * 4;
+		for (i = 0; i < LIMA_GP_SIM_NUM_ATTRIBS; i++)
+			for (c = 0; c < 4; c++)
+				sim->attrib[i][c][l] = attrib[4 * i + c];
+	}
+	
+	memset(sim->reg, 0, sizeof(sim->reg));
+	memset(sim->varying, 0, sizeof(sim->varying));
+	memset(sim->ld_addr, 0, sizeof(sim->ld_addr));
+	memset(&sim->p1, 0, sizeof(sim->p1));
+	memset(&sim->p2, 0, sizeof(sim->p2));
+	
+	if (sim->stores_temps)
+	{
+		for (i = 0; i < LIMA_GP_SIM_NUM_UNIFORMS; i++)
+			for (c = 0; c < 4; c++)
+				for (l = 0; l < LANES; l++)
+					sim->memory[i][c][l] = sim->uniforms[i][c];
+	}
+}
+
+static void end_batch(lima_gp_sim_t* sim, float* varyings, unsigned num_lanes)
+{
+	unsigned i, c, l;
+	for (l = 0; l < num_lanes; l++)
+	{
+		float* varying = varyings + l * LIMA_GP_SIM_NUM_VARYINGS * 4;
+		for (i = 0; i < LIMA_GP_SIM_NUM_VARYINGS; i++)
+			for (c = 0; c < 4; c++)
+				varying[4 * i + c] = sim->varying[i][c][l];
+	}
+}
+
+static bool run_batch(lima_gp_sim_t* sim)
+{
+	unsigned step;
+	for (step = 0; step < MAX_STEPS; step++)
+	{
+		unsigned l, pc = sim->num_instrs;
+		for (l = 0; l < LANES; l++)
+		{
+			if (sim->pc[l] < pc)
+				pc = sim->pc[l];
+		}
+		
+		if (pc >= sim->num_instrs)
+			return true;
+		
+		unsigned num_enabled = 0;
+		for (l = 0; l < LANES; l++)
+		{
+			sim->enabled[l] = sim->pc[l] == pc;
+			num_enabled += sim->enabled[l];
+		}
+		
+		sim->counts[pc] += num_enabled;
+		run_instr(sim, pc, num_enabled == LANES);
+	}
+	
+	return false;
+}
+
+bool lima_gp_sim_run(lima_gp_sim_t* sim, const float* attributes,
+					 float* varyings, unsigned num_vertices)
+{
+	unsigned i;
+	for (i = 0; i < num_vertices; i += LANES)
+	{
+		unsigned num_lanes = num_vertices - i < LANES ? num_vertices - i : LANES;
+		start_batch(sim, attributes + i * LIMA_GP_SIM_NUM_ATTRIBS * 4,
+					num_lanes);
+		if (!run_batch(sim))
+			return false;
+		end_batch(sim, varyings + i * LIMA_GP_SIM_NUM_VARYINGS * 4, num_lanes);
+	}
+	
+	return true;
+}
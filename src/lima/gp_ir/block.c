@@ -85,6 +85,7 @@ lima_gp_ir_block_t* lima_gp_ir_block_create(void)
 	block->live_virt_before = bitset_create(0);
 	
 	block->imm_dominator = NULL;
+	block->sched_log = NULL;
 	
 	return block;
 }
@@ -107,6 +108,11 @@ void lima_gp_ir_block_delete(lima_gp_ir_block_t* block)
 	while (block->num_instrs > 0)
 		lima_gp_ir_instr_delete(gp_ir_block_first_instr(block));
 	
+	lima_gp_ir_block_delete_shallow(block);
+}
+
+void lima_gp_ir_block_delete_shallow(lima_gp_ir_block_t* block)
+{
 	if (block->preds)
 		free(block->preds);
 	
@@ -222,6 +228,7 @@ typedef struct
 {
 	unsigned expr_index;
 	unsigned tabs;
+	FILE* f;
 } expr_print_state_t;
 
 static bool expr_print_cb(lima_gp_ir_node_t* node, void* _state)
@@ -230,10 +237,10 @@ static bool expr_print_cb(lima_gp_ir_node_t* node, void* _state)
 	{
 		expr_print_state_t* state = (expr_print_state_t*) _state;
 		
-		lima_gp_ir_print_tabs(state->tabs);
-		printf("(def_expr expr_%u\n", state->expr_index);
-		node->print(node, state->tabs + 1);
-		printf(")\n");
+		lima_gp_ir_print_tabs(state->tabs, state->f);
+		fprintf(state->f, "(def_expr expr_%u\n", state->expr_index);
+		node->print(node, state->tabs + 1, state->f);
+		fprintf(state->f, ")\n");
 		
 		node->index = state->expr_index;
 		state->expr_index++;
@@ -241,7 +248,7 @@ static bool expr_print_cb(lima_gp_ir_node_t* node, void* _state)
 	return true;
 }
 
-static void print_liveness(bitset_t live, unsigned size)
+static void print_liveness(bitset_t live, unsigned size, FILE* f)
 {
 	unsigned i;
 	for (i = 0; i < size; i++)
@@ -251,74 +258,75 @@ static void print_liveness(bitset_t live, unsigned size)
 			bitset_get(live, 4 * i + 2) ||
 			bitset_get(live, 4 * i + 3))
 		{
-			printf("%u.", i);
+			fprintf(f, "%u.", i);
 			if (bitset_get(live, 4 * i + 0))
-				printf("x");
+				fprintf(f, "x");
 			if (bitset_get(live, 4 * i + 1))
-				printf("y");
+				fprintf(f, "y");
 			if (bitset_get(live, 4 * i + 2))
-				printf("z");
+				fprintf(f, "z");
 			if (bitset_get(live, 4 * i + 3))
-				printf("w");
-			printf(" ");
+				fprintf(f, "w");
+			fprintf(f, " ");
 		}
 	}
 }
 
-static void print_block_liveness(lima_gp_ir_block_t* block)
+static void print_block_liveness(lima_gp_ir_block_t* block, FILE* f)
 {
-	printf("//live_phys: ");
-	print_liveness(block->live_phys_before, 16);
-	printf("\n//live_virt: ");
-	print_liveness(block->live_virt_before, block->prog->reg_alloc);
-	printf("\n");
+	fprintf(f, "//live_phys: ");
+	print_liveness(block->live_phys_before, 16, f);
+	fprintf(f, "\n//live_virt: ");
+	print_liveness(block->live_virt_before, block->prog->reg_alloc, f);
+	fprintf(f, "\n");
 }
 
-static void print_node_liveness(lima_gp_ir_root_node_t* node)
+static void print_node_liveness(lima_gp_ir_root_node_t* node, FILE* f)
 {
-	printf("//live_phys: ");
-	print_liveness(node->live_phys_after, 16);
-	printf("\n//live_virt: ");
-	print_liveness(node->live_virt_after, node->block->prog->reg_alloc);
-	printf("\n");
+	fprintf(f, "//live_phys: ");
+	print_liveness(node->live_phys_after, 16, f);
+	fprintf(f, "\n//live_virt: ");
+	print_liveness(node->live_virt_after, node->block->prog->reg_alloc, f);
+	fprintf(f, "\n");
 }
 
-static void print_dominance_info(lima_gp_ir_block_t* block)
+static void print_dominance_info(lima_gp_ir_block_t* block, FILE* f)
 {
 	if (block->imm_dominator)
-		printf("//immediate dominator: block_%u\n", block->imm_dominator->index);
+		fprintf(f, "//immediate dominator: block_%u\n", block->imm_dominator->index);
 	
 	ptrset_iter_t iter = ptrset_iter_create(block->dominance_frontier);
 	lima_gp_ir_block_t* cur_block;
-	printf("//dominance frontier:\n");
+	fprintf(f, "//dominance frontier:\n");
 	ptrset_iter_for_each(iter, cur_block)
 	{
-		printf("//\tblock_%u\n", cur_block->index);
+		fprintf(f, "//\tblock_%u\n", cur_block->index);
 	}
 }
 
 bool lima_gp_ir_block_print(lima_gp_ir_block_t* block, unsigned tabs,
-							bool print_liveness)
+							bool print_liveness, FILE* f)
 {
 	expr_print_state_t state = {
 		.expr_index = 0,
-		.tabs = tabs
+		.tabs = tabs,
+		.f = f
 	};
 	
-	printf("block_%u:\n", block->index);
+	fprintf(f, "block_%u:\n", block->index);
 	
-	print_dominance_info(block);
+	print_dominance_info(block, f);
 	
 	lima_gp_ir_phi_node_t* phi_node;
 	ptrset_iter_t iter = ptrset_iter_create(block->phi_nodes);
 	ptrset_iter_for_each(iter, phi_node)
 	{
-		phi_node->node.print(&phi_node->node, tabs);
-		printf("\n");
+		phi_node->node.print(&phi_node->node, tabs, f);
+		fprintf(f, "\n");
 	}
 	
 	if (print_liveness)
-		print_block_liveness(block);
+		print_block_liveness(block, f);
 	
 	lima_gp_ir_root_node_t* node;
 	gp_ir_block_for_each_node(block, node)
@@ -326,13 +334,13 @@ bool lima_gp_ir_block_print(lima_gp_ir_block_t* block, unsigned tabs,
 		if (!lima_gp_ir_node_dfs(&node->node, NULL, expr_print_cb,
 								 (void*) &state))
 			return false;
-		lima_gp_ir_node_print(&node->node, tabs);
-		printf("\n");
+		lima_gp_ir_node_print(&node->node, tabs, f);
+		fprintf(f, "\n");
 		if (print_liveness)
-			print_node_liveness(node);
+			print_node_liveness(node, f);
 	}
 	
-	printf("\n");
+	fprintf(f, "\n");
 	return true;
 }
 
@@ -438,7 +446,7 @@ void *lima_gp_ir_block_export(lima_gp_ir_block_t* block, unsigned* size)
 	for (i = 0; i < index; i++)
 		*size += node_data_size[i];
 	
-	void* data = malloc(*size);
+	void* data = calloc(1, *size);
 	if (!data)
 	{
 		free(node_data);
@@ -503,7 +511,8 @@ bool lima_gp_ir_block_import(lima_gp_ir_block_t* block, void* data,
 	unsigned i;
 	for (i = 0; i < header->num_phi_nodes; i++)
 	{
-		lima_gp_ir_phi_node_t* phi_node = lima_gp_ir_phi_node_create(0);
+		lima_gp_ir_phi_node_t* phi_node =
+			lima_gp_ir_phi_node_create(block->prog, 0);
 		if (!phi_node)
 		{
 			free(nodes);
@@ -520,7 +529,7 @@ bool lima_gp_ir_block_import(lima_gp_ir_block_t* block, void* data,
 	
 	for (i = 0; i < num_nodes; i++)
 	{
-		nodes[i] = lima_gp_ir_node_create(node_header->op);
+		nodes[i] = lima_gp_ir_node_create(block->prog, node_header->op);
 		if (!nodes[i])
 		{
 			free(nodes);
@@ -24,6 +24,7 @@
 
 #include "scheduler.h"
 #include "../gp/lima_gp.h"
+#include "cycle_estimate.h"
 #include <assert.h>
 #include <stdlib.h>
 #include <string.h>
@@ -32,7 +33,7 @@ typedef struct
 {
 	lima_gp_instruction_t* instrs;
 	unsigned num_instrs, start_instr;
-	bool has_branch;
+	bool has_branch, branch_unconditional;
 	unsigned branch_dest; // Refers to a basic block, must be fixed up
 } codegen_block_t;
 
@@ -976,8 +977,35 @@ static void emit_instr(lima_gp_instruction_t* instr,
 		emit_pass_slot(instr, ir_instr->pass_slot);
 }
 
+static void count_slots(lima_slot_usage_t* usage, unsigned used,
+						unsigned total)
+{
+	usage->used += used;
+	usage->total += total;
+}
+
+static void report_instr(lima_gp_ir_instr_t* instr,
+						 lima_shader_report_t* report)
+{
+	report->num_instructions++;
+	
+	count_slots(&report->units.vs.mul,
+				(instr->mul_slots[0] != NULL) + (instr->mul_slots[1] != NULL), 2);
+	count_slots(&report->units.vs.add,
+				(instr->add_slots[0] != NULL) + (instr->add_slots[1] != NULL), 2);
+	count_slots(&report->units.vs.complex, instr->complex_slot != NULL, 1);
+	count_slots(&report->units.vs.pass, instr->pass_slot != NULL, 1);
+	count_slots(&report->units.vs.load, instr->uniform_slot_num_used > 0, 1);
+	
+	if (instr->uniform_slot_num_used && instr->uniform_is_temp)
+		report->temp_loads++;
+	if (instr->store_slot_num_used && instr->store_slot_is_temp)
+		report->temp_stores++;
+}
+
 static bool emit_block(codegen_block_t* block,
-					   lima_gp_ir_block_t* ir_block)
+					   lima_gp_ir_block_t* ir_block,
+					   lima_shader_report_t* report)
 {
 	block->instrs =
 		malloc(sizeof(lima_gp_instruction_t) * ir_block->num_instrs);
@@ -991,12 +1019,14 @@ static bool emit_block(codegen_block_t* block,
 	gp_ir_block_for_each_instr(ir_block, instr)
 	{
 		emit_instr(&block->instrs[i], instr);
+		report_instr(instr, report);
 		if (instr->branch_slot)
 		{
 			block->has_branch = true;
 			lima_gp_ir_branch_node_t* branch_node =
 				gp_ir_node_to_branch(instr->branch_slot);
 			block->branch_dest = branch_node->dest->index;
+			block->branch_unconditional = branch_node->unconditional;
 		}
 		i++;
 	}
@@ -1004,7 +1034,8 @@ static bool emit_block(codegen_block_t* block,
 	return true;
 }
 
-static bool emit_program(codegen_prog_t* prog, lima_gp_ir_prog_t* ir_prog)
+static bool emit_program(codegen_prog_t* prog, lima_gp_ir_prog_t* ir_prog,
+						 lima_shader_report_t* report)
 {
 	prog->blocks = malloc(sizeof(codegen_block_t) * ir_prog->num_blocks);
 	if (!prog->blocks)
@@ -1024,7 +1055,7 @@ static bool emit_program(codegen_prog_t* prog, lima_gp_ir_prog_t* ir_prog)
 	unsigned cur_instr = 0;
 	gp_ir_prog_for_each_block(ir_prog, block)
 	{
-		if (!emit_block(&prog->blocks[i], block))
+		if (!emit_block(&prog->blocks[i], block, report))
 		{
 			free(prog->blocks);
 			return false;
@@ -1062,6 +1093,40 @@ static void fixup_branches(codegen_prog_t* prog)
 	}
 }
 
+/* Branches are on the last instruction of a block, and only fall through
+ * to the next block if they're conditional.
+ */
+
+static bool report_cycles(codegen_prog_t* prog, lima_shader_report_t* report)
+{
+	cycle_block_t* cycle_blocks = calloc(prog->num_blocks,
+										 sizeof(cycle_block_t));
+	if (!cycle_blocks)
+		return false;
+	
+	unsigned i;
+	for (i = 0; i < prog->num_blocks; i++)
+	{
+		codegen_block_t* block = &prog->blocks[i];
+		cycle_block_t* cycle_block = &cycle_blocks[i];
+		
+		if (block->has_branch)
+		{
+			report->branches++;
+			cycle_block_add_edge(cycle_block, block->num_instrs,
+								 block->branch_dest);
+			if (block->branch_unconditional)
+				continue;
+		}
+		
+		cycle_block_add_edge(cycle_block, block->num_instrs, i + 1);
+	}
+	
+	bool ret = cycle_estimate(cycle_blocks, prog->num_blocks, report);
+	free(cycle_blocks);
+	return ret;
+}
+
 static unsigned calc_attrib_prefetch(lima_gp_instruction_t* instrs,
 									 unsigned size)
 {
@@ -1074,14 +1139,22 @@ static unsigned calc_attrib_prefetch(lima_gp_instruction_t* instrs,
 }
 
 void* lima_gp_ir_codegen(lima_gp_ir_prog_t* ir_prog, unsigned* size,
-						 unsigned* attrib_prefetch)
+						 unsigned* attrib_prefetch, lima_shader_report_t* report)
 {
+	memset(report, 0, sizeof(*report));
+	
 	codegen_prog_t prog;
-	if (!emit_program(&prog, ir_prog))
+	if (!emit_program(&prog, ir_prog, report))
 		return false;
 	
 	fixup_branches(&prog);
 	
+	if (!report_cycles(&prog, report))
+	{
+		delete_program(prog);
+		return NULL;
+	}
+	
 	*size = 0;
 	unsigned i;
 	for (i = 0; i < prog.num_blocks; i++)
@@ -337,7 +337,8 @@ static bool const_fold_cb(lima_gp_ir_node_t* node, void* state)
 	if (!fold_node(node, &constant))
 		return true;
 	
-	lima_gp_ir_const_node_t* const_node = lima_gp_ir_const_node_create();
+	lima_gp_ir_const_node_t* const_node =
+		lima_gp_ir_const_node_create(node->prog);
 	if (!const_node)
 		return false;
 	
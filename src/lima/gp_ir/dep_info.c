@@ -28,6 +28,21 @@
 
 /* implements helpers for the scheduling algorithm(s) */
 
+lima_gp_ir_dep_info_t* lima_gp_ir_dep_info_alloc(lima_gp_ir_node_t* pred)
+{
+	lima_gp_ir_dep_info_t* dep_info =
+		arena_alloc(pred->prog->arena, sizeof(lima_gp_ir_dep_info_t));
+	if (dep_info)
+		dep_info->pred = pred;
+	return dep_info;
+}
+
+void lima_gp_ir_dep_info_free(lima_gp_ir_dep_info_t* dep_info)
+{
+	arena_free(dep_info->pred->prog->arena, dep_info,
+			   sizeof(lima_gp_ir_dep_info_t));
+}
+
 bool lima_gp_ir_dep_info_insert(lima_gp_ir_dep_info_t* dep_info)
 {
 	if (!ptrset_add(&dep_info->pred->succs, dep_info))
@@ -41,7 +56,7 @@ void lima_gp_ir_dep_info_delete(lima_gp_ir_dep_info_t* dep_info)
 {
 	ptrset_remove(&dep_info->pred->succs, dep_info);
 	ptrset_remove(&dep_info->succ->preds, dep_info);
-	free(dep_info);
+	lima_gp_ir_dep_info_free(dep_info);
 }
 
 lima_gp_ir_dep_info_t* lima_gp_ir_dep_info_find(lima_gp_ir_node_t* pred,
@@ -64,7 +79,7 @@ static bool node_insert_child_deps(lima_gp_ir_node_t* node)
 	gp_ir_node_for_each_child(node, iter)
 	{
 		lima_gp_ir_dep_info_t* dep_info =
-			malloc(sizeof(lima_gp_ir_dep_info_t));
+			lima_gp_ir_dep_info_alloc(*iter.child);
 		if (!dep_info)
 			return false;
 		dep_info->pred = *iter.child;
@@ -77,7 +92,7 @@ static bool node_insert_child_deps(lima_gp_ir_node_t* node)
 		}
 		if (!lima_gp_ir_dep_info_insert(dep_info))
 		{
-			free(dep_info);
+			lima_gp_ir_dep_info_free(dep_info);
 			return false;
 		}
 	}
@@ -115,7 +130,7 @@ static bool insert_reg_dependencies(lima_gp_ir_load_reg_node_t* load_reg_node)
 			{
 				// Insert write-after-read dependency (false dependency)
 				lima_gp_ir_dep_info_t* dep_info =
-					malloc(sizeof(lima_gp_ir_dep_info_t));
+					lima_gp_ir_dep_info_alloc(&load_reg_node->node);
 				if (!dep_info)
 					return false;
 				dep_info->pred = &load_reg_node->node;
@@ -123,7 +138,7 @@ static bool insert_reg_dependencies(lima_gp_ir_load_reg_node_t* load_reg_node)
 				dep_info->is_child_dep = false;
 				if (!lima_gp_ir_dep_info_insert(dep_info))
 				{
-					free(dep_info);
+					lima_gp_ir_dep_info_free(dep_info);
 					return false;
 				}
 				
@@ -147,7 +162,7 @@ static bool insert_reg_dependencies(lima_gp_ir_load_reg_node_t* load_reg_node)
 			{
 				// Insert read-after-write dependency (true dependency)
 				lima_gp_ir_dep_info_t* dep_info =
-					malloc(sizeof(lima_gp_ir_dep_info_t));
+					lima_gp_ir_dep_info_alloc(&node->node);
 				if (!dep_info)
 					return false;
 				dep_info->pred = &node->node;
@@ -155,7 +170,7 @@ static bool insert_reg_dependencies(lima_gp_ir_load_reg_node_t* load_reg_node)
 				dep_info->is_child_dep = false;
 				if (!lima_gp_ir_dep_info_insert(dep_info))
 				{
-					free(dep_info);
+					lima_gp_ir_dep_info_free(dep_info);
 					return false;
 				}
 				
@@ -183,7 +198,7 @@ static bool insert_temp_read_deps(lima_gp_ir_load_node_t* load_temp_node)
 		{
 			// Insert write-after-read dependency (false dependency)
 			lima_gp_ir_dep_info_t* dep_info =
-				malloc(sizeof(lima_gp_ir_dep_info_t));
+				lima_gp_ir_dep_info_alloc(&load_temp_node->node);
 			if (!dep_info)
 				return false;
 			dep_info->pred = &load_temp_node->node;
@@ -191,7 +206,7 @@ static bool insert_temp_read_deps(lima_gp_ir_load_node_t* load_temp_node)
 			dep_info->is_child_dep = false;
 			if (!lima_gp_ir_dep_info_insert(dep_info))
 			{
-				free(dep_info);
+				lima_gp_ir_dep_info_free(dep_info);
 				return false;
 			}
 				
@@ -208,7 +223,7 @@ static bool insert_temp_read_deps(lima_gp_ir_load_node_t* load_temp_node)
 		{
 			// Insert read-after-write dependency (true dependency)
 			lima_gp_ir_dep_info_t* dep_info =
-				malloc(sizeof(lima_gp_ir_dep_info_t));
+				lima_gp_ir_dep_info_alloc(&node->node);
 			if (!dep_info)
 				return false;
 			dep_info->pred = &node->node;
@@ -216,7 +231,7 @@ static bool insert_temp_read_deps(lima_gp_ir_load_node_t* load_temp_node)
 			dep_info->is_child_dep = false;
 			if (!lima_gp_ir_dep_info_insert(dep_info))
 			{
-				free(dep_info);
+				lima_gp_ir_dep_info_free(dep_info);
 				return false;
 			}
 			
@@ -263,7 +278,7 @@ static bool insert_temp_read_off_deps(lima_gp_ir_load_node_t* load_temp_node)
 		{
 			// Insert write-after-read dependency (false dependency)
 			lima_gp_ir_dep_info_t* dep_info =
-				malloc(sizeof(lima_gp_ir_dep_info_t));
+				lima_gp_ir_dep_info_alloc(&load_temp_node->node);
 			if (!dep_info)
 				return false;
 			dep_info->pred = &load_temp_node->node;
@@ -271,7 +286,7 @@ static bool insert_temp_read_off_deps(lima_gp_ir_load_node_t* load_temp_node)
 			dep_info->is_child_dep = false;
 			if (!lima_gp_ir_dep_info_insert(dep_info))
 			{
-				free(dep_info);
+				lima_gp_ir_dep_info_free(dep_info);
 				return false;
 			}
 			
@@ -288,7 +303,7 @@ static bool insert_temp_read_off_deps(lima_gp_ir_load_node_t* load_temp_node)
 		{
 			// Insert read-after-write dependency (true dependency)
 			lima_gp_ir_dep_info_t* dep_info =
-			malloc(sizeof(lima_gp_ir_dep_info_t));
+			lima_gp_ir_dep_info_alloc(&node->node);
 			if (!dep_info)
 				return false;
 			dep_info->pred = &node->node;
@@ -296,7 +311,7 @@ static bool insert_temp_read_off_deps(lima_gp_ir_load_node_t* load_temp_node)
 			dep_info->is_child_dep = false;
 			if (!lima_gp_ir_dep_info_insert(dep_info))
 			{
-				free(dep_info);
+				lima_gp_ir_dep_info_free(dep_info);
 				return false;
 			}
 			
@@ -394,7 +409,7 @@ static bool insert_reg_write_deps(lima_gp_ir_store_reg_node_t* store_reg_node)
 			
 			//Add the dependency
 			lima_gp_ir_dep_info_t* dep_info =
-				malloc(sizeof(lima_gp_ir_dep_info_t));
+				lima_gp_ir_dep_info_alloc(&node->node);
 			if (!dep_info)
 				return false;
 			
@@ -403,7 +418,7 @@ static bool insert_reg_write_deps(lima_gp_ir_store_reg_node_t* store_reg_node)
 			dep_info->is_child_dep = false;
 			if (!lima_gp_ir_dep_info_insert(dep_info))
 			{
-				free(dep_info);
+				lima_gp_ir_dep_info_free(dep_info);
 				return false;
 			}
 			
@@ -429,7 +444,7 @@ static bool insert_temp_write_deps(lima_gp_ir_store_node_t* temp_store_node)
 			
 			//Add the dependency
 			lima_gp_ir_dep_info_t* dep_info =
-			malloc(sizeof(lima_gp_ir_dep_info_t));
+			lima_gp_ir_dep_info_alloc(&node->node);
 			if (!dep_info)
 				return false;
 			
@@ -438,7 +453,7 @@ static bool insert_temp_write_deps(lima_gp_ir_store_node_t* temp_store_node)
 			dep_info->is_child_dep = false;
 			if (!lima_gp_ir_dep_info_insert(dep_info))
 			{
-				free(dep_info);
+				lima_gp_ir_dep_info_free(dep_info);
 				return false;
 			}
 			
@@ -465,7 +480,7 @@ static bool insert_temp_write_off_deps(lima_gp_ir_store_node_t* off_store_node)
 				
 				//Add the dependency
 				lima_gp_ir_dep_info_t* dep_info =
-				malloc(sizeof(lima_gp_ir_dep_info_t));
+				lima_gp_ir_dep_info_alloc(&node->node);
 				if (!dep_info)
 					return false;
 				
@@ -474,7 +489,7 @@ static bool insert_temp_write_off_deps(lima_gp_ir_store_node_t* off_store_node)
 				dep_info->is_child_dep = false;
 				if (!lima_gp_ir_dep_info_insert(dep_info))
 				{
-					free(dep_info);
+					lima_gp_ir_dep_info_free(dep_info);
 					return false;
 				}
 				
@@ -576,7 +591,7 @@ static bool make_varying_zero_last(lima_gp_ir_block_t* block)
 		if (node != varying_node)
 		{
 			lima_gp_ir_dep_info_t* dep_info =
-				malloc(sizeof(lima_gp_ir_dep_info_t));
+				lima_gp_ir_dep_info_alloc(node);
 			if (!dep_info)
 				return false;
 			
@@ -615,7 +630,7 @@ static bool make_branch_last(lima_gp_ir_block_t* block)
 		if (node != branch_node)
 		{
 			lima_gp_ir_dep_info_t* dep_info =
-				malloc(sizeof(lima_gp_ir_dep_info_t));
+				lima_gp_ir_dep_info_alloc(node);
 			if (!dep_info)
 				return false;
 			
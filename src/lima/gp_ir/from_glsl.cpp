@@ -186,7 +186,7 @@ ir_visitor_status gp_ir_visitor::visit_enter(ir_if* ir)
 	ir_dead_branches* db = this->dbv->get_dead_branches(ir);
 	
 	lima_gp_ir_branch_node_t* branch =
-		lima_gp_ir_branch_node_create(lima_gp_ir_op_branch_cond);
+		lima_gp_ir_branch_node_create(this->prog, lima_gp_ir_op_branch_cond);
 	branch->condition = this->cur_nodes[0];
 	lima_gp_ir_block_t** beginning_dest = &branch->dest;
 	lima_gp_ir_block_insert_end(this->cur_block, &branch->root_node);
@@ -200,7 +200,7 @@ ir_visitor_status gp_ir_visitor::visit_enter(ir_if* ir)
 	lima_gp_ir_block_t** then_dest = NULL;
 	if (!db->then_dead && !ir->else_instructions.is_empty())
 	{
-		branch = lima_gp_ir_branch_node_create(lima_gp_ir_op_branch_uncond);
+		branch = lima_gp_ir_branch_node_create(this->prog, lima_gp_ir_op_branch_uncond);
 		then_dest = &branch->dest;
 		lima_gp_ir_block_insert_end(this->cur_block, &branch->root_node);
 	}
@@ -255,7 +255,7 @@ ir_visitor_status gp_ir_visitor::visit_enter(ir_loop* ir)
 							_mesa_hash_pointer(ir), ir, this->cur_block);
 	
 	lima_gp_ir_branch_node_t* branch =
-		lima_gp_ir_branch_node_create(lima_gp_ir_op_branch_uncond);
+		lima_gp_ir_branch_node_create(this->prog, lima_gp_ir_op_branch_uncond);
 	branch->dest = loop_header;
 	lima_gp_ir_block_insert_end(this->cur_block, &branch->root_node);
 	
@@ -275,7 +275,7 @@ ir_visitor_status gp_ir_visitor::visit(ir_loop_jump* ir)
 							ir, this->cur_block);
 	
 	lima_gp_ir_branch_node_t* branch =
-		lima_gp_ir_branch_node_create(lima_gp_ir_op_branch_uncond);
+		lima_gp_ir_branch_node_create(this->prog, lima_gp_ir_op_branch_uncond);
 	if (ir->mode == ir_loop_jump::jump_break)
 		branch->dest = this->break_block;
 	else
@@ -322,7 +322,7 @@ ir_visitor_status gp_ir_visitor::visit(ir_phi_loop_end* ir)
 
 void gp_ir_visitor::insert_phi(ir_phi* ir, unsigned num_sources)
 {
-	lima_gp_ir_phi_node_t* phi = lima_gp_ir_phi_node_create(num_sources);
+	lima_gp_ir_phi_node_t* phi = lima_gp_ir_phi_node_create(this->prog, num_sources);
 	lima_gp_ir_reg_t* dest = lima_gp_ir_reg_create(this->prog);
 	dest->size = ir->dest->type->vector_elements;
 	phi->dest = dest;
@@ -475,7 +475,7 @@ ir_visitor_status gp_ir_visitor::visit_enter(ir_assignment* ir)
 static lima_gp_ir_node_t* build_alu_single(lima_gp_ir_op_e op,
 										   lima_gp_ir_node_t* child)
 {
-	lima_gp_ir_alu_node_t* node = lima_gp_ir_alu_node_create(op);
+	lima_gp_ir_alu_node_t* node = lima_gp_ir_alu_node_create(child->prog, op);
 	node->children[0] = child;
 	lima_gp_ir_node_link(&node->node, child);
 	return &node->node;
@@ -485,7 +485,7 @@ static lima_gp_ir_node_t* build_alu_dual(lima_gp_ir_op_e op,
 										 lima_gp_ir_node_t* child1,
 										 lima_gp_ir_node_t* child2)
 {
-	lima_gp_ir_alu_node_t* node = lima_gp_ir_alu_node_create(op);
+	lima_gp_ir_alu_node_t* node = lima_gp_ir_alu_node_create(child1->prog, op);
 	node->children[0] = child1;
 	node->children[1] = child2;
 	lima_gp_ir_node_link(&node->node, child1);
@@ -496,7 +496,7 @@ static lima_gp_ir_node_t* build_alu_dual(lima_gp_ir_op_e op,
 static lima_gp_ir_node_t* build_clamp_const(float min, float max,
 											lima_gp_ir_node_t* child)
 {
-	lima_gp_ir_clamp_const_node_t* node = lima_gp_ir_clamp_const_node_create();
+	lima_gp_ir_clamp_const_node_t* node = lima_gp_ir_clamp_const_node_create(child->prog);
 	node->low = min;
 	node->high = max;
 	node->child = child;
@@ -851,7 +851,7 @@ void gp_ir_visitor::emit_expression(lima_gp_ir_op_e op, ir_rvalue** sources,
 	lima_gp_ir_alu_node_t* nodes[4];
 	for (unsigned i = 0; i < size; i++)
 	{
-		nodes[i] = lima_gp_ir_alu_node_create(op);
+		nodes[i] = lima_gp_ir_alu_node_create(this->prog, op);
 	}
 	
 	for (unsigned i = 0; i < num_sources; i++)
@@ -885,7 +885,7 @@ ir_visitor_status gp_ir_visitor::visit(ir_constant* ir)
 	unsigned i;
 	for (i = 0; i < num_components; i++)
 	{
-		lima_gp_ir_const_node_t* node = lima_gp_ir_const_node_create();
+		lima_gp_ir_const_node_t* node = lima_gp_ir_const_node_create(this->prog);
 		switch (ir->type->base_type)
 		{
 			case GLSL_TYPE_FLOAT:
@@ -1025,7 +1025,7 @@ void gp_ir_visitor::emit_reg_store(ir_dereference* deref)
 	reg->size = var->type->vector_elements;
 	_mesa_hash_table_insert(this->var_to_reg, _mesa_hash_pointer(var), var, reg);
 	
-	lima_gp_ir_store_reg_node_t* store_reg = lima_gp_ir_store_reg_node_create();
+	lima_gp_ir_store_reg_node_t* store_reg = lima_gp_ir_store_reg_node_create(this->prog);
 	store_reg->reg = reg;
 	
 	for (unsigned i = 0; i < deref->type->vector_elements; i++)
@@ -1049,7 +1049,7 @@ void gp_ir_visitor::emit_reg_load(ir_dereference* deref)
 	
 	for (unsigned i = 0; i < deref->type->vector_elements; i++)
 	{
-		lima_gp_ir_load_reg_node_t* load = lima_gp_ir_load_reg_node_create();
+		lima_gp_ir_load_reg_node_t* load = lima_gp_ir_load_reg_node_create(this->prog);
 		load->reg = reg;
 		load->component = i;
 		this->cur_nodes[i] = &load->node;
@@ -1116,13 +1116,13 @@ void gp_ir_visitor::emit_output()
 	for (unsigned i = 0; i < 3; i++)
 	{
 		lima_gp_ir_load_node_t* scale =
-			lima_gp_ir_load_node_create(lima_gp_ir_op_load_uniform);
+			lima_gp_ir_load_node_create(this->prog, lima_gp_ir_op_load_uniform);
 		scale->index = trans_index;
 		scale->component = i;
 		scale->offset = false;
 		
 		lima_gp_ir_load_node_t* bias =
-			lima_gp_ir_load_node_create(lima_gp_ir_op_load_uniform);
+			lima_gp_ir_load_node_create(this->prog, lima_gp_ir_op_load_uniform);
 		bias->index = trans_index + 1;
 		bias->component = i;
 		bias->offset = false;
@@ -1136,7 +1136,7 @@ void gp_ir_visitor::emit_output()
 			&bias->node);
 	}
 	
-	lima_gp_ir_store_node_t* store = lima_gp_ir_store_node_create(lima_gp_ir_op_store_varying);
+	lima_gp_ir_store_node_t* store = lima_gp_ir_store_node_create(this->prog, lima_gp_ir_op_store_varying);
 	
 	lima_gp_ir_block_insert_end(this->cur_block, &store->root_node);
 	
@@ -1166,7 +1166,7 @@ void gp_ir_visitor::emit_temp_store(ir_dereference* deref, unsigned wrmask)
 	index = index / 4;
 	index += this->symbols->uniform_table.total_size / 4;
 	
-	lima_gp_ir_const_node_t* const_off = lima_gp_ir_const_node_create();
+	lima_gp_ir_const_node_t* const_off = lima_gp_ir_const_node_create(this->prog);
 	const_off->constant = (float) index;
 	
 	if (offset)
@@ -1174,7 +1174,7 @@ void gp_ir_visitor::emit_temp_store(ir_dereference* deref, unsigned wrmask)
 	else
 		offset = &const_off->node;
 	
-	lima_gp_ir_store_node_t* store = lima_gp_ir_store_node_create(lima_gp_ir_op_store_temp);
+	lima_gp_ir_store_node_t* store = lima_gp_ir_store_node_create(this->prog, lima_gp_ir_op_store_temp);
 	store->addr = offset;
 	
 	lima_gp_ir_block_insert_end(this->cur_block, &store->root_node);
@@ -1223,7 +1223,7 @@ void gp_ir_visitor::emit_uniform_load(ir_dereference* deref, bool is_temp)
 				op = lima_gp_ir_op_store_temp_load_off0;
 		}
 		
-		lima_gp_ir_store_node_t* store_off = lima_gp_ir_store_node_create(op);
+		lima_gp_ir_store_node_t* store_off = lima_gp_ir_store_node_create(this->prog, op);
 		store_off->mask[0] = true;
 		store_off->children[0] = offset;
 		lima_gp_ir_node_link(&store_off->root_node.node, offset);
@@ -1237,14 +1237,14 @@ void gp_ir_visitor::emit_uniform_load(ir_dereference* deref, bool is_temp)
 	//Hopefully the register-elimination pass will get rid of most of the mess.
 	
 	lima_gp_ir_reg_t* reg = lima_gp_ir_reg_create(this->prog);
-	lima_gp_ir_store_reg_node_t* store_reg = lima_gp_ir_store_reg_node_create();
+	lima_gp_ir_store_reg_node_t* store_reg = lima_gp_ir_store_reg_node_create(this->prog);
 	store_reg->reg = reg;
 	
 	lima_gp_ir_block_insert_end(this->cur_block, &store_reg->root_node);
 	
 	for (unsigned i = 0; i < deref->type->vector_elements; i++)
 	{
-		lima_gp_ir_load_node_t* load = lima_gp_ir_load_node_create(lima_gp_ir_op_load_uniform);
+		lima_gp_ir_load_node_t* load = lima_gp_ir_load_node_create(this->prog, lima_gp_ir_op_load_uniform);
 		load->index = index;
 		load->component = i + component_off;
 		if (offset)
@@ -1260,7 +1260,7 @@ void gp_ir_visitor::emit_uniform_load(ir_dereference* deref, bool is_temp)
 	
 	for (unsigned i = 0; i < deref->type->vector_elements; i++)
 	{
-		lima_gp_ir_load_reg_node_t* load = lima_gp_ir_load_reg_node_create();
+		lima_gp_ir_load_reg_node_t* load = lima_gp_ir_load_reg_node_create(this->prog);
 		load->reg = reg;
 		load->component = i;
 		
@@ -1279,7 +1279,7 @@ void gp_ir_visitor::emit_attr_load(ir_dereference* deref)
 	for (unsigned i = 0; i < deref->type->vector_elements; i++)
 	{
 		lima_gp_ir_load_node_t* load =
-			lima_gp_ir_load_node_create(lima_gp_ir_op_load_attribute);
+			lima_gp_ir_load_node_create(this->prog, lima_gp_ir_op_load_attribute);
 		load->index = index;
 		load->component = i;
 		this->cur_nodes[i] = &load->node;
@@ -1293,7 +1293,7 @@ void gp_ir_visitor::emit_varying_store(ir_dereference* deref, unsigned wrmask)
 	unsigned component_off = index % 4;
 	index /= 4;
 	
-	lima_gp_ir_store_node_t* store = lima_gp_ir_store_node_create(lima_gp_ir_op_store_varying);
+	lima_gp_ir_store_node_t* store = lima_gp_ir_store_node_create(this->prog, lima_gp_ir_op_store_varying);
 	store->index = index;
 	
 	lima_gp_ir_block_insert_end(this->cur_block, &store->root_node);
@@ -1409,7 +1409,7 @@ unsigned gp_ir_visitor::calc_deref_offset(ir_dereference* deref,
 		
 		if (stride != 4)
 		{
-			lima_gp_ir_const_node_t* stride_node = lima_gp_ir_const_node_create();
+			lima_gp_ir_const_node_t* stride_node = lima_gp_ir_const_node_create(this->prog);
 			stride_node->constant = stride / 4;
 			new_offset = build_alu_dual(lima_gp_ir_op_mul, index,
 										&stride_node->node);
@@ -32,8 +32,10 @@ extern "C" {
 #include "bitset.h"
 #include "ptrset.h"
 #include "list.h"
+#include "list_scheduler.h"
 #include "symbols/symbols.h"
 #include <stdint.h>
+#include <stdio.h>
 
 /* forward declaration of datastructures defined in scheduler.h */
 
@@ -41,7 +43,7 @@ struct lima_gp_ir_dep_info_s;
 
 
 
-void lima_gp_ir_print_tabs(unsigned tabs);
+void lima_gp_ir_print_tabs(unsigned tabs, FILE* f);
 
 /*
  * In this IR, the essential units of computation are "nodes." They map
@@ -182,7 +184,7 @@ typedef void (*lima_gp_ir_node_child_iter_next_cb)(
 	lima_gp_ir_child_node_iter_t* iter);
 
 typedef void (*lima_gp_ir_node_print_cb)(
-	struct lima_gp_ir_node_s* node, unsigned tabs);
+	struct lima_gp_ir_node_s* node, unsigned tabs, FILE* f);
 
 typedef bool (*lima_gp_ir_node_import_cb)(
 	struct lima_gp_ir_node_s* node, struct lima_gp_ir_node_s** nodes,
@@ -199,6 +201,9 @@ typedef struct lima_gp_ir_node_s
 {
 	lima_gp_ir_op_e op;
 	
+	/* the program whose arena the node was allocated from */
+	struct lima_gp_ir_prog_s* prog;
+	
 	/* used for reading/writing and printing */
 	unsigned index;
 		
@@ -222,6 +227,12 @@ typedef struct lima_gp_ir_node_s
 	 */
 	unsigned sched_pos, sched_instr;
 	
+	/* where the node is in the order the scheduler processed nodes in */
+	unsigned sched_order;
+	
+	/* successors left to schedule */
+	list_sched_node_t sched_node;
+	
 	ptrset_t parents;
 	struct lima_gp_ir_root_node_s* successor;
 } lima_gp_ir_node_t;
@@ -230,7 +241,8 @@ typedef struct lima_gp_ir_node_s
 	for(iter = node->child_iter_create(node); !iter.at_end; \
 		node->child_iter_next(&iter))
 
-lima_gp_ir_node_t* lima_gp_ir_node_create(lima_gp_ir_op_e op);
+lima_gp_ir_node_t* lima_gp_ir_node_create(struct lima_gp_ir_prog_s* prog,
+										  lima_gp_ir_op_e op);
 
 /*
  * Links a parent node to a child node. Assumes that the parent node is already
@@ -255,7 +267,7 @@ void lima_gp_ir_node_replace_child(lima_gp_ir_node_t* parent,
 bool lima_gp_ir_node_replace(lima_gp_ir_node_t* old_node,
 							 lima_gp_ir_node_t* new_node);
 
-void lima_gp_ir_node_print(lima_gp_ir_node_t* node, unsigned tabs);
+void lima_gp_ir_node_print(lima_gp_ir_node_t* node, unsigned tabs, FILE* f);
 
 /* delete a node, unlinking it from its children */
 void lima_gp_ir_node_delete(lima_gp_ir_node_t* node);
@@ -360,7 +372,8 @@ typedef struct
 } lima_gp_ir_alu_node_t;
 
 unsigned lima_gp_ir_alu_node_num_children(lima_gp_ir_op_e op);
-lima_gp_ir_alu_node_t* lima_gp_ir_alu_node_create(lima_gp_ir_op_e op);
+lima_gp_ir_alu_node_t* lima_gp_ir_alu_node_create(
+	struct lima_gp_ir_prog_s* prog, lima_gp_ir_op_e op);
 
 #define gp_ir_node_to_alu(_node) \
  container_of(_node, lima_gp_ir_alu_node_t, node)
@@ -381,7 +394,8 @@ typedef struct
 	lima_gp_ir_node_t* child;
 } lima_gp_ir_clamp_const_node_t;
 
-lima_gp_ir_clamp_const_node_t* lima_gp_ir_clamp_const_node_create(void);
+lima_gp_ir_clamp_const_node_t* lima_gp_ir_clamp_const_node_create(
+	struct lima_gp_ir_prog_s* prog);
 
 #define gp_ir_node_to_clamp_const(_node) \
 	container_of(_node, lima_gp_ir_clamp_const_node_t, node)
@@ -396,7 +410,8 @@ typedef struct
 	float constant;
 } lima_gp_ir_const_node_t;
 
-lima_gp_ir_const_node_t* lima_gp_ir_const_node_create(void);
+lima_gp_ir_const_node_t* lima_gp_ir_const_node_create(
+	struct lima_gp_ir_prog_s* prog);
 
 #define gp_ir_node_to_const(_node) \
 	container_of(_node, lima_gp_ir_const_node_t, node)
@@ -449,7 +464,8 @@ typedef struct
 	unsigned off_reg;
 } lima_gp_ir_load_node_t;
 
-lima_gp_ir_load_node_t* lima_gp_ir_load_node_create(lima_gp_ir_op_e op);
+lima_gp_ir_load_node_t* lima_gp_ir_load_node_create(
+	struct lima_gp_ir_prog_s* prog, lima_gp_ir_op_e op);
 
 #define gp_ir_node_to_load(_node) \
 	container_of(_node, lima_gp_ir_load_node_t, node)
@@ -468,7 +484,8 @@ typedef struct
 	lima_gp_ir_node_t* offset;
 } lima_gp_ir_load_reg_node_t;
 
-lima_gp_ir_load_reg_node_t* lima_gp_ir_load_reg_node_create(void);
+lima_gp_ir_load_reg_node_t* lima_gp_ir_load_reg_node_create(
+	struct lima_gp_ir_prog_s* prog);
 
 #define gp_ir_node_to_load_reg(_node) \
 	container_of(_node, lima_gp_ir_load_reg_node_t, node)
@@ -488,7 +505,8 @@ typedef struct
 	lima_gp_ir_node_t* addr;
 } lima_gp_ir_store_node_t;
 
-lima_gp_ir_store_node_t* lima_gp_ir_store_node_create(lima_gp_ir_op_e op);
+lima_gp_ir_store_node_t* lima_gp_ir_store_node_create(
+	struct lima_gp_ir_prog_s* prog, lima_gp_ir_op_e op);
 
 #define gp_ir_node_to_store(_node) \
 	container_of(_node, lima_gp_ir_store_node_t, root_node.node)
@@ -505,7 +523,8 @@ typedef struct
 	lima_gp_ir_node_t* children[4];
 } lima_gp_ir_store_reg_node_t;
 
-lima_gp_ir_store_reg_node_t* lima_gp_ir_store_reg_node_create(void);
+lima_gp_ir_store_reg_node_t* lima_gp_ir_store_reg_node_create(
+	struct lima_gp_ir_prog_s* prog);
 
 #define gp_ir_node_to_store_reg(_node) \
 	container_of(_node, lima_gp_ir_store_reg_node_t, root_node.node)
@@ -518,9 +537,15 @@ typedef struct
 	
 	struct lima_gp_ir_block_s* dest;
 	lima_gp_ir_node_t* condition;
+	
+	/* set when lowering turns an unconditional branch into a conditional
+	 * one, since the hardware only has those
+	 */
+	bool unconditional;
 } lima_gp_ir_branch_node_t;
 
-lima_gp_ir_branch_node_t* lima_gp_ir_branch_node_create(lima_gp_ir_op_e op);
+lima_gp_ir_branch_node_t* lima_gp_ir_branch_node_create(
+	struct lima_gp_ir_prog_s* prog, lima_gp_ir_op_e op);
 
 #define gp_ir_node_to_branch(_node) \
 	container_of(_node, lima_gp_ir_branch_node_t, root_node.node)
@@ -547,7 +572,8 @@ typedef struct
 	bool is_dead;
 } lima_gp_ir_phi_node_t;
 
-lima_gp_ir_phi_node_t* lima_gp_ir_phi_node_create(unsigned num_sources);
+lima_gp_ir_phi_node_t* lima_gp_ir_phi_node_create(
+	struct lima_gp_ir_prog_s* prog, unsigned num_sources);
 
 #define gp_ir_node_to_phi(_node) \
 	container_of(_node, lima_gp_ir_phi_node_t, node)
@@ -590,6 +616,9 @@ typedef struct lima_gp_ir_block_s
 	
 	bitset_t live_phys_before;
 	bitset_t live_virt_before;
+	
+	/* checkpoints for the scheduler, only valid while it's running */
+	struct lima_gp_ir_sched_log_s* sched_log;
 } lima_gp_ir_block_t;
 
 #define gp_ir_block_for_each_node(block, node) \
@@ -615,6 +644,12 @@ typedef struct lima_gp_ir_block_s
 
 lima_gp_ir_block_t* lima_gp_ir_block_create(void);
 void lima_gp_ir_block_delete(lima_gp_ir_block_t* block);
+
+/*
+ * Frees the block but not its nodes or instructions, which are left to be
+ * freed along with the program's arena.
+ */
+void lima_gp_ir_block_delete_shallow(lima_gp_ir_block_t* block);
 void lima_gp_ir_block_insert_start(
 	lima_gp_ir_block_t* block,
 	lima_gp_ir_root_node_t* node);
@@ -637,7 +672,7 @@ void lima_gp_ir_block_insert_phi(
 void lima_gp_ir_block_remove_phi(
 	lima_gp_ir_block_t* block, lima_gp_ir_phi_node_t* node);
 bool lima_gp_ir_block_print(
-	lima_gp_ir_block_t* block, unsigned tabs, bool print_liveness);
+	lima_gp_ir_block_t* block, unsigned tabs, bool print_liveness, FILE* f);
 void *lima_gp_ir_block_export(lima_gp_ir_block_t* block, unsigned* size);
 bool lima_gp_ir_block_import(lima_gp_ir_block_t* block, void* data,
 							 unsigned* size);
@@ -650,6 +685,12 @@ typedef struct lima_gp_ir_prog_s
 	struct list reg_list;
 	unsigned num_blocks;
 	unsigned reg_alloc, temp_alloc;
+	
+	unsigned sched_restarts; /* times the scheduler had to back up */
+	unsigned sched_nodes_undone; /* scheduled nodes thrown away when it did */
+	
+	/* nodes, dependencies, instructions, and their sets are allocated here */
+	arena_t* arena;
 } lima_gp_ir_prog_t;
 
 #define gp_ir_prog_for_each_block(prog, block) \
@@ -686,7 +727,7 @@ void lima_gp_ir_prog_remove(
 	lima_gp_ir_block_t* block);
 bool lima_gp_ir_prog_calc_preds(lima_gp_ir_prog_t* prog);
 bool lima_gp_ir_prog_print(
-	lima_gp_ir_prog_t* prog, unsigned tabs, bool print_liveness);
+	lima_gp_ir_prog_t* prog, unsigned tabs, bool print_liveness, FILE* f);
 lima_gp_ir_prog_t* lima_gp_ir_prog_import(void* data, unsigned* size);
 void* lima_gp_ir_prog_export(lima_gp_ir_prog_t* prog, unsigned* size);
 
@@ -753,12 +794,14 @@ bool lima_gp_ir_liveness_compute_prog(lima_gp_ir_prog_t* prog, bool virt);
 /* Register allocation */
 
 bool lima_gp_ir_regalloc(lima_gp_ir_prog_t* prog);
+bool lima_gp_ir_regalloc_linear_scan(lima_gp_ir_prog_t* prog);
 
 
 /* Codegen */
 
+/* also fills in report, see lima_shader_report_t */
 void* lima_gp_ir_codegen(lima_gp_ir_prog_t* ir_prog, unsigned* size,
-	unsigned* attrib_prefetch);
+	unsigned* attrib_prefetch, lima_shader_report_t* report);
 
 /* Constant folding */
 
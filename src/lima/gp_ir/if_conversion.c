@@ -183,7 +183,8 @@ static lima_gp_ir_reg_t* create_condition_reg(lima_gp_ir_block_t* entry)
 	
 	reg->size = 1;
 	
-	lima_gp_ir_store_reg_node_t* store_node = lima_gp_ir_store_reg_node_create();
+	lima_gp_ir_store_reg_node_t* store_node =
+		lima_gp_ir_store_reg_node_create(entry->prog);
 	if (!store_node)
 	{
 		lima_gp_ir_reg_delete(reg);
@@ -210,7 +211,8 @@ static bool rewrite_phi_nodes(lima_gp_ir_block_t* exit,
 {
 	unsigned i;
 	
-	lima_gp_ir_load_reg_node_t* cond = lima_gp_ir_load_reg_node_create();
+	lima_gp_ir_load_reg_node_t* cond =
+		lima_gp_ir_load_reg_node_create(exit->prog);
 	if (!cond)
 		return false;
 	
@@ -235,7 +237,7 @@ static bool rewrite_phi_nodes(lima_gp_ir_block_t* exit,
 		}
 		
 		lima_gp_ir_store_reg_node_t* store_node =
-			lima_gp_ir_store_reg_node_create();
+			lima_gp_ir_store_reg_node_create(exit->prog);
 		if (!store_node)
 			return false;
 		
@@ -246,7 +248,7 @@ static bool rewrite_phi_nodes(lima_gp_ir_block_t* exit,
 		for (i = 0; i < phi_node->dest->size; i++)
 		{
 			lima_gp_ir_alu_node_t* select_node =
-				lima_gp_ir_alu_node_create(lima_gp_ir_op_select);
+				lima_gp_ir_alu_node_create(exit->prog, lima_gp_ir_op_select);
 			if (!select_node)
 			{
 				lima_gp_ir_node_delete(&store_node->root_node.node);
@@ -254,7 +256,7 @@ static bool rewrite_phi_nodes(lima_gp_ir_block_t* exit,
 			}
 			
 			lima_gp_ir_load_reg_node_t* pred1_load =
-				lima_gp_ir_load_reg_node_create();
+				lima_gp_ir_load_reg_node_create(exit->prog);
 			if (!pred1_load)
 			{
 				lima_gp_ir_node_delete(&store_node->root_node.node);
@@ -263,7 +265,7 @@ static bool rewrite_phi_nodes(lima_gp_ir_block_t* exit,
 			}
 			
 			lima_gp_ir_load_reg_node_t* pred2_load =
-				lima_gp_ir_load_reg_node_create();
+				lima_gp_ir_load_reg_node_create(exit->prog);
 			if (!pred2_load)
 			{
 				lima_gp_ir_node_delete(&store_node->root_node.node);
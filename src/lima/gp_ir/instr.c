@@ -50,7 +50,9 @@ static const lima_gp_ir_instr_t empty_instr = {
 	.num_unscheduled_store_children = 0,
 	
 	.complex_slot = NULL,
-	.pass_slot = NULL
+	.pass_slot = NULL,
+	
+	.sched_epoch = 0
 };
 
 void lima_gp_ir_instr_init(lima_gp_ir_instr_t* instr)
@@ -58,9 +60,10 @@ void lima_gp_ir_instr_init(lima_gp_ir_instr_t* instr)
 	*instr = empty_instr;
 }
 
-lima_gp_ir_instr_t* lima_gp_ir_instr_create(void)
+lima_gp_ir_instr_t* lima_gp_ir_instr_create(lima_gp_ir_prog_t* prog)
 {
-	lima_gp_ir_instr_t* instr = malloc(sizeof(lima_gp_ir_instr_t));
+	lima_gp_ir_instr_t* instr = arena_alloc(prog->arena,
+											sizeof(lima_gp_ir_instr_t));
 	if (!instr)
 		return NULL;
 	
@@ -672,5 +675,5 @@ void lima_gp_ir_instr_delete(lima_gp_ir_instr_t* instr)
 {
 	list_del(&instr->instr_list);
 	instr->block->num_instrs--;
-	free(instr);
+	arena_free(instr->block->prog->arena, instr, sizeof(lima_gp_ir_instr_t));
 }
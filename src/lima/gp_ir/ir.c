@@ -36,7 +36,7 @@
 	if (!lima_gp_ir_lower_prog(prog->prog))
 		return NULL;
 	
-	if (!lima_gp_ir_prog_print(prog->prog, 0, false))
+	if (!lima_gp_ir_prog_print(prog->prog, 0, false, stdout))
 		return false;
 	
 	if (!lima_gp_ir_const_fold_prog(prog->prog))
@@ -49,25 +49,25 @@
 	if (!lima_gp_ir_convert_to_ssa(prog->prog))
 		return NULL;
 	
-	if (!lima_gp_ir_prog_print(prog->prog, 0, false))
+	if (!lima_gp_ir_prog_print(prog->prog, 0, false, stdout))
 		return NULL;
 	
 	if (!lima_gp_ir_if_convert(prog->prog))
 		return NULL;
 	
-	if (!lima_gp_ir_prog_print(prog->prog, 0, false))
+	if (!lima_gp_ir_prog_print(prog->prog, 0, false, stdout))
 		return NULL;
 	
 	if (!lima_gp_ir_dead_code_eliminate(prog->prog))
 		return NULL;
 	
-	if (!lima_gp_ir_prog_print(prog->prog, 0, false))
+	if (!lima_gp_ir_prog_print(prog->prog, 0, false, stdout))
 		return NULL;
 	
 	if (!lima_gp_ir_reg_eliminate(prog->prog))
 		return NULL;
 	
-	if (!lima_gp_ir_prog_print(prog->prog, 0, false))
+	if (!lima_gp_ir_prog_print(prog->prog, 0, false, stdout))
 		return NULL;
 	
 	if (!lima_gp_ir_eliminate_phi_nodes(prog->prog))
@@ -76,7 +76,7 @@
 	if (!lima_gp_ir_liveness_compute_prog(prog->prog, true))
 		return NULL;
 	
-	if (!lima_gp_ir_prog_print(prog->prog, 0, true))
+	if (!lima_gp_ir_prog_print(prog->prog, 0, true, stdout))
 		return NULL;
 	
 	if (!lima_gp_ir_regalloc(prog->prog))
@@ -85,7 +85,7 @@
 	if (!lima_gp_ir_lower_prog(prog->prog))
 		return NULL;
 	
-	if (!lima_gp_ir_prog_print(prog->prog, 0, false))
+	if (!lima_gp_ir_prog_print(prog->prog, 0, false, stdout))
 		return NULL;
 	
 	if (!lima_gp_ir_prog_calc_dependencies(prog->prog))
@@ -31,7 +31,7 @@ typedef lima_gp_ir_node_t* (*lower_cb)(lima_gp_ir_node_t* orig);
 static lima_gp_ir_node_t* lower_abs(lima_gp_ir_node_t* orig)
 {
 	lima_gp_ir_alu_node_t* node =
-		lima_gp_ir_alu_node_create(lima_gp_ir_op_max);
+		lima_gp_ir_alu_node_create(orig->prog, lima_gp_ir_op_max);
 	
 	if (!node)
 		return NULL;
@@ -49,12 +49,12 @@ static lima_gp_ir_node_t* lower_abs(lima_gp_ir_node_t* orig)
 static lima_gp_ir_node_t* lower_not(lima_gp_ir_node_t* orig)
 {
 	lima_gp_ir_alu_node_t* node =
-		lima_gp_ir_alu_node_create(lima_gp_ir_op_max);
+		lima_gp_ir_alu_node_create(orig->prog, lima_gp_ir_op_max);
 	
 	if (!node)
 		return NULL;
 	
-	lima_gp_ir_const_node_t* const_one = lima_gp_ir_const_node_create();
+	lima_gp_ir_const_node_t* const_one = lima_gp_ir_const_node_create(orig->prog);
 	
 	if (!const_one)
 	{
@@ -79,13 +79,13 @@ static lima_gp_ir_node_t* lower_not(lima_gp_ir_node_t* orig)
 static lima_gp_ir_node_t* lower_div(lima_gp_ir_node_t* orig)
 {
 	lima_gp_ir_alu_node_t* mul =
-		lima_gp_ir_alu_node_create(lima_gp_ir_op_mul);
+		lima_gp_ir_alu_node_create(orig->prog, lima_gp_ir_op_mul);
 	
 	if (!mul)
 		return NULL;
 	
 	lima_gp_ir_alu_node_t* rcp =
-		lima_gp_ir_alu_node_create(lima_gp_ir_op_rcp);
+		lima_gp_ir_alu_node_create(orig->prog, lima_gp_ir_op_rcp);
 	
 	if (!rcp)
 	{
@@ -110,13 +110,13 @@ static lima_gp_ir_node_t* lower_div(lima_gp_ir_node_t* orig)
 static lima_gp_ir_node_t* lower_mod(lima_gp_ir_node_t* orig)
 {
 	lima_gp_ir_alu_node_t* div =
-		lima_gp_ir_alu_node_create(lima_gp_ir_op_div);
+		lima_gp_ir_alu_node_create(orig->prog, lima_gp_ir_op_div);
 	
 	if (!div)
 		return NULL;
 	
 	lima_gp_ir_alu_node_t* fract =
-		lima_gp_ir_alu_node_create(lima_gp_ir_op_fract);
+		lima_gp_ir_alu_node_create(orig->prog, lima_gp_ir_op_fract);
 	
 	if (!fract)
 	{
@@ -125,7 +125,7 @@ static lima_gp_ir_node_t* lower_mod(lima_gp_ir_node_t* orig)
 	}
 	
 	lima_gp_ir_alu_node_t* mul =
-		lima_gp_ir_alu_node_create(lima_gp_ir_op_mul);
+		lima_gp_ir_alu_node_create(orig->prog, lima_gp_ir_op_mul);
 	
 	if (!mul)
 	{
@@ -156,13 +156,13 @@ static lima_gp_ir_node_t* lower_mod(lima_gp_ir_node_t* orig)
 static lima_gp_ir_node_t* lower_lrp(lima_gp_ir_node_t* orig)
 {
 	lima_gp_ir_alu_node_t* mul1 =
-		lima_gp_ir_alu_node_create(lima_gp_ir_op_mul);
+		lima_gp_ir_alu_node_create(orig->prog, lima_gp_ir_op_mul);
 	
 	if (!mul1)
 		return NULL;
 	
 	lima_gp_ir_alu_node_t* mul2 =
-		lima_gp_ir_alu_node_create(lima_gp_ir_op_mul);
+		lima_gp_ir_alu_node_create(orig->prog, lima_gp_ir_op_mul);
 	
 	if (!mul2)
 	{
@@ -170,7 +170,7 @@ static lima_gp_ir_node_t* lower_lrp(lima_gp_ir_node_t* orig)
 		return NULL;
 	}
 	
-	lima_gp_ir_const_node_t* one = lima_gp_ir_const_node_create();
+	lima_gp_ir_const_node_t* one = lima_gp_ir_const_node_create(orig->prog);
 	
 	if (!one)
 	{
@@ -182,7 +182,7 @@ static lima_gp_ir_node_t* lower_lrp(lima_gp_ir_node_t* orig)
 	one->constant = 1.0f;
 	
 	lima_gp_ir_alu_node_t* sub =
-		lima_gp_ir_alu_node_create(lima_gp_ir_op_add);
+		lima_gp_ir_alu_node_create(orig->prog, lima_gp_ir_op_add);
 	
 	if (!sub)
 	{
@@ -193,7 +193,7 @@ static lima_gp_ir_node_t* lower_lrp(lima_gp_ir_node_t* orig)
 	}
 	
 	lima_gp_ir_alu_node_t* add =
-		lima_gp_ir_alu_node_create(lima_gp_ir_op_add);
+		lima_gp_ir_alu_node_create(orig->prog, lima_gp_ir_op_add);
 	
 	if (!add)
 	{
@@ -234,7 +234,7 @@ static lima_gp_ir_node_t* lower_complex(lima_gp_ir_node_t* child,
 										lima_gp_ir_op_e impl_op)
 {
 	lima_gp_ir_alu_node_t* complex2_node =
-		lima_gp_ir_alu_node_create(lima_gp_ir_op_complex2);
+		lima_gp_ir_alu_node_create(child->prog, lima_gp_ir_op_complex2);
 	if (!complex2_node)
 		return NULL;
 	
@@ -242,7 +242,7 @@ static lima_gp_ir_node_t* lower_complex(lima_gp_ir_node_t* child,
 	lima_gp_ir_node_link(&complex2_node->node, child);
 	
 	lima_gp_ir_alu_node_t* impl_node =
-		lima_gp_ir_alu_node_create(impl_op);
+		lima_gp_ir_alu_node_create(child->prog, impl_op);
 	if (!impl_node)
 	{
 		lima_gp_ir_node_delete(&complex2_node->node);
@@ -253,7 +253,7 @@ static lima_gp_ir_node_t* lower_complex(lima_gp_ir_node_t* child,
 	lima_gp_ir_node_link(&impl_node->node, child);
 	
 	lima_gp_ir_alu_node_t* complex1_node =
-		lima_gp_ir_alu_node_create(lima_gp_ir_op_complex1);
+		lima_gp_ir_alu_node_create(child->prog, lima_gp_ir_op_complex1);
 	if (!complex1_node)
 	{
 		lima_gp_ir_node_delete(&complex2_node->node);
@@ -277,7 +277,7 @@ static lima_gp_ir_node_t* lower_exp2(lima_gp_ir_node_t* orig)
 	lima_gp_ir_node_t* child = orig_alu->children[0];
 	
 	lima_gp_ir_alu_node_t* preexp2_node =
-		lima_gp_ir_alu_node_create(lima_gp_ir_op_preexp2);
+		lima_gp_ir_alu_node_create(orig->prog, lima_gp_ir_op_preexp2);
 	if (!preexp2_node)
 		return NULL;
 	
@@ -301,7 +301,7 @@ static lima_gp_ir_node_t* lower_log2(lima_gp_ir_node_t* orig)
 	lima_gp_ir_node_t* child = orig_alu->children[0];
 	
 	lima_gp_ir_alu_node_t* postlog2_node =
-		lima_gp_ir_alu_node_create(lima_gp_ir_op_postlog2);
+		lima_gp_ir_alu_node_create(orig->prog, lima_gp_ir_op_postlog2);
 	if (!postlog2_node)
 		return NULL;
 	
@@ -343,12 +343,12 @@ static lima_gp_ir_node_t* lower_ceil(lima_gp_ir_node_t* orig)
 	lima_gp_ir_node_t* child = orig_alu->children[0];
 	
 	lima_gp_ir_alu_node_t* floor_node =
-		lima_gp_ir_alu_node_create(lima_gp_ir_op_floor);
+		lima_gp_ir_alu_node_create(orig->prog, lima_gp_ir_op_floor);
 	if (!floor_node)
 		return NULL;
 	
 	lima_gp_ir_alu_node_t* neg_node =
-		lima_gp_ir_alu_node_create(lima_gp_ir_op_neg);
+		lima_gp_ir_alu_node_create(orig->prog, lima_gp_ir_op_neg);
 	if (!neg_node)
 	{
 		lima_gp_ir_node_delete(&floor_node->node);
@@ -372,12 +372,12 @@ static lima_gp_ir_node_t* lower_fract(lima_gp_ir_node_t* orig)
 	lima_gp_ir_node_t* child = orig_alu->children[0];
 	
 	lima_gp_ir_alu_node_t* floor_node =
-	lima_gp_ir_alu_node_create(lima_gp_ir_op_floor);
+	lima_gp_ir_alu_node_create(orig->prog, lima_gp_ir_op_floor);
 	if (!floor_node)
 		return NULL;
 	
 	lima_gp_ir_alu_node_t* sub_node =
-		lima_gp_ir_alu_node_create(lima_gp_ir_op_add);
+		lima_gp_ir_alu_node_create(orig->prog, lima_gp_ir_op_add);
 	if (!sub_node)
 	{
 		lima_gp_ir_node_delete(&floor_node->node);
@@ -404,14 +404,14 @@ static lima_gp_ir_node_t* lower_exp(lima_gp_ir_node_t* orig)
 	lima_gp_ir_alu_node_t* orig_alu = gp_ir_node_to_alu(orig);
 	lima_gp_ir_node_t* child = orig_alu->children[0];
 	
-	lima_gp_ir_const_node_t* log2e = lima_gp_ir_const_node_create();
+	lima_gp_ir_const_node_t* log2e = lima_gp_ir_const_node_create(orig->prog);
 	if (!log2e)
 		return NULL;
 	
 	log2e->constant = M_LOG2E;
 	
 	lima_gp_ir_alu_node_t* mul_node =
-		lima_gp_ir_alu_node_create(lima_gp_ir_op_mul);
+		lima_gp_ir_alu_node_create(orig->prog, lima_gp_ir_op_mul);
 	if (!mul_node)
 	{
 		lima_gp_ir_node_delete(&log2e->node);
@@ -424,7 +424,7 @@ static lima_gp_ir_node_t* lower_exp(lima_gp_ir_node_t* orig)
 	lima_gp_ir_node_link(&mul_node->node, &log2e->node);
 	
 	lima_gp_ir_alu_node_t* exp2_node =
-		lima_gp_ir_alu_node_create(lima_gp_ir_op_exp2);
+		lima_gp_ir_alu_node_create(orig->prog, lima_gp_ir_op_exp2);
 	if (!exp2_node)
 	{
 		lima_gp_ir_node_delete(&log2e->node);
@@ -444,14 +444,14 @@ static lima_gp_ir_node_t* lower_log(lima_gp_ir_node_t* orig)
 	lima_gp_ir_alu_node_t* orig_alu = gp_ir_node_to_alu(orig);
 	lima_gp_ir_node_t* child = orig_alu->children[0];
 	
-	lima_gp_ir_const_node_t* ln2 = lima_gp_ir_const_node_create();
+	lima_gp_ir_const_node_t* ln2 = lima_gp_ir_const_node_create(orig->prog);
 	if (!ln2)
 		return NULL;
 	
 	ln2->constant = M_LN2;
 	
 	lima_gp_ir_alu_node_t* log2_node =
-		lima_gp_ir_alu_node_create(lima_gp_ir_op_log2);
+		lima_gp_ir_alu_node_create(orig->prog, lima_gp_ir_op_log2);
 	if (!log2_node)
 	{
 		lima_gp_ir_node_delete(&ln2->node);
@@ -462,7 +462,7 @@ static lima_gp_ir_node_t* lower_log(lima_gp_ir_node_t* orig)
 	lima_gp_ir_node_link(&log2_node->node, child);
 	
 	lima_gp_ir_alu_node_t* mul_node =
-		lima_gp_ir_alu_node_create(lima_gp_ir_op_mul);
+		lima_gp_ir_alu_node_create(orig->prog, lima_gp_ir_op_mul);
 	if (!mul_node)
 	{
 		lima_gp_ir_node_delete(&ln2->node);
@@ -486,12 +486,12 @@ static lima_gp_ir_node_t* lower_pow(lima_gp_ir_node_t* orig)
 	lima_gp_ir_node_t* exponent = orig_alu->children[1];
 	
 	lima_gp_ir_alu_node_t* log2_node =
-		lima_gp_ir_alu_node_create(lima_gp_ir_op_log2);
+		lima_gp_ir_alu_node_create(orig->prog, lima_gp_ir_op_log2);
 	if (!log2_node)
 		return NULL;
 	
 	lima_gp_ir_alu_node_t* mul_node =
-		lima_gp_ir_alu_node_create(lima_gp_ir_op_mul);
+		lima_gp_ir_alu_node_create(orig->prog, lima_gp_ir_op_mul);
 	if (!mul_node)
 	{
 		lima_gp_ir_node_delete(&log2_node->node);
@@ -499,7 +499,7 @@ static lima_gp_ir_node_t* lower_pow(lima_gp_ir_node_t* orig)
 	}
 	
 	lima_gp_ir_alu_node_t* exp2_node =
-		lima_gp_ir_alu_node_create(lima_gp_ir_op_exp2);
+		lima_gp_ir_alu_node_create(orig->prog, lima_gp_ir_op_exp2);
 	if (!mul_node)
 	{
 		lima_gp_ir_node_delete(&log2_node->node);
@@ -530,7 +530,7 @@ static lima_gp_ir_node_t* lower_sqrt(lima_gp_ir_node_t* orig)
 	lima_gp_ir_node_t* child = orig_alu->children[0];
 	
 	lima_gp_ir_alu_node_t* rsqrt_node =
-		lima_gp_ir_alu_node_create(lima_gp_ir_op_rsqrt);
+		lima_gp_ir_alu_node_create(orig->prog, lima_gp_ir_op_rsqrt);
 	if (!rsqrt_node)
 		return NULL;
 	
@@ -538,7 +538,7 @@ static lima_gp_ir_node_t* lower_sqrt(lima_gp_ir_node_t* orig)
 	lima_gp_ir_node_link(&rsqrt_node->node, child);
 	
 	lima_gp_ir_alu_node_t* rcp_node =
-		lima_gp_ir_alu_node_create(lima_gp_ir_op_rcp);
+		lima_gp_ir_alu_node_create(orig->prog, lima_gp_ir_op_rcp);
 	if (!rcp_node)
 	{
 		lima_gp_ir_node_delete(&rsqrt_node->node);
@@ -600,7 +600,7 @@ static const float sin_coefficients[] = {
 static lima_gp_ir_node_t* build_sin_series(lima_gp_ir_node_t* input)
 {
 	lima_gp_ir_alu_node_t* square_alu =
-		lima_gp_ir_alu_node_create(lima_gp_ir_op_mul);
+		lima_gp_ir_alu_node_create(input->prog, lima_gp_ir_op_mul);
 	if (!square_alu)
 		return NULL;
 	
@@ -615,13 +615,13 @@ static lima_gp_ir_node_t* build_sin_series(lima_gp_ir_node_t* input)
 	unsigned i = 0;
 	while (true)
 	{
-		lima_gp_ir_const_node_t* const_term = lima_gp_ir_const_node_create();
+		lima_gp_ir_const_node_t* const_term = lima_gp_ir_const_node_create(input->prog);
 		if (!const_term)
 			return NULL;
 		const_term->constant = sin_coefficients[i];
 		
 		lima_gp_ir_alu_node_t* term =
-			lima_gp_ir_alu_node_create(lima_gp_ir_op_mul);
+			lima_gp_ir_alu_node_create(input->prog, lima_gp_ir_op_mul);
 		if (!term)
 		{
 			lima_gp_ir_node_delete(&const_term->node);
@@ -638,7 +638,7 @@ static lima_gp_ir_node_t* build_sin_series(lima_gp_ir_node_t* input)
 		else
 		{
 			lima_gp_ir_alu_node_t* next_sum =
-				lima_gp_ir_alu_node_create(lima_gp_ir_op_add);
+				lima_gp_ir_alu_node_create(input->prog, lima_gp_ir_op_add);
 			if (!next_sum)
 			{
 				lima_gp_ir_node_delete(&term->node);
@@ -657,7 +657,7 @@ static lima_gp_ir_node_t* build_sin_series(lima_gp_ir_node_t* input)
 			break;
 		
 		lima_gp_ir_alu_node_t* next_x_term =
-			lima_gp_ir_alu_node_create(lima_gp_ir_op_mul);
+			lima_gp_ir_alu_node_create(input->prog, lima_gp_ir_op_mul);
 		if (!next_x_term)
 			return NULL;
 		
@@ -677,13 +677,13 @@ static lima_gp_ir_node_t* build_sin_series(lima_gp_ir_node_t* input)
 
 static lima_gp_ir_node_t* build_sin_input(lima_gp_ir_node_t* input)
 {
-	lima_gp_ir_const_node_t* two_pi = lima_gp_ir_const_node_create();
+	lima_gp_ir_const_node_t* two_pi = lima_gp_ir_const_node_create(input->prog);
 	if (!two_pi)
 		return NULL;
 	
 	two_pi->constant = 1.0 / (2.0 * M_PI);
 	
-	lima_gp_ir_const_node_t* one_fourth = lima_gp_ir_const_node_create();
+	lima_gp_ir_const_node_t* one_fourth = lima_gp_ir_const_node_create(input->prog);
 	if (!one_fourth)
 	{
 		lima_gp_ir_node_delete(&two_pi->node);
@@ -692,7 +692,7 @@ static lima_gp_ir_node_t* build_sin_input(lima_gp_ir_node_t* input)
 	
 	one_fourth->constant = .25;
 	
-	lima_gp_ir_const_node_t* three_fourths = lima_gp_ir_const_node_create();
+	lima_gp_ir_const_node_t* three_fourths = lima_gp_ir_const_node_create(input->prog);
 	if (!three_fourths)
 	{
 		lima_gp_ir_node_delete(&two_pi->node);
@@ -704,7 +704,7 @@ static lima_gp_ir_node_t* build_sin_input(lima_gp_ir_node_t* input)
 	
 	// = x/(2*pi)
 	lima_gp_ir_alu_node_t* x_over_two_pi =
-		lima_gp_ir_alu_node_create(lima_gp_ir_op_mul);
+		lima_gp_ir_alu_node_create(input->prog, lima_gp_ir_op_mul);
 	if (!x_over_two_pi)
 	{
 		lima_gp_ir_node_delete(&two_pi->node);
@@ -720,7 +720,7 @@ static lima_gp_ir_node_t* build_sin_input(lima_gp_ir_node_t* input)
 	
 	// = x/(2*pi) + 3/4
 	lima_gp_ir_alu_node_t* inner_floor =
-		lima_gp_ir_alu_node_create(lima_gp_ir_op_add);
+		lima_gp_ir_alu_node_create(input->prog, lima_gp_ir_op_add);
 	if (!inner_floor)
 	{
 		lima_gp_ir_node_delete(&x_over_two_pi->node);
@@ -736,7 +736,7 @@ static lima_gp_ir_node_t* build_sin_input(lima_gp_ir_node_t* input)
 	
 	// = floor(x/(2*pi) + 3/4)
 	lima_gp_ir_alu_node_t* floor =
-		lima_gp_ir_alu_node_create(lima_gp_ir_op_floor);
+		lima_gp_ir_alu_node_create(input->prog, lima_gp_ir_op_floor);
 	if (!floor)
 	{
 		lima_gp_ir_node_delete(&inner_floor->node);
@@ -749,7 +749,7 @@ static lima_gp_ir_node_t* build_sin_input(lima_gp_ir_node_t* input)
 	
 	// = x/(2*pi) - floor(x/(2*pi) + 3/4)
 	lima_gp_ir_alu_node_t* sum_one =
-		lima_gp_ir_alu_node_create(lima_gp_ir_op_add);
+		lima_gp_ir_alu_node_create(input->prog, lima_gp_ir_op_add);
 	if (!sum_one)
 	{
 		lima_gp_ir_node_delete(&floor->node);
@@ -765,7 +765,7 @@ static lima_gp_ir_node_t* build_sin_input(lima_gp_ir_node_t* input)
 	
 	// = x/(2*pi) - floor(x/(2*pi) + 3/4) + 1/4
 	lima_gp_ir_alu_node_t* sum_two =
-		lima_gp_ir_alu_node_create(lima_gp_ir_op_add);
+		lima_gp_ir_alu_node_create(input->prog, lima_gp_ir_op_add);
 	if (!sum_two)
 	{
 		lima_gp_ir_node_delete(&sum_one->node);
@@ -779,7 +779,7 @@ static lima_gp_ir_node_t* build_sin_input(lima_gp_ir_node_t* input)
 	lima_gp_ir_node_link(&sum_two->node, &one_fourth->node);
 	
 	// = abs(x/(2*pi) - floor(x/(2*pi) + 3/4) + 1/4)
-	lima_gp_ir_alu_node_t* abs = lima_gp_ir_alu_node_create(lima_gp_ir_op_max);
+	lima_gp_ir_alu_node_t* abs = lima_gp_ir_alu_node_create(input->prog, lima_gp_ir_op_max);
 	if (!abs)
 	{
 		lima_gp_ir_node_delete(&sum_two->node);
@@ -793,7 +793,7 @@ static lima_gp_ir_node_t* build_sin_input(lima_gp_ir_node_t* input)
 	
 	// = abs(x/(2*pi) - floor(x/(2*pi) + 3/4) + 1/4) - 1/4
 	lima_gp_ir_alu_node_t* result =
-		lima_gp_ir_alu_node_create(lima_gp_ir_op_add);
+		lima_gp_ir_alu_node_create(input->prog, lima_gp_ir_op_add);
 	if (!result)
 	{
 		lima_gp_ir_node_delete(&abs->node);
@@ -813,13 +813,13 @@ static lima_gp_ir_node_t* build_sin_input(lima_gp_ir_node_t* input)
 
 static lima_gp_ir_node_t* build_cos_input(lima_gp_ir_node_t* input)
 {
-	lima_gp_ir_const_node_t* two_pi = lima_gp_ir_const_node_create();
+	lima_gp_ir_const_node_t* two_pi = lima_gp_ir_const_node_create(input->prog);
 	if (!two_pi)
 		return NULL;
 	
 	two_pi->constant = 1.0 / (2.0 * M_PI);
 	
-	lima_gp_ir_const_node_t* one_half = lima_gp_ir_const_node_create();
+	lima_gp_ir_const_node_t* one_half = lima_gp_ir_const_node_create(input->prog);
 	if (!one_half)
 	{
 		lima_gp_ir_node_delete(&two_pi->node);
@@ -828,7 +828,7 @@ static lima_gp_ir_node_t* build_cos_input(lima_gp_ir_node_t* input)
 	
 	one_half->constant = .5;
 	
-	lima_gp_ir_const_node_t* neg_one_fourth = lima_gp_ir_const_node_create();
+	lima_gp_ir_const_node_t* neg_one_fourth = lima_gp_ir_const_node_create(input->prog);
 	if (!neg_one_fourth)
 	{
 		lima_gp_ir_node_delete(&two_pi->node);
@@ -840,7 +840,7 @@ static lima_gp_ir_node_t* build_cos_input(lima_gp_ir_node_t* input)
 	
 	// = x/(2*pi)
 	lima_gp_ir_alu_node_t* x_over_two_pi =
-		lima_gp_ir_alu_node_create(lima_gp_ir_op_mul);
+		lima_gp_ir_alu_node_create(input->prog, lima_gp_ir_op_mul);
 	if (!x_over_two_pi)
 	{
 		lima_gp_ir_node_delete(&two_pi->node);
@@ -856,7 +856,7 @@ static lima_gp_ir_node_t* build_cos_input(lima_gp_ir_node_t* input)
 	
 	// = floor(-x/(2*pi))
 	lima_gp_ir_alu_node_t* floor =
-		lima_gp_ir_alu_node_create(lima_gp_ir_op_floor);
+		lima_gp_ir_alu_node_create(input->prog, lima_gp_ir_op_floor);
 	if (!floor)
 	{
 		lima_gp_ir_node_delete(&x_over_two_pi->node);
@@ -871,7 +871,7 @@ static lima_gp_ir_node_t* build_cos_input(lima_gp_ir_node_t* input)
 	
 	// = x/(2*pi) + floor(-x/(2*pi))
 	lima_gp_ir_alu_node_t* sum_one =
-		lima_gp_ir_alu_node_create(lima_gp_ir_op_add);
+		lima_gp_ir_alu_node_create(input->prog, lima_gp_ir_op_add);
 	if (!sum_one)
 	{
 		lima_gp_ir_node_delete(&floor->node);
@@ -887,7 +887,7 @@ static lima_gp_ir_node_t* build_cos_input(lima_gp_ir_node_t* input)
 
 	// = x/(2*pi) + floor(-x/(2*pi)) + 1/2
 	lima_gp_ir_alu_node_t* sum_two =
-		lima_gp_ir_alu_node_create(lima_gp_ir_op_add);
+		lima_gp_ir_alu_node_create(input->prog, lima_gp_ir_op_add);
 	if (!sum_two)
 	{
 		lima_gp_ir_node_delete(&sum_one->node);
@@ -902,7 +902,7 @@ static lima_gp_ir_node_t* build_cos_input(lima_gp_ir_node_t* input)
 	lima_gp_ir_node_link(&sum_two->node, &one_half->node);
 	
 	// = abs(x/(2*pi) + floor(-x/(2*pi)) + 1/2)
-	lima_gp_ir_alu_node_t* abs = lima_gp_ir_alu_node_create(lima_gp_ir_op_max);
+	lima_gp_ir_alu_node_t* abs = lima_gp_ir_alu_node_create(input->prog, lima_gp_ir_op_max);
 	if (!abs)
 	{
 		lima_gp_ir_node_delete(&sum_two->node);
@@ -917,7 +917,7 @@ static lima_gp_ir_node_t* build_cos_input(lima_gp_ir_node_t* input)
 	
 	// = abs(x/(2*pi) + floor(-x/(2*pi)) + 1/2) - 1/4
 	lima_gp_ir_alu_node_t* result =
-		lima_gp_ir_alu_node_create(lima_gp_ir_op_add);
+		lima_gp_ir_alu_node_create(input->prog, lima_gp_ir_op_add);
 	if (!result)
 	{
 		lima_gp_ir_node_delete(&abs->node);
@@ -979,7 +979,7 @@ static lima_gp_ir_node_t* lower_tan(lima_gp_ir_node_t* orig)
 	lima_gp_ir_node_t* child = orig_alu->children[0];
 	
 	lima_gp_ir_alu_node_t* sin_node =
-		lima_gp_ir_alu_node_create(lima_gp_ir_op_sin);
+		lima_gp_ir_alu_node_create(orig->prog, lima_gp_ir_op_sin);
 	if (!sin_node)
 		return NULL;
 	
@@ -987,7 +987,7 @@ static lima_gp_ir_node_t* lower_tan(lima_gp_ir_node_t* orig)
 	lima_gp_ir_node_link(&sin_node->node, child);
 	
 	lima_gp_ir_alu_node_t* cos_node =
-		lima_gp_ir_alu_node_create(lima_gp_ir_op_cos);
+		lima_gp_ir_alu_node_create(orig->prog, lima_gp_ir_op_cos);
 	if (!cos_node)
 	{
 		lima_gp_ir_node_delete(&sin_node->node);
@@ -998,7 +998,7 @@ static lima_gp_ir_node_t* lower_tan(lima_gp_ir_node_t* orig)
 	lima_gp_ir_node_link(&cos_node->node, child);
 	
 	lima_gp_ir_alu_node_t* rcp_node =
-		lima_gp_ir_alu_node_create(lima_gp_ir_op_rcp);
+		lima_gp_ir_alu_node_create(orig->prog, lima_gp_ir_op_rcp);
 	if (!rcp_node)
 	{
 		lima_gp_ir_node_delete(&sin_node->node);
@@ -1010,7 +1010,7 @@ static lima_gp_ir_node_t* lower_tan(lima_gp_ir_node_t* orig)
 	lima_gp_ir_node_link(&rcp_node->node, &cos_node->node);
 	
 	lima_gp_ir_alu_node_t* mul_node =
-		lima_gp_ir_alu_node_create(lima_gp_ir_op_mul);
+		lima_gp_ir_alu_node_create(orig->prog, lima_gp_ir_op_mul);
 	if (!mul_node)
 	{
 		lima_gp_ir_node_delete(&rcp_node->node);
@@ -1030,13 +1030,13 @@ static lima_gp_ir_node_t* lower_tan(lima_gp_ir_node_t* orig)
 static lima_gp_ir_node_t* lower_eq(lima_gp_ir_node_t* orig)
 {
 	lima_gp_ir_alu_node_t* ge1 =
-		lima_gp_ir_alu_node_create(lima_gp_ir_op_ge);
+		lima_gp_ir_alu_node_create(orig->prog, lima_gp_ir_op_ge);
 	
 	if (!ge1)
 		return NULL;
 	
 	lima_gp_ir_alu_node_t* ge2 =
-		lima_gp_ir_alu_node_create(lima_gp_ir_op_ge);
+		lima_gp_ir_alu_node_create(orig->prog, lima_gp_ir_op_ge);
 	
 	if (!ge2)
 	{
@@ -1045,7 +1045,7 @@ static lima_gp_ir_node_t* lower_eq(lima_gp_ir_node_t* orig)
 	}
 	
 	lima_gp_ir_alu_node_t* min =
-		lima_gp_ir_alu_node_create(lima_gp_ir_op_min);
+		lima_gp_ir_alu_node_create(orig->prog, lima_gp_ir_op_min);
 	
 	if (!min)
 	{
@@ -1078,13 +1078,13 @@ static lima_gp_ir_node_t* lower_eq(lima_gp_ir_node_t* orig)
 static lima_gp_ir_node_t* lower_ne(lima_gp_ir_node_t* orig)
 {
 	lima_gp_ir_alu_node_t* lt1 =
-		lima_gp_ir_alu_node_create(lima_gp_ir_op_lt);
+		lima_gp_ir_alu_node_create(orig->prog, lima_gp_ir_op_lt);
 	
 	if (!lt1)
 		return NULL;
 	
 	lima_gp_ir_alu_node_t* lt2 =
-		lima_gp_ir_alu_node_create(lima_gp_ir_op_lt);
+		lima_gp_ir_alu_node_create(orig->prog, lima_gp_ir_op_lt);
 	
 	if (!lt2)
 	{
@@ -1093,7 +1093,7 @@ static lima_gp_ir_node_t* lower_ne(lima_gp_ir_node_t* orig)
 	}
 	
 	lima_gp_ir_alu_node_t* max =
-		lima_gp_ir_alu_node_create(lima_gp_ir_op_max);
+		lima_gp_ir_alu_node_create(orig->prog, lima_gp_ir_op_max);
 	
 	if (!max)
 	{
@@ -1125,14 +1125,14 @@ static lima_gp_ir_node_t* lower_ne(lima_gp_ir_node_t* orig)
 //f2b(x) = ne(x, 0.0)
 static lima_gp_ir_node_t* lower_f2b(lima_gp_ir_node_t* orig)
 {
-	lima_gp_ir_const_node_t* zero = lima_gp_ir_const_node_create();
+	lima_gp_ir_const_node_t* zero = lima_gp_ir_const_node_create(orig->prog);
 	
 	if (!zero)
 		return NULL;
 	
 	zero->constant = 0.0f;
 	
-	lima_gp_ir_alu_node_t* ne = lima_gp_ir_alu_node_create(lima_gp_ir_op_ne);
+	lima_gp_ir_alu_node_t* ne = lima_gp_ir_alu_node_create(orig->prog, lima_gp_ir_op_ne);
 	
 	if (!ne)
 	{
@@ -1154,13 +1154,13 @@ static lima_gp_ir_node_t* lower_f2b(lima_gp_ir_node_t* orig)
 static lima_gp_ir_node_t* lower_f2i(lima_gp_ir_node_t* orig)
 {
 	lima_gp_ir_alu_node_t* sign =
-		lima_gp_ir_alu_node_create(lima_gp_ir_op_sign);
+		lima_gp_ir_alu_node_create(orig->prog, lima_gp_ir_op_sign);
 	
 	if (!sign)
 		return NULL;
 	
 	lima_gp_ir_alu_node_t* floor =
-		lima_gp_ir_alu_node_create(lima_gp_ir_op_floor);
+		lima_gp_ir_alu_node_create(orig->prog, lima_gp_ir_op_floor);
 	
 	if (!floor)
 	{
@@ -1168,7 +1168,7 @@ static lima_gp_ir_node_t* lower_f2i(lima_gp_ir_node_t* orig)
 		return NULL;
 	}
 	
-	lima_gp_ir_alu_node_t* abs = lima_gp_ir_alu_node_create(lima_gp_ir_op_abs);
+	lima_gp_ir_alu_node_t* abs = lima_gp_ir_alu_node_create(orig->prog, lima_gp_ir_op_abs);
 	
 	if (!abs)
 	{
@@ -1177,7 +1177,7 @@ static lima_gp_ir_node_t* lower_f2i(lima_gp_ir_node_t* orig)
 		return NULL;
 	}
 	
-	lima_gp_ir_alu_node_t* mul = lima_gp_ir_alu_node_create(lima_gp_ir_op_mul);
+	lima_gp_ir_alu_node_t* mul = lima_gp_ir_alu_node_create(orig->prog, lima_gp_ir_op_mul);
 	
 	if (!abs)
 	{
@@ -1303,7 +1303,7 @@ static bool lower_store_child(lima_gp_ir_node_t* node,
 	
 	//This opcode cannot be used directly, insert a move
 	lima_gp_ir_alu_node_t* mov_node =
-		lima_gp_ir_alu_node_create(lima_gp_ir_op_mov);
+		lima_gp_ir_alu_node_create(node->prog, lima_gp_ir_op_mov);
 	if (!mov_node)
 		return false;
 	
@@ -1328,7 +1328,7 @@ bool lima_gp_ir_lower_root_node(lima_gp_ir_root_node_t* node)
 	if (node->node.op == lima_gp_ir_op_branch_uncond)
 	{
 		//Convert unconditional branches to conditional branches
-		lima_gp_ir_const_node_t* cond = lima_gp_ir_const_node_create();
+		lima_gp_ir_const_node_t* cond = lima_gp_ir_const_node_create(node->node.prog);
 		if (!cond)
 			return false;
 		
@@ -1339,6 +1339,7 @@ bool lima_gp_ir_lower_root_node(lima_gp_ir_root_node_t* node)
 		lima_gp_ir_branch_node_t* branch_node =
 			gp_ir_node_to_branch(&node->node);
 		branch_node->condition = &cond->node;
+		branch_node->unconditional = true;
 		lima_gp_ir_node_link(&node->node, &cond->node);
 	}
 	
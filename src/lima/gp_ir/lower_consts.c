@@ -31,7 +31,8 @@ static bool lower_const_node(lima_gp_ir_const_node_t* const_node,
 													const_node->constant);
 	
 	lima_gp_ir_load_node_t* load =
-		lima_gp_ir_load_node_create(lima_gp_ir_op_load_uniform);
+		lima_gp_ir_load_node_create(const_node->node.prog,
+			lima_gp_ir_op_load_uniform);
 	
 	if (!load)
 		return false;
@@ -479,20 +479,21 @@ const lima_gp_ir_op_t lima_gp_ir_op[] = {
 	}
 };
 
-void lima_gp_ir_print_tabs(unsigned tabs)
+void lima_gp_ir_print_tabs(unsigned tabs, FILE* f)
 {
 	unsigned i;
 	for (i = 0; i < tabs; i++)
-		printf("\t");
+		fprintf(f, "\t");
 }
 
-lima_gp_ir_node_t* lima_gp_ir_node_create(lima_gp_ir_op_e op)
+lima_gp_ir_node_t* lima_gp_ir_node_create(lima_gp_ir_prog_t* prog,
+										  lima_gp_ir_op_e op)
 {
 	switch (lima_gp_ir_op[op].type)
 	{
 		case lima_gp_ir_node_type_alu:
 		{
-			lima_gp_ir_alu_node_t* node = lima_gp_ir_alu_node_create(op);
+			lima_gp_ir_alu_node_t* node = lima_gp_ir_alu_node_create(prog, op);
 			if (!node)
 				return NULL;
 			return &node->node;
@@ -501,7 +502,7 @@ lima_gp_ir_node_t* lima_gp_ir_node_create(lima_gp_ir_op_e op)
 		case lima_gp_ir_node_type_clamp_const:
 		{
 			lima_gp_ir_clamp_const_node_t* node =
-				lima_gp_ir_clamp_const_node_create();
+				lima_gp_ir_clamp_const_node_create(prog);
 			if (!node)
 				return NULL;
 			return &node->node;
@@ -509,7 +510,7 @@ lima_gp_ir_node_t* lima_gp_ir_node_create(lima_gp_ir_op_e op)
 			
 		case lima_gp_ir_node_type_const:
 		{
-			lima_gp_ir_const_node_t* node = lima_gp_ir_const_node_create();
+			lima_gp_ir_const_node_t* node = lima_gp_ir_const_node_create(prog);
 			if (!node)
 				return NULL;
 			
@@ -518,7 +519,7 @@ lima_gp_ir_node_t* lima_gp_ir_node_create(lima_gp_ir_op_e op)
 			
 		case lima_gp_ir_node_type_load:
 		{
-			lima_gp_ir_load_node_t* node = lima_gp_ir_load_node_create(op);
+			lima_gp_ir_load_node_t* node = lima_gp_ir_load_node_create(prog, op);
 			if (!node)
 				return NULL;
 			return &node->node;
@@ -527,7 +528,7 @@ lima_gp_ir_node_t* lima_gp_ir_node_create(lima_gp_ir_op_e op)
 		case lima_gp_ir_node_type_load_reg:
 		{
 			lima_gp_ir_load_reg_node_t* node =
-				lima_gp_ir_load_reg_node_create();
+				lima_gp_ir_load_reg_node_create(prog);
 			if (!node)
 				return NULL;
 			return &node->node;
@@ -535,7 +536,7 @@ lima_gp_ir_node_t* lima_gp_ir_node_create(lima_gp_ir_op_e op)
 			
 		case lima_gp_ir_node_type_store:
 		{
-			lima_gp_ir_store_node_t* node = lima_gp_ir_store_node_create(op);
+			lima_gp_ir_store_node_t* node = lima_gp_ir_store_node_create(prog, op);
 			if (!node)
 				return NULL;
 			return &node->root_node.node;
@@ -544,7 +545,7 @@ lima_gp_ir_node_t* lima_gp_ir_node_create(lima_gp_ir_op_e op)
 		case lima_gp_ir_node_type_store_reg:
 		{
 			lima_gp_ir_store_reg_node_t* node =
-				lima_gp_ir_store_reg_node_create();
+				lima_gp_ir_store_reg_node_create(prog);
 			if (!node)
 				return NULL;
 			return &node->root_node.node;
@@ -552,7 +553,7 @@ lima_gp_ir_node_t* lima_gp_ir_node_create(lima_gp_ir_op_e op)
 			
 		case lima_gp_ir_node_type_branch:
 		{
-			lima_gp_ir_branch_node_t* node = lima_gp_ir_branch_node_create(op);
+			lima_gp_ir_branch_node_t* node = lima_gp_ir_branch_node_create(prog, op);
 			if (!node)
 				return NULL;
 			return &node->root_node.node;
@@ -560,7 +561,7 @@ lima_gp_ir_node_t* lima_gp_ir_node_create(lima_gp_ir_op_e op)
 			
 		case lima_gp_ir_node_type_phi:
 		{
-			lima_gp_ir_phi_node_t* node = lima_gp_ir_phi_node_create(0);
+			lima_gp_ir_phi_node_t* node = lima_gp_ir_phi_node_create(prog, 0);
 			if (!node)
 				return NULL;
 			return &node->node;
@@ -573,18 +574,21 @@ lima_gp_ir_node_t* lima_gp_ir_node_create(lima_gp_ir_op_e op)
 	return NULL;
 }
 
-static bool node_init(lima_gp_ir_node_t* node, lima_gp_ir_op_e op)
+static bool node_init(lima_gp_ir_node_t* node, lima_gp_ir_prog_t* prog,
+					  lima_gp_ir_op_e op)
 {
 	node->op = op;
+	node->prog = prog;
 	node->successor = NULL;
+	node->sched_node.succs_left = 0;
 	
-	if (!ptrset_create(&node->parents))
+	if (!ptrset_create_arena(&node->parents, prog->arena))
 		return false;
 	
-	if (!ptrset_create(&node->succs))
+	if (!ptrset_create_arena(&node->succs, prog->arena))
 		return false;
 	
-	if (!ptrset_create(&node->preds))
+	if (!ptrset_create_arena(&node->preds, prog->arena))
 		return false;
 	
 	return true;
@@ -785,16 +789,16 @@ bool lima_gp_ir_node_replace(lima_gp_ir_node_t* old_node,
 	return true;
 }
 
-void lima_gp_ir_node_print(lima_gp_ir_node_t* node, unsigned tabs)
+void lima_gp_ir_node_print(lima_gp_ir_node_t* node, unsigned tabs, FILE* f)
 {
 	if (ptrset_size(node->parents) > 1)
 	{
 		//Nodes with more than one parent must be represented as expressions
-		lima_gp_ir_print_tabs(tabs);
-		printf("(expr expr_%u)", node->index);
+		lima_gp_ir_print_tabs(tabs, f);
+		fprintf(f, "(expr expr_%u)", node->index);
 	}
 	else
-		node->print(node, tabs);
+		node->print(node, tabs, f);
 }
 
 static void node_remove(lima_gp_ir_node_t* node)
@@ -823,7 +827,7 @@ static void node_remove(lima_gp_ir_node_t* node)
 	ptrset_iter_for_each(ptrset_iter, dep_info)
 	{
 		ptrset_remove(&dep_info->succ->preds, dep_info);
-		free(dep_info);
+		arena_free(node->prog->arena, dep_info, sizeof(lima_gp_ir_dep_info_t));
 	}
 	ptrset_delete(node->succs);
 	
@@ -831,7 +835,7 @@ static void node_remove(lima_gp_ir_node_t* node)
 	ptrset_iter_for_each(ptrset_iter, dep_info)
 	{
 		ptrset_remove(&dep_info->pred->succs, dep_info);
-		free(dep_info);
+		arena_free(node->prog->arena, dep_info, sizeof(lima_gp_ir_dep_info_t));
 	}
 	ptrset_delete(node->preds);
 }
@@ -977,26 +981,26 @@ static void alu_node_child_iter_next(lima_gp_ir_child_node_iter_t* iter)
 	}
 }
 
-static void alu_node_print(lima_gp_ir_node_t* node, unsigned tabs)
+static void alu_node_print(lima_gp_ir_node_t* node, unsigned tabs, FILE* f)
 {
 	lima_gp_ir_alu_node_t* alu_node = gp_ir_node_to_alu(node);
 	
-	lima_gp_ir_print_tabs(tabs);
-	printf("(");
+	lima_gp_ir_print_tabs(tabs, f);
+	fprintf(f, "(");
 	if (alu_node->dest_negate)
-		printf("-");
-	printf("%s", lima_gp_ir_op[node->op].name);
+		fprintf(f, "-");
+	fprintf(f, "%s", lima_gp_ir_op[node->op].name);
 	
 	unsigned i;
 	for (i = 0; i < lima_gp_ir_alu_node_num_children(node->op); i++)
 	{
-		printf("\n");
+		fprintf(f, "\n");
 		if (alu_node->children_negate[i])
-			printf("-");
-		lima_gp_ir_node_print(alu_node->children[i], tabs + 1);
+			fprintf(f, "-");
+		lima_gp_ir_node_print(alu_node->children[i], tabs + 1, f);
 	}
 	
-	printf(")");
+	fprintf(f, ")");
 }
 
 typedef struct
@@ -1018,7 +1022,7 @@ static void* alu_node_export(lima_gp_ir_node_t* node, lima_gp_ir_block_t* block,
 	
 	*size = sizeof(alu_node_data_t);
 	
-	alu_node_data_t* data = malloc(sizeof(alu_node_data_t));
+	alu_node_data_t* data = calloc(1, sizeof(alu_node_data_t));
 	if (!data)
 		return NULL;
 	
@@ -1062,17 +1066,19 @@ static bool alu_node_import(lima_gp_ir_node_t* node, lima_gp_ir_node_t** nodes,
 static void alu_node_delete(lima_gp_ir_node_t* node)
 {
 	lima_gp_ir_alu_node_t* alu_node = gp_ir_node_to_alu(node);
-	free(alu_node);
+	arena_free(node->prog->arena, alu_node, sizeof(lima_gp_ir_alu_node_t));
 }
 
-lima_gp_ir_alu_node_t* lima_gp_ir_alu_node_create(lima_gp_ir_op_e op)
+lima_gp_ir_alu_node_t* lima_gp_ir_alu_node_create(lima_gp_ir_prog_t* prog,
+												  lima_gp_ir_op_e op)
 {
-	lima_gp_ir_alu_node_t* alu_node = malloc(sizeof(lima_gp_ir_alu_node_t));
+	lima_gp_ir_alu_node_t* alu_node =
+		arena_alloc(prog->arena, sizeof(lima_gp_ir_alu_node_t));
 	if (!alu_node)
 		return NULL;
-	if (!node_init(&alu_node->node, op))
+	if (!node_init(&alu_node->node, prog, op))
 	{
-		free(alu_node);
+		arena_free(prog->arena, alu_node, sizeof(lima_gp_ir_alu_node_t));
 		return NULL;
 	}
 	
@@ -1092,19 +1098,19 @@ lima_gp_ir_alu_node_t* lima_gp_ir_alu_node_create(lima_gp_ir_op_e op)
 }
 
 
-static void clamp_const_node_print(lima_gp_ir_node_t* node, unsigned tabs)
+static void clamp_const_node_print(lima_gp_ir_node_t* node, unsigned tabs, FILE* f)
 {
 	lima_gp_ir_clamp_const_node_t* clamp_const_node =
 		gp_ir_node_to_clamp_const(node);
 	
-	lima_gp_ir_print_tabs(tabs);
-	printf("(clamp_const ");
+	lima_gp_ir_print_tabs(tabs, f);
+	fprintf(f, "(clamp_const ");
 	if (clamp_const_node->is_inline_const)
-		printf("inline %f %f\n", clamp_const_node->low, clamp_const_node->high);
+		fprintf(f, "inline %f %f\n", clamp_const_node->low, clamp_const_node->high);
 	else
-		printf("%u\n", clamp_const_node->uniform_index);
-	lima_gp_ir_node_print(clamp_const_node->child, tabs + 1);
-	printf(")");
+		fprintf(f, "%u\n", clamp_const_node->uniform_index);
+	lima_gp_ir_node_print(clamp_const_node->child, tabs + 1, f);
+	fprintf(f, ")");
 }
 
 typedef struct
@@ -1125,7 +1131,7 @@ static void* clamp_const_node_export(lima_gp_ir_node_t* node,
 	lima_gp_ir_clamp_const_node_t* clamp_const_node =
 		gp_ir_node_to_clamp_const(node);
 	
-	clamp_const_node_data_t* data = malloc(sizeof(clamp_const_node_data_t));
+	clamp_const_node_data_t* data = calloc(1, sizeof(clamp_const_node_data_t));
 	if (!data)
 		return NULL;
 	
@@ -1186,17 +1192,20 @@ static void clamp_const_node_delete(lima_gp_ir_node_t* node)
 	lima_gp_ir_clamp_const_node_t* clamp_const_node =
 		gp_ir_node_to_clamp_const(node);
 	
-	free(clamp_const_node);
+	arena_free(node->prog->arena, clamp_const_node,
+			   sizeof(lima_gp_ir_clamp_const_node_t));
 }
 
-lima_gp_ir_clamp_const_node_t* lima_gp_ir_clamp_const_node_create()
+lima_gp_ir_clamp_const_node_t* lima_gp_ir_clamp_const_node_create(
+	lima_gp_ir_prog_t* prog)
 {
 	lima_gp_ir_clamp_const_node_t* clamp_const_node =
-		malloc(sizeof(lima_gp_ir_clamp_const_node_t));
+		arena_alloc(prog->arena, sizeof(lima_gp_ir_clamp_const_node_t));
 	
-	if (!node_init(&clamp_const_node->node, lima_gp_ir_op_clamp_const))
+	if (!node_init(&clamp_const_node->node, prog, lima_gp_ir_op_clamp_const))
 	{
-		free(clamp_const_node);
+		arena_free(prog->arena, clamp_const_node,
+				   sizeof(lima_gp_ir_clamp_const_node_t));
 		return NULL;
 	}
 	
@@ -1213,12 +1222,12 @@ lima_gp_ir_clamp_const_node_t* lima_gp_ir_clamp_const_node_create()
 }
 
 
-static void const_node_print(lima_gp_ir_node_t* node, unsigned tabs)
+static void const_node_print(lima_gp_ir_node_t* node, unsigned tabs, FILE* f)
 {
 	lima_gp_ir_const_node_t* const_node = gp_ir_node_to_const(node);
 	
-	lima_gp_ir_print_tabs(tabs);
-	printf("(inline_const %f)", const_node->constant);
+	lima_gp_ir_print_tabs(tabs, f);
+	fprintf(f, "(inline_const %f)", const_node->constant);
 }
 
 typedef struct
@@ -1235,7 +1244,7 @@ static void* const_node_export(lima_gp_ir_node_t* node,
 	
 	lima_gp_ir_const_node_t* const_node = gp_ir_node_to_const(node);
 	
-	const_node_data_t* data = malloc(sizeof(const_node_data_t));
+	const_node_data_t* data = calloc(1, sizeof(const_node_data_t));
 	if (!data)
 		return NULL;
 	
@@ -1285,17 +1294,17 @@ static void const_node_delete(lima_gp_ir_node_t* node)
 	lima_gp_ir_const_node_t* const_node =
 		gp_ir_node_to_const(node);
 	
-	free(const_node);
+	arena_free(node->prog->arena, const_node, sizeof(lima_gp_ir_const_node_t));
 }
 
-lima_gp_ir_const_node_t* lima_gp_ir_const_node_create()
+lima_gp_ir_const_node_t* lima_gp_ir_const_node_create(lima_gp_ir_prog_t* prog)
 {
 	lima_gp_ir_const_node_t* const_node =
-		malloc(sizeof(lima_gp_ir_const_node_t));
+		arena_alloc(prog->arena, sizeof(lima_gp_ir_const_node_t));
 	
-	if (!node_init(&const_node->node, lima_gp_ir_op_const))
+	if (!node_init(&const_node->node, prog, lima_gp_ir_op_const))
 	{
-		free(const_node);
+		arena_free(prog->arena, const_node, sizeof(lima_gp_ir_const_node_t));
 		return NULL;
 	}
 	
@@ -1310,17 +1319,17 @@ lima_gp_ir_const_node_t* lima_gp_ir_const_node_create()
 
 
 static bool root_node_init(lima_gp_ir_root_node_t* root_node,
-						   lima_gp_ir_op_e op)
+						   lima_gp_ir_prog_t* prog, lima_gp_ir_op_e op)
 {
-	if (!node_init(&root_node->node, op))
+	if (!node_init(&root_node->node, prog, op))
 		return false;
 	
 	root_node->node.successor = root_node;
 	
-	root_node->live_phys_after = bitset_create(16*4);
+	root_node->live_phys_after = bitset_create_arena(16*4, prog->arena);
 	
 	//Variably sized, has to be created before live variable analysis
-	root_node->live_virt_after = bitset_create(0);
+	root_node->live_virt_after = bitset_create_arena(0, prog->arena);
 	
 	return true;
 }
@@ -1332,20 +1341,20 @@ static void root_node_cleanup(lima_gp_ir_root_node_t* root_node)
 }
 
 
-static void load_node_print(lima_gp_ir_node_t* node, unsigned tabs)
+static void load_node_print(lima_gp_ir_node_t* node, unsigned tabs, FILE* f)
 {
 	lima_gp_ir_load_node_t* load_node = gp_ir_node_to_load(node);
 	
-	lima_gp_ir_print_tabs(tabs);
+	lima_gp_ir_print_tabs(tabs, f);
 	
 	const char* c = "xyzw";
-	printf("(%s %u.%c", lima_gp_ir_op[node->op].name, load_node->index,
+	fprintf(f, "(%s %u.%c", lima_gp_ir_op[node->op].name, load_node->index,
 		   c[load_node->component]);
 	
 	if (load_node->offset)
-		printf(" off_reg: %u", load_node->off_reg);
+		fprintf(f, " off_reg: %u", load_node->off_reg);
 	
-	printf(")");
+	fprintf(f, ")");
 }
 
 typedef struct
@@ -1363,7 +1372,7 @@ static void* load_node_export(lima_gp_ir_node_t* node,
 	
 	lima_gp_ir_load_node_t* load_node = gp_ir_node_to_load(node);
 	
-	load_node_data_t* data = malloc(sizeof(load_node_data_t));
+	load_node_data_t* data = calloc(1, sizeof(load_node_data_t));
 	if (!data)
 		return NULL;
 	
@@ -1414,17 +1423,19 @@ static void load_node_child_iter_next(lima_gp_ir_child_node_iter_t* iter)
 static void load_node_delete(lima_gp_ir_node_t* node)
 {
 	lima_gp_ir_load_node_t* load_node = gp_ir_node_to_load(node);
-	free(load_node);
+	arena_free(node->prog->arena, load_node, sizeof(lima_gp_ir_load_node_t));
 }
 
-lima_gp_ir_load_node_t* lima_gp_ir_load_node_create(lima_gp_ir_op_e op)
+lima_gp_ir_load_node_t* lima_gp_ir_load_node_create(lima_gp_ir_prog_t* prog,
+													lima_gp_ir_op_e op)
 {
-	lima_gp_ir_load_node_t* load_node = malloc(sizeof(lima_gp_ir_load_node_t));
+	lima_gp_ir_load_node_t* load_node =
+		arena_alloc(prog->arena, sizeof(lima_gp_ir_load_node_t));
 	if (!load_node)
 		return NULL;
-	if (!node_init(&load_node->node, op))
+	if (!node_init(&load_node->node, prog, op))
 	{
-		free(load_node);
+		arena_free(prog->arena, load_node, sizeof(lima_gp_ir_load_node_t));
 		return NULL;
 	}
 	
@@ -1442,20 +1453,20 @@ lima_gp_ir_load_node_t* lima_gp_ir_load_node_create(lima_gp_ir_op_e op)
 }
 
 
-static void load_reg_node_print(lima_gp_ir_node_t* node, unsigned tabs)
+static void load_reg_node_print(lima_gp_ir_node_t* node, unsigned tabs, FILE* f)
 {
 	lima_gp_ir_load_reg_node_t* load_reg_node = gp_ir_node_to_load_reg(node);
 	
-	lima_gp_ir_print_tabs(tabs);
-	printf("(virt_reg reg_%u", load_reg_node->reg->index);
+	lima_gp_ir_print_tabs(tabs, f);
+	fprintf(f, "(virt_reg reg_%u", load_reg_node->reg->index);
 	if (load_reg_node->offset)
 	{
-		printf("\n");
-		lima_gp_ir_node_print(load_reg_node->offset, tabs + 1);
+		fprintf(f, "\n");
+		lima_gp_ir_node_print(load_reg_node->offset, tabs + 1, f);
 	}
 	
 	const char* c = "xyzw";
-	printf(".%c)", c[load_reg_node->component]);
+	fprintf(f, ".%c)", c[load_reg_node->component]);
 }
 
 typedef struct
@@ -1471,7 +1482,7 @@ static void* load_reg_node_export(lima_gp_ir_node_t* node,
 {
 	(void) block;
 	
-	load_reg_node_data_t* data = malloc(sizeof(load_reg_node_data_t));
+	load_reg_node_data_t* data = calloc(1, sizeof(load_reg_node_data_t));
 	if (!data)
 		return NULL;
 	
@@ -1540,19 +1551,22 @@ static void load_reg_node_delete(lima_gp_ir_node_t* node)
 	lima_gp_ir_load_reg_node_t* load_reg_node = gp_ir_node_to_load_reg(node);
 	
 	ptrset_remove(&load_reg_node->reg->uses, node);
-	free(load_reg_node);
+	arena_free(node->prog->arena, load_reg_node,
+			   sizeof(lima_gp_ir_load_reg_node_t));
 }
 
 
-lima_gp_ir_load_reg_node_t* lima_gp_ir_load_reg_node_create(void)
+lima_gp_ir_load_reg_node_t* lima_gp_ir_load_reg_node_create(
+	lima_gp_ir_prog_t* prog)
 {
 	lima_gp_ir_load_reg_node_t* load_reg_node =
-		malloc(sizeof(lima_gp_ir_load_reg_node_t));
+		arena_alloc(prog->arena, sizeof(lima_gp_ir_load_reg_node_t));
 	if (!load_reg_node)
 		return NULL;
-	if (!node_init(&load_reg_node->node, lima_gp_ir_op_load_reg))
+	if (!node_init(&load_reg_node->node, prog, lima_gp_ir_op_load_reg))
 	{
-		free(load_reg_node);
+		arena_free(prog->arena, load_reg_node,
+				   sizeof(lima_gp_ir_load_reg_node_t));
 		return NULL;
 	}
 	
@@ -1568,12 +1582,12 @@ lima_gp_ir_load_reg_node_t* lima_gp_ir_load_reg_node_create(void)
 }
 
 
-static void store_node_print(lima_gp_ir_node_t* node, unsigned tabs)
+static void store_node_print(lima_gp_ir_node_t* node, unsigned tabs, FILE* f)
 {
 	lima_gp_ir_store_node_t* store_node = gp_ir_node_to_store(node);
 	
-	lima_gp_ir_print_tabs(tabs);
-	printf("(%s", lima_gp_ir_op[node->op].name);
+	lima_gp_ir_print_tabs(tabs, f);
+	fprintf(f, "(%s", lima_gp_ir_op[node->op].name);
 	
 	if (node->op != lima_gp_ir_op_store_temp_load_off0 &&
 		node->op != lima_gp_ir_op_store_temp_load_off1 &&
@@ -1581,12 +1595,12 @@ static void store_node_print(lima_gp_ir_node_t* node, unsigned tabs)
 	{
 		if (node->op == lima_gp_ir_op_store_temp)
 		{
-			printf("\n");
-			lima_gp_ir_node_print(store_node->addr, tabs + 1);
+			fprintf(f, "\n");
+			lima_gp_ir_node_print(store_node->addr, tabs + 1, f);
 		}
 		else
 		{
-			printf(" %u", store_node->index);
+			fprintf(f, " %u", store_node->index);
 		}
 	}
 	
@@ -1595,20 +1609,20 @@ static void store_node_print(lima_gp_ir_node_t* node, unsigned tabs)
 	for (i = 0; i < 4; i++)
 		if (store_node->mask[i])
 		{
-			printf("\n");
+			fprintf(f, "\n");
 			
 			if (node->op != lima_gp_ir_op_store_temp_load_off0 &&
 				node->op != lima_gp_ir_op_store_temp_load_off1 &&
 				node->op != lima_gp_ir_op_store_temp_load_off2)
 			{
-				lima_gp_ir_print_tabs(tabs + 1);
-				printf("%c:\n", c[i]);
+				lima_gp_ir_print_tabs(tabs + 1, f);
+				fprintf(f, "%c:\n", c[i]);
 			}
 			
-			lima_gp_ir_node_print(store_node->children[i], tabs + 1);
+			lima_gp_ir_node_print(store_node->children[i], tabs + 1, f);
 		}
 	
-	printf(")");
+	fprintf(f, ")");
 }
 
 typedef struct
@@ -1630,7 +1644,7 @@ static void* store_node_export(lima_gp_ir_node_t* node,
 	
 	lima_gp_ir_store_node_t* store_node = gp_ir_node_to_store(node);
 	
-	store_node_data_t* data = malloc(sizeof(store_node_data_t));
+	store_node_data_t* data = calloc(1, sizeof(store_node_data_t));
 	if (!data)
 		return NULL;
 	
@@ -1731,19 +1745,20 @@ static void store_node_delete(lima_gp_ir_node_t* node)
 {
 	lima_gp_ir_store_node_t* store_node = gp_ir_node_to_store(node);
 	root_node_cleanup(&store_node->root_node);
-	free(store_node);
+	arena_free(node->prog->arena, store_node, sizeof(lima_gp_ir_store_node_t));
 }
 
-lima_gp_ir_store_node_t* lima_gp_ir_store_node_create(lima_gp_ir_op_e op)
+lima_gp_ir_store_node_t* lima_gp_ir_store_node_create(lima_gp_ir_prog_t* prog,
+													  lima_gp_ir_op_e op)
 {
 	lima_gp_ir_store_node_t* store_node =
-		malloc(sizeof(lima_gp_ir_store_node_t));
+		arena_alloc(prog->arena, sizeof(lima_gp_ir_store_node_t));
 	if (!store_node)
 		return NULL;
 	
-	if (!root_node_init(&store_node->root_node, op))
+	if (!root_node_init(&store_node->root_node, prog, op))
 	{
-		free(store_node);
+		arena_free(prog->arena, store_node, sizeof(lima_gp_ir_store_node_t));
 		return NULL;
 	}
 	
@@ -1764,7 +1779,7 @@ lima_gp_ir_store_node_t* lima_gp_ir_store_node_create(lima_gp_ir_op_e op)
 }
 
 
-static void print_reg_type(lima_gp_ir_reg_t* reg)
+static void print_reg_type(lima_gp_ir_reg_t* reg, FILE* f)
 {
 	const char* sizes[] = {
 		"float",
@@ -1773,30 +1788,30 @@ static void print_reg_type(lima_gp_ir_reg_t* reg)
 		"vec4"
 	};
 	
-	printf("<%s>", sizes[reg->size - 1]);
+	fprintf(f, "<%s>", sizes[reg->size - 1]);
 }
 
-static void store_reg_node_print(lima_gp_ir_node_t* node, unsigned tabs)
+static void store_reg_node_print(lima_gp_ir_node_t* node, unsigned tabs, FILE* f)
 {
 	lima_gp_ir_store_reg_node_t* store_reg_node = gp_ir_node_to_store_reg(node);
 	
-	lima_gp_ir_print_tabs(tabs);
-	printf("(store_virt_reg ");
-	print_reg_type(store_reg_node->reg);
-	printf(" reg_%u", store_reg_node->reg->index);
+	lima_gp_ir_print_tabs(tabs, f);
+	fprintf(f, "(store_virt_reg ");
+	print_reg_type(store_reg_node->reg, f);
+	fprintf(f, " reg_%u", store_reg_node->reg->index);
 	
 	const char* c = "xyzw";
 	unsigned i;
 	for (i = 0; i < 4; i++)
 		if (store_reg_node->mask[i])
 		{
-			printf("\n");
-			lima_gp_ir_print_tabs(tabs + 1);
-			printf("%c:\n", c[i]);
-			lima_gp_ir_node_print(store_reg_node->children[i], tabs + 1);
+			fprintf(f, "\n");
+			lima_gp_ir_print_tabs(tabs + 1, f);
+			fprintf(f, "%c:\n", c[i]);
+			lima_gp_ir_node_print(store_reg_node->children[i], tabs + 1, f);
 		}
 	
-	printf(")");
+	fprintf(f, ")");
 }
 
 typedef struct
@@ -1817,7 +1832,7 @@ static void* store_reg_node_export(lima_gp_ir_node_t* node,
 	
 	lima_gp_ir_store_reg_node_t* store_reg_node = gp_ir_node_to_store_reg(node);
 	
-	store_reg_node_data_t* data = malloc(sizeof(store_reg_node_data_t));
+	store_reg_node_data_t* data = calloc(1, sizeof(store_reg_node_data_t));
 	if (!data)
 		return NULL;
 	
@@ -1908,19 +1923,22 @@ static void store_reg_node_delete(lima_gp_ir_node_t* node)
 	
 	ptrset_remove(&store_reg_node->reg->defs, node);
 	root_node_cleanup(&store_reg_node->root_node);
-	free(store_reg_node);
+	arena_free(node->prog->arena, store_reg_node,
+			   sizeof(lima_gp_ir_store_reg_node_t));
 }
 
-lima_gp_ir_store_reg_node_t* lima_gp_ir_store_reg_node_create(void)
+lima_gp_ir_store_reg_node_t* lima_gp_ir_store_reg_node_create(
+	lima_gp_ir_prog_t* prog)
 {
 	lima_gp_ir_store_reg_node_t* store_reg_node =
-		malloc(sizeof(lima_gp_ir_store_reg_node_t));
+		arena_alloc(prog->arena, sizeof(lima_gp_ir_store_reg_node_t));
 	if (!store_reg_node)
 		return NULL;
 	
-	if (!root_node_init(&store_reg_node->root_node, lima_gp_ir_op_store_reg))
+	if (!root_node_init(&store_reg_node->root_node, prog, lima_gp_ir_op_store_reg))
 	{
-		free(store_reg_node);
+		arena_free(prog->arena, store_reg_node,
+				   sizeof(lima_gp_ir_store_reg_node_t));
 		return NULL;
 	}
 	
@@ -1942,20 +1960,20 @@ lima_gp_ir_store_reg_node_t* lima_gp_ir_store_reg_node_create(void)
 }
 
 
-static void branch_node_print(lima_gp_ir_node_t* node, unsigned tabs)
+static void branch_node_print(lima_gp_ir_node_t* node, unsigned tabs, FILE* f)
 {
 	lima_gp_ir_branch_node_t* branch_node = gp_ir_node_to_branch(node);
 	
-	lima_gp_ir_print_tabs(tabs);
-	printf("(branch block_%u", branch_node->dest->index);
+	lima_gp_ir_print_tabs(tabs, f);
+	fprintf(f, "(branch block_%u", branch_node->dest->index);
 	
 	if (branch_node->condition)
 	{
-		printf("\n");
-		lima_gp_ir_node_print(branch_node->condition, tabs + 1);
+		fprintf(f, "\n");
+		lima_gp_ir_node_print(branch_node->condition, tabs + 1, f);
 	}
 	
-	printf(")");
+	fprintf(f, ")");
 }
 
 typedef struct
@@ -1980,7 +1998,7 @@ static void* branch_node_export(lima_gp_ir_node_t* node,
 {
 	(void) block;
 	
-	branch_node_data_t* data = malloc(sizeof(branch_node_data_t));
+	branch_node_data_t* data = calloc(1, sizeof(branch_node_data_t));
 	if (!data)
 		return NULL;
 	
@@ -2046,22 +2064,26 @@ static void branch_node_delete(lima_gp_ir_node_t* node)
 {
 	lima_gp_ir_branch_node_t* branch_node = gp_ir_node_to_branch(node);
 	root_node_cleanup(&branch_node->root_node);
-	free(branch_node);
+	arena_free(node->prog->arena, branch_node,
+			   sizeof(lima_gp_ir_branch_node_t));
 }
 
-lima_gp_ir_branch_node_t* lima_gp_ir_branch_node_create(lima_gp_ir_op_e op)
+lima_gp_ir_branch_node_t* lima_gp_ir_branch_node_create(lima_gp_ir_prog_t* prog,
+														lima_gp_ir_op_e op)
 {
 	lima_gp_ir_branch_node_t* branch_node =
-		malloc(sizeof(lima_gp_ir_branch_node_t));
+		arena_alloc(prog->arena, sizeof(lima_gp_ir_branch_node_t));
 	if (!branch_node)
 		return NULL;
 	
-	if (!root_node_init(&branch_node->root_node, op))
+	if (!root_node_init(&branch_node->root_node, prog, op))
 	{
-		free(branch_node);
+		arena_free(prog->arena, branch_node, sizeof(lima_gp_ir_branch_node_t));
 		return NULL;
 	}
 	
+	branch_node->unconditional = false;
+	
 	branch_node->root_node.node.child_iter_create =
 		branch_node_child_iter_create;
 	branch_node->root_node.node.child_iter_next = branch_node_child_iter_next;
@@ -2074,23 +2096,23 @@ lima_gp_ir_branch_node_t* lima_gp_ir_branch_node_create(lima_gp_ir_op_e op)
 }
 
 
-static void phi_node_print(lima_gp_ir_node_t* node, unsigned tabs)
+static void phi_node_print(lima_gp_ir_node_t* node, unsigned tabs, FILE* f)
 {
 	lima_gp_ir_phi_node_t* phi_node = gp_ir_node_to_phi(node);
 	
-	lima_gp_ir_print_tabs(tabs);
-	printf("(phi reg_%u\n", phi_node->dest->index);
+	lima_gp_ir_print_tabs(tabs, f);
+	fprintf(f, "(phi reg_%u\n", phi_node->dest->index);
 	
 	unsigned i;
 	for (i = 0; i < phi_node->num_sources; i++)
 	{
-		lima_gp_ir_print_tabs(tabs + 1);
-		printf("(block_%u reg_%u)", phi_node->sources[i].pred->index,
+		lima_gp_ir_print_tabs(tabs + 1, f);
+		fprintf(f, "(block_%u reg_%u)", phi_node->sources[i].pred->index,
 			   phi_node->sources[i].reg->index);
 		if (i != phi_node->num_sources - 1)
-			printf("\n");
+			fprintf(f, "\n");
 	}
-	printf(")");
+	fprintf(f, ")");
 }
 
 typedef struct
@@ -2116,7 +2138,7 @@ static void* phi_node_export(lima_gp_ir_node_t* node,
 	
 	*size = sizeof(phi_node_header_t) +
 		phi_node->num_sources*sizeof(phi_node_src_data_t);
-	void* data = malloc(*size);
+	void* data = calloc(1, *size);
 	if (!data)
 		return NULL;
 	
@@ -2152,7 +2174,8 @@ static bool phi_node_import(lima_gp_ir_node_t* node,
 	phi_node->num_sources = header->num_sources;
 	
 	phi_node->sources =
-		malloc(sizeof(lima_gp_ir_phi_node_src_t)*phi_node->num_sources);
+		arena_alloc(node->prog->arena,
+					sizeof(lima_gp_ir_phi_node_src_t)*phi_node->num_sources);
 	if (!phi_node->sources)
 		return false;
 	
@@ -2193,19 +2216,22 @@ static void phi_node_child_iter_next(lima_gp_ir_child_node_iter_t* iter)
 static void phi_node_delete(lima_gp_ir_node_t* node)
 {
 	lima_gp_ir_phi_node_t* phi_node = gp_ir_node_to_phi(node);
-	free(phi_node->sources);
-	free(phi_node);
+	arena_free(node->prog->arena, phi_node->sources,
+			   phi_node->num_sources * sizeof(lima_gp_ir_phi_node_src_t));
+	arena_free(node->prog->arena, phi_node, sizeof(lima_gp_ir_phi_node_t));
 }
 
-lima_gp_ir_phi_node_t* lima_gp_ir_phi_node_create(unsigned num_sources)
+lima_gp_ir_phi_node_t* lima_gp_ir_phi_node_create(lima_gp_ir_prog_t* prog,
+												  unsigned num_sources)
 {
-	lima_gp_ir_phi_node_t* phi_node = malloc(sizeof(lima_gp_ir_phi_node_t));
+	lima_gp_ir_phi_node_t* phi_node =
+		arena_alloc(prog->arena, sizeof(lima_gp_ir_phi_node_t));
 	if (!phi_node)
 		return NULL;
 	
-	if (!node_init(&phi_node->node, lima_gp_ir_op_phi))
+	if (!node_init(&phi_node->node, prog, lima_gp_ir_op_phi))
 	{
-		free(phi_node);
+		arena_free(prog->arena, phi_node, sizeof(lima_gp_ir_phi_node_t));
 		return NULL;
 	}
 	
@@ -2213,10 +2239,11 @@ lima_gp_ir_phi_node_t* lima_gp_ir_phi_node_create(unsigned num_sources)
 	if (num_sources)
 	{
 		phi_node->sources =
-			malloc(num_sources * sizeof(lima_gp_ir_phi_node_src_t));
+			arena_alloc(prog->arena,
+						num_sources * sizeof(lima_gp_ir_phi_node_src_t));
 		if (!phi_node->sources)
 		{
-			free(phi_node);
+			arena_free(prog->arena, phi_node, sizeof(lima_gp_ir_phi_node_t));
 			return NULL;
 		}
 	}
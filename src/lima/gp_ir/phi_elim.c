@@ -23,13 +23,15 @@
  */
 
 #include "gp_ir.h"
+#include "trace.h"
 
 /* Similar to the code in lima_pp_lir/phi_elim.c */
 
 static lima_gp_ir_root_node_t* create_copy(lima_gp_ir_reg_t* dst,
 										   lima_gp_ir_reg_t* src)
 {
-	lima_gp_ir_store_reg_node_t* store_node = lima_gp_ir_store_reg_node_create();
+	lima_gp_ir_store_reg_node_t* store_node =
+		lima_gp_ir_store_reg_node_create(dst->prog);
 	if (!store_node)
 		return NULL;
 	
@@ -38,7 +40,8 @@ static lima_gp_ir_root_node_t* create_copy(lima_gp_ir_reg_t* dst,
 	unsigned i;
 	for (i = 0; i < src->size; i++)
 	{
-		lima_gp_ir_load_reg_node_t* load_node = lima_gp_ir_load_reg_node_create();
+		lima_gp_ir_load_reg_node_t* load_node =
+			lima_gp_ir_load_reg_node_create(dst->prog);
 		if (!load_node)
 		{
 			lima_gp_ir_node_delete(&store_node->root_node.node);
@@ -240,7 +243,8 @@ bool lima_gp_ir_eliminate_phi_nodes(lima_gp_ir_prog_t* prog)
 	if (!insert_copies(prog))
 		return false;
 	
-	lima_gp_ir_prog_print(prog, 0, false);
+	if (lima_trace_enabled(lima_trace_ir))
+		lima_gp_ir_prog_print(prog, 0, false, lima_trace_file(lima_trace_ir));
 	
 	return eliminate_phi_nodes(prog);
 }
@@ -36,16 +36,27 @@ lima_gp_ir_prog_t* lima_gp_ir_prog_create(void)
 	list_init(&prog->block_list);
 	list_init(&prog->reg_list);
 	prog->num_blocks = prog->reg_alloc = 0;
+	prog->sched_restarts = prog->sched_nodes_undone = 0;
+	
+	prog->arena = arena_create();
+	if (!prog->arena)
+	{
+		free(prog);
+		return NULL;
+	}
 	
 	return prog;
 }
 
 void lima_gp_ir_prog_delete(lima_gp_ir_prog_t* prog)
 {
+	/* everything in the arena goes at once at the end, so there's no need to
+	 * unlink and delete the nodes one at a time
+	 */
 	lima_gp_ir_block_t* block, *temp_block;
 	gp_ir_prog_for_each_block_safe(prog, block, temp_block)
 	{
-		lima_gp_ir_block_delete(block);
+		lima_gp_ir_block_delete_shallow(block);
 	}
 	
 	lima_gp_ir_reg_t* reg, *temp_reg;
@@ -53,6 +64,8 @@ void lima_gp_ir_prog_delete(lima_gp_ir_prog_t* prog)
 	{
 		lima_gp_ir_reg_delete(reg);
 	}
+	
+	arena_delete(prog->arena);
 	free(prog);
 }
 
@@ -190,9 +203,9 @@ bool lima_gp_ir_prog_calc_preds(lima_gp_ir_prog_t* prog)
 }
 
 bool lima_gp_ir_prog_print(lima_gp_ir_prog_t* prog, unsigned tabs,
-						   bool print_liveness)
+						   bool print_liveness, FILE* f)
 {
-	printf("(temp_alloc %u)\n\n", prog->temp_alloc);
+	fprintf(f, "(temp_alloc %u)\n\n", prog->temp_alloc);
 	
 	lima_gp_ir_block_t* block;
 	unsigned index = 0;
@@ -200,7 +213,7 @@ bool lima_gp_ir_prog_print(lima_gp_ir_prog_t* prog, unsigned tabs,
 		block->index = index++;
 	
 	gp_ir_prog_for_each_block(prog, block)
-		if (!lima_gp_ir_block_print(block, tabs, print_liveness))
+		if (!lima_gp_ir_block_print(block, tabs, print_liveness, f))
 			return false;
 	
 	return true;
@@ -228,7 +241,7 @@ static void* export_regs(lima_gp_ir_prog_t* prog, unsigned* size)
 {
 	unsigned num_regs = calc_num_regs(prog);
 	*size = sizeof(uint32_t) + num_regs * sizeof(reg_data_t);
-	void* data = malloc(*size);
+	void* data = calloc(1, *size);
 	if (!data)
 		return NULL;
 	
@@ -395,7 +408,7 @@ void* lima_gp_ir_prog_export(lima_gp_ir_prog_t* prog, unsigned* size)
 	
 	*size = reg_size + block_size + sizeof(prog_header_t);
 	
-	void* data = malloc(*size);
+	void* data = calloc(1, *size);
 	if (!data)
 	{
 		free(block_data);
@@ -23,7 +23,10 @@
  */
 
 #include "scheduler.h"
+#include "trace.h"
+#include <stdlib.h>
 #include <assert.h>
+#include <limits.h>
 #include <math.h>
 
 /* Register Allocation
@@ -162,7 +165,8 @@ static void reg_simplify(lima_gp_ir_prog_t* prog, bitset_t int_matrix,
 					continue;
 				}
 				
-				printf("Pushing reg_%u onto stack\n", reg->index);
+				lima_trace(lima_trace_regalloc, "Pushing reg_%u onto stack\n",
+						   reg->index);
 				stack->regs[stack->index] = reg;
 				stack->index++;
 				bitset_set(allocated, reg->index, true);
@@ -191,7 +195,8 @@ static void reg_simplify(lima_gp_ir_prog_t* prog, bitset_t int_matrix,
 			}
 		}
 		
-		printf("Pushing reg_%u onto stack (possible spill)\n", min_reg->index);
+		lima_trace(lima_trace_regalloc,
+				   "Pushing reg_%u onto stack (possible spill)\n", min_reg->index);
 		stack->regs[stack->index] = min_reg;
 		stack->index++;
 		bitset_set(allocated, min_reg->index, true);
@@ -250,8 +255,9 @@ static void reg_select(lima_gp_ir_prog_t* prog, reg_stack* stack,
 					reg->phys_reg_assigned = true;
 					reg->phys_reg = j;
 					reg->phys_reg_offset = k;
-					printf("reg_%u getting phys_reg %u, offset %u\n", reg->index,
-						   j, k);
+					lima_trace(lima_trace_regalloc,
+							   "reg_%u getting phys_reg %u, offset %u\n",
+							   reg->index, j, k);
 					break;
 				}
 			}
@@ -276,7 +282,7 @@ static bool spill_reg(lima_gp_ir_reg_t* reg, unsigned temp_index,
 		lima_gp_ir_load_reg_node_t* load_reg_node = gp_ir_node_to_load_reg(use);
 		
 		lima_gp_ir_load_node_t* load_temp_node =
-			lima_gp_ir_load_node_create(lima_gp_ir_op_load_temp);
+			lima_gp_ir_load_node_create(reg->prog, lima_gp_ir_op_load_temp);
 		
 		if (!load_temp_node)
 			return false;
@@ -299,12 +305,13 @@ static bool spill_reg(lima_gp_ir_reg_t* reg, unsigned temp_index,
 			gp_ir_node_to_store_reg(def);
 		
 		lima_gp_ir_store_node_t* store_temp_node =
-			lima_gp_ir_store_node_create(lima_gp_ir_op_store_temp);
+			lima_gp_ir_store_node_create(reg->prog, lima_gp_ir_op_store_temp);
 		
 		if (!store_temp_node)
 			return false;
 		
-		lima_gp_ir_const_node_t* const_node = lima_gp_ir_const_node_create();
+		lima_gp_ir_const_node_t* const_node =
+			lima_gp_ir_const_node_create(reg->prog);
 		if (!const_node)
 		{
 			lima_gp_ir_node_delete(&store_temp_node->root_node.node);
@@ -375,17 +382,21 @@ bool lima_gp_ir_regalloc(lima_gp_ir_prog_t* prog)
 	{
 		bitset_t int_matrix = calc_int_matrix(prog);
 		
-		unsigned i, j;
-		for (i = 0; i < prog->reg_alloc; i++)
+		if (lima_trace_enabled(lima_trace_regalloc))
 		{
-			for (j = 0; j < prog->reg_alloc; j++)
+			FILE* f = lima_trace_file(lima_trace_regalloc);
+			unsigned i, j;
+			for (i = 0; i < prog->reg_alloc; i++)
 			{
-				if (bitset_get(int_matrix, prog->reg_alloc*i + j))
-					printf("1, ");
-				else
-					printf("0, ");
+				for (j = 0; j < prog->reg_alloc; j++)
+				{
+					if (bitset_get(int_matrix, prog->reg_alloc*i + j))
+						fprintf(f, "1, ");
+					else
+						fprintf(f, "0, ");
+				}
+				fprintf(f, "\n");
 			}
-			printf("\n");
 		}
 		
 		reg_stack stack = {
@@ -423,6 +434,245 @@ bool lima_gp_ir_regalloc(lima_gp_ir_prog_t* prog)
 	}
 }
 
+/* Linear scan allocation
+ *
+ * A faster alternative to the above. Every register gets a single interval,
+ * from the first point in the program (in block order) where it's written or
+ * live to the last, and the intervals are given slots in order of their start,
+ * expiring the ones that have ended along the way. Like reg_select(), we
+ * never fail but go above r15 instead, so registers whose intervals don't
+ * overlap share a temporary in spill_regs().
+ */
+
+typedef struct
+{
+	lima_gp_ir_reg_t* reg;
+	unsigned start, end; //start > end if the register is never live
+} interval_t;
+
+static void extend_interval(interval_t* interval, unsigned point)
+{
+	if (point < interval->start)
+		interval->start = point;
+	if (point > interval->end)
+		interval->end = point;
+}
+
+static void extend_live(interval_t* intervals, unsigned num_regs,
+						bitset_t live, unsigned point)
+{
+	unsigned i;
+	for (i = 0; i < num_regs; i++)
+	{
+		if (bitset_get(live, 4 * i + 0) ||
+			bitset_get(live, 4 * i + 1) ||
+			bitset_get(live, 4 * i + 2) ||
+			bitset_get(live, 4 * i + 3))
+			extend_interval(&intervals[i], point);
+	}
+}
+
+/*
+ * Within a block, a register is live from where it's stored (or the start of
+ * the block) to where it's last loaded (or the end of the block), so rather
+ * than going through the live set after every node, which is quadratic, we
+ * only look at the loads and stores and at the live sets at either end of
+ * each block. The intervals come out the same.
+ */
+
+typedef struct
+{
+	interval_t* intervals;
+	unsigned point;
+} calc_intervals_state_t;
+
+static bool calc_intervals_cb(lima_gp_ir_node_t* node, void* _state)
+{
+	if (node->op != lima_gp_ir_op_load_reg)
+		return true;
+	
+	calc_intervals_state_t* state = (calc_intervals_state_t*)_state;
+	lima_gp_ir_load_reg_node_t* load_reg_node = gp_ir_node_to_load_reg(node);
+	lima_gp_ir_reg_t* reg = load_reg_node->reg;
+	if (reg->phys_reg_assigned)
+		return true;
+	
+	//Live before the node, i.e. after the one before it
+	extend_interval(&state->intervals[reg->index], state->point - 1);
+	return true;
+}
+
+static bool calc_intervals(lima_gp_ir_prog_t* prog, interval_t* intervals)
+{
+	unsigned i, point = 0, num_regs = prog->reg_alloc;
+	for (i = 0; i < num_regs; i++)
+	{
+		intervals[i].reg = NULL;
+		intervals[i].start = UINT_MAX;
+		intervals[i].end = 0;
+	}
+	
+	lima_gp_ir_reg_t* reg;
+	gp_ir_prog_for_each_reg(prog, reg)
+	{
+		intervals[reg->index].reg = reg;
+	}
+	
+	calc_intervals_state_t state;
+	state.intervals = intervals;
+	
+	lima_gp_ir_block_t* block;
+	gp_ir_prog_for_each_block(prog, block)
+	{
+		extend_live(intervals, num_regs, block->live_virt_before, point++);
+		
+		lima_gp_ir_root_node_t* node;
+		gp_ir_block_for_each_node(block, node)
+		{
+			state.point = point;
+			if (!lima_gp_ir_node_dfs(&node->node, NULL, calc_intervals_cb,
+									 (void*)&state))
+				return false;
+			
+			//Registers that are written but never read still need somewhere
+			//to go
+			if (node->node.op == lima_gp_ir_op_store_reg)
+			{
+				lima_gp_ir_store_reg_node_t* store_reg_node =
+					gp_ir_node_to_store_reg(&node->node);
+				extend_interval(&intervals[store_reg_node->reg->index], point);
+			}
+			
+			point++;
+		}
+		
+		if (block->num_nodes != 0)
+		{
+			node = gp_ir_block_last_node(block);
+			extend_live(intervals, num_regs, node->live_virt_after, point - 1);
+		}
+	}
+	
+	return true;
+}
+
+static int compare_intervals(const void* elem1, const void* elem2)
+{
+	const interval_t* interval1 = *(const interval_t* const*) elem1;
+	const interval_t* interval2 = *(const interval_t* const*) elem2;
+	
+	if (interval1->start != interval2->start)
+		return interval1->start < interval2->start ? -1 : 1;
+	
+	return interval1->reg->index < interval2->reg->index ? -1 : 1;
+}
+
+static unsigned reg_mask(lima_gp_ir_reg_t* reg)
+{
+	return ((1 << reg->size) - 1) << reg->phys_reg_offset;
+}
+
+bool lima_gp_ir_regalloc_linear_scan(lima_gp_ir_prog_t* prog)
+{
+	if (!lima_gp_ir_liveness_compute_prog(prog, true))
+		return false;
+	
+	//Each register takes up at most one vec4 beyond the 16 we have
+	unsigned num_regs = prog->reg_alloc, num_phys_regs = 16 + num_regs;
+	interval_t* intervals = malloc(num_regs * sizeof(interval_t));
+	interval_t** sorted = malloc(num_regs * sizeof(interval_t*));
+	interval_t** active = malloc(num_regs * sizeof(interval_t*));
+	unsigned* used = calloc(num_phys_regs, sizeof(unsigned));
+	if (!intervals || !sorted || !active || !used)
+	{
+		free(intervals);
+		free(sorted);
+		free(active);
+		free(used);
+		return false;
+	}
+	
+	if (!calc_intervals(prog, intervals))
+	{
+		free(intervals);
+		free(sorted);
+		free(active);
+		free(used);
+		return false;
+	}
+	
+	unsigned num_sorted = 0, num_active = 0, i, j, k;
+	for (i = 0; i < num_regs; i++)
+	{
+		lima_gp_ir_reg_t* reg = intervals[i].reg;
+		if (!reg)
+			continue;
+		
+		if (intervals[i].start > intervals[i].end)
+		{
+			//Never live or written, so any slot will do
+			reg->phys_reg_assigned = true;
+			reg->phys_reg = 0;
+			reg->phys_reg_offset = 0;
+			continue;
+		}
+		
+		sorted[num_sorted++] = &intervals[i];
+	}
+	
+	qsort(sorted, num_sorted, sizeof(interval_t*), compare_intervals);
+	
+	for (i = 0; i < num_sorted; i++)
+	{
+		interval_t* cur = sorted[i];
+		lima_gp_ir_reg_t* reg = cur->reg;
+		
+		for (j = 0; j < num_active; )
+		{
+			if (active[j]->end < cur->start)
+			{
+				lima_gp_ir_reg_t* other_reg = active[j]->reg;
+				used[other_reg->phys_reg] &= ~reg_mask(other_reg);
+				active[j] = active[--num_active];
+			}
+			else
+				j++;
+		}
+		
+		bool found = false;
+		for (j = 0; j < num_phys_regs && !found; j++)
+		{
+			for (k = 0; k < 5 - reg->size; k++)
+			{
+				unsigned mask = ((1 << reg->size) - 1) << k;
+				if (!(used[j] & mask))
+				{
+					reg->phys_reg_assigned = true;
+					reg->phys_reg = j;
+					reg->phys_reg_offset = k;
+					found = true;
+					break;
+				}
+			}
+		}
+		
+		assert(found);
+		lima_trace(lima_trace_regalloc,
+				   "reg_%u getting phys_reg %u, offset %u\n",
+				   reg->index, reg->phys_reg, reg->phys_reg_offset);
+		
+		used[reg->phys_reg] |= reg_mask(reg);
+		active[num_active++] = cur;
+	}
+	
+	free(intervals);
+	free(sorted);
+	free(active);
+	free(used);
+	
+	return spill_regs(prog);
+}
+
 /* Register allocation within the scheduler
  *
  * The scheduler can spill intermediate results to registers in case it cannot
@@ -23,7 +23,9 @@
  */
 
 #include "scheduler.h"
-#include "priority_queue.h"
+#include "list_scheduler.h"
+#include "ptr_vector.h"
+#include "trace.h"
 #include <stdlib.h>
 #include <limits.h>
 #include <assert.h>
@@ -74,11 +76,107 @@ static bool instr_range_union(instr_range_t* dest, instr_range_t new)
 	return ret;
 }
 
+/* Checkpoints
+ *
+ * The scheduler takes a checkpoint before processing each node, so that when
+ * a node can't be scheduled we only have to throw away the part of the
+ * schedule that could have caused it instead of starting the block over.
+ * Instructions are saved lazily, the first time they're handed out for
+ * modification after a checkpoint, which makes taking a checkpoint cheap.
+ */
+
+typedef struct
+{
+	lima_gp_ir_instr_t* instr;
+	lima_gp_ir_instr_t contents;
+} saved_instr_t;
+
+typedef struct
+{
+	/* the state of the block before the node was processed */
+	unsigned num_instrs, num_saved, num_moves, num_placed;
+	
+	/* the checkpoint of the first of the node's successors to be processed */
+	unsigned first_succ;
+	
+	/* whether the node had to go through a register, which changes the
+	 * dependency graph for good */
+	bool inserted_reg;
+} checkpoint_t;
+
+typedef struct lima_gp_ir_sched_log_s
+{
+	/* bumped with every checkpoint, instructions remember the last one */
+	unsigned epoch;
+	
+	saved_instr_t* saved;
+	unsigned num_saved, saved_capacity;
+	
+	/* one for each node taken off the queue, in order */
+	checkpoint_t* checkpoints;
+	unsigned num_checkpoints, checkpoints_capacity;
+	
+	/* every node placed so far, including the ones placed along with the
+	 * node being processed (moves and register loads/stores), which never
+	 * go through the queue
+	 */
+	ptr_vector_t placed;
+	
+	/* moves inserted between the processed nodes and their successors */
+	ptr_vector_t moves;
+	
+	/* the last node we failed to schedule, until it's been scheduled */
+	lima_gp_ir_node_t* failed_node;
+} lima_gp_ir_sched_log_t;
+
+static bool save_instr(lima_gp_ir_instr_t* instr)
+{
+	lima_gp_ir_sched_log_t* log = instr->block->sched_log;
+	if (!log || instr->sched_epoch == log->epoch)
+		return true;
+	
+	if (log->num_saved == log->saved_capacity)
+	{
+		unsigned capacity = log->saved_capacity ? 2 * log->saved_capacity : 16;
+		saved_instr_t* saved = realloc(log->saved,
+									   capacity * sizeof(saved_instr_t));
+		if (!saved)
+			return false;
+		log->saved = saved;
+		log->saved_capacity = capacity;
+	}
+	
+	log->saved[log->num_saved].instr = instr;
+	log->saved[log->num_saved].contents = *instr;
+	log->num_saved++;
+	instr->sched_epoch = log->epoch;
+	return true;
+}
+
+/* Restores every instruction saved since the given point. Going backwards
+ * means the oldest copy of each instruction is the one that sticks.
+ */
+
+static void restore_instrs(lima_gp_ir_sched_log_t* log, unsigned num_saved)
+{
+	while (log->num_saved > num_saved)
+	{
+		saved_instr_t* saved = &log->saved[--log->num_saved];
+		struct list instr_list = saved->instr->instr_list;
+		*saved->instr = saved->contents;
+		saved->instr->instr_list = instr_list;
+	}
+}
+
+/* returns the instruction num instructions from the end, creating it if
+ * necessary, for the caller to modify
+ */
+
 static lima_gp_ir_instr_t* get_instr(lima_gp_ir_block_t* block, unsigned num)
 {
 	while (num >= block->num_instrs)
 	{
-		lima_gp_ir_instr_t* instr = lima_gp_ir_instr_create();
+		lima_gp_ir_instr_t* instr = lima_gp_ir_instr_create(block->prog);
 		if (!instr)
 			return NULL;
 		
@@ -93,6 +191,9 @@ static lima_gp_ir_instr_t* get_instr(lima_gp_ir_block_t* block, unsigned num)
 		cur_num--;
 	}
 	
+	if (!save_instr(cur_instr))
+		return NULL;
+	
 	return cur_instr;
 }
 
@@ -122,9 +223,10 @@ static bool try_insert_node(lima_gp_ir_node_t* node, bool* success)
 	
 	if (*success)
 	{
-		printf("placed node with op %s\n", lima_gp_ir_op[node->op].name);
-		printf("\tsched_instr: %u, sched_pos: %u\n", node->sched_instr,
-			   node->sched_pos);
+		lima_trace(lima_trace_sched, "placed node with op %s\n",
+				   lima_gp_ir_op[node->op].name);
+		lima_trace(lima_trace_sched, "\tsched_instr: %u, sched_pos: %u\n",
+				   node->sched_instr, node->sched_pos);
 	}
 	
 	return true;
@@ -263,7 +365,7 @@ static bool try_place_node(lima_gp_ir_node_t* node, bool* success)
 static bool insert_move(lima_gp_ir_node_t* node, lima_gp_ir_node_t** new_node)
 {
 	lima_gp_ir_alu_node_t* move_node =
-		lima_gp_ir_alu_node_create(lima_gp_ir_op_mov);
+		lima_gp_ir_alu_node_create(node->prog, lima_gp_ir_op_mov);
 	if (!move_node)
 		return false;
 	
@@ -299,7 +401,7 @@ static bool insert_move(lima_gp_ir_node_t* node, lima_gp_ir_node_t** new_node)
 			lima_gp_ir_node_unlink(dep_info->succ, node);
 			
 			lima_gp_ir_dep_info_t* new_dep_info =
-				malloc(sizeof(lima_gp_ir_dep_info_t));
+				lima_gp_ir_dep_info_alloc(&move_node->node);
 			if (!new_dep_info)
 				return false;
 			
@@ -315,7 +417,7 @@ static bool insert_move(lima_gp_ir_node_t* node, lima_gp_ir_node_t** new_node)
 	}
 	
 	lima_gp_ir_dep_info_t* new_dep_info =
-	malloc(sizeof(lima_gp_ir_dep_info_t));
+	lima_gp_ir_dep_info_alloc(node);
 	if (!new_dep_info)
 		return false;
 	
@@ -413,6 +515,8 @@ static bool undo_moves(ptrset_t* moves)
 	{
 		lima_gp_ir_instr_t* instr = get_instr(node->successor->block,
 											  node->sched_instr);
+		if (!instr)
+			return false;
 		lima_gp_ir_instr_remove_alu_node(instr, node);
 		/*printf("removing node:\n");
 		printf("\tsched_instr: %u, sched_pos: %u\n", node->sched_instr,
@@ -437,7 +541,7 @@ static bool undo_moves(ptrset_t* moves)
 			}
 			
 			lima_gp_ir_dep_info_t* new_dep_info =
-				malloc(sizeof(lima_gp_ir_dep_info_t));
+				lima_gp_ir_dep_info_alloc(child);
 			if (!new_dep_info)
 				return false;
 			
@@ -575,7 +679,7 @@ static bool insert_reg(lima_gp_ir_node_t* node,
 	
 	if (!is_scheduled_alu(node))
 	{
-		move_node = lima_gp_ir_alu_node_create(lima_gp_ir_op_mov);
+		move_node = lima_gp_ir_alu_node_create(node->prog, lima_gp_ir_op_mov);
 		if (!move_node)
 			return false;
 		
@@ -584,7 +688,7 @@ static bool insert_reg(lima_gp_ir_node_t* node,
 		move_node->children_negate[0] = false;
 		move_node->node.index = 0;
 		
-		lima_gp_ir_dep_info_t* dep_info = malloc(sizeof(lima_gp_ir_dep_info_t));
+		lima_gp_ir_dep_info_t* dep_info = lima_gp_ir_dep_info_alloc(node);
 		if (!dep_info)
 		{
 			lima_gp_ir_node_delete(&move_node->node);
@@ -598,7 +702,7 @@ static bool insert_reg(lima_gp_ir_node_t* node,
 		if (!lima_gp_ir_dep_info_insert(dep_info))
 		{
 			lima_gp_ir_node_delete(&move_node->node);
-			free(dep_info);
+			lima_gp_ir_dep_info_free(dep_info);
 			return false;
 		}
 		
@@ -616,7 +720,7 @@ static bool insert_reg(lima_gp_ir_node_t* node,
 	*new_reg = reg;
 	
 	lima_gp_ir_store_reg_node_t* store_reg_node =
-		lima_gp_ir_store_reg_node_create();
+		lima_gp_ir_store_reg_node_create(node->prog);
 	if (!store_reg_node)
 		return false;
 	
@@ -634,7 +738,7 @@ static bool insert_reg(lima_gp_ir_node_t* node,
 	lima_gp_ir_block_insert_before(&store_reg_node->root_node,
 								   node->successor);
 	
-	lima_gp_ir_dep_info_t* dep_info = malloc(sizeof(lima_gp_ir_dep_info_t));
+	lima_gp_ir_dep_info_t* dep_info = lima_gp_ir_dep_info_alloc(store_reg_node->children[0]);
 	if (!dep_info)
 		return false;
 	
@@ -644,7 +748,7 @@ static bool insert_reg(lima_gp_ir_node_t* node,
 	dep_info->is_offset = false;
 	if (!lima_gp_ir_dep_info_insert(dep_info))
 	{
-		free(dep_info);
+		lima_gp_ir_dep_info_free(dep_info);
 		return false;
 	}
 	
@@ -673,7 +777,7 @@ static bool insert_reg(lima_gp_ir_node_t* node,
 		}
 		
 		lima_gp_ir_load_reg_node_t* load_reg_node
-		= lima_gp_ir_load_reg_node_create();
+		= lima_gp_ir_load_reg_node_create(node->prog);
 		if (!load_reg_node)
 			return false;
 		
@@ -686,7 +790,7 @@ static bool insert_reg(lima_gp_ir_node_t* node,
 		if (is_store_dep(dep_info))
 		{
 			lima_gp_ir_alu_node_t* move_node =
-				lima_gp_ir_alu_node_create(lima_gp_ir_op_mov);
+				lima_gp_ir_alu_node_create(node->prog, lima_gp_ir_op_mov);
 			if (!move_node)
 			{
 				lima_gp_ir_node_delete(&load_reg_node->node);
@@ -701,7 +805,7 @@ static bool insert_reg(lima_gp_ir_node_t* node,
 			move_node->node.index = 0;
 			
 			lima_gp_ir_dep_info_t* new_dep_info =
-				malloc(sizeof(lima_gp_ir_dep_info_t));
+				lima_gp_ir_dep_info_alloc(&load_reg_node->node);
 			if (!new_dep_info)
 			{
 				lima_gp_ir_node_delete(&move_node->node);
@@ -717,7 +821,7 @@ static bool insert_reg(lima_gp_ir_node_t* node,
 			{
 				lima_gp_ir_node_delete(&move_node->node);
 				lima_gp_ir_node_delete(&load_reg_node->node);
-				free(dep_info);
+				lima_gp_ir_dep_info_free(new_dep_info);
 				return false;
 			}
 			
@@ -734,7 +838,7 @@ static bool insert_reg(lima_gp_ir_node_t* node,
 		}
 		
 		lima_gp_ir_dep_info_t* new_dep_info =
-			malloc(sizeof(lima_gp_ir_dep_info_t));
+			lima_gp_ir_dep_info_alloc(child_node);
 		if (!new_dep_info)
 			return false;
 		
@@ -744,7 +848,7 @@ static bool insert_reg(lima_gp_ir_node_t* node,
 		new_dep_info->is_offset = dep_info->is_offset;
 		if (!lima_gp_ir_dep_info_insert(new_dep_info))
 		{
-			free(new_dep_info);
+			lima_gp_ir_dep_info_free(new_dep_info);
 			return false;
 		}
 		
@@ -753,7 +857,7 @@ static bool insert_reg(lima_gp_ir_node_t* node,
 		
 		//lima_gp_ir_dep_info_delete(dep_info);
 		
-		new_dep_info = malloc(sizeof(lima_gp_ir_dep_info_t));
+		new_dep_info = lima_gp_ir_dep_info_alloc(&store_reg_node->root_node.node);
 		if (!new_dep_info)
 			return false;
 		
@@ -763,7 +867,7 @@ static bool insert_reg(lima_gp_ir_node_t* node,
 		new_dep_info->is_offset = false;
 		if (!lima_gp_ir_dep_info_insert(new_dep_info))
 		{
-			free(new_dep_info);
+			lima_gp_ir_dep_info_free(new_dep_info);
 			return false;
 		}
 		
@@ -995,11 +1099,22 @@ static bool try_schedule_reg(lima_gp_ir_node_t* node, bitset_t free_regs,
 	return true;
 }
 
+/* tries to schedule a node, putting it through a register if that fails and
+ * allow_reg is set.
+ *
+ * Moves inserted are added to new_moves_inserted, and inserted_reg is set if
+ * a register had to be inserted - in that case the dependency graph has
+ * changed even if scheduling failed.
+ */
+
 static bool try_schedule_node(lima_gp_ir_node_t* node, bitset_t free_regs,
-							  ptrset_t* new_moves_inserted, bool* success)
+							  bool allow_reg, ptr_vector_t* new_moves_inserted,
+							  bool* success, bool* inserted_reg)
 {
 	assert(node->op != lima_gp_ir_op_const);
 	
+	*inserted_reg = false;
+	
 	ptrset_t moves_inserted;
 	if (!ptrset_create(&moves_inserted))
 		return false;
@@ -1018,6 +1133,13 @@ static bool try_schedule_node(lima_gp_ir_node_t* node, bitset_t free_regs,
 			return false;
 		}
 		
+		if (!allow_reg)
+		{
+			ptrset_delete(moves_inserted);
+			return true;
+		}
+		
+		*inserted_reg = true;
 		if (!try_schedule_reg(node, free_regs, success))
 		{
 			ptrset_delete(moves_inserted);
@@ -1025,8 +1147,18 @@ static bool try_schedule_node(lima_gp_ir_node_t* node, bitset_t free_regs,
 		}
 	}
 	else
-		ptrset_union(new_moves_inserted, moves_inserted);
-		
+	{
+		lima_gp_ir_node_t* move_node;
+		ptrset_iter_t iter = ptrset_iter_create(moves_inserted);
+		ptrset_iter_for_each(iter, move_node)
+		{
+			if (!ptr_vector_add(new_moves_inserted, move_node))
+			{
+				ptrset_delete(moves_inserted);
+				return false;
+			}
+		}
+	}
 	
 	ptrset_delete(moves_inserted);
 	return true;
@@ -1087,19 +1219,6 @@ static bool compare_nodes(void* elem1, void* elem2)
 	return node1_value > node2_value;
 }
 
-static bool succs_processed(lima_gp_ir_node_t* node, ptrset_t processed)
-{
-	ptrset_iter_t node_iter = ptrset_iter_create(node->succs);
-	lima_gp_ir_dep_info_t* dep_info;
-	ptrset_iter_for_each(node_iter, dep_info)
-	{
-		if (!ptrset_contains(processed, dep_info->succ))
-			return false;
-	}
-	
-	return true;
-}
-
 static bool number_node_cb(lima_gp_ir_node_t* node, void* state)
 {
 	unsigned* count = state;
@@ -1108,8 +1227,7 @@ static bool number_node_cb(lima_gp_ir_node_t* node, void* state)
 	return true;
 }
 
-static bool schedule_block(lima_gp_ir_block_t* block, ptrset_t* moves_inserted,
-						   bool* success)
+static void number_nodes(lima_gp_ir_block_t* block)
 {
 	unsigned count = 0;
 	lima_gp_ir_root_node_t* root_node;
@@ -1118,94 +1236,388 @@ static bool schedule_block(lima_gp_ir_block_t* block, ptrset_t* moves_inserted,
 		lima_gp_ir_node_dfs(&root_node->node, NULL, number_node_cb,
 							(void*)&count);
 	}
+}
+
+static bool take_checkpoint(lima_gp_ir_block_t* block,
+							lima_gp_ir_node_t* node, ptrset_t processed_nodes)
+{
+	lima_gp_ir_sched_log_t* log = block->sched_log;
+	
+	if (log->num_checkpoints == log->checkpoints_capacity)
+	{
+		unsigned capacity = log->checkpoints_capacity ?
+			2 * log->checkpoints_capacity : 16;
+		checkpoint_t* checkpoints = realloc(log->checkpoints,
+											capacity * sizeof(checkpoint_t));
+		if (!checkpoints)
+			return false;
+		log->checkpoints = checkpoints;
+		log->checkpoints_capacity = capacity;
+	}
+	
+	checkpoint_t* checkpoint = &log->checkpoints[log->num_checkpoints];
+	checkpoint->num_instrs = block->num_instrs;
+	checkpoint->num_saved = log->num_saved;
+	checkpoint->num_moves = ptr_vector_size(log->moves);
+	checkpoint->num_placed = ptr_vector_size(log->placed);
+	checkpoint->first_succ = log->num_checkpoints;
+	checkpoint->inserted_reg = false;
+	
+	lima_gp_ir_dep_info_t* dep_info;
+	ptrset_iter_t iter = ptrset_iter_create(node->succs);
+	ptrset_iter_for_each(iter, dep_info)
+	{
+		if (ptrset_contains(processed_nodes, dep_info->succ) &&
+			dep_info->succ->sched_order < checkpoint->first_succ)
+			checkpoint->first_succ = dep_info->succ->sched_order;
+	}
+	
+	log->num_checkpoints++;
+	log->epoch++;
+	return true;
+}
+
+/* Marks the node just processed as placed, along with everything placed with
+ * it, which is whatever we can reach through its successors that hasn't been
+ * placed yet.
+ */
+
+static bool add_placed_nodes(lima_gp_ir_node_t* node,
+							 ptrset_t* processed_nodes,
+							 lima_gp_ir_sched_log_t* log)
+{
+	unsigned i = ptr_vector_size(log->placed);
+	unsigned sched_order = log->num_checkpoints - 1;
 	
-	priority_queue_t* queue = priority_queue_create(compare_nodes);
-	if (!queue)
+	if (!ptr_vector_add(&log->placed, node))
 		return false;
+	ptrset_add(processed_nodes, node);
 	
-	ptrset_t processed_nodes;
-	if (!ptrset_create(&processed_nodes))
+	for (; i < ptr_vector_size(log->placed); i++)
 	{
-		priority_queue_delete(queue);
+		lima_gp_ir_node_t* cur_node = ptr_vector_get(log->placed, i);
+		cur_node->sched_order = sched_order;
+		
+		lima_gp_ir_dep_info_t* dep_info;
+		ptrset_iter_t iter = ptrset_iter_create(cur_node->succs);
+		ptrset_iter_for_each(iter, dep_info)
+		{
+			if (ptrset_contains(*processed_nodes, dep_info->succ))
+				continue;
+			
+			if (!ptr_vector_add(&log->placed, dep_info->succ))
+				return false;
+			ptrset_add(processed_nodes, dep_info->succ);
+		}
+	}
+	
+	return true;
+}
+
+/* Figures out how far back we need to go after failing to schedule node.
+ * Its successors were placed without knowing it needed to go through a
+ * register, so they have to be redone, and so do the successors of every
+ * node after that point which had a register inserted, since the loads
+ * feeding them won't be there anymore.
+ *
+ * What's left of the schedule may still be in the way, though. So until we
+ * get past the node that failed, we don't insert any more registers, and if
+ * something else fails we start over from the beginning, like we would have
+ * if we hadn't tried to back up only part of the way.
+ */
+
+static unsigned find_rollback_target(lima_gp_ir_sched_log_t* log,
+									 lima_gp_ir_node_t* node)
+{
+	unsigned failed = log->num_checkpoints - 1;
+	
+	if (log->failed_node)
+	{
+		log->failed_node = NULL;
+		return 0;
+	}
+	log->failed_node = node;
+	
+	unsigned target = log->checkpoints[failed].first_succ;
+	unsigned i;
+	for (i = failed + 1; i-- > target; )
+	{
+		if (log->checkpoints[i].inserted_reg &&
+			log->checkpoints[i].first_succ < target)
+			target = log->checkpoints[i].first_succ;
+	}
+	
+	return target;
+}
+
+/* undoes everything done since the given checkpoint, except for the
+ * registers inserted
+ */
+
+static bool rollback(lima_gp_ir_block_t* block, ptrset_t* processed_nodes,
+					 unsigned target)
+{
+	lima_gp_ir_sched_log_t* log = block->sched_log;
+	checkpoint_t* checkpoint = &log->checkpoints[target];
+	unsigned i;
+	
+	//Forget about the nodes first, since undoing moves may delete some
+	for (i = checkpoint->num_placed; i < ptr_vector_size(log->placed); i++)
+		ptrset_remove(processed_nodes, ptr_vector_get(log->placed, i));
+	
+	ptr_vector_truncate(&log->placed, checkpoint->num_placed);
+	log->num_checkpoints = target;
+	
+	//Moves have to go before the instructions, since removing them touches the instructions
+	ptrset_t moves;
+	if (!ptrset_create(&moves))
+		return false;
+	
+	for (i = checkpoint->num_moves; i < ptr_vector_size(log->moves); i++)
+		ptrset_add(&moves, ptr_vector_get(log->moves, i));
+	
+	if (!undo_moves(&moves))
+	{
+		ptrset_delete(moves);
 		return false;
 	}
 	
-	bitset_t free_regs = lima_gp_ir_regalloc_get_free_regs(block);
+	ptrset_delete(moves);
+	ptr_vector_truncate(&log->moves, checkpoint->num_moves);
+	
+	restore_instrs(log, checkpoint->num_saved);
+	while (block->num_instrs > checkpoint->num_instrs)
+		lima_gp_ir_instr_delete(gp_ir_block_first_instr(block));
+	
+	return true;
+}
+
+static bool count_succs_left(lima_gp_ir_node_t* node, list_sched_t* sched,
+							 ptrset_t processed_nodes)
+{
+	unsigned succs_left = 0;
+	
+	lima_gp_ir_dep_info_t* dep_info;
+	ptrset_iter_t iter = ptrset_iter_create(node->succs);
+	ptrset_iter_for_each(iter, dep_info)
+	{
+		if (!ptrset_contains(processed_nodes, dep_info->succ))
+			succs_left++;
+	}
+	
+	list_sched_node(sched, node)->succs_left = succs_left;
+	return succs_left == 0;
+}
+
+/* Counts the successors left for every unprocessed node, and fills the ready
+ * list with the ones that don't have any. We walk the dependency graph rather
+ * than the expression trees, since register loads and moves inserted during
+ * scheduling may only be reachable through dependencies.
+ */
+
+static bool count_all_succs_left(lima_gp_ir_block_t* block,
+								 list_sched_t* sched, ptrset_t processed_nodes,
+								 bool fill)
+{
+	ptrset_t visited;
+	if (!ptrset_create(&visited))
+		return false;
+	
+	ptr_vector_t stack = ptr_vector_create();
+	bool ret = false;
 	
-	ptrset_iter_t iter = ptrset_iter_create(block->end_nodes);
 	lima_gp_ir_node_t* node;
+	ptrset_iter_t iter = ptrset_iter_create(block->end_nodes);
 	ptrset_iter_for_each(iter, node)
 	{
-		priority_queue_push(queue, (void*)node);
+		if (!ptr_vector_add(&stack, node))
+			goto cleanup;
 	}
 	
-	while (priority_queue_num_elems(queue))
+	while (ptr_vector_size(stack))
 	{
-		lima_gp_ir_node_t* node = priority_queue_pull(queue);
-		
-		bool result;
-		if (!try_schedule_node(node, free_regs, moves_inserted, &result))
-			return false;
-		
-		if (!result)
-		{
-			*success = false;
-			return true;
-		}
+		node = ptr_vector_get(stack, ptr_vector_size(stack) - 1);
+		ptr_vector_truncate(&stack, ptr_vector_size(stack) - 1);
 		
-		printf("processed node %u\n", node->index);
+		if (ptrset_contains(visited, node))
+			continue;
+		ptrset_add(&visited, node);
 		
-		ptrset_add(&processed_nodes, node);
+		if (!ptrset_contains(processed_nodes, node) &&
+			count_succs_left(node, sched, processed_nodes) && fill &&
+			!list_sched_push(sched, (void*)node))
+			goto cleanup;
 		
-		//Check if any predecessors are now processable
 		lima_gp_ir_dep_info_t* dep_info;
 		iter = ptrset_iter_create(node->preds);
 		ptrset_iter_for_each(iter, dep_info)
-			if (succs_processed(dep_info->pred, processed_nodes))
-				priority_queue_push(queue, (void*)dep_info->pred);
+		{
+			if (!ptr_vector_add(&stack, dep_info->pred))
+				goto cleanup;
+		}
 	}
 	
-	priority_queue_delete(queue);
-	ptrset_delete(processed_nodes);
-	bitset_delete(free_regs);
+	ret = true;
 	
-	*success = true;
-	return true;
+cleanup:
+	ptr_vector_delete(stack);
+	ptrset_delete(visited);
+	return ret;
 }
 
-static void delete_instrs(lima_gp_ir_block_t* block)
+static bool fill_ready_list(lima_gp_ir_block_t* block, list_sched_t* sched,
+							ptrset_t processed_nodes)
 {
-	while (block->num_instrs > 0)
-		lima_gp_ir_instr_delete(gp_ir_block_first_instr(block));
+	return list_sched_reset(sched) &&
+		count_all_succs_left(block, sched, processed_nodes, true);
 }
 
-bool lima_gp_ir_schedule_block(lima_gp_ir_block_t* block)
+static bool schedule_block(lima_gp_ir_block_t* block)
 {
-	ptrset_t moves_inserted;
-	if (!ptrset_create(&moves_inserted))
+	lima_gp_ir_sched_log_t* log = block->sched_log;
+	bool ret = false;
+	
+	list_sched_t sched;
+	if (!list_sched_create(&sched, compare_nodes,
+						   offsetof(lima_gp_ir_node_t, sched_node)))
 		return false;
 	
-	bool result = false;
-	while (!result)
+	ptrset_t processed_nodes;
+	if (!ptrset_create(&processed_nodes))
 	{
-		if (!lima_gp_ir_block_calc_crit_path(block))
-			return false;
-		if (!schedule_block(block, &moves_inserted, &result))
-			return false;
+		list_sched_delete(&sched);
+		return false;
+	}
+	
+	bitset_t free_regs = lima_gp_ir_regalloc_get_free_regs(block);
+	
+	if (!lima_gp_ir_block_calc_crit_path(block))
+		goto cleanup;
+	
+	number_nodes(block);
+	
+	if (!fill_ready_list(block, &sched, processed_nodes))
+		goto cleanup;
+	
+	lima_gp_ir_node_t* node;
+	while ((node = list_sched_pull(&sched)))
+	{
+		assert(!ptrset_contains(processed_nodes, node));
+		
+		if (!take_checkpoint(block, node, processed_nodes))
+			goto cleanup;
+		
+		bool result, inserted_reg;
+		if (!try_schedule_node(node, free_regs, !log->failed_node, &log->moves,
+							   &result, &inserted_reg))
+			goto cleanup;
+		
+		log->checkpoints[log->num_checkpoints - 1].inserted_reg = inserted_reg;
+		
 		if (!result)
 		{
-			if (!undo_moves(&moves_inserted))
-				return false;
+			unsigned target = find_rollback_target(log, node);
+			unsigned num_undone = log->num_checkpoints - 1 - target;
+			
+			block->prog->sched_restarts++;
+			block->prog->sched_nodes_undone += num_undone;
+			lima_trace(lima_trace_sched, "\nbacking up %u nodes...\n\n",
+					   num_undone);
+			
+			if (!rollback(block, &processed_nodes, target))
+				goto cleanup;
+			
+			//The registers inserted are still there and need to be scheduled
+			if (!lima_gp_ir_block_calc_crit_path(block))
+				goto cleanup;
 			
-			ptrset_empty(&moves_inserted);
+			bitset_delete(free_regs);
+			free_regs = lima_gp_ir_regalloc_get_free_regs(block);
 			
-			delete_instrs(block);
-			printf("\nrestarting...\n\n");
+			number_nodes(block);
+			
+			if (!fill_ready_list(block, &sched, processed_nodes))
+				goto cleanup;
+			
+			continue;
+		}
+		
+		lima_trace(lima_trace_sched, "processed node %u\n", node->index);
+		
+		unsigned first_placed = ptr_vector_size(log->placed);
+		if (!add_placed_nodes(node, &processed_nodes, log))
+			goto cleanup;
+		
+		if (node == log->failed_node)
+			log->failed_node = NULL;
+		
+		//Putting the node through a register rewired the dependency graph,
+		//so the successor counts have to be redone from scratch. Otherwise,
+		//everything placed is one less successor left for its predecessors.
+		if (inserted_reg &&
+			!count_all_succs_left(block, &sched, processed_nodes, false))
+			goto cleanup;
+		
+		unsigned i;
+		for (i = first_placed; i < ptr_vector_size(log->placed); i++)
+		{
+			lima_gp_ir_node_t* placed = ptr_vector_get(log->placed, i);
+			
+			lima_gp_ir_dep_info_t* dep_info;
+			ptrset_iter_t iter = ptrset_iter_create(placed->preds);
+			ptrset_iter_for_each(iter, dep_info)
+			{
+				lima_gp_ir_node_t* pred = dep_info->pred;
+				if (ptrset_contains(processed_nodes, pred))
+					continue;
+				
+				if (!inserted_reg)
+				{
+					if (!list_sched_succ_done(&sched, (void*)pred))
+						goto cleanup;
+				}
+				else if (list_sched_node(&sched, pred)->succs_left == 0)
+				{
+					if (!list_sched_push(&sched, (void*)pred))
+						goto cleanup;
+				}
+			}
 		}
 	}
 	
-	ptrset_delete(moves_inserted);
-	return true;
+	ret = true;
+	
+cleanup:
+	list_sched_delete(&sched);
+	ptrset_delete(processed_nodes);
+	bitset_delete(free_regs);
+	return ret;
+}
+
+bool lima_gp_ir_schedule_block(lima_gp_ir_block_t* block)
+{
+	lima_gp_ir_sched_log_t log = {
+		.epoch = 0,
+		.saved = NULL,
+		.num_saved = 0,
+		.saved_capacity = 0,
+		.checkpoints = NULL,
+		.num_checkpoints = 0,
+		.checkpoints_capacity = 0,
+		.placed = ptr_vector_create(),
+		.moves = ptr_vector_create(),
+		.failed_node = NULL
+	};
+	
+	block->sched_log = &log;
+	bool ret = schedule_block(block);
+	block->sched_log = NULL;
+	
+	free(log.saved);
+	free(log.checkpoints);
+	ptr_vector_delete(log.placed);
+	ptr_vector_delete(log.moves);
+	return ret;
 }
 
 bool lima_gp_ir_schedule_prog(lima_gp_ir_prog_t* prog)
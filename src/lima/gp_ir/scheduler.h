@@ -117,6 +117,9 @@ typedef struct
 	/* Passthrough slot */
 	
 	lima_gp_ir_node_t* pass_slot;
+	
+	/* the last checkpoint the scheduler saved this instruction for */
+	unsigned sched_epoch;
 } lima_gp_ir_instr_t;
 
 #define gp_ir_block_for_each_instr(block, instr) \
@@ -136,6 +139,9 @@ typedef struct
 
 bool lima_gp_ir_prog_calc_dependencies(lima_gp_ir_prog_t* prog);
 bool lima_gp_ir_block_calc_dependencies(lima_gp_ir_block_t* block);
+/* dependencies live in the program's arena; alloc sets pred */
+lima_gp_ir_dep_info_t* lima_gp_ir_dep_info_alloc(lima_gp_ir_node_t* pred);
+void lima_gp_ir_dep_info_free(lima_gp_ir_dep_info_t* dep_info);
 bool lima_gp_ir_dep_info_insert(lima_gp_ir_dep_info_t* dep_info);
 void lima_gp_ir_dep_info_delete(lima_gp_ir_dep_info_t* dep_info);
 lima_gp_ir_dep_info_t* lima_gp_ir_dep_info_find(lima_gp_ir_node_t* pred,
@@ -150,7 +156,7 @@ unsigned lima_gp_ir_dep_info_get_max_dist(lima_gp_ir_dep_info_t* dep_info);
 bool lima_gp_ir_block_calc_crit_path(lima_gp_ir_block_t* block);
 bool lima_gp_ir_prog_calc_crit_path(lima_gp_ir_prog_t* prog);
 
-lima_gp_ir_instr_t* lima_gp_ir_instr_create(void);
+lima_gp_ir_instr_t* lima_gp_ir_instr_create(lima_gp_ir_prog_t* prog);
 void lima_gp_ir_instr_insert_start(
 	lima_gp_ir_block_t* block, lima_gp_ir_instr_t* instr);
 void lima_gp_ir_instr_insert_end(
@@ -83,7 +83,7 @@ static bool insert_phi_nodes(lima_gp_ir_reg_t* reg)
 	ptrset_iter_for_each(iter, block)
 	{
 		lima_gp_ir_phi_node_t* phi_node =
-			lima_gp_ir_phi_node_create(block->num_preds);
+			lima_gp_ir_phi_node_create(block->prog, block->num_preds);
 		if (!phi_node)
 		{
 			ptrset_delete(blocks);
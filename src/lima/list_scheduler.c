@@ -0,0 +1,79 @@
+/* Author(s):
+ *   Connor Abbott (connor@abbott.cx)
+ *
+ * Copyright (c) 2014 Connor Abbott (connor@abbott.cx)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "list_scheduler.h"
+#include <assert.h>
+
+bool list_sched_create(list_sched_t* sched, compare_cb priority, size_t offset)
+{
+	sched->ready = priority_queue_create(priority);
+	if (!sched->ready)
+		return false;
+	
+	sched->priority = priority;
+	sched->offset = offset;
+	return true;
+}
+
+void list_sched_delete(list_sched_t* sched)
+{
+	priority_queue_delete(sched->ready);
+}
+
+bool list_sched_reset(list_sched_t* sched)
+{
+	priority_queue_delete(sched->ready);
+	sched->ready = priority_queue_create(sched->priority);
+	return sched->ready != NULL;
+}
+
+bool list_sched_add(list_sched_t* sched, void* node, unsigned succs_left)
+{
+	list_sched_node(sched, node)->succs_left = succs_left;
+	if (succs_left == 0)
+		return priority_queue_push(sched->ready, node);
+	
+	return true;
+}
+
+bool list_sched_push(list_sched_t* sched, void* node)
+{
+	return priority_queue_push(sched->ready, node);
+}
+
+bool list_sched_succ_done(list_sched_t* sched, void* node)
+{
+	list_sched_node_t* sched_node = list_sched_node(sched, node);
+	
+	assert(sched_node->succs_left > 0);
+	if (--sched_node->succs_left == 0)
+		return priority_queue_push(sched->ready, node);
+	
+	return true;
+}
+
+void* list_sched_pull(list_sched_t* sched)
+{
+	return priority_queue_pull(sched->ready);
+}
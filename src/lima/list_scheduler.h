@@ -0,0 +1,82 @@
+/* Author(s):
+ *   Connor Abbott (connor@abbott.cx)
+ *
+ * Copyright (c) 2014 Connor Abbott (connor@abbott.cx)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef __list_scheduler_h__
+#define __list_scheduler_h__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "priority_queue.h"
+
+/*
+ * list_scheduler.h
+ *
+ * The bookkeeping shared by the list schedulers in the backends. They all
+ * schedule bottom-up, so a node is ready once every one of its successors
+ * has been scheduled. Each node embeds a list_sched_node_t counting how many
+ * of its successors are left, which the scheduler decrements as they are
+ * scheduled, so that the node joins the ready list exactly once, when it
+ * drops to zero. Which ready node goes next is up to the priority function,
+ * which is the same kind the priority queue takes.
+ */
+
+typedef struct {
+	unsigned succs_left;
+} list_sched_node_t;
+
+typedef struct {
+	priority_queue_t* ready;
+	compare_cb priority;
+	size_t offset; /* of the list_sched_node_t in each node */
+} list_sched_t;
+
+bool list_sched_create(list_sched_t* sched, compare_cb priority, size_t offset);
+void list_sched_delete(list_sched_t* sched);
+
+/* empties the ready list, for starting over */
+bool list_sched_reset(list_sched_t* sched);
+
+static inline list_sched_node_t* list_sched_node(list_sched_t* sched,
+												 void* node)
+{
+	return (list_sched_node_t*) ((char*) node + sched->offset);
+}
+
+/* sets how many successors of node haven't been scheduled yet, making the
+ * node ready if there aren't any
+ */
+bool list_sched_add(list_sched_t* sched, void* node, unsigned succs_left);
+
+/* puts the node on the ready list directly */
+bool list_sched_push(list_sched_t* sched, void* node);
+
+/* called once for each dependency of node on a successor that was just
+ * scheduled
+ */
+bool list_sched_succ_done(list_sched_t* sched, void* node);
+
+/* returns the highest priority ready node, or NULL if there are none */
+void* list_sched_pull(list_sched_t* sched);
+
+#endif
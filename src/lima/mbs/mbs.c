@@ -32,27 +32,90 @@ typedef struct {
 	uint32_t size;
 } mbs_header_t;
 
+/*
+ * A piece of a chunk's contents: either a child chunk, or a run of bytes
+ * that's either in someone else's buffer or in the chunk's own copies. Copies
+ * are kept as an offset, since the buffer moves as it grows.
+ */
+
+typedef enum {
+	mbs_piece_chunk,
+	mbs_piece_ref,
+	mbs_piece_copy
+} mbs_piece_type_e;
+
+typedef struct {
+	mbs_piece_type_e type;
+	union {
+		mbs_chunk_t* chunk;
+		const void* data;
+		unsigned offset;
+	};
+	unsigned size;
+} mbs_piece_t;
+
+struct mbs_chunk_s {
+	mbs_header_t header; /* the size is only valid while exporting */
+	
+	mbs_piece_t* pieces;
+	unsigned num_pieces, pieces_capacity;
+	
+	char* copies;
+	unsigned copies_size, copies_capacity;
+};
+
 mbs_chunk_t* mbs_chunk_create(char* ident)
 {
-	mbs_chunk_t* chunk = malloc(sizeof(mbs_chunk_t));
+	mbs_chunk_t* chunk = calloc(1, sizeof(mbs_chunk_t));
 	if (!chunk)
 		return NULL;
 	
-	memcpy(&chunk->ident, ident, 4);
-	chunk->data = NULL;
-	chunk->size = 0;
+	memcpy(&chunk->header.ident, ident, 4);
 	
 	return chunk;
 }
 
 void mbs_chunk_delete(mbs_chunk_t* chunk)
 {
-	free(chunk->data);
+	if (!chunk)
+		return;
+	
+	unsigned i;
+	for (i = 0; i < chunk->num_pieces; i++)
+		if (chunk->pieces[i].type == mbs_piece_chunk)
+			mbs_chunk_delete(chunk->pieces[i].chunk);
+	
+	free(chunk->pieces);
+	free(chunk->copies);
 	free(chunk);
 }
 
+static mbs_piece_t* add_piece(mbs_chunk_t* chunk, mbs_piece_type_e type,
+							  unsigned size)
+{
+	if (chunk->num_pieces == chunk->pieces_capacity)
+	{
+		unsigned new_capacity =
+			chunk->pieces_capacity ? 2 * chunk->pieces_capacity : 4;
+		mbs_piece_t* new_pieces = realloc(chunk->pieces,
+										  new_capacity * sizeof(mbs_piece_t));
+		if (!new_pieces)
+			return NULL;
+		
+		chunk->pieces = new_pieces;
+		chunk->pieces_capacity = new_capacity;
+	}
+	
+	mbs_piece_t* piece = &chunk->pieces[chunk->num_pieces++];
+	piece->type = type;
+	piece->size = size;
+	return piece;
+}
+
 mbs_chunk_t* mbs_chunk_string(const char* string)
 {
+	static const char zeros[4];
+	
 	mbs_chunk_t* chunk = mbs_chunk_create("STRI");
 	if (!chunk)
 		return NULL;
@@ -60,54 +123,167 @@ mbs_chunk_t* mbs_chunk_string(const char* string)
 	unsigned size = strlen(string) + 1;
 	//round up to nearest multiple of 4
 	unsigned aligned_size = (size + 3) & ~3;
-	chunk->data = calloc(aligned_size, 1);
-	if (!chunk->data)
+	if (!mbs_chunk_append_ref(chunk, string, size) ||
+		!mbs_chunk_append_ref(chunk, zeros, aligned_size - size))
 	{
-		free(chunk);
+		mbs_chunk_delete(chunk);
 		return NULL;
 	}
-	chunk->size = aligned_size;
-	
-	memcpy(chunk->data, string, size);
 	
 	return chunk;
 }
 
 bool mbs_chunk_append(mbs_chunk_t* chunk, mbs_chunk_t* append)
 {
-	chunk->data = realloc(chunk->data,
-						  chunk->size + sizeof(mbs_header_t) + append->size);
-	if (!chunk->data)
+	mbs_piece_t* piece = add_piece(chunk, mbs_piece_chunk, 0);
+	if (!piece)
 		return false;
 	
-	mbs_chunk_export(append, chunk->data + chunk->size);
-	chunk->size += sizeof(mbs_header_t) + append->size;
-	mbs_chunk_delete(append);
+	piece->chunk = append;
+	return true;
+}
+
+bool mbs_chunk_append_data(mbs_chunk_t* chunk, const void* data,
+						   unsigned size)
+{
+	if (size == 0)
+		return true;
+	
+	if (chunk->copies_size + size > chunk->copies_capacity)
+	{
+		unsigned new_capacity = chunk->copies_capacity ?
+			chunk->copies_capacity : 64;
+		while (new_capacity < chunk->copies_size + size)
+			new_capacity *= 2;
+		char* new_copies = realloc(chunk->copies, new_capacity);
+		if (!new_copies)
+			return false;
+		
+		chunk->copies = new_copies;
+		chunk->copies_capacity = new_capacity;
+	}
+	
+	/* consecutive copies become a single piece */
+	mbs_piece_t* last = chunk->num_pieces ?
+		&chunk->pieces[chunk->num_pieces - 1] : NULL;
+	if (last && last->type == mbs_piece_copy &&
+		last->offset + last->size == chunk->copies_size)
+		last->size += size;
+	else
+	{
+		mbs_piece_t* piece = add_piece(chunk, mbs_piece_copy, size);
+		if (!piece)
+			return false;
+		
+		piece->offset = chunk->copies_size;
+	}
+	
+	memcpy(chunk->copies + chunk->copies_size, data, size);
+	chunk->copies_size += size;
 	return true;
 }
 
-bool mbs_chunk_append_data(mbs_chunk_t* chunk, void* data, unsigned size)
+bool mbs_chunk_append_ref(mbs_chunk_t* chunk, const void* data,
+						  unsigned size)
 {
-	chunk->data = realloc(chunk->data, chunk->size + size);
+	if (size == 0)
+		return true;
 	
-	if (!chunk->data)
+	mbs_piece_t* piece = add_piece(chunk, mbs_piece_ref, size);
+	if (!piece)
 		return false;
 	
-	memcpy(chunk->data + chunk->size, data, size);
-	chunk->size += size;
+	piece->data = data;
 	return true;
 }
 
+/* fills in the size in the headers of the chunk and all its children */
+
+static unsigned compute_size(mbs_chunk_t* chunk)
+{
+	uint32_t size = 0;
+	
+	unsigned i;
+	for (i = 0; i < chunk->num_pieces; i++)
+	{
+		mbs_piece_t* piece = &chunk->pieces[i];
+		if (piece->type == mbs_piece_chunk)
+			size += compute_size(piece->chunk);
+		else
+			size += piece->size;
+	}
+	
+	chunk->header.size = size;
+	return size + sizeof(mbs_header_t);
+}
+
 unsigned mbs_chunk_size(mbs_chunk_t* chunk)
 {
-	return chunk->size + sizeof(mbs_header_t);
+	return compute_size(chunk);
+}
+
+/*
+ * Hands each piece of the exported chunk to emit() in order, after
+ * compute_size() has been run. Stops early if emit() fails.
+ */
+
+typedef bool (*emit_cb)(const void* data, unsigned size, void* state);
+
+static bool walk(mbs_chunk_t* chunk, emit_cb emit, void* state)
+{
+	if (!emit(&chunk->header, sizeof(mbs_header_t), state))
+		return false;
+	
+	unsigned i;
+	for (i = 0; i < chunk->num_pieces; i++)
+	{
+		mbs_piece_t* piece = &chunk->pieces[i];
+		bool ret;
+		switch (piece->type)
+		{
+			case mbs_piece_chunk:
+				ret = walk(piece->chunk, emit, state);
+				break;
+				
+			case mbs_piece_ref:
+				ret = emit(piece->data, piece->size, state);
+				break;
+				
+			case mbs_piece_copy:
+			default:
+				ret = emit(chunk->copies + piece->offset, piece->size, state);
+				break;
+		}
+		
+		if (!ret)
+			return false;
+	}
+	
+	return true;
+}
+
+static bool emit_memory(const void* data, unsigned size, void* state)
+{
+	char** pos = state;
+	memcpy(*pos, data, size);
+	*pos += size;
+	return true;
 }
 
 void mbs_chunk_export(mbs_chunk_t* chunk, void* data)
 {
-	mbs_header_t header;
-	memcpy(&header.ident, &chunk->ident, 4);
-	header.size = chunk->size;
-	memcpy(data, &header, sizeof(mbs_header_t));
-	memcpy((char*) data + sizeof(mbs_header_t), chunk->data, chunk->size);
+	char* pos = data;
+	compute_size(chunk);
+	walk(chunk, emit_memory, &pos);
+}
+
+static bool emit_file(const void* data, unsigned size, void* state)
+{
+	return fwrite(data, 1, size, (FILE*) state) == size;
+}
+
+bool mbs_chunk_write(mbs_chunk_t* chunk, FILE* fp)
+{
+	compute_size(chunk);
+	return walk(chunk, emit_file, fp);
 }
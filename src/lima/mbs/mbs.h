@@ -26,24 +26,38 @@
 #define __MBS_H__
 
 #include <stdbool.h>
+#include <stdio.h>
 
-typedef struct {
-	char ident[4];
-	unsigned size;
-	char* data;
-} mbs_chunk_t;
+/*
+ * MBS files are a tree of chunks, each a four-character ident and a size
+ * followed by the contents, which may include other chunks. Writing one
+ * happens in two phases: first the tree is built, with the contents
+ * referencing existing buffers where possible, and then the sizes are
+ * computed in one pass and the pieces are written out in order, straight to
+ * the destination, without assembling the file anywhere in between.
+ */
+
+struct mbs_chunk_s;
+typedef struct mbs_chunk_s mbs_chunk_t;
 
 mbs_chunk_t* mbs_chunk_create(char* ident);
 void mbs_chunk_delete(mbs_chunk_t* chunk);
 
-//creates a chunk of type STRI
+//creates a chunk of type STRI, which references the string
 mbs_chunk_t* mbs_chunk_string(const char* string);
 
-//insert one chunk inside another - deletes the chunk being inserted
+//insert one chunk inside another - the chunk being inserted is deleted
+//along with its parent
 bool mbs_chunk_append(mbs_chunk_t* chunk, mbs_chunk_t* append);
 
-//insert binary data inside a chunk
-bool mbs_chunk_append_data(mbs_chunk_t* chunk, void* data, unsigned size);
+//insert a copy of binary data inside a chunk, for small temporaries
+bool mbs_chunk_append_data(mbs_chunk_t* chunk, const void* data,
+						   unsigned size);
+
+//insert binary data inside a chunk without copying it, the data must
+//outlive the chunk
+bool mbs_chunk_append_ref(mbs_chunk_t* chunk, const void* data,
+						  unsigned size);
 
 //returns the total amount of bytes needed to hold the exported chunk
 unsigned mbs_chunk_size(mbs_chunk_t* chunk);
@@ -51,4 +65,7 @@ unsigned mbs_chunk_size(mbs_chunk_t* chunk);
 //exports a chunk to an allocated piece of memory
 void mbs_chunk_export(mbs_chunk_t* chunk, void* data);
 
+//writes a chunk to a file
+bool mbs_chunk_write(mbs_chunk_t* chunk, FILE* fp);
+
 #endif
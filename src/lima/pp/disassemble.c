@@ -34,11 +34,11 @@
 #include <stdlib.h>
 #include <stdio.h>
 
-static void print_tabs(unsigned tabs)
+static void print_tabs(string_buf_t* buf, unsigned tabs)
 {
 	unsigned i;
 	for (i = 0; i < tabs; i++)
-		printf("\t");
+		string_buf_printf(buf, "\t");
 }
 
 const char* lima_pp_field_name[] =
@@ -59,9 +59,18 @@ const char* lima_pp_field_name[] =
 
 unsigned lima_pp_field_size[] =
 {
-	34, 62, 41, 43,
-	30, 44, 31, 30,
-	41, 73, 64, 64,
+	lima_pp_field_varying_size,
+	lima_pp_field_sampler_size,
+	lima_pp_field_uniform_size,
+	lima_pp_field_vec4_mul_size,
+	lima_pp_field_float_mul_size,
+	lima_pp_field_vec4_acc_size,
+	lima_pp_field_float_acc_size,
+	lima_pp_field_combine_size,
+	lima_pp_field_temp_write_size,
+	lima_pp_field_branch_size,
+	lima_pp_field_vec4_const_0_size,
+	lima_pp_field_vec4_const_1_size,
 };
 
 
@@ -75,7 +84,7 @@ lima_pp_asm_op_t lima_pp_vec4_mul_asm_op[] =
 	{ "mul", "*" , 1, 1 },
 	{ "mul", "*" , 1, 1 },
 	{ "mul", "*" , 1, 1 },
-
+	
 	{ "not", "!" , 0, 1 },
 	{ NULL , NULL, 1, 1 },
 	{ NULL , NULL, 1, 1 },
@@ -84,7 +93,7 @@ lima_pp_asm_op_t lima_pp_vec4_mul_asm_op[] =
 	{ "lt" , "<" , 1, 1 },
 	{ "le" , "<=", 1, 1 },
 	{ "eq" , "==", 1, 1 },
-
+	
 	{ "min", NULL, 1, 1 },
 	{ "max", NULL, 1, 1 },
 	{ NULL , NULL, 1, 1 },
@@ -93,7 +102,7 @@ lima_pp_asm_op_t lima_pp_vec4_mul_asm_op[] =
 	{ NULL , NULL, 1, 1 },
 	{ NULL , NULL, 1, 1 },
 	{ NULL , NULL, 1, 1 },
-
+	
 	{ NULL , NULL, 1, 1 },
 	{ NULL , NULL, 1, 1 },
 	{ NULL , NULL, 1, 1 },
@@ -114,7 +123,7 @@ lima_pp_asm_op_t lima_pp_vec4_acc_asm_op[] =
 	{ NULL   , NULL, 1, 1 },
 	{ NULL   , NULL, 1, 1 },
 	{ NULL   , NULL, 1, 1 },
-
+	
 	{ "ne"   , "!=", 1, 1 },
 	{ "lt"   , "<" , 1, 1 },
 	{ "le"   , "<=", 1, 1 },
@@ -123,7 +132,7 @@ lima_pp_asm_op_t lima_pp_vec4_acc_asm_op[] =
 	{ "ceil" , NULL, 0, 1 },
 	{ "min"  , NULL, 1, 1 },
 	{ "max"  , NULL, 1, 1 },
-
+	
 	{ "sum3", NULL, 0, 1 },
 	{ "sum" , NULL, 0, 1 },
 	{ NULL  , NULL, 1, 1 },
@@ -132,7 +141,7 @@ lima_pp_asm_op_t lima_pp_vec4_acc_asm_op[] =
 	{ "dFdy", NULL, 1, 1 },
 	{ NULL  , NULL, 1, 1 },
 	{ "sel" , ":" , 1, 1 },
-
+	
 	{ NULL , NULL, 1, 1 },
 	{ NULL , NULL, 1, 1 },
 	{ NULL , NULL, 1, 1 },
@@ -153,7 +162,7 @@ lima_pp_asm_op_t lima_pp_float_mul_asm_op[] =
 	{ "mul", "*" , 1, 1 },
 	{ "mul", "*" , 1, 1 },
 	{ "mul", "*" , 1, 1 },
-
+	
 	{ "not", "!" , 0, 1 },
 	{ NULL , NULL, 1, 1 },
 	{ NULL , NULL, 1, 1 },
@@ -162,7 +171,7 @@ lima_pp_asm_op_t lima_pp_float_mul_asm_op[] =
 	{ "lt" , "<" , 1, 1 },
 	{ "le" , "<=", 1, 1 },
 	{ "eq" , "==", 1, 1 },
-
+	
 	{ "min", NULL, 1, 1 },
 	{ "max", NULL, 1, 1 },
 	{ NULL , NULL, 1, 1 },
@@ -171,7 +180,7 @@ lima_pp_asm_op_t lima_pp_float_mul_asm_op[] =
 	{ NULL , NULL, 1, 1 },
 	{ NULL , NULL, 1, 1 },
 	{ NULL , NULL, 1, 1 },
-
+	
 	{ NULL , NULL, 1, 1 },
 	{ NULL , NULL, 1, 1 },
 	{ NULL , NULL, 1, 1 },
@@ -192,7 +201,7 @@ lima_pp_asm_op_t lima_pp_float_acc_asm_op[] =
 	{ NULL   , NULL, 1, 1 },
 	{ NULL   , NULL, 1, 1 },
 	{ NULL   , NULL, 1, 1 },
-
+	
 	{ "ne"   , "!=", 1, 1 },
 	{ "lt"   , "<" , 1, 1 },
 	{ "le"   , "<=", 1, 1 },
@@ -201,7 +210,7 @@ lima_pp_asm_op_t lima_pp_float_acc_asm_op[] =
 	{ "ceil" , NULL, 0, 1 },
 	{ "min"  , NULL, 1, 1 },
 	{ "max"  , NULL, 1, 1 },
-
+	
 	{ NULL  , NULL, 1, 1 },
 	{ NULL  , NULL, 1, 1 },
 	{ NULL  , NULL, 1, 1 },
@@ -210,7 +219,7 @@ lima_pp_asm_op_t lima_pp_float_acc_asm_op[] =
 	{ "dFdy", NULL, 1, 1 },
 	{ NULL  , NULL, 1, 1 },
 	{ NULL  , NULL, 1, 1 },
-
+	
 	{ NULL , NULL, 1, 1 },
 	{ NULL , NULL, 1, 1 },
 	{ NULL , NULL, 1, 1 },
@@ -231,7 +240,7 @@ lima_pp_asm_op_t lima_pp_combine_asm_op[] =
 	{ "log2", NULL, 0, 1 },
 	{ "sin", NULL, 0, 1 },
 	{ "cos", NULL, 0, 1 },
-
+	
 	{ NULL, NULL, 1, 1 },
 	{ NULL, NULL, 1, 1 },
 	{ NULL, NULL, 1, 1 },
@@ -244,133 +253,133 @@ lima_pp_asm_op_t lima_pp_combine_asm_op[] =
 
 
 
-static void _print_bin_u32n(uint32_t mask, unsigned size)
+static void _print_bin_u32n(string_buf_t* buf, uint32_t mask, unsigned size)
 {
 	unsigned i = size;
 	for (i = size; i--;)
-		printf("%u", (unsigned)((mask >> i) & 1));
+		string_buf_printf(buf, "%u", (unsigned)((mask >> i) & 1));
 }
 
-static void _print_bin_un(uint32_t* mask, unsigned size)
+static void _print_bin_un(string_buf_t* buf, uint32_t* mask, unsigned size)
 {
-	_print_bin_u32n(mask[size >> 5], (size & 31));
+	_print_bin_u32n(buf, mask[size >> 5], (size & 31));
 	for (size >>= 5; size; size--)
-		_print_bin_u32n(mask[size - 1], 32);
+		_print_bin_u32n(buf, mask[size - 1], 32);
 }
 
 
 
-static void _lima_pp_field_print_swizzle(uint8_t swizzle)
+static void _lima_pp_field_print_swizzle(string_buf_t* buf, uint8_t swizzle)
 {
 	if (swizzle == 0xE4)
 		return;
-
-	printf(".");
+	
+	string_buf_printf(buf, ".");
 	char symbol[4] = { 'x', 'y', 'z', 'w' };
 	unsigned i;
 	for (i = 0; i < 4; i++, swizzle >>= 2)
-		printf("%c", symbol[swizzle & 3]);
+		string_buf_printf(buf, "%c", symbol[swizzle & 3]);
 }
 
-static void _lima_pp_field_print_mask(uint8_t mask)
+static void _lima_pp_field_print_mask(string_buf_t* buf, uint8_t mask)
 {
 	if (mask == 0xF)
 		return;
-	printf(".");
-	if (mask & 1) printf("x");
-	if (mask & 2) printf("y");
-	if (mask & 4) printf("z");
-	if (mask & 8) printf("w");
+	string_buf_printf(buf, ".");
+	if (mask & 1) string_buf_printf(buf, "x");
+	if (mask & 2) string_buf_printf(buf, "y");
+	if (mask & 4) string_buf_printf(buf, "z");
+	if (mask & 8) string_buf_printf(buf, "w");
 }
 
 
 
 static void _lima_pp_field_print_reg_name(
-	lima_pp_vec4_reg_e reg, const char* special,
+	string_buf_t* buf, lima_pp_vec4_reg_e reg, const char* special,
 	bool verbose)
 {
 	if (special)
 	{
-		printf("%s", special);
+		string_buf_printf(buf, "%s", special);
 	} else {
 		switch (reg)
 		{
 			case lima_pp_vec4_reg_constant0:
-				printf("^const0");
+				string_buf_printf(buf, "^const0");
 				break;
 			case lima_pp_vec4_reg_constant1:
-				printf("^const1");
+				string_buf_printf(buf, "^const1");
 				break;
 			case lima_pp_vec4_reg_texture:
 				if (verbose)
-					printf("^texture");
+					string_buf_printf(buf, "^texture");
 				else
-					printf("^tex_sampler");
+					string_buf_printf(buf, "^tex_sampler");
 				break;
 			case lima_pp_vec4_reg_uniform:
 				if (verbose)
-					printf("^uniform");
+					string_buf_printf(buf, "^uniform");
 				else
-					printf("^u");
+					string_buf_printf(buf, "^u");
 				break;
 			default:
-				printf("$%u", reg);
+				string_buf_printf(buf, "$%u", reg);
 				break;
 		}
 	}
 }
 
 static void _lima_pp_field_print_reg_source(
-	lima_pp_vec4_reg_e reg, const char* special,
+	string_buf_t* buf, lima_pp_vec4_reg_e reg, const char* special,
 	uint8_t swizzle, bool abs, bool neg,
 	bool verbose)
 {
 	if (neg)
-		printf("-");
+		string_buf_printf(buf, "-");
 	if (abs)
-		printf("abs(");
-
+		string_buf_printf(buf, "abs(");
+	
 	_lima_pp_field_print_reg_name(
-		reg, special, verbose);
-
-	_lima_pp_field_print_swizzle(swizzle);
+		buf, reg, special, verbose);
+	
+	_lima_pp_field_print_swizzle(buf, swizzle);
 	if (abs)
-		printf(")");
+		string_buf_printf(buf, ")");
 }
 
 static void _lima_pp_field_print_reg_source_scalar(
-	unsigned reg, const char* special,
+	string_buf_t* buf, unsigned reg, const char* special,
 	bool abs, bool neg,
 	bool verbose)
 {
 	if (neg)
-		printf("-");
+		string_buf_printf(buf, "-");
 	if (abs)
-		printf("abs(");
-
+		string_buf_printf(buf, "abs(");
+	
 	_lima_pp_field_print_reg_name(
-		(reg >> 2), special, verbose);
+		buf, (reg >> 2), special, verbose);
 	if (!special)
 	{
 		static const char c[4] = "xyzw";
-		printf(".%c", c[reg & 3]);
+		string_buf_printf(buf, ".%c", c[reg & 3]);
 	}
 	if (abs)
-		printf(")");
+		string_buf_printf(buf, ")");
 }
 
-static void _lima_pp_field_print_outmod_d3d(lima_pp_outmod_e modifier)
+static void _lima_pp_field_print_outmod_d3d(string_buf_t* buf, lima_pp_outmod_e modifier)
 {
 	switch (modifier)
 	{
 		case lima_pp_outmod_clamp_fraction:
-			printf("_sat");
+			string_buf_printf(buf, "_sat");
 			break;
 		case lima_pp_outmod_clamp_positive:
-			printf("_pos");
+			string_buf_printf(buf, "_pos");
 			break;
 		case lima_pp_outmod_round:
-			printf("_int");
+			string_buf_printf(buf, "_int");
 			break;
 		default:
 			break;
@@ -378,43 +387,43 @@ static void _lima_pp_field_print_outmod_d3d(lima_pp_outmod_e modifier)
 }
 
 static void _lima_pp_field_print_reg_dest_scalar(
-	unsigned reg,
+	string_buf_t* buf, unsigned reg,
 	lima_pp_outmod_e modifier)
 {
-	printf("$%u", (reg >> 2));
-	_lima_pp_field_print_outmod_d3d(modifier);
+	string_buf_printf(buf, "$%u", (reg >> 2));
+	_lima_pp_field_print_outmod_d3d(buf, modifier);
 	static const char c[4] = "xyzw";
-	printf(".%c", c[reg & 3]);
+	string_buf_printf(buf, ".%c", c[reg & 3]);
 }
 
-static void _lima_pp_field_print_outmod_start(lima_pp_outmod_e modifier)
+static void _lima_pp_field_print_outmod_start(string_buf_t* buf, lima_pp_outmod_e modifier)
 {
 	switch (modifier)
 	{
 		case lima_pp_outmod_clamp_fraction:
-			printf("clamp(");
+			string_buf_printf(buf, "clamp(");
 			break;
 		case lima_pp_outmod_clamp_positive:
-			printf("max(0.0, ");
+			string_buf_printf(buf, "max(0.0, ");
 			break;
 		case lima_pp_outmod_round:
-			printf("round(");
+			string_buf_printf(buf, "round(");
 			break;
 		default:
 			break;
 	}
 }
 
-static void _lima_pp_field_print_outmod_end(lima_pp_outmod_e modifier)
+static void _lima_pp_field_print_outmod_end(string_buf_t* buf, lima_pp_outmod_e modifier)
 {
 	switch (modifier)
 	{
 		case lima_pp_outmod_clamp_fraction:
-			printf(", 0.0, 1.0)");
+			string_buf_printf(buf, ", 0.0, 1.0)");
 			break;
 		case lima_pp_outmod_clamp_positive:
 		case lima_pp_outmod_round:
-			printf(")");
+			string_buf_printf(buf, ")");
 			break;
 		default:
 			break;
@@ -424,84 +433,84 @@ static void _lima_pp_field_print_outmod_end(lima_pp_outmod_e modifier)
 
 
 static void _lima_pp_field_print_const(
-	lima_pp_field_e field,
+	string_buf_t* buf, lima_pp_field_e field,
 	lima_pp_vec4_t* vector,
 	bool verbose)
 {
 	if (verbose)
-		printf("^");
-	printf("const%u ", (field - lima_pp_field_vec4_const_0));
+		string_buf_printf(buf, "^");
+	string_buf_printf(buf, "const%u ", (field - lima_pp_field_vec4_const_0));
 	if (verbose)
-		printf("= vec4(");
-	
-	printf("%g", ogt_hfloat_to_float(vector->x));
-	if (verbose) printf(",");
-	printf(" %g", ogt_hfloat_to_float(vector->y));
-	if (verbose) printf(",");
-	printf(" %g", ogt_hfloat_to_float(vector->z));
-	if (verbose) printf(",");
-	printf(" %g", ogt_hfloat_to_float(vector->w));
+		string_buf_printf(buf, "= vec4(");
+	
+	string_buf_printf(buf, "%g", ogt_hfloat_to_float(vector->x));
+	if (verbose) string_buf_printf(buf, ",");
+	string_buf_printf(buf, " %g", ogt_hfloat_to_float(vector->y));
+	if (verbose) string_buf_printf(buf, ",");
+	string_buf_printf(buf, " %g", ogt_hfloat_to_float(vector->z));
+	if (verbose) string_buf_printf(buf, ",");
+	string_buf_printf(buf, " %g", ogt_hfloat_to_float(vector->w));
 	if (verbose)
-		printf(")");
+		string_buf_printf(buf, ")");
 }
 
 static void _lima_pp_field_print_varying(
-	lima_pp_field_e field,
+	string_buf_t* buf, lima_pp_field_e field,
 	lima_pp_field_varying_t* varying,
 	bool verbose)
 {
 	(void) field; /* Not used. */
-
+	
 	if (verbose)
 	{
 		if (varying->imm.dest != lima_pp_vec4_reg_discard)
 		{
-			printf("$%u", varying->imm.dest);
-			_lima_pp_field_print_mask(varying->imm.mask);
-			printf(" = ");
+			string_buf_printf(buf, "$%u", varying->imm.dest);
+			_lima_pp_field_print_mask(buf, varying->imm.mask);
+			string_buf_printf(buf, " = ");
 		}
-
+		
 		bool perspective
 			= ((varying->imm.source_type < 2)
 				&& varying->imm.perspective);
 		if (perspective)
-			printf("perspective(");
-
+			string_buf_printf(buf, "perspective(");
+		
 		switch (varying->imm.source_type)
 		{
 			case 1:
 				_lima_pp_field_print_reg_source(
-					varying->reg.source, NULL,
+					buf, varying->reg.source, NULL,
 					varying->reg.swizzle,
 					varying->reg.absolute,
 					varying->reg.negate,
 					verbose);
 				break;
 			case 2:
-				printf("gl_FragCoord");
+				string_buf_printf(buf, "gl_FragCoord");
 				break;
 			case 3:
 				if (varying->imm.perspective)
-					printf("gl_FrontFacing");
+					string_buf_printf(buf, "gl_FrontFacing");
 				else
-					printf("gl_PointCoord");
+					string_buf_printf(buf, "gl_PointCoord");
 				break;
 			default:
 				switch (varying->imm.alignment)
 				{
 					case 0:
 					{
-						printf("varying[%u",
+						string_buf_printf(buf, "varying[%u",
 							(varying->imm.index >> 2));
 					} break;
 					case 1:
 					{
-						printf("varying[%u",
+						string_buf_printf(buf, "varying[%u",
 							(varying->imm.index >> 1));
 					} break;
 					default:
 					{
-						printf("varying[%u", varying->imm.index);
+						string_buf_printf(buf, "varying[%u", varying->imm.index);
 					} break;
 				}
 				
@@ -509,8 +518,8 @@ static void _lima_pp_field_print_varying(
 				{
 					unsigned reg = (varying->imm.offset_vector << 2)
 						+ varying->imm.offset_scalar;
-					printf(" + ");
-					_lima_pp_field_print_reg_source_scalar(reg, NULL,
+					string_buf_printf(buf, " + ");
+					_lima_pp_field_print_reg_source_scalar(buf, reg, NULL,
 						false, false, true);
 				}
 				
@@ -519,92 +528,92 @@ static void _lima_pp_field_print_varying(
 					case 0:
 					{
 						const char c[4] = "xyzw";
-						printf("].%c", c[varying->imm.index & 3]);
+						string_buf_printf(buf, "].%c", c[varying->imm.index & 3]);
 						break;
 					}
 					case 1:
 					{
 						const char* c[2] = {"xy", "zw"};
-						printf("].%s", c[varying->imm.index & 1]);
+						string_buf_printf(buf, "].%s", c[varying->imm.index & 1]);
 						break;
 					}
 					default:
-						printf("]");
+						string_buf_printf(buf, "]");
 						break;
 				}
 				break;
 		}
-
+		
 		if (perspective)
 		{
 			switch (varying->imm.perspective)
 			{
 				case 2:
-					printf(", z)");
+					string_buf_printf(buf, ", z)");
 					break;
 				case 3:
-					printf(", w)");
+					string_buf_printf(buf, ", w)");
 					break;
 				default:
-					printf(", unknown)");
+					string_buf_printf(buf, ", unknown)");
 					break;
 			}
 		}
 	} else {
-		printf("load");
+		string_buf_printf(buf, "load");
 		
 		bool perspective
 			= ((varying->imm.source_type < 2)
 				&& varying->imm.perspective);
 		if (perspective)
 		{
-			printf("_perspective");
+			string_buf_printf(buf, "_perspective");
 			switch (varying->imm.perspective)
 			{
 				case 2:
-					printf("_z");
+					string_buf_printf(buf, "_z");
 					break;
 				case 3:
-					printf("_w");
+					string_buf_printf(buf, "_w");
 					break;
 				default:
-					printf("_unknown");
+					string_buf_printf(buf, "_unknown");
 					break;
 			}
 		}
-		printf(".v ");
-
-
+		string_buf_printf(buf, ".v ");
+		
+		
 		switch (varying->imm.dest)
 		{
 			case lima_pp_vec4_reg_discard:
-				printf("^discard");
+				string_buf_printf(buf, "^discard");
 				break;
 			default:
-				printf("$%u", varying->imm.dest);
+				string_buf_printf(buf, "$%u", varying->imm.dest);
 				break;
 		}
-		_lima_pp_field_print_mask(varying->imm.mask);
-		printf(" ");
-
+		_lima_pp_field_print_mask(buf, varying->imm.mask);
+		string_buf_printf(buf, " ");
+		
 		switch (varying->imm.source_type)
 		{
 			case 1:
 				_lima_pp_field_print_reg_source(
-					varying->reg.source, NULL,
+					buf, varying->reg.source, NULL,
 					varying->reg.swizzle,
 					varying->reg.absolute,
 					varying->reg.negate,
 					verbose);
 				break;
 			case 2:
-				printf("gl_FragCoord");
+				string_buf_printf(buf, "gl_FragCoord");
 				break;
 			case 3:
 				if (varying->imm.perspective)
-					printf("gl_FrontFacing");
+					string_buf_printf(buf, "gl_FrontFacing");
 				else
-					printf("gl_PointCoord");
+					string_buf_printf(buf, "gl_PointCoord");
 				break;
 			default:
 				switch (varying->imm.alignment)
@@ -612,28 +621,28 @@ static void _lima_pp_field_print_varying(
 					case 0:
 					{
 						const char c[4] = "xyzw";
-						printf("%u.%c",
+						string_buf_printf(buf, "%u.%c",
 							(varying->imm.index >> 2),
 							c[varying->imm.index & 3]);
 					} break;
 					case 1:
 					{
 						const char *c[2] = {"xy", "zw"};
-						printf("%u.%s",
+						string_buf_printf(buf, "%u.%s",
 							(varying->imm.index >> 1),
 							c[varying->imm.index & 1]);
 					} break;
 					default:
 					{
-						printf("%u", varying->imm.index);
+						string_buf_printf(buf, "%u", varying->imm.index);
 					} break;
 				}
 				if (varying->imm.offset_vector != 15)
 				{
 					unsigned reg = (varying->imm.offset_vector << 2)
 						+ varying->imm.offset_scalar;
-					printf("+");
-					_lima_pp_field_print_reg_source_scalar(reg, NULL,
+					string_buf_printf(buf, "+");
+					_lima_pp_field_print_reg_source_scalar(buf, reg, NULL,
 						false, false, false);
 				}
 				break;
@@ -642,82 +651,82 @@ static void _lima_pp_field_print_varying(
 }
 
 static void _lima_pp_field_print_sampler(
-	lima_pp_field_e field,
+	string_buf_t* buf, lima_pp_field_e field,
 	lima_pp_field_sampler_t* sampler,
 	bool verbose)
 {
 	(void) field; /* Not used. */
-
+	
 	if (verbose)
 	{
-		printf("^texture = ");
+		string_buf_printf(buf, "^texture = ");
 		switch (sampler->type)
 		{
 			case lima_pp_sampler_type_2d:
-				printf("sampler2D");
+				string_buf_printf(buf, "sampler2D");
 				break;
 			case lima_pp_sampler_type_cube:
-				printf("samplerCube");
+				string_buf_printf(buf, "samplerCube");
 				break;
 			default:
-				printf("sampler%u", sampler->type);
+				string_buf_printf(buf, "sampler%u", sampler->type);
 				break;
 		}
-		printf("(");
-
-		printf("%u", sampler->index);
-
+		string_buf_printf(buf, "(");
+		
+		string_buf_printf(buf, "%u", sampler->index);
+		
 		if (sampler->offset_en)
 		{
-			printf(" + ");
+			string_buf_printf(buf, " + ");
 			_lima_pp_field_print_reg_source_scalar(
-				sampler->index_offset, NULL,
+				buf, sampler->index_offset, NULL,
 				false, false,
 				verbose);
 		}
-
+		
 		if (sampler->lod_bias_en)
 		{
-			printf(", ");
+			string_buf_printf(buf, ", ");
 			_lima_pp_field_print_reg_source_scalar(
-				sampler->lod_bias, NULL,
+				buf, sampler->lod_bias, NULL,
 				false, false,
 				verbose);
 		}
-		printf(")");
+		string_buf_printf(buf, ")");
 	} else {
-		printf("texld");
+		string_buf_printf(buf, "texld");
 		if (sampler->lod_bias_en)
-			printf("b");
-
+			string_buf_printf(buf, "b");
+		
 		switch (sampler->type)
 		{
 			case lima_pp_sampler_type_2d:
-				printf("_2d");
+				string_buf_printf(buf, "_2d");
 				break;
 			case lima_pp_sampler_type_cube:
-				printf("_cube");
+				string_buf_printf(buf, "_cube");
 				break;
 			default:
-				printf("_t%u", sampler->type);
+				string_buf_printf(buf, "_t%u", sampler->type);
 				break;
 		}
-		printf(" %u", sampler->index);
-
+		string_buf_printf(buf, " %u", sampler->index);
+		
 		if (sampler->offset_en)
 		{
-			printf("+");
+			string_buf_printf(buf, "+");
 			_lima_pp_field_print_reg_source_scalar(
-				sampler->index_offset, NULL,
+				buf, sampler->index_offset, NULL,
 				false, false,
 				verbose);
 		}
-
+		
 		if (sampler->lod_bias_en)
 		{
-			printf(" ");
+			string_buf_printf(buf, " ");
 			_lima_pp_field_print_reg_source_scalar(
-				sampler->lod_bias, NULL,
+				buf, sampler->lod_bias, NULL,
 				false, false,
 				verbose);
 		}
@@ -725,82 +734,82 @@ static void _lima_pp_field_print_sampler(
 }
 
 static void _lima_pp_field_print_uniform(
-	lima_pp_field_e field,
+	string_buf_t* buf, lima_pp_field_e field,
 	lima_pp_field_uniform_t* uniform,
 	bool verbose)
 {
 	(void) field; /* Not used. */
-
+	
 	if (verbose)
 	{
-		printf("^uniform = ");
+		string_buf_printf(buf, "^uniform = ");
 		switch (uniform->source)
 		{
 			case lima_pp_uniform_src_uniform:
-				printf("uniform");
+				string_buf_printf(buf, "uniform");
 				break;
 			case lima_pp_uniform_src_temporary:
-				printf("temporary");
+				string_buf_printf(buf, "temporary");
 				break;
 			default:
-				printf("source%u", uniform->source);
+				string_buf_printf(buf, "source%u", uniform->source);
 				break;
 		}
-
+		
 		if(uniform->alignment)
 		{
-			printf("[%u", uniform->index);
+			string_buf_printf(buf, "[%u", uniform->index);
 		} else {
-			printf("[%u",
+			string_buf_printf(buf, "[%u",
 				(uniform->index >> 2));
 		}
 		
 		if(uniform->offset_en) {
-			printf(" + ");
+			string_buf_printf(buf, " + ");
 			_lima_pp_field_print_reg_source_scalar(
-				uniform->offset_reg, NULL,
+				buf, uniform->offset_reg, NULL,
 				false, false,
 				verbose);
 		}
 		
-		printf("]");
+		string_buf_printf(buf, "]");
 		
 		if(!uniform->alignment) {
 			char* c = "xyzw";
-			printf(".%c", c[uniform->index & 3]);
+			string_buf_printf(buf, ".%c", c[uniform->index & 3]);
 		}
 	}
 	else
 	{
-		printf("load.");
-
+		string_buf_printf(buf, "load.");
+		
 		switch (uniform->source)
 		{
 			case lima_pp_uniform_src_uniform:
-				printf("u");
+				string_buf_printf(buf, "u");
 				break;
 			case lima_pp_uniform_src_temporary:
-				printf("t");
+				string_buf_printf(buf, "t");
 				break;
 			default:
-				printf(".u%u", uniform->source);
+				string_buf_printf(buf, ".u%u", uniform->source);
 				break;
 		}
-
+		
 		if (uniform->alignment)
 		{
-			printf(" %u", uniform->index);
+			string_buf_printf(buf, " %u", uniform->index);
 		} else {
 			char* c = "xyzw";
-			printf(" %u.%c",
+			string_buf_printf(buf, " %u.%c",
 				(uniform->index >> 2),
 				c[uniform->index & 3]);
 		}
 		
 		if(uniform->offset_en) {
-			printf(" ");
+			string_buf_printf(buf, " ");
 			_lima_pp_field_print_reg_source_scalar(
-				uniform->offset_reg, NULL,
+				buf, uniform->offset_reg, NULL,
 				false, false,
 				verbose);
 		}
@@ -808,88 +817,88 @@ static void _lima_pp_field_print_uniform(
 }
 
 static void _lima_pp_field_print_vec4_mul(
-	lima_pp_field_e field,
+	string_buf_t* buf, lima_pp_field_e field,
 	lima_pp_field_vec4_mul_t* vec4_mul,
 	bool verbose)
 {
 	(void) field; /* Not used. */
-
+	
 	lima_pp_asm_op_t op
 		= lima_pp_vec4_mul_asm_op[vec4_mul->op];
 	if (!verbose)
 	{
 		if (op.name)
-			printf("%s", op.name);
+			string_buf_printf(buf, "%s", op.name);
 		else
-			printf("op%u", vec4_mul->op);
-		printf(".v0 ");
+			string_buf_printf(buf, "op%u", vec4_mul->op);
+		string_buf_printf(buf, ".v0 ");
 	}
-
+	
 	if (vec4_mul->mask)
 	{
-		printf("$%u", vec4_mul->dest);
+		string_buf_printf(buf, "$%u", vec4_mul->dest);
 		if (!verbose)
-			_lima_pp_field_print_outmod_d3d(vec4_mul->dest_modifier);
-		_lima_pp_field_print_mask(vec4_mul->mask);
+			_lima_pp_field_print_outmod_d3d(buf, vec4_mul->dest_modifier);
+		_lima_pp_field_print_mask(buf, vec4_mul->mask);
 		if (verbose)
-			printf(" =");
-		printf(" ");
+			string_buf_printf(buf, " =");
+		string_buf_printf(buf, " ");
 	}
-
+	
 	bool bracket = verbose;
 	if (!op.arg0
 		&& !op.arg1)
 		bracket = false;
-
+	
 	const char* seperator = NULL;
 	if (verbose)
 	{
-		printf("^vmul = ");
-
-		_lima_pp_field_print_outmod_start(vec4_mul->dest_modifier);
-
+		string_buf_printf(buf, "^vmul = ");
+		
+		_lima_pp_field_print_outmod_start(buf, vec4_mul->dest_modifier);
+		
 		if (op.symbol)
 		{
 			bracket = false;
 			seperator = op.symbol;
 		} else {
 			if (op.name)
-				printf("%s", op.name);
+				string_buf_printf(buf, "%s", op.name);
 			else
-				printf("op%u", vec4_mul->op);
+				string_buf_printf(buf, "op%u", vec4_mul->op);
 		}
 		if (bracket)
-			printf("(");
+			string_buf_printf(buf, "(");
 	}
-
+	
 	if (op.arg0)
 	{
 		_lima_pp_field_print_reg_source(
-			vec4_mul->arg0_source, NULL,
+			buf, vec4_mul->arg0_source, NULL,
 			vec4_mul->arg0_swizzle,
 			vec4_mul->arg0_absolute,
 			vec4_mul->arg0_negate,
 			verbose);
 	}
-
+	
 	if (op.arg0
 		&& op.arg1)
 	{
 		if (seperator)
-			printf(" %s", seperator);
+			string_buf_printf(buf, " %s", seperator);
 		else if (bracket)
-			printf(",");
-		printf(" ");
+			string_buf_printf(buf, ",");
+		string_buf_printf(buf, " ");
 	}
 	else if (seperator)
 	{
-		printf("%s", seperator);
+		string_buf_printf(buf, "%s", seperator);
 	}
-
+	
 	if (op.arg1)
 	{
 		_lima_pp_field_print_reg_source(
-			vec4_mul->arg1_source, NULL,
+			buf, vec4_mul->arg1_source, NULL,
 			vec4_mul->arg1_swizzle,
 			vec4_mul->arg1_absolute,
 			vec4_mul->arg1_negate,
@@ -900,58 +909,58 @@ static void _lima_pp_field_print_vec4_mul(
 		&& (vec4_mul->op > 0))
 	{
 		if (verbose)
-			printf(" <<");
-		printf(" ");
-		printf("%u", vec4_mul->op);
+			string_buf_printf(buf, " <<");
+		string_buf_printf(buf, " ");
+		string_buf_printf(buf, "%u", vec4_mul->op);
 	}
-
+	
 	if (verbose)
 	{
 		if (bracket)
-			printf(")");
-		_lima_pp_field_print_outmod_end(vec4_mul->dest_modifier);
+			string_buf_printf(buf, ")");
+		_lima_pp_field_print_outmod_end(buf, vec4_mul->dest_modifier);
 	}
 }
 
 static void _lima_pp_field_print_vec4_acc(
-	lima_pp_field_e field,
+	string_buf_t* buf, lima_pp_field_e field,
 	lima_pp_field_vec4_acc_t* vec4_acc,
 	bool verbose)
 {
 	(void) field; /* Not used. */
-
+	
 	lima_pp_asm_op_t op
 		= lima_pp_vec4_acc_asm_op[vec4_acc->op];
 	if (!verbose)
 	{
 		if (op.name)
-			printf("%s", op.name);
+			string_buf_printf(buf, "%s", op.name);
 		else
-			printf("op%u", vec4_acc->op);
-		printf(".v1 ");
+			string_buf_printf(buf, "op%u", vec4_acc->op);
+		string_buf_printf(buf, ".v1 ");
 	}
-
+	
 	if (vec4_acc->mask)
 	{
-		printf("$%u", vec4_acc->dest);
+		string_buf_printf(buf, "$%u", vec4_acc->dest);
 		if (!verbose)
-			_lima_pp_field_print_outmod_d3d(vec4_acc->dest_modifier);
-		_lima_pp_field_print_mask(vec4_acc->mask);
+			_lima_pp_field_print_outmod_d3d(buf, vec4_acc->dest_modifier);
+		_lima_pp_field_print_mask(buf, vec4_acc->mask);
 		if (verbose)
-			printf(" =");
-		printf(" ");
+			string_buf_printf(buf, " =");
+		string_buf_printf(buf, " ");
 	}
 		
 	bool bracket = verbose;
 	if (!op.arg0
 		&& !op.arg1)
 		bracket = false;
-
+	
 	const char* seperator = NULL;
 	if (verbose)
 	{
-		_lima_pp_field_print_outmod_start(vec4_acc->dest_modifier);
-
+		_lima_pp_field_print_outmod_start(buf, vec4_acc->dest_modifier);
+		
 		if (op.symbol)
 		{
 			if (vec4_acc->op != lima_pp_vec4_acc_op_sel)
@@ -959,141 +968,141 @@ static void _lima_pp_field_print_vec4_acc(
 			seperator = op.symbol;
 		} else {
 			if (op.name)
-				printf("%s", op.name);
+				string_buf_printf(buf, "%s", op.name);
 			else
-				printf("op%u", vec4_acc->op);
+				string_buf_printf(buf, "op%u", vec4_acc->op);
 		}
 		if (bracket)
-			printf("(");
+			string_buf_printf(buf, "(");
 	}
-
+	
 	if ((vec4_acc->op == lima_pp_vec4_acc_op_sel)
 		&& verbose)
-		printf("!^fmul ? ");
-
+		string_buf_printf(buf, "!^fmul ? ");
+	
 	if (op.arg0)
 	{
 		_lima_pp_field_print_reg_source(
-			vec4_acc->arg0_source, NULL,
+			buf, vec4_acc->arg0_source, NULL,
 			vec4_acc->arg0_swizzle,
 			vec4_acc->arg0_absolute,
 			vec4_acc->arg0_negate,
 			verbose);
 	}
-
+	
 	if (op.arg0
 		&& op.arg1)
 	{
 		if (seperator)
-			printf(" %s", seperator);
+			string_buf_printf(buf, " %s", seperator);
 		else if (bracket)
-			printf(",");
-		printf(" ");
+			string_buf_printf(buf, ",");
+		string_buf_printf(buf, " ");
 	}
 	else if (seperator)
 	{
-		printf("%s", seperator);
+		string_buf_printf(buf, "%s", seperator);
 	}
-
+	
 	if (op.arg1)
 	{
 		_lima_pp_field_print_reg_source(
-			vec4_acc->arg1_source,
+			buf, vec4_acc->arg1_source,
 			(vec4_acc->mul_in ? (verbose ? "^vmul" : "^v0") : NULL),
 			vec4_acc->arg1_swizzle,
 			vec4_acc->arg1_absolute,
 			vec4_acc->arg1_negate,
 			verbose);
 	}
-
+	
 	if (verbose)
 	{
 		if (bracket)
-			printf(")");
-		_lima_pp_field_print_outmod_end(vec4_acc->dest_modifier);
+			string_buf_printf(buf, ")");
+		_lima_pp_field_print_outmod_end(buf, vec4_acc->dest_modifier);
 	}
 }
 
 static void _lima_pp_field_print_float_mul(
-	lima_pp_field_e field,
+	string_buf_t* buf, lima_pp_field_e field,
 	lima_pp_field_float_mul_t* float_mul,
 	bool verbose)
 {
 	(void) field; /* Not used. */
-
+	
 	lima_pp_asm_op_t op
 		= lima_pp_float_mul_asm_op[float_mul->op];
 	if (!verbose)
 	{
 		if (op.name)
-			printf("%s", op.name);
+			string_buf_printf(buf, "%s", op.name);
 		else
-			printf("op%u", float_mul->op);
-		printf(".s0 ");
+			string_buf_printf(buf, "op%u", float_mul->op);
+		string_buf_printf(buf, ".s0 ");
 	}
-
+	
 	if (float_mul->output_en)
 	{
-		_lima_pp_field_print_reg_dest_scalar(float_mul->dest,
+		_lima_pp_field_print_reg_dest_scalar(buf, float_mul->dest,
 			(verbose ? lima_pp_outmod_none : float_mul->dest_modifier));
 		if (verbose)
-			printf(" =");
-		printf(" ");
+			string_buf_printf(buf, " =");
+		string_buf_printf(buf, " ");
 	}
-
+	
 	bool bracket = verbose;
 	if (!op.arg0
 		&& !op.arg1)
 		bracket = false;
-
+	
 	const char* seperator = NULL;
 	if (verbose)
 	{
-		printf("^fmul = ");
-
-		_lima_pp_field_print_outmod_start(float_mul->dest_modifier);
-
+		string_buf_printf(buf, "^fmul = ");
+		
+		_lima_pp_field_print_outmod_start(buf, float_mul->dest_modifier);
+		
 		if (op.symbol)
 		{
 			bracket = false;
 			seperator = op.symbol;
 		} else {
 			if (op.name)
-		printf("%s", op.name);
+		string_buf_printf(buf, "%s", op.name);
 			else
-		printf("op%u", float_mul->op);
+		string_buf_printf(buf, "op%u", float_mul->op);
 		}
 		if (bracket)
-			printf("(");
+			string_buf_printf(buf, "(");
 	}
-
+	
 	if (op.arg0)
 	{
 		_lima_pp_field_print_reg_source_scalar(
-			float_mul->arg0_source, NULL,
+			buf, float_mul->arg0_source, NULL,
 			float_mul->arg0_absolute,
 			float_mul->arg0_negate,
 			verbose);
 	}
-
+	
 	if (op.arg0
 		&& op.arg1)
 	{
 		if (seperator)
-			printf(" %s", seperator);
+			string_buf_printf(buf, " %s", seperator);
 		else if (bracket)
-			printf(",");
-		printf(" ");
+			string_buf_printf(buf, ",");
+		string_buf_printf(buf, " ");
 	}
 	else if (seperator)
 	{
-		printf("%s", seperator);
+		string_buf_printf(buf, "%s", seperator);
 	}
-
+	
 	if (op.arg1)
 	{
 		_lima_pp_field_print_reg_source_scalar(
-			float_mul->arg1_source, NULL,
+			buf, float_mul->arg1_source, NULL,
 			float_mul->arg1_absolute,
 			float_mul->arg1_negate,
 			verbose);
@@ -1103,99 +1112,99 @@ static void _lima_pp_field_print_float_mul(
 		&& (float_mul->op > 0))
 	{
 		if (verbose)
-			printf(" << ");
+			string_buf_printf(buf, " << ");
 		else
-			printf(", ");
-		printf("%u", float_mul->op);
+			string_buf_printf(buf, ", ");
+		string_buf_printf(buf, "%u", float_mul->op);
 	}
-
+	
 	if (verbose)
 	{
 		if (bracket)
-			printf(")");
-		_lima_pp_field_print_outmod_end(float_mul->dest_modifier);
+			string_buf_printf(buf, ")");
+		_lima_pp_field_print_outmod_end(buf, float_mul->dest_modifier);
 	}
 }
 
 static void _lima_pp_field_print_float_acc(
-	lima_pp_field_e field,
+	string_buf_t* buf, lima_pp_field_e field,
 	lima_pp_field_float_acc_t* float_acc,
 	bool verbose)
 {
 	(void) field; /* Not used. */
-
+	
 	lima_pp_asm_op_t op
 		= lima_pp_float_acc_asm_op[float_acc->op];
 	if (!verbose)
 	{
 		if (op.name)
-			printf("%s", op.name);
+			string_buf_printf(buf, "%s", op.name);
 		else
-			printf("op%u", float_acc->op);
-		printf(".s1 ");
+			string_buf_printf(buf, "op%u", float_acc->op);
+		string_buf_printf(buf, ".s1 ");
 	}
-
+	
 	if (float_acc->output_en)
 	{
-		_lima_pp_field_print_reg_dest_scalar(float_acc->dest,
+		_lima_pp_field_print_reg_dest_scalar(buf, float_acc->dest,
 			(verbose ? lima_pp_outmod_none : float_acc->dest_modifier));
 		if (verbose)
-			printf(" =");
-		printf(" ");
+			string_buf_printf(buf, " =");
+		string_buf_printf(buf, " ");
 	}
-
+	
 	bool bracket = verbose;
 	if (!op.arg0
 		&& !op.arg1)
 		bracket = false;
-
+	
 	const char* seperator = NULL;
 	if (verbose)
 	{
-		_lima_pp_field_print_outmod_start(float_acc->dest_modifier);
-
+		_lima_pp_field_print_outmod_start(buf, float_acc->dest_modifier);
+		
 		if (op.symbol)
 		{
 			bracket = false;
 			seperator = op.symbol;
 		} else {
 			if (op.name)
-				printf("%s", op.name);
+				string_buf_printf(buf, "%s", op.name);
 			else
-				printf("op%u", float_acc->op);
+				string_buf_printf(buf, "op%u", float_acc->op);
 		}
-
+		
 		if (bracket)
-			printf("(");
+			string_buf_printf(buf, "(");
 	}
-
+	
 	if (op.arg0)
 	{
 		_lima_pp_field_print_reg_source_scalar(
-			float_acc->arg0_source, NULL,
+			buf, float_acc->arg0_source, NULL,
 			float_acc->arg0_absolute,
 			float_acc->arg0_negate,
 			verbose);
 	}
-
+	
 	if (op.arg0
 		&& op.arg1)
 	{
 		if (seperator)
-			printf(" %s", seperator);
+			string_buf_printf(buf, " %s", seperator);
 		else if (bracket)
-			printf(",");
-		printf(" ");
+			string_buf_printf(buf, ",");
+		string_buf_printf(buf, " ");
 	}
 	else if (seperator)
 	{
-		printf("%s", seperator);
+		string_buf_printf(buf, "%s", seperator);
 	}
-
+	
 	if (op.arg1)
 	{
 		_lima_pp_field_print_reg_source_scalar(
-			float_acc->arg1_source,
+			buf, float_acc->arg1_source,
 			(float_acc->mul_in ? (verbose ? "^fmul" : "^s0") : NULL),
 			float_acc->arg1_absolute,
 			float_acc->arg1_negate,
@@ -1206,27 +1215,27 @@ static void _lima_pp_field_print_float_acc(
 		&& (float_acc->op > 0))
 	{
 		if (verbose)
-			printf(" << ");
+			string_buf_printf(buf, " << ");
 		else
-			printf(" ");
-		printf("%u", float_acc->op);
+			string_buf_printf(buf, " ");
+		string_buf_printf(buf, "%u", float_acc->op);
 	}
-
+	
 	if (verbose)
 	{
 		if (bracket)
-			printf(")");
-		_lima_pp_field_print_outmod_end(float_acc->dest_modifier);
+			string_buf_printf(buf, ")");
+		_lima_pp_field_print_outmod_end(buf, float_acc->dest_modifier);
 	}
 }
 
 static void _lima_pp_field_print_combine(
-	lima_pp_field_e field,
+	string_buf_t* buf, lima_pp_field_e field,
 	lima_pp_field_combine_t* combine,
 	bool verbose)
 {
 	(void) field; /* Not used. */
-
+	
 	if (!combine->scalar.dest_vec)
 	{
 		if (!combine->scalar.arg1_en)
@@ -1236,38 +1245,38 @@ static void _lima_pp_field_print_combine(
 			if (!verbose)
 			{
 				if (op.name)
-					printf("%s.s2 ", op.name);
+					string_buf_printf(buf, "%s.s2 ", op.name);
 				else
-					printf("op%u.s2 ", combine->scalar.op);
+					string_buf_printf(buf, "op%u.s2 ", combine->scalar.op);
 			}
-
-			_lima_pp_field_print_reg_dest_scalar(combine->scalar.dest,
+			
+			_lima_pp_field_print_reg_dest_scalar(buf, combine->scalar.dest,
 				(verbose ? lima_pp_outmod_none : combine->scalar.dest_modifier));
 			if (verbose)
-				printf(" =");
-			printf(" ");
-
+				string_buf_printf(buf, " =");
+			string_buf_printf(buf, " ");
+			
 			bool bracket = verbose;
 		
 			if (verbose)
 			{
-				_lima_pp_field_print_outmod_start(combine->scalar.dest_modifier);
+				_lima_pp_field_print_outmod_start(buf, combine->scalar.dest_modifier);
 				if (op.symbol)
 				{
-					printf("%s", op.symbol);
+					string_buf_printf(buf, "%s", op.symbol);
 					bracket = false;
 				} else {
 					if (op.name)
-						printf("%s", op.name);
+						string_buf_printf(buf, "%s", op.name);
 					else
-						printf("op%u", combine->scalar.op);
+						string_buf_printf(buf, "op%u", combine->scalar.op);
 					if (bracket)
-						printf("(");
+						string_buf_printf(buf, "(");
 				}
 			}
-
+			
 			_lima_pp_field_print_reg_source_scalar(
-				combine->scalar.arg0_src, NULL,
+				buf, combine->scalar.arg0_src, NULL,
 				combine->scalar.arg0_absolute,
 				combine->scalar.arg0_negate,
 				verbose);
@@ -1275,96 +1284,96 @@ static void _lima_pp_field_print_combine(
 			if (verbose)
 			{
 				if (bracket)
-					printf(")");
-				_lima_pp_field_print_outmod_end(combine->scalar.dest_modifier);
+					string_buf_printf(buf, ")");
+				_lima_pp_field_print_outmod_end(buf, combine->scalar.dest_modifier);
 			}
 		} else {
 			if (!verbose)
-				printf("atan_pt2.s2 ");
-
+				string_buf_printf(buf, "atan_pt2.s2 ");
+			
 			_lima_pp_field_print_reg_dest_scalar(
-				combine->scalar.dest, lima_pp_outmod_none);
+				buf, combine->scalar.dest, lima_pp_outmod_none);
 			if (verbose)
-				printf(" =");
-			printf(" ");
+				string_buf_printf(buf, " =");
+			string_buf_printf(buf, " ");
 		
 			if (verbose)
 			{
-				printf("atan_pt2(");
+				string_buf_printf(buf, "atan_pt2(");
 			}
 			
 			_lima_pp_field_print_reg_source(
-				combine->vector.arg1_source, NULL,
+				buf, combine->vector.arg1_source, NULL,
 				combine->vector.arg1_swizzle, false, false,
 				verbose);
-
+			
 			if (verbose)
-				printf(")");
+				string_buf_printf(buf, ")");
 		}
 	} else {
 		if (!combine->vector.arg1_en)
 		{
 			if (!verbose) {
 				if (combine->scalar.op == lima_pp_combine_scalar_op_atan)
-					printf("atan.s2 ");
+					string_buf_printf(buf, "atan.s2 ");
 				else
-					printf("atan2.s2 ");
+					string_buf_printf(buf, "atan2.s2 ");
 			}
 		
-			printf("$%u", combine->vector.dest);
-			_lima_pp_field_print_mask(combine->vector.mask);
+			string_buf_printf(buf, "$%u", combine->vector.dest);
+			_lima_pp_field_print_mask(buf, combine->vector.mask);
 			if (verbose)
-				printf(" =");
-			printf(" ");
-
+				string_buf_printf(buf, " =");
+			string_buf_printf(buf, " ");
+			
 			if (verbose) {
 				if (combine->scalar.op == lima_pp_combine_scalar_op_atan)
-					printf("atan(");
+					string_buf_printf(buf, "atan(");
 				else
-					printf("atan2(");
+					string_buf_printf(buf, "atan2(");
 			}
-
+			
 			_lima_pp_field_print_reg_source_scalar(
-				combine->scalar.arg0_src, NULL,
+				buf, combine->scalar.arg0_src, NULL,
 				combine->scalar.arg0_absolute,
 				combine->scalar.arg0_negate,
 				verbose);
 			
 			if (combine->scalar.op == lima_pp_combine_scalar_op_atan2) {
 				if (verbose)
-					printf(", ");
+					string_buf_printf(buf, ", ");
 				else
-					printf(" ");
+					string_buf_printf(buf, " ");
 				_lima_pp_field_print_reg_source_scalar(
-					combine->scalar.arg1_src, NULL,
+					buf, combine->scalar.arg1_src, NULL,
 					combine->scalar.arg1_absolute,
 					combine->scalar.arg1_negate,
 					verbose);
 			}
-
+			
 			if (verbose)
-				printf(")");
+				string_buf_printf(buf, ")");
 		} else {
 			if (!verbose)
-				printf("mul.s2 ");
-
-			printf("$%u", combine->vector.dest);
-			_lima_pp_field_print_mask(combine->vector.mask);
+				string_buf_printf(buf, "mul.s2 ");
+			
+			string_buf_printf(buf, "$%u", combine->vector.dest);
+			_lima_pp_field_print_mask(buf, combine->vector.mask);
 			if (verbose)
-				printf(" =");
-			printf(" ");
-
+				string_buf_printf(buf, " =");
+			string_buf_printf(buf, " ");
+			
 			_lima_pp_field_print_reg_source(
-				combine->vector.arg1_source, NULL,
+				buf, combine->vector.arg1_source, NULL,
 				combine->vector.arg1_swizzle, false, false,
 				verbose);
-
+			
 			if (verbose)
-				printf(" *");
-			printf(" ");
-
+				string_buf_printf(buf, " *");
+			string_buf_printf(buf, " ");
+			
 			_lima_pp_field_print_reg_source_scalar(
-				combine->scalar.arg0_src, NULL,
+				buf, combine->scalar.arg0_src, NULL,
 				combine->scalar.arg0_absolute,
 				combine->scalar.arg0_negate,
 				verbose);
@@ -1373,7 +1382,7 @@ static void _lima_pp_field_print_combine(
 }
 
 static void _lima_pp_field_print_temp_write(
-	lima_pp_field_e field,
+	string_buf_t* buf, lima_pp_field_e field,
 	lima_pp_field_temp_write_t* temp_write,
 	bool verbose)
 {
@@ -1382,84 +1391,84 @@ static void _lima_pp_field_print_temp_write(
 	if (temp_write->fb_read.unknown_0 == 0x7)
 	{
 		if (verbose)
-			printf("$%u = ", temp_write->fb_read.dest);
+			string_buf_printf(buf, "$%u = ", temp_write->fb_read.dest);
 		if (temp_write->fb_read.source)
-			printf("fb_color");
+			string_buf_printf(buf, "fb_color");
 		else
-			printf("fb_depth");
+			string_buf_printf(buf, "fb_depth");
 		if (!verbose)
-			printf(" $%u", temp_write->fb_read.dest);
+			string_buf_printf(buf, " $%u", temp_write->fb_read.dest);
 		
 		return;
 	}
 	
 	if (verbose)
 	{
-		printf("temporary[");
+		string_buf_printf(buf, "temporary[");
 		
 		if(temp_write->temp_write.alignment)
 		{
-			printf("%u", temp_write->temp_write.index);
+			string_buf_printf(buf, "%u", temp_write->temp_write.index);
 		} else {
-			printf("%u",
+			string_buf_printf(buf, "%u",
 				   (temp_write->temp_write.index >> 2));
 		}
 		
 		if(temp_write->temp_write.offset_en) {
-			printf(" + ");
+			string_buf_printf(buf, " + ");
 			_lima_pp_field_print_reg_source_scalar(
-				temp_write->temp_write.offset_reg, NULL,
+				buf, temp_write->temp_write.offset_reg, NULL,
 				false, false,
 				verbose);
 		}
 		
-		printf("]");
+		string_buf_printf(buf, "]");
 		
 		if(!temp_write->temp_write.alignment) {
 			char* c = "xyzw";
-			printf(".%c", c[temp_write->temp_write.index & 3]);
+			string_buf_printf(buf, ".%c", c[temp_write->temp_write.index & 3]);
 		}
 		
-		printf(" = ");
+		string_buf_printf(buf, " = ");
 	}
 	else
 	{
-		printf("store.t");
+		string_buf_printf(buf, "store.t");
 		
 		if (temp_write->temp_write.alignment)
 		{
-			printf(" %u", temp_write->temp_write.index);
+			string_buf_printf(buf, " %u", temp_write->temp_write.index);
 		} else {
 			char* c = "xyzw";
-			printf(" %u.%c",
+			string_buf_printf(buf, " %u.%c",
 				   (temp_write->temp_write.index >> 2),
 				   c[temp_write->temp_write.index & 3]);
 		}
 		
 		if(temp_write->temp_write.offset_en) {
-			printf(" ");
+			string_buf_printf(buf, " ");
 			_lima_pp_field_print_reg_source_scalar(
-				temp_write->temp_write.offset_reg, NULL,
+				buf, temp_write->temp_write.offset_reg, NULL,
 				false, false,
 				verbose);
 		}
 		
-		printf(" ");
+		string_buf_printf(buf, " ");
 	}
 	
 	if(temp_write->temp_write.alignment) {
 		_lima_pp_field_print_reg_name(
-			temp_write->temp_write.source >> 2, NULL, verbose);
+			buf, temp_write->temp_write.source >> 2, NULL, verbose);
 	} else {
 		_lima_pp_field_print_reg_source_scalar(
-			temp_write->temp_write.source, NULL,
+			buf, temp_write->temp_write.source, NULL,
 			false, false,
 			verbose);
 	}
 }
 
 static void _lima_pp_field_print_branch(
-	lima_pp_field_e field,
+	string_buf_t* buf, lima_pp_field_e field,
 	lima_pp_field_branch_t* branch,
 	bool verbose)
 {
@@ -1469,10 +1478,10 @@ static void _lima_pp_field_print_branch(
 		branch->discard.word1 == LIMA_PP_DISCARD_WORD1 &&
 		branch->discard.word2 == LIMA_PP_DISCARD_WORD2)
 	{
-		printf("discard");
+		string_buf_printf(buf, "discard");
 		return;
 	}
-
+	
 	if (!verbose)
 	{
 		const char* cond[] =
@@ -1484,84 +1493,84 @@ static void _lima_pp_field_print_branch(
 		cond_mask |= (branch->branch.cond_lt ? 1 : 0);
 		cond_mask |= (branch->branch.cond_eq ? 2 : 0);
 		cond_mask |= (branch->branch.cond_gt ? 4 : 0);
-		printf("j%s ", cond[cond_mask]);
-
+		string_buf_printf(buf, "j%s ", cond[cond_mask]);
+		
 		if (cond_mask)
 		{
 			_lima_pp_field_print_reg_source_scalar(
-				branch->branch.arg0_source, NULL,
+				buf, branch->branch.arg0_source, NULL,
 				false, false,
 				verbose);
-			printf(" ");
+			string_buf_printf(buf, " ");
 			_lima_pp_field_print_reg_source_scalar(
-				branch->branch.arg1_source, NULL,
+				buf, branch->branch.arg1_source, NULL,
 				false, false,
 				verbose);
-			printf(" ");
+			string_buf_printf(buf, " ");
 		}
 	} else {
 		if (!branch->branch.cond_lt
 			|| !branch->branch.cond_eq
 			|| !branch->branch.cond_gt)
 		{
-			printf(" if (");
-
+			string_buf_printf(buf, " if (");
+			
 			if (branch->branch.cond_lt
 				|| branch->branch.cond_eq
 				|| branch->branch.cond_gt)
 			{
 				_lima_pp_field_print_reg_source_scalar(
-					branch->branch.arg0_source, NULL,
+					buf, branch->branch.arg0_source, NULL,
 					false, false,
 					verbose);
-
+				
 				if (branch->branch.cond_eq)
 				{
 					if (branch->branch.cond_gt)
-						printf(" >= ");
+						string_buf_printf(buf, " >= ");
 					else if (branch->branch.cond_lt)
-						printf(" <= ");
+						string_buf_printf(buf, " <= ");
 					else
-						printf(" == ");
+						string_buf_printf(buf, " == ");
 				} else {
 					if (branch->branch.cond_gt
 						&& branch->branch.cond_lt)
-						printf(" != ");
+						string_buf_printf(buf, " != ");
 					else if (branch->branch.cond_gt)
-						printf(" > ");
+						string_buf_printf(buf, " > ");
 					else if (branch->branch.cond_lt)
-						printf(" < ");
+						string_buf_printf(buf, " < ");
 					else
-						printf(" == ");
+						string_buf_printf(buf, " == ");
 				}
-
+				
 				_lima_pp_field_print_reg_source_scalar(
-					branch->branch.arg1_source, NULL,
+					buf, branch->branch.arg1_source, NULL,
 					false, false,
 					verbose);
 			} else {
-				printf("false");
+				string_buf_printf(buf, "false");
 			}
-			printf(") ");
+			string_buf_printf(buf, ") ");
 		}
-		printf ("goto ");
+		string_buf_printf(buf, "goto ");
 	}
-	printf("%d", branch->branch.target);
+	string_buf_printf(buf, "%d", branch->branch.target);
 }
 
 static void _lima_pp_field_print_unknown(
-	lima_pp_field_e field,
+	string_buf_t* buf, lima_pp_field_e field,
 	void* data,
 	bool verbose)
 {
 	(void) verbose; /* Not used. */
-
-	printf("%s:", lima_pp_field_name[field]);
-	_print_bin_un(data, lima_pp_field_size[field]);
+	
+	string_buf_printf(buf, "%s:", lima_pp_field_name[field]);
+	_print_bin_un(buf, data, lima_pp_field_size[field]);
 }
 
 void lima_pp_instruction_print(
-	lima_pp_instruction_t* code, bool verbose, unsigned tabs)
+	string_buf_t* buf, lima_pp_instruction_t* code, bool verbose, unsigned tabs)
 {
 	void* field[] =
 	{
@@ -1578,8 +1587,9 @@ void lima_pp_instruction_print(
 		&code->const0,
 		&code->const1,
 	};
-
-	void (*field_print[])(lima_pp_field_e field, void* data, bool verbose) =
+	
+	void (*field_print[])(string_buf_t* buf, lima_pp_field_e field,
+						  void* data, bool verbose) =
 	{
 		(void*)_lima_pp_field_print_varying,
 		(void*)_lima_pp_field_print_sampler,
@@ -1594,7 +1604,7 @@ void lima_pp_instruction_print(
 		(void*)_lima_pp_field_print_const,
 		(void*)_lima_pp_field_print_const,
 	};
-
+	
 	unsigned field_order[] =
 	{
 		lima_pp_field_vec4_const_0,
@@ -1612,8 +1622,8 @@ void lima_pp_instruction_print(
 	};
 	
 	if (!verbose)
-		print_tabs(tabs);
-
+		print_tabs(buf, tabs);
+	
 	bool first = true;
 	unsigned i;
 	for (i = 0; i < lima_pp_field_count; i++)
@@ -1624,106 +1634,83 @@ void lima_pp_instruction_print(
 			if (first)
 				first = false;
 			else
-				printf(",%c", (verbose ? '\n' : ' '));
-
+				string_buf_printf(buf, ",%c", (verbose ? '\n' : ' '));
+			
 			if (verbose)
-				print_tabs(tabs);
-
+				print_tabs(buf, tabs);
+			
 			if (field_print[f])
-				field_print[f](f, field[f], verbose);
+				field_print[f](buf, f, field[f], verbose);
 			else
-				_lima_pp_field_print_unknown(f, field[f], verbose);
+				_lima_pp_field_print_unknown(buf, f, field[f], verbose);
 		}
 	}
-
+	
 	if (code->control.sync
 		|| code->control.stop)
 	{
 		if (first)
 			first = false;
 		else
-			printf(",%c", (verbose ? '\n' : ' '));
-
+			string_buf_printf(buf, ",%c", (verbose ? '\n' : ' '));
+		
 		if (verbose)
-			print_tabs(tabs);
-
+			print_tabs(buf, tabs);
+		
 		if (code->control.sync)
 		{
-			printf("sync");
+			string_buf_printf(buf, "sync");
 			if (code->control.stop)
-				printf(", ");
+				string_buf_printf(buf, ", ");
 		}
 		if (code->control.stop)
-			printf("stop");
+			string_buf_printf(buf, "stop");
 	}
-
+	
 	if (verbose)
 	{
-		printf(";");
+		string_buf_printf(buf, ";");
 		if  (code->control.unknown)
 		{
-			printf(" # unknown = ");
-			_print_bin_u32n(code->control.unknown, 6);
+			string_buf_printf(buf, " # unknown = ");
+			_print_bin_u32n(buf, code->control.unknown, 6);
 		}
 	}
-	printf("\n");
+	string_buf_printf(buf, "\n");
 }
 
-#if 0
-
 bool lima_pp_disassemble(
-	void* code, unsigned size,
-	ogt_link_map_t* map,
-	ogt_asm_type_e type,
-	ogt_asm_type_e syntax,
+	string_buf_t* buf, const void* code, unsigned size, bool verbose,
 	unsigned tabs)
 {
-	(void)map;  /* Not used. */
-	(void)type; /* Not used. */
-
 	/* Fragment assembler must be a multiple of 32-bits. */
-	if (size & 3) return false;
-
-
-	bool verbose = false;
-	switch (syntax)
-	{
-		case ogt_asm_syntax_explicit:
-			verbose = true;
-			break;
-		case ogt_asm_syntax_verbose:
-			break;
-		default:
-			return false;
-	}
-
-	if (!code) return false;
-
-	/* Print symbol table. */
-	essl_program_t* program
-		= ogt_link_map_export_essl(map);
-	if (program)
-	{
-		essl_program_print(program, stdout, tabs);
-		printf("\n");
-	}
-
-	uint32_t* wcode = (uint32_t*)code;
+	if (!code || (size & 3))
+		return false;
+	
+	const uint32_t* wcode = (const uint32_t*)code;
+	size >>= 2;
+	
 	lima_pp_ctrl_t ctrl;
 	unsigned i;
-	for (i = 0; i < (size >> 2); i += ctrl.count)
+	for (i = 0; i < size; i += ctrl.count)
 	{
 		ctrl.mask = wcode[i];
-
+		
+		/* The count has to agree with the fields present, and stay within
+		 * the code, otherwise decoding would read out of bounds. */
+		lima_pp_ctrl_t expected = ctrl;
+		lima_pp_instruction_calc_size(&expected);
+		if ((ctrl.count != expected.count) || (ctrl.count > size - i))
+			return false;
+		
 		if (i && verbose)
-			printf("\n");
-
+			string_buf_printf(buf, "\n");
+		
 		lima_pp_instruction_t inst;
-		lima_pp_instruction_decode(&wcode[i], &inst);
-		lima_pp_instruction_print(&inst, verbose, tabs);
+		lima_pp_instruction_decode((uint32_t*)&wcode[i], &inst);
+		lima_pp_instruction_print(buf, &inst, verbose, tabs);
+		string_buf_flush(buf);
 	}
-
+	
 	return true;
 }
-
-#endif
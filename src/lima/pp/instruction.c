@@ -26,96 +26,195 @@
  */
 
 
-
 #include "lima_pp.h"
-#include "bitaddr.h"
 
-#include <stdlib.h>
-#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+
+
+
+/* Where each field lives in lima_pp_instruction_t, in encoding order. */
+
+#define FIELD(name) \
+	{ offsetof(lima_pp_instruction_t, name), \
+	  sizeof(((lima_pp_instruction_t*)0)->name) }
+
+static const struct
+{
+	unsigned offset, bytes;
+} lima_pp_field_layout[lima_pp_field_count] =
+{
+	FIELD(varying),
+	FIELD(sampler),
+	FIELD(uniform),
+	FIELD(vec4_mul),
+	FIELD(float_mul),
+	FIELD(vec4_acc),
+	FIELD(float_acc),
+	FIELD(combine),
+	FIELD(temp_write),
+	FIELD(branch),
+	FIELD(const0),
+	FIELD(const1),
+};
+
+#undef FIELD
+
+/* The total size in bits of the fields in the low and high six bits of the
+ * field mask, so the size of an instruction is two lookups. They're built
+ * from the field sizes in lima_pp.h by the preprocessor. */
+
+#define SIZE_IF(mask, bit, size) (((mask) & (1 << (bit))) ? (size) : 0)
+
+#define LO_SIZE(mask) ( \
+	SIZE_IF(mask, 0, lima_pp_field_varying_size) + \
+	SIZE_IF(mask, 1, lima_pp_field_sampler_size) + \
+	SIZE_IF(mask, 2, lima_pp_field_uniform_size) + \
+	SIZE_IF(mask, 3, lima_pp_field_vec4_mul_size) + \
+	SIZE_IF(mask, 4, lima_pp_field_float_mul_size) + \
+	SIZE_IF(mask, 5, lima_pp_field_vec4_acc_size))
 
+#define HI_SIZE(mask) ( \
+	SIZE_IF(mask, 0, lima_pp_field_float_acc_size) + \
+	SIZE_IF(mask, 1, lima_pp_field_combine_size) + \
+	SIZE_IF(mask, 2, lima_pp_field_temp_write_size) + \
+	SIZE_IF(mask, 3, lima_pp_field_branch_size) + \
+	SIZE_IF(mask, 4, lima_pp_field_vec4_const_0_size) + \
+	SIZE_IF(mask, 5, lima_pp_field_vec4_const_1_size))
 
+#define ROW(SIZE, mask) \
+	SIZE((mask) + 0), SIZE((mask) + 1), SIZE((mask) + 2), SIZE((mask) + 3), \
+	SIZE((mask) + 4), SIZE((mask) + 5), SIZE((mask) + 6), SIZE((mask) + 7)
+
+#define TABLE(SIZE) \
+	ROW(SIZE,  0), ROW(SIZE,  8), ROW(SIZE, 16), ROW(SIZE, 24), \
+	ROW(SIZE, 32), ROW(SIZE, 40), ROW(SIZE, 48), ROW(SIZE, 56)
+
+static const uint16_t lima_pp_fields_lo_size[64] = { TABLE(LO_SIZE) };
+static const uint16_t lima_pp_fields_hi_size[64] = { TABLE(HI_SIZE) };
+
+#undef TABLE
+#undef ROW
+#undef HI_SIZE
+#undef LO_SIZE
+#undef SIZE_IF
 
 void lima_pp_instruction_calc_size(lima_pp_ctrl_t* control)
 {
-	unsigned i, size;
-	for (i = 0, size = 32; i < lima_pp_field_count; i++)
+	unsigned size = 32
+		+ lima_pp_fields_lo_size[control->fields & 0x3F]
+		+ lima_pp_fields_hi_size[control->fields >> 6];
+	control->count = ((size + 0x1F) >> 5);
+}
+
+
+
+/* Fields are packed back to back, least significant bit first, with no
+ * regard for word boundaries. Rather than copying each one bit by bit, the
+ * encoder shifts whole words into a 64-bit accumulator and writes out a word
+ * whenever 32 bits are ready, and the decoder does the reverse, so every
+ * word of the instruction is read or written exactly once. */
+
+static inline uint32_t low_bits(uint32_t value, unsigned size)
+{
+	return value & (uint32_t)((1ULL << size) - 1);
+}
+
+typedef struct
+{
+	uint64_t  acc;
+	unsigned  bits;
+	uint32_t* out;
+} bit_writer_t;
+
+/* size is 1 to 32, and value has no bits set above it */
+static inline void bit_writer_put(
+	bit_writer_t* writer, uint32_t value, unsigned size)
+{
+	writer->acc |= (uint64_t)value << writer->bits;
+	writer->bits += size;
+	if (writer->bits >= 32)
+	{
+		*writer->out++ = (uint32_t)writer->acc;
+		writer->acc >>= 32;
+		writer->bits -= 32;
+	}
+}
+
+typedef struct
+{
+	uint64_t        acc;
+	unsigned        bits;
+	const uint32_t* in;
+} bit_reader_t;
+
+/* size is 1 to 32 */
+static inline uint32_t bit_reader_get(bit_reader_t* reader, unsigned size)
+{
+	if (reader->bits < size)
 	{
-		if ((control->fields >> i) & 1)
-			size += lima_pp_field_size[i];
+		reader->acc |= (uint64_t)*reader->in++ << reader->bits;
+		reader->bits += 32;
 	}
 	
-	control->count = ((size + 0x1F) >> 5);
+	uint32_t value = low_bits((uint32_t)reader->acc, size);
+	reader->acc >>= size;
+	reader->bits -= size;
+	return value;
 }
 
 void lima_pp_instruction_encode(
 	lima_pp_instruction_t* inst, uint32_t* output)
 {
-	void* field[] =
-	{
-		&inst->varying,
-		&inst->sampler,
-		&inst->uniform,
-		&inst->vec4_mul,
-		&inst->float_mul,
-		&inst->vec4_acc,
-		&inst->float_acc,
-		&inst->combine,
-		&inst->temp_write,
-		&inst->branch,
-		&inst->const0,
-		&inst->const1,
-	};
-
 	lima_pp_instruction_calc_size(&inst->control);
 	output[0] = inst->control.mask;
-
-	unsigned offset, i;
-	for (i = 0, offset = 32;
-		i < lima_pp_field_count; i++)
+	
+	bit_writer_t writer = { 0, 0, output + 1 };
+	
+	unsigned fields = inst->control.fields;
+	unsigned i;
+	for (i = 0; i < lima_pp_field_count; i++)
 	{
-		if ((inst->control.fields >> i) & 1)
-		{
-			unsigned size = lima_pp_field_size[i];
-			bitcopy(output, offset, field[i], 0, size);
-			offset += size;
-		}
+		if (!((fields >> i) & 1))
+			continue;
+		
+		/* The largest field is 73 bits. */
+		uint32_t words[3] = { 0, 0, 0 };
+		memcpy(words, (const char*)inst + lima_pp_field_layout[i].offset,
+			lima_pp_field_layout[i].bytes);
+		
+		unsigned size = lima_pp_field_size[i], j;
+		for (j = 0; size > 32; j++, size -= 32)
+			bit_writer_put(&writer, words[j], 32);
+		bit_writer_put(&writer, low_bits(words[j], size), size);
 	}
-
-	if (offset & 0x1F)
-		bitclear(output, offset,
-			(32 - (offset & 0x1F)));
+	
+	/* Pad the last word with zeroes. */
+	if (writer.bits)
+		*writer.out = (uint32_t)writer.acc;
 }
 
 void lima_pp_instruction_decode(
 	uint32_t* source, lima_pp_instruction_t* output)
 {
 	output->control.mask = source[0];
-
-	void* field[] =
-	{
-		&output->varying,
-		&output->sampler,
-		&output->uniform,
-		&output->vec4_mul,
-		&output->float_mul,
-		&output->vec4_acc,
-		&output->float_acc,
-		&output->combine,
-		&output->temp_write,
-		&output->branch,
-		&output->const0,
-		&output->const1,
-	};
-
-	unsigned i, offset;
-	for (i = 0, offset = 32;
-		i < lima_pp_field_count; i++)
+	
+	bit_reader_t reader = { 0, 0, source + 1 };
+	
+	unsigned fields = output->control.fields;
+	unsigned i;
+	for (i = 0; i < lima_pp_field_count; i++)
 	{
-		if ((output->control.fields >> i) & 1)
-		{
-			unsigned size = lima_pp_field_size[i];
-			bitcopy(field[i], 0, source, offset, size);
-			offset += size;
-		}
+		if (!((fields >> i) & 1))
+			continue;
+		
+		uint32_t words[3] = { 0, 0, 0 };
+		unsigned size = lima_pp_field_size[i], j;
+		for (j = 0; size > 32; j++, size -= 32)
+			words[j] = bit_reader_get(&reader, 32);
+		words[j] = bit_reader_get(&reader, size);
+		
+		memcpy((char*)output + lima_pp_field_layout[i].offset, words,
+			lima_pp_field_layout[i].bytes);
 	}
 }
@@ -33,6 +33,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "hfloat.h"
+#include "string_buf.h"
 
 
 
@@ -93,6 +94,24 @@ typedef enum
 	lima_pp_field_count        = 12,
 } lima_pp_field_e;
 
+/* The size in bits of each field, as constants so that the encoder can build
+ * its tables from them at compile time. */
+enum
+{
+	lima_pp_field_varying_size      = 34,
+	lima_pp_field_sampler_size      = 62,
+	lima_pp_field_uniform_size      = 41,
+	lima_pp_field_vec4_mul_size     = 43,
+	lima_pp_field_float_mul_size    = 30,
+	lima_pp_field_vec4_acc_size     = 44,
+	lima_pp_field_float_acc_size    = 31,
+	lima_pp_field_combine_size      = 30,
+	lima_pp_field_temp_write_size   = 41,
+	lima_pp_field_branch_size       = 73,
+	lima_pp_field_vec4_const_0_size = 64,
+	lima_pp_field_vec4_const_1_size = 64,
+};
+
 extern const char* lima_pp_field_name[];
 extern unsigned    lima_pp_field_size[];
 
@@ -476,6 +495,12 @@ extern void     lima_pp_instruction_encode(
 extern void     lima_pp_instruction_decode(
 	uint32_t* source, lima_pp_instruction_t* output);
 extern void     lima_pp_instruction_print(
-	lima_pp_instruction_t* code, bool verbose, unsigned tabs);
+	string_buf_t* buf, lima_pp_instruction_t* code, bool verbose,
+	unsigned tabs);
+
+/* Prints each instruction in code to buf, flushing it after each one. */
+extern bool     lima_pp_disassemble(
+	string_buf_t* buf, const void* code, unsigned size, bool verbose,
+	unsigned tabs);
 
 #endif
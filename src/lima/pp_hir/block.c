@@ -105,6 +105,20 @@ static void update_reg_alloc(lima_pp_hir_cmd_t* cmd)
 		cmd->block->prog->reg_alloc = cmd->dst.reg.index + 1;
 }
 
+static void notify_added(lima_pp_hir_cmd_t* cmd)
+{
+	lima_pp_hir_prog_t* prog = cmd->block->prog;
+	if (prog->cmd_added)
+		prog->cmd_added(cmd, prog->hook_data);
+}
+
+static void notify_deleted(lima_pp_hir_cmd_t* cmd)
+{
+	lima_pp_hir_prog_t* prog = cmd->block->prog;
+	if (prog && prog->cmd_deleted)
+		prog->cmd_deleted(cmd, prog->hook_data);
+}
+
 static void add_to_uses(lima_pp_hir_cmd_t* cmd)
 {
 	unsigned i;
@@ -139,6 +153,7 @@ void lima_pp_hir_block_insert(lima_pp_hir_cmd_t* cmd,
 	cmd->block->size++;
 	update_reg_alloc(cmd);
 	add_to_uses(cmd);
+	notify_added(cmd);
 }
 
 void lima_pp_hir_block_insert_start(lima_pp_hir_block_t* block,
@@ -149,6 +164,7 @@ void lima_pp_hir_block_insert_start(lima_pp_hir_block_t* block,
 	block->size++;
 	update_reg_alloc(cmd);
 	add_to_uses(cmd);
+	notify_added(cmd);
 }
 
 void lima_pp_hir_block_insert_end(lima_pp_hir_block_t* block,
@@ -159,6 +175,7 @@ void lima_pp_hir_block_insert_end(lima_pp_hir_block_t* block,
 	block->size++;
 	update_reg_alloc(cmd);
 	add_to_uses(cmd);
+	notify_added(cmd);
 }
 
 void lima_pp_hir_block_remove(lima_pp_hir_block_t* block,
@@ -167,6 +184,7 @@ void lima_pp_hir_block_remove(lima_pp_hir_block_t* block,
 	block->size--;
 	list_del(&cmd->cmd_list);
 	remove_from_uses(cmd);
+	notify_deleted(cmd);
 	lima_pp_hir_cmd_delete(cmd);
 }
 
@@ -176,9 +194,11 @@ void lima_pp_hir_block_replace(lima_pp_hir_cmd_t* old_cmd,
 	__list_add(&new_cmd->cmd_list, old_cmd->cmd_list.prev, old_cmd->cmd_list.next);
 	new_cmd->block = old_cmd->block;
 	remove_from_uses(old_cmd);
+	notify_deleted(old_cmd);
 	lima_pp_hir_cmd_delete(old_cmd);
 	update_reg_alloc(new_cmd);
 	add_to_uses(new_cmd);
+	notify_added(new_cmd);
 }
 
 typedef struct
@@ -321,6 +341,7 @@ static unsigned block_get_index(lima_pp_hir_block_t* block,
 static _lima_pp_hir_reg_cond_t write_cond_reg(lima_pp_hir_reg_cond_t reg)
 {
 	_lima_pp_hir_reg_cond_t ret;
+	memset(&ret, 0, sizeof(ret));
 	if (reg.is_constant)
 	{
 		ret.is_constant = true;
@@ -340,7 +361,10 @@ void* lima_pp_hir_block_export(lima_pp_hir_block_t* block,
 	if (!block)
 		return NULL;
 
+	/* fields that don't apply to this block are left zeroed, so exporting
+	 * the same block always gives the same bytes */
 	_lima_pp_hir_file_header_t header;
+	memset(&header, 0, sizeof(header));
 	memcpy(&header.ident, "BSB\0", 4);
 	header.size             = block->size;
 	header.is_end           = block->is_end;
@@ -226,6 +226,7 @@ typedef enum
 {
 	_lima_pp_hir_file_src_type_normal,
 	_lima_pp_hir_file_src_type_constant,
+	_lima_pp_hir_file_src_type_undef,
 } _lima_pp_hir_file_src_type_e;
 
 typedef struct
@@ -295,8 +296,19 @@ static bool import_src(void* data, unsigned size, unsigned* pos,
 			if (!dep) return false;
 			memcpy(dep, &v, sizeof(v));
 		}
-	} else {
+	} else if (header.type == _lima_pp_hir_file_src_type_normal) {
 		dep = _lima_pp_hir_find_dep(prog, block, header.reg);
+		if (!dep && src)
+		{
+			/* A phi source coming from a loop's back edge is defined after
+			 * the phi, so point it at a placeholder for now, which
+			 * lima_pp_hir_prog_import() replaces once every block is read.
+			 */
+			dep = lima_pp_hir_cmd_create(lima_pp_hir_op_mov);
+			if (!dep)
+				return false;
+			dep->dst.reg.index = header.reg;
+		}
 		if (!dep)
 			return false;
 	}
@@ -392,6 +404,7 @@ void* lima_pp_hir_cmd_export(lima_pp_hir_cmd_t* cmd, unsigned* size)
 	*size = 0;
 
 	_lima_pp_hir_file_cmd_t header;
+	memset(&header, 0, sizeof(header));
 	header.op       = cmd->op;
 	header.args     = cmd->num_args;
 	header.shift    = cmd->shift;
@@ -415,11 +428,15 @@ void* lima_pp_hir_cmd_export(lima_pp_hir_cmd_t* cmd, unsigned* size)
 	unsigned i;
 	for (i = 0; i < cmd->num_args; i++)
 	{
-		if (!cmd->src[i].depend)
-			return NULL;
-
 		_lima_pp_hir_file_src_t source;
-		if (cmd->src[i].constant)
+		if (!cmd->src[i].depend)
+		{
+			/* phi sources may be undefined along some paths */
+			if (cmd->op != lima_pp_hir_op_phi)
+				return NULL;
+			source.reg  = 0;
+			source.type = _lima_pp_hir_file_src_type_undef;
+		} else if (cmd->src[i].constant)
 		{
 			source.reg  = 0;
 			source.type = _lima_pp_hir_file_src_type_constant;
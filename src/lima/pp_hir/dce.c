@@ -24,6 +24,7 @@
 
 #include "pp_hir.h"
 #include "fixed_queue.h"
+#include "trace.h"
 
 static unsigned num_cmds(lima_pp_hir_prog_t* prog)
 {
@@ -125,7 +126,8 @@ bool lima_pp_hir_dead_code_eliminate(lima_pp_hir_prog_t* prog)
 		if (!lima_pp_hir_reg_narrow(prog))
 			return false;
 		
-		lima_pp_hir_prog_print(prog);
+		if (lima_trace_enabled(lima_trace_ir))
+			lima_pp_hir_prog_print(prog, lima_trace_file(lima_trace_ir));
 		
 		progress = dead_code_eliminate(prog);
 	}
@@ -1635,13 +1635,14 @@ bool lima_pp_hir_op_is_branch(lima_pp_hir_op_e op)
 	
 	lima_pp_hir_prog_cfold(source->prog);
 	
-	unsigned c;
-	do
+	if (!lima_pp_hir_prog_xform(source->prog))
 	{
-		c = lima_pp_hir_prog_xform(source->prog);
-	} while (c != 0);
+		essl_program_delete(dest->symbol_table);
+		free(dest);
+		return NULL;
+	}
 	
-	lima_pp_hir_prog_print(source->prog);
+	lima_pp_hir_prog_print(source->prog, stdout);
 	
 	if (!lima_pp_hir_split_crit_edges(source->prog))
 	{
@@ -1664,7 +1665,7 @@ bool lima_pp_hir_op_is_branch(lima_pp_hir_op_e op)
 		return NULL;
 	}
 	
-	lima_pp_hir_prog_print(source->prog);
+	lima_pp_hir_prog_print(source->prog, stdout);
 	
 	dest->prog = lima_pp_lir_convert(source->prog);
 	if (!dest->prog)
@@ -126,7 +126,7 @@ static lima_pp_lir_instr_t* convert_instr(lima_pp_lir_prog_t* prog,
 										   lima_pp_hir_cmd_t* cmd)
 {
 	unsigned i, j;
-	lima_pp_lir_instr_t* instr = lima_pp_lir_instr_create();
+	lima_pp_lir_instr_t* instr = lima_pp_lir_instr_create(prog);
 	if (!instr)
 	{
 		fprintf(stderr, "Error: failed to allocate new instruction\n");
@@ -210,7 +210,7 @@ static bool convert_combine(lima_pp_lir_block_t* block,
 		}
 		
 		lima_pp_hir_cmd_t* dep = cmd->src[i].depend;
-		lima_pp_lir_instr_t* instr = lima_pp_lir_instr_create();
+		lima_pp_lir_instr_t* instr = lima_pp_lir_instr_create(block->prog);
 		
 		instr->op = lima_pp_hir_op_mov;
 		instr->dest.reg = dest_reg;
@@ -274,14 +274,14 @@ static bool convert_branch(lima_pp_lir_prog_t* frag_prog,
 		if (next_index < 0)
 			return false;
 		
-		lima_pp_lir_instr_t* branch_instr = lima_pp_lir_instr_create();
+		lima_pp_lir_instr_t* branch_instr = lima_pp_lir_instr_create(frag_prog);
 		branch_instr->op = lima_pp_hir_op_branch;
 		branch_instr->branch_dest = (unsigned) next_index;
 
 		return append_instr(frag_block, branch_instr);
 	}
 	
-	lima_pp_lir_instr_t* branch_instr = lima_pp_lir_instr_create();
+	lima_pp_lir_instr_t* branch_instr = lima_pp_lir_instr_create(frag_prog);
 	
 	if (block->next[0] == next_block)
 	{
@@ -416,7 +416,7 @@ static bool convert_branch(lima_pp_lir_prog_t* frag_prog,
 		if (next_index < 0)
 			return false;
 		
-		branch_instr = lima_pp_lir_instr_create();
+		branch_instr = lima_pp_lir_instr_create(frag_prog);
 		branch_instr->op = lima_pp_hir_op_branch;
 		branch_instr->branch_dest = (unsigned) next_index;
 		
@@ -468,7 +468,7 @@ static lima_pp_lir_block_t* convert_block(lima_pp_lir_prog_t* frag_prog,
 	{
 		ret->num_succs = 0;
 		ret->discard = block->discard;
-		lima_pp_lir_instr_t* output_instr = lima_pp_lir_instr_create();
+		lima_pp_lir_instr_t* output_instr = lima_pp_lir_instr_create(frag_prog);
 		if (!output_instr)
 		{
 			fprintf(stderr, "Error: failed to allocate output instruction\n");
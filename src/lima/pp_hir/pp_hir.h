@@ -376,6 +376,14 @@ typedef struct lima_pp_hir_prog_s
 	
 	unsigned num_arrays;
 	lima_pp_hir_temp_array_t* arrays;
+	
+	/* if set, called with hook_data whenever a command is added to or
+	 * deleted from one of the blocks, for passes that keep track of
+	 * commands themselves
+	 */
+	void (*cmd_added)(lima_pp_hir_cmd_t* cmd, void* data);
+	void (*cmd_deleted)(lima_pp_hir_cmd_t* cmd, void* data);
+	void* hook_data;
 } lima_pp_hir_prog_t;
 
 
@@ -526,14 +534,14 @@ void* lima_pp_hir_block_export(
 	lima_pp_hir_block_t* block,
 	lima_pp_hir_prog_t* prog, unsigned* size);
 
-bool lima_pp_hir_prog_print(lima_pp_hir_prog_t* prog);
+bool lima_pp_hir_prog_print(lima_pp_hir_prog_t* prog, FILE* f);
 bool lima_pp_hir_block_print(
 	lima_pp_hir_block_t* block,
-	lima_pp_hir_prog_t* prog);
+	lima_pp_hir_prog_t* prog, FILE* f);
 void lima_pp_hir_cmd_print(
 	lima_pp_hir_cmd_t* cmd,
 	lima_pp_hir_block_t* block,
-	lima_pp_hir_prog_t* prog);
+	lima_pp_hir_prog_t* prog, FILE* f);
 
 bool lima_pp_hir_calc_dominance(lima_pp_hir_prog_t* prog);
 
@@ -30,17 +30,17 @@
 
 
 
-static void reg_print(lima_pp_hir_reg_t* reg)
+static void reg_print(lima_pp_hir_reg_t* reg, FILE* f)
 {
-	printf("%%%u", reg->index);
+	fprintf(f, "%%%u", reg->index);
 }
 
-static void source_print(lima_pp_hir_source_t* src, unsigned num_channels)
+static void source_print(lima_pp_hir_source_t* src, unsigned num_channels, FILE* f)
 {
 	if (src->negate)
-		printf("-");
+		fprintf(f, "-");
 	if (src->absolute)
-		printf("abs(");
+		fprintf(f, "abs(");
 
 	if (src->constant)
 	{
@@ -55,12 +55,12 @@ static void source_print(lima_pp_hir_source_t* src, unsigned num_channels)
 			&& (vs[1] == vs[3]))
 		{
 			if (vs[0] == vs[1])
-				printf("%g", vs[0]);
+				fprintf(f, "%g", vs[0]);
 			else
-				printf("vec2(%g, %g)",
+				fprintf(f, "vec2(%g, %g)",
 					vs[0], vs[1]);
 		} else {
-			printf("vec4(%g, %g, %g, %g)",
+			fprintf(f, "vec4(%g, %g, %g, %g)",
 				vs[0], vs[1], vs[2], vs[3]);
 		}
 	} else {
@@ -68,31 +68,31 @@ static void source_print(lima_pp_hir_source_t* src, unsigned num_channels)
 		if (cmd)
 		{
 			lima_pp_hir_reg_t* reg = &cmd->dst.reg;
-			reg_print(reg);
-			printf(".");
+			reg_print(reg, f);
+			fprintf(f, ".");
 			const char* c = "xyzw";
 			unsigned i;
 			for (i = 0; i < num_channels; i++)
-				printf("%c", c[src->swizzle[i]]);
+				fprintf(f, "%c", c[src->swizzle[i]]);
 		}
 		else
-			printf("(undefined)");
+			fprintf(f, "(undefined)");
 	}
 
 	if (src->absolute)
-		printf(")");
+		fprintf(f, ")");
 }
 
-static void dest_print(lima_pp_hir_dest_t* dst)
+static void dest_print(lima_pp_hir_dest_t* dst, FILE* f)
 {
 	if (dst->reg.size)
-		printf("vec%u ", (dst->reg.size + 1));
+		fprintf(f, "vec%u ", (dst->reg.size + 1));
 	else
-		printf("float ");
+		fprintf(f, "float ");
 
-	reg_print(&dst->reg);
+	reg_print(&dst->reg, f);
 
-	printf(" = ");
+	fprintf(f, " = ");
 }
 
 static int get_block_index(lima_pp_hir_block_t* block, lima_pp_hir_prog_t* prog)
@@ -109,77 +109,77 @@ static int get_block_index(lima_pp_hir_block_t* block, lima_pp_hir_prog_t* prog)
 }
 
 void lima_pp_hir_cmd_print(lima_pp_hir_cmd_t* cmd, lima_pp_hir_block_t* block,
-					   lima_pp_hir_prog_t* prog)
+					   lima_pp_hir_prog_t* prog, FILE* f)
 {
 	if (lima_pp_hir_op[cmd->op].has_dest)
-		dest_print(&cmd->dst);
+		dest_print(&cmd->dst, f);
 
 	lima_pp_hir_op_t op
 		= lima_pp_hir_op[cmd->op];
 
-	printf("%s ", op.name);
+	fprintf(f, "%s ", op.name);
 	
 	if (lima_pp_hir_op_is_load_store(cmd->op))
 	{
-		printf("%u", cmd->load_store_index);
+		fprintf(f, "%u", cmd->load_store_index);
 		if (lima_pp_hir_op_is_store(cmd->op))
 		{
 			if (lima_pp_hir_op[cmd->op].args == 2)
 			{
-				printf(" + ");
-				source_print(&cmd->src[0], lima_pp_hir_arg_size(cmd, 0));
+				fprintf(f, " + ");
+				source_print(&cmd->src[0], lima_pp_hir_arg_size(cmd, 0), f);
 			}
-			printf(" = ");
+			fprintf(f, " = ");
 		}
 		else if(lima_pp_hir_op[cmd->op].args)
-			printf(", ");
+			fprintf(f, ", ");
 	}
 
 	if (lima_pp_hir_op_is_store(cmd->op) &&
 		lima_pp_hir_op[cmd->op].args == 2)
 	{
-		source_print(&cmd->src[1], lima_pp_hir_arg_size(cmd, 1));
+		source_print(&cmd->src[1], lima_pp_hir_arg_size(cmd, 1), f);
 	}
 	else
 	{
 		if (cmd->num_args)
 		{
-			source_print(&cmd->src[0], lima_pp_hir_arg_size(cmd, 0));
+			source_print(&cmd->src[0], lima_pp_hir_arg_size(cmd, 0), f);
 			if (cmd->op == lima_pp_hir_op_phi)
 			{
-				printf(" : ");
-				printf("%u", get_block_index(block->preds[0], prog));
+				fprintf(f, " : ");
+				fprintf(f, "%u", get_block_index(block->preds[0], prog));
 			}
 
 			unsigned i;
 			for (i = 1; i < cmd->num_args; i++)
 			{
-				printf(", ");
-				source_print(&cmd->src[i], lima_pp_hir_arg_size(cmd, i));
+				fprintf(f, ", ");
+				source_print(&cmd->src[i], lima_pp_hir_arg_size(cmd, i), f);
 				if (cmd->op == lima_pp_hir_op_phi)
 				{
-					printf(" : ");
-					printf("%u", get_block_index(block->preds[i], prog));
+					fprintf(f, " : ");
+					fprintf(f, "%u", get_block_index(block->preds[i], prog));
 				}
 			}
 		}
 		
 		if (cmd->op == lima_pp_hir_op_mul && cmd->shift != 0)
-			printf(" << %d", cmd->shift);
+			fprintf(f, " << %d", cmd->shift);
 	}
 
-	printf(";\n");
+	fprintf(f, ";\n");
 }
 
-static void reg_cond_print(lima_pp_hir_reg_cond_t reg_cond)
+static void reg_cond_print(lima_pp_hir_reg_cond_t reg_cond, FILE* f)
 {
 	if (reg_cond.is_constant)
-		printf("%g", reg_cond.constant);
+		fprintf(f, "%g", reg_cond.constant);
 	else
-		reg_print(&reg_cond.reg->dst.reg);
+		reg_print(&reg_cond.reg->dst.reg, f);
 }
 
-bool lima_pp_hir_block_print(lima_pp_hir_block_t* block, lima_pp_hir_prog_t* prog)
+bool lima_pp_hir_block_print(lima_pp_hir_block_t* block, lima_pp_hir_prog_t* prog, FILE* f)
 {
 	if (!block)
 		return false;
@@ -190,27 +190,27 @@ bool lima_pp_hir_block_print(lima_pp_hir_block_t* block, lima_pp_hir_prog_t* pro
 		fprintf(stderr, "Error: basic block found not in program\n");
 		return false;
 	}
-	printf("%d:\n", index);
+	fprintf(f, "%d:\n", index);
 
 	lima_pp_hir_cmd_t* cmd;
 	pp_hir_block_for_each_cmd(block, cmd)
 	{
 		if (cmd->op != lima_pp_hir_op_phi)
 			break;
-		lima_pp_hir_cmd_print(cmd, block, prog);
+		lima_pp_hir_cmd_print(cmd, block, prog, f);
 	}
-	printf("%%\n");
+	fprintf(f, "%%\n");
 	pp_hir_block_for_each_cmd(block, cmd)
 	{
 		if (cmd->op == lima_pp_hir_op_phi)
 			continue;
-		lima_pp_hir_cmd_print(cmd, block, prog);
+		lima_pp_hir_cmd_print(cmd, block, prog, f);
 	}
 	
 	if (!block->is_end)
 	{
 		if (block->branch_cond == lima_pp_hir_branch_cond_always)
-			printf("branch %d;\n", get_block_index(block->next[0], prog));
+			fprintf(f, "branch %d;\n", get_block_index(block->next[0], prog));
 		else
 		{
 			char *conds[7] = {
@@ -222,47 +222,47 @@ bool lima_pp_hir_block_print(lima_pp_hir_block_t* block, lima_pp_hir_prog_t* pro
 				"ne",
 				"le"
 			};
-			printf("branch.%s ", conds[block->branch_cond]);
-			reg_cond_print(block->reg_cond_a);
-			printf(": %d, ", get_block_index(block->next[0], prog));
-			reg_cond_print(block->reg_cond_b);
-			printf(": %d;\n", get_block_index(block->next[1], prog));
+			fprintf(f, "branch.%s ", conds[block->branch_cond]);
+			reg_cond_print(block->reg_cond_a, f);
+			fprintf(f, ": %d, ", get_block_index(block->next[0], prog));
+			reg_cond_print(block->reg_cond_b, f);
+			fprintf(f, ": %d;\n", get_block_index(block->next[1], prog));
 		}
 	}
 	else
 	{
 		if (block->discard)
-			printf("discard;\n");
+			fprintf(f, "discard;\n");
 		else
 		{
-			printf("output ");
-			reg_print(&block->output->dst.reg);
-			printf(";\n");
+			fprintf(f, "output ");
+			reg_print(&block->output->dst.reg, f);
+			fprintf(f, ";\n");
 		}
 	}
 		
-	printf("\n");
+	fprintf(f, "\n");
 
 	return true;
 }
 
-static void array_print(lima_pp_hir_temp_array_t array)
+static void array_print(lima_pp_hir_temp_array_t array, FILE* f)
 {
 	static char* align[2] = {"1", "4"};
-	printf("array align(%s) [%u-%u];\n", align[array.alignment], array.start,
+	fprintf(f, "array align(%s) [%u-%u];\n", align[array.alignment], array.start,
 		   array.end);
 }
 
-bool lima_pp_hir_prog_print(lima_pp_hir_prog_t *prog)
+bool lima_pp_hir_prog_print(lima_pp_hir_prog_t *prog, FILE* f)
 {
 	lima_pp_hir_block_t* block;
 	pp_hir_prog_for_each_block(prog, block)
-		if(!lima_pp_hir_block_print(block, prog))
+		if(!lima_pp_hir_block_print(block, prog, f))
 			return false;
 	
 	unsigned i;
 	for (i = 0; i < prog->num_arrays; i++)
-		array_print(prog->arrays[i]);
+		array_print(prog->arrays[i], f);
 	
 	return true;
 }
@@ -38,8 +38,12 @@ lima_pp_hir_prog_t* lima_pp_hir_prog_create(void)
 	list_init(&prog->block_list);
 	prog->num_blocks = 0;
 	prog->reg_alloc = 0;
+	prog->temp_alloc = 0;
 	prog->num_arrays = 0;
 	prog->arrays = NULL;
+	prog->cmd_added = NULL;
+	prog->cmd_deleted = NULL;
+	prog->hook_data = NULL;
 	return prog;
 }
 
@@ -197,9 +201,10 @@ typedef struct
 __attribute__((__packed__))
 {
 	char     ident[4]; /* ="LIR\0" */
-	uint32_t version;  /* =3       */
+	uint32_t version;  /* =4       */
 	uint32_t num_blocks;
 	uint32_t num_arrays;
+	uint32_t temp_alloc;
 } _lima_pp_hir_file_header_t;
 
 typedef struct
@@ -207,6 +212,68 @@ typedef struct
 	uint32_t start, end, alignment;
 } _array_data_t;
 
+/*
+ * Replaces the placeholders lima_pp_hir_cmd_import() creates for sources
+ * defined later in the program with the commands that actually define them.
+ * Placeholders are the only commands that aren't in a block.
+ */
+
+static bool resolve_forward_refs(lima_pp_hir_prog_t* prog)
+{
+	lima_pp_hir_cmd_t** defs = calloc(prog->reg_alloc + 1,
+									  sizeof(lima_pp_hir_cmd_t*));
+	if (!defs)
+		return false;
+	
+	ptrset_t placeholders;
+	if (!ptrset_create(&placeholders))
+	{
+		free(defs);
+		return false;
+	}
+	
+	lima_pp_hir_block_t* block;
+	lima_pp_hir_cmd_t* cmd;
+	pp_hir_prog_for_each_block(prog, block)
+		pp_hir_block_for_each_cmd(block, cmd)
+			if (lima_pp_hir_op[cmd->op].has_dest)
+				defs[cmd->dst.reg.index] = cmd;
+	
+	bool ret = true;
+	pp_hir_prog_for_each_block(prog, block)
+	{
+		pp_hir_block_for_each_cmd(block, cmd)
+		{
+			unsigned i;
+			for (i = 0; i < cmd->num_args; i++)
+			{
+				lima_pp_hir_cmd_t* dep = cmd->src[i].depend;
+				if (cmd->src[i].constant || !dep || dep->block)
+					continue;
+				
+				ptrset_add(&placeholders, dep);
+				if (dep->dst.reg.index >= prog->reg_alloc ||
+					!defs[dep->dst.reg.index])
+				{
+					ret = false;
+					continue;
+				}
+				
+				cmd->src[i].depend = defs[dep->dst.reg.index];
+				ptrset_add(&defs[dep->dst.reg.index]->cmd_uses, cmd);
+			}
+		}
+	}
+	
+	ptrset_iter_t iter = ptrset_iter_create(placeholders);
+	ptrset_iter_for_each(iter, cmd)
+		lima_pp_hir_cmd_delete(cmd);
+	
+	ptrset_delete(placeholders);
+	free(defs);
+	return ret;
+}
+
 lima_pp_hir_prog_t* lima_pp_hir_prog_import(void* data, unsigned size)
 {
 	unsigned pos = 0;
@@ -229,13 +296,15 @@ lima_pp_hir_prog_t* lima_pp_hir_prog_import(void* data, unsigned size)
 		fprintf(stderr, "Error: Failed to import program, incorrect ident.\n");
 		return NULL;
 	}
-	if (header.version != 3)
+	if (header.version != 4)
 	{
 		lima_pp_hir_prog_delete(prog);
 		fprintf(stderr, "Error: Failed to import program, unsupported version.\n");
 		return NULL;
 	}
 
+	prog->temp_alloc = header.temp_alloc;
+
 	uint32_t i;
 	lima_pp_hir_block_t** blocks = malloc(sizeof(lima_pp_hir_block_t*)
 										  * header.num_blocks);
@@ -299,6 +368,14 @@ lima_pp_hir_prog_t* lima_pp_hir_prog_import(void* data, unsigned size)
 		}
 	}
 	
+	if (!resolve_forward_refs(prog))
+	{
+		lima_pp_hir_prog_delete(prog);
+		free(blocks);
+		fprintf(stderr, "Error: Failed to import program, undefined register.\n");
+		return NULL;
+	}
+	
 	if (!lima_pp_hir_prog_add_predecessors(prog))
 	{
 		lima_pp_hir_prog_delete(prog);
@@ -318,9 +395,10 @@ void* lima_pp_hir_prog_export(lima_pp_hir_prog_t* prog, unsigned* size)
 
 	_lima_pp_hir_file_header_t header;
 	memcpy(&header.ident, "LIR\0", 4);
-	header.version    = 3;
+	header.version    = 4;
 	header.num_blocks = prog->num_blocks;
 	header.num_arrays = prog->num_arrays;
+	header.temp_alloc = prog->temp_alloc;
 	
 	*size = 0;
 	
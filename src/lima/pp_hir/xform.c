@@ -26,6 +26,8 @@
 
 
 #include "pp_hir.h"
+#include "ptr_vector.h"
+#include "trace.h"
 #include <stdlib.h>
 #include <math.h>
 #include <assert.h>
@@ -1358,28 +1360,184 @@ bool (*lima_pp_hir_xform[])(lima_pp_hir_cmd_t* cmd) =
 
 
 
-unsigned lima_pp_hir_prog_xform(lima_pp_hir_prog_t* prog)
+/* The worklist holds every command that may still need to be transformed, in
+ * the order they're to be visited. Each command is on it at most once, and
+ * commands deleted while they're on it are replaced with NULL. The commands
+ * added to the program by the transform being run are collected in added.
+ */
+
+typedef struct
 {
-	if (!prog)
-		return 0;
+	ptr_vector_t cmds;
+	unsigned head;
+	ptrset_t queued;
+	ptr_vector_t added;
+	bool error;
+} worklist_t;
+
+static bool worklist_push(worklist_t* worklist, lima_pp_hir_cmd_t* cmd)
+{
+	if (cmd->op >= lima_pp_hir_op_count || !lima_pp_hir_xform[cmd->op])
+		return true;
+	
+	if (ptrset_contains(worklist->queued, cmd))
+		return true;
+	
+	if (!ptr_vector_add(&worklist->cmds, cmd))
+		return false;
+	if (!ptrset_add(&worklist->queued, cmd))
+		return false;
+	return true;
+}
+
+static lima_pp_hir_cmd_t* worklist_pull(worklist_t* worklist)
+{
+	while (worklist->head < ptr_vector_size(worklist->cmds))
+	{
+		lima_pp_hir_cmd_t* cmd =
+			ptr_vector_get(worklist->cmds, worklist->head++);
+		if (!cmd)
+			continue;
+		
+		ptrset_remove(&worklist->queued, cmd);
+		return cmd;
+	}
+	
+	return NULL;
+}
+
+static void remove_cmd(ptr_vector_t vector, unsigned start,
+					   lima_pp_hir_cmd_t* cmd)
+{
+	unsigned i;
+	for (i = start; i < ptr_vector_size(vector); i++)
+	{
+		if (ptr_vector_get(vector, i) == cmd)
+		{
+			ptr_vector_set(vector, NULL, i);
+			return;
+		}
+	}
+}
+
+static void cmd_added(lima_pp_hir_cmd_t* cmd, void* data)
+{
+	worklist_t* worklist = data;
+	if (!ptr_vector_add(&worklist->added, cmd))
+		worklist->error = true;
+}
+
+static void cmd_deleted(lima_pp_hir_cmd_t* cmd, void* data)
+{
+	worklist_t* worklist = data;
+	
+	/* the command being transformed has already been pulled, so this is
+	 * rarely needed
+	 */
+	if (ptrset_contains(worklist->queued, cmd))
+	{
+		ptrset_remove(&worklist->queued, cmd);
+		remove_cmd(worklist->cmds, worklist->head, cmd);
+	}
+	
+	remove_cmd(worklist->added, 0, cmd);
+}
 
-	unsigned c = 0;
+/* Queues the commands the last transform added, along with their users. */
+
+static bool queue_added_cmds(worklist_t* worklist)
+{
+	unsigned i;
+	for (i = 0; i < ptr_vector_size(worklist->added); i++)
+	{
+		lima_pp_hir_cmd_t* cmd = ptr_vector_get(worklist->added, i);
+		if (!cmd)
+			continue;
+		
+		if (!worklist_push(worklist, cmd))
+			return false;
+		
+		lima_pp_hir_cmd_t* use;
+		ptrset_iter_t iter = ptrset_iter_create(cmd->cmd_uses);
+		ptrset_iter_for_each(iter, use)
+		{
+			if (!worklist_push(worklist, use))
+				return false;
+		}
+	}
+	
+	ptr_vector_clear(&worklist->added);
+	return true;
+}
+
+/* Lowers every command which has a transform until none are left. Commands
+ * are visited once up front, and after that only the ones a transform adds,
+ * and their users, are revisited. Returns false if it ran out of memory.
+ */
+
+bool lima_pp_hir_prog_xform(lima_pp_hir_prog_t* prog)
+{
+	if (!prog)
+		return false;
+	
+	worklist_t worklist;
+	worklist.cmds = ptr_vector_create();
+	worklist.added = ptr_vector_create();
+	worklist.head = 0;
+	worklist.error = false;
+	if (!ptrset_create(&worklist.queued))
+		return false;
+	
+	unsigned hits[lima_pp_hir_op_count] = {0};
+	bool ret = false;
+	
 	lima_pp_hir_block_t* block;
 	pp_hir_prog_for_each_block(prog, block)
 	{
-		lima_pp_hir_cmd_t* cmd, *tmp_cmd;
-		pp_hir_block_for_each_cmd_safe(block, tmp_cmd, cmd)
+		lima_pp_hir_cmd_t* cmd;
+		pp_hir_block_for_each_cmd(block, cmd)
 		{
-			unsigned o = cmd->op;
-			if (o >= lima_pp_hir_op_count)
-				continue;
-			if (lima_pp_hir_xform[o])
-			{
-				if (lima_pp_hir_xform[o](cmd))
-					c++;
-			}
+			if (!worklist_push(&worklist, cmd))
+				goto cleanup;
 		}
 	}
-
-	return c;
+	
+	prog->cmd_added = cmd_added;
+	prog->cmd_deleted = cmd_deleted;
+	prog->hook_data = &worklist;
+	
+	lima_pp_hir_cmd_t* cmd;
+	while ((cmd = worklist_pull(&worklist)))
+	{
+		lima_pp_hir_op_e op = cmd->op;
+		bool progress = lima_pp_hir_xform[op](cmd);
+		if (worklist.error)
+			goto cleanup;
+		
+		if (progress)
+			hits[op]++;
+		
+		if (!queue_added_cmds(&worklist))
+			goto cleanup;
+	}
+	
+	if (lima_trace_enabled(lima_trace_ir))
+	{
+		unsigned o;
+		for (o = 0; o < lima_pp_hir_op_count; o++)
+			if (hits[o])
+				lima_trace(lima_trace_ir, "xform %s: %u\n",
+						   lima_pp_hir_op[o].name, hits[o]);
+	}
+	
+	ret = true;
+	
+cleanup:
+	prog->cmd_added = NULL;
+	prog->cmd_deleted = NULL;
+	prog->hook_data = NULL;
+	ptr_vector_delete(worklist.cmds);
+	ptr_vector_delete(worklist.added);
+	ptrset_delete(worklist.queued);
+	return ret;
 }
@@ -35,7 +35,7 @@ extern "C" {
 
 extern bool (*lima_pp_hir_xform[])(lima_pp_hir_prog_t* prog, unsigned index);
 
-extern unsigned lima_pp_hir_prog_xform(lima_pp_hir_prog_t* prog);
+extern bool lima_pp_hir_prog_xform(lima_pp_hir_prog_t* prog);
 
 #ifdef __cplusplus
 }
@@ -23,22 +23,24 @@
  */
 
 #include "scheduler.h"
-#include "priority_queue.h"
 
 bool lima_pp_lir_schedule_block(lima_pp_lir_block_t* block,
 								sched_priority_cb sched_priority,
 								sched_insert_cb sched_insert)
 {
-	priority_queue_t* work_queue =
-		priority_queue_create(sched_priority);
+	list_sched_t sched;
+	if (!list_sched_create(&sched, sched_priority,
+						   offsetof(lima_pp_lir_scheduled_instr_t, sched_node)))
+		return false;
+	
+	ptr_vector_t preds = ptr_vector_create();
+	bool ret = false;
 	
 	lima_pp_lir_scheduled_instr_t* instr;
 	pp_lir_block_for_each_instr(block, instr)
 	{
-		if (ptrset_size(instr->succs) == 0)
-			priority_queue_push(work_queue, instr);
-		
-		instr->visited = false;
+		if (!list_sched_add(&sched, instr, ptrset_size(instr->succs)))
+			goto cleanup;
 	}
 	
 	//Here's the hacky part... we delete the instructions from the list,
@@ -49,55 +51,37 @@ bool lima_pp_lir_schedule_block(lima_pp_lir_block_t* block,
 		block->num_instrs--;
 	}
 	
-	while (priority_queue_num_elems(work_queue) != 0)
+	while ((instr = list_sched_pull(&sched)))
 	{
-		instr = priority_queue_pull(work_queue);
-		
-		//Make a copy of instr->preds, since instr may be deleted by
-		//sched_insert() and we need it in the loop later on
-		ptrset_t preds;
-		if (!ptrset_copy(&preds, instr->preds))
-		{
-			priority_queue_delete(work_queue);
-			return false;
-		}
-		
-		instr->visited = true;
-		
-		if (!sched_insert(instr))
-		{
-			priority_queue_delete(work_queue);
-			ptrset_delete(preds);
-			return false;
-		}
-		
-		ptrset_iter_t iter = ptrset_iter_create(preds);
+		//Save instr->preds, since instr may be deleted by sched_insert() and
+		//we need it afterwards
+		ptr_vector_clear(&preds);
+		ptrset_iter_t iter = ptrset_iter_create(instr->preds);
 		lima_pp_lir_scheduled_instr_t* pred;
 		ptrset_iter_for_each(iter, pred)
 		{
-			bool succs_visited = true;
-			ptrset_iter_t iter2 = ptrset_iter_create(pred->succs);
-			lima_pp_lir_scheduled_instr_t* succ;
-			ptrset_iter_for_each(iter2, succ)
-			{
-				if (!succ->visited)
-				{
-					succs_visited = false;
-					break;
-				}
-			}
-			
-			if (succs_visited)
-			{
-				priority_queue_push(work_queue, pred);
-			}
+			if (!ptr_vector_add(&preds, pred))
+				goto cleanup;
 		}
 		
-		ptrset_delete(preds);
+		if (!sched_insert(instr))
+			goto cleanup;
+		
+		//If instr was combined with an instruction already scheduled, its
+		//predecessors now depend on that instruction instead, so they still
+		//have one less successor left either way
+		unsigned i;
+		for (i = 0; i < ptr_vector_size(preds); i++)
+			if (!list_sched_succ_done(&sched, ptr_vector_get(preds, i)))
+				goto cleanup;
 	}
 	
-	priority_queue_delete(work_queue);
-	return true;
+	ret = true;
+	
+cleanup:
+	ptr_vector_delete(preds);
+	list_sched_delete(&sched);
+	return ret;
 }
 
 bool lima_pp_lir_schedule_prog(lima_pp_lir_prog_t* prog,
@@ -50,6 +50,11 @@ void lima_pp_lir_block_delete(lima_pp_lir_block_t* block)
 		lima_pp_lir_block_remove(instr);
 	}
 	
+	lima_pp_lir_block_delete_shallow(block);
+}
+
+void lima_pp_lir_block_delete_shallow(lima_pp_lir_block_t* block)
+{
 	if (block->preds)
 		free(block->preds);
 	
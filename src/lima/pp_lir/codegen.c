@@ -25,6 +25,7 @@
 #include "pp_lir.h"
 #include "../pp/lima_pp.h"
 #include "hfloat.h"
+#include "cycle_estimate.h"
 #include <assert.h>
 
 static bool is_scalar_temp_load(lima_pp_hir_op_e op)
@@ -1263,15 +1264,124 @@ static void resolve_branch_dests(pp_asm_block_t** blocks, unsigned num_blocks)
 	}
 }
 
+static void count_field(lima_slot_usage_t* usage,
+						lima_pp_instruction_t* instr, lima_pp_field_e field)
+{
+	usage->total++;
+	if (instr->control.fields & (1 << field))
+		usage->used++;
+}
+
+static void report_instr(lima_pp_instruction_t* instr,
+						 lima_shader_report_t* report)
+{
+	report->num_instructions++;
+	
+	count_field(&report->units.fs.varying, instr, lima_pp_field_varying);
+	count_field(&report->units.fs.texld, instr, lima_pp_field_sampler);
+	count_field(&report->units.fs.uniform, instr, lima_pp_field_uniform);
+	count_field(&report->units.fs.vmul, instr, lima_pp_field_vec4_mul);
+	count_field(&report->units.fs.fmul, instr, lima_pp_field_float_mul);
+	count_field(&report->units.fs.vadd, instr, lima_pp_field_vec4_acc);
+	count_field(&report->units.fs.fadd, instr, lima_pp_field_float_acc);
+	count_field(&report->units.fs.combine, instr, lima_pp_field_combine);
+	count_field(&report->const_slots, instr, lima_pp_field_vec4_const_0);
+	count_field(&report->const_slots, instr, lima_pp_field_vec4_const_1);
+	
+	unsigned fields = instr->control.fields;
+	if ((fields & (1 << lima_pp_field_uniform)) &&
+		instr->uniform.source == lima_pp_uniform_src_temporary)
+		report->temp_loads++;
+	
+	/* the same field does framebuffer reads */
+	if ((fields & (1 << lima_pp_field_temp_write)) &&
+		instr->temp_write.temp_write.dest == 3)
+		report->temp_stores++;
+}
+
+static bool has_branch(lima_pp_instruction_t* instr)
+{
+	return instr->control.fields & (1 << lima_pp_field_branch);
+}
+
+static bool is_unconditional(lima_pp_instruction_t* instr)
+{
+	return instr->branch.branch.cond_gt && instr->branch.branch.cond_eq &&
+		instr->branch.branch.cond_lt;
+}
+
+/* A block can branch from its last two instructions, to dest2 from the
+ * second to last and to dest1 from the last, and falls through to the
+ * next block unless the last branch is unconditional. Discards and other
+ * instructions with the stop bit end the shader.
+ */
+
+static bool report_prog(pp_asm_block_t** blocks, unsigned num_blocks,
+						lima_shader_report_t* report)
+{
+	memset(report, 0, sizeof(*report));
+	
+	cycle_block_t* cycle_blocks = calloc(num_blocks, sizeof(cycle_block_t));
+	if (!cycle_blocks)
+		return false;
+	
+	unsigned i, j;
+	for (i = 0; i < num_blocks; i++)
+	{
+		pp_asm_block_t* block = blocks[i];
+		cycle_block_t* cycle_block = &cycle_blocks[i];
+		unsigned size = block->size;
+		
+		for (j = 0; j < size; j++)
+			report_instr(&block->instrs[j], report);
+		
+		if (block->discard || (size && block->instrs[size - 1].control.stop))
+		{
+			cycle_block_add_edge(cycle_block, size, CYCLE_EXIT);
+			continue;
+		}
+		
+		if (size >= 2 && has_branch(&block->instrs[size - 2]))
+		{
+			report->branches++;
+			cycle_block_add_edge(cycle_block, size - 1, block->dest2);
+			if (is_unconditional(&block->instrs[size - 2]))
+				continue;
+		}
+		
+		if (size >= 1 && has_branch(&block->instrs[size - 1]))
+		{
+			report->branches++;
+			cycle_block_add_edge(cycle_block, size, block->dest1);
+			if (is_unconditional(&block->instrs[size - 1]))
+				continue;
+		}
+		
+		cycle_block_add_edge(cycle_block, size, i + 1);
+	}
+	
+	bool ret = cycle_estimate(cycle_blocks, num_blocks, report);
+	free(cycle_blocks);
+	return ret;
+}
+
 static void dump_asm(pp_asm_block_t** blocks, unsigned num_blocks)
 {
+	string_buf_t buf;
+	if (!string_buf_init(&buf, NULL, NULL))
+		return;
+	
 	unsigned i, j;
 	for (i = 0; i < num_blocks; i++)
 		for (j = 0; j < blocks[i]->size; j++)
-			lima_pp_instruction_print(&blocks[i]->instrs[j], true, 0);
+			lima_pp_instruction_print(&buf, &blocks[i]->instrs[j], true, 0);
+	
+	fputs(buf.data, stdout);
+	string_buf_delete(&buf);
 }
 
-void* lima_pp_lir_codegen(lima_pp_lir_prog_t* prog, unsigned* code_size)
+void* lima_pp_lir_codegen(lima_pp_lir_prog_t* prog, unsigned* code_size,
+						  lima_shader_report_t* report)
 {
 	offset_temporaries(prog);
 	
@@ -1290,7 +1400,9 @@ void* lima_pp_lir_codegen(lima_pp_lir_prog_t* prog, unsigned* code_size)
 	
 	/*dump_asm(blocks, prog->num_blocks);*/
 	
-	uint32_t* code = malloc(size * sizeof(uint32_t));
+	uint32_t* code = NULL;
+	if (report_prog(blocks, prog->num_blocks, report))
+		code = malloc(size * sizeof(uint32_t));
 	if (!code)
 	{
 		for (i = 0; i < prog->num_blocks; i++)
@@ -141,8 +141,10 @@ static void update_reg_write_regs(bitset_t read_regs, bitset_t write_regs,
 
 static void calc_read_write_regs(lima_pp_lir_scheduled_instr_t* instr)
 {
-	instr->read_regs = bitset_create((instr->block->prog->reg_alloc + 6) * 4);
-	instr->write_regs = bitset_create((instr->block->prog->reg_alloc + 6) * 4);
+	instr->read_regs = bitset_create_arena((instr->prog->reg_alloc + 6) * 4,
+										   instr->prog->arena);
+	instr->write_regs = bitset_create_arena((instr->prog->reg_alloc + 6) * 4,
+											instr->prog->arena);
 	
 	if (instr->varying_instr)
 		update_reg_write_regs(instr->read_regs, instr->write_regs,
@@ -305,28 +307,105 @@ static void add_dep_instr(lima_pp_lir_scheduled_instr_t* instr)
 	}
 }
 
-static void remove_true_dep(lima_pp_lir_scheduled_instr_t* before,
-							lima_pp_lir_scheduled_instr_t* after)
+static void remove_min_dep(lima_pp_lir_scheduled_instr_t* before,
+						   lima_pp_lir_scheduled_instr_t* after)
 {
 	ptrset_remove(&before->min_succs, after);
 	ptrset_remove(&after->min_preds, before);
 }
 
-static void remove_edges(lima_pp_lir_scheduled_instr_t* start_instr,
-						 lima_pp_lir_scheduled_instr_t* cur_instr)
+/* Fills in reach for instr and everything below it. Since the graph is
+ * acyclic, once all the successors of an instruction are done, what it can
+ * reach is just its successors plus whatever they can reach, which is a
+ * bitwise OR of a word at a time.
+ */
+
+static void calc_reach(lima_pp_lir_reach_t* reach,
+					   lima_pp_lir_scheduled_instr_t* instr)
 {
-	if (cur_instr->visited)
-		return;
+	bitset_t* set = &reach->reach[instr->reach_index];
+	
+	ptrset_iter_t iter = ptrset_iter_create(instr->succs);
+	lima_pp_lir_scheduled_instr_t* succ;
+	ptrset_iter_for_each(iter, succ)
+	{
+		if (!succ->visited)
+			calc_reach(reach, succ);
+		
+		bitset_union(set, reach->reach[succ->reach_index]);
+		bitset_set(*set, succ->reach_index, true);
+	}
+	
+	instr->visited = true;
+}
+
+bool lima_pp_lir_reach_create(lima_pp_lir_reach_t* reach,
+							  lima_pp_lir_block_t* block)
+{
+	reach->num_instrs = block->num_instrs;
+	reach->reach = malloc(block->num_instrs * sizeof(bitset_t));
+	if (!reach->reach)
+		return false;
+	
+	unsigned i = 0;
+	lima_pp_lir_scheduled_instr_t* instr;
+	pp_lir_block_for_each_instr(block, instr)
+	{
+		instr->reach_index = i;
+		instr->visited = false;
+		reach->reach[i++] = bitset_create(block->num_instrs);
+	}
+	
+	pp_lir_block_for_each_instr(block, instr)
+	{
+		if (!instr->visited)
+			calc_reach(reach, instr);
+	}
+	
+	return true;
+}
+
+void lima_pp_lir_reach_delete(lima_pp_lir_reach_t* reach)
+{
+	unsigned i;
+	for (i = 0; i < reach->num_instrs; i++)
+		bitset_delete(reach->reach[i]);
+	free(reach->reach);
+}
+
+/* An edge A -> B is redundant if B can be reached from some other successor
+ * of A, so we take everything A's successors can reach and remove it from
+ * A's min_succs. min_succs is always a subset of succs, so it's safe to
+ * iterate over succs while removing from min_succs.
+ */
+
+static void reduce_instr(lima_pp_lir_reach_t* reach,
+						 lima_pp_lir_scheduled_instr_t* instr,
+						 bitset_t* below)
+{
+	memset(below->bits, 0, below->size * sizeof(uint32_t));
 	
-	ptrset_iter_t iter = ptrset_iter_create(cur_instr->succs);
-	lima_pp_lir_scheduled_instr_t* child;
-	ptrset_iter_for_each(iter, child)
+	ptrset_iter_t iter = ptrset_iter_create(instr->succs);
+	lima_pp_lir_scheduled_instr_t* succ;
+	ptrset_iter_for_each(iter, succ)
 	{
-		remove_true_dep(start_instr, child);
-		remove_edges(start_instr, child);
+		bitset_union(below, reach->reach[succ->reach_index]);
 	}
 	
-	cur_instr->visited = true;
+	iter = ptrset_iter_create(instr->succs);
+	ptrset_iter_for_each(iter, succ)
+	{
+		if (bitset_get(*below, succ->reach_index))
+			remove_min_dep(instr, succ);
+	}
+}
+
+void lima_pp_lir_reach_reduce(lima_pp_lir_reach_t* reach,
+							  lima_pp_lir_scheduled_instr_t* instr)
+{
+	bitset_t below = bitset_create(reach->num_instrs);
+	reduce_instr(reach, instr, &below);
+	bitset_delete(below);
 }
 
 /* Calculates the transitive reduction of the dataflow graph, which contains
@@ -340,22 +419,23 @@ static void remove_edges(lima_pp_lir_scheduled_instr_t* start_instr,
 
 void lima_pp_lir_calc_min_dep_info(lima_pp_lir_block_t* block)
 {
+	if (block->num_instrs == 0)
+		return;
+	
+	lima_pp_lir_reach_t reach;
+	if (!lima_pp_lir_reach_create(&reach, block))
+		return;
+	
+	bitset_t below = bitset_create(block->num_instrs);
+	
 	lima_pp_lir_scheduled_instr_t* instr;
 	pp_lir_block_for_each_instr(block, instr)
 	{
-		lima_pp_lir_scheduled_instr_t* temp;
-		pp_lir_block_for_each_instr(block, temp)
-		{
-			temp->visited = false;
-		}
-		
-		ptrset_iter_t iter = ptrset_iter_create(instr->succs);
-		lima_pp_lir_scheduled_instr_t* succ;
-		ptrset_iter_for_each(iter, succ)
-		{
-			remove_edges(instr, succ);
-		}
+		reduce_instr(&reach, instr, &below);
 	}
+	
+	bitset_delete(below);
+	lima_pp_lir_reach_delete(&reach);
 }
 
 static void calc_dep_info_block(lima_pp_lir_block_t* block)
@@ -27,75 +27,65 @@
 #include <string.h>
 
 
-lima_pp_lir_instr_t* lima_pp_lir_instr_create(void)
+lima_pp_lir_instr_t* lima_pp_lir_instr_create(lima_pp_lir_prog_t* prog)
 {
-	return calloc(sizeof(lima_pp_lir_instr_t), 1);
+	lima_pp_lir_instr_t* instr =
+		arena_calloc(prog->arena, sizeof(lima_pp_lir_instr_t));
+	if (!instr)
+		return NULL;
+	
+	instr->prog = prog;
+	return instr;
 }
 
 void lima_pp_lir_instr_delete(lima_pp_lir_instr_t *instr)
 {
-	free(instr);
+	arena_free(instr->prog->arena, instr, sizeof(lima_pp_lir_instr_t));
 }
 
-lima_pp_lir_scheduled_instr_t* lima_pp_lir_scheduled_instr_create(void)
+lima_pp_lir_scheduled_instr_t* lima_pp_lir_scheduled_instr_create(
+	lima_pp_lir_prog_t* prog)
 {
 	lima_pp_lir_scheduled_instr_t* instr =
-		calloc(sizeof(lima_pp_lir_scheduled_instr_t), 1);
+		arena_calloc(prog->arena, sizeof(lima_pp_lir_scheduled_instr_t));
 	if (!instr)
 		return NULL;
 	
-	if (!ptrset_create(&instr->preds))
-	{
-		free(instr);
-		return NULL;
-	}
+	instr->prog = prog;
 	
-	if (!ptrset_create(&instr->succs))
-	{
-		ptrset_delete(instr->preds);
-		free(instr);
-		return NULL;
-	}
+	if (!ptrset_create_arena(&instr->preds, prog->arena))
+		goto err_preds;
 	
-	if (!ptrset_create(&instr->min_preds))
-	{
-		ptrset_delete(instr->preds);
-		ptrset_delete(instr->succs);
-		free(instr);
-		return NULL;
-	}
+	if (!ptrset_create_arena(&instr->succs, prog->arena))
+		goto err_succs;
 	
-	if (!ptrset_create(&instr->min_succs))
-	{
-		ptrset_delete(instr->preds);
-		ptrset_delete(instr->succs);
-		ptrset_delete(instr->min_preds);
-		free(instr);
-		return NULL;
-	}
+	if (!ptrset_create_arena(&instr->min_preds, prog->arena))
+		goto err_min_preds;
 	
-	if (!ptrset_create(&instr->true_preds))
-	{
-		ptrset_delete(instr->preds);
-		ptrset_delete(instr->succs);
-		ptrset_delete(instr->min_preds);
-		ptrset_delete(instr->min_succs);
-		free(instr);
-		return NULL;
-	}
+	if (!ptrset_create_arena(&instr->min_succs, prog->arena))
+		goto err_min_succs;
 	
-	if (!ptrset_create(&instr->true_succs))
-	{
-		ptrset_delete(instr->preds);
-		ptrset_delete(instr->succs);
-		ptrset_delete(instr->min_preds);
-		ptrset_delete(instr->min_succs);
-		ptrset_delete(instr->true_preds);
-		free(instr);
-		return NULL;
-	}
+	if (!ptrset_create_arena(&instr->true_preds, prog->arena))
+		goto err_true_preds;
+	
+	if (!ptrset_create_arena(&instr->true_succs, prog->arena))
+		goto err_true_succs;
 	
 	return instr;
+	
+err_true_succs:
+	ptrset_delete(instr->true_preds);
+err_true_preds:
+	ptrset_delete(instr->min_succs);
+err_min_succs:
+	ptrset_delete(instr->min_preds);
+err_min_preds:
+	ptrset_delete(instr->succs);
+err_succs:
+	ptrset_delete(instr->preds);
+err_preds:
+	arena_free(prog->arena, instr, sizeof(lima_pp_lir_scheduled_instr_t));
+	return NULL;
 }
 
 void lima_pp_lir_scheduled_instr_delete(lima_pp_lir_scheduled_instr_t *instr)
@@ -122,7 +112,8 @@ void lima_pp_lir_scheduled_instr_delete(lima_pp_lir_scheduled_instr_t *instr)
 	ptrset_delete(instr->true_preds);
 	ptrset_delete(instr->true_succs);
 	
-	free(instr);
+	arena_free(instr->prog->arena, instr,
+			   sizeof(lima_pp_lir_scheduled_instr_t));
 }
 
 typedef struct
@@ -413,7 +404,7 @@ lima_pp_lir_instr_t* lima_pp_lir_instr_import(
 	_instr_header_t* header = data;
 	data = header + 1;
 	
-	lima_pp_lir_instr_t* instr = lima_pp_lir_instr_create();
+	lima_pp_lir_instr_t* instr = lima_pp_lir_instr_create(prog);
 	if (!instr)
 		return NULL;
 	
@@ -672,7 +663,8 @@ lima_pp_lir_scheduled_instr_t* lima_pp_lir_scheduled_instr_import(
 	data = header + 1;
 	*len = sizeof(*header);
 	
-	lima_pp_lir_scheduled_instr_t* instr = lima_pp_lir_scheduled_instr_create();
+	lima_pp_lir_scheduled_instr_t* instr =
+		lima_pp_lir_scheduled_instr_create(prog);
 	if (!instr)
 		return NULL;
 	
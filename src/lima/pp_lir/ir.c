@@ -38,12 +38,12 @@
 	if (!lima_pp_lir_peephole(prog->prog))
 		return NULL;
 	
-	lima_pp_lir_prog_print(prog->prog, false);
+	lima_pp_lir_prog_print(prog->prog, false, stdout);
 	
 	if (!lima_pp_lir_reg_pressure_schedule_prog(prog->prog))
 		return NULL;
 	
-	lima_pp_lir_prog_print(prog->prog, false);
+	lima_pp_lir_prog_print(prog->prog, false, stdout);
 	
 	lima_pp_lir_delete_dep_info(prog->prog);
 	
@@ -52,12 +52,12 @@
 	
 	lima_pp_lir_calc_dep_info(prog->prog);
 	
-	lima_pp_lir_prog_print(prog->prog, false);
+	lima_pp_lir_prog_print(prog->prog, false, stdout);
 	
 	if (!lima_pp_lir_combine_schedule_prog(prog->prog))
 		return NULL;
 	
-	lima_pp_lir_prog_print(prog->prog, false);
+	lima_pp_lir_prog_print(prog->prog, false, stdout);
 	
 	lima_pp_lir_delete_dep_info(prog->prog);
 	
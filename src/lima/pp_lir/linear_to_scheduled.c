@@ -120,7 +120,8 @@ static bool is_combine(lima_pp_lir_instr_t* instr)
 lima_pp_lir_scheduled_instr_t* lima_pp_lir_instr_to_sched_instr(
 	lima_pp_lir_instr_t* instr)
 {
-	lima_pp_lir_scheduled_instr_t* ret = lima_pp_lir_scheduled_instr_create();
+	lima_pp_lir_scheduled_instr_t* ret =
+		lima_pp_lir_scheduled_instr_create(instr->prog);
 	if (!ret)
 		return NULL;
 	
@@ -273,7 +274,7 @@ lima_pp_lir_scheduled_instr_t* lima_pp_lir_instr_to_sched_instr(
 			
 		case lima_pp_hir_op_select:
 		{
-			lima_pp_lir_instr_t* new_instr = lima_pp_lir_instr_create();
+			lima_pp_lir_instr_t* new_instr = lima_pp_lir_instr_create(instr->prog);
 			if (!new_instr)
 				return NULL;
 			
@@ -358,7 +359,7 @@ lima_pp_lir_scheduled_instr_t* lima_pp_lir_instr_to_sched_instr(
 		case lima_pp_hir_op_loadt_four:
 		case lima_pp_hir_op_loadt_four_off:
 		{
-			lima_pp_lir_instr_t* new_instr = lima_pp_lir_instr_create();
+			lima_pp_lir_instr_t* new_instr = lima_pp_lir_instr_create(instr->prog);
 			if (!new_instr)
 				return NULL;
 			
@@ -436,7 +437,7 @@ lima_pp_lir_scheduled_instr_t* lima_pp_lir_instr_to_sched_instr(
 		case lima_pp_hir_op_texld_cube_lod:
 		case lima_pp_hir_op_texld_cube_off_lod:
 		{
-			lima_pp_lir_instr_t* coord_instr = lima_pp_lir_instr_create();
+			lima_pp_lir_instr_t* coord_instr = lima_pp_lir_instr_create(instr->prog);
 			if (!coord_instr)
 				return NULL;
 			
@@ -470,7 +471,7 @@ lima_pp_lir_scheduled_instr_t* lima_pp_lir_instr_to_sched_instr(
 			//doesn't matter which one
 			instr->sources[0].pipeline_reg = lima_pp_lir_pipeline_reg_discard;
 			
-			lima_pp_lir_instr_t* new_instr = lima_pp_lir_instr_create();
+			lima_pp_lir_instr_t* new_instr = lima_pp_lir_instr_create(instr->prog);
 			
 			if (!new_instr)
 				return false;
@@ -30,8 +30,8 @@
 
 static void liveness_init_instr(lima_pp_lir_instr_t* instr, unsigned size)
 {
-	instr->live_in = bitset_create(size);
-	instr->live_out = bitset_create(size);
+	instr->live_in = bitset_create_arena(size, instr->prog->arena);
+	instr->live_out = bitset_create_arena(size, instr->prog->arena);
 }
 
 static void liveness_init_sched_instr(lima_pp_lir_scheduled_instr_t* instr,
@@ -58,8 +58,8 @@ static void liveness_init_sched_instr(lima_pp_lir_scheduled_instr_t* instr,
 	if (instr->branch_instr)
 		liveness_init_instr(instr->branch_instr, size);
 	
-	instr->live_in = bitset_create(size);
-	instr->live_out = bitset_create(size);
+	instr->live_in = bitset_create_arena(size, instr->prog->arena);
+	instr->live_out = bitset_create_arena(size, instr->prog->arena);
 }
 
 bool lima_pp_lir_liveness_init(lima_pp_lir_prog_t* prog)
@@ -156,7 +156,7 @@ static void remove_instr(lima_pp_lir_scheduled_instr_t* instr)
 
 static lima_pp_lir_instr_t* copy_uniform_instr(lima_pp_lir_instr_t* orig)
 {
-	lima_pp_lir_instr_t* new = lima_pp_lir_instr_create();
+	lima_pp_lir_instr_t* new = lima_pp_lir_instr_create(orig->prog);
 	if (!new)
 		return NULL;
 	
@@ -329,7 +329,7 @@ static bool peephole_uniform(lima_pp_lir_scheduled_instr_t* instr)
 
 static lima_pp_lir_instr_t* copy_varying_instr(lima_pp_lir_instr_t* instr)
 {
-	lima_pp_lir_instr_t* ret = lima_pp_lir_instr_create();
+	lima_pp_lir_instr_t* ret = lima_pp_lir_instr_create(instr->prog);
 	if (!ret)
 		return NULL;
 	
@@ -647,7 +647,7 @@ static bool peephole_varying(lima_pp_lir_scheduled_instr_t* instr,
 			if (use->varying_instr)
 			{
 				lima_pp_lir_scheduled_instr_t* new_def =
-					lima_pp_lir_scheduled_instr_create();
+					lima_pp_lir_scheduled_instr_create(instr->prog);
 				if (!new_def)
 				{
 					lima_pp_lir_instr_delete(varying_instr);
@@ -1122,10 +1122,11 @@ static bool peephole_block(lima_pp_lir_block_t* block)
 			if (!peephole_discard_move(instr, &progress))
 				return false;
 			
-			lima_pp_lir_calc_min_dep_info(block);
-			
 			if (progress)
+			{
+				lima_pp_lir_calc_min_dep_info(block);
 				break;
+			}
 		}
 	}
 	
@@ -1138,10 +1139,11 @@ static bool peephole_block(lima_pp_lir_block_t* block)
 			if (!peephole_mul_add(instr, &progress))
 				return false;
 			
-			lima_pp_lir_calc_min_dep_info(block);
-			
 			if (progress)
+			{
+				lima_pp_lir_calc_min_dep_info(block);
 				break;
+			}
 		}
 	}
 	
@@ -1163,10 +1165,11 @@ static bool peephole_block(lima_pp_lir_block_t* block)
 			if (!peephole_varying(instr, &progress))
 				return false;
 			
-			lima_pp_lir_calc_min_dep_info(block);
-			
 			if (progress)
+			{
+				lima_pp_lir_calc_min_dep_info(block);
 				break;
+			}
 		}
 	}
 	
@@ -33,6 +33,8 @@ extern "C" {
 #include "bitset.h"
 #include "ptrset.h"
 #include "ptr_vector.h"
+#include "list_scheduler.h"
+#include "shader.h"
 
 
 /*
@@ -143,6 +145,8 @@ typedef struct {
 } lima_pp_lir_dest_t;
 
 typedef struct lima_pp_lir_instr_s {
+	struct lima_pp_lir_prog_s* prog;
+	
 	lima_pp_hir_op_e op;
 	lima_pp_lir_source_t sources[3];
 	lima_pp_lir_dest_t dest;
@@ -170,6 +174,7 @@ typedef enum
 typedef struct lima_pp_lir_scheduled_instr_s {
 	struct list instr_list;
 	
+	struct lima_pp_lir_prog_s* prog;
 	struct lima_pp_lir_block_s* block;
 	
 	lima_pp_lir_instr_t* varying_instr;
@@ -213,6 +218,12 @@ typedef struct lima_pp_lir_scheduled_instr_s {
 	/* estimated register pressure */
 	unsigned reg_pressure;
 	
+	/* which bit stands for this instruction in a lima_pp_lir_reach_t */
+	unsigned reach_index;
+	
+	/* successors left to schedule */
+	list_sched_node_t sched_node;
+	
 	bool visited;
 } lima_pp_lir_scheduled_instr_t;
 
@@ -241,6 +252,13 @@ typedef struct lima_pp_lir_prog_s {
 	unsigned reg_alloc, temp_alloc;
 	unsigned num_regs;
 	lima_pp_lir_reg_t** regs;
+	
+	unsigned spill_iterations; /* times regalloc had to spill and start over */
+	
+	/* instructions, their dependency sets, and liveness info are allocated
+	 * here, so that deleting the program doesn't have to walk them
+	 */
+	arena_t* arena;
 } lima_pp_lir_prog_t;
 
 lima_pp_lir_prog_t* lima_pp_lir_convert(lima_pp_hir_prog_t* prog);
@@ -259,6 +277,10 @@ lima_pp_lir_reg_t* lima_pp_lir_prog_find_reg(
 
 lima_pp_lir_block_t* lima_pp_lir_block_create(void);
 void lima_pp_lir_block_delete(lima_pp_lir_block_t* block);
+/* frees the block without deleting its instructions, which must instead be
+ * freed along with the program's arena
+ */
+void lima_pp_lir_block_delete_shallow(lima_pp_lir_block_t* block);
 void* lima_pp_lir_block_export(lima_pp_lir_block_t* block, unsigned* size);
 lima_pp_lir_block_t* lima_pp_lir_block_import(
 	void* data, unsigned* len, lima_pp_lir_prog_t* prog);
@@ -297,13 +319,14 @@ lima_pp_lir_reg_t* lima_pp_lir_reg_create(void);
 void lima_pp_lir_reg_delete(lima_pp_lir_reg_t* reg);
 
 
-lima_pp_lir_instr_t* lima_pp_lir_instr_create(void);
+lima_pp_lir_instr_t* lima_pp_lir_instr_create(lima_pp_lir_prog_t* prog);
 void lima_pp_lir_instr_delete(lima_pp_lir_instr_t* instr);
 void* lima_pp_lir_instr_export(lima_pp_lir_instr_t* instr, unsigned* size);
 lima_pp_lir_instr_t* lima_pp_lir_instr_import(
 	void* data, unsigned* len, lima_pp_lir_prog_t* prog);
 
-lima_pp_lir_scheduled_instr_t* lima_pp_lir_scheduled_instr_create(void);
+lima_pp_lir_scheduled_instr_t* lima_pp_lir_scheduled_instr_create(
+	lima_pp_lir_prog_t* prog);
 void lima_pp_lir_scheduled_instr_delete(lima_pp_lir_scheduled_instr_t* instr);
 void* lima_pp_lir_scheduled_instr_export(
 	lima_pp_lir_scheduled_instr_t* instr, unsigned* size);
@@ -323,22 +346,52 @@ void lima_pp_lir_liveness_calc_prog(lima_pp_lir_prog_t* prog);
 
 bool lima_pp_lir_instr_print(
 	lima_pp_lir_instr_t* instr,
-	bool print_live_vars, unsigned tabs);
+	bool print_live_vars, unsigned tabs, FILE* f);
 bool lima_pp_lir_block_print(
 	lima_pp_lir_block_t* block,
-	bool print_live_vars);
+	bool print_live_vars, FILE* f);
 bool lima_pp_lir_prog_print(
-	lima_pp_lir_prog_t* prog, bool print_live_vars);
+	lima_pp_lir_prog_t* prog, bool print_live_vars, FILE* f);
 
 bool lima_pp_lir_instr_can_swap(
 	lima_pp_lir_instr_t* before, lima_pp_lir_instr_t* after);
 
 bool lima_pp_lir_regalloc(lima_pp_lir_prog_t* prog);
+bool lima_pp_lir_regalloc_linear_scan(lima_pp_lir_prog_t* prog);
 
 void lima_pp_lir_calc_dep_info(lima_pp_lir_prog_t* prog);
 void lima_pp_lir_calc_min_dep_info(lima_pp_lir_block_t* block);
 void lima_pp_lir_delete_dep_info(lima_pp_lir_prog_t* prog);
 
+/* Which instructions each instruction in a block can reach by following
+ * succs, as one bitset per instruction. It's a snapshot of the dependency
+ * graph, so it has to be recreated after instructions are merged, added, or
+ * removed. This is what lima_pp_lir_calc_min_dep_info() uses, and it's here
+ * for passes that merge instructions and need to know whether a merge would
+ * create a cycle, or to reduce only the instructions they touched.
+ */
+
+typedef struct {
+	unsigned num_instrs;
+	bitset_t* reach; /* indexed by reach_index */
+} lima_pp_lir_reach_t;
+
+bool lima_pp_lir_reach_create(lima_pp_lir_reach_t* reach,
+							  lima_pp_lir_block_t* block);
+void lima_pp_lir_reach_delete(lima_pp_lir_reach_t* reach);
+
+/* is there a path from before to after? */
+static inline bool lima_pp_lir_reaches(lima_pp_lir_reach_t* reach,
+									   lima_pp_lir_scheduled_instr_t* before,
+									   lima_pp_lir_scheduled_instr_t* after)
+{
+	return bitset_get(reach->reach[before->reach_index], after->reach_index);
+}
+
+/* removes the edges from instr's min_succs that are implied by other paths */
+void lima_pp_lir_reach_reduce(lima_pp_lir_reach_t* reach,
+							  lima_pp_lir_scheduled_instr_t* instr);
+
 bool lima_pp_lir_peephole(lima_pp_lir_prog_t* prog);
 
 bool lima_pp_lir_simple_schedule_prog(lima_pp_lir_prog_t* prog);
@@ -361,7 +414,9 @@ bool lima_pp_lir_instr_combine_indep(
 	lima_pp_lir_scheduled_instr_t* instr,
 	lima_pp_lir_scheduled_instr_t* other);
 
-void* lima_pp_lir_codegen(lima_pp_lir_prog_t* prog, unsigned* code_size);
+/* also fills in report, see lima_shader_report_t */
+void* lima_pp_lir_codegen(lima_pp_lir_prog_t* prog, unsigned* code_size,
+						  lima_shader_report_t* report);
 //Returns the number of channels possibly used for an argument
 static inline unsigned lima_pp_lir_arg_size(lima_pp_lir_instr_t* instr, unsigned arg)
 {
@@ -25,58 +25,58 @@
 #include "pp_lir.h"
 #include <stdio.h>
 
-static void print_reg(lima_pp_lir_reg_t* reg)
+static void print_reg(lima_pp_lir_reg_t* reg, FILE* f)
 {
 	if (reg->precolored)
-		printf("$%u", reg->index);
+		fprintf(f, "$%u", reg->index);
 	else
-		printf("%%%u", reg->index);
+		fprintf(f, "%%%u", reg->index);
 }
 
-static void print_tabs(unsigned num_tabs)
+static void print_tabs(unsigned num_tabs, FILE* f)
 {
 	unsigned i;
 	for (i = 0; i < num_tabs; i++)
-		printf("\t");
+		fprintf(f, "\t");
 }
 
-static void print_pipeline_reg(lima_pp_lir_pipeline_reg_e reg)
+static void print_pipeline_reg(lima_pp_lir_pipeline_reg_e reg, FILE* f)
 {
 	switch(reg)
 	{
 		case lima_pp_lir_pipeline_reg_const0:
-			printf("^const0");
+			fprintf(f, "^const0");
 			break;
 		case lima_pp_lir_pipeline_reg_const1:
-			printf("^const1");
+			fprintf(f, "^const1");
 			break;
 		case lima_pp_lir_pipeline_reg_sampler:
-			printf("^sampler");
+			fprintf(f, "^sampler");
 			break;
 		case lima_pp_lir_pipeline_reg_uniform:
-			printf("^uniform");
+			fprintf(f, "^uniform");
 			break;
 		case lima_pp_lir_pipeline_reg_vmul:
-			printf("^vmul");
+			fprintf(f, "^vmul");
 			break;
 		case lima_pp_lir_pipeline_reg_fmul:
-			printf("^fmul");
+			fprintf(f, "^fmul");
 			break;
 		case lima_pp_lir_pipeline_reg_discard:
-			printf("^discard");
+			fprintf(f, "^discard");
 			break;
 		default:
-			printf("unknown pipeline register %u", (unsigned) reg);
+			fprintf(f, "unknown pipeline register %u", (unsigned) reg);
 	}
 }
 
-static void print_live_vars(bitset_t live_regs)
+static void print_live_vars(bitset_t live_regs, FILE* f)
 {
 	static char* c = "xyzw";
 	unsigned i, j;
 	bool first = true;
 	
-	printf("{");
+	fprintf(f, "{");
 	
 	for (i = 0; i < (live_regs.size * 8) - 1; i++)
 	{
@@ -86,11 +86,11 @@ static void print_live_vars(bitset_t live_regs)
 			bitset_get(live_regs, 4*(i + 1) + 3))
 		{
 			if (!first)
-				printf(", ");
-			printf("%%%u.", i);
+				fprintf(f, ", ");
+			fprintf(f, "%%%u.", i);
 			for (j = 0; j < 4; j++)
 				if (bitset_get(live_regs, 4*(i + 1) + j))
-					printf("%c", c[j]);
+					fprintf(f, "%c", c[j]);
 			first = false;
 		}
 	}
@@ -101,19 +101,19 @@ static void print_live_vars(bitset_t live_regs)
 		bitset_get(live_regs, 3))
 	{
 		if (!first)
-			printf(", ");
-		printf("$0.");
+			fprintf(f, ", ");
+		fprintf(f, "$0.");
 		for (j = 0; j < 4; j++)
 			if (bitset_get(live_regs, j))
-				printf("%c", c[j]);
+				fprintf(f, "%c", c[j]);
 		first = false;
 	}
 	
-	printf("}\n");
+	fprintf(f, "}\n");
 }
 
 
-static bool print_dest(lima_pp_lir_dest_t* dest, lima_pp_hir_op_e op)
+static bool print_dest(lima_pp_lir_dest_t* dest, lima_pp_hir_op_e op, FILE* f)
 {
 
 	if (!dest->pipeline)
@@ -121,13 +121,13 @@ static bool print_dest(lima_pp_lir_dest_t* dest, lima_pp_hir_op_e op)
 		switch (dest->reg->size)
 		{
 			case 1:
-				printf("float");
+				fprintf(f, "float");
 				break;
 		
 			case 2:
 			case 3:
 			case 4:
-				printf("vec%u", dest->reg->size);
+				fprintf(f, "vec%u", dest->reg->size);
 				break;
 			default:
 				fprintf(stderr, "Error: unknown destination register size %u\n", 
@@ -140,13 +140,13 @@ static bool print_dest(lima_pp_lir_dest_t* dest, lima_pp_hir_op_e op)
 		case lima_pp_outmod_none:
 			break;
 		case lima_pp_outmod_clamp_fraction:
-			printf(" sat");
+			fprintf(f, " sat");
 			break;
 		case lima_pp_outmod_clamp_positive:
-			printf(" pos");
+			fprintf(f, " pos");
 			break;
 		case lima_pp_outmod_round:
-			printf(" int");
+			fprintf(f, " int");
 			break;
 		default:
 			fprintf(stderr, "Error: unknown output modifier %u\n", 
@@ -154,104 +154,104 @@ static bool print_dest(lima_pp_lir_dest_t* dest, lima_pp_hir_op_e op)
 			return false;
 	}
 	
-	printf(" ");
+	fprintf(f, " ");
 	if (dest->pipeline)
-		print_pipeline_reg(dest->pipeline_reg);
+		print_pipeline_reg(dest->pipeline_reg, f);
 	else
-		print_reg(dest->reg);
+		print_reg(dest->reg, f);
 
-	printf(".");
+	fprintf(f, ".");
 	static char* c = "xyzw";
 	
 	unsigned i;
 	for (i = 0; i < 4; i++)
 		if (dest->mask[i])
-			printf("%c", c[i]);
+			fprintf(f, "%c", c[i]);
 	
-	printf(" = ");
+	fprintf(f, " = ");
 	
 	return true;
 }
 
-static void print_source(lima_pp_lir_source_t* source)
+static void print_source(lima_pp_lir_source_t* source, FILE* f)
 {
 	if (source->negate)
-		printf("-");
+		fprintf(f, "-");
 	if (source->absolute)
-		printf("abs(");
+		fprintf(f, "abs(");
 	
 	if(source->constant)
 	{
-		printf("(");
+		fprintf(f, "(");
 		bool first = true;
 		double *constant = source->reg;
 		unsigned i;
 		for (i = 0; i < 4; i++)
 		{
 			if (!first)
-				printf(", ");
-			printf("%lf", constant[i]);
+				fprintf(f, ", ");
+			fprintf(f, "%lf", constant[i]);
 			first = false;
 		}
-		printf(")");
+		fprintf(f, ")");
 	}
 	else
 	{
 		if (source->pipeline)
-			print_pipeline_reg(source->pipeline_reg);
+			print_pipeline_reg(source->pipeline_reg, f);
 		else
-			print_reg(source->reg);
-		printf(".");
+			print_reg(source->reg, f);
+		fprintf(f, ".");
 		unsigned i;
 		const char* c = "xyzw";
 		for (i = 0; i < 4; i++)
 		{
-			printf("%c", c[source->swizzle[i]]);
+			fprintf(f, "%c", c[source->swizzle[i]]);
 		}
 	}
 	
 	if (source->absolute)
-		printf(")");
+		fprintf(f, ")");
 }
 
-bool lima_pp_lir_instr_print(lima_pp_lir_instr_t* instr, bool live_vars, unsigned tabs)
+bool lima_pp_lir_instr_print(lima_pp_lir_instr_t* instr, bool live_vars, unsigned tabs, FILE* f)
 {
 	unsigned i;
 	
 	if (live_vars)
 	{
-			print_tabs(tabs);
-			print_live_vars(instr->live_in);
+			print_tabs(tabs, f);
+			print_live_vars(instr->live_in, f);
 	}
 	
-	print_tabs(tabs);
+	print_tabs(tabs, f);
 	
 	if (lima_pp_hir_op[instr->op].has_dest
-		&& !print_dest(&instr->dest, instr->op))
+		&& !print_dest(&instr->dest, instr->op, f))
 			return false;
 	
-	printf("%s ", lima_pp_hir_op[instr->op].name);
+	fprintf(f, "%s ", lima_pp_hir_op[instr->op].name);
 	
 	if (lima_pp_hir_op_is_load_store(instr->op))
 	{
-		printf("%u", instr->load_store_index);
+		fprintf(f, "%u", instr->load_store_index);
 		if (lima_pp_hir_op_is_store(instr->op))
 		{
 			if (lima_pp_hir_op[instr->op].args == 2)
 			{
-				printf(" + ");
-				print_source(&instr->sources[0]);
+				fprintf(f, " + ");
+				print_source(&instr->sources[0], f);
 			}
-			printf(" = ");
+			fprintf(f, " = ");
 		}
 		else if(lima_pp_hir_op[instr->op].args)
-			printf(", ");
+			fprintf(f, ", ");
 	}
 	
 	if (lima_pp_hir_op_is_store(instr->op) &&
 		lima_pp_hir_op[instr->op].args == 2)
 	{
-		print_source(&instr->sources[1]);
+		print_source(&instr->sources[1], f);
 	}
 	else
 	{
@@ -259,138 +259,138 @@ bool lima_pp_lir_instr_print(lima_pp_lir_instr_t* instr, bool live_vars, unsigne
 		for (i = 0; i < lima_pp_hir_op[instr->op].args; i++)
 		{
 			if (!first)
-				printf(", ");
-			print_source(&instr->sources[i]);
+				fprintf(f, ", ");
+			print_source(&instr->sources[i], f);
 			first = false;
 		}
 		
 		if (instr->op == lima_pp_hir_op_mul && instr->shift != 0)
 		{
-			printf(" << %d", instr->shift);
+			fprintf(f, " << %d", instr->shift);
 		}
 	}
 	
 	if (lima_pp_hir_op_is_branch(instr->op))
 	{
 		if (instr->op != lima_pp_hir_op_branch)
-			printf(", ");
-		printf("%u", instr->branch_dest);
+			fprintf(f, ", ");
+		fprintf(f, "%u", instr->branch_dest);
 	}
 	
-	printf(";\n");
+	fprintf(f, ";\n");
 
 	if (live_vars)
 	{
-		print_tabs(tabs);
-		print_live_vars(instr->live_out);
+		print_tabs(tabs, f);
+		print_live_vars(instr->live_out, f);
 	}
 
 	return true;
 }
 
-static void print_instr_set(ptrset_t set)
+static void print_instr_set(ptrset_t set, FILE* f)
 {
 	ptrset_iter_t iter = ptrset_iter_create(set);
 	lima_pp_lir_scheduled_instr_t* instr;
 	ptrset_iter_for_each(iter, instr)
 	{
-		printf("%u ", instr->index);
+		fprintf(f, "%u ", instr->index);
 	}
 }
 
-bool lima_pp_lir_scheduled_instr_print(lima_pp_lir_scheduled_instr_t* instr, bool live_vars)
+bool lima_pp_lir_scheduled_instr_print(lima_pp_lir_scheduled_instr_t* instr, bool live_vars, FILE* f)
 {
 	if (live_vars)
-		print_live_vars(instr->live_in);
+		print_live_vars(instr->live_in, f);
 	
-	printf("//(%u)\n", instr->index);
+	fprintf(f, "//(%u)\n", instr->index);
 	if (ptrset_size(instr->preds))
 	{
-		printf("//preds: ");
-		print_instr_set(instr->preds);
-		printf("\n");
+		fprintf(f, "//preds: ");
+		print_instr_set(instr->preds, f);
+		fprintf(f, "\n");
 	}
 	if (ptrset_size(instr->succs))
 	{
-		printf("//succs: ");
-		print_instr_set(instr->succs);
-		printf("\n");
+		fprintf(f, "//succs: ");
+		print_instr_set(instr->succs, f);
+		fprintf(f, "\n");
 	}
 	if (ptrset_size(instr->true_preds))
 	{
-		printf("//true preds: ");
-		print_instr_set(instr->true_preds);
-		printf("\n");
+		fprintf(f, "//true preds: ");
+		print_instr_set(instr->true_preds, f);
+		fprintf(f, "\n");
 	}
 	if (ptrset_size(instr->true_succs))
 	{
-		printf("//true succs: ");
-		print_instr_set(instr->true_succs);
-		printf("\n");
+		fprintf(f, "//true succs: ");
+		print_instr_set(instr->true_succs, f);
+		fprintf(f, "\n");
 	}
 	if (ptrset_size(instr->min_preds))
 	{
-		printf("//min preds: ");
-		print_instr_set(instr->min_preds);
-		printf("\n");
+		fprintf(f, "//min preds: ");
+		print_instr_set(instr->min_preds, f);
+		fprintf(f, "\n");
 	}
 	if (ptrset_size(instr->min_succs))
 	{
-		printf("//min succs: ");
-		print_instr_set(instr->min_succs);
-		printf("\n");
+		fprintf(f, "//min succs: ");
+		print_instr_set(instr->min_succs, f);
+		fprintf(f, "\n");
 	}
 
-	printf("{\n");
+	fprintf(f, "{\n");
 	if (instr->const0_size)
 	{
-		printf("\t^const0 = ");
+		fprintf(f, "\t^const0 = ");
 		unsigned i;
 		bool first = true;
 		for (i = 0; i < instr->const0_size; i++)
 		{
 			if (!first)
-				printf(", ");
+				fprintf(f, ", ");
 			else
 				first = false;
 			
-			printf("%lf", instr->const0[i]);
+			fprintf(f, "%lf", instr->const0[i]);
 		}
-		printf(";\n");
+		fprintf(f, ";\n");
 	}
 
 	if (instr->const1_size)
 	{
-		printf("\t^const1 = ");
+		fprintf(f, "\t^const1 = ");
 		unsigned i;
 		bool first = true;
 		for (i = 0; i < instr->const1_size; i++)
 		{
 			if (!first)
-				printf(", ");
+				fprintf(f, ", ");
 			else
 				first = false;
 			
-			printf("%lf", instr->const1[i]);
+			fprintf(f, "%lf", instr->const1[i]);
 		}
-		printf(";\n");
+		fprintf(f, ";\n");
 	}
 
 	if (instr->varying_instr)
 	{
-		if (!lima_pp_lir_instr_print(instr->varying_instr, live_vars, 1))
+		if (!lima_pp_lir_instr_print(instr->varying_instr, live_vars, 1, f))
 			return false;
 	}
 	
 	if (instr->texld_instr)
 	{
-		if (!lima_pp_lir_instr_print(instr->texld_instr, live_vars, 1))
+		if (!lima_pp_lir_instr_print(instr->texld_instr, live_vars, 1, f))
 			return false;
 	}
 	
 	if (instr->uniform_instr)
 	{
-		if (!lima_pp_lir_instr_print(instr->uniform_instr, live_vars, 1))
+		if (!lima_pp_lir_instr_print(instr->uniform_instr, live_vars, 1, f))
 			return false;
 	}
 	
@@ -400,26 +400,26 @@ bool lima_pp_lir_scheduled_instr_print(lima_pp_lir_scheduled_instr_t* instr, boo
 		if (!instr->alu_instrs[i])
 			continue;
 		
-		if (!lima_pp_lir_instr_print(instr->alu_instrs[i], live_vars, 1))
+		if (!lima_pp_lir_instr_print(instr->alu_instrs[i], live_vars, 1, f))
 			return false;
 	}
 	
 	if (instr->temp_store_instr)
 	{
-		if (!lima_pp_lir_instr_print(instr->temp_store_instr, live_vars, 1))
+		if (!lima_pp_lir_instr_print(instr->temp_store_instr, live_vars, 1, f))
 			return false;
 	}
 	
 	if (instr->branch_instr)
 	{
-		if (!lima_pp_lir_instr_print(instr->branch_instr, live_vars, 1))
+		if (!lima_pp_lir_instr_print(instr->branch_instr, live_vars, 1, f))
 			return false;
 	}
 	
-	printf("}\n");
+	fprintf(f, "}\n");
 	
 	if (live_vars)
-		print_live_vars(instr->live_out);
+		print_live_vars(instr->live_out, f);
 	
 	return true;
 }
@@ -434,43 +434,43 @@ static void index_instrs(lima_pp_lir_block_t* block)
 	}
 }
 
-bool lima_pp_lir_block_print(lima_pp_lir_block_t* block, bool live_vars)
+bool lima_pp_lir_block_print(lima_pp_lir_block_t* block, bool live_vars, FILE* f)
 {
 	index_instrs(block);
 	
 	if (live_vars)
-		print_live_vars(block->live_in);
+		print_live_vars(block->live_in, f);
 	
 	lima_pp_lir_scheduled_instr_t* instr;
 	pp_lir_block_for_each_instr(block, instr)
 	{
-		if (!lima_pp_lir_scheduled_instr_print(instr, live_vars))
+		if (!lima_pp_lir_scheduled_instr_print(instr, live_vars, f))
 			return false;
 	}
 	
 	if (live_vars)
-		print_live_vars(block->live_out);
+		print_live_vars(block->live_out, f);
 	
 	if (block->is_end)
 	{
 		if (block->discard)
-			printf("discard;\n");
+			fprintf(f, "discard;\n");
 		else
-			printf("stop;\n");
+			fprintf(f, "stop;\n");
 	}
 
-	printf("\n");
+	fprintf(f, "\n");
 	
 	return true;
 }
 
-bool lima_pp_lir_prog_print(lima_pp_lir_prog_t* prog, bool live_vars)
+bool lima_pp_lir_prog_print(lima_pp_lir_prog_t* prog, bool live_vars, FILE* f)
 {
 	unsigned i;
 	for (i = 0; i < prog->num_blocks; i++)
 	{
-		printf("%u:\n", i);
-		if (!lima_pp_lir_block_print(prog->blocks[i], live_vars))
+		fprintf(f, "%u:\n", i);
+		if (!lima_pp_lir_block_print(prog->blocks[i], live_vars, f))
 			return false;
 	}
 	return true;
@@ -29,20 +29,35 @@
 
 lima_pp_lir_prog_t *lima_pp_lir_prog_create(void)
 {
-	 return calloc(sizeof(lima_pp_lir_prog_t), 1);
+	lima_pp_lir_prog_t* prog = calloc(sizeof(lima_pp_lir_prog_t), 1);
+	if (!prog)
+		return NULL;
+	
+	prog->arena = arena_create();
+	if (!prog->arena)
+	{
+		free(prog);
+		return NULL;
+	}
+	
+	return prog;
 }
 
 void lima_pp_lir_prog_delete(lima_pp_lir_prog_t* prog)
 {
+	/* the instructions all live in the arena, so only the blocks themselves
+	 * need to be freed here
+	 */
 	unsigned i;
 	for (i = 0; i < prog->num_blocks; i++)
 		if (prog->blocks[i])
-			lima_pp_lir_block_delete(prog->blocks[i]);
+			lima_pp_lir_block_delete_shallow(prog->blocks[i]);
 	free(prog->blocks);
 	for (i = 0; i < prog->num_regs; i++)
 		if (prog->regs[i])
 			lima_pp_lir_reg_delete(prog->regs[i]);
 	free(prog->regs);
+	arena_delete(prog->arena);
 	free(prog);
 }
 
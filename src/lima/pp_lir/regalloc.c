@@ -24,6 +24,9 @@
 
 #include "regalloc.h"
 #include "fixed_queue.h"
+#include "trace.h"
+#include <stdlib.h>
+#include <limits.h>
 #include <math.h>
 #include <assert.h>
 
@@ -96,32 +99,237 @@ static unsigned get_index(lima_pp_lir_reg_t* reg)
 	return reg->index + 1;
 }
 
-static void add_edge(lima_pp_lir_reg_t* reg1, lima_pp_lir_reg_t* reg2,
-					 unsigned reg1_components, unsigned reg2_components,
-					 bitset_t matrix, unsigned num_regs)
+static bool is_move(lima_pp_lir_instr_t* instr)
 {
-	if (reg1 == reg2)
-		return;
+	if (instr->op != lima_pp_hir_op_mov)
+		return false;
+	
+	if (instr->dest.pipeline || instr->sources[0].pipeline)
+		return false;
+	
+	if (instr->dest.modifier != lima_pp_outmod_none)
+		return false;
+	
+	if (instr->sources[0].absolute || instr->sources[0].negate)
+		return false;
+	
+	return true;
+}
+
+/*
+ * The interference graph. Rather than a matrix with a bit for every pair of
+ * registers (or every pair of register components), which grows with the
+ * square of the number of registers, the edges are kept in a hash table keyed
+ * by the pair of register indices, and the graph is walked using the adjacent
+ * list in each register. For pairs where both registers are move-related, the
+ * edge also records which components of the two registers interfere, since
+ * that's what coalescing needs to pick a swizzle; no other pair ever gets
+ * coalesced, so for the rest only the edge itself is kept.
+ */
+
+typedef struct
+{
+	uint64_t key; //0 for an empty slot
+	
+	//bit 4*i + j is set if component i of the register with the lower index
+	//interferes with component j of the other one
+	uint16_t components;
+} edge_t;
+
+typedef struct
+{
+	edge_t* edges;
+	unsigned num_edges, table_size; //table_size is a power of two
+	
+	//indexed by get_index()
+	unsigned num_regs;
+	lima_pp_lir_reg_t** regs;
+	bool* move_related;
+} int_graph_t;
+
+#define INITIAL_TABLE_SIZE 64
+
+static uint64_t edge_key(unsigned index1, unsigned index2)
+{
+	if (index1 > index2)
+	{
+		unsigned temp = index1;
+		index1 = index2;
+		index2 = temp;
+	}
+	
+	return (((uint64_t) index1 << 32) | index2) + 1;
+}
+
+static unsigned component_bit(unsigned index1, unsigned index2,
+							  unsigned component1, unsigned component2)
+{
+	if (index1 <= index2)
+		return 4*component1 + component2;
+	return 4*component2 + component1;
+}
+
+static edge_t* find_edge_key(int_graph_t* graph, uint64_t key)
+{
+	unsigned mask = graph->table_size - 1;
+	uint64_t hash = key * 0x9E3779B97F4A7C15ull;
+	unsigned i = (unsigned) (hash ^ (hash >> 32)) & mask;
+	while (graph->edges[i].key != 0 && graph->edges[i].key != key)
+		i = (i + 1) & mask;
+	
+	return &graph->edges[i];
+}
+
+//Returns the edge between the two registers, or NULL if they don't interfere
+static edge_t* find_edge(int_graph_t* graph, lima_pp_lir_reg_t* reg1,
+						 lima_pp_lir_reg_t* reg2)
+{
+	edge_t* edge = find_edge_key(graph,
+								 edge_key(get_index(reg1), get_index(reg2)));
+	return edge->key ? edge : NULL;
+}
+
+static bool int_graph_grow(int_graph_t* graph)
+{
+	edge_t* old_edges = graph->edges;
+	unsigned old_size = graph->table_size;
+	
+	graph->edges = calloc(2 * old_size, sizeof(edge_t));
+	if (!graph->edges)
+	{
+		graph->edges = old_edges;
+		return false;
+	}
+	
+	graph->table_size = 2 * old_size;
+	
+	unsigned i;
+	for (i = 0; i < old_size; i++)
+		if (old_edges[i].key)
+			*find_edge_key(graph, old_edges[i].key) = old_edges[i];
+	
+	free(old_edges);
+	return true;
+}
+
+//Adds an edge with no interfering components, returning NULL on failure
+static edge_t* insert_edge(int_graph_t* graph, lima_pp_lir_reg_t* reg1,
+						   lima_pp_lir_reg_t* reg2)
+{
+	if (2 * (graph->num_edges + 1) > graph->table_size)
+		if (!int_graph_grow(graph))
+			return NULL;
+	
+	uint64_t key = edge_key(get_index(reg1), get_index(reg2));
+	edge_t* edge = find_edge_key(graph, key);
+	edge->key = key;
+	edge->components = 0;
+	graph->num_edges++;
+	return edge;
+}
+
+//Whether the per-component interference between the two registers is kept
+static bool tracks_components(int_graph_t* graph, lima_pp_lir_reg_t* reg1,
+							  lima_pp_lir_reg_t* reg2)
+{
+	return graph->move_related[get_index(reg1)] &&
+		graph->move_related[get_index(reg2)];
+}
+
+static void set_component(edge_t* edge, lima_pp_lir_reg_t* reg1,
+						  lima_pp_lir_reg_t* reg2, unsigned component1,
+						  unsigned component2)
+{
+	unsigned index1 = get_index(reg1), index2 = get_index(reg2);
+	edge->components |=
+		1 << component_bit(index1, index2, component1, component2);
+	edge->components |=
+		1 << component_bit(index2, index1, component2, component1);
+}
+
+static bool int_graph_create(int_graph_t* graph, lima_pp_lir_prog_t* prog)
+{
+	graph->num_regs = prog->reg_alloc + 1;
+	graph->num_edges = 0;
+	graph->table_size = INITIAL_TABLE_SIZE;
+	graph->edges = calloc(INITIAL_TABLE_SIZE, sizeof(edge_t));
+	graph->regs = calloc(graph->num_regs, sizeof(lima_pp_lir_reg_t*));
+	graph->move_related = calloc(graph->num_regs, sizeof(bool));
+	if (!graph->edges || !graph->regs || !graph->move_related)
+	{
+		free(graph->edges);
+		free(graph->regs);
+		free(graph->move_related);
+		return false;
+	}
 	
 	unsigned i, j;
-	bool added = false;
-	for (i = 0; i < 4; i++)
-		for (j = 0; j < 4; j++)
+	for (i = 0; i < prog->num_regs; i++)
+	{
+		lima_pp_lir_reg_t* reg = prog->regs[i];
+		if (reg->precolored && reg->index != 0)
+			continue;
+		
+		graph->regs[get_index(reg)] = reg;
+	}
+	
+	for (i = 0; i < prog->num_blocks; i++)
+	{
+		lima_pp_lir_scheduled_instr_t* instr;
+		pp_lir_block_for_each_instr(prog->blocks[i], instr)
 		{
-			unsigned reg1_index = 4*get_index(reg1) + i;
-			unsigned reg2_index = 4*get_index(reg2) + j;
-			if (bitset_get(matrix, (1 + num_regs)*4*reg1_index + reg2_index))
+			for (j = 0; j < 5; j++)
 			{
-				added = true;
-				continue;
+				lima_pp_lir_instr_t* alu_instr = instr->alu_instrs[j];
+				if (!alu_instr || !is_move(alu_instr))
+					continue;
+				
+				graph->move_related[get_index(alu_instr->dest.reg)] = true;
+				graph->move_related[get_index(alu_instr->sources[0].reg)] = true;
 			}
-			
-			if (!((reg1_components >> i) & 1) || !((reg2_components >> j) & 1))
-				continue;
-			
-			bitset_set(matrix, (1 + num_regs)*4*reg1_index + reg2_index, true);
-			bitset_set(matrix, (1 + num_regs)*4*reg2_index + reg1_index, true);
 		}
+	}
+	
+	return true;
+}
+
+static void int_graph_delete(int_graph_t* graph)
+{
+	free(graph->edges);
+	free(graph->regs);
+	free(graph->move_related);
+}
+
+static bool add_edge(int_graph_t* graph,
+					 lima_pp_lir_reg_t* reg1, lima_pp_lir_reg_t* reg2,
+					 unsigned reg1_components, unsigned reg2_components)
+{
+	if (reg1 == reg2)
+		return true;
+	
+	edge_t* edge = find_edge(graph, reg1, reg2);
+	bool added = edge != NULL;
+	
+	if (!edge && reg1_components && reg2_components)
+	{
+		edge = insert_edge(graph, reg1, reg2);
+		if (!edge)
+			return false;
+	}
+	
+	if (edge && tracks_components(graph, reg1, reg2))
+	{
+		unsigned i, j;
+		for (i = 0; i < 4; i++)
+			for (j = 0; j < 4; j++)
+			{
+				if (!((reg1_components >> i) & 1) ||
+					!((reg2_components >> j) & 1))
+					continue;
+				
+				set_component(edge, reg1, reg2, i, j);
+			}
+	}
 	
 	if (!added)
 	{
@@ -134,30 +342,12 @@ static void add_edge(lima_pp_lir_reg_t* reg1, lima_pp_lir_reg_t* reg2,
 		ptr_vector_add(&reg1->adjacent, reg2);
 		ptr_vector_add(&reg2->adjacent, reg1);
 	}
-}
-
-static bool is_move(lima_pp_lir_instr_t* instr)
-{
-	if (instr->op != lima_pp_hir_op_mov)
-		return false;
-	
-	if (instr->dest.pipeline || instr->sources[0].pipeline)
-		return false;
-	
-	if (instr->dest.modifier != lima_pp_outmod_none)
-		return false;
-	
-	if (instr->sources[0].absolute || instr->sources[0].negate)
-		return false;
 	
 	return true;
 }
 
-static void add_edge_instr(lima_pp_lir_instr_t* instr, bitset_t matrix,
-						   unsigned num_regs)
+static bool add_edge_instr(lima_pp_lir_instr_t* instr, int_graph_t* graph)
 {
-	lima_pp_lir_prog_t* prog = instr->sched_instr->block->prog;
-	
 	unsigned reg1_components = 0;
 	unsigned i, j;
 	for (i = 0; i < 4; i++)
@@ -180,39 +370,42 @@ static void add_edge_instr(lima_pp_lir_instr_t* instr, bitset_t matrix,
 		}
 	}
 	
-	for (i = 0; i < prog->num_regs; i++)
+	//Each register takes up 4 bits of the liveness info, so every word
+	//covers 8 registers; only look at the registers that are live
+	for (i = 0; i < instr->live_out.size; i++)
 	{
-		lima_pp_lir_reg_t* reg = prog->regs[i];
-		if (reg->precolored && reg->index != 0)
-			continue;
-		
-		unsigned reg2_components = 0;
-		unsigned reg2_index = get_index(reg);
-		for (j = 0; j < 4; j++)
-		{
-			if (bitset_get(instr->live_out, 4*reg2_index + j))
-				reg2_components |= 1 << j;
-		}
-		
-		if (reg == use)
+		uint32_t word = instr->live_out.bits[i];
+		for (j = 0; word != 0; j++, word >>= 4)
 		{
-			reg2_components &= ~use_components;
-		}
-		
-		if (reg2_components)
-		{
-			add_edge(instr->dest.reg, reg, reg1_components, reg2_components,
-					 matrix, num_regs);
+			unsigned reg2_components = word & 0xF;
+			if (!reg2_components || 8*i + j >= graph->num_regs)
+				continue;
+			
+			lima_pp_lir_reg_t* reg = graph->regs[8*i + j];
+			
+			if (reg == use)
+			{
+				reg2_components &= ~use_components;
+			}
+			
+			if (reg2_components)
+			{
+				if (!add_edge(graph, instr->dest.reg, reg, reg1_components,
+							  reg2_components))
+					return false;
+			}
 		}
 	}
+	
+	return true;
 }
 
-//Gets the interference matrix, where each channel of each variable has an entry.
-//Used for move elimination.
-static bitset_t calc_detailed_int_matrix(lima_pp_lir_prog_t* prog)
+static bool calc_int_graph(int_graph_t* graph, lima_pp_lir_prog_t* prog)
 {
+	if (!int_graph_create(graph, prog))
+		return false;
+	
 	unsigned i;
-	bitset_t ret = bitset_create(16 * (prog->reg_alloc + 1) * (prog->reg_alloc + 1));
 	for (i = 0; i < prog->num_regs; i++)
 	{
 		lima_pp_lir_reg_t* reg = prog->regs[i];
@@ -220,36 +413,15 @@ static bitset_t calc_detailed_int_matrix(lima_pp_lir_prog_t* prog)
 		ptrset_iter_t iter = ptrset_iter_create(reg->defs);
 		ptrset_iter_for_each(iter, def)
 		{
-			add_edge_instr(def, ret, prog->reg_alloc);
-		}
-	}
-	
-	return ret;
-}
-
-//Calculate coarse interference matrix for register allocation
-static bitset_t calc_coarse_int_matrix(bitset_t detailed_int_matrix, unsigned num_regs)
-{
-	bitset_t ret = bitset_create((num_regs + 1) * (num_regs + 1));
-	unsigned i, j, ii, jj;
-	for (i = 0; i < num_regs + 1; i++)
-		for (j = 0; j < num_regs + 1; j++)
-		{
-			for (ii = 0; ii < 4; ii++)
+			if (!add_edge_instr(def, graph))
 			{
-				for (jj = 0; jj < 4; jj++)
-					if (bitset_get(detailed_int_matrix,
-								   (num_regs + 1)*4*(4*i + ii) + (4*j + jj)))
-					{
-						bitset_set(ret, (num_regs + 1)*i + j, true);
-						goto outer_break;
-					}
+				int_graph_delete(graph);
+				return false;
 			}
-			outer_break:
-			; //Silly GCC error
 		}
+	}
 	
-	return ret;
+	return true;
 }
 
 typedef struct
@@ -458,7 +630,7 @@ static void simplify(state_t* state)
 	state->select_stack[state->select_stack_index] = reg;
 	state->select_stack_index++;
 	
-	printf("Pushing %%%u onto stack\n", reg->index);
+	lima_trace(lima_trace_regalloc, "Pushing %%%u onto stack\n", reg->index);
 	
 	reg->state = lima_pp_lir_reg_state_simplified;
 	
@@ -511,57 +683,76 @@ static void add_to_queue(lima_pp_lir_reg_t* reg, state_t* state)
 	}
 }
 
-static bool component_interferes(bitset_t matrix, unsigned num_regs,
+static bool component_interferes(int_graph_t* graph,
 								 lima_pp_lir_reg_t* reg1,
 								 lima_pp_lir_reg_t* reg2,
 								 unsigned reg1_component,
 								 unsigned reg2_component)
 {
-	unsigned reg1_index = get_index(reg1);
-	unsigned reg2_index = get_index(reg2);
-	return bitset_get(matrix,
-					  (1 + num_regs)*4*(4*reg1_index + reg1_component) +
-					  (4*reg2_index + reg2_component));
+	edge_t* edge = find_edge(graph, reg1, reg2);
+	if (!edge)
+		return false;
+	
+	//Be conservative if we don't know
+	if (!tracks_components(graph, reg1, reg2))
+		return true;
+	
+	unsigned bit = component_bit(get_index(reg1), get_index(reg2),
+								 reg1_component, reg2_component);
+	return (edge->components >> bit) & 1;
 }
 
-static bool reg_interferes(bitset_t matrix, unsigned num_regs,
+static bool reg_interferes(int_graph_t* graph,
 						   lima_pp_lir_reg_t* reg1,
 						   lima_pp_lir_reg_t* reg2)
 {
-	unsigned reg1_index = get_index(reg1);
-	unsigned reg2_index = get_index(reg2);
-	return bitset_get(matrix, (1 + num_regs)*reg1_index + reg2_index);
+	return find_edge(graph, reg1, reg2) != NULL;
 }
 
+static void add_q(lima_pp_lir_reg_t* reg1, lima_pp_lir_reg_t* reg2,
+				  lima_pp_lir_reg_t* other, unsigned reg_class,
+				  int_graph_t* graph, ptrset_t* seen, unsigned* q_total)
+{
+	if (ptrset_contains(*seen, other))
+		return;
+	
+	ptrset_add(seen, other);
+	
+	if (!reg_interferes(graph, reg1, other) &&
+		!reg_interferes(graph, reg2, other))
+		return;
+	
+	if (other->q_total >= p[get_reg_class(other)])
+	{
+		*q_total += q[reg_class][get_reg_class(other)];
+	}
+}
 
 //Brigg's conservative coalescing heuristic, modified to use the <p, q> test
 static bool can_coalesce(lima_pp_lir_reg_t* reg1, lima_pp_lir_reg_t* reg2,
-						 bitset_t matrix, lima_pp_lir_prog_t* prog,
-						 unsigned num_regs)
+						 int_graph_t* graph)
 {
 	//calculate register class of combined register
 	unsigned size = reg1->size > reg2->size ? reg1->size : reg2->size;
 	unsigned reg_class =
 		(reg1->beginning || reg2->beginning) ? size + 3 : size - 1;
 	
+	//Every register interfering with either one is on one of the adjacent
+	//lists, possibly more than once
+	ptrset_t seen;
+	if (!ptrset_create(&seen))
+		return false;
+	
 	unsigned q_total = 0;
 	unsigned i;
-	for (i = 0; i < prog->num_regs; i++)
-	{
-		lima_pp_lir_reg_t* other = prog->regs[i];
-		
-		if (other->precolored && other->index != 0)
-			continue;
-		
-		if (!reg_interferes(matrix, num_regs, reg1, other) &&
-			!reg_interferes(matrix, num_regs, reg2, other))
-			continue;
-		
-		if (other->q_total >= p[get_reg_class(other)])
-		{
-			q_total += q[reg_class][get_reg_class(other)];
-		}
-	}
+	for (i = 0; i < ptr_vector_size(reg1->adjacent); i++)
+		add_q(reg1, reg2, ptr_vector_get(reg1->adjacent, i), reg_class,
+			  graph, &seen, &q_total);
+	for (i = 0; i < ptr_vector_size(reg2->adjacent); i++)
+		add_q(reg1, reg2, ptr_vector_get(reg2->adjacent, i), reg_class,
+			  graph, &seen, &q_total);
+	
+	ptrset_delete(seen);
 	
 	return q_total < p[reg_class];
 }
@@ -569,16 +760,15 @@ static bool can_coalesce(lima_pp_lir_reg_t* reg1, lima_pp_lir_reg_t* reg2,
 //Add an edge between dst and other
 static void add_move_edge(lima_pp_lir_reg_t* src, lima_pp_lir_reg_t* dst,
 						  lima_pp_lir_reg_t* other, unsigned* swizzle,
-						  bitset_t detailed_matrix, bitset_t coarse_matrix,
-						  unsigned num_regs)
+						  int_graph_t* graph)
 {
-	unsigned dst_index = get_index(dst);
-	unsigned other_index = get_index(other);
-	
-	if (!reg_interferes(coarse_matrix, num_regs, dst, other))
+	edge_t* edge = find_edge(graph, dst, other);
+	if (!edge)
 	{
-		bitset_set(coarse_matrix, (num_regs + 1)*dst_index + other_index, true);
-		bitset_set(coarse_matrix, (num_regs + 1)*other_index + dst_index, true);
+		edge = insert_edge(graph, dst, other);
+		if (!edge)
+			return;
+		
 		ptr_vector_add(&dst->adjacent, other);
 		ptr_vector_add(&other->adjacent, dst);
 		
@@ -589,23 +779,18 @@ static void add_move_edge(lima_pp_lir_reg_t* src, lima_pp_lir_reg_t* dst,
 			other->q_total += q[get_reg_class(other)][get_reg_class(dst)];
 	}
 	
+	if (!tracks_components(graph, dst, other))
+		return;
+	
 	unsigned i, j;
 	for (i = 0; i < src->size; i++)
 		for (j = 0; j < dst->size; j++)
-			if (component_interferes(detailed_matrix, num_regs, src, other, i, j))
-			{
-				bitset_set(detailed_matrix,
-						   (num_regs + 1)*4*(4*dst_index + swizzle[i])
-						   + (4*other_index + j), true);
-				bitset_set(detailed_matrix,
-						   (num_regs + 1)*4*(4*other_index + j)
-						   + (4*dst_index + swizzle[i]), true);
-			}
+			if (component_interferes(graph, src, other, i, j))
+				set_component(edge, dst, other, swizzle[i], j);
 }
 
 static void combine(lima_pp_lir_reg_t* src, lima_pp_lir_reg_t* dst,
-					unsigned* swizzle, bitset_t detailed_matrix,
-					bitset_t coarse_matrix, unsigned num_regs, state_t* state)
+					unsigned* swizzle, int_graph_t* graph, state_t* state)
 {
 	if (src->state == lima_pp_lir_reg_state_to_freeze)
 		ptrset_remove(&state->freeze_queue, src);
@@ -627,8 +812,7 @@ static void combine(lima_pp_lir_reg_t* src, lima_pp_lir_reg_t* dst,
 			other->state == lima_pp_lir_reg_state_coalesced)
 			continue;
 		
-		add_move_edge(src, dst, other, swizzle, detailed_matrix, coarse_matrix,
-					  num_regs);
+		add_move_edge(src, dst, other, swizzle, graph);
 		decrement_q_total(other, src, state);
 	}
 	
@@ -641,9 +825,7 @@ static void combine(lima_pp_lir_reg_t* src, lima_pp_lir_reg_t* dst,
 	}
 }
 
-static void coalesce(state_t* state, bitset_t detailed_matrix,
-					 bitset_t coarse_matrix, lima_pp_lir_prog_t* prog,
-					 unsigned num_regs)
+static void coalesce(state_t* state, int_graph_t* graph)
 {
 	lima_pp_lir_instr_t* move = ptrset_first(state->move_queue);
 	ptrset_remove(&state->move_queue, move);
@@ -704,7 +886,7 @@ static void coalesce(state_t* state, bitset_t detailed_matrix,
 	//Check that src and dst don't interfere
 	for (i = 0; i < num_components; i++)
 	{
-		if (component_interferes(detailed_matrix, num_regs, src, dst,
+		if (component_interferes(graph, src, dst,
 								 src_components[i], dst_components[i]))
 		{
 			add_to_queue(src, state);
@@ -740,7 +922,7 @@ static void coalesce(state_t* state, bitset_t detailed_matrix,
 		for (j = 0; j < dst->size; j++)
 		{
 			if (!dst_used[j] &&
-				!component_interferes(detailed_matrix, num_regs, src, dst, i, j))
+				!component_interferes(graph, src, dst, i, j))
 				break;
 		}
 		
@@ -769,24 +951,24 @@ static void coalesce(state_t* state, bitset_t detailed_matrix,
 	
 	//We've found a valid swizzle, so we can replace src by dst - the only thing
 	//stopping us now is if it could cause extra spills.
-	if (!can_coalesce(src, dst, coarse_matrix, prog, num_regs))
+	if (!can_coalesce(src, dst, graph))
 	{
 		ptrset_add(&state->active_moves, move);
 		return;
 	}
 	
-	printf("Coalesing %%%u into ", src->index);
+	lima_trace(lima_trace_regalloc, "Coalesing %%%u into ", src->index);
 	if (dst->precolored)
-		printf("$%u", dst->index);
+		lima_trace(lima_trace_regalloc, "$%u", dst->index);
 	else
-		printf("%%%u", dst->index);
+		lima_trace(lima_trace_regalloc, "%%%u", dst->index);
 	
-	printf(", swizzle: ");
+	lima_trace(lima_trace_regalloc, ", swizzle: ");
 	for (i = 0; i < src->size; i++)
-		printf("%c", "xyzw"[swizzle[i]]);
-	printf("\n");
+		lima_trace(lima_trace_regalloc, "%c", "xyzw"[swizzle[i]]);
+	lima_trace(lima_trace_regalloc, "\n");
 	
-	combine(src, dst, swizzle, detailed_matrix, coarse_matrix, num_regs, state);
+	combine(src, dst, swizzle, graph, state);
 }
 
 static void freeze_moves(lima_pp_lir_reg_t* reg, state_t* state)
@@ -824,7 +1006,7 @@ static void freeze(state_t* state)
 {
 	lima_pp_lir_reg_t* reg = ptrset_first(state->freeze_queue);
 	
-	printf("Freezing %%%u\n", reg->index);
+	lima_trace(lima_trace_regalloc, "Freezing %%%u\n", reg->index);
 	
 	ptrset_remove(&state->freeze_queue, reg);
 	fixed_queue_push(&state->simplify_queue, reg);
@@ -871,7 +1053,8 @@ static void select_spill(state_t* state)
 		}
 	}
 	
-	printf("Optimistically choosing %%%u for simplifying\n", min_reg->index);
+	lima_trace(lima_trace_regalloc,
+			   "Optimistically choosing %%%u for simplifying\n", min_reg->index);
 	
 	ptrset_remove(&state->spill_queue, min_reg);
 	fixed_queue_push(&state->simplify_queue, min_reg);
@@ -935,8 +1118,9 @@ static void assign_colors(state_t* state)
 					reg->allocated_index = j;
 					reg->allocated_offset = k;
 					reg->state = lima_pp_lir_reg_state_colored;
-					printf("Register %%%u getting index %u, offset %u\n",
-						   reg->index, j, k);
+					lima_trace(lima_trace_regalloc,
+							   "Register %%%u getting index %u, offset %u\n",
+							   reg->index, j, k);
 					break;
 				}
 			}
@@ -947,7 +1131,8 @@ static void assign_colors(state_t* state)
 		
 		if (conflicts)
 		{
-			printf("Failed to find a position for register %%%u\n", reg->index);
+			lima_trace(lima_trace_regalloc,
+					   "Failed to find a position for register %%%u\n", reg->index);
 			ptrset_add(&state->spilled_regs, reg);
 			reg->state = lima_pp_lir_reg_state_spilled;
 		}
@@ -1196,8 +1381,8 @@ static void reg_to_reg_instr(lima_pp_lir_instr_t* instr, lima_pp_lir_reg_t* reg,
 	{
 		if (!instr->sources[i].pipeline && instr->sources[i].reg == reg)
 		{
-			ptrset_remove(&reg->defs, instr);
-			ptrset_add(&new_reg->defs, instr);
+			ptrset_remove(&reg->uses, instr);
+			ptrset_add(&new_reg->uses, instr);
 			instr->sources[i].reg = new_reg;
 		}
 	}
@@ -1294,7 +1479,7 @@ static bool spill_sched_instr(lima_pp_lir_scheduled_instr_t* instr,
 	
 	if (load)
 	{
-		lima_pp_lir_instr_t* load_instr = lima_pp_lir_instr_create();
+		lima_pp_lir_instr_t* load_instr = lima_pp_lir_instr_create(instr->prog);
 		if (!load)
 			return false;
 		
@@ -1316,7 +1501,7 @@ static bool spill_sched_instr(lima_pp_lir_scheduled_instr_t* instr,
 		}
 		else
 		{
-			lima_pp_lir_instr_t* mov_instr = lima_pp_lir_instr_create();
+			lima_pp_lir_instr_t* mov_instr = lima_pp_lir_instr_create(instr->prog);
 			if (!mov_instr)
 			{
 				lima_pp_lir_instr_delete(load_instr);
@@ -1362,7 +1547,7 @@ static bool spill_sched_instr(lima_pp_lir_scheduled_instr_t* instr,
 	
 	if (components_written)
 	{
-		lima_pp_lir_instr_t* store_instr = lima_pp_lir_instr_create();
+		lima_pp_lir_instr_t* store_instr = lima_pp_lir_instr_create(instr->prog);
 		
 		if (!store_instr)
 			return false;
@@ -1475,30 +1660,39 @@ bool lima_pp_lir_regalloc(lima_pp_lir_prog_t* prog)
 		
 		lima_pp_lir_liveness_calc_prog(prog);
 		
-		lima_pp_lir_prog_print(prog, true);
+		if (lima_trace_enabled(lima_trace_regalloc))
+			lima_pp_lir_prog_print(prog, true,
+								   lima_trace_file(lima_trace_regalloc));
 		
-		bitset_t detailed_int_matrix = calc_detailed_int_matrix(prog);
+		int_graph_t graph;
+		if (!calc_int_graph(&graph, prog))
+		{
+			lima_pp_lir_liveness_delete(prog);
+			return false;
+		}
 		lima_pp_lir_liveness_delete(prog);
-		bitset_t coarse_int_matrix = calc_coarse_int_matrix(detailed_int_matrix,
-															prog->reg_alloc);
 		
-		for (i = 0; i < 1 + prog->reg_alloc; i++)
+		if (lima_trace_enabled(lima_trace_regalloc))
 		{
-			for (j = 0; j < 1 + prog->reg_alloc; j++)
+			FILE* f = lima_trace_file(lima_trace_regalloc);
+			for (i = 0; i < graph.num_regs; i++)
 			{
-				if (bitset_get(coarse_int_matrix, (1 + prog->reg_alloc)*i + j))
-					printf("1, ");
-				else
-					printf("0, ");
+				lima_pp_lir_reg_t* reg = graph.regs[i];
+				if (!reg)
+					continue;
+				
+				fprintf(f, "%u:", i);
+				for (j = 0; j < ptr_vector_size(reg->adjacent); j++)
+					fprintf(f, " %u",
+							get_index(ptr_vector_get(reg->adjacent, j)));
+				fprintf(f, "\n");
 			}
-			printf("\n");
 		}
 
 		state_t state;
 		if (!create_state(&state, prog->reg_alloc))
 		{
-			bitset_delete(detailed_int_matrix);
-			bitset_delete(coarse_int_matrix);
+			int_graph_delete(&graph);
 			return false;
 		}
 		
@@ -1510,8 +1704,7 @@ bool lima_pp_lir_regalloc(lima_pp_lir_prog_t* prog)
 			if (!fixed_queue_is_empty(state.simplify_queue))
 				simplify(&state);
 			else if (ptrset_size(state.move_queue) != 0)
-				coalesce(&state, detailed_int_matrix, coarse_int_matrix, prog,
-						 prog->reg_alloc);
+				coalesce(&state, &graph);
 			else if (ptrset_size(state.freeze_queue) != 0)
 				freeze(&state);
 			else if (ptrset_size(state.spill_queue) != 0)
@@ -1520,8 +1713,7 @@ bool lima_pp_lir_regalloc(lima_pp_lir_prog_t* prog)
 		
 		assign_colors(&state);
 		
-		bitset_delete(coarse_int_matrix);
-		bitset_delete(detailed_int_matrix);
+		int_graph_delete(&graph);
 		
 		if (ptrset_size(state.spilled_regs) == 0)
 		{
@@ -1529,11 +1721,14 @@ bool lima_pp_lir_regalloc(lima_pp_lir_prog_t* prog)
 			break;
 		}
 		
+		prog->spill_iterations++;
+		
 		ptrset_iter_t iter = ptrset_iter_create(state.spilled_regs);
 		lima_pp_lir_reg_t* reg;
 		ptrset_iter_for_each(iter, reg)
 		{
-			printf("Spilling register %%%u\n", reg->index);
+			lima_trace(lima_trace_regalloc, "Spilling register %%%u\n",
+					   reg->index);
 			if (!spill_reg(reg, prog))
 			{
 				delete_state(&state);
@@ -1548,3 +1743,400 @@ bool lima_pp_lir_regalloc(lima_pp_lir_prog_t* prog)
 	remove_dead_moves(prog);
 	return true;
 }
+
+/*
+ * Linear scan allocation, for when compile time matters more than the quality
+ * of the code. Each register gets a single live interval, which is the span
+ * of the program (laid out in block order) from the first point where it's
+ * live or written to the last one, so that two registers whose intervals
+ * overlap are assumed to interfere. The intervals are then handed out slots in
+ * the 6 vec4's in order of their start, with the same alignment constraints as
+ * above. There's no coalescing, so some of the moves the graph-coloring
+ * allocator would have gotten rid of are left in.
+ *
+ * Each scheduled instruction gets two points (before and after) for every
+ * stage, in the order the liveness code goes through them, so that a register
+ * read in one stage can share a slot with one written in a later stage.
+ */
+
+#define NUM_STAGES 8
+#define POINTS_PER_INSTR (2 * NUM_STAGES)
+
+typedef struct
+{
+	lima_pp_lir_reg_t* reg;
+	unsigned start, end; //start > end if the register is never live
+} interval_t;
+
+static void extend_interval(interval_t* interval, unsigned point)
+{
+	if (point < interval->start)
+		interval->start = point;
+	if (point > interval->end)
+		interval->end = point;
+}
+
+//Extends the interval of every register live in live to include point
+static void extend_live(interval_t* intervals, unsigned num_intervals,
+						bitset_t live, unsigned point)
+{
+	unsigned i, j;
+	for (i = 0; i < live.size; i++)
+	{
+		uint32_t word = live.bits[i];
+		for (j = 0; word != 0; j++, word >>= 4)
+		{
+			if ((word & 0xF) && 8*i + j < num_intervals)
+				extend_interval(&intervals[8*i + j], point);
+		}
+	}
+}
+
+/*
+ * Within a block, a register is live from where it's written (or the start of
+ * the block, if it's live there) to where it's last read (or the end of the
+ * block), so the hull of the points where it's live is also the hull of the
+ * points where it's read or written, plus the ends of the blocks it's live
+ * across. Only those are looked at, which keeps this linear in the size of
+ * the program instead of going through every live set.
+ */
+
+static void extend_stage(interval_t* intervals, lima_pp_lir_instr_t* instr,
+						 unsigned point, unsigned* first, unsigned* last)
+{
+	if (!instr)
+		return;
+	
+	if (point < *first)
+		*first = point;
+	*last = point;
+	
+	//Sources are live where they're read, see liveness_calc_read()
+	unsigned i, j;
+	for (i = 0; i < lima_pp_hir_op[instr->op].args; i++)
+	{
+		if (instr->sources[i].constant || instr->sources[i].pipeline)
+			continue;
+		
+		for (j = 0; j < lima_pp_lir_arg_size(instr, i); j++)
+		{
+			if (lima_pp_lir_channel_used(instr, i, j))
+			{
+				extend_interval(&intervals[get_index(instr->sources[i].reg)],
+								point);
+				break;
+			}
+		}
+	}
+	
+	//Registers that are written but never read still need somewhere to go
+	if (lima_pp_hir_op[instr->op].has_dest && !instr->dest.pipeline)
+		extend_interval(&intervals[get_index(instr->dest.reg)], point + 1);
+}
+
+static void calc_intervals(lima_pp_lir_prog_t* prog, interval_t* intervals,
+						   unsigned num_intervals)
+{
+	unsigned i, j, point = 0;
+	for (i = 0; i < num_intervals; i++)
+	{
+		intervals[i].reg = NULL;
+		intervals[i].start = UINT_MAX;
+		intervals[i].end = 0;
+	}
+	
+	for (i = 0; i < prog->num_regs; i++)
+	{
+		lima_pp_lir_reg_t* reg = prog->regs[i];
+		if (reg->precolored && reg->index != 0)
+			continue;
+		
+		intervals[get_index(reg)].reg = reg;
+	}
+	
+	for (i = 0; i < prog->num_blocks; i++)
+	{
+		lima_pp_lir_block_t* block = prog->blocks[i];
+		
+		//The first and last points used by an instruction in the block
+		unsigned first = UINT_MAX, last = 0;
+		
+		lima_pp_lir_scheduled_instr_t* instr;
+		pp_lir_block_for_each_instr(block, instr)
+		{
+			extend_stage(intervals, instr->varying_instr, point,
+						 &first, &last);
+			extend_stage(intervals, instr->texld_instr, point + 2,
+						 &first, &last);
+			extend_stage(intervals, instr->uniform_instr, point + 4,
+						 &first, &last);
+			for (j = 0; j < 5; j++)
+				extend_stage(intervals, instr->alu_instrs[j],
+							 point + 6 + 2 * (j / 2), &first, &last);
+			extend_stage(intervals, instr->temp_store_instr, point + 12,
+						 &first, &last);
+			extend_stage(intervals, instr->branch_instr, point + 14,
+						 &first, &last);
+			
+			point += POINTS_PER_INSTR;
+		}
+		
+		if (first > last)
+			continue;
+		
+		extend_live(intervals, num_intervals, block->live_in, first);
+		extend_live(intervals, num_intervals, block->live_out, last + 1);
+	}
+}
+
+static int compare_intervals(const void* elem1, const void* elem2)
+{
+	const interval_t* interval1 = *(const interval_t* const*) elem1;
+	const interval_t* interval2 = *(const interval_t* const*) elem2;
+	
+	if (interval1->start != interval2->start)
+		return interval1->start < interval2->start ? -1 : 1;
+	
+	return interval1->reg->index < interval2->reg->index ? -1 : 1;
+}
+
+static unsigned reg_mask(lima_pp_lir_reg_t* reg)
+{
+	return ((1 << reg->size) - 1) << reg->allocated_offset;
+}
+
+//Finds a free slot for interval given the components in use in each vec4
+static bool find_slot(interval_t* interval, const unsigned* used,
+					  interval_t** precolored, unsigned num_precolored)
+{
+	lima_pp_lir_reg_t* reg = interval->reg;
+	unsigned i, j, k;
+	for (j = 0; j < 6; j++)
+	{
+		bool blocked = false;
+		for (i = 0; i < num_precolored; i++)
+		{
+			if (precolored[i]->reg->index == j &&
+				precolored[i]->start <= interval->end &&
+				interval->start <= precolored[i]->end)
+			{
+				blocked = true;
+				break;
+			}
+		}
+		
+		if (blocked)
+			continue;
+		
+		for (k = 0; k < (reg->beginning ? 1 : 5 - reg->size); k++)
+		{
+			unsigned mask = ((1 << reg->size) - 1) << k;
+			if (!(used[j] & mask))
+			{
+				reg->allocated_index = j;
+				reg->allocated_offset = k;
+				return true;
+			}
+		}
+	}
+	
+	return false;
+}
+
+/*
+ * Runs a single linear scan over the intervals, adding the registers that
+ * didn't fit to spilled_regs. When a register doesn't fit, we spill whichever
+ * of it and the active registers (the ones taking up a slot) ends last, as
+ * long as getting rid of that register makes room.
+ */
+
+static bool linear_scan(interval_t** sorted, unsigned num_sorted,
+						interval_t** precolored, unsigned num_precolored,
+						ptrset_t* spilled_regs)
+{
+	interval_t** active = malloc(num_sorted * sizeof(interval_t*));
+	if (!active)
+		return false;
+	
+	unsigned used[6] = {0, 0, 0, 0, 0, 0};
+	unsigned num_active = 0, i, j;
+	for (i = 0; i < num_sorted; i++)
+	{
+		interval_t* cur = sorted[i];
+		
+		//Expire the registers that are dead by now
+		for (j = 0; j < num_active; )
+		{
+			lima_pp_lir_reg_t* reg = active[j]->reg;
+			if (active[j]->end < cur->start)
+			{
+				used[reg->allocated_index] &= ~reg_mask(reg);
+				active[j] = active[--num_active];
+			}
+			else
+				j++;
+		}
+		
+		if (!find_slot(cur, used, precolored, num_precolored))
+		{
+			unsigned victim = num_active;
+			for (j = 0; j < num_active; j++)
+			{
+				lima_pp_lir_reg_t* reg = active[j]->reg;
+				if (active[j]->end <= cur->end ||
+					(victim != num_active && active[j]->end <= active[victim]->end))
+					continue;
+				
+				unsigned old_used = used[reg->allocated_index];
+				used[reg->allocated_index] &= ~reg_mask(reg);
+				
+				unsigned allocated_index = reg->allocated_index;
+				unsigned allocated_offset = reg->allocated_offset;
+				if (find_slot(cur, used, precolored, num_precolored))
+					victim = j;
+				reg->allocated_index = allocated_index;
+				reg->allocated_offset = allocated_offset;
+				
+				used[reg->allocated_index] = old_used;
+			}
+			
+			if (victim == num_active)
+			{
+				lima_trace(lima_trace_regalloc,
+						   "Failed to find a position for register %%%u\n",
+						   cur->reg->index);
+				ptrset_add(spilled_regs, cur->reg);
+				cur->reg->state = lima_pp_lir_reg_state_spilled;
+				continue;
+			}
+			
+			lima_pp_lir_reg_t* reg = active[victim]->reg;
+			lima_trace(lima_trace_regalloc,
+					   "Evicting register %%%u to make room for %%%u\n",
+					   reg->index, cur->reg->index);
+			used[reg->allocated_index] &= ~reg_mask(reg);
+			ptrset_add(spilled_regs, reg);
+			reg->state = lima_pp_lir_reg_state_spilled;
+			active[victim] = active[--num_active];
+			
+			find_slot(cur, used, precolored, num_precolored);
+		}
+		
+		lima_trace(lima_trace_regalloc,
+				   "Register %%%u getting index %u, offset %u\n",
+				   cur->reg->index, cur->reg->allocated_index,
+				   cur->reg->allocated_offset);
+		cur->reg->state = lima_pp_lir_reg_state_colored;
+		used[cur->reg->allocated_index] |= reg_mask(cur->reg);
+		active[num_active++] = cur;
+	}
+	
+	free(active);
+	return true;
+}
+
+bool lima_pp_lir_regalloc_linear_scan(lima_pp_lir_prog_t* prog)
+{
+	unsigned i;
+	
+	while (true)
+	{
+		init_regs(prog);
+		
+		if (!lima_pp_lir_liveness_init(prog))
+			return false;
+		
+		lima_pp_lir_liveness_calc_prog(prog);
+		
+		unsigned num_intervals = prog->reg_alloc + 1;
+		interval_t* intervals = malloc(num_intervals * sizeof(interval_t));
+		interval_t** sorted = malloc(num_intervals * sizeof(interval_t*));
+		if (!intervals || !sorted)
+		{
+			free(intervals);
+			free(sorted);
+			lima_pp_lir_liveness_delete(prog);
+			return false;
+		}
+		
+		calc_intervals(prog, intervals, num_intervals);
+		lima_pp_lir_liveness_delete(prog);
+		
+		//The precolored registers go at the end, so that they can be passed
+		//to find_slot() separately
+		unsigned num_sorted = 0, num_precolored = 0;
+		for (i = 0; i < num_intervals; i++)
+		{
+			lima_pp_lir_reg_t* reg = intervals[i].reg;
+			if (!reg)
+				continue;
+			
+			if (intervals[i].start > intervals[i].end)
+			{
+				//Never live or written, so any slot will do
+				if (!reg->precolored)
+				{
+					reg->allocated_index = 0;
+					reg->allocated_offset = 0;
+					reg->state = lima_pp_lir_reg_state_colored;
+				}
+				continue;
+			}
+			
+			if (reg->precolored)
+				sorted[num_intervals - ++num_precolored] = &intervals[i];
+			else
+				sorted[num_sorted++] = &intervals[i];
+		}
+		
+		qsort(sorted, num_sorted, sizeof(interval_t*), compare_intervals);
+		
+		ptrset_t spilled_regs;
+		if (!ptrset_create(&spilled_regs))
+		{
+			free(intervals);
+			free(sorted);
+			return false;
+		}
+		
+		bool ret = linear_scan(sorted, num_sorted,
+							   sorted + num_intervals - num_precolored,
+							   num_precolored, &spilled_regs);
+		
+		free(intervals);
+		free(sorted);
+		
+		if (!ret)
+		{
+			ptrset_delete(spilled_regs);
+			return false;
+		}
+		
+		if (ptrset_size(spilled_regs) == 0)
+		{
+			ptrset_delete(spilled_regs);
+			break;
+		}
+		
+		prog->spill_iterations++;
+		
+		ptrset_iter_t iter = ptrset_iter_create(spilled_regs);
+		lima_pp_lir_reg_t* reg;
+		ptrset_iter_for_each(iter, reg)
+		{
+			lima_trace(lima_trace_regalloc, "Spilling register %%%u\n",
+					   reg->index);
+			if (!spill_reg(reg, prog))
+			{
+				ptrset_delete(spilled_regs);
+				return false;
+			}
+		}
+		
+		ptrset_delete(spilled_regs);
+	}
+	
+	rewrite_regs(prog);
+	remove_dead_moves(prog);
+	return true;
+}
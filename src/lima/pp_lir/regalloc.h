@@ -28,6 +28,7 @@
 #include "pp_lir.h"
 
 bool lima_pp_lir_regalloc(lima_pp_lir_prog_t* prog);
+bool lima_pp_lir_regalloc_linear_scan(lima_pp_lir_prog_t* prog);
 
 
 #endif
@@ -57,6 +57,12 @@ static inline void ptr_vector_clear(ptr_vector_t* vector)
 	vector->size = 0;
 }
 
+static inline void ptr_vector_truncate(ptr_vector_t* vector, unsigned size)
+{
+	assert(size <= vector->size);
+	vector->size = size;
+}
+
 ptr_vector_t ptr_vector_create(void);
 void ptr_vector_delete(ptr_vector_t vector);
 bool ptr_vector_add(ptr_vector_t* vector, void* elem);
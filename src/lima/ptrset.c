@@ -26,163 +26,241 @@
 #include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
 #include <assert.h>
 
 
-#define INITIAL_NUM_ELEMS 16
-#define MAX_LOAD 0.7f
+/* capacity of the dense array when a set first outgrows its inline storage */
+#define INITIAL_CAPACITY 16
 
-#define EMPTY_ELEM NULL
-#define DELETED_ELEM ((void*)1)
+static unsigned get_hash(void* ptr, unsigned mask)
+{
+	uintptr_t num = (uintptr_t) ptr;
+	uint32_t hash = (uint32_t) (num >> 4) ^ (uint32_t) (num >> 20);
+	hash *= 0x9E3779B1u;
+	return (hash ^ (hash >> 15)) & mask;
+}
 
-static unsigned get_hash(void* ptr, unsigned num_elems)
+static bool is_inline(const ptrset_t* set)
 {
-	unsigned long num = (unsigned long) ptr;
-	return (num >> 4) % num_elems;
+	return set->capacity == PTRSET_INLINE_SIZE;
 }
-bool ptrset_create(ptrset_t* set)
-{	
-	set->elems = calloc(INITIAL_NUM_ELEMS, sizeof(void*));
-	if (!set->elems)
-		return false;
-	
-	set->size = 0;
-	set->total_size = 0;
-	set->num_elems = INITIAL_NUM_ELEMS;
-	return true;
+
+static void** get_elems(ptrset_t* set)
+{
+	if (is_inline(set))
+		return set->u.inline_elems;
+	return set->u.heap.elems;
 }
 
-void ptrset_delete(ptrset_t set)
+/* The dense array and the hash table are allocated together, with the table
+ * right after the array.
+ */
+
+static unsigned storage_size(unsigned capacity)
 {
-	free(set.elems);
+	return capacity * sizeof(void*) + 2 * capacity * sizeof(unsigned);
 }
 
-bool ptrset_copy(ptrset_t* dest, ptrset_t src)
+static void** storage_alloc(arena_t* arena, unsigned capacity)
 {
-	dest->elems = calloc(src.num_elems, sizeof(void*));
-	if (!dest->elems)
-		return false;
-	
-	dest->num_elems = src.num_elems;
-	dest->size = src.size;
-	dest->total_size = src.total_size;
-	
-	memcpy(dest->elems, src.elems, src.num_elems * sizeof(void*));
+	if (arena)
+		return arena_calloc(arena, storage_size(capacity));
+	return calloc(storage_size(capacity), 1);
+}
+
+static void storage_free(ptrset_t* set)
+{
+	if (is_inline(set))
+		return;
 	
-	return true;
+	if (set->arena)
+		arena_free(set->arena, set->u.heap.elems, storage_size(set->capacity));
+	else
+		free(set->u.heap.elems);
 }
 
-static void elems_add(void** elems, unsigned num_elems, void* ptr)
+/* returns the table slot containing ptr, or the empty slot where it would go */
+static unsigned* table_lookup(ptrset_t* set, void* ptr)
 {
-	unsigned hash = get_hash(ptr, num_elems);
-	while (elems[hash] != EMPTY_ELEM)
+	unsigned mask = 2 * set->capacity - 1;
+	unsigned hash = get_hash(ptr, mask);
+	unsigned* table = set->u.heap.table;
+	while (table[hash] != 0)
 	{
-		hash = (hash + 1) % num_elems;
+		if (set->u.heap.elems[table[hash] - 1] == ptr)
+			break;
+		
+		hash = (hash + 1) & mask;
 	}
 	
-	elems[hash] = ptr;
+	return &table[hash];
 }
 
-static bool ptrset_expand(ptrset_t* set, unsigned new_num_elems)
+/* moves the elements into freshly allocated heap storage, dropping any
+ * removed ones but keeping them in the same order
+ */
+static bool ptrset_rebuild(ptrset_t* set, unsigned new_capacity)
 {
-	void** new_elems = calloc(new_num_elems, sizeof(void*));
+	void** new_elems = storage_alloc(set->arena, new_capacity);
 	if (!new_elems)
 		return false;
 	
-	unsigned i;
+	void** old_elems = get_elems(set);
+	unsigned i, num_elems = 0;
 	for (i = 0; i < set->num_elems; i++)
-	{
-		if (set->elems[i] == EMPTY_ELEM || set->elems[i] == DELETED_ELEM)
-			continue;
-		
-		elems_add(new_elems, new_num_elems, set->elems[i]);
-	}
+		if (old_elems[i])
+			new_elems[num_elems++] = old_elems[i];
+	
+	storage_free(set);
+	set->u.heap.elems = new_elems;
+	set->u.heap.table = (unsigned*)(new_elems + new_capacity);
+	set->capacity = new_capacity;
+	set->num_elems = num_elems;
+	
+	for (i = 0; i < num_elems; i++)
+		*table_lookup(set, new_elems[i]) = i + 1;
+	
+	return true;
+}
+
+bool ptrset_create_arena(ptrset_t* set, arena_t* arena)
+{
+	set->size = 0;
+	set->num_elems = 0;
+	set->capacity = PTRSET_INLINE_SIZE;
+	set->arena = arena;
+	return true;
+}
+
+bool ptrset_create(ptrset_t* set)
+{
+	return ptrset_create_arena(set, NULL);
+}
+
+void ptrset_delete(ptrset_t set)
+{
+	storage_free(&set);
+}
+
+bool ptrset_copy(ptrset_t* dest, ptrset_t src)
+{
+	*dest = src;
+	if (is_inline(&src))
+		return true;
+	
+	dest->u.heap.elems = storage_alloc(src.arena, src.capacity);
+	if (!dest->u.heap.elems)
+		return false;
+	
+	dest->u.heap.table = (unsigned*)(dest->u.heap.elems + src.capacity);
+	memcpy(dest->u.heap.elems, src.u.heap.elems, storage_size(src.capacity));
 	
-	free(set->elems);
-	set->num_elems = new_num_elems;
-	set->elems = new_elems;
-	set->total_size = set->size;
 	return true;
 }
 
 bool ptrset_add(ptrset_t* set, void* ptr)
 {
-	if ((float)set->total_size / set->num_elems > MAX_LOAD)
-		if (!ptrset_expand(set, set->num_elems * 2))
-			return false;
+	assert(ptr);
 	
-	unsigned hash = get_hash(ptr, set->num_elems);
-	unsigned insert_point;
-	bool inserted = false;
-	while (set->elems[hash] != EMPTY_ELEM)
+	unsigned i;
+	if (is_inline(set))
 	{
-		if (set->elems[hash] == ptr)
-			return true;
+		for (i = 0; i < set->size; i++)
+			if (set->u.inline_elems[i] == ptr)
+				return true;
 		
-		if (set->elems[hash] == DELETED_ELEM && !inserted)
+		if (set->size < PTRSET_INLINE_SIZE)
 		{
-			insert_point = hash;
-			inserted = true;
+			set->u.inline_elems[set->size++] = ptr;
+			set->num_elems++;
+			return true;
 		}
 		
-		hash = (hash + 1) % set->num_elems;
+		if (!ptrset_rebuild(set, INITIAL_CAPACITY))
+			return false;
 	}
 	
-	if (!inserted)
+	unsigned* slot = table_lookup(set, ptr);
+	if (*slot != 0)
+		return true;
+	
+	if (set->num_elems == set->capacity)
 	{
-		set->total_size++;
-		insert_point = hash;
+		//If at least half the slots are live, grow; otherwise, just squeeze
+		//out the removed elements
+		unsigned new_capacity = set->capacity;
+		if (set->size >= set->capacity / 2)
+			new_capacity *= 2;
+		if (!ptrset_rebuild(set, new_capacity))
+			return false;
+		
+		slot = table_lookup(set, ptr);
 	}
 	
-	set->elems[insert_point] = ptr;
+	set->u.heap.elems[set->num_elems++] = ptr;
+	*slot = set->num_elems;
 	set->size++;
 	
-	assert(set->size <= set->total_size);
-	
 	return true;
 }
 
 bool ptrset_contains(ptrset_t set, void* ptr)
 {
-	unsigned hash = get_hash(ptr, set.num_elems);
-	while (set.elems[hash] != EMPTY_ELEM)
+	if (is_inline(&set))
 	{
-		if (set.elems[hash] == ptr)
-			return true;
+		unsigned i;
+		for (i = 0; i < set.size; i++)
+			if (set.u.inline_elems[i] == ptr)
+				return true;
 		
-		hash = (hash + 1) % set.num_elems;
+		return false;
 	}
 	
-	return false;
+	return *table_lookup(&set, ptr) != 0;
 }
 
 bool ptrset_remove(ptrset_t* set, void* ptr)
 {
-	unsigned hash = get_hash(ptr, set->num_elems);
-	while (set->elems[hash] != EMPTY_ELEM)
+	if (is_inline(set))
 	{
-		if (set->elems[hash] == ptr)
+		unsigned i;
+		for (i = 0; i < set->size; i++)
 		{
-			set->elems[hash] = DELETED_ELEM;
-			set->size--;
-			return true;
+			if (set->u.inline_elems[i] == ptr)
+			{
+				memmove(&set->u.inline_elems[i], &set->u.inline_elems[i + 1],
+						(set->size - i - 1) * sizeof(void*));
+				set->size--;
+				set->num_elems--;
+				return true;
+			}
 		}
 		
-		hash = (hash + 1) % set->num_elems;
+		return false;
 	}
 	
-	return false;
+	//The table entry stays behind and points to the NULL left in the array,
+	//which never matches anything, until the next rebuild
+	unsigned* slot = table_lookup(set, ptr);
+	if (*slot == 0)
+		return false;
+	
+	set->u.heap.elems[*slot - 1] = NULL;
+	set->size--;
+	return true;
 }
 
 bool ptrset_union(ptrset_t* dest, ptrset_t src)
 {
+	void** elems = get_elems(&src);
 	unsigned i;
 	for (i = 0; i < src.num_elems; i++)
 	{
-		if (src.elems[i] == EMPTY_ELEM || src.elems[i] == DELETED_ELEM)
+		if (!elems[i])
 			continue;
 		
-		if (!ptrset_add(dest, src.elems[i]))
+		if (!ptrset_add(dest, elems[i]))
 			return false;
 	}
 	
@@ -191,13 +269,12 @@ bool ptrset_union(ptrset_t* dest, ptrset_t src)
 
 void* ptrset_first(ptrset_t set)
 {
+	void** elems = get_elems(&set);
 	unsigned i;
 	for (i = 0; i < set.num_elems; i++)
 	{
-		if (set.elems[i] == EMPTY_ELEM || set.elems[i] == DELETED_ELEM)
-			continue;
-		
-		return set.elems[i];
+		if (elems[i])
+			return elems[i];
 	}
 	
 	return NULL;
@@ -205,59 +282,39 @@ void* ptrset_first(ptrset_t set)
 
 void ptrset_empty(ptrset_t* set)
 {
-	memset(set->elems, 0, set->num_elems * sizeof(void*));
+	if (!is_inline(set))
+		memset(set->u.heap.table, 0, 2 * set->capacity * sizeof(unsigned));
 	set->size = 0;
+	set->num_elems = 0;
 }
 
-static void update_iter_initial(ptrset_iter_t* iter)
+static void update_iter(ptrset_iter_t* iter, unsigned start)
 {
+	void** elems = get_elems(&iter->set);
 	unsigned i;
-	for (i = 0; i < iter->set.num_elems; i++)
+	for (i = start; i < iter->set.num_elems; i++)
 	{
-		if (iter->set.elems[i] != EMPTY_ELEM &&
-			iter->set.elems[i] != DELETED_ELEM)
-		{
-			iter->cur_elem = i;
-			return;
-		}
+		if (elems[i])
+			break;
 	}
 	
-	iter->cur_elem = iter->set.num_elems;
-	return;
+	iter->cur_elem = i;
 }
 
 ptrset_iter_t ptrset_iter_create(ptrset_t set)
 {
 	ptrset_iter_t iter;
-	iter.cur_elem = 0;
 	iter.set = set;
-	update_iter_initial(&iter);
+	update_iter(&iter, 0);
 	return iter;
 }
 
-static void update_iter(ptrset_iter_t* iter)
-{
-	assert(iter->cur_elem != iter->set.num_elems);
-	
-	unsigned i;
-	for (i = iter->cur_elem + 1; i < iter->set.num_elems; i++)
-	{
-		if (iter->set.elems[i] != EMPTY_ELEM &&
-			iter->set.elems[i] != DELETED_ELEM)
-		{
-			iter->cur_elem = i;
-			return;
-		}
-	}
-	iter->cur_elem = iter->set.num_elems;
-}
-
 bool ptrset_iter_next(ptrset_iter_t* iter, void** ptr)
 {
 	if (iter->cur_elem == iter->set.num_elems)
 		return false;
-
-	*ptr = iter->set.elems[iter->cur_elem];
-	update_iter(iter);
+	
+	*ptr = get_elems(&iter->set)[iter->cur_elem];
+	update_iter(iter, iter->cur_elem + 1);
 	return true;
 }
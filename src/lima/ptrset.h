@@ -26,16 +26,33 @@
 #define __ptrset_h__
 
 #include <stdbool.h>
+#include "arena.h"
 
 
-/* Implements a set of pointers,
- * using an open-coded linear-probe hash-set
+/* Implements a set of pointers.
+ *
+ * Sets with up to PTRSET_INLINE_SIZE elements keep them inline in the
+ * ptrset_t itself, and lookups just scan them. Larger sets keep the elements
+ * in a dense array in insertion order, indexed by an open-addressed hash
+ * table of power-of-two size. Either way, iteration visits the elements in
+ * the order they were added, so that anything which walks a set (e.g. the
+ * schedulers) doesn't depend on where things happen to be in memory.
  */
 
+#define PTRSET_INLINE_SIZE 4
+
 typedef struct {
-	void** elems;
-	unsigned size, num_elems;
-	unsigned total_size; //internal, includes deleted elements
+	union {
+		void* inline_elems[PTRSET_INLINE_SIZE];
+		struct {
+			void** elems; //in insertion order, NULL for removed elements
+			unsigned* table; //index + 1 into elems, or 0 for an empty slot
+		} heap;
+	} u;
+	unsigned size; //number of elements in the set
+	unsigned num_elems; //internal, used slots in elems (including removed)
+	unsigned capacity; //internal, slots in elems; table has twice as many
+	arena_t* arena; //where the heap storage comes from, or NULL for malloc
 } ptrset_t;
 
 typedef struct {
@@ -44,6 +61,7 @@ typedef struct {
 } ptrset_iter_t;
 
 bool ptrset_create(ptrset_t* set);
+bool ptrset_create_arena(ptrset_t* set, arena_t* arena);
 void ptrset_delete(ptrset_t set);
 bool ptrset_copy(ptrset_t* dest, ptrset_t src);
 bool ptrset_add(ptrset_t* set, void* ptr);
@@ -59,7 +77,8 @@ static inline unsigned ptrset_size(ptrset_t set)
 
 /* 
  * Note: this iterator implementation *is* safe for deletion of the current
- * element.
+ * element. Elements are returned in insertion order. Small sets are copied
+ * into the iterator, so changes made to them during iteration aren't seen.
  */
 
 ptrset_iter_t ptrset_iter_create(ptrset_t set);
@@ -69,10 +69,41 @@ typedef union {
 	} fs;
 } lima_shader_info_t;
 
+struct lima_compiler_s;
+typedef struct lima_compiler_s lima_compiler_t;
+
+/*
+ * The compiler context owns the state shared between shaders, i.e. the
+ * builtin function library and the GLSL type tables. These are built the
+ * first time a compiler is created and kept alive until the last compiler is
+ * deleted, so that compiling many shaders doesn't rebuild them every time.
+ * All shaders created with a compiler must be deleted before the compiler.
+ *
+ * A compiler may be shared between threads, and different shaders may be
+ * compiled concurrently, but each shader must only be used by one thread at a
+ * time.
+ */
+
+lima_compiler_t* lima_compiler_create(void);
+void lima_compiler_delete(lima_compiler_t* compiler);
+
+/*
+ * Keep compiled shaders in a cache directory on disk, which may be shared
+ * with other processes, and grows up to max_size bytes. Shaders whose source,
+ * stage, core, and options match a cached shader compiled by the same
+ * compiler binary are loaded from the cache in lima_shader_parse(), after
+ * which optimizing and compiling them does nothing and the GLSL IR can't be
+ * printed. Must be called before any shaders are created.
+ */
+
+bool lima_compiler_set_cache(lima_compiler_t* compiler, const char* path,
+							 unsigned long max_size);
+
 struct lima_shader_s;
 typedef struct lima_shader_s lima_shader_t;
 
-lima_shader_t* lima_shader_create(lima_shader_stage_e stage, lima_core_e core);
+lima_shader_t* lima_shader_create(lima_compiler_t* compiler,
+								  lima_shader_stage_e stage, lima_core_e core);
 void lima_shader_delete(lima_shader_t* shader);
 
 /*
@@ -122,10 +153,296 @@ lima_shader_stage_e lima_shader_get_stage(lima_shader_t* shader);
 
 struct lima_shader_symbols_s* lima_shader_get_symbols(lima_shader_t* shader);
 
-/* export to the MBS format used by the binary offline compiler */
+/*
+ * Statistics about the passes run on a shader, for finding out where compile
+ * time goes. A pass run more than once (e.g. in the optimization loop) gets a
+ * single entry, with the time and heap growth summed over all the runs and
+ * the sizes taken from before the first and after the last run. Sizes count
+ * the unit of whatever IR the pass works on: GLSL IR instructions, PP HIR
+ * commands, scheduled PP LIR instructions, or GP IR root nodes, and registers
+ * count GLSL variables or backend registers.
+ *
+ * Heap usage counts what the compiler allocates with malloc and friends on
+ * the thread running the pass, so other shaders being compiled at the same
+ * time don't affect it. The peaks are high-water marks inside the passes:
+ * a pass's peak_heap is the most it had allocated above what was in use
+ * when it started, over all its runs, and the shader's is the highest total
+ * reached by all the passes so far. Heap usage is only counted in builds on
+ * Linux, and is 0 elsewhere.
+ */
+
+typedef struct {
+	const char* name;
+	unsigned runs;
+	double time; /* wall time in seconds */
+	long heap_delta; /* change in heap usage in bytes */
+	unsigned long peak_heap; /* in bytes */
+	unsigned size_before, size_after;
+	unsigned regs_before, regs_after;
+} lima_pass_stats_t;
+
+typedef struct {
+	unsigned num_passes;
+	lima_pass_stats_t* passes;
+	
+	double total_time;
+	unsigned long peak_heap;
+	
+	unsigned sched_restarts; /* GP scheduler */
+	unsigned sched_nodes_undone;
+	unsigned spill_iterations; /* PP register allocator */
+	
+	bool cached; /* loaded from the cache, so no passes were run */
+} lima_shader_stats_t;
+
+/* start collecting stats, must be called before lima_shader_parse() */
+
+void lima_shader_enable_stats(lima_shader_t* shader);
+
+/* returns NULL if stats weren't enabled */
+
+const lima_shader_stats_t* lima_shader_get_stats(lima_shader_t* shader);
+
+/*
+ * A static estimate of how well the compiled code will run, for choosing
+ * between variants of a shader and catching code quality regressions
+ * without the hardware. Every instruction counts as one cycle, assuming the
+ * other threads hide the latency of texture fetches and loads. Loops are
+ * counted as running once, so when has_loops is set the cycle counts are
+ * for a single trip through each loop. The shortest path may be one that
+ * discards.
+ *
+ * Each unit counts how many of its slots the code fills out of how many
+ * there are, e.g. vertex shaders have two multipliers and two adders in
+ * every instruction. Constant slots are the two vec4 constants fragment
+ * shader instructions can embed; vertex shaders load constants like
+ * uniforms instead, so they have none. Temporary loads and stores are
+ * mostly register spills, but indexing into arrays uses them too.
+ */
+
+typedef struct {
+	unsigned used, total;
+} lima_slot_usage_t;
+
+typedef struct {
+	unsigned num_instructions;
+	unsigned min_cycles, max_cycles; /* along the shortest and longest path */
+	bool has_loops;
+	unsigned branches;
+	lima_slot_usage_t const_slots;
+	unsigned temp_loads, temp_stores;
+	
+	union {
+		struct {
+			lima_slot_usage_t mul, add, complex, pass, load;
+		} vs;
+		
+		struct {
+			lima_slot_usage_t varying, texld, uniform;
+			lima_slot_usage_t vmul, fmul, vadd, fadd, combine;
+		} fs;
+	} units;
+} lima_shader_report_t;
+
+/* returns false if the shader hasn't been compiled */
+
+bool lima_shader_get_report(lima_shader_t* shader,
+							lima_shader_report_t* report);
+
+/*
+ * Debug output, which is off by default. Everything the compiler has to say
+ * about the enabled categories while compiling the shader gets passed to
+ * sink, a chunk at a time and flushed at the end of each line. The sink is
+ * called on the thread doing the compiling.
+ */
+
+typedef enum {
+	lima_trace_sched    = 1 << 0, /* instruction schedulers */
+	lima_trace_regalloc = 1 << 1, /* register allocators */
+	lima_trace_ir       = 1 << 2, /* IR dumps in the middle of compiling */
+	lima_trace_symbols  = 1 << 3, /* the symbol table after packing */
+	lima_trace_all      = 0xf
+} lima_trace_category_e;
+
+typedef void (*lima_trace_sink_t)(lima_trace_category_e category,
+								  const char* text, unsigned size,
+								  void* data);
+
+void lima_shader_set_trace(lima_shader_t* shader, unsigned categories,
+						   lima_trace_sink_t sink, void* data);
+
+/*
+ * Which register allocator the backends use. The graph-coloring allocator,
+ * which is the default, produces the best code. Linear scan is a lot faster,
+ * at the cost of some extra moves and spills, for when compile latency
+ * matters more. Must be called before lima_shader_parse() or
+ * lima_shader_resume().
+ */
+
+typedef enum {
+	lima_regalloc_graph,
+	lima_regalloc_linear_scan
+} lima_regalloc_e;
+
+void lima_shader_set_regalloc(lima_shader_t* shader, lima_regalloc_e regalloc);
+
+/*
+ * How much work the compiler puts into the code, similar to -O in other
+ * compilers. -O0 only runs the passes needed to get correct code, and is for
+ * tools that recompile on every edit. -O1 skips the slowest passes, and -O2,
+ * the default, runs everything. -Os also runs everything, but where a pass
+ * can make the code bigger it compiles the shader both with and without it
+ * and keeps the smaller result, so it's the slowest. Repeated passes have a
+ * bounded number of iterations at every level. See opt_levels in shader.cpp
+ * for the passes run at each level. Must be called before
+ * lima_shader_parse() or lima_shader_resume().
+ */
+
+typedef enum {
+	lima_opt_level_0,
+	lima_opt_level_1,
+	lima_opt_level_2,
+	lima_opt_level_size
+} lima_opt_level_e;
+
+void lima_shader_set_opt_level(lima_shader_t* shader, lima_opt_level_e level);
+
+/*
+ * Checkpoints, for trying out several backend options (e.g. register
+ * allocators or optimization levels) on a shader without running the
+ * frontend each time. lima_shader_checkpoint() takes a shader after
+ * lima_shader_optimize(), lowers it to the backend IR, and returns the IR and
+ * the symbol tables as a blob allocated with malloc(), or NULL if there were
+ * errors or it ran out of memory. The shader can still be compiled
+ * afterwards.
+ *
+ * lima_shader_resume() loads a checkpoint into a new shader in place of
+ * lima_shader_parse() and lima_shader_optimize(), after which
+ * lima_shader_compile() only runs the backend, with the options set on the
+ * new shader. The stage and core must match the checkpoint, and the frontend
+ * passes run are whatever the optimization level was when the checkpoint was
+ * made. Like the cache, checkpoints only work with the compiler binary that
+ * made them. Checkpoints that are truncated, corrupted, or from another
+ * compiler are rejected with an error in the info log, like a compile error,
+ * and resumed shaders aren't cached.
+ */
+
+void* lima_shader_checkpoint(lima_shader_t* shader, unsigned* size);
+bool lima_shader_resume(lima_shader_t* shader, const void* data,
+						unsigned size);
+
+/*
+ * Disassembler, for code from lima_shader_get_code() or the online compiler.
+ * The text is handed to sink a chunk at a time, at least once per
+ * instruction, so it never has to be held in memory all at once. There's no
+ * global state, so any number of threads can disassemble at the same time.
+ * Fragment shaders don't support lima_asm_syntax_decompile. Returns false if
+ * the code is corrupt, the syntax isn't supported, or it ran out of memory,
+ * in which case some of the text may already have been passed to sink.
+ */
+
+typedef void (*lima_disasm_sink_t)(const char* text, unsigned size,
+								   void* data);
+
+bool lima_disassemble(lima_shader_stage_e stage, lima_asm_syntax_e syntax,
+					  const void* code, unsigned size,
+					  lima_disasm_sink_t sink, void* data);
+
+/* the same, but returns the whole text as a string allocated with malloc(),
+ * or NULL on failure
+ */
+
+char* lima_disassemble_string(lima_shader_stage_e stage,
+							  lima_asm_syntax_e syntax,
+							  const void* code, unsigned size);
+
+/*
+ * export to the MBS format used by the binary offline compiler. The chunk
+ * references the shader's code and symbols, so it must be deleted first.
+ */
 
 mbs_chunk_t* lima_shader_export_offline(lima_shader_t* shader);
 
+/*
+ * Online compilation, for drivers and other apps that compile shaders while
+ * they run. Results are memoized process-wide, keyed by the source, stage,
+ * and core, so asking for a shader that was already compiled (or is being
+ * compiled by another thread) doesn't compile it again. Shaders are compiled
+ * with the default options. Everything here may be called from any thread.
+ *
+ * A lima_online_shader_t is a reference to a result, which may still be
+ * pending if it came from lima_online_compile_async(), and must be released
+ * with lima_online_shader_release(). The getters wait for the result.
+ */
+
+struct lima_online_shader_s;
+typedef struct lima_online_shader_s lima_online_shader_t;
+
+/* compiles on the calling thread unless the result is already available or
+ * in progress, returns NULL if out of memory
+ */
+
+lima_online_shader_t* lima_online_compile(lima_compiler_t* compiler,
+										  lima_shader_stage_e stage,
+										  lima_core_e core,
+										  const char* source);
+
+void lima_online_shader_release(lima_online_shader_t* shader);
+
+bool lima_online_shader_is_done(lima_online_shader_t* shader);
+void lima_online_shader_wait(lima_online_shader_t* shader);
+
+/* whether there were compile errors, in which case there's no code */
+bool lima_online_shader_error(lima_online_shader_t* shader);
+const char* lima_online_shader_info_log(lima_online_shader_t* shader);
+
+const void* lima_online_shader_get_code(lima_online_shader_t* shader);
+unsigned lima_online_shader_get_code_size(lima_online_shader_t* shader);
+lima_shader_info_t lima_online_shader_get_info(lima_online_shader_t* shader);
+
+/*
+ * A pool of threads compiling shaders in the background, in the order they
+ * were queued. lima_online_compile() takes over a shader that is still
+ * waiting in a queue instead of waiting behind it. Deleting the queue
+ * finishes the shaders already queued, and must happen before the compiler
+ * is deleted.
+ */
+
+struct lima_online_queue_s;
+typedef struct lima_online_queue_s lima_online_queue_t;
+
+lima_online_queue_t* lima_online_queue_create(lima_compiler_t* compiler,
+											  unsigned num_threads);
+void lima_online_queue_delete(lima_online_queue_t* queue);
+
+/*
+ * Called once the shader is done, on the thread that compiled it, or right
+ * away on the calling thread if it already was. The shader is only
+ * guaranteed to stay alive during the callback if the caller still holds the
+ * reference returned by lima_online_compile_async().
+ */
+
+typedef void (*lima_online_callback_t)(lima_online_shader_t* shader,
+									   void* data);
+
+/* callback may be NULL, returns NULL if out of memory */
+
+lima_online_shader_t* lima_online_compile_async(lima_online_queue_t* queue,
+												lima_shader_stage_e stage,
+												lima_core_e core,
+												const char* source,
+												lima_online_callback_t callback,
+												void* data);
+
+/*
+ * Finished shaders are kept around for reuse until their code and source
+ * take up more than max_size bytes in total, after which the least recently
+ * used ones are dropped. Defaults to 16 MiB, and 0 turns off memoization of
+ * finished shaders.
+ */
+
+void lima_online_set_cache_size(unsigned long max_size);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,186 @@
+/* Author(s):
+ *   Connor Abbott
+ *
+ * Copyright (c) 2014 Connor Abbott (connor@abbott.cx)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "shader_internal.h"
+#include <stdint.h>
+
+/*
+ * A checkpoint is the shader right after it's lowered to the backend IR: a
+ * header, the version string of the compiler that made it, the packed symbol
+ * tables, and then either the PP HIR or the GP IR in their export formats.
+ * The importers trust the data they're given, so the header also has a
+ * checksum of everything after it, which is checked before importing.
+ */
+
+typedef struct {
+	char ident[4]; /* ="LCKP" */
+	uint32_t stage, core;
+	uint32_t version_size, symbols_size, ir_size;
+	uint64_t checksum;
+} checkpoint_header_t;
+
+/* 64-bit FNV-1a, which changes with any single changed byte */
+static uint64_t checksum(const void* data, unsigned size)
+{
+	const unsigned char* bytes = (const unsigned char*) data;
+	uint64_t hash = 0xcbf29ce484222325ull;
+	
+	for (unsigned i = 0; i < size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= 0x100000001b3ull;
+	}
+	
+	return hash;
+}
+
+void* lima_shader_checkpoint(lima_shader_t* shader, unsigned* size)
+{
+	if (!shader->parsed || shader->cached || shader->compiled)
+		return NULL;
+	
+	if (!shader->lowered)
+	{
+		lima_trace_begin(&shader->trace);
+		lima_shader_lower(shader);
+		lima_trace_end(&shader->trace);
+		if (shader->errors)
+			return NULL;
+	}
+	
+	unsigned symbols_size;
+	void* symbols = lima_shader_symbols_export(&shader->symbols, &symbols_size);
+	if (!symbols)
+		return NULL;
+	
+	unsigned ir_size;
+	void* ir;
+	if (shader->stage == lima_shader_stage_fragment)
+		ir = lima_pp_hir_prog_export(shader->ir.pp.hir_prog, &ir_size);
+	else
+		ir = lima_gp_ir_prog_export(shader->ir.gp.gp_prog, &ir_size);
+	if (!ir)
+	{
+		free(symbols);
+		return NULL;
+	}
+	
+	checkpoint_header_t header;
+	memcpy(header.ident, "LCKP", 4);
+	header.stage = shader->stage;
+	header.core = shader->core;
+	header.version_size = strlen(shader->compiler->version);
+	header.symbols_size = symbols_size;
+	header.ir_size = ir_size;
+	header.checksum = 0;
+	
+	*size = sizeof(header) + header.version_size + symbols_size + ir_size;
+	char* data = (char*) malloc(*size);
+	if (data)
+	{
+		char* pos = data + sizeof(header);
+		memcpy(pos, shader->compiler->version, header.version_size);
+		pos += header.version_size;
+		memcpy(pos, symbols, symbols_size);
+		pos += symbols_size;
+		memcpy(pos, ir, ir_size);
+		
+		header.checksum = checksum(data + sizeof(header),
+								   *size - sizeof(header));
+		memcpy(data, &header, sizeof(header));
+	}
+	
+	free(symbols);
+	free(ir);
+	return data;
+}
+
+static bool resume_error(lima_shader_t* shader, const char* error)
+{
+	shader->info_log = ralloc_asprintf(shader->mem_ctx, "Error: %s\n", error);
+	shader->errors = true;
+	return true;
+}
+
+bool lima_shader_resume(lima_shader_t* shader, const void* data, unsigned size)
+{
+	const char* pos = (const char*) data;
+	
+	checkpoint_header_t header;
+	if (size < sizeof(header))
+		return resume_error(shader, "invalid checkpoint");
+	
+	memcpy(&header, pos, sizeof(header));
+	pos += sizeof(header);
+	if (memcmp(header.ident, "LCKP", 4) != 0 ||
+		size - sizeof(header) != (uint64_t) header.version_size +
+			header.symbols_size + header.ir_size ||
+		header.checksum != checksum(pos, size - sizeof(header)))
+		return resume_error(shader, "invalid checkpoint");
+	
+	if (header.version_size != strlen(shader->compiler->version) ||
+		memcmp(pos, shader->compiler->version, header.version_size) != 0)
+		return resume_error(shader,
+							"checkpoint was made by a different compiler");
+	pos += header.version_size;
+	
+	if (header.stage != (uint32_t) shader->stage ||
+		header.core != (uint32_t) shader->core)
+		return resume_error(shader,
+							"checkpoint is for a different stage or core");
+	
+	if (!lima_shader_symbols_import(&shader->symbols, pos, header.symbols_size))
+	{
+		lima_shader_symbols_delete(&shader->symbols);
+		lima_shader_symbols_init(&shader->symbols);
+		return resume_error(shader, "invalid checkpoint");
+	}
+	pos += header.symbols_size;
+	
+	/* the importers don't modify the data, they just aren't const-correct */
+	void* ir = const_cast<char*>(pos);
+	if (shader->stage == lima_shader_stage_fragment)
+	{
+		shader->ir.pp.hir_prog = lima_pp_hir_prog_import(ir, header.ir_size);
+		if (!shader->ir.pp.hir_prog)
+			return resume_error(shader, "invalid checkpoint");
+	}
+	else
+	{
+		unsigned ir_size;
+		shader->ir.gp.gp_prog = lima_gp_ir_prog_import(ir, &ir_size);
+		if (!shader->ir.gp.gp_prog)
+			return resume_error(shader, "invalid checkpoint");
+		if (ir_size != header.ir_size)
+		{
+			lima_gp_ir_prog_delete(shader->ir.gp.gp_prog);
+			return resume_error(shader, "invalid checkpoint");
+		}
+	}
+	
+	shader->errors = false;
+	shader->parsed = true;
+	shader->lowered = true;
+	return true;
+}
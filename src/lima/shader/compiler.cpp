@@ -0,0 +1,123 @@
+/* Author(s):
+ *   Connor Abbott
+ *
+ * Copyright (c) 2014 Connor Abbott (connor@abbott.cx)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "shader_internal.h"
+#include "ir.h"
+#include <pthread.h>
+#include <dlfcn.h>
+#include <sys/stat.h>
+#include <stdio.h>
+
+/*
+ * The builtin function library and the glsl_type caches are process-wide in
+ * the GLSL frontend, so every compiler shares them. We build them when the
+ * first compiler is created, and only tear them down when the last one goes
+ * away.
+ */
+
+static unsigned num_compilers = 0;
+static pthread_mutex_t compilers_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/*
+ * There's no version number that changes whenever the output of the
+ * compiler might, so cached shaders are tied to the binary that compiled
+ * them instead, identified by its path, size, and modification time. The
+ * same goes for checkpoints.
+ */
+
+static char* compiler_version(void)
+{
+	char* version;
+	Dl_info dl_info;
+	struct stat st;
+	
+	if (dladdr((void*) lima_compiler_set_cache, &dl_info) &&
+		dl_info.dli_fname && stat(dl_info.dli_fname, &st) == 0)
+	{
+		if (asprintf(&version, "%s %lld %lld.%09ld", dl_info.dli_fname,
+					 (long long) st.st_size, (long long) st.st_mtim.tv_sec,
+					 st.st_mtim.tv_nsec) == -1)
+			return NULL;
+	}
+	else
+	{
+		if (asprintf(&version, "built %s %s", __DATE__, __TIME__) == -1)
+			return NULL;
+	}
+	
+	return version;
+}
+
+lima_compiler_t* lima_compiler_create(void)
+{
+	lima_compiler_t* compiler = (lima_compiler_t*) calloc(1, sizeof(lima_compiler_t));
+	if (!compiler)
+		return NULL;
+	
+	compiler->num_shaders = 0;
+	compiler->cache = NULL;
+	compiler->version = compiler_version();
+	if (!compiler->version)
+	{
+		free(compiler);
+		return NULL;
+	}
+	
+	pthread_mutex_lock(&compilers_lock);
+	if (num_compilers++ == 0)
+		_mesa_glsl_initialize_builtin_functions();
+	pthread_mutex_unlock(&compilers_lock);
+	
+	return compiler;
+}
+
+void lima_compiler_delete(lima_compiler_t* compiler)
+{
+	assert(compiler->num_shaders == 0);
+	
+	pthread_mutex_lock(&compilers_lock);
+	if (--num_compilers == 0)
+		_mesa_destroy_shader_compiler();
+	pthread_mutex_unlock(&compilers_lock);
+	
+	if (compiler->cache)
+		lima_cache_close(compiler->cache);
+	free(compiler->version);
+	free(compiler);
+}
+
+bool lima_compiler_set_cache(lima_compiler_t* compiler, const char* path,
+							 unsigned long max_size)
+{
+	assert(compiler->num_shaders == 0);
+	
+	lima_cache_t* cache = lima_cache_open(path, max_size);
+	if (!cache)
+		return false;
+	
+	if (compiler->cache)
+		lima_cache_close(compiler->cache);
+	compiler->cache = cache;
+	return true;
+}
@@ -0,0 +1,86 @@
+/* Author(s):
+ *   Connor Abbott
+ *
+ * Copyright (c) 2014 Connor Abbott (connor@abbott.cx)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include "shader.h"
+#include "pp/lima_pp.h"
+#include "gp/lima_gp.h"
+#include "string_buf.h"
+
+static bool disassemble(string_buf_t* buf, lima_shader_stage_e stage,
+						lima_asm_syntax_e syntax, const void* code,
+						unsigned size)
+{
+	switch (stage)
+	{
+		case lima_shader_stage_vertex:
+			return lima_gp_disassemble(buf, code, size, syntax, 0);
+			
+		case lima_shader_stage_fragment:
+			switch (syntax)
+			{
+				case lima_asm_syntax_explicit:
+					return lima_pp_disassemble(buf, code, size, true, 0);
+				case lima_asm_syntax_verbose:
+					return lima_pp_disassemble(buf, code, size, false, 0);
+				default:
+					return false;
+			}
+			
+		default:
+			return false;
+	}
+}
+
+bool lima_disassemble(lima_shader_stage_e stage, lima_asm_syntax_e syntax,
+					  const void* code, unsigned size,
+					  lima_disasm_sink_t sink, void* data)
+{
+	string_buf_t buf;
+	if (!string_buf_init(&buf, sink, data))
+		return false;
+	
+	bool ret = disassemble(&buf, stage, syntax, code, size);
+	string_buf_flush(&buf);
+	ret = ret && !buf.error;
+	string_buf_delete(&buf);
+	return ret;
+}
+
+char* lima_disassemble_string(lima_shader_stage_e stage,
+							  lima_asm_syntax_e syntax,
+							  const void* code, unsigned size)
+{
+	string_buf_t buf;
+	if (!string_buf_init(&buf, NULL, NULL))
+		return NULL;
+	
+	if (!disassemble(&buf, stage, syntax, code, size) || buf.error)
+	{
+		string_buf_delete(&buf);
+		return NULL;
+	}
+	
+	return buf.data;
+}
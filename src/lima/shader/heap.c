@@ -0,0 +1,127 @@
+/* Author(s):
+ *   Connor Abbott
+ *
+ * Copyright (c) 2014 Connor Abbott (connor@abbott.cx)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#define _GNU_SOURCE
+#include "heap.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static __thread lima_heap_counter_t* cur_counter;
+
+void lima_heap_set_counter(lima_heap_counter_t* counter)
+{
+	cur_counter = counter;
+}
+
+#ifdef LIMA_COUNT_HEAP
+
+#include <malloc.h>
+
+/*
+ * The linker points the library's calls to these functions at the __wrap_
+ * versions, and __real_ at the C library's. Sizes are what the allocator
+ * actually handed out, so that frees balance the allocations exactly.
+ */
+
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t num, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+void __real_free(void* ptr);
+char* __real_strdup(const char* str);
+
+static void count_alloc(void* ptr)
+{
+	lima_heap_counter_t* counter = cur_counter;
+	if (!counter || !ptr)
+		return;
+	
+	counter->in_use += malloc_usable_size(ptr);
+	if (counter->in_use > counter->peak)
+		counter->peak = counter->in_use;
+}
+
+static void count_free(void* ptr)
+{
+	lima_heap_counter_t* counter = cur_counter;
+	if (!counter || !ptr)
+		return;
+	
+	counter->in_use -= malloc_usable_size(ptr);
+}
+
+void* __wrap_malloc(size_t size)
+{
+	void* ret = __real_malloc(size);
+	count_alloc(ret);
+	return ret;
+}
+
+void* __wrap_calloc(size_t num, size_t size)
+{
+	void* ret = __real_calloc(num, size);
+	count_alloc(ret);
+	return ret;
+}
+
+void* __wrap_realloc(void* ptr, size_t size)
+{
+	size_t old_size = 0;
+	if (cur_counter && ptr)
+		old_size = malloc_usable_size(ptr);
+	
+	void* ret = __real_realloc(ptr, size);
+	if (ptr && (ret || size == 0) && cur_counter)
+		cur_counter->in_use -= old_size;
+	count_alloc(ret);
+	return ret;
+}
+
+void __wrap_free(void* ptr)
+{
+	count_free(ptr);
+	__real_free(ptr);
+}
+
+char* __wrap_strdup(const char* str)
+{
+	char* ret = __real_strdup(str);
+	count_alloc(ret);
+	return ret;
+}
+
+int __wrap_asprintf(char** str, const char* format, ...)
+{
+	va_list args;
+	va_start(args, format);
+	int ret = vasprintf(str, format, args);
+	va_end(args);
+	
+	if (ret >= 0)
+		count_alloc(*str);
+	return ret;
+}
+
+#endif
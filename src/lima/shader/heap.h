@@ -0,0 +1,55 @@
+/* Author(s):
+ *   Connor Abbott
+ *
+ * Copyright (c) 2014 Connor Abbott (connor@abbott.cx)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef __HEAP_H__
+#define __HEAP_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Counts the heap memory allocated by the compiler, for the per-pass stats.
+ *
+ * When the library is linked with the malloc family wrapped (see the
+ * Makefile), every allocation and free made by the calling thread while a
+ * counter is set is added to it, so the counter sees the high-water mark
+ * inside a pass and not just the usage between passes. Only the thread
+ * that set the counter is counted, so shaders compiled on other threads
+ * don't show up in it. Memory allocated by the C++ runtime isn't seen.
+ */
+
+typedef struct
+{
+	long in_use; /* bytes allocated minus bytes freed since it was set */
+	long peak; /* the highest in_use has been */
+} lima_heap_counter_t;
+
+/* starts counting this thread's allocations in counter, or stops if NULL */
+void lima_heap_set_counter(lima_heap_counter_t* counter);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,514 @@
+/* Author(s):
+ *   Connor Abbott
+ *
+ * Copyright (c) 2014 Connor Abbott (connor@abbott.cx)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "shader.h"
+#include "list.h"
+#include "main/hash_table.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * All the state here is protected by a single lock, which is only held while
+ * looking shaders up and moving them around, never while compiling.
+ *
+ * A shader is in the memo table from when it's first asked for until it gets
+ * evicted, so that asking for a shader that's still being compiled finds it.
+ * While it's waiting for a worker it's in the pending list of a queue, and
+ * once it's done it's in the LRU list. The table holds a reference, as does
+ * every handle given out and the worker compiling it.
+ */
+
+typedef struct waiter_s {
+	lima_online_callback_t callback;
+	void* data;
+	struct waiter_s* next;
+} waiter_t;
+
+struct lima_online_shader_s {
+	lima_shader_stage_e stage;
+	lima_core_e core;
+	char* source;
+	uint32_t hash;
+	
+	unsigned refs;
+	bool in_memo;
+	bool started, done;
+	waiter_t* waiters; /* callbacks to call once it's done */
+	
+	struct list link; /* in a queue's pending list, or the LRU list */
+	unsigned long size; /* how much it counts against the memo size */
+	
+	/* the result, which doesn't change once done is set */
+	bool error, out_of_memory;
+	char* info_log;
+	void* code;
+	unsigned code_size;
+	lima_shader_info_t info;
+};
+
+struct lima_online_queue_s {
+	lima_compiler_t* compiler;
+	struct list pending; /* newest first */
+	pthread_cond_t cond;
+	bool quit;
+	
+	unsigned num_threads;
+	pthread_t* threads;
+};
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t done_cond = PTHREAD_COND_INITIALIZER;
+
+static struct hash_table* memo = NULL;
+static LIST_HEAD(lru); /* most recently used first */
+static unsigned long memo_size = 0, memo_max_size = 16 << 20;
+
+static bool key_equal(const void* _a, const void* _b)
+{
+	const lima_online_shader_t* a = _a, *b = _b;
+	return a->stage == b->stage && a->core == b->core &&
+		strcmp(a->source, b->source) == 0;
+}
+
+static void free_shader(lima_online_shader_t* shader)
+{
+	free(shader->source);
+	free(shader->info_log);
+	free(shader->code);
+	free(shader);
+}
+
+static void memo_remove(lima_online_shader_t* shader)
+{
+	struct hash_entry* entry = _mesa_hash_table_search(memo, shader->hash,
+													   shader);
+	_mesa_hash_table_remove(memo, entry);
+	shader->in_memo = false;
+	
+	list_del(&shader->link);
+	memo_size -= shader->size;
+	
+	if (--shader->refs == 0)
+		free_shader(shader);
+}
+
+static void evict(void)
+{
+	while (memo_size > memo_max_size && !list_is_empty(&lru))
+		memo_remove(list_entry(lru.prev, lima_online_shader_t, link));
+}
+
+/* finds or creates the memo entry for a shader, with the lock held */
+
+static lima_online_shader_t* lookup(lima_shader_stage_e stage,
+									lima_core_e core, const char* source,
+									bool* created)
+{
+	if (!memo)
+	{
+		memo = _mesa_hash_table_create(NULL, key_equal);
+		if (!memo)
+			return NULL;
+	}
+	
+	lima_online_shader_t key;
+	memset(&key, 0, sizeof(key));
+	key.stage = stage;
+	key.core = core;
+	key.source = (char*) source;
+	key.hash = _mesa_hash_string(source) ^ (2 * stage + core);
+	
+	struct hash_entry* entry = _mesa_hash_table_search(memo, key.hash, &key);
+	if (entry)
+	{
+		lima_online_shader_t* shader = entry->data;
+		shader->refs++;
+		if (shader->done)
+		{
+			list_del(&shader->link);
+			list_add(&shader->link, &lru);
+		}
+		*created = false;
+		return shader;
+	}
+	
+	lima_online_shader_t* shader = calloc(1, sizeof(lima_online_shader_t));
+	if (!shader)
+		return NULL;
+	
+	*shader = key;
+	shader->source = strdup(source);
+	if (!shader->source)
+	{
+		free(shader);
+		return NULL;
+	}
+	
+	shader->refs = 2;
+	shader->in_memo = true;
+	shader->started = false;
+	shader->done = false;
+	shader->waiters = NULL;
+	list_init(&shader->link);
+	
+	if (!_mesa_hash_table_insert(memo, shader->hash, shader, shader))
+	{
+		free_shader(shader);
+		return NULL;
+	}
+	
+	*created = true;
+	return shader;
+}
+
+/* runs without the lock held */
+
+static void compile_shader(lima_compiler_t* compiler,
+						   lima_online_shader_t* online)
+{
+	lima_shader_t* shader = lima_shader_create(compiler, online->stage,
+											   online->core);
+	if (!shader)
+		goto err_mem;
+	
+	if (!lima_shader_parse(shader, online->source))
+		goto err_mem2;
+	
+	if (!lima_shader_error(shader))
+	{
+		lima_shader_optimize(shader);
+		if (!lima_shader_compile(shader, false))
+			goto err_mem2;
+	}
+	
+	if (lima_shader_error(shader))
+	{
+		const char* info_log = lima_shader_info_log(shader);
+		online->error = true;
+		online->info_log = strdup(info_log ? info_log : "");
+		if (!online->info_log)
+			goto err_mem2;
+	}
+	else
+	{
+		online->code_size = lima_shader_get_code_size(shader);
+		online->code = malloc(online->code_size);
+		if (!online->code)
+			goto err_mem2;
+		memcpy(online->code, lima_shader_get_code(shader), online->code_size);
+		online->info = lima_shader_get_info(shader);
+	}
+	
+	lima_shader_delete(shader);
+	return;
+	
+	err_mem2:
+	lima_shader_delete(shader);
+	err_mem:
+	online->error = true;
+	online->out_of_memory = true;
+}
+
+/* publishes the result and calls the callbacks, without the lock held */
+
+static void finish_shader(lima_online_shader_t* shader)
+{
+	pthread_mutex_lock(&lock);
+	
+	shader->done = true;
+	waiter_t* waiters = shader->waiters;
+	shader->waiters = NULL;
+	
+	if (shader->in_memo)
+	{
+		//Running out of memory isn't worth remembering
+		if (shader->out_of_memory)
+			memo_remove(shader);
+		else
+		{
+			shader->size = strlen(shader->source) + 1 + shader->code_size;
+			if (shader->info_log)
+				shader->size += strlen(shader->info_log) + 1;
+			
+			list_add(&shader->link, &lru);
+			memo_size += shader->size;
+			evict();
+		}
+	}
+	
+	pthread_cond_broadcast(&done_cond);
+	pthread_mutex_unlock(&lock);
+	
+	while (waiters)
+	{
+		waiter_t* next = waiters->next;
+		waiters->callback(shader, waiters->data);
+		free(waiters);
+		waiters = next;
+	}
+}
+
+lima_online_shader_t* lima_online_compile(lima_compiler_t* compiler,
+										  lima_shader_stage_e stage,
+										  lima_core_e core,
+										  const char* source)
+{
+	pthread_mutex_lock(&lock);
+	
+	bool created;
+	lima_online_shader_t* shader = lookup(stage, core, source, &created);
+	if (!shader)
+	{
+		pthread_mutex_unlock(&lock);
+		return NULL;
+	}
+	
+	if (!shader->started)
+	{
+		//Take it out of whichever queue it's waiting in, if any
+		shader->started = true;
+		list_del(&shader->link);
+		pthread_mutex_unlock(&lock);
+		
+		compile_shader(compiler, shader);
+		finish_shader(shader);
+		return shader;
+	}
+	
+	while (!shader->done)
+		pthread_cond_wait(&done_cond, &lock);
+	
+	pthread_mutex_unlock(&lock);
+	return shader;
+}
+
+void lima_online_shader_release(lima_online_shader_t* shader)
+{
+	pthread_mutex_lock(&lock);
+	bool last = --shader->refs == 0;
+	pthread_mutex_unlock(&lock);
+	
+	if (last)
+		free_shader(shader);
+}
+
+bool lima_online_shader_is_done(lima_online_shader_t* shader)
+{
+	pthread_mutex_lock(&lock);
+	bool done = shader->done;
+	pthread_mutex_unlock(&lock);
+	return done;
+}
+
+void lima_online_shader_wait(lima_online_shader_t* shader)
+{
+	pthread_mutex_lock(&lock);
+	while (!shader->done)
+		pthread_cond_wait(&done_cond, &lock);
+	pthread_mutex_unlock(&lock);
+}
+
+bool lima_online_shader_error(lima_online_shader_t* shader)
+{
+	lima_online_shader_wait(shader);
+	return shader->error;
+}
+
+const char* lima_online_shader_info_log(lima_online_shader_t* shader)
+{
+	lima_online_shader_wait(shader);
+	if (shader->out_of_memory)
+		return "Error: out of memory\n";
+	return shader->info_log ? shader->info_log : "";
+}
+
+const void* lima_online_shader_get_code(lima_online_shader_t* shader)
+{
+	lima_online_shader_wait(shader);
+	return shader->code;
+}
+
+unsigned lima_online_shader_get_code_size(lima_online_shader_t* shader)
+{
+	lima_online_shader_wait(shader);
+	return shader->code_size;
+}
+
+lima_shader_info_t lima_online_shader_get_info(lima_online_shader_t* shader)
+{
+	lima_online_shader_wait(shader);
+	return shader->info;
+}
+
+static void* worker(void* data)
+{
+	lima_online_queue_t* queue = data;
+	
+	pthread_mutex_lock(&lock);
+	while (true)
+	{
+		while (list_is_empty(&queue->pending) && !queue->quit)
+			pthread_cond_wait(&queue->cond, &lock);
+		
+		if (list_is_empty(&queue->pending))
+			break;
+		
+		lima_online_shader_t* shader =
+			list_entry(queue->pending.prev, lima_online_shader_t, link);
+		list_del(&shader->link);
+		shader->started = true;
+		shader->refs++;
+		pthread_mutex_unlock(&lock);
+		
+		compile_shader(queue->compiler, shader);
+		finish_shader(shader);
+		lima_online_shader_release(shader);
+		
+		pthread_mutex_lock(&lock);
+	}
+	pthread_mutex_unlock(&lock);
+	
+	return NULL;
+}
+
+static void stop_workers(lima_online_queue_t* queue, unsigned num_threads)
+{
+	pthread_mutex_lock(&lock);
+	queue->quit = true;
+	pthread_cond_broadcast(&queue->cond);
+	pthread_mutex_unlock(&lock);
+	
+	unsigned i;
+	for (i = 0; i < num_threads; i++)
+		pthread_join(queue->threads[i], NULL);
+}
+
+lima_online_queue_t* lima_online_queue_create(lima_compiler_t* compiler,
+											  unsigned num_threads)
+{
+	lima_online_queue_t* queue = calloc(1, sizeof(lima_online_queue_t));
+	if (!queue)
+		return NULL;
+	
+	queue->threads = malloc(num_threads * sizeof(pthread_t));
+	if (!queue->threads)
+	{
+		free(queue);
+		return NULL;
+	}
+	
+	queue->compiler = compiler;
+	list_init(&queue->pending);
+	pthread_cond_init(&queue->cond, NULL);
+	queue->quit = false;
+	queue->num_threads = num_threads;
+	
+	unsigned i;
+	for (i = 0; i < num_threads; i++)
+	{
+		if (pthread_create(&queue->threads[i], NULL, worker, queue) != 0)
+		{
+			stop_workers(queue, i);
+			pthread_cond_destroy(&queue->cond);
+			free(queue->threads);
+			free(queue);
+			return NULL;
+		}
+	}
+	
+	return queue;
+}
+
+void lima_online_queue_delete(lima_online_queue_t* queue)
+{
+	stop_workers(queue, queue->num_threads);
+	pthread_cond_destroy(&queue->cond);
+	free(queue->threads);
+	free(queue);
+}
+
+lima_online_shader_t* lima_online_compile_async(lima_online_queue_t* queue,
+												lima_shader_stage_e stage,
+												lima_core_e core,
+												const char* source,
+												lima_online_callback_t callback,
+												void* data)
+{
+	waiter_t* waiter = NULL;
+	if (callback)
+	{
+		waiter = malloc(sizeof(waiter_t));
+		if (!waiter)
+			return NULL;
+		waiter->callback = callback;
+		waiter->data = data;
+	}
+	
+	pthread_mutex_lock(&lock);
+	
+	bool created;
+	lima_online_shader_t* shader = lookup(stage, core, source, &created);
+	if (!shader)
+	{
+		pthread_mutex_unlock(&lock);
+		free(waiter);
+		return NULL;
+	}
+	
+	if (shader->done)
+	{
+		pthread_mutex_unlock(&lock);
+		if (waiter)
+		{
+			callback(shader, data);
+			free(waiter);
+		}
+		return shader;
+	}
+	
+	if (waiter)
+	{
+		waiter->next = shader->waiters;
+		shader->waiters = waiter;
+	}
+	
+	//Otherwise, it's already waiting in a queue or being compiled
+	if (created)
+	{
+		list_add(&shader->link, &queue->pending);
+		pthread_cond_signal(&queue->cond);
+	}
+	
+	pthread_mutex_unlock(&lock);
+	return shader;
+}
+
+void lima_online_set_cache_size(unsigned long max_size)
+{
+	pthread_mutex_lock(&lock);
+	memo_max_size = max_size;
+	evict();
+	pthread_mutex_unlock(&lock);
+}
@@ -46,7 +46,8 @@ static void DeleteShader(struct gl_context *ctx, struct gl_shader *shader)
 	ralloc_free(shader);
 }
 
-lima_shader_t* lima_shader_create(lima_shader_stage_e stage, lima_core_e core)
+lima_shader_t* lima_shader_create(lima_compiler_t* compiler,
+								  lima_shader_stage_e stage, lima_core_e core)
 {
 	lima_shader_t* shader = (lima_shader_t*) calloc(1, sizeof(lima_shader_t));
 	if (!shader)
@@ -55,13 +56,22 @@ lima_shader_t* lima_shader_create(lima_shader_stage_e stage, lima_core_e core)
 	if (!lima_shader_symbols_init(&shader->symbols))
 		goto err_mem;
 	
+	shader->compiler = compiler;
 	shader->stage = stage;
 	shader->core = core;
+	shader->regalloc = lima_regalloc_graph;
+	shader->opt_level = lima_opt_level_2;
 	shader->parsed = false;
+	shader->lowered = false;
 	shader->compiled = false;
 	shader->info_log = NULL;
 	shader->code = NULL;
 	shader->code_size = 0;
+	shader->cache_key = NULL;
+	shader->cache_key_size = 0;
+	shader->cached = false;
+	shader->stats = NULL;
+	lima_trace_init(&shader->trace, 0, NULL, NULL);
 	
 	initialize_context_to_defaults(&shader->mesa_ctx, API_OPENGLES2);
 	shader->mesa_ctx.Const.GLSLVersion = 100;
@@ -119,6 +129,8 @@ lima_shader_t* lima_shader_create(lima_shader_stage_e stage, lima_core_e core)
 	
 	shader->whole_program->LinkStatus = true;
 	
+	__sync_fetch_and_add(&compiler->num_shaders, 1);
+	
 	return shader;
 	
 	err_mem2:
@@ -134,17 +146,35 @@ lima_shader_t* lima_shader_create(lima_shader_stage_e stage, lima_core_e core)
 
 void lima_shader_delete(lima_shader_t* shader)
 {
+	/* checkpointed or resumed, but never compiled */
+	if (shader->lowered && !shader->compiled)
+	{
+		if (shader->stage == lima_shader_stage_fragment)
+			lima_pp_hir_prog_delete(shader->ir.pp.hir_prog);
+		else
+			lima_gp_ir_prog_delete(shader->ir.gp.gp_prog);
+	}
+	
 	for (unsigned i = 0; i < MESA_SHADER_STAGES; i++)
 		ralloc_free(shader->whole_program->_LinkedShaders[i]);
 	ralloc_free(shader->linked_shader);
 	ralloc_free(shader->mem_ctx);
 	lima_shader_symbols_delete(&shader->symbols);
+	__sync_fetch_and_sub(&shader->compiler->num_shaders, 1);
 	free(shader);
-	_mesa_destroy_shader_compiler();
 }
 
 bool lima_shader_parse(lima_shader_t* shader, const char* source)
 {
+	if (lima_shader_cache_load(shader, source))
+	{
+		shader->cached = true;
+		shader->parsed = true;
+		shader->compiled = true;
+		shader->errors = false;
+		return true;
+	}
+	
 	shader->state = new(shader->mem_ctx)
 		_mesa_glsl_parse_state(&shader->mesa_ctx, shader->shader->Stage,
 							   shader->mem_ctx);
@@ -154,10 +184,11 @@ bool lima_shader_parse(lima_shader_t* shader, const char* source)
 	
 	shader->errors = false;
 	
-	shader->state->error = glcpp_preprocess(shader->mem_ctx, &source,
-											&shader->state->info_log,
-											shader->state->extensions,
-											&shader->mesa_ctx);
+	LIMA_PASS(shader, "glcpp_preprocess", lima_ir_none,
+		shader->state->error = glcpp_preprocess(shader->mem_ctx, &source,
+												&shader->state->info_log,
+												shader->state->extensions,
+												&shader->mesa_ctx));
 	if (shader->state->error)
 	{
 		shader->errors = true;
@@ -165,9 +196,10 @@ bool lima_shader_parse(lima_shader_t* shader, const char* source)
 		return true;
 	}
 	
-	_mesa_glsl_lexer_ctor(shader->state, source);
-	_mesa_glsl_parse(shader->state);
-	_mesa_glsl_lexer_dtor(shader->state);
+	LIMA_PASS(shader, "_mesa_glsl_parse", lima_ir_none,
+		_mesa_glsl_lexer_ctor(shader->state, source);
+		_mesa_glsl_parse(shader->state);
+		_mesa_glsl_lexer_dtor(shader->state));
 	
 	if (shader->state->error)
 	{
@@ -182,7 +214,8 @@ bool lima_shader_parse(lima_shader_t* shader, const char* source)
 	
 	shader->shader->ir = ir;
 	
-	_mesa_ast_to_hir(ir, shader->state);
+	LIMA_LOWERING_PASS(shader, "_mesa_ast_to_hir", lima_ir_none, lima_ir_glsl,
+		_mesa_ast_to_hir(ir, shader->state));
 	if (shader->state->error)
 	{
 		shader->errors = true;
@@ -195,11 +228,13 @@ bool lima_shader_parse(lima_shader_t* shader, const char* source)
 	shader->shader->symbols = shader->state->symbols;
 	shader->shader->uses_builtin_functions = shader->state->uses_builtin_functions;
 	
-	shader->linked_shader = link_intrastage_shaders(shader->mem_ctx,
-													&shader->mesa_ctx,
-													shader->whole_program,
-													shader->whole_program->Shaders,
-													shader->whole_program->NumShaders);
+	LIMA_PASS(shader, "link_intrastage_shaders", lima_ir_glsl,
+		shader->linked_shader =
+			link_intrastage_shaders(shader->mem_ctx,
+									&shader->mesa_ctx,
+									shader->whole_program,
+									shader->whole_program->Shaders,
+									shader->whole_program->NumShaders));
 	
 	if (!shader->linked_shader)
 	{
@@ -209,23 +244,28 @@ bool lima_shader_parse(lima_shader_t* shader, const char* source)
 	}
 	
 	/* lower things we can't support before we optimize or lower to gp_ir or pp_hir */
-	do_mat_op_to_vec(shader->linked_shader->ir);
-	lower_instructions(shader->linked_shader->ir,
-					   DIV_TO_MUL_RCP |
-					   EXP_TO_EXP2 |
-					   LOG_TO_LOG2 |
-					   POW_TO_EXP2 |
-					   INT_DIV_TO_MUL_RCP);
-	do_vec_index_to_cond_assign(shader->linked_shader->ir);
-	lower_vector_insert(shader->linked_shader->ir, true);
+	LIMA_PASS(shader, "do_mat_op_to_vec", lima_ir_glsl,
+		do_mat_op_to_vec(shader->linked_shader->ir));
+	LIMA_PASS(shader, "lower_instructions", lima_ir_glsl,
+		lower_instructions(shader->linked_shader->ir,
+						   DIV_TO_MUL_RCP |
+						   EXP_TO_EXP2 |
+						   LOG_TO_LOG2 |
+						   POW_TO_EXP2 |
+						   INT_DIV_TO_MUL_RCP));
+	LIMA_PASS(shader, "do_vec_index_to_cond_assign", lima_ir_glsl,
+		do_vec_index_to_cond_assign(shader->linked_shader->ir));
+	LIMA_PASS(shader, "lower_vector_insert", lima_ir_glsl,
+		lower_vector_insert(shader->linked_shader->ir, true));
 	
 	/* vertex shaders can't write to a varying or read from an attribute with
 	 * a nonconstant index
 	 */
 	if (shader->stage == lima_shader_stage_vertex)
 	{
-		lower_variable_index_to_cond_assign(shader->linked_shader->ir,
-											true, true, false, false);
+		LIMA_PASS(shader, "lower_variable_index_to_cond_assign", lima_ir_glsl,
+			lower_variable_index_to_cond_assign(shader->linked_shader->ir,
+												true, true, false, false));
 	}
 	
 	validate_ir_tree(shader->linked_shader->ir);
@@ -234,20 +274,53 @@ bool lima_shader_parse(lima_shader_t* shader, const char* source)
 	return true;
 }
 
+/*
+ * The optional passes run at each optimization level; the rest are needed to
+ * get correct code and always run. glsl_iterations bounds the GLSL
+ * optimization loop, which otherwise stops once it doesn't make any progress.
+ * Inlining and jump lowering happen in the loop, so it always runs once.
+ */
+
+struct opt_level_passes {
+	unsigned glsl_iterations;
+	bool pp_hir_opt; /* copy propagation and constant folding */
+	bool pp_lir_peephole;
+	bool pp_lir_reg_pressure_schedule;
+	bool pp_lir_combine_schedule;
+	bool pp_lir_smallest; /* try with and without reg_pressure_schedule */
+	bool gp_if_convert;
+	bool gp_const_fold;
+};
+
+static const struct opt_level_passes opt_levels[] = {
+	/* -O0 */ { 1, false, false, false, false, false, false, false },
+	/* -O1 */ { 2, true, false, false, true, false, true, true },
+	/* -O2 */ { 16, true, true, true, true, false, true, true },
+	/* -Os */ { 16, true, true, true, true, true, true, true },
+};
+
+static const struct opt_level_passes* get_passes(lima_shader_t* shader)
+{
+	return &opt_levels[shader->opt_level];
+}
+
 void lima_shader_optimize(lima_shader_t* shader)
 {
-	if (!shader->parsed)
+	if (!shader->parsed || shader->cached || shader->lowered)
 		return;
 	
 	gl_shader_stage stage = shader->linked_shader->Stage;
 	exec_list* ir = shader->linked_shader->ir;
 	bool progress = true;
 	
-	while (progress)
+	for (unsigned i = 0; progress && i < get_passes(shader)->glsl_iterations;
+		 i++)
 	{
-		progress = do_common_optimization(ir, true, false, 0,
-										  &shader->mesa_ctx.ShaderCompilerOptions[stage]);
-		progress = do_lower_jumps(ir, true, true, false, false, false) || progress;
+		LIMA_PASS(shader, "do_common_optimization", lima_ir_glsl,
+			progress = do_common_optimization(ir, true, false, 0,
+											  &shader->mesa_ctx.ShaderCompilerOptions[stage]));
+		LIMA_PASS(shader, "do_lower_jumps", lima_ir_glsl,
+			progress = do_lower_jumps(ir, true, true, false, false, false) || progress);
 	}
 	
 	validate_ir_tree(shader->linked_shader->ir);
@@ -255,75 +328,179 @@ void lima_shader_optimize(lima_shader_t* shader)
 
 /* driver for the PP backend */
 
+/* optimization, register allocation, and scheduling for PP LIR */
+
+static void compile_pp_lir(lima_shader_t* shader,
+						   const struct opt_level_passes* passes,
+						   bool reg_pressure_schedule)
+{
+	if (passes->pp_lir_peephole || reg_pressure_schedule)
+	{
+		LIMA_PASS(shader, "lima_pp_lir_calc_dep_info", lima_ir_pp_lir,
+			lima_pp_lir_calc_dep_info(shader->ir.pp.lir_prog));
+		
+		if (passes->pp_lir_peephole)
+			LIMA_PASS(shader, "lima_pp_lir_peephole", lima_ir_pp_lir,
+				lima_pp_lir_peephole(shader->ir.pp.lir_prog));
+		
+		if (reg_pressure_schedule)
+			LIMA_PASS(shader, "lima_pp_lir_reg_pressure_schedule_prog",
+				lima_ir_pp_lir,
+				lima_pp_lir_reg_pressure_schedule_prog(shader->ir.pp.lir_prog));
+		
+		lima_pp_lir_delete_dep_info(shader->ir.pp.lir_prog);
+	}
+	
+	if (shader->regalloc == lima_regalloc_linear_scan)
+		LIMA_PASS(shader, "lima_pp_lir_regalloc_linear_scan", lima_ir_pp_lir,
+			lima_pp_lir_regalloc_linear_scan(shader->ir.pp.lir_prog));
+	else
+		LIMA_PASS(shader, "lima_pp_lir_regalloc", lima_ir_pp_lir,
+			lima_pp_lir_regalloc(shader->ir.pp.lir_prog));
+	
+	if (passes->pp_lir_combine_schedule)
+	{
+		LIMA_PASS(shader, "lima_pp_lir_calc_dep_info", lima_ir_pp_lir,
+			lima_pp_lir_calc_dep_info(shader->ir.pp.lir_prog));
+		
+		LIMA_PASS(shader, "lima_pp_lir_combine_schedule_prog", lima_ir_pp_lir,
+			lima_pp_lir_combine_schedule_prog(shader->ir.pp.lir_prog));
+		
+		lima_pp_lir_delete_dep_info(shader->ir.pp.lir_prog);
+	}
+	
+	if (shader->stats)
+		shader->stats->stats.spill_iterations +=
+			shader->ir.pp.lir_prog->spill_iterations;
+}
+
 static void compile_pp_shader(lima_shader_t* shader, bool dump_ir)
 {
+	const struct opt_level_passes* passes = get_passes(shader);
+	
 	if (dump_ir)
 	{
 		printf("PP HIR (before optimization & lowering):\n\n");
-		lima_pp_hir_prog_print(shader->ir.pp.hir_prog);
+		lima_pp_hir_prog_print(shader->ir.pp.hir_prog, stdout);
 	}
 	
 	lima_pp_hir_prog_validate(shader->ir.pp.hir_prog);
 	
-	lima_pp_hir_dead_code_eliminate(shader->ir.pp.hir_prog);
-	
-	lima_pp_hir_prog_print(shader->ir.pp.hir_prog);
+	LIMA_PASS(shader, "lima_pp_hir_dead_code_eliminate", lima_ir_pp_hir,
+		lima_pp_hir_dead_code_eliminate(shader->ir.pp.hir_prog));
 	
-	lima_pp_hir_propagate_copies(shader->ir.pp.hir_prog);
+	if (lima_trace_enabled(lima_trace_ir))
+		lima_pp_hir_prog_print(shader->ir.pp.hir_prog,
+							   lima_trace_file(lima_trace_ir));
 	
-	lima_pp_hir_prog_cfold(shader->ir.pp.hir_prog);
+	if (passes->pp_hir_opt)
+	{
+		LIMA_PASS(shader, "lima_pp_hir_propagate_copies", lima_ir_pp_hir,
+			lima_pp_hir_propagate_copies(shader->ir.pp.hir_prog));
+		
+		LIMA_PASS(shader, "lima_pp_hir_prog_cfold", lima_ir_pp_hir,
+			lima_pp_hir_prog_cfold(shader->ir.pp.hir_prog));
+	}
 	
-	unsigned c;
-	do
+	bool lowered;
+	LIMA_PASS(shader, "lima_pp_hir_prog_xform", lima_ir_pp_hir,
+		lowered = lima_pp_hir_prog_xform(shader->ir.pp.hir_prog));
+	if (!lowered)
 	{
-		c = lima_pp_hir_prog_xform(shader->ir.pp.hir_prog);
-	} while (c != 0);
+		ralloc_asprintf_append(&shader->info_log,
+							   "Error: ran out of memory lowering the shader.\n");
+		shader->errors = true;
+		/* still lowered but not compiled, so lima_shader_delete() frees it */
+		return;
+	}
 	
-	lima_pp_hir_split_crit_edges(shader->ir.pp.hir_prog);
+	LIMA_PASS(shader, "lima_pp_hir_split_crit_edges", lima_ir_pp_hir,
+		lima_pp_hir_split_crit_edges(shader->ir.pp.hir_prog));
 	
-	lima_pp_hir_prog_reorder(shader->ir.pp.hir_prog);
+	LIMA_PASS(shader, "lima_pp_hir_prog_reorder", lima_ir_pp_hir,
+		lima_pp_hir_prog_reorder(shader->ir.pp.hir_prog));
 	
 	if (dump_ir)
 	{
 		printf("PP HIR (after optimization & lowering):\n\n");
-		lima_pp_hir_prog_print(shader->ir.pp.hir_prog);
+		lima_pp_hir_prog_print(shader->ir.pp.hir_prog, stdout);
 	}
 	
 	fill_fs_info(shader->ir.pp.hir_prog, &shader->info);
 	
-	lima_pp_hir_convert_to_cssa(shader->ir.pp.hir_prog);
+	LIMA_PASS(shader, "lima_pp_hir_convert_to_cssa", lima_ir_pp_hir,
+		lima_pp_hir_convert_to_cssa(shader->ir.pp.hir_prog));
 	
-	shader->ir.pp.lir_prog = lima_pp_lir_convert(shader->ir.pp.hir_prog);
+	LIMA_LOWERING_PASS(shader, "lima_pp_lir_convert", lima_ir_pp_hir, lima_ir_pp_lir,
+		shader->ir.pp.lir_prog = lima_pp_lir_convert(shader->ir.pp.hir_prog));
 	
 	if (dump_ir)
 	{
 		printf("PP LIR (before optimization, regalloc, and scheduling):\n\n");
-		lima_pp_lir_prog_print(shader->ir.pp.lir_prog, false);
+		lima_pp_lir_prog_print(shader->ir.pp.lir_prog, false, stdout);
 	}
 	
-	lima_pp_lir_calc_dep_info(shader->ir.pp.lir_prog);
-	
-	lima_pp_lir_peephole(shader->ir.pp.lir_prog);
-	
-	lima_pp_lir_reg_pressure_schedule_prog(shader->ir.pp.lir_prog);
-	
-	lima_pp_lir_delete_dep_info(shader->ir.pp.lir_prog);
-	
-	lima_pp_lir_regalloc(shader->ir.pp.lir_prog);
-	
-	lima_pp_lir_calc_dep_info(shader->ir.pp.lir_prog);
-	
-	lima_pp_lir_combine_schedule_prog(shader->ir.pp.lir_prog);
-	
-	lima_pp_lir_delete_dep_info(shader->ir.pp.lir_prog);
-	
-	if (dump_ir)
+	void* code;
+	if (passes->pp_lir_smallest)
 	{
-		printf("PP LIR (after optimization, regalloc, and scheduling):\n\n");
-		lima_pp_lir_prog_print(shader->ir.pp.lir_prog, false);
+		/* Scheduling for register pressure gets rid of spills, but it also
+		 * gets in the way of the combine scheduler, so try it both ways.
+		 */
+		lima_pp_lir_prog_t* prog = shader->ir.pp.lir_prog;
+		LIMA_LOWERING_PASS(shader, "lima_pp_lir_convert", lima_ir_pp_hir,
+			lima_ir_pp_lir,
+			shader->ir.pp.lir_prog = lima_pp_lir_convert(shader->ir.pp.hir_prog));
+		compile_pp_lir(shader, passes, false);
+		
+		void* other_code;
+		unsigned other_size;
+		lima_shader_report_t other_report;
+		LIMA_PASS(shader, "lima_pp_lir_codegen", lima_ir_pp_lir,
+			other_code = lima_pp_lir_codegen(shader->ir.pp.lir_prog, &other_size,
+											 &other_report));
+		
+		lima_pp_lir_prog_t* other = shader->ir.pp.lir_prog;
+		shader->ir.pp.lir_prog = prog;
+		compile_pp_lir(shader, passes, true);
+		
+		LIMA_PASS(shader, "lima_pp_lir_codegen", lima_ir_pp_lir,
+			code = lima_pp_lir_codegen(shader->ir.pp.lir_prog, &shader->code_size,
+									   &shader->report));
+		
+		if (other_size < shader->code_size)
+		{
+			shader->ir.pp.lir_prog = other;
+			other = prog;
+			free(code);
+			code = other_code;
+			shader->code_size = other_size;
+			shader->report = other_report;
+		}
+		else
+			free(other_code);
+		
+		lima_pp_lir_prog_delete(other);
+		
+		if (dump_ir)
+		{
+			printf("PP LIR (after optimization, regalloc, and scheduling):\n\n");
+			lima_pp_lir_prog_print(shader->ir.pp.lir_prog, false, stdout);
+		}
+	}
+	else
+	{
+		compile_pp_lir(shader, passes, passes->pp_lir_reg_pressure_schedule);
+		
+		if (dump_ir)
+		{
+			printf("PP LIR (after optimization, regalloc, and scheduling):\n\n");
+			lima_pp_lir_prog_print(shader->ir.pp.lir_prog, false, stdout);
+		}
+		
+		LIMA_PASS(shader, "lima_pp_lir_codegen", lima_ir_pp_lir,
+			code = lima_pp_lir_codegen(shader->ir.pp.lir_prog, &shader->code_size,
+									   &shader->report));
 	}
-	
-	void* code = lima_pp_lir_codegen(shader->ir.pp.lir_prog, &shader->code_size);
 	
 	//get first instruction length
 	uint32_t first_instr_control = *((uint32_t*)code);
@@ -341,100 +518,185 @@ static void compile_pp_shader(lima_shader_t* shader, bool dump_ir)
 
 static void compile_gp_shader(lima_shader_t* shader, bool dump_ir)
 {
+	const struct opt_level_passes* passes = get_passes(shader);
+	
 	if (dump_ir)
 	{
 		printf("GP IR (before optimization and lowering):\n\n");
-		lima_gp_ir_prog_print(shader->ir.gp.gp_prog, 0, false);
+		lima_gp_ir_prog_print(shader->ir.gp.gp_prog, 0, false, stdout);
 	}
 	
-	lima_gp_ir_if_convert(shader->ir.gp.gp_prog);
+	if (passes->gp_if_convert)
+		LIMA_PASS(shader, "lima_gp_ir_if_convert", lima_ir_gp_ir,
+			lima_gp_ir_if_convert(shader->ir.gp.gp_prog));
 	
-	lima_gp_ir_dead_code_eliminate(shader->ir.gp.gp_prog);
+	LIMA_PASS(shader, "lima_gp_ir_dead_code_eliminate", lima_ir_gp_ir,
+		lima_gp_ir_dead_code_eliminate(shader->ir.gp.gp_prog));
 	
-	lima_gp_ir_reg_eliminate(shader->ir.gp.gp_prog);
+	LIMA_PASS(shader, "lima_gp_ir_reg_eliminate", lima_ir_gp_ir,
+		lima_gp_ir_reg_eliminate(shader->ir.gp.gp_prog));
 	
-	lima_gp_ir_const_fold_prog(shader->ir.gp.gp_prog);
+	if (passes->gp_const_fold)
+		LIMA_PASS(shader, "lima_gp_ir_const_fold_prog", lima_ir_gp_ir,
+			lima_gp_ir_const_fold_prog(shader->ir.gp.gp_prog));
 	
-	lima_gp_ir_eliminate_phi_nodes(shader->ir.gp.gp_prog);
+	LIMA_PASS(shader, "lima_gp_ir_eliminate_phi_nodes", lima_ir_gp_ir,
+		lima_gp_ir_eliminate_phi_nodes(shader->ir.gp.gp_prog));
 	
-	lima_gp_ir_liveness_compute_prog(shader->ir.gp.gp_prog, true);
+	LIMA_PASS(shader, "lima_gp_ir_liveness_compute_prog", lima_ir_gp_ir,
+		lima_gp_ir_liveness_compute_prog(shader->ir.gp.gp_prog, true));
 	
-	lima_gp_ir_regalloc(shader->ir.gp.gp_prog);
+	if (shader->regalloc == lima_regalloc_linear_scan)
+		LIMA_PASS(shader, "lima_gp_ir_regalloc_linear_scan", lima_ir_gp_ir,
+			lima_gp_ir_regalloc_linear_scan(shader->ir.gp.gp_prog));
+	else
+		LIMA_PASS(shader, "lima_gp_ir_regalloc", lima_ir_gp_ir,
+			lima_gp_ir_regalloc(shader->ir.gp.gp_prog));
 	
-	lima_gp_ir_lower_prog(shader->ir.gp.gp_prog);
+	LIMA_PASS(shader, "lima_gp_ir_lower_prog", lima_ir_gp_ir,
+		lima_gp_ir_lower_prog(shader->ir.gp.gp_prog));
 	
-	lima_gp_ir_lower_consts(shader->ir.gp.gp_prog, &shader->symbols);
+	LIMA_PASS(shader, "lima_gp_ir_lower_consts", lima_ir_gp_ir,
+		lima_gp_ir_lower_consts(shader->ir.gp.gp_prog, &shader->symbols));
 	
-	lima_gp_ir_prog_calc_dependencies(shader->ir.gp.gp_prog);
+	LIMA_PASS(shader, "lima_gp_ir_prog_calc_dependencies", lima_ir_gp_ir,
+		lima_gp_ir_prog_calc_dependencies(shader->ir.gp.gp_prog));
 	
-	lima_gp_ir_prog_calc_crit_path(shader->ir.gp.gp_prog);
+	LIMA_PASS(shader, "lima_gp_ir_prog_calc_crit_path", lima_ir_gp_ir,
+		lima_gp_ir_prog_calc_crit_path(shader->ir.gp.gp_prog));
 	
-	lima_gp_ir_schedule_prog(shader->ir.gp.gp_prog);
+	LIMA_PASS(shader, "lima_gp_ir_schedule_prog", lima_ir_gp_ir,
+		lima_gp_ir_schedule_prog(shader->ir.gp.gp_prog));
 	
 	if (dump_ir)
 	{
 		printf("GP IR (after optimization and lowering):\n\n");
-		lima_gp_ir_prog_print(shader->ir.gp.gp_prog, 0, false);
+		lima_gp_ir_prog_print(shader->ir.gp.gp_prog, 0, false, stdout);
 	}
 	
-	void* code = lima_gp_ir_codegen(shader->ir.gp.gp_prog, &shader->code_size,
-									&shader->info.vs.attrib_prefetch);
+	void* code;
+	LIMA_PASS(shader, "lima_gp_ir_codegen", lima_ir_gp_ir,
+		code = lima_gp_ir_codegen(shader->ir.gp.gp_prog, &shader->code_size,
+								  &shader->info.vs.attrib_prefetch,
+								  &shader->report));
 	shader->info.vs.num_instructions = shader->code_size / 16;
 	
 	shader->code = ralloc_size(shader->mem_ctx, shader->code_size);
 	memcpy(shader->code, code, shader->code_size);
 	free(code);
 	
+	if (shader->stats)
+	{
+		shader->stats->stats.sched_restarts +=
+			shader->ir.gp.gp_prog->sched_restarts;
+		shader->stats->stats.sched_nodes_undone +=
+			shader->ir.gp.gp_prog->sched_nodes_undone;
+	}
+	
 	lima_gp_ir_prog_delete(shader->ir.gp.gp_prog);
 }
 
-bool lima_shader_compile(lima_shader_t* shader, bool dump_ir)
+void lima_shader_lower(lima_shader_t* shader)
 {
-	if (!shader->parsed)
-		return true;
+	LIMA_PASS(shader, "convert_to_ssa", lima_ir_glsl,
+		convert_to_ssa(shader->linked_shader->ir));
 	
-	convert_to_ssa(shader->linked_shader->ir);
+	LIMA_PASS(shader, "lima_lower_conditions", lima_ir_glsl,
+		lima_lower_conditions(shader->linked_shader->ir));
 	
-	lima_lower_conditions(shader->linked_shader->ir);
+	LIMA_PASS(shader, "lima_lower_scalar_args", lima_ir_glsl,
+		lima_lower_scalar_args(shader->linked_shader->ir));
 	
-	lima_lower_scalar_args(shader->linked_shader->ir);
+	LIMA_PASS(shader, "lima_lower_output_writemask", lima_ir_glsl,
+		lima_lower_output_writemask(shader->linked_shader->ir,
+									shader->stage == lima_shader_stage_fragment));
 	
-	lima_lower_output_writemask(shader->linked_shader->ir,
-								shader->stage == lima_shader_stage_fragment);
+	if (lima_trace_enabled(lima_trace_ir))
+		_mesa_print_ir(lima_trace_file(lima_trace_ir),
+					   shader->linked_shader->ir, shader->state);
 	
-	_mesa_print_ir(shader->linked_shader->ir, shader->state);
-	
-	lima_convert_symbols(shader);
-	if (!lima_shader_symbols_pack(&shader->symbols, shader->stage))
+	bool packed;
+	LIMA_PASS(shader, "lima_convert_symbols", lima_ir_glsl,
+		lima_convert_symbols(shader));
+	LIMA_PASS(shader, "lima_shader_symbols_pack", lima_ir_glsl,
+		packed = lima_shader_symbols_pack(&shader->symbols, shader->stage));
+	if (!packed)
 	{
 		ralloc_asprintf_append(&shader->info_log,
 							   "Error: could not allocate enough space for variables.\n");
 		shader->errors = true;
-		return true;
+		return;
 	}
-	lima_shader_symbols_print(&shader->symbols);
 	
-	_mesa_print_ir(shader->linked_shader->ir, shader->state);
+	if (lima_trace_enabled(lima_trace_symbols))
+		lima_shader_symbols_print(&shader->symbols,
+								  lima_trace_file(lima_trace_symbols));
+	
+	if (lima_trace_enabled(lima_trace_ir))
+		_mesa_print_ir(lima_trace_file(lima_trace_ir),
+					   shader->linked_shader->ir, shader->state);
 	
 	if (shader->stage == lima_shader_stage_fragment)
+		LIMA_LOWERING_PASS(shader, "lima_lower_to_pp_hir", lima_ir_glsl, lima_ir_pp_hir,
+			lima_lower_to_pp_hir(shader));
+	else
+		LIMA_LOWERING_PASS(shader, "lima_lower_to_gp_ir", lima_ir_glsl, lima_ir_gp_ir,
+			lima_lower_to_gp_ir(shader));
+	
+	shader->lowered = true;
+}
+
+static void compile(lima_shader_t* shader, bool dump_ir)
+{
+	if (!shader->lowered)
 	{
-		lima_lower_to_pp_hir(shader);
-		compile_pp_shader(shader, dump_ir);
+		lima_shader_lower(shader);
+		if (shader->errors)
+			return;
 	}
+	
+	if (shader->stage == lima_shader_stage_fragment)
+		compile_pp_shader(shader, dump_ir);
 	else
-	{
-		lima_lower_to_gp_ir(shader);
 		compile_gp_shader(shader, dump_ir);
-	}
+	if (shader->errors)
+		return;
 	
 	shader->compiled = true;
+	lima_shader_cache_store(shader);
+}
+
+bool lima_shader_compile(lima_shader_t* shader, bool dump_ir)
+{
+	if (!shader->parsed || shader->cached)
+		return true;
+	
+	lima_trace_begin(&shader->trace);
+	compile(shader, dump_ir);
+	lima_trace_end(&shader->trace);
 	return true;
 }
 
 void lima_shader_print_glsl(lima_shader_t* shader)
 {
 	assert(shader->linked_shader);
-	_mesa_print_ir(shader->linked_shader->ir, shader->state);
+	_mesa_print_ir(stdout, shader->linked_shader->ir, shader->state);
+}
+
+void lima_shader_set_trace(lima_shader_t* shader, unsigned categories,
+						   lima_trace_sink_t sink, void* data)
+{
+	lima_trace_init(&shader->trace, categories, sink, data);
+}
+
+void lima_shader_set_regalloc(lima_shader_t* shader, lima_regalloc_e regalloc)
+{
+	shader->regalloc = regalloc;
+}
+
+void lima_shader_set_opt_level(lima_shader_t* shader, lima_opt_level_e level)
+{
+	shader->opt_level = level;
 }
 
 bool lima_shader_error(lima_shader_t* shader)
@@ -462,6 +724,16 @@ lima_shader_info_t lima_shader_get_info(lima_shader_t* shader)
 	return shader->info;
 }
 
+bool lima_shader_get_report(lima_shader_t* shader,
+							lima_shader_report_t* report)
+{
+	if (!shader->code)
+		return false;
+	
+	*report = shader->report;
+	return true;
+}
+
 lima_core_e lima_shader_get_core(lima_shader_t* shader)
 {
 	return shader->core;
@@ -0,0 +1,156 @@
+/* Author(s):
+ *   Connor Abbott
+ *
+ * Copyright (c) 2014 Connor Abbott (connor@abbott.cx)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "shader_internal.h"
+#include <stdint.h>
+
+/*
+ * Glue between the shader and the on-disk cache. The key is the source
+ * together with everything else that affects the output, and the entry holds
+ * everything lima_shader_export_offline() and the online compiler need, i.e.
+ * the code, the info structure, and the packed symbol tables, along with the
+ * report.
+ */
+
+typedef struct {
+	lima_shader_info_t info;
+	lima_shader_report_t report;
+	uint32_t code_size;
+	uint32_t symbols_size;
+} entry_header_t;
+
+static bool make_key(lima_shader_t* shader, const char* source)
+{
+	unsigned version_size = strlen(shader->compiler->version) + 1;
+	unsigned source_size = strlen(source);
+	uint32_t stage = shader->stage, core = shader->core;
+	uint32_t regalloc = shader->regalloc, opt_level = shader->opt_level;
+	
+	shader->cache_key_size = version_size + sizeof(stage) + sizeof(core) +
+		sizeof(regalloc) + sizeof(opt_level) + source_size;
+	char* key = (char*) ralloc_size(shader->mem_ctx, shader->cache_key_size);
+	if (!key)
+		return false;
+	
+	shader->cache_key = key;
+	memcpy(key, shader->compiler->version, version_size);
+	key += version_size;
+	memcpy(key, &stage, sizeof(stage));
+	key += sizeof(stage);
+	memcpy(key, &core, sizeof(core));
+	key += sizeof(core);
+	memcpy(key, &regalloc, sizeof(regalloc));
+	key += sizeof(regalloc);
+	memcpy(key, &opt_level, sizeof(opt_level));
+	key += sizeof(opt_level);
+	memcpy(key, source, source_size);
+	
+	return true;
+}
+
+static bool load_entry(lima_shader_t* shader, const char* data, unsigned size)
+{
+	entry_header_t header;
+	if (size < sizeof(header))
+		return false;
+	
+	memcpy(&header, data, sizeof(header));
+	data += sizeof(header);
+	if (size - sizeof(header) != (uint64_t) header.code_size + header.symbols_size)
+		return false;
+	
+	if (!lima_shader_symbols_import(&shader->symbols, data + header.code_size,
+									header.symbols_size))
+	{
+		lima_shader_symbols_delete(&shader->symbols);
+		lima_shader_symbols_init(&shader->symbols);
+		return false;
+	}
+	
+	shader->code = ralloc_size(shader->mem_ctx, header.code_size);
+	if (!shader->code)
+		return false;
+	
+	memcpy(shader->code, data, header.code_size);
+	shader->code_size = header.code_size;
+	shader->info = header.info;
+	shader->report = header.report;
+	
+	return true;
+}
+
+bool lima_shader_cache_load(lima_shader_t* shader, const char* source)
+{
+	if (!shader->compiler->cache)
+		return false;
+	
+	if (!make_key(shader, source))
+		return false;
+	
+	void* data;
+	unsigned size;
+	if (!lima_cache_get(shader->compiler->cache, shader->cache_key,
+						shader->cache_key_size, &data, &size))
+		return false;
+	
+	bool loaded = load_entry(shader, (const char*) data, size);
+	free(data);
+	return loaded;
+}
+
+void lima_shader_cache_store(lima_shader_t* shader)
+{
+	if (!shader->compiler->cache || !shader->cache_key || shader->errors)
+		return;
+	
+	unsigned symbols_size;
+	void* symbols = lima_shader_symbols_export(&shader->symbols, &symbols_size);
+	if (!symbols)
+		return;
+	
+	unsigned size = sizeof(entry_header_t) + shader->code_size + symbols_size;
+	char* data = (char*) malloc(size);
+	if (!data)
+	{
+		free(symbols);
+		return;
+	}
+	
+	entry_header_t header;
+	memset(&header, 0, sizeof(header));
+	header.info = shader->info;
+	header.report = shader->report;
+	header.code_size = shader->code_size;
+	header.symbols_size = symbols_size;
+	
+	memcpy(data, &header, sizeof(header));
+	memcpy(data + sizeof(header), shader->code, shader->code_size);
+	memcpy(data + sizeof(header) + shader->code_size, symbols, symbols_size);
+	
+	lima_cache_put(shader->compiler->cache, shader->cache_key,
+				   shader->cache_key_size, data, size);
+	
+	free(data);
+	free(symbols);
+}
@@ -31,13 +31,42 @@
 #include "pp_hir/pp_hir.h"
 #include "pp_lir/pp_lir.h"
 #include "gp_ir/gp_ir.h"
+#include "cache/cache.h"
+#include "heap.h"
+#include "trace.h"
+
+struct lima_compiler_s
+{
+	unsigned num_shaders; /* number of live shaders created with this compiler */
+	
+	lima_cache_t* cache;
+	char* version; /* identifies the compiler binary in cache keys and checkpoints */
+};
+
+struct lima_stats_state_s
+{
+	lima_shader_stats_t stats;
+	unsigned passes_capacity;
+	
+	/* the pass currently running */
+	lima_pass_stats_t* pass;
+	double pass_start;
+	long pass_heap; /* heap.in_use when it started */
+	
+	/* what the passes have allocated so far */
+	lima_heap_counter_t heap;
+};
 
 struct lima_shader_s
 {
 	void* mem_ctx;
 	
+	lima_compiler_t* compiler;
+	
 	lima_shader_stage_e stage;
 	lima_core_e core;
+	lima_regalloc_e regalloc;
+	lima_opt_level_e opt_level;
 	
 	struct gl_context mesa_ctx;
 	_mesa_glsl_parse_state* state;
@@ -65,12 +94,59 @@ struct lima_shader_s
 	unsigned code_size;
 	
 	lima_shader_info_t info;
+	lima_shader_report_t report;
+	
+	/* the cache key for the source, and whether the shader was loaded from
+	 * the cache, in which case there's no GLSL IR to work with
+	 */
+	void* cache_key;
+	unsigned cache_key_size;
+	bool cached;
+	
+	struct lima_stats_state_s* stats; /* NULL unless stats are enabled */
+	
+	lima_trace_t trace;
 	
 	bool parsed; /* whether the shader was parsed without any errors */
+	bool lowered; /* whether the shader is in the backend IR, see lima_shader_lower() */
 	bool compiled; /* whether the shader was lowered to assembly without any errors */
 	bool errors;
 };
 
+/* lowers the optimized GLSL IR to the backend IR, and packs the symbols */
+void lima_shader_lower(lima_shader_t* shader);
+
+bool lima_shader_cache_load(lima_shader_t* shader, const char* source);
+void lima_shader_cache_store(lima_shader_t* shader);
+
+typedef enum {
+	lima_ir_none,
+	lima_ir_glsl,
+	lima_ir_pp_hir,
+	lima_ir_pp_lir,
+	lima_ir_gp_ir
+} lima_ir_e;
+
+void lima_shader_pass_begin(lima_shader_t* shader, const char* name,
+							lima_ir_e ir);
+void lima_shader_pass_end(lima_shader_t* shader, lima_ir_e ir);
+
+/* Run a pass, recording stats about it if they're enabled. The lowering
+ * version is for passes that change which IR the shader is in.
+ */
+
+#define LIMA_LOWERING_PASS(shader, name, from, to, ...) \
+	do { \
+		if ((shader)->stats) \
+			lima_shader_pass_begin(shader, name, from); \
+		__VA_ARGS__; \
+		if ((shader)->stats) \
+			lima_shader_pass_end(shader, to); \
+	} while (0)
+
+#define LIMA_PASS(shader, name, ir, ...) \
+	LIMA_LOWERING_PASS(shader, name, ir, ir, __VA_ARGS__)
+
 void lima_convert_symbols(lima_shader_t* shader);
 void lima_lower_to_pp_hir(lima_shader_t* shader);
 void lima_lower_to_gp_ir(lima_shader_t* shader);
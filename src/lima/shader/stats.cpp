@@ -0,0 +1,191 @@
+/* Author(s):
+ *   Connor Abbott
+ *
+ * Copyright (c) 2014 Connor Abbott (connor@abbott.cx)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "shader_internal.h"
+#include "ir.h"
+#include "ir_hierarchical_visitor.h"
+#include <time.h>
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+void lima_shader_enable_stats(lima_shader_t* shader)
+{
+	if (shader->stats)
+		return;
+	
+	shader->stats = rzalloc(shader->mem_ctx, struct lima_stats_state_s);
+}
+
+const lima_shader_stats_t* lima_shader_get_stats(lima_shader_t* shader)
+{
+	if (!shader->stats)
+		return NULL;
+	
+	shader->stats->stats.cached = shader->cached;
+	return &shader->stats->stats;
+}
+
+/* IR sizes */
+
+static void count_glsl_ir(ir_instruction* ir, void* data)
+{
+	unsigned* counts = (unsigned*) data;
+	counts[0]++;
+	if (ir->as_variable())
+		counts[1]++;
+}
+
+static void ir_size(lima_shader_t* shader, lima_ir_e ir, unsigned* size,
+					unsigned* regs)
+{
+	*size = *regs = 0;
+	
+	switch (ir)
+	{
+		case lima_ir_none:
+			break;
+			
+		case lima_ir_glsl:
+		{
+			exec_list* list = shader->linked_shader ?
+				shader->linked_shader->ir : shader->shader->ir;
+			if (!list)
+				break;
+			
+			unsigned counts[2] = {0, 0};
+			foreach_list(node, list)
+				visit_tree((ir_instruction*) node, count_glsl_ir, counts);
+			*size = counts[0];
+			*regs = counts[1];
+			break;
+		}
+			
+		case lima_ir_pp_hir:
+		{
+			lima_pp_hir_prog_t* prog = shader->ir.pp.hir_prog;
+			/* the list iteration macros need typeof, which C++ lacks */
+			for (struct list* node = prog->block_list.next;
+				 node != &prog->block_list; node = node->next)
+				*size += (list_entry(node, lima_pp_hir_block_t, block_list))->size;
+			*regs = prog->reg_alloc;
+			break;
+		}
+			
+		case lima_ir_pp_lir:
+		{
+			lima_pp_lir_prog_t* prog = shader->ir.pp.lir_prog;
+			for (unsigned i = 0; i < prog->num_blocks; i++)
+				*size += prog->blocks[i]->num_instrs;
+			*regs = prog->num_regs;
+			break;
+		}
+			
+		case lima_ir_gp_ir:
+		{
+			lima_gp_ir_prog_t* prog = shader->ir.gp.gp_prog;
+			for (struct list* node = prog->block_list.next;
+				 node != &prog->block_list; node = node->next)
+				*size += (list_entry(node, lima_gp_ir_block_t,
+								   block_list))->num_nodes;
+			*regs = prog->reg_alloc;
+			break;
+		}
+	}
+}
+
+static lima_pass_stats_t* get_pass(struct lima_stats_state_s* state,
+								   const char* name)
+{
+	lima_shader_stats_t* stats = &state->stats;
+	for (unsigned i = 0; i < stats->num_passes; i++)
+		if (strcmp(stats->passes[i].name, name) == 0)
+			return &stats->passes[i];
+	
+	if (stats->num_passes == state->passes_capacity)
+	{
+		unsigned capacity = state->passes_capacity ? 2 * state->passes_capacity : 32;
+		lima_pass_stats_t* passes = reralloc(state, stats->passes,
+											 lima_pass_stats_t, capacity);
+		if (!passes)
+			return NULL;
+		
+		stats->passes = passes;
+		state->passes_capacity = capacity;
+	}
+	
+	lima_pass_stats_t* pass = &stats->passes[stats->num_passes++];
+	memset(pass, 0, sizeof(*pass));
+	pass->name = name;
+	return pass;
+}
+
+void lima_shader_pass_begin(lima_shader_t* shader, const char* name,
+							lima_ir_e ir)
+{
+	struct lima_stats_state_s* state = shader->stats;
+	
+	state->pass = get_pass(state, name);
+	if (!state->pass)
+		return;
+	
+	if (state->pass->runs == 0)
+		ir_size(shader, ir, &state->pass->size_before,
+				&state->pass->regs_before);
+	
+	/* start the high-water mark over for this run */
+	state->pass_heap = state->heap.in_use;
+	state->heap.peak = state->heap.in_use;
+	lima_heap_set_counter(&state->heap);
+	
+	state->pass_start = now();
+}
+
+void lima_shader_pass_end(lima_shader_t* shader, lima_ir_e ir)
+{
+	struct lima_stats_state_s* state = shader->stats;
+	lima_pass_stats_t* pass = state->pass;
+	if (!pass)
+		return;
+	
+	double time = now() - state->pass_start;
+	lima_heap_set_counter(NULL);
+	
+	pass->runs++;
+	pass->time += time;
+	pass->heap_delta += state->heap.in_use - state->pass_heap;
+	if (state->heap.peak - state->pass_heap > (long) pass->peak_heap)
+		pass->peak_heap = state->heap.peak - state->pass_heap;
+	ir_size(shader, ir, &pass->size_after, &pass->regs_after);
+	
+	state->stats.total_time += time;
+	if (state->heap.peak > (long) state->stats.peak_heap)
+		state->stats.peak_heap = state->heap.peak;
+	
+	state->pass = NULL;
+}
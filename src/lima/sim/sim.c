@@ -0,0 +1,570 @@
+/* Author(s):
+ *   Connor Abbott
+ *
+ * Copyright (c) 2014 Connor Abbott (connor@abbott.cx)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Runs compiled vertex shaders on the GP simulator. Attributes and uniforms
+ * that aren't given on the command line are filled with pseudo-random values
+ * from a fixed seed, so the output only changes when what the code computes
+ * does, and two builds of the compiler can be compared by diffing it. The
+ * varyings of the first few vertices are printed, along with how many
+ * instructions ran over all of them.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "shader.h"
+#include "symbols/symbols.h"
+#include "gp/lima_gp.h"
+
+#define USAGE \
+"usage: limasim [options] inputs...\n" \
+"\n" \
+"options:\n" \
+"\t--vertices (-n) [number] -- the number of vertices to run. Default: 1\n" \
+"\t--print (-p) [number] -- print the varyings of this many vertices.\n" \
+"\t\tDefault: 1\n" \
+"\t--seed (-s) [number] -- the seed for the inputs that aren't given.\n" \
+"\t\tDefault: 1\n" \
+"\t--attribute (-a) [name=x,y,...] -- set an attribute for every vertex.\n" \
+"\t--uniform (-u) [name=x,y,...] -- set a uniform.\n" \
+"\t--counts (-c) -- print how many times each instruction ran.\n" \
+"\t--help (-h) -- print this message and quit.\n" \
+"\n" \
+"The inputs are vertex shader sources. Values are given in the order of the\n" \
+"array elements, then the matrix columns, then the components.\n"
+
+static void usage(void)
+{
+	fprintf(stderr, USAGE);
+}
+
+static char* read_file(const char* path)
+{
+	FILE* fp = fopen(path, "rb");
+	if (!fp) return NULL;
+	
+	if (fseek(fp, 0, SEEK_END) != 0)
+	{
+		fclose(fp);
+		return NULL;
+	}
+	long fsize = ftell(fp);
+	if ((fsize <= 0)
+		|| (fseek(fp, 0, SEEK_SET) != 0))
+	{
+		fclose(fp);
+		return NULL;
+	}
+	
+	char* data = (char*)malloc(fsize + 1);
+	if (!data)
+	{
+		fclose(fp);
+		return NULL;
+	}
+	
+	if (fread(data, fsize, 1, fp) != 1)
+	{
+		fclose(fp);
+		free(data);
+		return NULL;
+	}
+	data[fsize] = '\0';
+	
+	fclose(fp);
+	return data;
+}
+
+/* an input given on the command line */
+typedef struct
+{
+	const char* name;
+	unsigned name_len;
+	float values[64];
+	unsigned num_values;
+} input_t;
+
+#define MAX_INPUTS 64
+
+typedef struct
+{
+	input_t attributes[MAX_INPUTS], uniforms[MAX_INPUTS];
+	unsigned num_attributes, num_uniforms;
+	unsigned num_vertices, num_print;
+	uint32_t seed;
+	bool counts;
+} options_t;
+
+static bool parse_input(const char* arg, input_t* input)
+{
+	const char* equals = strchr(arg, '=');
+	if (!equals || equals == arg)
+		return false;
+	
+	input->name = arg;
+	input->name_len = equals - arg;
+	input->num_values = 0;
+	
+	const char* pos = equals + 1;
+	while (*pos)
+	{
+		if (input->num_values == 64)
+			return false;
+		
+		char* end;
+		input->values[input->num_values++] = strtof(pos, &end);
+		if (end == pos)
+			return false;
+		
+		pos = end;
+		if (*pos == ',')
+			pos++;
+		else if (*pos)
+			return false;
+	}
+	
+	return input->num_values > 0;
+}
+
+static uint32_t next_random(uint32_t* state)
+{
+	/* xorshift32 */
+	uint32_t x = *state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*state = x;
+	return x;
+}
+
+/* a value in [-1, 1] */
+static float random_value(uint32_t* state)
+{
+	return (float) (next_random(state) >> 8) / (float) (1 << 23) - 1.f;
+}
+
+static const unsigned num_components[lima_num_symbol_types] = {
+	[lima_symbol_float] = 1,
+	[lima_symbol_bool] = 1,
+	[lima_symbol_int] = 1,
+	[lima_symbol_vec2]  = 2,
+	[lima_symbol_ivec2] = 2,
+	[lima_symbol_bvec2] = 2,
+	[lima_symbol_mat2]  = 2,
+	[lima_symbol_vec3]  = 3,
+	[lima_symbol_ivec3] = 3,
+	[lima_symbol_bvec3] = 3,
+	[lima_symbol_mat3]  = 3,
+	[lima_symbol_vec4]  = 4,
+	[lima_symbol_ivec4] = 4,
+	[lima_symbol_bvec4] = 4,
+	[lima_symbol_mat4]  = 4,
+};
+
+static const unsigned num_columns[lima_num_symbol_types] = {
+	[lima_symbol_float] = 1,
+	[lima_symbol_bool] = 1,
+	[lima_symbol_int] = 1,
+	[lima_symbol_vec2]  = 1,
+	[lima_symbol_ivec2] = 1,
+	[lima_symbol_bvec2] = 1,
+	[lima_symbol_vec3]  = 1,
+	[lima_symbol_ivec3] = 1,
+	[lima_symbol_bvec3] = 1,
+	[lima_symbol_vec4]  = 1,
+	[lima_symbol_ivec4] = 1,
+	[lima_symbol_bvec4] = 1,
+	[lima_symbol_mat2]  = 2,
+	[lima_symbol_mat3]  = 3,
+	[lima_symbol_mat4]  = 4,
+};
+
+/* The number of floats in a symbol, and where the i'th one is. The packing
+ * puts each array element stride floats apart, with the matrix columns spread
+ * evenly over it. */
+
+static unsigned symbol_size(const lima_symbol_t* symbol)
+{
+	unsigned elems = symbol->array_elems ? symbol->array_elems : 1;
+	return elems * num_columns[symbol->type] * num_components[symbol->type];
+}
+
+static unsigned symbol_offset(const lima_symbol_t* symbol, unsigned i)
+{
+	unsigned components = num_components[symbol->type];
+	unsigned columns = num_columns[symbol->type];
+	unsigned elem = i / (components * columns);
+	unsigned column = i / components % columns;
+	return symbol->offset + elem * symbol->stride +
+		column * (symbol->stride / columns) + i % components;
+}
+
+static bool simple_symbol(const lima_symbol_t* symbol)
+{
+	return symbol->used && symbol->type != lima_symbol_struct &&
+		num_components[symbol->type] != 0;
+}
+
+static bool set_input(lima_symbol_table_t* table, const input_t* input,
+					  float* data, unsigned size)
+{
+	unsigned i, j;
+	for (i = 0; i < table->num_symbols; i++)
+	{
+		lima_symbol_t* symbol = table->symbols[i];
+		if (strlen(symbol->name) != input->name_len ||
+			strncmp(symbol->name, input->name, input->name_len) != 0)
+			continue;
+		
+		if (!simple_symbol(symbol))
+			return false;
+		
+		for (j = 0; j < input->num_values && j < symbol_size(symbol); j++)
+		{
+			unsigned offset = symbol_offset(symbol, j);
+			if (offset < size)
+				data[offset] = input->values[j];
+		}
+		
+		return true;
+	}
+	
+	return false;
+}
+
+static bool setup_uniforms(lima_shader_symbols_t* symbols,
+						   const options_t* options, lima_gp_sim_t* sim)
+{
+	static float uniforms[LIMA_GP_SIM_NUM_UNIFORMS * 4];
+	unsigned size = LIMA_GP_SIM_NUM_UNIFORMS * 4;
+	memset(uniforms, 0, sizeof(uniforms));
+	
+	uint32_t state = options->seed;
+	unsigned i, j;
+	for (i = 0; i < symbols->uniform_table.total_size && i < size; i++)
+		uniforms[i] = random_value(&state);
+	
+	/* the constants added by the compiler, and any initializers */
+	for (i = 0; i < symbols->uniform_table.num_symbols; i++)
+	{
+		lima_symbol_t* symbol = symbols->uniform_table.symbols[i];
+		if (!symbol->array_const || !simple_symbol(symbol))
+			continue;
+		
+		for (j = 0; j < symbol_size(symbol); j++)
+		{
+			unsigned offset = symbol_offset(symbol, j);
+			if (offset < size)
+				uniforms[offset] = symbol->array_const[j];
+		}
+	}
+	
+	for (i = 0; i < options->num_uniforms; i++)
+	{
+		const input_t* input = &options->uniforms[i];
+		if (!set_input(&symbols->uniform_table, input, uniforms, size))
+		{
+			fprintf(stderr, "Error: no uniform %.*s\n", input->name_len,
+					input->name);
+			return false;
+		}
+	}
+	
+	lima_gp_sim_set_uniforms(sim, uniforms, LIMA_GP_SIM_NUM_UNIFORMS);
+	return true;
+}
+
+static float* setup_attributes(lima_shader_symbols_t* symbols,
+							   const options_t* options)
+{
+	unsigned size = LIMA_GP_SIM_NUM_ATTRIBS * 4;
+	float* attributes = malloc(options->num_vertices * size * sizeof(float));
+	if (!attributes)
+		return NULL;
+	
+	/* a different stream from the uniforms */
+	uint32_t state = options->seed ^ 0x9e3779b9;
+	if (!state)
+		state = 1;
+	
+	unsigned i, j;
+	for (i = 0; i < options->num_vertices; i++)
+	{
+		float* vertex = attributes + i * size;
+		for (j = 0; j < size; j++)
+			vertex[j] = random_value(&state);
+		
+		for (j = 0; j < options->num_attributes; j++)
+		{
+			const input_t* input = &options->attributes[j];
+			if (!set_input(&symbols->attribute_table, input, vertex, size))
+			{
+				fprintf(stderr, "Error: no attribute %.*s\n", input->name_len,
+						input->name);
+				free(attributes);
+				return NULL;
+			}
+		}
+	}
+	
+	return attributes;
+}
+
+static void print_varyings(lima_shader_symbols_t* symbols,
+						   const float* varyings, unsigned num_vertices)
+{
+	unsigned size = LIMA_GP_SIM_NUM_VARYINGS * 4;
+	
+	unsigned i, j, k;
+	for (i = 0; i < num_vertices; i++)
+	{
+		printf("vertex %u:\n", i);
+		for (j = 0; j < symbols->varying_table.num_symbols; j++)
+		{
+			lima_symbol_t* symbol = symbols->varying_table.symbols[j];
+			if (!simple_symbol(symbol))
+				continue;
+			
+			printf("\t%s =", symbol->name);
+			for (k = 0; k < symbol_size(symbol); k++)
+			{
+				unsigned offset = symbol_offset(symbol, k);
+				printf(" %.9g", offset < size ? varyings[i * size + offset] : 0.);
+			}
+			printf("\n");
+		}
+	}
+}
+
+static void print_counts(lima_gp_sim_t* sim)
+{
+	unsigned num_instrs;
+	const unsigned long* counts = lima_gp_sim_get_counts(sim, &num_instrs);
+	
+	printf("instruction counts:\n");
+	unsigned i;
+	for (i = 0; i < num_instrs; i++)
+		printf("\t%u: %lu\n", i, counts[i]);
+}
+
+static bool simulate(lima_shader_t* shader, const char* path,
+					 const options_t* options)
+{
+	lima_gp_sim_t* sim = lima_gp_sim_create(lima_shader_get_code(shader),
+											lima_shader_get_code_size(shader));
+	if (!sim)
+	{
+		fprintf(stderr, "%s: corrupt code\n", path);
+		return false;
+	}
+	
+	lima_shader_symbols_t* symbols = lima_shader_get_symbols(shader);
+	
+	bool success = false;
+	float* attributes = NULL, *varyings = NULL;
+	
+	if (!setup_uniforms(symbols, options, sim))
+		goto cleanup;
+	
+	attributes = setup_attributes(symbols, options);
+	varyings = malloc(options->num_vertices * LIMA_GP_SIM_NUM_VARYINGS * 4 *
+					  sizeof(float));
+	if (!attributes || !varyings)
+		goto cleanup;
+	
+	if (!lima_gp_sim_run(sim, attributes, varyings, options->num_vertices))
+	{
+		fprintf(stderr, "%s: a loop didn't terminate\n", path);
+		goto cleanup;
+	}
+	
+	unsigned num_instrs, i;
+	const unsigned long* counts = lima_gp_sim_get_counts(sim, &num_instrs);
+	unsigned long total = 0;
+	for (i = 0; i < num_instrs; i++)
+		total += counts[i];
+	
+	printf("%s: %u instructions, %u vertices, %lu instructions run "
+		   "(%.2f per vertex)\n", path, num_instrs, options->num_vertices,
+		   total, (double) total / options->num_vertices);
+	
+	print_varyings(symbols, varyings,
+				   options->num_print < options->num_vertices ?
+				   options->num_print : options->num_vertices);
+	
+	if (options->counts)
+		print_counts(sim);
+	
+	success = true;
+
+cleanup:
+	free(attributes);
+	free(varyings);
+	lima_gp_sim_delete(sim);
+	return success;
+}
+
+static bool run(lima_compiler_t* compiler, const char* path,
+				const options_t* options)
+{
+	char* source = read_file(path);
+	if (!source)
+	{
+		fprintf(stderr, "Error: could not read input file %s\n", path);
+		return false;
+	}
+	
+	lima_shader_t* shader = lima_shader_create(compiler,
+											   lima_shader_stage_vertex,
+											   lima_core_mali_400);
+	if (!shader)
+	{
+		free(source);
+		return false;
+	}
+	
+	bool success = false;
+	
+	lima_shader_parse(shader, source);
+	if (!lima_shader_error(shader))
+	{
+		lima_shader_optimize(shader);
+		lima_shader_compile(shader, false);
+	}
+	
+	if (lima_shader_error(shader))
+		fprintf(stderr, "%s: %s", path, lima_shader_info_log(shader));
+	else
+		success = simulate(shader, path, options);
+	
+	lima_shader_delete(shader);
+	free(source);
+	return success;
+}
+
+int main(int argc, char** argv)
+{
+	static options_t options;
+	options.num_vertices = 1;
+	options.num_print = 1;
+	options.seed = 1;
+	
+	static struct option long_options[] = {
+		{"vertices",  required_argument, NULL, 'n'},
+		{"print",     required_argument, NULL, 'p'},
+		{"seed",      required_argument, NULL, 's'},
+		{"attribute", required_argument, NULL, 'a'},
+		{"uniform",   required_argument, NULL, 'u'},
+		{"counts",    no_argument,       NULL, 'c'},
+		{"help",      no_argument,       NULL, 'h'},
+		{NULL,        0,                 NULL, 0}
+	};
+	
+	int c;
+	while ((c = getopt_long(argc, argv, "n:p:s:a:u:ch", long_options,
+							NULL)) != -1)
+	{
+		switch (c)
+		{
+			case 'n':
+				options.num_vertices = strtoul(optarg, NULL, 10);
+				if (options.num_vertices == 0)
+				{
+					fprintf(stderr, "Error: invalid vertex count %s\n", optarg);
+					return 1;
+				}
+				break;
+			
+			case 'p':
+				options.num_print = strtoul(optarg, NULL, 10);
+				break;
+			
+			case 's':
+				options.seed = strtoul(optarg, NULL, 10);
+				if (options.seed == 0)
+				{
+					fprintf(stderr, "Error: the seed must not be 0\n");
+					return 1;
+				}
+				break;
+			
+			case 'a':
+			case 'u':
+			{
+				input_t* inputs = c == 'a' ? options.attributes : options.uniforms;
+				unsigned* num_inputs =
+					c == 'a' ? &options.num_attributes : &options.num_uniforms;
+				if (*num_inputs == MAX_INPUTS ||
+					!parse_input(optarg, &inputs[*num_inputs]))
+				{
+					fprintf(stderr, "Error: invalid input %s\n", optarg);
+					return 1;
+				}
+				(*num_inputs)++;
+				break;
+			}
+			
+			case 'c':
+				options.counts = true;
+				break;
+			
+			case 'h':
+				usage();
+				return 0;
+			
+			default:
+				usage();
+				return 1;
+		}
+	}
+	
+	if (optind == argc)
+	{
+		fprintf(stderr, "Error: no inputs\n");
+		usage();
+		return 1;
+	}
+	
+	lima_compiler_t* compiler = lima_compiler_create();
+	if (!compiler)
+	{
+		fprintf(stderr, "Error: could not create the compiler\n");
+		return 1;
+	}
+	
+	int ret = 0;
+	int i;
+	for (i = optind; i < argc; i++)
+	{
+		if (!run(compiler, argv[i], &options))
+			ret = 1;
+	}
+	
+	lima_compiler_delete(compiler);
+	return ret;
+}
@@ -27,10 +27,12 @@
 #include <string.h>
 #include <getopt.h>
 #include <stdbool.h>
+#include <pthread.h>
 #include "shader.h"
 
 #define USAGE \
 "usage: limasc -t [vert|frag] -o [output] input \n" \
+"       limasc [-t [vert|frag]] [-j jobs] [-m manifest] inputs... \n" \
 "\n" \
 "options:\n" \
 "\t--type (-t) [vert|frag] -- choose which kind of shader\n" \
@@ -44,21 +46,64 @@
 "\t--dump-asm (-d) -- print out the resulting assembly\n" \
 "\t--syntax [verbose|explicit|decompile] -- " \
 "choose the syntax for the disassembly\n\n" \
-"\t\tFor vertex shaders: verbose will dump the raw fields, with\n" \
+"\t\tFor vertex shaders: explicit will dump the raw fields, with\n" \
 "\t\tlittle interpretation except for suppressing certain fields\n" \
-"\t\twhen they are unused. Explicit will print a more normal\n" \
+"\t\twhen they are unused. Verbose will print a more normal\n" \
 "\t\tassembly, but due to the nature of the instruction set it\n" \
 "\t\twill still be verbose and unreadable. Decompile will try to\n" \
 "\t\tproduce a more readable output at the expense of losing some\n" \
 "\t\tdetails (such as how efficient the assembly is).\n\n" \
-"\t\tFor fragment shaders: verbose will print out a more readable\n" \
+"\t\tFor fragment shaders: explicit will print out a more readable\n" \
 "\t\tassembly, but sometimes it will be less clear which instructions\n" \
-"\t\tare scheduled in which unit. The explicit syntax is more\n" \
+"\t\tare scheduled in which unit. The verbose syntax is more\n" \
 "\t\tassembly-like and easier to parse, but at the expense of being\n" \
 "\t\tless readable. Decompile is invalid for fragment shaders.\n\n" \
 "\t\tExplicit is the default for vertex shaders, while verbose is the \n" \
 "\t\tdefault for fragment shaders.\n\n" \
 "\t--output (-o) -- the output file. Defaults to out.mbs\n" \
+"\t--jobs (-j) [number] -- compile the inputs using this many threads.\n" \
+"\t\tDefault: 1\n" \
+"\t--manifest (-m) [file] -- read a list of inputs from a file, one per\n" \
+"\t\tline, each optionally followed by whitespace and the output file.\n" \
+"\t\tEmpty lines and lines starting with # are ignored.\n\n" \
+"\t\tWhen more than one input is given, the output of each input is\n" \
+"\t\twritten to the input path with .mbs appended unless the manifest\n" \
+"\t\tsays otherwise, --output and the dump options are not allowed,\n" \
+"\t\tand if no type is specified, it is guessed from the .vert or\n" \
+"\t\t.frag extension of each input.\n\n" \
+"\t--cache [directory] -- reuse the output of previous compilations,\n" \
+"\t\tstored in this directory. It may be shared between several\n" \
+"\t\tinstances of limasc running at once. Ignored when dumping or\n" \
+"\t\tmaking checkpoints.\n" \
+"\t--cache-size [megabytes] -- the most space the cache may use.\n" \
+"\t\tDefault: 64\n" \
+"\t--stats[=text|json] -- print how long each compiler pass took, how\n" \
+"\t\tmuch memory it used, and the size of the IR before and after it.\n" \
+"\t\tWith json, one object is printed per line for each input.\n" \
+"\t\tDefault: text\n" \
+"\t--report[=text|json] -- print a static estimate of the cost of the\n" \
+"\t\tcode: the cycles along the shortest and longest paths, how\n" \
+"\t\tmany slots of each unit are used, constant slots, temporary\n" \
+"\t\tloads and stores, and branches. Loops are counted once.\n" \
+"\t\tWith json, one object is printed per line for each input.\n" \
+"\t\tDefault: text\n" \
+"\t--trace [category,...] -- print what the compiler is doing to stderr.\n" \
+"\t\tThe categories are sched, regalloc, ir, symbols, and all.\n" \
+"\t--regalloc [graph|linear-scan] -- choose the register allocator.\n" \
+"\t\tLinear scan is faster, but the code is worse.\n" \
+"\t\tDefault: graph\n" \
+"\t-O [0|1|2|s] -- how hard to optimize. 0 only runs the passes needed\n" \
+"\t\tfor correct code, 1 skips the slowest passes, 2 runs all of\n" \
+"\t\tthem, and s tries harder to make the code small.\n" \
+"\t\tDefault: 2\n" \
+"\t--checkpoint -- stop once the shader is lowered to the backend IR, and\n" \
+"\t\twrite it out instead of the assembly, so that it can be compiled\n" \
+"\t\tlater with --resume. The default output file becomes out.ckpt,\n" \
+"\t\tor the input path with .ckpt appended.\n" \
+"\t--resume -- the inputs are checkpoints made with --checkpoint by the\n" \
+"\t\tsame limasc binary, so only the backend is run, using the options\n" \
+"\t\tgiven now. The type must match, and it is guessed from the .vert\n" \
+"\t\tor .frag extension before .ckpt.\n" \
 "\t--help (-h) -- print this message and quit.\n"
 
 static void usage(void)
@@ -66,7 +111,9 @@ static void usage(void)
 	fprintf(stderr, USAGE);
 }
 
-static char* read_file(const char* path)
+/* size, if not NULL, is set to the size without the terminating '\0' */
+
+static char* read_file(const char* path, unsigned* size)
 {
 	FILE* fp = fopen(path, "rb");
 	if (!fp) return NULL;
@@ -100,14 +147,583 @@ static char* read_file(const char* path)
 	data[fsize] = '\0';
 	
 	fclose(fp);
+	if (size)
+		*size = fsize;
 	return data;
 }
 
-static void shader_errors(lima_shader_t* shader)
+typedef struct
+{
+	const char* infile;
+	const char* outfile;
+	lima_shader_stage_e stage;
+	bool success;
+	
+	/* the paths that were allocated rather than taken from argv, freed once
+	 * all the jobs are done */
+	char* infile_alloc, *outfile_alloc;
+} job_t;
+
+typedef enum
+{
+	stats_none,
+	stats_text,
+	stats_json
+} stats_format_e;
+
+typedef struct
+{
+	lima_compiler_t* compiler;
+	lima_core_e core;
+	lima_regalloc_e regalloc;
+	lima_opt_level_e opt_level;
+	bool dump_hir, dump_lir, dump_ir, dump_asm;
+	lima_asm_syntax_e syntax;
+	stats_format_e stats, report;
+	unsigned trace; /* lima_trace_category_e bits */
+	bool checkpoint, resume;
+	
+	/* keeps the stats and reports of different shaders from being
+	 * interleaved */
+	pthread_mutex_t output_lock;
+	
+	job_t* jobs;
+	unsigned num_jobs, jobs_capacity;
+	
+	/* protects next_job */
+	pthread_mutex_t lock;
+	unsigned next_job;
+} batch_t;
+
+static job_t* add_job(batch_t* batch, const char* infile, const char* outfile,
+					  lima_shader_stage_e stage)
+{
+	if (batch->num_jobs == batch->jobs_capacity)
+	{
+		unsigned new_capacity = batch->jobs_capacity ? 2 * batch->jobs_capacity : 16;
+		job_t* new_jobs = realloc(batch->jobs, new_capacity * sizeof(job_t));
+		if (!new_jobs)
+			return NULL;
+		batch->jobs = new_jobs;
+		batch->jobs_capacity = new_capacity;
+	}
+	
+	job_t* job = &batch->jobs[batch->num_jobs++];
+	job->infile = infile;
+	job->outfile = outfile;
+	job->stage = stage;
+	job->success = false;
+	job->infile_alloc = NULL;
+	job->outfile_alloc = NULL;
+	return job;
+}
+
+static void free_jobs(batch_t* batch)
+{
+	unsigned i;
+	for (i = 0; i < batch->num_jobs; i++)
+	{
+		free(batch->jobs[i].infile_alloc);
+		free(batch->jobs[i].outfile_alloc);
+	}
+	
+	free(batch->jobs);
+	batch->jobs = NULL;
+	batch->num_jobs = batch->jobs_capacity = 0;
+}
+
+static bool has_suffix(const char* str, const char* suffix)
+{
+	size_t len = strlen(str), suffix_len = strlen(suffix);
+	return len >= suffix_len && strcmp(str + len - suffix_len, suffix) == 0;
+}
+
+static lima_shader_stage_e stage_from_path(const char* path)
+{
+	if (has_suffix(path, ".vert") || has_suffix(path, ".vert.ckpt"))
+		return lima_shader_stage_vertex;
+	if (has_suffix(path, ".frag") || has_suffix(path, ".frag.ckpt"))
+		return lima_shader_stage_fragment;
+	return lima_shader_stage_unknown;
+}
+
+/* reads a manifest, and adds a job for every input listed in it */
+
+static bool read_manifest(batch_t* batch, const char* path,
+						  lima_shader_stage_e stage)
+{
+	char* data = read_file(path, NULL);
+	if (!data)
+		return false;
+	
+	char* line = data;
+	while (*line)
+	{
+		char* next = strchr(line, '\n');
+		if (next)
+			*next++ = '\0';
+		else
+			next = line + strlen(line);
+		
+		char* saveptr;
+		char* infile = strtok_r(line, " \t\r", &saveptr);
+		if (infile && infile[0] != '#')
+		{
+			char* outfile = strtok_r(NULL, " \t\r", &saveptr);
+			char* infile_copy = strdup(infile);
+			char* outfile_copy = outfile ? strdup(outfile) : NULL;
+			job_t* job = NULL;
+			if (infile_copy && (!outfile || outfile_copy))
+				job = add_job(batch, infile_copy, outfile_copy, stage);
+			if (!job)
+			{
+				free(infile_copy);
+				free(outfile_copy);
+				free(data);
+				return false;
+			}
+			
+			job->infile_alloc = infile_copy;
+			job->outfile_alloc = outfile_copy;
+		}
+		
+		line = next;
+	}
+	
+	free(data);
+	return true;
+}
+
+static void shader_errors(job_t* job, lima_shader_t* shader)
+{
+	fprintf(stderr, "There were error(s) during compilation of %s.\n"
+			"Info log:\n%s", job->infile, lima_shader_info_log(shader));
+}
+
+static FILE* open_output(const char* outfile)
+{
+	FILE* fp = fopen(outfile, "wb");
+	if (!fp)
+		fprintf(stderr, "Failed to open output file %s\n", outfile);
+	return fp;
+}
+
+static bool write_file(const char* outfile, const void* data, unsigned size)
+{
+	FILE* fp = open_output(outfile);
+	if (!fp)
+		return false;
+	
+	fwrite(data, 1, size, fp);
+	
+	fclose(fp);
+	return true;
+}
+
+static bool write_output(const char* outfile, lima_shader_t* shader)
+{
+	mbs_chunk_t* chunk = lima_shader_export_offline(shader);
+	if (!chunk)
+		return false;
+	
+	FILE* fp = open_output(outfile);
+	if (!fp)
+	{
+		mbs_chunk_delete(chunk);
+		return false;
+	}
+	
+	bool ret = mbs_chunk_write(chunk, fp);
+	if (fclose(fp) != 0)
+		ret = false;
+	if (!ret)
+		fprintf(stderr, "Failed to write output file %s\n", outfile);
+	
+	mbs_chunk_delete(chunk);
+	return ret;
+}
+
+static bool write_checkpoint(const char* outfile, lima_shader_t* shader)
+{
+	unsigned size;
+	void* data = lima_shader_checkpoint(shader, &size);
+	if (!data)
+		return false;
+	
+	bool ret = write_file(outfile, data, size);
+	free(data);
+	return ret;
+}
+
+static void print_json_string(const char* str)
+{
+	putchar('"');
+	for (; *str; str++)
+	{
+		if (*str == '"' || *str == '\\')
+			printf("\\%c", *str);
+		else if ((unsigned char) *str < 0x20)
+			printf("\\u%04x", *str);
+		else
+			putchar(*str);
+	}
+	putchar('"');
+}
+
+static void print_stats_json(job_t* job, const lima_shader_stats_t* stats)
+{
+	printf("{\"input\": ");
+	print_json_string(job->infile);
+	printf(", \"cached\": %s, \"total_time\": %g, \"peak_heap\": %lu, "
+		   "\"sched_restarts\": %u, \"sched_nodes_undone\": %u, "
+		   "\"spill_iterations\": %u, \"passes\": [",
+		   stats->cached ? "true" : "false", stats->total_time,
+		   stats->peak_heap, stats->sched_restarts, stats->sched_nodes_undone,
+		   stats->spill_iterations);
+	
+	unsigned i;
+	for (i = 0; i < stats->num_passes; i++)
+	{
+		const lima_pass_stats_t* pass = &stats->passes[i];
+		printf("%s{\"name\": ", i ? ", " : "");
+		print_json_string(pass->name);
+		printf(", \"runs\": %u, \"time\": %g, \"heap_delta\": %ld, "
+			   "\"peak_heap\": %lu, "
+			   "\"size_before\": %u, \"size_after\": %u, "
+			   "\"regs_before\": %u, \"regs_after\": %u}",
+			   pass->runs, pass->time, pass->heap_delta, pass->peak_heap,
+			   pass->size_before, pass->size_after,
+			   pass->regs_before, pass->regs_after);
+	}
+	
+	printf("]}\n");
+}
+
+static void print_stats_text(job_t* job, const lima_shader_stats_t* stats)
+{
+	printf("Stats for %s%s:\n", job->infile,
+		   stats->cached ? " (cached)" : "");
+	printf("%-40s %4s %10s %10s %10s %15s %15s\n", "pass", "runs",
+		   "time (ms)", "heap (KiB)", "peak (KiB)", "size", "regs");
+	
+	unsigned i;
+	for (i = 0; i < stats->num_passes; i++)
+	{
+		const lima_pass_stats_t* pass = &stats->passes[i];
+		printf("%-40s %4u %10.3f %10.1f %10.1f %7u->%-7u %7u->%-7u\n",
+			   pass->name, pass->runs, pass->time * 1000.,
+			   pass->heap_delta / 1024., pass->peak_heap / 1024.,
+			   pass->size_before, pass->size_after,
+			   pass->regs_before, pass->regs_after);
+	}
+	
+	printf("total time: %.3f ms, peak heap: %.1f KiB, "
+		   "scheduler restarts: %u (%u nodes undone), "
+		   "spill iterations: %u\n\n",
+		   stats->total_time * 1000., stats->peak_heap / 1024.,
+		   stats->sched_restarts, stats->sched_nodes_undone,
+		   stats->spill_iterations);
+}
+
+static void print_stats(batch_t* batch, job_t* job, lima_shader_t* shader)
+{
+	const lima_shader_stats_t* stats = lima_shader_get_stats(shader);
+	if (!stats)
+		return;
+	
+	pthread_mutex_lock(&batch->output_lock);
+	if (batch->stats == stats_json)
+		print_stats_json(job, stats);
+	else
+		print_stats_text(job, stats);
+	fflush(stdout);
+	pthread_mutex_unlock(&batch->output_lock);
+}
+
+typedef struct
+{
+	const char* name;
+	const lima_slot_usage_t* usage;
+} unit_t;
+
+/* the most units of any stage, plus the constants */
+#define MAX_UNITS 9
+
+/* returns the number of units */
+
+static unsigned get_units(lima_shader_stage_e stage,
+						  const lima_shader_report_t* report, unit_t* units)
+{
+	unsigned num = 0;
+	
+#define UNIT(stage, unit) \
+	units[num].name = #unit; \
+	units[num].usage = &report->units.stage.unit; \
+	num++
+	
+	if (stage == lima_shader_stage_vertex)
+	{
+		UNIT(vs, mul);
+		UNIT(vs, add);
+		UNIT(vs, complex);
+		UNIT(vs, pass);
+		UNIT(vs, load);
+	}
+	else
+	{
+		UNIT(fs, varying);
+		UNIT(fs, texld);
+		UNIT(fs, uniform);
+		UNIT(fs, vmul);
+		UNIT(fs, fmul);
+		UNIT(fs, vadd);
+		UNIT(fs, fadd);
+		UNIT(fs, combine);
+	}
+	
+#undef UNIT
+	
+	return num;
+}
+
+static double percent(const lima_slot_usage_t* usage)
+{
+	return usage->total ? 100. * usage->used / usage->total : 0.;
+}
+
+static void print_report_json(job_t* job, lima_shader_stage_e stage,
+							  const lima_shader_report_t* report)
+{
+	printf("{\"input\": ");
+	print_json_string(job->infile);
+	printf(", \"instructions\": %u, \"min_cycles\": %u, "
+		   "\"max_cycles\": %u, \"has_loops\": %s, \"branches\": %u, "
+		   "\"const_slots\": {\"used\": %u, \"total\": %u}, "
+		   "\"temp_loads\": %u, \"temp_stores\": %u, \"units\": {",
+		   report->num_instructions, report->min_cycles, report->max_cycles,
+		   report->has_loops ? "true" : "false", report->branches,
+		   report->const_slots.used, report->const_slots.total,
+		   report->temp_loads, report->temp_stores);
+	
+	unit_t units[MAX_UNITS];
+	unsigned i, num_units = get_units(stage, report, units);
+	for (i = 0; i < num_units; i++)
+		printf("%s\"%s\": {\"used\": %u, \"total\": %u}", i ? ", " : "",
+			   units[i].name, units[i].usage->used, units[i].usage->total);
+	
+	printf("}}\n");
+}
+
+static void print_report_text(job_t* job, lima_shader_stage_e stage,
+							  const lima_shader_report_t* report)
+{
+	printf("Report for %s:\n", job->infile);
+	printf("instructions: %u, cycles: %u shortest, %u longest%s\n",
+		   report->num_instructions, report->min_cycles, report->max_cycles,
+		   report->has_loops ? " (loops counted once)" : "");
+	printf("branches: %u, temporary loads: %u, temporary stores: %u\n",
+		   report->branches, report->temp_loads, report->temp_stores);
+	
+	unit_t units[MAX_UNITS];
+	unsigned i, num_units = get_units(stage, report, units);
+	if (stage == lima_shader_stage_fragment)
+	{
+		units[num_units].name = "constants";
+		units[num_units].usage = &report->const_slots;
+		num_units++;
+	}
+	
+	printf("%-10s %8s %8s %6s\n", "unit", "used", "slots", "%");
+	for (i = 0; i < num_units; i++)
+		printf("%-10s %8u %8u %6.1f\n", units[i].name, units[i].usage->used,
+			   units[i].usage->total, percent(units[i].usage));
+	printf("\n");
+}
+
+static void print_report(batch_t* batch, job_t* job, lima_shader_t* shader)
+{
+	lima_shader_report_t report;
+	if (!lima_shader_get_report(shader, &report))
+		return;
+	
+	lima_shader_stage_e stage = lima_shader_get_stage(shader);
+	
+	pthread_mutex_lock(&batch->output_lock);
+	if (batch->report == stats_json)
+		print_report_json(job, stage, &report);
+	else
+		print_report_text(job, stage, &report);
+	fflush(stdout);
+	pthread_mutex_unlock(&batch->output_lock);
+}
+
+static const struct {
+	const char* name;
+	lima_trace_category_e category;
+} trace_categories[] = {
+	{"sched",    lima_trace_sched},
+	{"regalloc", lima_trace_regalloc},
+	{"ir",       lima_trace_ir},
+	{"symbols",  lima_trace_symbols},
+	{"all",      lima_trace_all},
+};
+
+/* parses a comma-separated list of trace categories, returns 0 on error */
+
+static unsigned parse_trace(const char* arg)
+{
+	unsigned ret = 0;
+	
+	while (*arg)
+	{
+		size_t len = strcspn(arg, ",");
+		unsigned i, num = sizeof(trace_categories) / sizeof(trace_categories[0]);
+		for (i = 0; i < num; i++)
+			if (strlen(trace_categories[i].name) == len &&
+				strncmp(trace_categories[i].name, arg, len) == 0)
+				break;
+		
+		if (i == num)
+			return 0;
+		
+		ret |= trace_categories[i].category;
+		arg += len;
+		if (*arg == ',')
+			arg++;
+	}
+	
+	return ret;
+}
+
+static void trace_sink(lima_trace_category_e category, const char* text,
+					   unsigned size, void* data)
+{
+	(void) category;
+	(void) data;
+	fwrite(text, 1, size, stderr);
+}
+
+static void disasm_sink(const char* text, unsigned size, void* data)
+{
+	fwrite(text, 1, size, data);
+}
+
+static bool compile_job(batch_t* batch, job_t* job)
+{
+	unsigned source_size;
+	char* source = read_file(job->infile, &source_size);
+	if (!source)
+	{
+		fprintf(stderr, "Error: could not read input file %s\n", job->infile);
+		return false;
+	}
+	
+	lima_shader_t* shader = lima_shader_create(batch->compiler, job->stage,
+											   batch->core);
+	if (!shader)
+	{
+		free(source);
+		return false;
+	}
+	
+	bool success = false;
+	
+	if (batch->stats != stats_none)
+		lima_shader_enable_stats(shader);
+	
+	if (batch->trace)
+		lima_shader_set_trace(shader, batch->trace, trace_sink, NULL);
+	
+	lima_shader_set_regalloc(shader, batch->regalloc);
+	lima_shader_set_opt_level(shader, batch->opt_level);
+	
+	if (batch->resume)
+		lima_shader_resume(shader, source, source_size);
+	else
+		lima_shader_parse(shader, source);
+	if (lima_shader_error(shader))
+	{
+		shader_errors(job, shader);
+		goto cleanup;
+	}
+	
+	if (batch->dump_hir)
+	{
+		printf("HIR:\n\n");
+		lima_shader_print_glsl(shader);
+		printf("\n\n");
+	}
+	
+	lima_shader_optimize(shader);
+	
+	if (batch->dump_lir)
+	{
+		printf("LIR:\n\n");
+		lima_shader_print_glsl(shader);
+		printf("\n\n");
+	}
+	
+	if (batch->checkpoint)
+	{
+		success = write_checkpoint(job->outfile, shader);
+		if (lima_shader_error(shader))
+			shader_errors(job, shader);
+	}
+	else
+	{
+		lima_shader_compile(shader, batch->dump_ir);
+		
+		if (lima_shader_error(shader))
+		{
+			shader_errors(job, shader);
+			goto cleanup;
+		}
+		
+		if (batch->dump_asm)
+		{
+			printf("Assembly:\n\n");
+			if (!lima_disassemble(job->stage, batch->syntax,
+								  lima_shader_get_code(shader),
+								  lima_shader_get_code_size(shader),
+								  disasm_sink, stdout))
+				fprintf(stderr, "Error: could not disassemble %s\n",
+						job->infile);
+			printf("\n\n");
+		}
+		
+		success = write_output(job->outfile, shader);
+	}
+	
+	if (success && batch->stats != stats_none)
+		print_stats(batch, job, shader);
+	
+	if (success && batch->report != stats_none && !batch->checkpoint)
+		print_report(batch, job, shader);
+	
+cleanup:
+	lima_shader_delete(shader);
+	free(source);
+	return success;
+}
+
+static void* worker(void* data)
 {
-	fprintf(stderr, "There were error(s) during compilation.\n");
-	fprintf(stderr, "Info log:\n%s", lima_shader_info_log(shader));
-	exit(1);
+	batch_t* batch = data;
+	
+	while (true)
+	{
+		pthread_mutex_lock(&batch->lock);
+		unsigned index = batch->next_job++;
+		pthread_mutex_unlock(&batch->lock);
+		
+		if (index >= batch->num_jobs)
+			break;
+		
+		job_t* job = &batch->jobs[index];
+		job->success = compile_job(batch, job);
+	}
+	
+	return NULL;
 }
 
 int main(int argc, char** argv)
@@ -117,7 +733,15 @@ int main(int argc, char** argv)
 	lima_core_e core = lima_core_mali_400;
 	lima_asm_syntax_e syntax = lima_asm_syntax_unknown;
 	char* outfile = NULL;
-	char* infile = NULL;
+	char* manifest = NULL;
+	unsigned num_threads = 1;
+	char* cache_dir = NULL;
+	unsigned long cache_size = 64;
+	stats_format_e stats = stats_none, report = stats_none;
+	unsigned trace = 0;
+	lima_regalloc_e regalloc = lima_regalloc_graph;
+	lima_opt_level_e opt_level = lima_opt_level_2;
+	bool checkpoint = false, resume = false;
 	
 	static struct option long_options[] = {
 		{"type",     required_argument, NULL, 't'},
@@ -128,6 +752,16 @@ int main(int argc, char** argv)
 		{"dump-asm", no_argument,       NULL, 'd'},
 		{"syntax",   required_argument, NULL, 's'},
 		{"output",   required_argument, NULL, 'o'},
+		{"jobs",     required_argument, NULL, 'j'},
+		{"manifest", required_argument, NULL, 'm'},
+		{"cache",    required_argument, NULL, 'C'},
+		{"cache-size", required_argument, NULL, 'S'},
+		{"stats",    optional_argument, NULL, 'T'},
+		{"report",   optional_argument, NULL, 'P'},
+		{"trace",    required_argument, NULL, 'R'},
+		{"regalloc", required_argument, NULL, 'A'},
+		{"checkpoint", no_argument,     NULL, 'K'},
+		{"resume",   no_argument,       NULL, 'U'},
 		{"help",     no_argument,       NULL, 'h'},
 		{0, 0, 0, 0}
 	};
@@ -136,7 +770,8 @@ int main(int argc, char** argv)
 	{
 		int option_index = 0;
 		
-		int c = getopt_long(argc, argv, "t:c:ds:o:h", long_options, &option_index);
+		int c = getopt_long(argc, argv, "t:c:ds:o:j:m:O:h", long_options,
+							&option_index);
 		
 		if (c == -1)
 			break;
@@ -167,6 +802,7 @@ int main(int argc, char** argv)
 					usage();
 					exit(1);
 				}
+				break;
 			
 			case 'd':
 				dump_asm = true;
@@ -210,6 +846,125 @@ int main(int argc, char** argv)
 				outfile = optarg;
 				break;
 				
+			case 'j':
+			{
+				char* end;
+				long jobs = strtol(optarg, &end, 10);
+				if (*end != '\0' || jobs <= 0)
+				{
+					fprintf(stderr, "Error: invalid number of jobs %s\n", optarg);
+					usage();
+					exit(1);
+				}
+				num_threads = jobs;
+				break;
+			}
+				
+			case 'm':
+				if (manifest)
+				{
+					fprintf(stderr, "Error: manifest specified more than once\n");
+					usage();
+					exit(1);
+				}
+				manifest = optarg;
+				break;
+				
+			case 'C':
+				cache_dir = optarg;
+				break;
+				
+			case 'S':
+			{
+				char* end;
+				long size = strtol(optarg, &end, 10);
+				if (*end != '\0' || size <= 0)
+				{
+					fprintf(stderr, "Error: invalid cache size %s\n", optarg);
+					usage();
+					exit(1);
+				}
+				cache_size = size;
+				break;
+			}
+				
+			case 'T':
+				if (!optarg || strcmp(optarg, "text") == 0)
+					stats = stats_text;
+				else if (strcmp(optarg, "json") == 0)
+					stats = stats_json;
+				else
+				{
+					fprintf(stderr, "Error: unknown stats format %s\n", optarg);
+					usage();
+					exit(1);
+				}
+				break;
+				
+			case 'P':
+				if (!optarg || strcmp(optarg, "text") == 0)
+					report = stats_text;
+				else if (strcmp(optarg, "json") == 0)
+					report = stats_json;
+				else
+				{
+					fprintf(stderr, "Error: unknown report format %s\n", optarg);
+					usage();
+					exit(1);
+				}
+				break;
+				
+			case 'R':
+				trace = parse_trace(optarg);
+				if (!trace)
+				{
+					fprintf(stderr, "Error: unknown trace category in %s\n",
+							optarg);
+					usage();
+					exit(1);
+				}
+				break;
+				
+			case 'A':
+				if (strcmp(optarg, "graph") == 0)
+					regalloc = lima_regalloc_graph;
+				else if (strcmp(optarg, "linear-scan") == 0)
+					regalloc = lima_regalloc_linear_scan;
+				else
+				{
+					fprintf(stderr, "Error: unknown register allocator %s\n",
+							optarg);
+					usage();
+					exit(1);
+				}
+				break;
+				
+			case 'O':
+				if (strcmp(optarg, "0") == 0)
+					opt_level = lima_opt_level_0;
+				else if (strcmp(optarg, "1") == 0)
+					opt_level = lima_opt_level_1;
+				else if (strcmp(optarg, "2") == 0)
+					opt_level = lima_opt_level_2;
+				else if (strcmp(optarg, "s") == 0)
+					opt_level = lima_opt_level_size;
+				else
+				{
+					fprintf(stderr, "Error: unknown optimization level -O%s\n",
+							optarg);
+					usage();
+					exit(1);
+				}
+				break;
+				
+			case 'K':
+				checkpoint = true;
+				break;
+				
+			case 'U':
+				resume = true;
+				break;
+				
 			case 'h':
 				usage();
 				exit(0);
@@ -224,107 +979,198 @@ int main(int argc, char** argv)
 		}
 	}
 	
-	if (stage == lima_shader_stage_unknown)
+	if (checkpoint && resume)
 	{
-		fprintf(stderr, "Error: no shader type specified\n");
+		fprintf(stderr, "Error: --checkpoint cannot be used with --resume\n");
 		usage();
 		exit(1);
 	}
 	
-	if (syntax == lima_asm_syntax_unknown)
-	{
-		switch (stage)
-		{
-			case lima_shader_stage_vertex:
-				syntax = lima_asm_syntax_explicit;
-				break;
-			
-			case lima_shader_stage_fragment:
-				syntax = lima_asm_syntax_verbose;
-				break;
-				
-			default:
-				abort();
-		}
-	}
-	
-	if (optind == argc)
+	if (resume && (dump_hir || dump_lir))
 	{
-		fprintf(stderr, "Error: no input specified\n");
+		fprintf(stderr, "Error: checkpoints have no GLSL IR to dump\n");
 		usage();
 		exit(1);
 	}
 	
-	if (optind < argc - 1)
+	const char* out_ext = checkpoint ? ".ckpt" : ".mbs";
+	
+	batch_t batch;
+	memset(&batch, 0, sizeof(batch));
+	batch.core = core;
+	batch.regalloc = regalloc;
+	batch.opt_level = opt_level;
+	batch.dump_hir = dump_hir;
+	batch.dump_lir = dump_lir;
+	batch.dump_ir = dump_ir;
+	batch.dump_asm = dump_asm;
+	batch.stats = stats;
+	batch.report = report;
+	batch.trace = trace;
+	batch.checkpoint = checkpoint;
+	batch.resume = resume;
+	pthread_mutex_init(&batch.lock, NULL);
+	pthread_mutex_init(&batch.output_lock, NULL);
+	
+	int i;
+	for (i = optind; i < argc; i++)
+		if (!add_job(&batch, argv[i], NULL, stage))
+			return 1;
+	
+	if (manifest && !read_manifest(&batch, manifest, stage))
 	{
-		fprintf(stderr, "Error: more than one input specified\n");
+		fprintf(stderr, "Error: could not read manifest %s\n", manifest);
 		usage();
 		exit(1);
 	}
 	
-	infile = argv[optind];
-	if (!outfile)
-		outfile = "out.mbs";
-	
-	char* source = read_file(infile);
-	if (!source)
+	if (batch.num_jobs == 0)
 	{
-		fprintf(stderr, "Error: could not read input file %s\n", infile);
+		fprintf(stderr, "Error: no input specified\n");
 		usage();
 		exit(1);
 	}
 	
-	lima_shader_t* shader = lima_shader_create(stage, core);
-	lima_shader_parse(shader, source);
-	if (lima_shader_error(shader))
-		shader_errors(shader);
-	
-	if (dump_hir)
+	if (batch.num_jobs == 1 && !manifest)
 	{
-		printf("HIR:\n\n");
-		lima_shader_print_glsl(shader);
-		printf("\n\n");
+		/* checkpoints are always named after the type of the shader */
+		if (stage == lima_shader_stage_unknown && resume)
+		{
+			stage = stage_from_path(batch.jobs[0].infile);
+			batch.jobs[0].stage = stage;
+		}
+		
+		if (stage == lima_shader_stage_unknown)
+		{
+			fprintf(stderr, "Error: no shader type specified\n");
+			usage();
+			exit(1);
+		}
+		
+		if (syntax == lima_asm_syntax_unknown)
+		{
+			switch (stage)
+			{
+				case lima_shader_stage_vertex:
+					syntax = lima_asm_syntax_explicit;
+					break;
+				
+				case lima_shader_stage_fragment:
+					syntax = lima_asm_syntax_verbose;
+					break;
+					
+				default:
+					abort();
+			}
+		}
+		
+		if (stage == lima_shader_stage_fragment &&
+			syntax == lima_asm_syntax_decompile)
+		{
+			fprintf(stderr, "Error: decompile is invalid for fragment shaders\n");
+			usage();
+			exit(1);
+		}
+		
+		batch.syntax = syntax;
+		
+		if (outfile)
+			batch.jobs[0].outfile = outfile;
+		else
+			batch.jobs[0].outfile = checkpoint ? "out.ckpt" : "out.mbs";
 	}
-	
-	lima_shader_optimize(shader);
-	
-	if (dump_lir)
+	else
 	{
-		printf("LIR:\n\n");
-		lima_shader_print_glsl(shader);
-		printf("\n\n");
+		if (outfile)
+		{
+			fprintf(stderr, "Error: --output cannot be used with more than one input\n");
+			usage();
+			exit(1);
+		}
+		
+		if (dump_hir || dump_lir || dump_ir || dump_asm)
+		{
+			fprintf(stderr, "Error: dump options cannot be used with more than one input\n");
+			usage();
+			exit(1);
+		}
+		
+		unsigned j;
+		for (j = 0; j < batch.num_jobs; j++)
+		{
+			job_t* job = &batch.jobs[j];
+			
+			if (job->stage == lima_shader_stage_unknown)
+				job->stage = stage_from_path(job->infile);
+			
+			if (job->stage == lima_shader_stage_unknown)
+			{
+				fprintf(stderr, "Error: could not guess the shader type of %s\n",
+						job->infile);
+				usage();
+				exit(1);
+			}
+			
+			if (!job->outfile)
+			{
+				char* path = malloc(strlen(job->infile) + strlen(out_ext) + 1);
+				if (!path)
+					return 1;
+				strcpy(path, job->infile);
+				strcat(path, out_ext);
+				job->outfile = job->outfile_alloc = path;
+			}
+		}
 	}
 	
-	lima_shader_compile(shader, dump_ir);
-	
-	if (lima_shader_error(shader))
-		shader_errors(shader);
-	
-	mbs_chunk_t* chunk = lima_shader_export_offline(shader);
-	if (!chunk)
+	batch.compiler = lima_compiler_create();
+	if (!batch.compiler)
 		return 1;
 	
-	unsigned size = mbs_chunk_size(chunk);
-	void* data = malloc(size);
-	if (!data)
-		return 1;
+	/* a cached shader has no IR left to dump or checkpoint */
+	if (cache_dir && !(dump_hir || dump_lir || dump_ir || checkpoint) &&
+		!lima_compiler_set_cache(batch.compiler, cache_dir, cache_size << 20))
+		fprintf(stderr, "Warning: could not open cache directory %s\n",
+				cache_dir);
 	
-	mbs_chunk_export(chunk, data);
-	mbs_chunk_delete(chunk);
+	if (num_threads > batch.num_jobs)
+		num_threads = batch.num_jobs;
 	
-	FILE* fp = fopen(outfile, "wb");
-	if (!fp)
+	if (num_threads == 1)
+		worker(&batch);
+	else
 	{
-		fprintf(stderr, "Failed to open output file\n");
-		return 1;
+		pthread_t* threads = malloc(num_threads * sizeof(pthread_t));
+		if (!threads)
+			return 1;
+		
+		unsigned j;
+		for (j = 0; j < num_threads; j++)
+		{
+			if (pthread_create(&threads[j], NULL, worker, &batch) != 0)
+			{
+				fprintf(stderr, "Error: could not create thread\n");
+				return 1;
+			}
+		}
+		
+		for (j = 0; j < num_threads; j++)
+			pthread_join(threads[j], NULL);
+		
+		free(threads);
 	}
 	
-	fwrite(data, 1, size, fp);
+	lima_compiler_delete(batch.compiler);
 	
-	fclose(fp);
-	free(data);
-	free(source);
-	lima_shader_delete(shader);
+	unsigned j;
+	int ret = 0;
+	for (j = 0; j < batch.num_jobs; j++)
+		if (!batch.jobs[j].success)
+			ret = 1;
+	
+	free_jobs(&batch);
+	pthread_mutex_destroy(&batch.lock);
+	pthread_mutex_destroy(&batch.output_lock);
 	
-	return 0;
+	return ret;
 }
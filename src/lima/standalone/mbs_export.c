@@ -211,8 +211,8 @@ static mbs_chunk_t* export_cver(lima_shader_t* shader)
 	if (!code_chunk)
 		goto err_mem;
 	
-	if (!mbs_chunk_append_data(code_chunk, lima_shader_get_code(shader),
-							   lima_shader_get_code_size(shader)))
+	if (!mbs_chunk_append_ref(code_chunk, lima_shader_get_code(shader),
+							  lima_shader_get_code_size(shader)))
 	{
 		mbs_chunk_delete(code_chunk);
 		goto err_mem;
@@ -314,8 +314,8 @@ static mbs_chunk_t* export_cfra(lima_shader_t* shader)
 	if (!code_chunk)
 		goto err_mem;
 	
-	if (!mbs_chunk_append_data(code_chunk, lima_shader_get_code(shader),
-							   lima_shader_get_code_size(shader)))
+	if (!mbs_chunk_append_ref(code_chunk, lima_shader_get_code(shader),
+							  lima_shader_get_code_size(shader)))
 	{
 		mbs_chunk_delete(code_chunk);
 		goto err_mem;
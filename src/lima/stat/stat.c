@@ -0,0 +1,876 @@
+/* Author(s):
+ *   Connor Abbott
+ *
+ * Copyright (c) 2014 Connor Abbott (connor@abbott.cx)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Statistics over a corpus of compiled MBS files. Each file is mapped into
+ * memory, the chunk tree written by standalone/mbs_export.c is walked to find
+ * the symbol tables and the code, and the code is decoded one instruction at
+ * a time to count how often each unit is used. Files are spread over a pool
+ * of threads, each writing the stats for a file into that file's own slot, so
+ * the only thing the threads share is the index of the next file to take.
+ * The totals are summed up once all the threads are done.
+ */
+
+#define _XOPEN_SOURCE 700
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <ftw.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "shader.h"
+#include "pp/lima_pp.h"
+#include "gp/lima_gp.h"
+
+#define USAGE \
+"usage: limastat [options] inputs...\n" \
+"\n" \
+"options:\n" \
+"\t--format (-f) [csv|json] -- the output format. Default: csv\n" \
+"\t--summary (-s) -- only print the totals for each shader type,\n" \
+"\t\tnot a row for every input.\n" \
+"\t--jobs (-j) [number] -- analyze the inputs using this many threads.\n" \
+"\t\tDefault: the number of online processors\n" \
+"\t--help (-h) -- print this message and quit.\n" \
+"\n" \
+"Inputs may be MBS files or directories, which are searched recursively\n" \
+"for files ending in .mbs. Files that can't be read or aren't valid MBS\n" \
+"are reported on stderr and left out of the totals.\n"
+
+static void usage(void)
+{
+	fprintf(stderr, USAGE);
+}
+
+/* what the vertex shader units are counted as */
+
+typedef enum {
+	gp_unit_mul0,
+	gp_unit_mul1,
+	gp_unit_acc0,
+	gp_unit_acc1,
+	gp_unit_complex,
+	gp_unit_pass,
+	gp_unit_store0,
+	gp_unit_store1,
+	gp_unit_load,
+	gp_unit_register,
+	gp_unit_branch,
+	gp_unit_count
+} gp_unit_e;
+
+static const char* gp_unit_name[gp_unit_count] = {
+	"mul0",
+	"mul1",
+	"acc0",
+	"acc1",
+	"complex",
+	"pass",
+	"store0",
+	"store1",
+	"load",
+	"register",
+	"branch"
+};
+
+typedef struct
+{
+	lima_shader_stage_e stage;
+	lima_core_e core;
+	bool core_known;
+	
+	unsigned code_size, num_instrs;
+	
+	/* how many instructions use each unit */
+	unsigned pp_units[lima_pp_field_count];
+	unsigned gp_units[gp_unit_count];
+	
+	unsigned branches, discards;
+	unsigned const_slots; /* fragment shader embedded constants */
+	unsigned stack_size; /* from the FSTA chunk */
+	unsigned temp_loads; /* fragment shaders only */
+	unsigned temp_stores;
+	
+	unsigned num_uniforms, uniform_size;
+	unsigned num_attributes, num_varyings;
+} mbs_stats_t;
+
+typedef struct
+{
+	const char* path;
+	bool success;
+	mbs_stats_t stats;
+} job_t;
+
+typedef struct
+{
+	job_t* jobs;
+	unsigned num_jobs, jobs_capacity;
+	
+	/* protects next_job */
+	pthread_mutex_t lock;
+	unsigned next_job;
+} batch_t;
+
+static bool add_job(batch_t* batch, const char* path)
+{
+	if (batch->num_jobs == batch->jobs_capacity)
+	{
+		unsigned new_capacity = batch->jobs_capacity ? 2 * batch->jobs_capacity : 64;
+		job_t* new_jobs = realloc(batch->jobs, new_capacity * sizeof(job_t));
+		if (!new_jobs)
+			return false;
+		batch->jobs = new_jobs;
+		batch->jobs_capacity = new_capacity;
+	}
+	
+	job_t* job = &batch->jobs[batch->num_jobs++];
+	job->path = path;
+	job->success = false;
+	return true;
+}
+
+static bool has_suffix(const char* str, const char* suffix)
+{
+	size_t len = strlen(str), suffix_len = strlen(suffix);
+	return len >= suffix_len && strcmp(str + len - suffix_len, suffix) == 0;
+}
+
+/* nftw() has no way to pass data to the callback */
+static batch_t* walk_batch;
+
+static int walk_callback(const char* path, const struct stat* st, int type,
+						 struct FTW* ftw)
+{
+	(void) st;
+	(void) ftw;
+	
+	if (type != FTW_F || !has_suffix(path, ".mbs"))
+		return 0;
+	
+	char* copy = strdup(path);
+	if (!copy || !add_job(walk_batch, copy))
+	{
+		free(copy);
+		return 1;
+	}
+	
+	return 0;
+}
+
+static int compare_jobs(const void* a, const void* b)
+{
+	return strcmp(((const job_t*) a)->path, ((const job_t*) b)->path);
+}
+
+/* adds a file, or all the .mbs files under a directory in sorted order */
+
+static bool add_input(batch_t* batch, const char* path)
+{
+	struct stat st;
+	if (stat(path, &st) != 0 || !S_ISDIR(st.st_mode))
+		return add_job(batch, path);
+	
+	unsigned first = batch->num_jobs;
+	walk_batch = batch;
+	if (nftw(path, walk_callback, 16, FTW_PHYS) != 0)
+		return false;
+	
+	qsort(batch->jobs + first, batch->num_jobs - first, sizeof(job_t),
+		  compare_jobs);
+	return true;
+}
+
+/*
+ * Walking the chunk tree. The reader never looks outside the mapping: every
+ * size is checked against what's left of the parent before it's used.
+ */
+
+typedef struct
+{
+	const uint8_t* data;
+	unsigned size;
+} chunk_t;
+
+static uint32_t read_u32(const uint8_t* data)
+{
+	uint32_t ret;
+	memcpy(&ret, data, 4);
+	return ret;
+}
+
+/* takes the next chunk off the front of contents */
+
+static bool next_chunk(chunk_t* contents, char ident[4], chunk_t* chunk)
+{
+	if (contents->size < 8)
+		return false;
+	
+	uint32_t size = read_u32(contents->data + 4);
+	if (size > contents->size - 8)
+		return false;
+	
+	memcpy(ident, contents->data, 4);
+	chunk->data = contents->data + 8;
+	chunk->size = size;
+	contents->data += 8 + size;
+	contents->size -= 8 + size;
+	return true;
+}
+
+/* reads the count at the start of a symbol table chunk */
+
+static bool read_count(chunk_t chunk, unsigned* count)
+{
+	if (chunk.size < 4)
+		return false;
+	
+	*count = read_u32(chunk.data);
+	return true;
+}
+
+static const char* analyze_pp(chunk_t code, mbs_stats_t* stats)
+{
+	if (code.size & 3)
+		return "fragment shader code isn't a whole number of words";
+	
+	/* the decoder wants the words aligned, which they are unless some
+	 * chunk before the code has an odd size */
+	if ((uintptr_t) code.data & 3)
+		return "misaligned code";
+	
+	uint32_t* words = (uint32_t*) code.data;
+	unsigned size = code.size >> 2;
+	
+	lima_pp_ctrl_t ctrl;
+	unsigned i;
+	for (i = 0; i < size; i += ctrl.count)
+	{
+		ctrl.mask = words[i];
+		
+		lima_pp_ctrl_t expected = ctrl;
+		lima_pp_instruction_calc_size(&expected);
+		if (ctrl.count != expected.count || ctrl.count > size - i)
+			return "corrupt fragment shader instruction";
+		
+		lima_pp_instruction_t inst;
+		lima_pp_instruction_decode(&words[i], &inst);
+		stats->num_instrs++;
+		
+		unsigned j;
+		for (j = 0; j < lima_pp_field_count; j++)
+			if ((ctrl.fields >> j) & 1)
+				stats->pp_units[j]++;
+		
+		if ((ctrl.fields >> lima_pp_field_uniform) & 1 &&
+			inst.uniform.source == lima_pp_uniform_src_temporary)
+			stats->temp_loads++;
+		
+		/* the same field does framebuffer reads */
+		if ((ctrl.fields >> lima_pp_field_temp_write) & 1 &&
+			inst.temp_write.temp_write.dest == 3)
+			stats->temp_stores++;
+		
+		if ((ctrl.fields >> lima_pp_field_branch) & 1)
+		{
+			if (inst.branch.discard.word0 == LIMA_PP_DISCARD_WORD0)
+				stats->discards++;
+			else
+				stats->branches++;
+		}
+		
+		if ((ctrl.fields >> lima_pp_field_vec4_const_0) & 1)
+			stats->const_slots++;
+		if ((ctrl.fields >> lima_pp_field_vec4_const_1) & 1)
+			stats->const_slots++;
+	}
+	
+	return NULL;
+}
+
+static bool src_is_load(lima_gp_src_e src)
+{
+	return src >= lima_gp_src_load_x && src <= lima_gp_src_load_w;
+}
+
+static bool src_is_register(lima_gp_src_e src)
+{
+	return src <= lima_gp_src_register_w ||
+		src >= lima_gp_src_p1_attrib_x;
+}
+
+static void analyze_gp_instr(const lima_gp_instruction_t* inst,
+							 mbs_stats_t* stats)
+{
+	lima_gp_src_e srcs[] = {
+		inst->mul0_src0, inst->mul0_src1,
+		inst->mul1_src0, inst->mul1_src1,
+		inst->acc0_src0, inst->acc0_src1,
+		inst->acc1_src0, inst->acc1_src1,
+		inst->complex_src, inst->pass_src,
+	};
+	
+	bool load = inst->pass_op == lima_gp_pass_op_clamp;
+	bool reg = false;
+	unsigned i;
+	for (i = 0; i < sizeof(srcs) / sizeof(srcs[0]); i++)
+	{
+		load = load || src_is_load(srcs[i]);
+		reg = reg || src_is_register(srcs[i]);
+	}
+	
+	/* select and the first half of complex1 take up both multipliers */
+	bool mul_both = inst->mul_op != lima_gp_mul_op_mul &&
+		inst->mul_op != lima_gp_mul_op_complex2;
+	
+	if (mul_both || inst->mul0_src0 != lima_gp_src_unused ||
+		inst->mul0_src1 != lima_gp_src_unused)
+		stats->gp_units[gp_unit_mul0]++;
+	if (mul_both || inst->mul1_src0 != lima_gp_src_unused ||
+		inst->mul1_src1 != lima_gp_src_unused)
+		stats->gp_units[gp_unit_mul1]++;
+	if (inst->acc0_src0 != lima_gp_src_unused ||
+		inst->acc0_src1 != lima_gp_src_unused)
+		stats->gp_units[gp_unit_acc0]++;
+	if (inst->acc1_src0 != lima_gp_src_unused ||
+		inst->acc1_src1 != lima_gp_src_unused)
+		stats->gp_units[gp_unit_acc1]++;
+	if (inst->complex_op != lima_gp_complex_op_nop)
+		stats->gp_units[gp_unit_complex]++;
+	if (inst->pass_src != lima_gp_src_unused)
+		stats->gp_units[gp_unit_pass]++;
+	
+	bool store0 = inst->store0_src_x != lima_gp_store_src_none ||
+		inst->store0_src_y != lima_gp_store_src_none;
+	bool store1 = inst->store1_src_z != lima_gp_store_src_none ||
+		inst->store1_src_w != lima_gp_store_src_none;
+	if (store0)
+		stats->gp_units[gp_unit_store0]++;
+	if (store1)
+		stats->gp_units[gp_unit_store1]++;
+	if ((store0 && inst->store0_temporary) ||
+		(store1 && inst->store1_temporary))
+		stats->temp_stores++;
+	
+	/* loads from temporaries can't be told apart from loads of the
+	 * constants the compiler adds after the uniforms, so they aren't
+	 * counted separately */
+	if (load)
+		stats->gp_units[gp_unit_load]++;
+	
+	if (reg)
+		stats->gp_units[gp_unit_register]++;
+	
+	if (inst->branch)
+	{
+		stats->gp_units[gp_unit_branch]++;
+		stats->branches++;
+	}
+}
+
+static const char* analyze_gp(chunk_t code, mbs_stats_t* stats)
+{
+	if (code.size % sizeof(lima_gp_instruction_t))
+		return "vertex shader code isn't a whole number of instructions";
+	
+	unsigned i;
+	for (i = 0; i < code.size; i += sizeof(lima_gp_instruction_t))
+	{
+		lima_gp_instruction_t inst;
+		memcpy(&inst, code.data + i, sizeof(inst));
+		analyze_gp_instr(&inst, stats);
+		stats->num_instrs++;
+	}
+	
+	return NULL;
+}
+
+/* returns NULL on success, or what's wrong with the file */
+
+static const char* analyze(const uint8_t* data, unsigned size,
+						   mbs_stats_t* stats)
+{
+	memset(stats, 0, sizeof(*stats));
+	
+	chunk_t file = { data, size }, mbs, shader;
+	char ident[4];
+	if (!next_chunk(&file, ident, &mbs) || memcmp(ident, "MBS1", 4) != 0)
+		return "not an MBS file";
+	
+	if (!next_chunk(&mbs, ident, &shader))
+		return "missing shader chunk";
+	
+	if (memcmp(ident, "CVER", 4) == 0)
+		stats->stage = lima_shader_stage_vertex;
+	else if (memcmp(ident, "CFRA", 4) == 0)
+		stats->stage = lima_shader_stage_fragment;
+	else
+		return "unknown shader chunk";
+	
+	if (shader.size < 4)
+		return "truncated shader chunk";
+	
+	uint32_t version = read_u32(shader.data);
+	shader.data += 4;
+	shader.size -= 4;
+	
+	/* the inverse of the versions in standalone/mbs_export.c */
+	stats->core_known = true;
+	if (version == 2 || version == 5)
+		stats->core = lima_core_mali_200;
+	else if (version == 6 || version == 7)
+		stats->core = lima_core_mali_400;
+	else
+		stats->core_known = false;
+	
+	chunk_t chunk, code;
+	bool has_code = false;
+	while (next_chunk(&shader, ident, &chunk))
+	{
+		if (memcmp(ident, "SUNI", 4) == 0)
+		{
+			if (!read_count(chunk, &stats->num_uniforms) || chunk.size < 8)
+				return "truncated uniform table";
+			stats->uniform_size = read_u32(chunk.data + 4);
+		}
+		else if (memcmp(ident, "SATT", 4) == 0)
+		{
+			if (!read_count(chunk, &stats->num_attributes))
+				return "truncated attribute table";
+		}
+		else if (memcmp(ident, "SVAR", 4) == 0)
+		{
+			if (!read_count(chunk, &stats->num_varyings))
+				return "truncated varying table";
+		}
+		else if (memcmp(ident, "FSTA", 4) == 0)
+		{
+			if (!read_count(chunk, &stats->stack_size))
+				return "truncated FSTA chunk";
+		}
+		else if (memcmp(ident, "DBIN", 4) == 0)
+		{
+			code = chunk;
+			has_code = true;
+		}
+	}
+	
+	if (shader.size != 0)
+		return "corrupt chunk";
+	
+	if (!has_code)
+		return "missing code";
+	
+	stats->code_size = code.size;
+	
+	if (stats->stage == lima_shader_stage_vertex)
+		return analyze_gp(code, stats);
+	return analyze_pp(code, stats);
+}
+
+static bool analyze_file(job_t* job)
+{
+	int fd = open(job->path, O_RDONLY);
+	if (fd < 0)
+	{
+		fprintf(stderr, "Warning: could not open %s\n", job->path);
+		return false;
+	}
+	
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size == 0 || st.st_size > UINT32_MAX)
+	{
+		fprintf(stderr, "Warning: %s: not an MBS file\n", job->path);
+		close(fd);
+		return false;
+	}
+	
+	void* data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED)
+	{
+		fprintf(stderr, "Warning: could not map %s\n", job->path);
+		return false;
+	}
+	
+	const char* error = analyze(data, st.st_size, &job->stats);
+	munmap(data, st.st_size);
+	
+	if (error)
+	{
+		fprintf(stderr, "Warning: %s: %s\n", job->path, error);
+		return false;
+	}
+	
+	return true;
+}
+
+static void* worker(void* data)
+{
+	batch_t* batch = data;
+	
+	while (true)
+	{
+		pthread_mutex_lock(&batch->lock);
+		unsigned index = batch->next_job++;
+		pthread_mutex_unlock(&batch->lock);
+		
+		if (index >= batch->num_jobs)
+			break;
+		
+		job_t* job = &batch->jobs[index];
+		job->success = analyze_file(job);
+	}
+	
+	return NULL;
+}
+
+static void add_stats(mbs_stats_t* total, const mbs_stats_t* stats)
+{
+	total->code_size += stats->code_size;
+	total->num_instrs += stats->num_instrs;
+	
+	unsigned i;
+	for (i = 0; i < lima_pp_field_count; i++)
+		total->pp_units[i] += stats->pp_units[i];
+	for (i = 0; i < gp_unit_count; i++)
+		total->gp_units[i] += stats->gp_units[i];
+	
+	total->branches += stats->branches;
+	total->discards += stats->discards;
+	total->const_slots += stats->const_slots;
+	total->stack_size += stats->stack_size;
+	total->temp_loads += stats->temp_loads;
+	total->temp_stores += stats->temp_stores;
+	total->num_uniforms += stats->num_uniforms;
+	total->uniform_size += stats->uniform_size;
+	total->num_attributes += stats->num_attributes;
+	total->num_varyings += stats->num_varyings;
+}
+
+static const char* stage_name(lima_shader_stage_e stage)
+{
+	return stage == lima_shader_stage_vertex ? "vert" : "frag";
+}
+
+static const char* core_name(const mbs_stats_t* stats)
+{
+	if (!stats->core_known)
+		return "unknown";
+	return stats->core == lima_core_mali_200 ? "Mali-200" : "Mali-400";
+}
+
+static void print_csv_header(void)
+{
+	printf("path,stage,core,files,code_size,instructions,branches,discards,"
+		   "const_slots,stack_size,temp_loads,temp_stores,uniforms,"
+		   "uniform_size,attributes,varyings");
+	
+	unsigned i;
+	for (i = 0; i < lima_pp_field_count; i++)
+		printf(",pp_%s", lima_pp_field_name[i]);
+	for (i = 0; i < gp_unit_count; i++)
+		printf(",gp_%s", gp_unit_name[i]);
+	printf("\n");
+}
+
+/* paths are quoted, in case they have commas in them */
+
+static void print_csv_string(const char* str)
+{
+	putchar('"');
+	for (; *str; str++)
+	{
+		if (*str == '"')
+			putchar('"');
+		putchar(*str);
+	}
+	putchar('"');
+}
+
+static void print_csv_row(const char* path, const char* core,
+						  const mbs_stats_t* stats, unsigned files)
+{
+	print_csv_string(path);
+	printf(",%s,%s,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u",
+		   stage_name(stats->stage), core, files, stats->code_size,
+		   stats->num_instrs, stats->branches, stats->discards,
+		   stats->const_slots, stats->stack_size, stats->temp_loads,
+		   stats->temp_stores, stats->num_uniforms, stats->uniform_size,
+		   stats->num_attributes, stats->num_varyings);
+	
+	unsigned i;
+	for (i = 0; i < lima_pp_field_count; i++)
+		printf(",%u", stats->pp_units[i]);
+	for (i = 0; i < gp_unit_count; i++)
+		printf(",%u", stats->gp_units[i]);
+	printf("\n");
+}
+
+static void print_json_string(const char* str)
+{
+	putchar('"');
+	for (; *str; str++)
+	{
+		if (*str == '"' || *str == '\\')
+			printf("\\%c", *str);
+		else if ((unsigned char) *str < 0x20)
+			printf("\\u%04x", *str);
+		else
+			putchar(*str);
+	}
+	putchar('"');
+}
+
+static void print_json_object(const char* path, const char* core,
+							  const mbs_stats_t* stats, unsigned files)
+{
+	printf("{");
+	if (path)
+	{
+		printf("\"path\": ");
+		print_json_string(path);
+		printf(", \"core\": \"%s\", ", core);
+	}
+	else
+		printf("\"files\": %u, ", files);
+	
+	printf("\"stage\": \"%s\", \"code_size\": %u, \"instructions\": %u, "
+		   "\"branches\": %u, \"discards\": %u, \"const_slots\": %u, "
+		   "\"stack_size\": %u, \"temp_loads\": %u, \"temp_stores\": %u, "
+		   "\"uniforms\": %u, \"uniform_size\": %u, \"attributes\": %u, "
+		   "\"varyings\": %u, \"units\": {",
+		   stage_name(stats->stage), stats->code_size, stats->num_instrs,
+		   stats->branches, stats->discards, stats->const_slots,
+		   stats->stack_size, stats->temp_loads, stats->temp_stores,
+		   stats->num_uniforms, stats->uniform_size, stats->num_attributes,
+		   stats->num_varyings);
+	
+	unsigned i;
+	if (stats->stage == lima_shader_stage_vertex)
+	{
+		for (i = 0; i < gp_unit_count; i++)
+			printf("%s\"%s\": %u", i ? ", " : "", gp_unit_name[i],
+				   stats->gp_units[i]);
+	}
+	else
+	{
+		for (i = 0; i < lima_pp_field_count; i++)
+			printf("%s\"%s\": %u", i ? ", " : "", lima_pp_field_name[i],
+				   stats->pp_units[i]);
+	}
+	printf("}}");
+}
+
+int main(int argc, char** argv)
+{
+	bool json = false, summary = false;
+	long num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+	if (num_threads < 1)
+		num_threads = 1;
+	
+	static struct option long_options[] = {
+		{"format",  required_argument, NULL, 'f'},
+		{"summary", no_argument,       NULL, 's'},
+		{"jobs",    required_argument, NULL, 'j'},
+		{"help",    no_argument,       NULL, 'h'},
+		{0,         0,                 0,    0}
+	};
+	
+	while (true)
+	{
+		int option_index;
+		int c = getopt_long(argc, argv, "f:sj:h", long_options,
+							&option_index);
+		
+		if (c == -1)
+			break;
+		
+		switch (c)
+		{
+			case 'f':
+				if (strcmp(optarg, "csv") == 0)
+					json = false;
+				else if (strcmp(optarg, "json") == 0)
+					json = true;
+				else
+				{
+					fprintf(stderr, "Error: unknown format %s\n", optarg);
+					usage();
+					exit(1);
+				}
+				break;
+			
+			case 's':
+				summary = true;
+				break;
+			
+			case 'j':
+			{
+				char* end;
+				num_threads = strtol(optarg, &end, 10);
+				if (*end != '\0' || num_threads < 1)
+				{
+					fprintf(stderr, "Error: invalid number of jobs %s\n",
+							optarg);
+					usage();
+					exit(1);
+				}
+				break;
+			}
+			
+			case 'h':
+				usage();
+				exit(0);
+			
+			default:
+				usage();
+				exit(1);
+		}
+	}
+	
+	if (optind == argc)
+	{
+		fprintf(stderr, "Error: no input specified\n");
+		usage();
+		exit(1);
+	}
+	
+	batch_t batch;
+	memset(&batch, 0, sizeof(batch));
+	pthread_mutex_init(&batch.lock, NULL);
+	
+	int i;
+	for (i = optind; i < argc; i++)
+	{
+		if (!add_input(&batch, argv[i]))
+		{
+			fprintf(stderr, "Error: could not read directory %s\n", argv[i]);
+			return 1;
+		}
+	}
+	
+	if ((unsigned long) num_threads > batch.num_jobs)
+		num_threads = batch.num_jobs ? batch.num_jobs : 1;
+	
+	if (num_threads == 1)
+		worker(&batch);
+	else
+	{
+		pthread_t* threads = malloc(num_threads * sizeof(pthread_t));
+		if (!threads)
+			return 1;
+		
+		long j;
+		for (j = 0; j < num_threads; j++)
+		{
+			if (pthread_create(&threads[j], NULL, worker, &batch) != 0)
+			{
+				fprintf(stderr, "Error: could not create thread\n");
+				return 1;
+			}
+		}
+		
+		for (j = 0; j < num_threads; j++)
+			pthread_join(threads[j], NULL);
+		
+		free(threads);
+	}
+	
+	/* totals for vertex and fragment shaders, in that order */
+	mbs_stats_t totals[2];
+	unsigned num_files[2] = {0, 0};
+	memset(totals, 0, sizeof(totals));
+	totals[0].stage = lima_shader_stage_vertex;
+	totals[1].stage = lima_shader_stage_fragment;
+	
+	int ret = 0;
+	unsigned j;
+	for (j = 0; j < batch.num_jobs; j++)
+	{
+		job_t* job = &batch.jobs[j];
+		if (!job->success)
+		{
+			ret = 1;
+			continue;
+		}
+		
+		unsigned t = job->stats.stage == lima_shader_stage_vertex ? 0 : 1;
+		add_stats(&totals[t], &job->stats);
+		num_files[t]++;
+	}
+	
+	if (json)
+	{
+		printf("{\n");
+		if (!summary)
+		{
+			printf("\t\"files\": [");
+			bool first = true;
+			for (j = 0; j < batch.num_jobs; j++)
+			{
+				job_t* job = &batch.jobs[j];
+				if (!job->success)
+					continue;
+				
+				printf(first ? "\n\t\t" : ",\n\t\t");
+				first = false;
+				print_json_object(job->path, core_name(&job->stats),
+								  &job->stats, 1);
+			}
+			printf("\n\t],\n");
+		}
+		
+		printf("\t\"totals\": [\n\t\t");
+		print_json_object(NULL, NULL, &totals[0], num_files[0]);
+		printf(",\n\t\t");
+		print_json_object(NULL, NULL, &totals[1], num_files[1]);
+		printf("\n\t]\n}\n");
+	}
+	else
+	{
+		print_csv_header();
+		if (!summary)
+		{
+			for (j = 0; j < batch.num_jobs; j++)
+			{
+				job_t* job = &batch.jobs[j];
+				if (job->success)
+					print_csv_row(job->path, core_name(&job->stats),
+								  &job->stats, 1);
+			}
+		}
+		
+		print_csv_row("total", "all", &totals[0], num_files[0]);
+		print_csv_row("total", "all", &totals[1], num_files[1]);
+	}
+	
+	return ret;
+}
@@ -0,0 +1,103 @@
+/* Author(s):
+ *   Connor Abbott
+ *
+ * Copyright (c) 2014 Connor Abbott (connor@abbott.cx)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "string_buf.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define INITIAL_CAPACITY 256
+
+bool string_buf_init(string_buf_t* buf, string_buf_sink_t sink,
+					 void* sink_data)
+{
+	buf->data = malloc(INITIAL_CAPACITY);
+	if (!buf->data)
+		return false;
+	
+	buf->data[0] = '\0';
+	buf->size = 0;
+	buf->capacity = INITIAL_CAPACITY;
+	buf->error = false;
+	buf->sink = sink;
+	buf->sink_data = sink_data;
+	return true;
+}
+
+void string_buf_delete(string_buf_t* buf)
+{
+	free(buf->data);
+}
+
+void string_buf_printf(string_buf_t* buf, const char* format, ...)
+{
+	if (buf->error)
+		return;
+	
+	va_list args;
+	va_start(args, format);
+	int len = vsnprintf(buf->data + buf->size, buf->capacity - buf->size,
+						format, args);
+	va_end(args);
+	
+	if (len < 0)
+	{
+		buf->error = true;
+		return;
+	}
+	
+	if (buf->size + len >= buf->capacity)
+	{
+		unsigned capacity = buf->capacity;
+		while (buf->size + len >= capacity)
+			capacity *= 2;
+		
+		char* data = realloc(buf->data, capacity);
+		if (!data)
+		{
+			buf->data[buf->size] = '\0';
+			buf->error = true;
+			return;
+		}
+		buf->data = data;
+		buf->capacity = capacity;
+		
+		va_start(args, format);
+		vsnprintf(buf->data + buf->size, buf->capacity - buf->size,
+				  format, args);
+		va_end(args);
+	}
+	
+	buf->size += len;
+}
+
+void string_buf_flush(string_buf_t* buf)
+{
+	if (!buf->sink || buf->error || !buf->size)
+		return;
+	
+	buf->sink(buf->data, buf->size, buf->sink_data);
+	buf->size = 0;
+	buf->data[0] = '\0';
+}
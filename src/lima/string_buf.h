@@ -0,0 +1,60 @@
+/* Author(s):
+ *   Connor Abbott
+ *
+ * Copyright (c) 2014 Connor Abbott (connor@abbott.cx)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef __string_buf_h__
+#define __string_buf_h__
+
+#include <stdbool.h>
+
+/*
+ * A growable string that text gets printed into. If it has a sink,
+ * string_buf_flush() hands everything printed so far to the sink and starts
+ * over, so the buffer only ever needs to be as big as the text between
+ * flushes. Without a sink it just keeps growing, and the result is in data.
+ *
+ * Running out of memory sets error and drops any further text, so callers
+ * only need to check once at the end.
+ */
+
+typedef void (*string_buf_sink_t)(const char* text, unsigned size, void* data);
+
+typedef struct
+{
+	char* data; /* always NUL-terminated */
+	unsigned size, capacity;
+	bool error;
+	
+	string_buf_sink_t sink;
+	void* sink_data;
+} string_buf_t;
+
+bool string_buf_init(string_buf_t* buf, string_buf_sink_t sink,
+					 void* sink_data);
+void string_buf_delete(string_buf_t* buf);
+
+void string_buf_printf(string_buf_t* buf, const char* format, ...)
+	__attribute__((format(printf, 2, 3)));
+void string_buf_flush(string_buf_t* buf);
+
+#endif
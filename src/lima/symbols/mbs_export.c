@@ -192,7 +192,7 @@ static bool mbs_uniform_export(mbs_chunk_t* uniform_table, lima_symbol_t* symbol
 		return false;
 	}
 	
-	if (!mbs_chunk_append_data(vidx_chunk, (void*) vidx_blob, 9 * 4))
+	if (!mbs_chunk_append_ref(vidx_chunk, vidx_blob, 9 * 4))
 	{
 		mbs_chunk_delete(chunk);
 		mbs_chunk_delete(vidx_chunk);
@@ -217,8 +217,8 @@ static bool mbs_uniform_export(mbs_chunk_t* uniform_table, lima_symbol_t* symbol
 		
 		uint32_t count = component_counts[symbol->type] * num_rows[symbol->type];
 		if (!mbs_chunk_append_data(vini_chunk, &count, sizeof(uint32_t)) ||
-			!mbs_chunk_append_data(vini_chunk, symbol->array_const,
-								   count * sizeof(float)))
+			!mbs_chunk_append_ref(vini_chunk, symbol->array_const,
+								  count * sizeof(float)))
 		{
 			mbs_chunk_delete(chunk);
 			mbs_chunk_delete(vini_chunk);
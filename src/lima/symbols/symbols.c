@@ -27,6 +27,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
+#include <stddef.h>
 #include <assert.h>
 
 lima_symbol_t* lima_symbol_create(lima_symbol_type_e type,
@@ -142,6 +144,8 @@ lima_symbol_t* lima_const_create(unsigned index, lima_symbol_type_e type,
 	symbol->offset = 0;
 	symbol->stride = 0;
 	symbol->used = true;
+	symbol->num_children = 0;
+	symbol->children = NULL;
 	
 	unsigned size = (array_elems ? array_elems : 1) * const_size(type);
 	symbol->array_const = malloc(size * sizeof(float));
@@ -391,10 +395,10 @@ unsigned lima_shader_symbols_add_clamp_const(lima_shader_symbols_t* symbols,
 	return symbol->offset / 4;
 }
 
-static void print_tabs(unsigned tabs)
+static void print_tabs(unsigned tabs, FILE* f)
 {
 	for (unsigned i = 0; i < tabs; i++)
-		printf("\t");
+		fprintf(f, "\t");
 }
 
 static const char* symbol_strings[lima_num_symbol_types] = {
@@ -424,41 +428,284 @@ static const char* precision_strings[3] = {
 	[lima_precision_medium] = "mediump"
 };
 
-static void print_symbol(lima_symbol_t* symbol, unsigned tabs)
+static void print_symbol(lima_symbol_t* symbol, unsigned tabs, FILE* f)
 {
-	print_tabs(tabs);
-	printf("%s %s ", precision_strings[symbol->precision],
+	print_tabs(tabs, f);
+	fprintf(f, "%s %s ", precision_strings[symbol->precision],
 		   symbol_strings[symbol->type]);
 	if (symbol->type == lima_symbol_struct)
 	{
-		printf("{\n");
+		fprintf(f, "{\n");
 		for (unsigned i = 0; i < symbol->num_children; i++)
-			print_symbol(symbol->children[i], tabs + 1);
-		printf("} ");
+			print_symbol(symbol->children[i], tabs + 1, f);
+		fprintf(f, "} ");
 	}
 	
-	printf("%s", symbol->name);
+	fprintf(f, "%s", symbol->name);
 	if (symbol->array_elems)
-		printf("[%u]", symbol->array_elems);
-	printf("; //offset = %u, stride = %u", symbol->offset, symbol->stride);
+		fprintf(f, "[%u]", symbol->array_elems);
+	fprintf(f, "; //offset = %u, stride = %u", symbol->offset, symbol->stride);
 	if (!symbol->used)
-		printf(", unused");
-	printf("\n");
+		fprintf(f, ", unused");
+	fprintf(f, "\n");
 }
 
-static void print_table(lima_symbol_table_t* table, const char* prefix)
+static void print_table(lima_symbol_table_t* table, const char* prefix, FILE* f)
 {
 	for (unsigned i = 0; i < table->num_symbols; i++)
 	{
-		printf("%s ", prefix);
-		print_symbol(table->symbols[i], 0);
+		fprintf(f, "%s ", prefix);
+		print_symbol(table->symbols[i], 0, f);
+	}
+}
+
+void lima_shader_symbols_print(lima_shader_symbols_t* symbols, FILE* f)
+{
+	print_table(&symbols->attribute_table, "attribute", f);
+	print_table(&symbols->varying_table, "varying", f);
+	print_table(&symbols->uniform_table, "uniform", f);
+	print_table(&symbols->temporary_table, "", f);
+}
+
+/* serialization, used by the on-disk shader cache */
+
+typedef struct {
+	uint32_t type, precision;
+	uint32_t array_elems;
+	uint32_t offset, stride;
+	uint32_t used;
+	uint32_t num_children;
+	uint32_t name_size; /* including padding to a multiple of 4 */
+	uint32_t num_consts;
+} symbol_header_t;
+
+typedef struct {
+	uint32_t num_symbols;
+	uint32_t total_size;
+} table_header_t;
+
+static unsigned symbol_num_consts(lima_symbol_t* symbol)
+{
+	if (!symbol->array_const)
+		return 0;
+	
+	return (symbol->array_elems ? symbol->array_elems : 1) *
+		const_size(symbol->type);
+}
+
+static unsigned symbol_export_size(lima_symbol_t* symbol)
+{
+	unsigned size = sizeof(symbol_header_t);
+	size += (strlen(symbol->name) + 4) & ~3;
+	size += symbol_num_consts(symbol) * sizeof(float);
+	if (symbol->type == lima_symbol_struct)
+	{
+		for (unsigned i = 0; i < symbol->num_children; i++)
+			size += symbol_export_size(symbol->children[i]);
 	}
+	
+	return size;
+}
+
+static char* symbol_export(lima_symbol_t* symbol, char* data)
+{
+	symbol_header_t* header = (symbol_header_t*) data;
+	unsigned name_len = strlen(symbol->name);
+	
+	header->type = symbol->type;
+	header->precision = symbol->precision;
+	header->array_elems = symbol->array_elems;
+	header->offset = symbol->offset;
+	header->stride = symbol->stride;
+	header->used = symbol->used;
+	header->num_children =
+		symbol->type == lima_symbol_struct ? symbol->num_children : 0;
+	header->name_size = (name_len + 4) & ~3;
+	header->num_consts = symbol_num_consts(symbol);
+	data += sizeof(symbol_header_t);
+	
+	memset(data, 0, header->name_size);
+	memcpy(data, symbol->name, name_len);
+	data += header->name_size;
+	
+	memcpy(data, symbol->array_const, header->num_consts * sizeof(float));
+	data += header->num_consts * sizeof(float);
+	
+	for (unsigned i = 0; i < header->num_children; i++)
+		data = symbol_export(symbol->children[i], data);
+	
+	return data;
 }
 
-void lima_shader_symbols_print(lima_shader_symbols_t* symbols)
+static lima_symbol_t* symbol_import(const char** data, const char* end)
 {
-	print_table(&symbols->attribute_table, "attribute");
-	print_table(&symbols->varying_table, "varying");
-	print_table(&symbols->uniform_table, "uniform");
-	print_table(&symbols->temporary_table, "");
+	if (end - *data < (ptrdiff_t) sizeof(symbol_header_t))
+		return NULL;
+	
+	symbol_header_t header;
+	memcpy(&header, *data, sizeof(symbol_header_t));
+	*data += sizeof(symbol_header_t);
+	
+	if (header.type >= lima_num_symbol_types ||
+		header.precision >= lima_num_precisions ||
+		header.name_size == 0 ||
+		(unsigned) (end - *data) < header.name_size ||
+		(*data)[header.name_size - 1] != '\0')
+		return NULL;
+	
+	lima_symbol_t* symbol = lima_symbol_create(header.type, header.precision,
+											   *data, header.array_elems);
+	if (!symbol)
+		return NULL;
+	*data += header.name_size;
+	
+	symbol->offset = header.offset;
+	symbol->stride = header.stride;
+	symbol->used = header.used;
+	
+	if (header.num_consts)
+	{
+		unsigned size = header.num_consts * sizeof(float);
+		if ((unsigned) (end - *data) < size)
+			goto err;
+		
+		symbol->array_const = malloc(size);
+		if (!symbol->array_const)
+			goto err;
+		
+		memcpy(symbol->array_const, *data, size);
+		*data += size;
+	}
+	
+	if (header.num_children)
+	{
+		if (header.type != lima_symbol_struct)
+			goto err;
+		
+		symbol->children = calloc(header.num_children, sizeof(lima_symbol_t*));
+		if (!symbol->children)
+			goto err;
+		
+		for (unsigned i = 0; i < header.num_children; i++)
+		{
+			symbol->children[i] = symbol_import(data, end);
+			if (!symbol->children[i])
+				goto err;
+			symbol->num_children++;
+		}
+	}
+	
+	return symbol;
+	
+err:
+	lima_symbol_delete(symbol);
+	return NULL;
+}
+
+static unsigned table_export_size(lima_symbol_table_t* table)
+{
+	unsigned size = sizeof(table_header_t);
+	for (unsigned i = 0; i < table->num_symbols; i++)
+		size += symbol_export_size(table->symbols[i]);
+	
+	return size;
+}
+
+static char* table_export(lima_symbol_table_t* table, char* data)
+{
+	table_header_t* header = (table_header_t*) data;
+	header->num_symbols = table->num_symbols;
+	header->total_size = table->total_size;
+	data += sizeof(table_header_t);
+	
+	for (unsigned i = 0; i < table->num_symbols; i++)
+		data = symbol_export(table->symbols[i], data);
+	
+	return data;
+}
+
+static bool table_import(lima_symbol_table_t* table, const char** data,
+						 const char* end)
+{
+	if (end - *data < (ptrdiff_t) sizeof(table_header_t))
+		return false;
+	
+	table_header_t header;
+	memcpy(&header, *data, sizeof(table_header_t));
+	*data += sizeof(table_header_t);
+	
+	for (unsigned i = 0; i < header.num_symbols; i++)
+	{
+		lima_symbol_t* symbol = symbol_import(data, end);
+		if (!symbol)
+			return false;
+		
+		if (!lima_symbol_table_add(table, symbol))
+		{
+			lima_symbol_delete(symbol);
+			return false;
+		}
+	}
+	
+	table->total_size = header.total_size;
+	return true;
+}
+
+typedef struct {
+	uint32_t cur_uniform_index, cur_const_index;
+} symbols_header_t;
+
+void* lima_shader_symbols_export(lima_shader_symbols_t* symbols,
+								 unsigned* size)
+{
+	*size = sizeof(symbols_header_t) +
+		table_export_size(&symbols->attribute_table) +
+		table_export_size(&symbols->varying_table) +
+		table_export_size(&symbols->uniform_table) +
+		table_export_size(&symbols->temporary_table);
+	
+	char* data = malloc(*size);
+	if (!data)
+		return NULL;
+	
+	symbols_header_t* header = (symbols_header_t*) data;
+	header->cur_uniform_index = symbols->cur_uniform_index;
+	header->cur_const_index = symbols->cur_const_index;
+	
+	char* pos = data + sizeof(symbols_header_t);
+	pos = table_export(&symbols->attribute_table, pos);
+	pos = table_export(&symbols->varying_table, pos);
+	pos = table_export(&symbols->uniform_table, pos);
+	pos = table_export(&symbols->temporary_table, pos);
+	assert(pos == data + *size);
+	
+	return data;
+}
+
+bool lima_shader_symbols_import(lima_shader_symbols_t* symbols,
+								const void* data, unsigned size)
+{
+	assert(symbols->attribute_table.num_symbols == 0 &&
+		   symbols->varying_table.num_symbols == 0 &&
+		   symbols->uniform_table.num_symbols == 0 &&
+		   symbols->temporary_table.num_symbols == 0);
+	
+	const char* pos = data;
+	const char* end = pos + size;
+	
+	if (size < sizeof(symbols_header_t))
+		return false;
+	
+	symbols_header_t header;
+	memcpy(&header, pos, sizeof(symbols_header_t));
+	pos += sizeof(symbols_header_t);
+	
+	symbols->cur_uniform_index = header.cur_uniform_index;
+	symbols->cur_const_index = header.cur_const_index;
+	
+	return table_import(&symbols->attribute_table, &pos, end) &&
+		table_import(&symbols->varying_table, &pos, end) &&
+		table_import(&symbols->uniform_table, &pos, end) &&
+		table_import(&symbols->temporary_table, &pos, end) &&
+		pos == end;
 }
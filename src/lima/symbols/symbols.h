@@ -30,6 +30,7 @@ extern "C" {
 #endif
 
 #include <stdbool.h>
+#include <stdio.h>
 #include "shader.h"
 #include "mbs/mbs.h"
 #include "main/hash_table.h"
@@ -161,11 +162,21 @@ unsigned lima_shader_symbols_add_const(lima_shader_symbols_t* symbols,
 unsigned lima_shader_symbols_add_clamp_const(lima_shader_symbols_t* symbols,
 											 float const1, float const2);
 
-void lima_shader_symbols_print(lima_shader_symbols_t* symbols);
+void lima_shader_symbols_print(lima_shader_symbols_t* symbols, FILE* f);
 
 bool lima_shader_symbols_pack(lima_shader_symbols_t* symbols,
 							  lima_shader_stage_e stage);
 
+/* serialize the symbol tables after packing, so they can be restored without
+ * recompiling the shader. The export is malloc'd. Import expects freshly
+ * initialized symbols, and leaves them partially filled in on failure.
+ */
+
+void* lima_shader_symbols_export(lima_shader_symbols_t* symbols,
+								 unsigned* size);
+bool lima_shader_symbols_import(lima_shader_symbols_t* symbols,
+								const void* data, unsigned size);
+
 mbs_chunk_t* lima_export_varying_table(lima_shader_symbols_t* symbols);
 mbs_chunk_t* lima_export_attribute_table(lima_shader_symbols_t* symbols);
 mbs_chunk_t* lima_export_uniform_table(lima_shader_symbols_t* symbols);
@@ -0,0 +1,264 @@
+/* Author(s):
+ *   Connor Abbott
+ *
+ * Copyright (c) 2014 Connor Abbott (connor@abbott.cx)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Checks that lima_shader_resume() rejects damaged checkpoints. A checkpoint
+ * is made from each input, and must resume and checkpoint again to the same
+ * bytes. Then every truncation of it, and copies with a byte flipped at every
+ * position in the header and at pseudo-random positions after it, must be
+ * rejected with an error rather than imported.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "shader.h"
+
+/* the largest header a checkpoint might have, every byte of which is
+ * flipped */
+#define HEADER_SIZE 64
+
+#define NUM_FLIPS 256
+
+static char* read_file(const char* path)
+{
+	FILE* fp = fopen(path, "rb");
+	if (!fp) return NULL;
+	
+	if (fseek(fp, 0, SEEK_END) != 0)
+	{
+		fclose(fp);
+		return NULL;
+	}
+	long fsize = ftell(fp);
+	if ((fsize <= 0)
+		|| (fseek(fp, 0, SEEK_SET) != 0))
+	{
+		fclose(fp);
+		return NULL;
+	}
+	
+	char* data = (char*)malloc(fsize + 1);
+	if (!data)
+	{
+		fclose(fp);
+		return NULL;
+	}
+	
+	if (fread(data, fsize, 1, fp) != 1)
+	{
+		fclose(fp);
+		free(data);
+		return NULL;
+	}
+	data[fsize] = '\0';
+	
+	fclose(fp);
+	return data;
+}
+
+static uint32_t next_random(uint32_t* state)
+{
+	/* xorshift32 */
+	uint32_t x = *state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*state = x;
+	return x;
+}
+
+static bool get_stage(const char* path, lima_shader_stage_e* stage)
+{
+	const char* ext = strrchr(path, '.');
+	if (ext && strcmp(ext, ".vert") == 0)
+		*stage = lima_shader_stage_vertex;
+	else if (ext && strcmp(ext, ".frag") == 0)
+		*stage = lima_shader_stage_fragment;
+	else
+		return false;
+	
+	return true;
+}
+
+/* returns whether the checkpoint was rejected, or resumed into *shader */
+static bool resume(lima_compiler_t* compiler, lima_shader_stage_e stage,
+				   const void* data, unsigned size, lima_shader_t** shader)
+{
+	*shader = lima_shader_create(compiler, stage, lima_core_mali_400);
+	if (!*shader)
+	{
+		fprintf(stderr, "Error: could not create a shader\n");
+		exit(1);
+	}
+	
+	lima_shader_resume(*shader, data, size);
+	return lima_shader_error(*shader);
+}
+
+static bool expect_error(lima_compiler_t* compiler, lima_shader_stage_e stage,
+						 const void* data, unsigned size)
+{
+	lima_shader_t* shader;
+	bool rejected = resume(compiler, stage, data, size, &shader);
+	lima_shader_delete(shader);
+	return rejected;
+}
+
+static bool check(lima_compiler_t* compiler, const char* path)
+{
+	lima_shader_stage_e stage;
+	if (!get_stage(path, &stage))
+	{
+		fprintf(stderr, "%s: unknown shader type\n", path);
+		return false;
+	}
+	
+	char* source = read_file(path);
+	if (!source)
+	{
+		fprintf(stderr, "Error: could not read input file %s\n", path);
+		return false;
+	}
+	
+	lima_shader_t* shader = lima_shader_create(compiler, stage,
+											   lima_core_mali_400);
+	if (!shader)
+	{
+		free(source);
+		return false;
+	}
+	
+	lima_shader_parse(shader, source);
+	free(source);
+	if (!lima_shader_error(shader))
+		lima_shader_optimize(shader);
+	
+	unsigned size;
+	char* data = lima_shader_checkpoint(shader, &size);
+	if (!data)
+	{
+		fprintf(stderr, "%s: %s", path, lima_shader_info_log(shader));
+		lima_shader_delete(shader);
+		return false;
+	}
+	lima_shader_delete(shader);
+	
+	bool success = true;
+	
+	/* an intact checkpoint goes through unchanged */
+	if (resume(compiler, stage, data, size, &shader))
+	{
+		fprintf(stderr, "%s: intact checkpoint rejected: %s", path,
+				lima_shader_info_log(shader));
+		success = false;
+	}
+	else
+	{
+		unsigned new_size;
+		char* new_data = lima_shader_checkpoint(shader, &new_size);
+		if (!new_data || new_size != size || memcmp(new_data, data, size) != 0)
+		{
+			fprintf(stderr, "%s: resumed checkpoint doesn't match\n", path);
+			success = false;
+		}
+		free(new_data);
+	}
+	lima_shader_delete(shader);
+	
+	unsigned i, failures = 0;
+	for (i = 0; i < size; i++)
+	{
+		if (!expect_error(compiler, stage, data, i))
+		{
+			if (!failures++)
+				fprintf(stderr, "%s: accepted truncated to %u bytes\n", path, i);
+		}
+	}
+	
+	char* damaged = malloc(size);
+	if (!damaged)
+	{
+		free(data);
+		return false;
+	}
+	
+	uint32_t state = 1;
+	for (i = 0; i < HEADER_SIZE + NUM_FLIPS; i++)
+	{
+		unsigned pos = i < HEADER_SIZE ? i : next_random(&state) % size;
+		unsigned char mask = next_random(&state) % 255 + 1;
+		if (pos >= size)
+			continue;
+		
+		memcpy(damaged, data, size);
+		damaged[pos] ^= mask;
+		if (!expect_error(compiler, stage, damaged, size))
+		{
+			if (!failures++)
+				fprintf(stderr, "%s: accepted with byte %u flipped\n", path, pos);
+		}
+	}
+	
+	if (failures)
+	{
+		fprintf(stderr, "%s: %u damaged checkpoints accepted\n", path, failures);
+		success = false;
+	}
+	
+	printf("%s: %s (%u bytes)\n", path, success ? "ok" : "FAILED", size);
+	
+	free(damaged);
+	free(data);
+	return success;
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		fprintf(stderr, "usage: limatest-checkpoint shaders...\n");
+		return 1;
+	}
+	
+	lima_compiler_t* compiler = lima_compiler_create();
+	if (!compiler)
+	{
+		fprintf(stderr, "Error: could not create the compiler\n");
+		return 1;
+	}
+	
+	int ret = 0;
+	int i;
+	for (i = 1; i < argc; i++)
+	{
+		if (!check(compiler, argv[i]))
+			ret = 1;
+	}
+	
+	lima_compiler_delete(compiler);
+	return ret;
+}
@@ -0,0 +1,106 @@
+/* Author(s):
+ *   Connor Abbott
+ *
+ * Copyright (c) 2014 Connor Abbott (connor@abbott.cx)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#define _GNU_SOURCE /* for fopencookie */
+#include "trace.h"
+#include <strings.h>
+#include <sys/types.h>
+
+__thread unsigned lima_trace_mask = 0;
+static __thread lima_trace_t* cur_trace = NULL;
+
+void lima_trace_init(lima_trace_t* trace, unsigned categories,
+					 lima_trace_sink_t sink, void* data)
+{
+	trace->categories = sink ? categories & lima_trace_all : 0;
+	trace->sink = sink;
+	trace->data = data;
+	
+	unsigned i;
+	for (i = 0; i < LIMA_TRACE_NUM_CATEGORIES; i++)
+	{
+		trace->streams[i].trace = trace;
+		trace->streams[i].category = (lima_trace_category_e) (1 << i);
+		trace->streams[i].file = NULL;
+	}
+}
+
+static ssize_t stream_write(void* cookie, const char* buf, size_t size)
+{
+	lima_trace_stream_t* stream = cookie;
+	stream->trace->sink(stream->category, buf, size, stream->trace->data);
+	return size;
+}
+
+static const cookie_io_functions_t stream_funcs = {
+	.read = NULL,
+	.write = stream_write,
+	.seek = NULL,
+	.close = NULL
+};
+
+void lima_trace_begin(lima_trace_t* trace)
+{
+	unsigned mask = 0;
+	
+	unsigned i;
+	for (i = 0; i < LIMA_TRACE_NUM_CATEGORIES; i++)
+	{
+		lima_trace_stream_t* stream = &trace->streams[i];
+		if (!(trace->categories & stream->category))
+			continue;
+		
+		/* if we're out of memory, just drop this category */
+		stream->file = fopencookie(stream, "w", stream_funcs);
+		if (!stream->file)
+			continue;
+		
+		setvbuf(stream->file, NULL, _IOLBF, 0);
+		mask |= stream->category;
+	}
+	
+	cur_trace = trace;
+	lima_trace_mask = mask;
+}
+
+void lima_trace_end(lima_trace_t* trace)
+{
+	unsigned i;
+	for (i = 0; i < LIMA_TRACE_NUM_CATEGORIES; i++)
+	{
+		if (trace->streams[i].file)
+		{
+			fclose(trace->streams[i].file);
+			trace->streams[i].file = NULL;
+		}
+	}
+	
+	cur_trace = NULL;
+	lima_trace_mask = 0;
+}
+
+FILE* lima_trace_file(lima_trace_category_e category)
+{
+	return cur_trace->streams[ffs(category) - 1].file;
+}
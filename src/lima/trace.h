@@ -0,0 +1,86 @@
+/* Author(s):
+ *   Connor Abbott
+ *
+ * Copyright (c) 2014 Connor Abbott (connor@abbott.cx)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef __lima_trace_h__
+#define __lima_trace_h__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "shader.h"
+#include <stdio.h>
+
+/*
+ * Debug output from inside the compiler. Each enabled category gets its own
+ * line-buffered stream, which forwards whatever is written to it on to the
+ * sink the user supplied with lima_shader_set_trace(). The streams only exist
+ * between lima_trace_begin() and lima_trace_end(), so when tracing is off
+ * lima_trace() costs a load and a branch.
+ */
+
+#define LIMA_TRACE_NUM_CATEGORIES 4
+
+struct lima_trace_s;
+
+typedef struct {
+	struct lima_trace_s* trace;
+	lima_trace_category_e category;
+	FILE* file;
+} lima_trace_stream_t;
+
+typedef struct lima_trace_s {
+	unsigned categories;
+	lima_trace_sink_t sink;
+	void* data;
+	
+	lima_trace_stream_t streams[LIMA_TRACE_NUM_CATEGORIES];
+} lima_trace_t;
+
+/* the categories enabled for the shader being compiled on this thread */
+extern __thread unsigned lima_trace_mask;
+
+void lima_trace_init(lima_trace_t* trace, unsigned categories,
+					 lima_trace_sink_t sink, void* data);
+
+/* route tracing on this thread to trace until the matching lima_trace_end() */
+void lima_trace_begin(lima_trace_t* trace);
+void lima_trace_end(lima_trace_t* trace);
+
+/* returns the stream for category, which must be enabled */
+FILE* lima_trace_file(lima_trace_category_e category);
+
+#define lima_trace_enabled(category) (lima_trace_mask & (category))
+
+#define lima_trace(category, ...) \
+	do { \
+		if (lima_trace_enabled(category)) \
+			fprintf(lima_trace_file(category), __VA_ARGS__); \
+	} while (0)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif